@@ -0,0 +1,850 @@
+#include "BCEncoder.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include "../Soco/Util/JobSystem.h"
+#include "../Soco/Util/Profiler.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SOCO_BC_SSE2 1
+#else
+#define SOCO_BC_SSE2 0
+#endif
+
+namespace
+{
+
+// BC7 4位索引的插值权重，w和15 - w对应的权重之和是64，所以交换端点后把索引取反结果不变
+const int BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// 一个块的16个像素，按通道分开存，方便4个像素一起算
+struct BlockPixels
+{
+	alignas(16) float Channels[4][16];
+};
+
+BlockPixels LoadBlock(const uint8_t* texels)
+{
+	BlockPixels pixels;
+	for (int i = 0; i < 16; ++i)
+		for (int c = 0; c < 4; ++c)
+			pixels.Channels[c][i] = texels[i * 4 + c];
+	return pixels;
+}
+
+/*
+每个像素在调色板里找最近的一项，只比较前channelCount个通道，返回误差平方和
+weights不为空时按像素加权，权重为0的像素不计误差(索引由调用者另外指定)
+*/
+float FitPalette(const BlockPixels& pixels, int channelCount, const float (*palette)[4], int paletteCount,
+	const float* weights, uint8_t* indices)
+{
+#if SOCO_BC_SSE2
+	__m128 total = _mm_setzero_ps();
+	for (int i = 0; i < 16; i += 4)
+	{
+		__m128 best = _mm_set1_ps(FLT_MAX);
+		__m128i bestIndex = _mm_setzero_si128();
+		for (int k = 0; k < paletteCount; ++k)
+		{
+			__m128 distance = _mm_setzero_ps();
+			for (int c = 0; c < channelCount; ++c)
+			{
+				const __m128 d = _mm_sub_ps(_mm_load_ps(&pixels.Channels[c][i]), _mm_set1_ps(palette[k][c]));
+				distance = _mm_add_ps(distance, _mm_mul_ps(d, d));
+			}
+			const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+			best = _mm_min_ps(distance, best);
+			bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, bestIndex));
+		}
+		if (weights != nullptr)
+			best = _mm_mul_ps(best, _mm_loadu_ps(weights + i));
+		total = _mm_add_ps(total, best);
+
+		alignas(16) int32_t lanes[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes), bestIndex);
+		for (int j = 0; j < 4; ++j)
+			indices[i + j] = (uint8_t)lanes[j];
+	}
+	alignas(16) float sums[4];
+	_mm_store_ps(sums, total);
+	return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+	float total = 0.0f;
+	for (int i = 0; i < 16; ++i)
+	{
+		float best = FLT_MAX;
+		for (int k = 0; k < paletteCount; ++k)
+		{
+			float distance = 0.0f;
+			for (int c = 0; c < channelCount; ++c)
+			{
+				const float d = pixels.Channels[c][i] - palette[k][c];
+				distance += d * d;
+			}
+			if (distance < best)
+			{
+				best = distance;
+				indices[i] = (uint8_t)k;
+			}
+		}
+		total += weights != nullptr ? best * weights[i] : best;
+	}
+	return total;
+#endif
+}
+
+/*
+主成分方向上最远的两个投影点作为初始端点，weights为0的像素不参与
+所有像素相同时两个端点都是平均值
+*/
+void PrincipalEndpoints(const BlockPixels& pixels, int channelCount, const float* weights, float* e0, float* e1)
+{
+	float mean[4] = { 0, 0, 0, 0 };
+	float count = 0.0f;
+	for (int i = 0; i < 16; ++i)
+	{
+		const float w = weights != nullptr ? weights[i] : 1.0f;
+		count += w;
+		for (int c = 0; c < channelCount; ++c)
+			mean[c] += w * pixels.Channels[c][i];
+	}
+	for (int c = 0; c < channelCount; ++c)
+		mean[c] /= std::max(count, 1.0f);
+
+	float covariance[4][4] = {};
+	for (int i = 0; i < 16; ++i)
+	{
+		const float w = weights != nullptr ? weights[i] : 1.0f;
+		for (int a = 0; a < channelCount; ++a)
+			for (int b = 0; b < channelCount; ++b)
+				covariance[a][b] += w * (pixels.Channels[a][i] - mean[a]) * (pixels.Channels[b][i] - mean[b]);
+	}
+
+	//幂迭代，从方差最大的通道开始
+	float axis[4] = { 0, 0, 0, 0 };
+	int largest = 0;
+	for (int c = 1; c < channelCount; ++c)
+		if (covariance[c][c] > covariance[largest][largest])
+			largest = c;
+	for (int c = 0; c < channelCount; ++c)
+		axis[c] = covariance[largest][c];
+	for (int iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[4] = { 0, 0, 0, 0 };
+		float length = 0.0f;
+		for (int a = 0; a < channelCount; ++a)
+		{
+			for (int b = 0; b < channelCount; ++b)
+				next[a] += covariance[a][b] * axis[b];
+			length = std::max(length, std::abs(next[a]));
+		}
+		if (length <= 1e-6f)
+			break;
+		for (int c = 0; c < channelCount; ++c)
+			axis[c] = next[c] / length;
+	}
+
+	float lengthSq = 0.0f;
+	for (int c = 0; c < channelCount; ++c)
+		lengthSq += axis[c] * axis[c];
+	float minT = 0.0f, maxT = 0.0f;
+	if (lengthSq > 1e-12f)
+	{
+		minT = FLT_MAX;
+		maxT = -FLT_MAX;
+		for (int i = 0; i < 16; ++i)
+		{
+			if (weights != nullptr && weights[i] == 0.0f)
+				continue;
+			float t = 0.0f;
+			for (int c = 0; c < channelCount; ++c)
+				t += (pixels.Channels[c][i] - mean[c]) * axis[c];
+			t /= lengthSq;
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+	}
+
+	for (int c = 0; c < channelCount; ++c)
+	{
+		e0[c] = std::min(std::max(mean[c] + axis[c] * maxT, 0.0f), 255.0f);
+		e1[c] = std::min(std::max(mean[c] + axis[c] * minT, 0.0f), 255.0f);
+	}
+}
+
+/*
+已知每个像素的插值权重(weightsA是端点A的份额)，用最小二乘求两个端点
+像素权重为0的不参与；方程退化(所有像素都用同一个端点)时返回false
+*/
+bool SolveEndpoints(const BlockPixels& pixels, int channelCount, const float* weightsA, const float* pixelWeights, float* a, float* b)
+{
+	float aa = 0, ab = 0, bb = 0;
+	float ax[4] = { 0, 0, 0, 0 }, bx[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 16; ++i)
+	{
+		const float p = pixelWeights != nullptr ? pixelWeights[i] : 1.0f;
+		const float wa = weightsA[i];
+		const float wb = 1.0f - wa;
+		aa += p * wa * wa;
+		ab += p * wa * wb;
+		bb += p * wb * wb;
+		for (int c = 0; c < channelCount; ++c)
+		{
+			ax[c] += p * wa * pixels.Channels[c][i];
+			bx[c] += p * wb * pixels.Channels[c][i];
+		}
+	}
+	const float determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) < 1e-6f)
+		return false;
+	for (int c = 0; c < channelCount; ++c)
+	{
+		a[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / determinant, 0.0f), 255.0f);
+		b[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / determinant, 0.0f), 255.0f);
+	}
+	return true;
+}
+
+// 按位从低到高写入/读出一个块
+struct BitWriter
+{
+	uint8_t* Data;
+	uint32_t Position = 0;
+
+	void Write(uint32_t value, uint32_t bits)
+	{
+		for (uint32_t i = 0; i < bits; ++i, ++Position)
+			Data[Position >> 3] |= (uint8_t)(((value >> i) & 1) << (Position & 7));
+	}
+};
+
+struct BitReader
+{
+	const uint8_t* Data;
+	uint32_t Position = 0;
+
+	uint32_t Read(uint32_t bits)
+	{
+		uint32_t value = 0;
+		for (uint32_t i = 0; i < bits; ++i, ++Position)
+			value |= ((Data[Position >> 3] >> (Position & 7)) & 1u) << i;
+		return value;
+	}
+};
+
+//---------------------------------------- BC1 ----------------------------------------
+
+void Expand565(uint16_t color, int* rgb)
+{
+	const int r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+uint16_t Quantize565(const float* rgb)
+{
+	const int r = std::min(std::max((int)(rgb[0] * 31.0f / 255.0f + 0.5f), 0), 31);
+	const int g = std::min(std::max((int)(rgb[1] * 63.0f / 255.0f + 0.5f), 0), 63);
+	const int b = std::min(std::max((int)(rgb[2] * 31.0f / 255.0f + 0.5f), 0), 31);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+// c0 > c1时4色，否则3色且索引3是透明黑
+void BC1Palette(uint16_t c0, uint16_t c1, float (*palette)[4])
+{
+	int a[3], b[3];
+	Expand565(c0, a);
+	Expand565(c1, b);
+	for (int c = 0; c < 3; ++c)
+	{
+		palette[0][c] = (float)a[c];
+		palette[1][c] = (float)b[c];
+		if (c0 > c1)
+		{
+			palette[2][c] = (2.0f * a[c] + b[c]) / 3.0f;
+			palette[3][c] = (a[c] + 2.0f * b[c]) / 3.0f;
+		}
+		else
+		{
+			palette[2][c] = (a[c] + b[c]) / 2.0f;
+			palette[3][c] = 0.0f;
+		}
+	}
+	for (int k = 0; k < 4; ++k)
+		palette[k][3] = (c0 <= c1 && k == 3) ? 0.0f : 255.0f;
+}
+
+struct BC1Candidate
+{
+	uint16_t C0 = 0;
+	uint16_t C1 = 0;
+	uint8_t Indices[16] = {};
+	float Error = FLT_MAX;
+};
+
+/*
+两个端点编码成一个块：4色模式要求c0 > c1，3色模式要求c0 <= c1，按模式排好端点的顺序再选索引
+4色模式下两个端点相同时只能用3色调色板的前3项(第3项是透明)
+*/
+BC1Candidate EvaluateBC1(const BlockPixels& pixels, const float* opaque, bool threeColor, uint16_t a, uint16_t b)
+{
+	BC1Candidate candidate;
+	candidate.C0 = threeColor ? std::min(a, b) : std::max(a, b);
+	candidate.C1 = threeColor ? std::max(a, b) : std::min(a, b);
+
+	float palette[4][4];
+	BC1Palette(candidate.C0, candidate.C1, palette);
+	const int paletteCount = candidate.C0 > candidate.C1 ? 4 : 3;
+	candidate.Error = FitPalette(pixels, 3, palette, paletteCount, threeColor ? opaque : nullptr, candidate.Indices);
+	if (threeColor)
+	{
+		for (int i = 0; i < 16; ++i)
+			if (opaque[i] == 0.0f)
+				candidate.Indices[i] = 3;
+	}
+	return candidate;
+}
+
+//---------------------------------------- BC4 ----------------------------------------
+
+void BC4Palette(uint8_t a0, uint8_t a1, float (*palette)[4])
+{
+	palette[0][0] = a0;
+	palette[1][0] = a1;
+	if (a0 > a1)
+	{
+		for (int i = 2; i < 8; ++i)
+			palette[i][0] = ((8 - i) * a0 + (i - 1) * a1) / 7.0f;
+	}
+	else
+	{
+		for (int i = 2; i < 6; ++i)
+			palette[i][0] = ((6 - i) * a0 + (i - 1) * a1) / 5.0f;
+		palette[6][0] = 0.0f;
+		palette[7][0] = 255.0f;
+	}
+}
+
+// 索引i对应的端点a0的份额，用于最小二乘
+float BC4WeightA(uint8_t index, bool eightValues)
+{
+	if (index == 0)
+		return 1.0f;
+	if (index == 1)
+		return 0.0f;
+	return eightValues ? (8 - index) / 7.0f : (6 - index) / 5.0f;
+}
+
+struct BC4Candidate
+{
+	uint8_t A0 = 0;
+	uint8_t A1 = 0;
+	uint8_t Indices[16] = {};
+	float Error = FLT_MAX;
+};
+
+BC4Candidate EvaluateBC4(const BlockPixels& pixels, uint8_t a0, uint8_t a1)
+{
+	BC4Candidate candidate;
+	candidate.A0 = a0;
+	candidate.A1 = a1;
+	float palette[8][4];
+	BC4Palette(a0, a1, palette);
+	candidate.Error = FitPalette(pixels, 1, palette, 8, nullptr, candidate.Indices);
+	return candidate;
+}
+
+uint8_t RoundToByte(float v)
+{
+	return (uint8_t)std::min(std::max((int)(v + 0.5f), 0), 255);
+}
+
+void WriteBC4(const BC4Candidate& candidate, uint8_t* block)
+{
+	memset(block, 0, 8);
+	block[0] = candidate.A0;
+	block[1] = candidate.A1;
+	BitWriter writer{ block, 16 };
+	for (int i = 0; i < 16; ++i)
+		writer.Write(candidate.Indices[i], 3);
+}
+
+void DecodeBC4Block(const uint8_t* block, uint8_t* values)
+{
+	float palette[8][4];
+	BC4Palette(block[0], block[1], palette);
+	BitReader reader{ block, 16 };
+	for (int i = 0; i < 16; ++i)
+		values[i] = RoundToByte(palette[reader.Read(3)][0]);
+}
+
+//---------------------------------------- BC7 ----------------------------------------
+
+struct BC7Candidate
+{
+	uint8_t Q0[4] = {};
+	uint8_t Q1[4] = {};
+	uint8_t P0 = 0;
+	uint8_t P1 = 0;
+	uint8_t Indices[16] = {};
+	float Error = FLT_MAX;
+};
+
+void BC7Palette(const uint8_t* e0, const uint8_t* e1, float (*palette)[4])
+{
+	for (int k = 0; k < 16; ++k)
+		for (int c = 0; c < 4; ++c)
+			palette[k][c] = (float)(((64 - BC7Weights4[k]) * e0[c] + BC7Weights4[k] * e1[c] + 32) >> 6);
+}
+
+// 两个端点的4种p位组合都试一次，保留误差最小的
+void TryBC7Endpoints(const BlockPixels& pixels, const float* e0, const float* e1, BC7Candidate& best)
+{
+	for (int p0 = 0; p0 < 2; ++p0)
+	{
+		for (int p1 = 0; p1 < 2; ++p1)
+		{
+			BC7Candidate candidate;
+			candidate.P0 = (uint8_t)p0;
+			candidate.P1 = (uint8_t)p1;
+			uint8_t full0[4], full1[4];
+			for (int c = 0; c < 4; ++c)
+			{
+				candidate.Q0[c] = (uint8_t)std::min(std::max((int)std::floor((e0[c] - p0) * 0.5f + 0.5f), 0), 127);
+				candidate.Q1[c] = (uint8_t)std::min(std::max((int)std::floor((e1[c] - p1) * 0.5f + 0.5f), 0), 127);
+				full0[c] = (uint8_t)((candidate.Q0[c] << 1) | p0);
+				full1[c] = (uint8_t)((candidate.Q1[c] << 1) | p1);
+			}
+			float palette[16][4];
+			BC7Palette(full0, full1, palette);
+			candidate.Error = FitPalette(pixels, 4, palette, 16, nullptr, candidate.Indices);
+			if (candidate.Error < best.Error)
+				best = candidate;
+		}
+	}
+}
+
+/*
+纯色块的查找表：两个p位相同、所有像素用索引7时，每个通道值c都能找到插值结果正好是c的一对7位端点
+p位都为0时除了255都能表示，都为1时除了0都能表示，同时含有0和255的颜色mode 6表示不了，走一般的拟合
+*/
+struct BC7SolidTable
+{
+	static const int Index = 7;
+	// [p位][通道值]，-1表示表示不了
+	int16_t Q0[2][256];
+	int16_t Q1[2][256];
+
+	BC7SolidTable()
+	{
+		for (int p = 0; p < 2; ++p)
+		{
+			for (int c = 0; c < 256; ++c)
+			{
+				Q0[p][c] = Q1[p][c] = -1;
+				for (int q0 = std::max(c / 2 - 4, 0); q0 <= std::min(c / 2 + 4, 127) && Q0[p][c] < 0; ++q0)
+				{
+					for (int q1 = std::max(c / 2 - 4, 0); q1 <= std::min(c / 2 + 4, 127); ++q1)
+					{
+						const int e0 = q0 * 2 + p, e1 = q1 * 2 + p;
+						if ((((64 - BC7Weights4[Index]) * e0 + BC7Weights4[Index] * e1 + 32) >> 6) == c)
+						{
+							Q0[p][c] = (int16_t)q0;
+							Q1[p][c] = (int16_t)q1;
+							break;
+						}
+					}
+				}
+			}
+		}
+	}
+};
+
+bool EncodeBC7Solid(const uint8_t* color, BC7Candidate& candidate)
+{
+	static const BC7SolidTable table;
+	for (int p = 0; p < 2; ++p)
+	{
+		bool representable = true;
+		for (int c = 0; c < 4; ++c)
+			representable &= table.Q0[p][color[c]] >= 0;
+		if (!representable)
+			continue;
+
+		candidate.P0 = candidate.P1 = (uint8_t)p;
+		for (int c = 0; c < 4; ++c)
+		{
+			candidate.Q0[c] = (uint8_t)table.Q0[p][color[c]];
+			candidate.Q1[c] = (uint8_t)table.Q1[p][color[c]];
+		}
+		memset(candidate.Indices, BC7SolidTable::Index, sizeof(candidate.Indices));
+		candidate.Error = 0.0f;
+		return true;
+	}
+	return false;
+}
+
+void DecodeBC7Block(const uint8_t* block, uint8_t* texels)
+{
+	BitReader reader{ block, 0 };
+	if (reader.Read(7) != 0x40)
+	{
+		memset(texels, 0, 64);
+		return;
+	}
+	uint8_t e[2][4];
+	for (int c = 0; c < 4; ++c)
+	{
+		e[0][c] = (uint8_t)reader.Read(7);
+		e[1][c] = (uint8_t)reader.Read(7);
+	}
+	const uint32_t p0 = reader.Read(1);
+	const uint32_t p1 = reader.Read(1);
+	for (int c = 0; c < 4; ++c)
+	{
+		e[0][c] = (uint8_t)((e[0][c] << 1) | p0);
+		e[1][c] = (uint8_t)((e[1][c] << 1) | p1);
+	}
+	float palette[16][4];
+	BC7Palette(e[0], e[1], palette);
+	for (int i = 0; i < 16; ++i)
+	{
+		const uint32_t index = reader.Read(i == 0 ? 3 : 4);
+		for (int c = 0; c < 4; ++c)
+			texels[i * 4 + c] = (uint8_t)palette[index][c];
+	}
+}
+
+void DecodeBC1Block(const uint8_t* block, uint8_t* texels)
+{
+	const uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+	const uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+	float palette[4][4];
+	BC1Palette(c0, c1, palette);
+	BitReader reader{ block, 32 };
+	for (int i = 0; i < 16; ++i)
+	{
+		const uint32_t index = reader.Read(2);
+		for (int c = 0; c < 4; ++c)
+			texels[i * 4 + c] = RoundToByte(palette[index][c]);
+	}
+}
+
+void DecodeBlock(const uint8_t* block, BCFormat format, uint8_t* texels)
+{
+	switch (format)
+	{
+	case BCFormat::BC1:
+		DecodeBC1Block(block, texels);
+		break;
+	case BCFormat::BC4:
+	case BCFormat::BC5:
+	{
+		uint8_t red[16], green[16] = {};
+		DecodeBC4Block(block, red);
+		if (format == BCFormat::BC5)
+			DecodeBC4Block(block + 8, green);
+		for (int i = 0; i < 16; ++i)
+		{
+			texels[i * 4] = red[i];
+			texels[i * 4 + 1] = green[i];
+			texels[i * 4 + 2] = 0;
+			texels[i * 4 + 3] = 255;
+		}
+		break;
+	}
+	case BCFormat::BC7:
+		DecodeBC7Block(block, texels);
+		break;
+	}
+}
+
+}
+
+uint32_t GetBCBlockBytes(BCFormat format)
+{
+	return format == BCFormat::BC1 || format == BCFormat::BC4 ? 8 : 16;
+}
+
+const char* GetBCFormatName(BCFormat format)
+{
+	switch (format)
+	{
+	case BCFormat::BC1: return "BC1";
+	case BCFormat::BC4: return "BC4";
+	case BCFormat::BC5: return "BC5";
+	case BCFormat::BC7: return "BC7";
+	}
+	return "Unknown";
+}
+
+uint32_t GetBCRowPitch(BCFormat format, uint32_t width)
+{
+	return (width + 3) / 4 * GetBCBlockBytes(format);
+}
+
+uint32_t GetBCSize(BCFormat format, uint32_t width, uint32_t height)
+{
+	return GetBCRowPitch(format, width) * ((height + 3) / 4);
+}
+
+void EncodeBC1Block(const uint8_t* texels, uint8_t* block, uint32_t refineIterations)
+{
+	const BlockPixels pixels = LoadBlock(texels);
+
+	//有透明像素时用3色模式，透明像素固定用索引3，不参与端点和误差
+	alignas(16) float opaque[16];
+	bool threeColor = false;
+	bool anyOpaque = false;
+	for (int i = 0; i < 16; ++i)
+	{
+		opaque[i] = texels[i * 4 + 3] >= 128 ? 1.0f : 0.0f;
+		threeColor |= opaque[i] == 0.0f;
+		anyOpaque |= opaque[i] != 0.0f;
+	}
+
+	BC1Candidate best;
+	if (!anyOpaque)
+	{
+		best.C0 = best.C1 = 0;
+		memset(best.Indices, 3, sizeof(best.Indices));
+	}
+	else
+	{
+		float e0[4], e1[4];
+		PrincipalEndpoints(pixels, 3, threeColor ? opaque : nullptr, e0, e1);
+		best = EvaluateBC1(pixels, opaque, threeColor, Quantize565(e0), Quantize565(e1));
+
+		for (uint32_t iteration = 0; iteration < refineIterations && best.Error > 0.0f; ++iteration)
+		{
+			const bool fourColor = best.C0 > best.C1;
+			float weightsA[16];
+			for (int i = 0; i < 16; ++i)
+			{
+				static const float fourWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+				static const float threeWeights[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+				weightsA[i] = fourColor ? fourWeights[best.Indices[i]] : threeWeights[best.Indices[i]];
+			}
+			float a[4], b[4];
+			if (!SolveEndpoints(pixels, 3, weightsA, threeColor ? opaque : nullptr, a, b))
+				break;
+			const BC1Candidate refined = EvaluateBC1(pixels, opaque, threeColor, Quantize565(a), Quantize565(b));
+			if (refined.Error >= best.Error)
+				break;
+			best = refined;
+		}
+	}
+
+	memset(block, 0, 8);
+	block[0] = (uint8_t)(best.C0 & 0xFF);
+	block[1] = (uint8_t)(best.C0 >> 8);
+	block[2] = (uint8_t)(best.C1 & 0xFF);
+	block[3] = (uint8_t)(best.C1 >> 8);
+	BitWriter writer{ block, 32 };
+	for (int i = 0; i < 16; ++i)
+		writer.Write(best.Indices[i], 2);
+}
+
+void EncodeBC4Block(const uint8_t* values, uint8_t* block, uint32_t refineIterations)
+{
+	BlockPixels pixels = {};
+	uint8_t minValue = 255, maxValue = 0;
+	//6值模式的端点不用考虑0和255，它们有单独的索引
+	uint8_t minInner = 255, maxInner = 0;
+	for (int i = 0; i < 16; ++i)
+	{
+		pixels.Channels[0][i] = values[i];
+		minValue = std::min(minValue, values[i]);
+		maxValue = std::max(maxValue, values[i]);
+		if (values[i] != 0 && values[i] != 255)
+		{
+			minInner = std::min(minInner, values[i]);
+			maxInner = std::max(maxInner, values[i]);
+		}
+	}
+
+	if (minValue == maxValue)
+	{
+		BC4Candidate solid;
+		solid.A0 = solid.A1 = minValue;
+		WriteBC4(solid, block);
+		return;
+	}
+
+	//8值模式：a0 > a1
+	BC4Candidate best = EvaluateBC4(pixels, maxValue, minValue);
+	for (uint32_t iteration = 0; iteration < refineIterations && best.Error > 0.0f; ++iteration)
+	{
+		float weightsA[16];
+		for (int i = 0; i < 16; ++i)
+			weightsA[i] = BC4WeightA(best.Indices[i], true);
+		float a[4], b[4];
+		if (!SolveEndpoints(pixels, 1, weightsA, nullptr, a, b))
+			break;
+		const uint8_t a0 = RoundToByte(a[0]), a1 = RoundToByte(b[0]);
+		if (a0 <= a1)
+			break;
+		const BC4Candidate refined = EvaluateBC4(pixels, a0, a1);
+		if (refined.Error >= best.Error)
+			break;
+		best = refined;
+	}
+
+	//6值模式：a0 <= a1，0和255精确表示，块里同时有极值和中间值时更好
+	if (minInner > maxInner)
+		minInner = maxInner = 0;
+	const BC4Candidate sixValues = EvaluateBC4(pixels, minInner, maxInner);
+	if (sixValues.Error < best.Error)
+		best = sixValues;
+
+	WriteBC4(best, block);
+}
+
+void EncodeBC5Block(const uint8_t* texels, uint8_t* block, uint32_t refineIterations)
+{
+	uint8_t red[16], green[16];
+	for (int i = 0; i < 16; ++i)
+	{
+		red[i] = texels[i * 4];
+		green[i] = texels[i * 4 + 1];
+	}
+	EncodeBC4Block(red, block, refineIterations);
+	EncodeBC4Block(green, block + 8, refineIterations);
+}
+
+void EncodeBC7Block(const uint8_t* texels, uint8_t* block, uint32_t refineIterations)
+{
+	const BlockPixels pixels = LoadBlock(texels);
+
+	bool solid = true;
+	for (int i = 1; i < 16 && solid; ++i)
+		solid = memcmp(texels, texels + i * 4, 4) == 0;
+
+	BC7Candidate best;
+	if (!solid || !EncodeBC7Solid(texels, best))
+	{
+		float e0[4], e1[4];
+		PrincipalEndpoints(pixels, 4, nullptr, e0, e1);
+		TryBC7Endpoints(pixels, e0, e1, best);
+	}
+
+	for (uint32_t iteration = 0; iteration < refineIterations && best.Error > 0.0f; ++iteration)
+	{
+		float weightsA[16];
+		for (int i = 0; i < 16; ++i)
+			weightsA[i] = (64 - BC7Weights4[best.Indices[i]]) / 64.0f;
+		float a[4], b[4];
+		if (!SolveEndpoints(pixels, 4, weightsA, nullptr, a, b))
+			break;
+		const float previous = best.Error;
+		TryBC7Endpoints(pixels, a, b, best);
+		if (best.Error >= previous)
+			break;
+	}
+
+	//第一个像素的索引最高位隐含为0，否则交换端点并把索引取反
+	if (best.Indices[0] >= 8)
+	{
+		for (int c = 0; c < 4; ++c)
+			std::swap(best.Q0[c], best.Q1[c]);
+		std::swap(best.P0, best.P1);
+		for (int i = 0; i < 16; ++i)
+			best.Indices[i] = (uint8_t)(15 - best.Indices[i]);
+	}
+
+	memset(block, 0, 16);
+	BitWriter writer{ block, 0 };
+	writer.Write(0x40, 7);
+	for (int c = 0; c < 4; ++c)
+	{
+		writer.Write(best.Q0[c], 7);
+		writer.Write(best.Q1[c], 7);
+	}
+	writer.Write(best.P0, 1);
+	writer.Write(best.P1, 1);
+	for (int i = 0; i < 16; ++i)
+		writer.Write(best.Indices[i], i == 0 ? 3 : 4);
+}
+
+std::vector<uint8_t> EncodeBC(const uint8_t* rgba, uint32_t width, uint32_t height, BCFormat format, const BCEncodeOptions& options)
+{
+	SOCO_PROFILE_SCOPE("EncodeBC");
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+	const uint32_t blockBytes = GetBCBlockBytes(format);
+	std::vector<uint8_t> blocks((size_t)blocksX * blocksY * blockBytes);
+
+	auto encodeRows = [&](size_t first, size_t last) {
+		uint8_t texels[64];
+		for (size_t by = first; by < last; ++by)
+		{
+			for (uint32_t bx = 0; bx < blocksX; ++bx)
+			{
+				for (uint32_t y = 0; y < 4; ++y)
+				{
+					const uint32_t sy = std::min<uint32_t>((uint32_t)by * 4 + y, height - 1);
+					for (uint32_t x = 0; x < 4; ++x)
+					{
+						const uint32_t sx = std::min(bx * 4 + x, width - 1);
+						memcpy(texels + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+					}
+				}
+
+				uint8_t* block = blocks.data() + (by * blocksX + bx) * blockBytes;
+				switch (format)
+				{
+				case BCFormat::BC1:
+					EncodeBC1Block(texels, block, options.RefineIterations);
+					break;
+				case BCFormat::BC4:
+				{
+					uint8_t red[16];
+					for (int i = 0; i < 16; ++i)
+						red[i] = texels[i * 4];
+					EncodeBC4Block(red, block, options.RefineIterations);
+					break;
+				}
+				case BCFormat::BC5:
+					EncodeBC5Block(texels, block, options.RefineIterations);
+					break;
+				case BCFormat::BC7:
+					EncodeBC7Block(texels, block, options.RefineIterations);
+					break;
+				}
+			}
+		}
+	};
+
+	if (options.Parallel)
+		Soco::JobSystem::GetInstance()->ParallelFor(0, blocksY, std::max(1u, options.RowsPerJob), encodeRows);
+	else
+		encodeRows(0, blocksY);
+	return blocks;
+}
+
+std::vector<uint8_t> DecodeBC(const uint8_t* blocks, uint32_t width, uint32_t height, BCFormat format)
+{
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+	const uint32_t blockBytes = GetBCBlockBytes(format);
+	std::vector<uint8_t> rgba((size_t)width * height * 4);
+
+	uint8_t texels[64];
+	for (uint32_t by = 0; by < blocksY; ++by)
+	{
+		for (uint32_t bx = 0; bx < blocksX; ++bx)
+		{
+			DecodeBlock(blocks + ((size_t)by * blocksX + bx) * blockBytes, format, texels);
+			for (uint32_t y = 0; y < 4 && by * 4 + y < height; ++y)
+				for (uint32_t x = 0; x < 4 && bx * 4 + x < width; ++x)
+					memcpy(rgba.data() + ((size_t)(by * 4 + y) * width + bx * 4 + x) * 4, texels + (y * 4 + x) * 4, 4);
+		}
+	}
+	return rgba;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/*
+块压缩编码，每个4x4块独立编码，整张图按块行分给JobSystem并行
+BC1：RGB 565两端点 + 2位索引，alpha < 128的像素用3色模式的透明索引，8字节/块
+BC4：单通道(取R)两端点 + 3位索引，适合高度图，8字节/块
+BC5：两个BC4块(取R、G)，适合只存xy的法线贴图，16字节/块
+BC7：只用mode 6(RGBA 7位端点 + p位 + 4位索引)，16字节/块
+索引选择的最近距离搜索在有SSE2时4个像素一起算
+*/
+enum class BCFormat
+{
+	BC1,
+	BC4,
+	BC5,
+	BC7,
+};
+
+struct BCEncodeOptions
+{
+	// 按块行拆成job并行编码
+	bool Parallel = true;
+	uint32_t RowsPerJob = 4;
+	// 由当前索引用最小二乘重新求端点的轮数，越多越慢、质量越好
+	uint32_t RefineIterations = 2;
+};
+
+uint32_t GetBCBlockBytes(BCFormat format);
+const char* GetBCFormatName(BCFormat format);
+
+// 一个mip压缩后的行距和大小：行数是(height + 3) / 4个块行，宽高不足4的mip也占一整块
+uint32_t GetBCRowPitch(BCFormat format, uint32_t width);
+uint32_t GetBCSize(BCFormat format, uint32_t width, uint32_t height);
+
+// texels是4x4块的RGBA8，按行排列共64字节
+void EncodeBC1Block(const uint8_t* texels, uint8_t* block, uint32_t refineIterations = 2);
+void EncodeBC4Block(const uint8_t* values, uint8_t* block, uint32_t refineIterations = 2);
+void EncodeBC5Block(const uint8_t* texels, uint8_t* block, uint32_t refineIterations = 2);
+void EncodeBC7Block(const uint8_t* texels, uint8_t* block, uint32_t refineIterations = 2);
+
+// rgba是width x height的RGBA8图像，行之间没有间隙，边缘不足一块的部分重复最后一行/列
+std::vector<uint8_t> EncodeBC(const uint8_t* rgba, uint32_t width, uint32_t height, BCFormat format, const BCEncodeOptions& options = BCEncodeOptions());
+
+// 解码成RGBA8，缺少的通道和GPU采样的结果一致：BC4是(R, 0, 0, 255)，BC5是(R, G, 0, 255)
+// BC7只支持本编码器输出的mode 6，其他mode的块解码成0
+std::vector<uint8_t> DecodeBC(const uint8_t* blocks, uint32_t width, uint32_t height, BCFormat format);
@@ -21,6 +21,7 @@
 #include <assert.h>
 #include <algorithm>
 #include <memory>
+#include <vector>
 #include <wrl.h>
 
 #include "DDSTextureLoader.h" 
@@ -1669,29 +1670,29 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D11Device* d3dDevice,
     return hr;
 }
 
-static HRESULT CreateTextureFromDDS12(
-	_In_ ID3D12Device* device,
-	_In_opt_ ID3D12GraphicsCommandList* cmdList,
+//--------------------------------------------------------------------------------------
+// Reads the full-chain description out of a DDS header, shared by the create, describe and load paths
+static HRESULT GetTextureInfoFromDDS12(
 	_In_ const DDS_HEADER* header,
-	_In_reads_bytes_(bitSize) const uint8_t* bitData,
-	_In_ size_t bitSize,
-	_In_ size_t maxsize,
-	_In_ bool forceSRGB,
-	ComPtr<ID3D12Resource>& texture,
-	ComPtr<ID3D12Resource>& textureUploadHeap)
+	_Out_ uint32_t& resDim,
+	_Out_ UINT& width,
+	_Out_ UINT& height,
+	_Out_ UINT& depth,
+	_Out_ size_t& mipCount,
+	_Out_ UINT& arraySize,
+	_Out_ DXGI_FORMAT& format,
+	_Out_ bool& isCubeMap)
 {
-	HRESULT hr = S_OK;
+	width = header->width;
+	height = header->height;
+	depth = header->depth;
 
-	UINT width = header->width;
-	UINT height = header->height;
-	UINT depth = header->depth;
+	resDim = D3D12_RESOURCE_DIMENSION_UNKNOWN;
+	arraySize = 1;
+	format = DXGI_FORMAT_UNKNOWN;
+	isCubeMap = false;
 
-	uint32_t resDim = D3D12_RESOURCE_DIMENSION_UNKNOWN;
-	UINT arraySize = 1;
-	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
-	bool isCubeMap = false;
-
-	size_t mipCount = header->mipMapCount;
+	mipCount = header->mipMapCount;
 	if (0 == mipCount) mipCount = 1;
 
 	if ((header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))
@@ -1835,6 +1836,64 @@ static HRESULT CreateTextureFromDDS12(
 		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
 	}
 
+	return S_OK;
+}
+
+//--------------------------------------------------------------------------------------
+// Only 2D textures (including arrays and cubes) are created by the 12 paths
+static HRESULT BuildTextureDesc12(
+	_In_ uint32_t resDim,
+	_In_ UINT width,
+	_In_ UINT height,
+	_In_ size_t mipCount,
+	_In_ UINT arraySize,
+	_In_ DXGI_FORMAT format,
+	_Out_ D3D12_RESOURCE_DESC& desc)
+{
+	if (resDim != D3D12_RESOURCE_DIMENSION_TEXTURE2D)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	ZeroMemory(&desc, sizeof(D3D12_RESOURCE_DESC));
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	desc.Alignment = 0;
+	desc.Width = width;
+	desc.Height = height;
+	desc.DepthOrArraySize = (uint16_t)arraySize;
+	desc.MipLevels = (uint16_t)mipCount;
+	desc.Format = format;
+	desc.SampleDesc.Count = 1;
+	desc.SampleDesc.Quality = 0;
+	desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+	return S_OK;
+}
+
+static HRESULT CreateTextureFromDDS12(
+	_In_ ID3D12Device* device,
+	_In_opt_ ID3D12GraphicsCommandList* cmdList,
+	_In_ const DDS_HEADER* header,
+	_In_reads_bytes_(bitSize) const uint8_t* bitData,
+	_In_ size_t bitSize,
+	_In_ size_t maxsize,
+	_In_ bool forceSRGB,
+	ComPtr<ID3D12Resource>& texture,
+	ComPtr<ID3D12Resource>& textureUploadHeap)
+{
+	HRESULT hr = S_OK;
+
+	UINT width = 0;
+	UINT height = 0;
+	UINT depth = 0;
+	uint32_t resDim = D3D12_RESOURCE_DIMENSION_UNKNOWN;
+	UINT arraySize = 1;
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	bool isCubeMap = false;
+	size_t mipCount = 0;
+
+	hr = GetTextureInfoFromDDS12(header, resDim, width, height, depth, mipCount, arraySize, format, isCubeMap);
+	if (FAILED(hr))
+		return hr;
+
 	// Create the texture
 	std::unique_ptr<D3D12_SUBRESOURCE_DATA[]> initData(
 		new (std::nothrow) D3D12_SUBRESOURCE_DATA[mipCount * arraySize]
@@ -2228,6 +2287,183 @@ HRESULT DirectX::CreateDDSTextureFromFile12(_In_ ID3D12Device* device,
 	return hr;
 }
 
+//--------------------------------------------------------------------------------------
+HRESULT DirectX::GetDDSTextureDescFromFile12(_In_z_ const wchar_t* szFileName,
+	_Out_ D3D12_RESOURCE_DESC& desc)
+{
+	if (!szFileName)
+	{
+		return E_INVALIDARG;
+	}
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+	ScopedHandle hFile(safe_handle(CreateFile2(szFileName, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr)));
+#else
+	ScopedHandle hFile(safe_handle(CreateFileW(szFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)));
+#endif
+	if (!hFile)
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	// Magic number, header and the optional DX10 extension; the surface data is never read
+	uint8_t headerData[sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10)] = {};
+	DWORD bytesRead = 0;
+	if (!ReadFile(hFile.get(), headerData, sizeof(headerData), &bytesRead, nullptr))
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+	if (bytesRead < sizeof(uint32_t) + sizeof(DDS_HEADER) || *reinterpret_cast<const uint32_t*>(headerData) != DDS_MAGIC)
+	{
+		return E_FAIL;
+	}
+
+	auto header = reinterpret_cast<const DDS_HEADER*>(headerData + sizeof(uint32_t));
+	if (header->size != sizeof(DDS_HEADER) || header->ddspf.size != sizeof(DDS_PIXELFORMAT))
+	{
+		return E_FAIL;
+	}
+	if ((header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC) && bytesRead < sizeof(headerData))
+	{
+		return E_FAIL;
+	}
+
+	uint32_t resDim = D3D12_RESOURCE_DIMENSION_UNKNOWN;
+	UINT width = 0, height = 0, depth = 0, arraySize = 1;
+	size_t mipCount = 0;
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	bool isCubeMap = false;
+	HRESULT hr = GetTextureInfoFromDDS12(header, resDim, width, height, depth, mipCount, arraySize, format, isCubeMap);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+	return BuildTextureDesc12(resDim, width, height, mipCount, arraySize, format, desc);
+}
+
+//--------------------------------------------------------------------------------------
+HRESULT DirectX::LoadDDSTextureDataFromFile12(_In_z_ const wchar_t* szFileName,
+	_Out_ std::unique_ptr<uint8_t[]>& ddsData,
+	_Out_ D3D12_RESOURCE_DESC& desc,
+	_Out_ std::vector<D3D12_SUBRESOURCE_DATA>& subresources)
+{
+	subresources.clear();
+	if (!szFileName)
+	{
+		return E_INVALIDARG;
+	}
+
+	DDS_HEADER* header = nullptr;
+	uint8_t* bitData = nullptr;
+	size_t bitSize = 0;
+	HRESULT hr = LoadTextureDataFromFile(szFileName, ddsData, &header, &bitData, &bitSize);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	uint32_t resDim = D3D12_RESOURCE_DIMENSION_UNKNOWN;
+	UINT width = 0, height = 0, depth = 0, arraySize = 1;
+	size_t mipCount = 0;
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	bool isCubeMap = false;
+	hr = GetTextureInfoFromDDS12(header, resDim, width, height, depth, mipCount, arraySize, format, isCubeMap);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+	hr = BuildTextureDesc12(resDim, width, height, mipCount, arraySize, format, desc);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	// Full chain: maxsize 0 never skips a level
+	subresources.resize(mipCount * arraySize);
+	size_t twidth = 0, theight = 0, tdepth = 0, skipMip = 0;
+	return FillInitData12(width, height, depth, mipCount, arraySize, format, 0, bitSize, bitData,
+		twidth, theight, tdepth, skipMip, subresources.data());
+}
+
+//--------------------------------------------------------------------------------------
+HRESULT DirectX::SaveDDSTextureToFile12(_In_z_ const wchar_t* szFileName,
+	_In_ DXGI_FORMAT format,
+	_In_ uint32_t width,
+	_In_ uint32_t height,
+	_In_reads_(mipCount) const D3D12_SUBRESOURCE_DATA* mips,
+	_In_ uint32_t mipCount)
+{
+	if (!szFileName || !mips || mipCount == 0 || width == 0 || height == 0)
+	{
+		return E_INVALIDARG;
+	}
+
+	// Tightly packed rows of every level, finest first; pitches of the source data may be wider
+	std::vector<size_t> rowBytes(mipCount), rowCount(mipCount);
+	size_t totalBytes = 0;
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		size_t numBytes = 0;
+		GetSurfaceInfo(std::max<uint32_t>(width >> mip, 1), std::max<uint32_t>(height >> mip, 1), format, &numBytes, &rowBytes[mip], &rowCount[mip]);
+		if (rowBytes[mip] == 0 || rowBytes[mip] > static_cast<size_t>(mips[mip].RowPitch))
+		{
+			return E_INVALIDARG;
+		}
+		totalBytes += numBytes;
+	}
+
+	const size_t headerBytes = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+	std::vector<uint8_t> fileData(headerBytes + totalBytes);
+	*reinterpret_cast<uint32_t*>(fileData.data()) = DDS_MAGIC;
+
+	auto header = reinterpret_cast<DDS_HEADER*>(fileData.data() + sizeof(uint32_t));
+	header->size = sizeof(DDS_HEADER);
+	// DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE
+	header->flags = 0x1 | DDS_HEIGHT | DDS_WIDTH | 0x1000 | 0x20000 | 0x80000;
+	header->height = height;
+	header->width = width;
+	header->pitchOrLinearSize = static_cast<uint32_t>(rowBytes[0] * rowCount[0]);
+	header->mipMapCount = mipCount;
+	header->ddspf.size = sizeof(DDS_PIXELFORMAT);
+	header->ddspf.flags = DDS_FOURCC;
+	header->ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+	// DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX
+	header->caps = 0x1000 | 0x400000 | 0x8;
+
+	auto ext = reinterpret_cast<DDS_HEADER_DXT10*>(fileData.data() + sizeof(uint32_t) + sizeof(DDS_HEADER));
+	ext->dxgiFormat = format;
+	ext->resourceDimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	ext->arraySize = 1;
+
+	uint8_t* dest = fileData.data() + headerBytes;
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		auto src = static_cast<const uint8_t*>(mips[mip].pData);
+		for (size_t row = 0; row < rowCount[mip]; ++row)
+		{
+			memcpy(dest, src + row * mips[mip].RowPitch, rowBytes[mip]);
+			dest += rowBytes[mip];
+		}
+	}
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+	ScopedHandle hFile(safe_handle(CreateFile2(szFileName, GENERIC_WRITE, 0, CREATE_ALWAYS, nullptr)));
+#else
+	ScopedHandle hFile(safe_handle(CreateFileW(szFileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)));
+#endif
+	if (!hFile)
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	DWORD bytesWritten = 0;
+	if (!WriteFile(hFile.get(), fileData.data(), static_cast<DWORD>(fileData.size()), &bytesWritten, nullptr))
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+	return bytesWritten == fileData.size() ? S_OK : E_FAIL;
+}
+
 _Use_decl_annotations_
 HRESULT DirectX::CreateDDSTextureFromFile( ID3D11Device* d3dDevice,
                                            ID3D11DeviceContext* d3dContext,
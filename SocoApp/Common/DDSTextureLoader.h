@@ -24,6 +24,8 @@
 
 #include <wrl.h>
 #include <d3d11_1.h>
+#include <memory>
+#include <vector>
 #include "d3dx12.h"
 
 #pragma warning(push)
@@ -92,6 +94,29 @@ namespace DirectX
 		                               _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
 		                               );
 
+	// Full-chain description from the header only, without reading the surface data
+	HRESULT GetDDSTextureDescFromFile12(_In_z_ const wchar_t* szFileName,
+		                                _Out_ D3D12_RESOURCE_DESC& desc
+		                                );
+
+	// Reads the whole file and splits it into subresources (slice-major, finest mip first);
+	// touches no device object, so it can run on a background thread
+	HRESULT LoadDDSTextureDataFromFile12(_In_z_ const wchar_t* szFileName,
+		                                 _Out_ std::unique_ptr<uint8_t[]>& ddsData,
+		                                 _Out_ D3D12_RESOURCE_DESC& desc,
+		                                 _Out_ std::vector<D3D12_SUBRESOURCE_DATA>& subresources
+		                                 );
+
+	// Writes a 2D texture with the given mip levels (finest first) as a DX10-header DDS;
+	// rows are repacked tightly, so RowPitch may include padding
+	HRESULT SaveDDSTextureToFile12(_In_z_ const wchar_t* szFileName,
+		                           _In_ DXGI_FORMAT format,
+		                           _In_ uint32_t width,
+		                           _In_ uint32_t height,
+		                           _In_reads_(mipCount) const D3D12_SUBRESOURCE_DATA* mips,
+		                           _In_ uint32_t mipCount
+		                           );
+
     // Standard version with optional auto-gen mipmap support
     HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
                                         _In_opt_ ID3D11DeviceContext* d3dContext,
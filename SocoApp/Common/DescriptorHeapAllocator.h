@@ -1,15 +1,19 @@
 #pragma once
 #include "d3dApp.h"
+#include "../Soco/Util/Stats.h"
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 struct DescriptorHeapAllocation
 {
 	CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle;
 	CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle;
 
+	//RTV/DSV堆不是着色器可见的，没有GPU句柄，只看CPU句柄
 	bool IsNull()
 	{
-		return cpuHandle.ptr == 0 || gpuHandle.ptr == 0;
+		return cpuHandle.ptr == 0;
 	}
 
 	DescriptorHeapAllocation()
@@ -30,11 +34,24 @@ public:
 	//	return instance;
 	//}
 
+	//多线程录制时Renderer可能并发地延迟创建视图，所以分配需要加锁
+	//单个分配时优先复用Free释放的描述符，多个分配总是从堆尾取连续的一段
 	void Allocate(const UINT NumAllocate = 1, DescriptorHeapAllocation* allocation = nullptr)
 	{
+		std::lock_guard<std::mutex> lock(mAllocateMutex);
+		if (NumAllocate == 1 && !mFreeIndices.empty())
+		{
+			if (allocation != nullptr)
+				GetDescriptor(allocation, mFreeIndices.back());
+			mFreeIndices.pop_back();
+			SOCO_STAT_ADD("DescriptorsReused", 1);
+			mInUseGauge->Set(AllocatorCount - (int)mFreeIndices.size());
+			return;
+		}
+
 		if (AllocatorCount + NumAllocate > MAX_DESCRIPTOR_COUNT) {
-			std::cout << "DescriptorHeapѴﵽ:" << MAX_DESCRIPTOR_COUNT << std::endl;
-			throw std::exception("DescriptorHeapѴﵽ");
+			std::cout << "DescriptorHeap已达到最大分配数:" << MAX_DESCRIPTOR_COUNT << std::endl;
+			throw std::exception("DescriptorHeap已达到最大分配数");
 		}
 		else
 		{
@@ -52,9 +69,25 @@ public:
 			}
 
 			AllocatorCount += NumAllocate;
+			SOCO_STAT_ADD("DescriptorsAllocated", NumAllocate);
+			mInUseGauge->Set(AllocatorCount - (int)mFreeIndices.size());
 		}
 	}
 
+	//释放单个分配的描述符并把allocation置空，调用者保证GPU已经不再使用它(比如在飞的帧都已经执行完)
+	void Free(DescriptorHeapAllocation& allocation)
+	{
+		if (allocation.IsNull())
+			return;
+
+		std::lock_guard<std::mutex> lock(mAllocateMutex);
+		const UINT index = (UINT)((allocation.cpuHandle.ptr - mDescriptorHeap->GetCPUDescriptorHandleForHeapStart().ptr) / mDescriptorSize);
+		assert(index < (UINT)AllocatorCount && "描述符不是这个堆分配的");
+		mFreeIndices.push_back(index);
+		mInUseGauge->Set(AllocatorCount - (int)mFreeIndices.size());
+		allocation = DescriptorHeapAllocation();
+	}
+
 	void GetDescriptor(DescriptorHeapAllocation* allocation, const UINT Index)
 	{
 		CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
@@ -90,11 +123,26 @@ public:
 		ThrowIfFailed(Device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&mDescriptorHeap)));
 	
 		mDescriptorSize = DescriptorSize;
+
+		//每种堆一个gauge，记录当前已分配的描述符数量
+		const char* typeName = "";
+		switch (Type)
+		{
+		case D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV: typeName = "CbvSrvUav"; break;
+		case D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER: typeName = "Sampler"; break;
+		case D3D12_DESCRIPTOR_HEAP_TYPE_RTV: typeName = "Rtv"; break;
+		case D3D12_DESCRIPTOR_HEAP_TYPE_DSV: typeName = "Dsv"; break;
+		}
+		mInUseGauge = Soco::StatsRegistry::GetInstance()->GetGauge(std::string("DescriptorsInUse.") + typeName);
 	}
 private:
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mDescriptorHeap = nullptr;
 
 	int AllocatorCount = 0;
+	//Free释放的下标，单个分配时从尾部取
+	std::vector<UINT> mFreeIndices;
 	UINT mDescriptorSize;
+	std::mutex mAllocateMutex;
+	Soco::StatGauge* mInUseGauge = nullptr;
 };
 
@@ -18,6 +18,9 @@ public:
 	void Stop();  // Call when paused.
 	void Tick();  // Call every frame.
 
+	// 大于0时每次Tick固定前进seconds，不再读取QPC，用于可重复的benchmark；0恢复实时
+	void SetFixedDeltaTime(double seconds);
+
 private:
 	double mSecondsPerCount;
 	double mDeltaTime;
@@ -29,6 +32,9 @@ private:
 	__int64 mCurrTime;
 
 	bool mStopped;
+
+	double mFixedDeltaTime;
+	double mFixedTotalTime;
 };
 
 #endif // GAMETIMER_H
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "d3dUtil.h"
 #include "d3dApp.h"
 #include "D3D12MemAlloc.h"
+#include "../Soco/Util/Stats.h"
 
 class UploadBuffer
 {
@@ -67,14 +68,22 @@ public:
 	template <typename T>
     void CopyData(int elementIndex, const T& data)
     {
+        SOCO_STAT_ADD("UploadBufferBytes", sizeof(T));
         memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(T));
     }
 
 	void CopyData(int elementIndex, const BYTE* data, UINT size)
 	{
+		SOCO_STAT_ADD("UploadBufferBytes", size);
 		memcpy(&mMappedData[elementIndex*mElementByteSize], data, size);
 	}
 
+	// 直接写映射的内存，省掉一次拷贝，由调用者统计上传字节
+	BYTE* GetMappedData(int elementIndex)
+	{
+		return &mMappedData[elementIndex*mElementByteSize];
+	}
+
 private:
     Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
     BYTE* mMappedData = nullptr;
@@ -4,6 +4,8 @@
 
 #include "d3dApp.h"
 #include <WindowsX.h>
+#include "../Soco/Util/Profiler.h"
+#include "../Soco/Util/Stats.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace std;
@@ -87,13 +89,32 @@ int D3DApp::Run()
 		// Otherwise, do animation/game stuff.
 		else
         {	
+			uint64_t frameBegin = Soco::Profiler::Now();
 			mTimer.Tick();
 
 			if( !mAppPaused )
 			{
 				CalculateFrameStats();
 
-				mKeysTracker.Update(mKeyboard->GetState());
+				if (mBenchmark)
+				{
+					mBenchmark->BeginFrame(mScriptedKeys);
+
+					//Keyboard::State是256个按键位，和DirectXTK内部的做法一样按uint32_t写入
+					uint32_t* keyBits = reinterpret_cast<uint32_t*>(&mScriptedKeyboardState);
+					for (size_t i = 0; i < mScriptedKeys.size(); ++i)
+					{
+						if (mScriptedKeys[i])
+							keyBits[i >> 5] |= 1u << (i & 31);
+						else
+							keyBits[i >> 5] &= ~(1u << (i & 31));
+					}
+					mKeysTracker.Update(mScriptedKeyboardState);
+				}
+				else
+				{
+					mKeysTracker.Update(mKeyboard->GetState());
+				}
 
 				Update(mTimer);	
 
@@ -101,7 +122,21 @@ int D3DApp::Run()
                 Draw(mTimer);
 				//rdoc_api->EndFrameCapture(nullptr, nullptr);
 
-				mMouseTracker.Update(mMouse->GetState());
+				uint64_t frameTime = Soco::Profiler::Now() - frameBegin;
+
+				//收集本帧各线程的profile zone
+				Soco::Profiler::GetInstance()->EndFrame();
+				//采样并清零本帧的统计计数
+				Soco::StatsRegistry::GetInstance()->EndFrame();
+
+				mMouseTracker.Update(mBenchmark ? DirectX::Mouse::State{} : mMouse->GetState());
+
+				if (mBenchmark)
+				{
+					mBenchmark->EndFrame(frameTime, Soco::Profiler::GetInstance()->GetLastFrame());
+					if (mBenchmark->IsFinished())
+						break;
+				}
 			}
 			else
 			{
@@ -110,10 +145,27 @@ int D3DApp::Run()
         }
     }
 
-	return (int)msg.wParam;
+	int exitCode = (int)msg.wParam;
+	if (mBenchmark)
+	{
+		const std::string& reportPath = mBenchmark->GetConfig().ReportPath;
+		if (mBenchmark->WriteReport())
+			std::cout << "已导出benchmark报告" << reportPath << std::endl;
+		else
+			std::cout << "导出benchmark报告失败：" << reportPath << std::endl;
+
+		//回放中有检查失败时退出码为1，脚本可以直接判断
+		for (const std::string& failure : mBenchmark->GetFailures())
+		{
+			std::cout << "benchmark检查失败：" << failure << std::endl;
+			exitCode = 1;
+		}
+	}
+
+	return exitCode;
 }
 
-//cout
+//用于cout输出
 class outbuf : public std::streambuf {
 public:
 	outbuf() {
@@ -719,7 +771,7 @@ void D3DApp::CalculateFrameStats()
 
 	frameCnt++;
 
-	//һͳһ
+	//一秒统计一次
 	// Compute averages over one second period.
 	if( (mTimer.TotalTime() - timeElapsed) >= 1.0f )
 	{
@@ -816,8 +868,17 @@ void D3DApp::LogOutputDisplayModes(IDXGIOutput* output, DXGI_FORMAT format)
     }
 }
 
+void D3DApp::SetBenchmark(const Soco::BenchmarkConfig& config)
+{
+	mBenchmark = std::make_unique<Soco::Benchmark>(config);
+	mTimer.SetFixedDeltaTime(config.FixedDeltaTime);
+}
+
 bool D3DApp::GetKey(Key key)
 {
+	if (mBenchmark)
+		return mScriptedKeyboardState.IsKeyDown(key);
+
 	auto& state = mKeyboard->GetState();
 	return state.IsKeyDown(key);
 }
@@ -832,6 +893,9 @@ bool D3DApp::GetKeyUp(Key key)
 
 bool D3DApp::GetKey(MouseKey mouse)
 {
+	if (mBenchmark)
+		return false;
+
 	auto& state = mMouse->GetState();
 	switch (mouse)
 	{
@@ -874,6 +938,9 @@ bool D3DApp::GetKeyUp(MouseKey mouse)
 
 POINT D3DApp::GetMouseMove()
 {
+	if (mBenchmark)
+		return { 0, 0 };
+
 	auto& lastState = mMouseTracker.GetLastState();
 	auto& currState = mMouse->GetState();
 
@@ -892,6 +959,11 @@ void D3DApp::GetCbvSrvUavAllocate(DescriptorHeapAllocation* allocation, const UI
 	mApp->mCbvSrvUavHeap->Allocate(NumAllocate, allocation);
 }
 
+ID3D12DescriptorHeap* D3DApp::GetCbvSrvUavHeap()
+{
+	return mApp->mCbvSrvUavHeap->GetDescriptorHeap();
+}
+
 void D3DApp::GetRtvAllocate(DescriptorHeapAllocation* allocation, const UINT NumAllocate)
 {
 	mApp->mRtvHeap->Allocate(NumAllocate, allocation);
@@ -900,4 +972,19 @@ void D3DApp::GetRtvAllocate(DescriptorHeapAllocation* allocation, const UINT Num
 void D3DApp::GetDsvAllocate(DescriptorHeapAllocation* allocation, const UINT NumAllocate)
 {
 	mApp->mDsvHeap->Allocate(NumAllocate, allocation);
+}
+
+void D3DApp::FreeCbvSrvUavAllocate(DescriptorHeapAllocation& allocation)
+{
+	mApp->mCbvSrvUavHeap->Free(allocation);
+}
+
+void D3DApp::FreeRtvAllocate(DescriptorHeapAllocation& allocation)
+{
+	mApp->mRtvHeap->Free(allocation);
+}
+
+void D3DApp::FreeDsvAllocate(DescriptorHeapAllocation& allocation)
+{
+	mApp->mDsvHeap->Free(allocation);
 }
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include "renderdoc_app.h"
 
 #include "DescriptorHeapAllocator.h"
+#include "../Soco/Util/Benchmark.h"
 
 // Link necessary d3d12 libraries.
 #pragma comment(lib,"d3dcompiler.lib")
@@ -50,11 +51,15 @@ public:
     bool Get4xMsaaState()const;
     void Set4xMsaaState(bool value);
 
+	//在Initialize前调用：固定步长、按脚本回放输入，运行指定帧数后写出报告并退出
+	void SetBenchmark(const Soco::BenchmarkConfig& config);
+
 	UINT GetCbvSrvUavDescriptorSize() { return mCbvSrvUavDescriptorSize; }
 
 	int Run();
 
 	static ID3D12Device* GetDevice() { return mApp->md3dDevice.Get(); }
+	static IDXGIAdapter1* GetAdapter() { return mApp->mAdapter.Get(); }
 	static D3D12MA::Allocator* GetVideoMemoryAllocator() { return mApp->mAllocator; }
 	static ID3D12GraphicsCommandList* GetCommandList() { return mApp->mCommandList.Get(); }
 	static DXGI_FORMAT GetBackBufferFormat() { return mApp->mBackBufferFormat; }
@@ -62,8 +67,13 @@ public:
 	static std::pair<bool, UINT> GetMSAAState() { return { mApp->m4xMsaaQuality, mApp->m4xMsaaQuality }; }
  
 	static void GetCbvSrvUavAllocate(DescriptorHeapAllocation* allocation, const UINT NumAllocate);
+	static ID3D12DescriptorHeap* GetCbvSrvUavHeap();
 	static void GetRtvAllocate(DescriptorHeapAllocation* allocation, const UINT NumAllocate);
 	static void GetDsvAllocate(DescriptorHeapAllocation* allocation, const UINT NumAllocate);
+	//释放单个分配的描述符，之后可以被再次分配，调用者保证GPU已经不再使用
+	static void FreeCbvSrvUavAllocate(DescriptorHeapAllocation& allocation);
+	static void FreeRtvAllocate(DescriptorHeapAllocation& allocation);
+	static void FreeDsvAllocate(DescriptorHeapAllocation& allocation);
 
     virtual bool Initialize();
     virtual LRESULT MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -126,7 +136,7 @@ protected:
     bool      m4xMsaaState = false;    // 4X MSAA enabled
     UINT      m4xMsaaQuality = 0;      // quality level of 4X MSAA
 
-	// Used to keep track of the delta-time?and game time (?.4).
+	// Used to keep track of the 揹elta-time?and game time (?.4).
 	GameTimer mTimer;
 	
     Microsoft::WRL::ComPtr<IDXGIFactory4> mdxgiFactory;
@@ -182,5 +192,10 @@ protected:
 
 	RENDERDOC_API_1_1_2 *rdoc_api = nullptr;
 
+	//benchmark模式下键盘状态来自输入脚本，鼠标不动
+	std::unique_ptr<Soco::Benchmark> mBenchmark;
+	std::bitset<256> mScriptedKeys;
+	DirectX::Keyboard::State mScriptedKeyboardState = {};
+
 };
 
@@ -34,6 +34,11 @@
 
 extern const int gNumFrameResources;
 
+namespace Soco
+{
+struct MeshletSet;
+}
+
 inline void d3dSetDebugName(IDXGIObject* obj, const char* name)
 {
     if(obj)
@@ -152,6 +157,15 @@ public:
 // geometries are stored in one vertex and index buffer.  It provides the offsets
 // and data needed to draw a subset of geometry stores in the vertex and index 
 // buffers so that we can implement the technique described by Figure 6.3.
+//简化后的一级LOD，与原子网格共用顶点，索引在同一个索引缓冲里
+struct SubmeshLod
+{
+	UINT IndexCount = 0;
+	UINT StartIndexLocation = 0;
+	//物体空间的几何误差，选择LOD时投影到屏幕上比较
+	float Error = 0.0f;
+};
+
 struct SubmeshGeometry
 {
 	UINT IndexCount = 0;
@@ -161,6 +175,15 @@ struct SubmeshGeometry
     // Bounding box of the geometry defined by this submesh. 
     // This is used in later chapters of the book.
 	DirectX::BoundingBox Bounds;
+
+	//可选的meshlet剔除数据，顶点序号相对BaseVertexLocation，见Soco/Util/Meshlet.h
+	std::shared_ptr<const Soco::MeshletSet> Meshlets;
+
+	//可选的LOD链，由细到粗，不含子网格本身；只有完整网格做meshlet剔除
+	std::vector<SubmeshLod> Lods;
+
+	//每个物体空间单位对应的UV长度，纹理流式加载用它估计屏幕上的纹素密度；0表示未知，用到的纹理保持完整精度
+	float UvDensity = 0.0f;
 };
 
 struct MeshGeometry
@@ -185,6 +208,11 @@ struct MeshGeometry
 	DXGI_FORMAT IndexFormat = DXGI_FORMAT_R16_UINT;
 	UINT IndexBufferByteSize = 0;
 
+	//放在共享几何缓冲(Soco::GeometryArena)里时，网格在缓冲里的位置，draw时加到子网格的BaseVertexLocation/StartIndexLocation上
+	//此时两个视图覆盖整个共享缓冲，自己单独创建缓冲的网格保持0
+	INT ArenaBaseVertex = 0;
+	UINT ArenaStartIndex = 0;
+
 	// A MeshGeometry may store multiple geometries in one vertex/index buffer.
 	// Use this container to define the Submesh geometries so we can draw
 	// the Submeshes individually.
@@ -293,7 +321,7 @@ struct Texture
 #define ReleaseCom(x) { if(x){ x->Release(); x = 0; } }
 #endif
 
-//ԶID3DInclude
+//自定义的ID3DInclude
 //class SocoShaderInclude : public ID3DInclude {
 //public:
 //	SocoShaderInclude(){}
@@ -317,10 +345,10 @@ struct Texture
 //			IncludeFilePath += IncludeFileName;
 //			break;
 //		default:
-//			assert("Include Type Ƿ" && 0);
+//			assert("Include Type 非法" && 0);
 //		}
-//		std::cout << "IncludeΪ " << type << std::endl;
-//		std::cout << "Include·Ϊ " << IncludeFilePath << std::endl;
+//		std::cout << "Include类型为 " << type << std::endl;
+//		std::cout << "Include路径为 " << IncludeFilePath << std::endl;
 //
 //		//return S_OK;
 //		std::ifstream includeFile(IncludeFilePath, std::ios::in | std::ios::binary | std::ios::ate);
@@ -363,29 +391,29 @@ struct Texture
 inline std::wstring StringToWstring(std::string str)
 {
 	std::wstring result;
-	//ȡСռ䣬Сַ  
+	//获取缓冲区大小，并申请空间，缓冲区大小按字符计算  
 	int len = MultiByteToWideChar(CP_ACP, 0, str.c_str(), str.size(), NULL, 0);
 	TCHAR* buffer = new TCHAR[len + 1];
-	//ֽڱתɿֽڱ  
+	//多字节编码转换成宽字节编码  
 	MultiByteToWideChar(CP_ACP, 0, str.c_str(), str.size(), buffer, len);
-	buffer[len] = '\0';             //ַβ  
-	//ɾֵ  
+	buffer[len] = '\0';             //添加字符串结尾  
+	//删除缓冲区并返回值  
 	result.append(buffer);
 	delete[] buffer;
 	return result;
 }
 
-//wstringתstring  
+//将wstring转换成string  
 inline std::string WstringToString(std::wstring wstr)
 {
 	std::string result;
-	//ȡСռ䣬С°ֽڼ  
+	//获取缓冲区大小，并申请空间，缓冲区大小事按字节计算的  
 	int len = WideCharToMultiByte(CP_ACP, 0, wstr.c_str(), wstr.size(), NULL, 0, NULL, NULL);
 	char* buffer = new char[len + 1];
-	//ֽڱתɶֽڱ  
+	//宽字节编码转换成多字节编码  
 	WideCharToMultiByte(CP_ACP, 0, wstr.c_str(), wstr.size(), buffer, len, NULL, NULL);
 	buffer[len] = '\0';
-	//ɾֵ  
+	//删除缓冲区并返回值  
 	result.append(buffer);
 	delete[] buffer;
 	return result;
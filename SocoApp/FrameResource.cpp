@@ -6,10 +6,49 @@ FrameResource::FrameResource(ID3D12Device* device, UINT passSize)
         D3D12_COMMAND_LIST_TYPE_DIRECT,
 		IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
 
+    ThrowIfFailed(device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(PostCmdListAlloc.GetAddressOf())));
+    ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+        PostCmdListAlloc.Get(), nullptr, IID_PPV_ARGS(PostCmdList.GetAddressOf())));
+    PostCmdList->Close();
+
+    D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    queryHeapDesc.Count = Soco::GpuProfiler::QueriesPerFrame;
+    ThrowIfFailed(device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(TimestampQueryHeap.GetAddressOf())));
+
+    ThrowIfFailed(device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(Soco::GpuProfiler::QueriesPerFrame * sizeof(UINT64)),
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(TimestampReadback.GetAddressOf())));
+
     PassCB = std::make_unique<UploadBuffer>(gNumFrameResources, passSize, true);
 }
 
 FrameResource::~FrameResource()
 {
 
+}
+
+void FrameResource::EnsureChunkCommandLists(ID3D12Device* device, UINT count)
+{
+    while (ChunkCmdLists.size() < count)
+    {
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> alloc;
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> cmdList;
+        ThrowIfFailed(device->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            IID_PPV_ARGS(alloc.GetAddressOf())));
+        ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+            alloc.Get(), nullptr, IID_PPV_ARGS(cmdList.GetAddressOf())));
+        // 创建后处于录制状态，先关闭，Draw时统一Reset
+        cmdList->Close();
+
+        ChunkCmdListAllocs.push_back(alloc);
+        ChunkCmdLists.push_back(cmdList);
+    }
 }
\ No newline at end of file
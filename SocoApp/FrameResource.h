@@ -4,6 +4,7 @@
 #include "Common/MathHelper.h"
 #include "Common/UploadBuffer.h"
 #include "Common/D3D12MemAlloc.h"
+#include "Soco/GpuProfiler.h"
 
 extern const int gNumFrameResources;
 
@@ -17,8 +18,23 @@ public:
     FrameResource& operator=(const FrameResource& rhs) = delete;
     ~FrameResource();
 
+    // 保证至少有count个分块命令列表可用，不足时创建
+    void EnsureChunkCommandLists(ID3D12Device* device, UINT count);
 
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
+
+    // 多线程录制：每个分块一个allocator + command list，由一个工作线程独占
+    std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> ChunkCmdListAllocs;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>> ChunkCmdLists;
+
+    // 后处理与Present前的屏障，和分块并行录制
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> PostCmdListAlloc;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> PostCmdList;
+
+    // GPU计时：本帧的时间戳查询，帧末resolve到readback buffer，fence完成后读取
+    Microsoft::WRL::ComPtr<ID3D12QueryHeap> TimestampQueryHeap;
+    Microsoft::WRL::ComPtr<ID3D12Resource> TimestampReadback;
+
     std::unique_ptr<UploadBuffer> PassCB = nullptr;
     UINT64 Fence = 0;
 };
\ No newline at end of file
@@ -0,0 +1,8 @@
+#ifndef _COSOINC_BINDLESS_
+#define _COSOINC_BINDLESS_
+
+// Every material texture lives in one descriptor range owned by Soco/BindlessTextureTable.
+// Materials store indices into it in their constant buffer; index 0 is a null SRV.
+Texture2D gBindlessTextures[] : register(t0, space1);
+
+#endif
@@ -0,0 +1,13 @@
+#include "FullScreen.hlsli"
+
+Texture2D gInput : register(t0);
+
+FullScreenOut VS(uint vI : SV_VERTEXID)
+{
+	return FullScreenVS(vI);
+}
+
+float4 PS(FullScreenOut i) : SV_TARGET
+{
+	return gInput[int2(i.PositionCS.xy)];
+}
@@ -19,8 +19,7 @@
 
 // Include structures and functions for lighting.
 #include "Common.hlsli"
-
-Texture2D    gDiffuseMap : register(t0);
+#include "Bindless.hlsli"
 
 // Constant data that varies per frame.
 cbuffer cbPerObject : register(b0)
@@ -35,6 +34,7 @@ cbuffer cbMaterial : register(b2)
     float3   gFresnelR0;
     float    gRoughness;
 	float4x4 gMatTransform;
+	uint     gDiffuseMapIndex;
 };
 
 struct VertexIn
@@ -75,7 +75,7 @@ VertexOut VS(VertexIn vin)
 
 float4 PS(VertexOut pin) : SV_Target
 {
-    float4 diffuseAlbedo = gDiffuseMap.Sample(gsamAnisotropicWrap, pin.TexC) * gDiffuseAlbedo;
+    float4 diffuseAlbedo = gBindlessTextures[gDiffuseMapIndex].Sample(gsamAnisotropicWrap, pin.TexC) * gDiffuseAlbedo;
     //return diffuseAlbedo * float4(1, 0, 1, 1);
 #ifdef ALPHA_TEST
 	// Discard pixel if texture alpha < 0.1.  We do this test as soon 
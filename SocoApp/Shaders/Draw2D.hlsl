@@ -1,11 +1,11 @@
 #include "Common.hlsli"
-
-Texture2D MainTex : register(t0);
+#include "Bindless.hlsli"
 
 cbuffer cbTexPosition : register(b0)
 {
     float2 gTexSize;
     float2 gTexOffset;
+    uint gTextureIndex;
 }
 
 struct VertexOut
@@ -28,5 +28,5 @@ VertexOut VS(uint vI : SV_VERTEXID)
 
 float4 PS(VertexOut i) : SV_TARGET
 {
-	return MainTex.Sample(gsamAnisotropicWrap, i.uv);
+	return gBindlessTextures[gTextureIndex].Sample(gsamAnisotropicWrap, i.uv);
 }
\ No newline at end of file
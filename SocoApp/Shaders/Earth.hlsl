@@ -1,18 +1,28 @@
 #include "Common.hlsli"
-
-Texture2D EarthDayMap : register(t0);
-Texture2D EarthNightMap : register(t1);
-Texture2D EarthCloudMap : register(t2);
+#include "PackedVertex.hlsli"
+#include "Bindless.hlsli"
 
 cbuffer cbPerObject : register(b0)
 {
     float4x4 gWorld;
 };
 
+cbuffer cbMaterial : register(b2)
+{
+    uint EarthDayMapIndex;
+    uint EarthNightMapIndex;
+    uint EarthCloudMapIndex;
+};
+
 struct VertexIn
 {
+#ifdef PACKED_VERTEX
+	float4 PositionOS    : POSITION;
+    float2 NormalOct : NORMAL;
+#else
 	float3 PositionOS    : POSITION;
     float3 NormalOS : NORMAL;
+#endif
 	float2 TexC    : TEXCOORD;
 };
 
@@ -28,10 +38,18 @@ VertexOut VS(VertexIn vin)
 {
 	VertexOut vout = (VertexOut)0.0f;
 
-	vout.PositionWS = mul(float4(vin.PositionOS, 1), gWorld);
+#ifdef PACKED_VERTEX
+    float3 positionOS = vin.PositionOS.xyz;
+    float3 normalOS = DecodeOctahedral(vin.NormalOct);
+#else
+    float3 positionOS = vin.PositionOS;
+    float3 normalOS = vin.NormalOS;
+#endif
+
+	vout.PositionWS = mul(float4(positionOS, 1), gWorld);
     vout.PositionCS = mul(vout.PositionWS, gViewProj);
 
-    vout.NormalWS = mul(vin.NormalOS, (float3x3)gWorld);
+    vout.NormalWS = mul(normalOS, (float3x3)gWorld);
     vout.TexC = vin.TexC;
 
     return vout;
@@ -39,9 +57,9 @@ VertexOut VS(VertexIn vin)
 
 float4 PS(VertexOut pin) : SV_Target
 {
-    float4 dayAlbedo = EarthDayMap.Sample(gsamAnisotropicWrap, pin.TexC);
-    float4 nightAlbedo = EarthNightMap.Sample(gsamAnisotropicWrap, pin.TexC);
-    float4 cloudAlbedo = EarthCloudMap.Sample(gsamAnisotropicWrap, pin.TexC);
+    float4 dayAlbedo = gBindlessTextures[EarthDayMapIndex].Sample(gsamAnisotropicWrap, pin.TexC);
+    float4 nightAlbedo = gBindlessTextures[EarthNightMapIndex].Sample(gsamAnisotropicWrap, pin.TexC);
+    float4 cloudAlbedo = gBindlessTextures[EarthCloudMapIndex].Sample(gsamAnisotropicWrap, pin.TexC);
 
     Light mainLight = gLights[1];
     float3 lightDir = mainLight.Position - pin.PositionWS.xyz;
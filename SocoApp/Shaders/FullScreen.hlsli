@@ -0,0 +1,19 @@
+#ifndef _COSOINC_FULLSCREEN_
+#define _COSOINC_FULLSCREEN_
+
+struct FullScreenOut
+{
+	float4 PositionCS : SV_POSITION;
+	float2 uv : TEXCOORD;
+};
+
+// One triangle covering the whole viewport, draw with DrawInstanced(3, 1, 0, 0) and no vertex buffer
+FullScreenOut FullScreenVS(uint vI : SV_VERTEXID)
+{
+	FullScreenOut o = (FullScreenOut)0;
+	o.uv = float2((vI << 1) & 2, vI & 2);
+	o.PositionCS = float4(o.uv.x * 2 - 1, 1 - o.uv.y * 2, 0, 1);
+	return o;
+}
+
+#endif
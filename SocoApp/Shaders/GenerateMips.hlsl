@@ -0,0 +1,68 @@
+// Builds one mip level from the previous one. Sizes come from the resources, so no constant buffer is needed.
+// MIP_MIN / MIP_MAX: take the min / max over the footprint (conservative heightmap bounds), default is the area-weighted box.
+// SRGB: gSrcMip is read through an _SRGB view (already linear), gDstMip is a UNORM view so the result is encoded by hand.
+
+Texture2D<float4> gSrcMip   : register(t0);
+RWTexture2D<float4> gDstMip : register(u0);
+
+// Same footprint as the CPU box filter: even sizes take two texels at 1/2,
+// an odd size 2n+1 takes texels 2i, 2i+1, 2i+2 weighted (n-i), n, (i+1) over 2n+1
+uint TapCount(uint srcSize)
+{
+	return srcSize == 1 ? 1 : ((srcSize & 1) ? 3 : 2);
+}
+
+float TapWeight(uint i, uint k, uint srcSize, uint dstSize)
+{
+	if (srcSize == 1)
+		return 1.0;
+	if ((srcSize & 1) == 0)
+		return 0.5;
+	float n = dstSize;
+	return (k == 0 ? n - i : (k == 1 ? n : i + 1)) / srcSize;
+}
+
+float3 LinearToSrgb(float3 c)
+{
+	return c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+}
+
+[numthreads(8, 8, 1)]
+void GenerateMipCS(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+	uint srcWidth, srcHeight, dstWidth, dstHeight;
+	gSrcMip.GetDimensions(srcWidth, srcHeight);
+	gDstMip.GetDimensions(dstWidth, dstHeight);
+	if (dispatchThreadID.x >= dstWidth || dispatchThreadID.y >= dstHeight)
+		return;
+
+#if defined(MIP_MIN)
+	float4 result = 1e30;
+#elif defined(MIP_MAX)
+	float4 result = -1e30;
+#else
+	float4 result = 0;
+#endif
+
+	uint countX = TapCount(srcWidth);
+	uint countY = TapCount(srcHeight);
+	for (uint ky = 0; ky < countY; ++ky)
+	{
+		for (uint kx = 0; kx < countX; ++kx)
+		{
+			float4 texel = gSrcMip.Load(int3(dispatchThreadID.x * 2 + kx, dispatchThreadID.y * 2 + ky, 0));
+#if defined(MIP_MIN)
+			result = min(result, texel);
+#elif defined(MIP_MAX)
+			result = max(result, texel);
+#else
+			result += texel * TapWeight(dispatchThreadID.x, kx, srcWidth, dstWidth) * TapWeight(dispatchThreadID.y, ky, srcHeight, dstHeight);
+#endif
+		}
+	}
+
+#ifdef SRGB
+	result.rgb = LinearToSrgb(saturate(result.rgb));
+#endif
+	gDstMip[dispatchThreadID.xy] = result;
+}
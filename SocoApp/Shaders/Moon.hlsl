@@ -1,16 +1,26 @@
 #include "Common.hlsli"
-
-Texture2D MoonMap : register(t0);
+#include "PackedVertex.hlsli"
+#include "Bindless.hlsli"
 
 cbuffer cbPerObject : register(b0)
 {
     float4x4 gWorld;
 };
 
+cbuffer cbMaterial : register(b2)
+{
+    uint MoonMapIndex;
+};
+
 struct VertexIn
 {
+#ifdef PACKED_VERTEX
+	float4 PositionOS    : POSITION;
+    float2 NormalOct : NORMAL;
+#else
 	float3 PositionOS    : POSITION;
     float3 NormalOS : NORMAL;
+#endif
 	float2 TexC    : TEXCOORD;
 };
 
@@ -26,10 +36,18 @@ VertexOut VS(VertexIn vin)
 {
 	VertexOut vout = (VertexOut)0.0f;
 
-	vout.PositionWS = mul(float4(vin.PositionOS, 1), gWorld);
+#ifdef PACKED_VERTEX
+    float3 positionOS = vin.PositionOS.xyz;
+    float3 normalOS = DecodeOctahedral(vin.NormalOct);
+#else
+    float3 positionOS = vin.PositionOS;
+    float3 normalOS = vin.NormalOS;
+#endif
+
+	vout.PositionWS = mul(float4(positionOS, 1), gWorld);
     vout.PositionCS = mul(vout.PositionWS, gViewProj);
 
-    vout.NormalWS = mul(vin.NormalOS, (float3x3)gWorld);
+    vout.NormalWS = mul(normalOS, (float3x3)gWorld);
     vout.TexC = vin.TexC;
 
     return vout;
@@ -37,7 +55,7 @@ VertexOut VS(VertexIn vin)
 
 float4 PS(VertexOut pin) : SV_Target
 {
-    float4 moonAlbedo = MoonMap.Sample(gsamAnisotropicWrap, pin.TexC);
+    float4 moonAlbedo = gBindlessTextures[MoonMapIndex].Sample(gsamAnisotropicWrap, pin.TexC);
 
     Light mainLight = gLights[1];
     float3 lightDir = mainLight.Position - pin.PositionWS.xyz;
@@ -0,0 +1,16 @@
+#ifndef _COSOINC_PACKEDVERTEX_
+#define _COSOINC_PACKEDVERTEX_
+
+// Decode side of Soco/Util/VertexCompression. The input assembler already converts
+// half/snorm/unorm to float, only the octahedral unfold is left to the shader.
+
+// Inverse of EncodeOctahedral, e in [-1,1]^2
+float3 DecodeOctahedral(float2 e)
+{
+    float3 n = float3(e, 1 - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0 ? -t : t;
+    return normalize(n);
+}
+
+#endif
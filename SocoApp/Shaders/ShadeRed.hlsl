@@ -1,9 +1,28 @@
+#include "FullScreen.hlsli"
+
 Texture2D gInput            : register(t0);
 RWTexture2D<float4> gOutput : register(u0);
 
+float4 ShadeRedColor(float4 color)
+{
+	return color * float4(1, 0, 1, 1);
+}
+
+// Compute version, writes a UAV target so it can be chained with other compute effects
 [numthreads(32, 32, 1)]
-void ShadeRed(int3 groupThreadID : SV_GroupThreadID,
+void ShadeRedCS(int3 groupThreadID : SV_GroupThreadID,
 				int3 dispatchThreadID : SV_DispatchThreadID)
 {
-	gOutput[dispatchThreadID.xy] = gInput[dispatchThreadID.xy] * float4(1, 0, 1, 1);
-}
\ No newline at end of file
+	gOutput[dispatchThreadID.xy] = ShadeRedColor(gInput[dispatchThreadID.xy]);
+}
+
+// Full-screen pixel version, the last effect of the chain writes straight into the back buffer
+FullScreenOut VS(uint vI : SV_VERTEXID)
+{
+	return FullScreenVS(vI);
+}
+
+float4 PS(FullScreenOut i) : SV_TARGET
+{
+	return ShadeRedColor(gInput[int2(i.PositionCS.xy)]);
+}
@@ -0,0 +1,40 @@
+#include "Common.hlsli"
+#include "Bindless.hlsli"
+
+// Must match Soco::SpriteInstance in Soco/Util/SpriteBatchBuilder.h.
+struct SpriteInstance
+{
+    float2 Size;
+    float2 Offset;
+    float4 UvRect;
+    uint TextureIndex;
+};
+
+// One entry per sprite, sorted by (layer, texture) on the CPU; bound as a root SRV.
+StructuredBuffer<SpriteInstance> gSprites : register(t0);
+
+struct VertexOut
+{
+    float4 PositionCS : SV_POSITION;
+    float2 uv : TEXCOORD;
+    nointerpolation uint TextureIndex : TEXINDEX;
+};
+
+VertexOut VS(uint vI : SV_VERTEXID, uint iI : SV_INSTANCEID)
+{
+    SpriteInstance sprite = gSprites[iI];
+
+    VertexOut o = (VertexOut)0;
+    float2 corner = float2(vI & 1, vI >> 1);
+    float2 pos = float2(corner.x, 1.0f - corner.y) * sprite.Size + sprite.Offset;
+    o.PositionCS = float4(pos * 2 - 1, 0, 1);
+    o.uv = sprite.UvRect.xy + corner * sprite.UvRect.zw;
+    o.TextureIndex = sprite.TextureIndex;
+    return o;
+}
+
+float4 PS(VertexOut i) : SV_TARGET
+{
+    // The index varies per instance, so it is not uniform across a wave.
+    return gBindlessTextures[NonUniformResourceIndex(i.TextureIndex)].Sample(gsamAnisotropicWrap, i.uv);
+}
@@ -1,16 +1,26 @@
 #include "Common.hlsli"
-
-Texture2D SunNoiseMap : register(t0);
+#include "PackedVertex.hlsli"
+#include "Bindless.hlsli"
 
 cbuffer cbPerObject : register(b0)
 {
     float4x4 gWorld;
 };
 
+cbuffer cbMaterial : register(b2)
+{
+    uint SunNoiseMapIndex;
+};
+
 struct VertexIn
 {
+#ifdef PACKED_VERTEX
+	float4 PositionOS    : POSITION;
+    float2 NormalOct : NORMAL;
+#else
 	float3 PositionOS    : POSITION;
     float3 NormalOS : NORMAL;
+#endif
 	float2 TexC    : TEXCOORD;
 };
 
@@ -26,10 +36,18 @@ VertexOut VS(VertexIn vin)
 {
 	VertexOut vout = (VertexOut)0.0f;
 
-	vout.PositionWS = mul(float4(vin.PositionOS, 1), gWorld);
+#ifdef PACKED_VERTEX
+    float3 positionOS = vin.PositionOS.xyz;
+    float3 normalOS = DecodeOctahedral(vin.NormalOct);
+#else
+    float3 positionOS = vin.PositionOS;
+    float3 normalOS = vin.NormalOS;
+#endif
+
+	vout.PositionWS = mul(float4(positionOS, 1), gWorld);
     vout.PositionCS = mul(vout.PositionWS, gViewProj);
 
-    vout.NormalWS = mul(vin.NormalOS, (float3x3)gWorld);
+    vout.NormalWS = mul(normalOS, (float3x3)gWorld);
     vout.TexC = vin.TexC;
 
     return vout;
@@ -40,7 +58,7 @@ float4 PS(VertexOut pin) : SV_Target
     // Light mainLight = gLights[0];
     // float ndotl = saturate(dot(-mainLight.Direction, pin.NormalWS.xyz));
     // return float4(ndotl.xxx, 1);
-    float4 sunAlbedo = SunNoiseMap.Sample(gsamAnisotropicWrap, pin.TexC);
+    float4 sunAlbedo = gBindlessTextures[SunNoiseMapIndex].Sample(gsamAnisotropicWrap, pin.TexC);
 
     float3 color = lerp(float3(0.603, 0.07, 0.07), float3(1, 0.7, 0.227), sunAlbedo.r);
 
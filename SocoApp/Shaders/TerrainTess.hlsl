@@ -8,12 +8,21 @@ cbuffer cbPerObject : register(b0)
     float HeightMapWidth;
     float HeightMapHeight;
     float Height;
+    // Grid vertex counts, the packed path rebuilds x/z and uv from SV_VertexID
+    float GridColumns;
+    float GridRows;
 };
 
 struct VertexIn
 {
+#ifdef PACKED_VERTEX
+    // unorm16 height relative to [0, Height], vertices are stored row by row
+    float HeightOS : POSITION;
+    uint VertexId : SV_VertexID;
+#else
 	float3 PositionOS    : POSITION;
 	float2 TexC    : TEXCOORD;
+#endif
 };
 
 struct VertexOut
@@ -26,8 +35,15 @@ VertexOut VS(VertexIn vin)
 {
 	VertexOut vout = (VertexOut)0.0f;
 
+#ifdef PACKED_VERTEX
+    uint columns = (uint)GridColumns;
+    float2 grid = float2(vin.VertexId % columns, vin.VertexId / columns);
+    vout.TexC = grid / float2(GridColumns - 1, GridRows - 1);
+    vout.PositionOS = float3((vout.TexC.x - 0.5) * HeightMapWidth, vin.HeightOS * Height, (vout.TexC.y - 0.5) * HeightMapHeight);
+#else
     vout.PositionOS = vin.PositionOS;
     vout.TexC = vin.TexC;
+#endif
 
     // int3 SamplePosition = int3(vout.TexC * float2(HeightMapWidth - 1, HeightMapHeight - 1), 0);
     // float height = HeightMap.Load(SamplePosition).x;
@@ -137,10 +153,11 @@ struct DomainOut
     float3 Color : TEXCOORD3;
 };
 
-float3 EstimateNormal(float2 texcoord)
+// lod is the height map mip to read; the Sobel taps step one texel of that mip so the normal stays consistent
+float3 EstimateNormal(float2 texcoord, float lod)
 {
     float2 uvOffset = float2(1.0 / HeightMapWidth, 1.0 / HeightMapHeight);
-    float uvScale = 1;
+    float uvScale = exp2(lod);
 
     float2 uvb = texcoord + uvOffset * float2(0, -1) * uvScale;
     float2 uvc = texcoord + uvOffset * float2(1, -1) * uvScale;
@@ -151,14 +168,14 @@ float3 EstimateNormal(float2 texcoord)
     float2 uvh = texcoord + uvOffset * float2(-1, 0) * uvScale;
     float2 uvi = texcoord + uvOffset * float2(-1, -1) * uvScale;
 
-    float yb = HeightMap.SampleLevel(gsamLinearClamp, uvb, 0).x * Height;
-    float yc = HeightMap.SampleLevel(gsamLinearClamp, uvc, 0).x * Height;
-    float yd = HeightMap.SampleLevel(gsamLinearClamp, uvd, 0).x * Height;
-    float ye = HeightMap.SampleLevel(gsamLinearClamp, uve, 0).x * Height;
-    float yf = HeightMap.SampleLevel(gsamLinearClamp, uvf, 0).x * Height;
-    float yg = HeightMap.SampleLevel(gsamLinearClamp, uvg, 0).x * Height;
-    float yh = HeightMap.SampleLevel(gsamLinearClamp, uvh, 0).x * Height;
-    float yi = HeightMap.SampleLevel(gsamLinearClamp, uvi, 0).x * Height;
+    float yb = HeightMap.SampleLevel(gsamLinearClamp, uvb, lod).x * Height;
+    float yc = HeightMap.SampleLevel(gsamLinearClamp, uvc, lod).x * Height;
+    float yd = HeightMap.SampleLevel(gsamLinearClamp, uvd, lod).x * Height;
+    float ye = HeightMap.SampleLevel(gsamLinearClamp, uve, lod).x * Height;
+    float yf = HeightMap.SampleLevel(gsamLinearClamp, uvf, lod).x * Height;
+    float yg = HeightMap.SampleLevel(gsamLinearClamp, uvg, lod).x * Height;
+    float yh = HeightMap.SampleLevel(gsamLinearClamp, uvh, lod).x * Height;
+    float yi = HeightMap.SampleLevel(gsamLinearClamp, uvi, lod).x * Height;
 
     float3 normal = float3(-yc-2*yd-ye+yg+2*yh+yi, 8, 2*yb+yc-ye-2*yf-yg+yi);
 
@@ -183,13 +200,18 @@ DomainOut DS(PatchTess patchTess,
 
     int3 SamplePosition = int3(dout.TexC * float2(HeightMapWidth - 1, HeightMapHeight - 1), 0);
     //float height = HeightMap.Load(SamplePosition).x;
-    float height = HeightMap.SampleLevel(gsamLinearClamp, dout.TexC, 0).x;
+    // Displace from the mip matching the tessellation density: one tessellated step covers patch texels / tess factor,
+    // sampling finer than that aliases and thrashes the texture cache. The factor is evaluated at the vertex itself
+    // (not per patch) so vertices on a shared edge pick the same mip and no cracks open up
+    float2 patchTexels = abs(quad[3].TexC - quad[0].TexC) * float2(HeightMapWidth, HeightMapHeight);
+    float lod = log2(max(max(patchTexels.x, patchTexels.y) / CalcQuadTessFactor(PositionOS, PositionOS), 1));
+    float height = HeightMap.SampleLevel(gsamLinearClamp, dout.TexC, lod).x;
 
     dout.PositionWS.y = height * Height;
 
     dout.PositionCS = mul(dout.PositionWS, gViewProj);
 
-    //dout.NormalWS = float4(EstimateNormal(dout.TexC), 0);
+    //dout.NormalWS = float4(EstimateNormal(dout.TexC, lod), 0);
 
     if(tessUV.x == 0 || tessUV.y == 0 || tessUV.x == 1 || tessUV.y == 1)
         dout.Color = float3(1, 0, 0);
@@ -207,7 +229,7 @@ float4 PS(DomainOut pin) : SV_Target
     //return Albedo;
     Light mainLight = gLights[0];
 
-    float3 normal = EstimateNormal(pin.TexC);
+    float3 normal = EstimateNormal(pin.TexC, HeightMap.CalculateLevelOfDetail(gsamLinearClamp, pin.TexC));
 
     float ndotl = saturate(dot(-normalize(mainLight.Direction), normal));
 
@@ -0,0 +1,131 @@
+#include "BindlessTextureTable.h"
+
+#include "../Common/d3dApp.h"
+#include "Texture.h"
+#include "Util/Stats.h"
+
+namespace Soco
+{
+
+void BindlessTextureTable::Initialize(ID3D12Device* device, uint32_t capacity, uint32_t frameCopies)
+{
+	assert(mDevice == nullptr && "无绑定纹理表只能初始化一次");
+	assert(capacity > 1 && frameCopies > 0);
+	mDevice = device;
+	mCapacity = capacity;
+	mDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	mAllocator = std::make_unique<BindlessIndexAllocator>(capacity, frameCopies);
+
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.NumDescriptors = capacity;
+	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	ThrowIfFailed(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&mCpuHeap)));
+
+	//各副本在着色器可见堆里首尾相接，只需要第一个位置
+	std::vector<DescriptorHeapAllocation> copies(capacity * frameCopies);
+	D3DApp::GetCbvSrvUavAllocate(copies.data(), (UINT)copies.size());
+	mCopies = copies[0];
+	mTableStart = mCopies.gpuHandle;
+
+	//没有用到的位置也要是合法的描述符，全部写成空的SRV
+	D3D12_SHADER_RESOURCE_VIEW_DESC nullDesc = {};
+	nullDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	nullDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	nullDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	nullDesc.Texture2D.MipLevels = 1;
+	CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mCpuHeap->GetCPUDescriptorHandleForHeapStart());
+	for (uint32_t i = 0; i < capacity; ++i)
+	{
+		device->CreateShaderResourceView(nullptr, &nullDesc, cpuHandle);
+		cpuHandle.Offset(1, mDescriptorSize);
+	}
+	for (uint32_t copy = 0; copy < frameCopies; ++copy)
+		device->CopyDescriptorsSimple(capacity, CopyHandle(copy, 0), mCpuHeap->GetCPUDescriptorHandleForHeapStart(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	const uint32_t nullIndex = mAllocator->Allocate();
+	assert(nullIndex == NullIndex);
+}
+
+uint32_t BindlessTextureTable::Register(Texture* texture)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	const uint32_t index = mAllocator->Allocate();
+	if (index == BindlessIndexAllocator::InvalidIndex)
+	{
+		std::cout << "无绑定纹理表已满(" << mCapacity << ")，" << texture->Name << "使用空纹理" << std::endl;
+		return NullIndex;
+	}
+
+	WriteDescriptor(index, texture);
+	return index;
+}
+
+void BindlessTextureTable::Refresh(Texture* texture)
+{
+	const uint32_t index = texture->mBindlessIndex.load(std::memory_order_acquire);
+	if (index == Texture::InvalidBindlessIndex || index == NullIndex)
+		return;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	WriteDescriptor(index, texture);
+}
+
+void BindlessTextureTable::Release(uint32_t index)
+{
+	if (index == NullIndex)
+		return;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	//描述符不用清掉，重新分配前一定会重写
+	if (!mAllocator->Free(index))
+		std::cout << "无绑定纹理表重复释放下标" << index << std::endl;
+}
+
+void BindlessTextureTable::BeginFrame(uint32_t frameIndex)
+{
+	SOCO_PROFILE_SCOPE("BindlessTextureTable");
+	std::lock_guard<std::mutex> lock(mMutex);
+	const std::vector<uint32_t>& dirty = mAllocator->BeginFrame(frameIndex);
+
+	//下标是升序的，连续的一段一次拷贝
+	CD3DX12_CPU_DESCRIPTOR_HANDLE srcStart(mCpuHeap->GetCPUDescriptorHandleForHeapStart());
+	for (size_t begin = 0; begin < dirty.size();)
+	{
+		size_t end = begin + 1;
+		while (end < dirty.size() && dirty[end] == dirty[end - 1] + 1)
+			++end;
+
+		mDevice->CopyDescriptorsSimple((UINT)(end - begin), CopyHandle(frameIndex, dirty[begin]),
+			CD3DX12_CPU_DESCRIPTOR_HANDLE(srcStart, dirty[begin], mDescriptorSize), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		begin = end;
+	}
+	SOCO_STAT_ADD("BindlessDescriptorCopies", dirty.size());
+
+	mTableStart = CD3DX12_GPU_DESCRIPTOR_HANDLE(mCopies.gpuHandle, frameIndex * mCapacity, mDescriptorSize);
+}
+
+void BindlessTextureTable::EndFrame()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mAllocator->EndFrame();
+}
+
+void BindlessTextureTable::WriteDescriptor(uint32_t index, Texture* texture)
+{
+	CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mCpuHeap->GetCPUDescriptorHandleForHeapStart(), index, mDescriptorSize);
+	texture->WriteSRV(cpuHandle);
+	mAllocator->MarkDirty(index);
+
+	//当前帧的副本GPU还没开始用，直接写，这一帧录制的draw就能用上
+	const uint32_t copy = mAllocator->GetCurrentCopy();
+	if (copy != BindlessIndexAllocator::InvalidIndex)
+		mDevice->CopyDescriptorsSimple(1, CopyHandle(copy, index), cpuHandle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+CD3DX12_CPU_DESCRIPTOR_HANDLE BindlessTextureTable::CopyHandle(uint32_t copy, uint32_t index) const
+{
+	return CD3DX12_CPU_DESCRIPTOR_HANDLE(mCopies.cpuHandle, copy * mCapacity + index, mDescriptorSize);
+}
+
+}
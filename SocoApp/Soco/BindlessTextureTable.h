@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include "../Common/d3dUtil.h"
+#include "../Common/DescriptorHeapAllocator.h"
+#include "Util/BindlessIndexAllocator.h"
+
+namespace Soco
+{
+class Texture;
+
+/*
+无绑定纹理表：材质用到的2D纹理的SRV都放在着色器可见堆里一段连续的范围，每张纹理有一个不变的下标，材质把下标写在常量缓冲里
+shader里声明为Texture2D gBindlessTextures[] : register(t0, space1)，Shader反射到没有大小的纹理数组时把它的根参数指向这里，
+设置根签名时一起设置，绘制时不再按纹理设置描述符表
+所有描述符先写在一个CPU端的堆里，着色器可见堆里每个FrameResource一份副本，由BindlessIndexAllocator决定每帧要更新哪些
+0号下标固定是空的SRV，没有设置纹理时采样得到0
+*/
+class BindlessTextureTable
+{
+public:
+	static constexpr uint32_t NullIndex = 0;
+
+	static BindlessTextureTable* GetInstance()
+	{
+		static BindlessTextureTable* instance = new BindlessTextureTable();
+		return instance;
+	}
+
+	// capacity也是shader里数组的大小，要在编译shader之前调用；frameCopies是FrameResource的数量
+	void Initialize(ID3D12Device* device, uint32_t capacity, uint32_t frameCopies);
+	uint32_t GetCapacity() const { return mCapacity; }
+
+	// 给纹理分配下标并写SRV，只用于Texture2D这样的2D纹理；表满时返回NullIndex
+	uint32_t Register(Texture* texture);
+	// 纹理的资源变了(常驻管理换了资源、RenderTexture改变大小)，没有分配下标时什么也不做
+	void Refresh(Texture* texture);
+	// 纹理析构时调用，下标等在飞的帧执行完后才会再分配
+	void Release(uint32_t index);
+
+	// 每帧等到这个FrameResource的fence之后、录制之前调用：把这份副本里过期的描述符从CPU端的堆拷过来
+	void BeginFrame(uint32_t frameIndex);
+	// 这一帧提交之后调用，之后到下次BeginFrame之间写的描述符不会碰在飞的副本
+	void EndFrame();
+
+	// 当前帧使用的副本的起始位置，Shader设置根签名时绑定
+	D3D12_GPU_DESCRIPTOR_HANDLE GetTableStart() const { return mTableStart; }
+
+private:
+	BindlessTextureTable() {}
+
+	// 调用时持有mMutex
+	void WriteDescriptor(uint32_t index, Texture* texture);
+	CD3DX12_CPU_DESCRIPTOR_HANDLE CopyHandle(uint32_t copy, uint32_t index) const;
+
+	ID3D12Device* mDevice = nullptr;
+	uint32_t mCapacity = 0;
+	UINT mDescriptorSize = 0;
+	// CPU端的堆，保存每个下标最新的描述符，作为拷贝的源
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mCpuHeap;
+	// 着色器可见堆里连续的frameCopies * capacity个描述符的起始位置
+	DescriptorHeapAllocation mCopies;
+	D3D12_GPU_DESCRIPTOR_HANDLE mTableStart = {};
+	std::unique_ptr<BindlessIndexAllocator> mAllocator;
+	// 录制线程可能同时第一次访问纹理的下标
+	std::mutex mMutex;
+};
+
+}
@@ -0,0 +1,369 @@
+#include "FrameGraph.h"
+#include "GpuProfiler.h"
+
+namespace Soco
+{
+
+ID3D12Resource* FrameGraphResources::GetResource(FrameGraphResource resource) const
+{
+	const FrameGraph::ResourceEntry& entry = mGraph.mResourceEntries[resource];
+	if (entry.Resource != nullptr)
+		return entry.Resource;
+
+	RenderTexture* texture = GetTexture(resource);
+	return texture != nullptr ? texture->GetResource() : nullptr;
+}
+
+RenderTexture* FrameGraphResources::GetTexture(FrameGraphResource resource) const
+{
+	const FrameGraph::ResourceEntry& entry = mGraph.mResourceEntries[resource];
+	if (entry.Texture != nullptr)
+		return entry.Texture;
+
+	uint32_t slot = mGraph.mCompiled.PhysicalSlot[resource];
+	return slot != FGInvalidIndex ? mGraph.mSlotTextures[slot] : nullptr;
+}
+
+FrameGraph::~FrameGraph()
+{
+	//析构前调用者已经FlushCommandQueue，纹理要先于它们所在的堆释放
+	for (TransientHeap& heap : mHeaps)
+		ReleaseHeap(heap);
+	for (RetiredHeap& retired : mRetiredHeaps)
+		ReleaseHeap(retired.Heap);
+}
+
+FrameGraphResource FrameGraph::ImportResource(const std::string& name, ID3D12Resource* resource,
+	D3D12_RESOURCE_STATES currentState, D3D12_RESOURCE_STATES finalState)
+{
+	FGResourceInfo info;
+	info.Name = name;
+	info.Imported = true;
+	info.InitialState = (uint32_t)currentState;
+	info.FinalState = (uint32_t)finalState;
+
+	ResourceEntry entry;
+	entry.Resource = resource;
+	mResourceEntries.push_back(entry);
+	return mCompiler.AddResource(info);
+}
+
+FrameGraphResource FrameGraph::ImportTexture(const std::string& name, RenderTexture* texture)
+{
+	FGResourceInfo info;
+	info.Name = name;
+	info.Imported = true;
+	info.InitialState = (uint32_t)texture->GetCurrentState();
+
+	ResourceEntry entry;
+	entry.Texture = texture;
+	mResourceEntries.push_back(entry);
+	return mCompiler.AddResource(info);
+}
+
+FrameGraphResource FrameGraph::CreateTexture(const std::string& name, const FrameGraphTextureDesc& desc)
+{
+	FGResourceInfo info;
+	info.Name = name;
+	info.AliasKey = HashDesc(desc);
+	mTransientDescs[info.AliasKey] = desc;
+
+	D3D12_RESOURCE_DESC texDesc = RenderTexture::BuildDesc(desc.Width, desc.Height, desc.Formats);
+	D3D12_RESOURCE_ALLOCATION_INFO allocInfo = D3DApp::GetDevice()->GetResourceAllocationInfo(0, 1, &texDesc);
+	info.Size = allocInfo.SizeInBytes;
+	info.Alignment = allocInfo.Alignment;
+	info.HeapGroup = HeapGroupOf(desc);
+
+	mResourceEntries.push_back(ResourceEntry());
+	return mCompiler.AddResource(info);
+}
+
+void FrameGraph::AddPass(const std::string& name, const std::function<void(FrameGraphPassBuilder&)>& setup, ExecuteFunc execute)
+{
+	FGPassInfo info;
+	info.Name = name;
+	FrameGraphPassBuilder builder(info);
+	setup(builder);
+
+	mCompiler.AddPass(info);
+	mExecuteFuncs.push_back(std::move(execute));
+	mIsCompiled = false;
+}
+
+void FrameGraph::Compile()
+{
+	mSlotTextures.clear();
+	mCompiled = mCompiler.Compile([this](const FGCompileResult& layout, uint32_t slot) {
+		assert(slot == mSlotTextures.size());
+		uint32_t group = layout.SlotHeapGroup[slot];
+		RenderTexture* texture = group == FGInvalidIndex ?
+			AcquireTransient(layout.SlotAliasKey[slot], layout.SlotOrdinal[slot]) :
+			AcquirePlaced(group, layout.HeapSize[group], layout.SlotAliasKey[slot], layout.SlotHeapOffset[slot]);
+		mSlotTextures.push_back(texture);
+		return (uint32_t)texture->GetCurrentState();
+	});
+	mIsCompiled = true;
+}
+
+void FrameGraph::Execute(ID3D12GraphicsCommandList* cmdList)
+{
+	if (!mIsCompiled)
+		Compile();
+
+	FrameGraphResources resources(*this);
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+	for (const FGCompiledPass& pass : mCompiled.Passes)
+	{
+		barriers.clear();
+		AppendBarriers(pass.Barriers, barriers);
+		if (!barriers.empty())
+			cmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+
+		//刚开始占用堆内存的纹理内容未定义，RT/DS/UAV需要Discard(或完整Clear)后才能使用
+		for (const FGAccess& activated : pass.Activated)
+		{
+			if (activated.State == D3D12_RESOURCE_STATE_RENDER_TARGET || activated.State == D3D12_RESOURCE_STATE_DEPTH_WRITE ||
+				activated.State == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+				cmdList->DiscardResource(resources.GetResource(activated.Resource), nullptr);
+		}
+
+		GpuProfileScope gpuZone(cmdList, mCompiler.GetPass(pass.Pass).Name);
+		mExecuteFuncs[pass.Pass](cmdList, resources);
+	}
+
+	barriers.clear();
+	AppendBarriers(mCompiled.FinalBarriers, barriers);
+	if (!barriers.empty())
+		cmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+
+	//同步纹理自己记录的状态，下一帧和其他代码才能从正确的状态转换
+	for (FrameGraphResource r = 0; r < mResourceEntries.size(); ++r)
+	{
+		if (mResourceEntries[r].Texture != nullptr)
+			mResourceEntries[r].Texture->SetCurrentState((D3D12_RESOURCE_STATES)mCompiled.ResourceFinalState[r]);
+	}
+	for (uint32_t slot = 0; slot < mSlotTextures.size(); ++slot)
+	{
+		mSlotTextures[slot]->SetCurrentState((D3D12_RESOURCE_STATES)mCompiled.SlotFinalState[slot]);
+	}
+
+	ReleaseUnusedTransients();
+	Reset();
+}
+
+bool FrameGraph::IsPassCulled(const std::string& name) const
+{
+	for (uint32_t pass = 0; pass < mCompiler.PassCount(); ++pass)
+	{
+		if (mCompiler.GetPass(pass).Name == name)
+			return mIsCompiled && mCompiled.PassCulled[pass];
+	}
+	return true;
+}
+
+UINT64 FrameGraph::GetTransientHeapSize() const
+{
+	UINT64 size = 0;
+	for (UINT64 heapSize : mCompiled.HeapSize)
+		size += heapSize;
+	return size;
+}
+
+uint64_t FrameGraph::HashDesc(const FrameGraphTextureDesc& desc)
+{
+	//FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	auto combine = [&hash](uint64_t value) {
+		for (int i = 0; i < 8; ++i)
+		{
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 1099511628211ull;
+		}
+	};
+
+	combine(desc.Width);
+	combine(desc.Height);
+	combine(desc.Formats.ResourceFormat);
+	combine(desc.Formats.SrvFormat);
+	combine(desc.Formats.UavFormat);
+	combine(desc.Formats.RtvFormat);
+	combine(desc.Formats.DsvFormat);
+	return hash;
+}
+
+RenderTexture* FrameGraph::AcquireTransient(uint64_t key, uint32_t ordinal)
+{
+	std::vector<TransientTexture>& textures = mTransientPool[key];
+	while (textures.size() <= ordinal)
+	{
+		FrameGraphTextureDesc& desc = mTransientDescs[key];
+		TransientTexture transient;
+		transient.Texture = std::make_unique<RenderTexture>(desc.Width, desc.Height, desc.Formats);
+		textures.push_back(std::move(transient));
+	}
+
+	textures[ordinal].LastUsedFrame = mFrameIndex;
+	return textures[ordinal].Texture.get();
+}
+
+uint32_t FrameGraph::HeapGroupOf(const FrameGraphTextureDesc& desc) const
+{
+	//Resource Heap Tier 1的堆只能放一类资源，RT/DS纹理和其他纹理分开放
+	if (D3DApp::GetVideoMemoryAllocator()->GetD3D12Options().ResourceHeapTier >= D3D12_RESOURCE_HEAP_TIER_2)
+		return 0;
+
+	bool rtOrDs = desc.Formats.RtvFormat != DXGI_FORMAT_UNKNOWN || desc.Formats.DsvFormat != DXGI_FORMAT_UNKNOWN;
+	return rtOrDs ? 0 : 1;
+}
+
+RenderTexture* FrameGraph::AcquirePlaced(uint32_t group, UINT64 heapSize, uint64_t key, UINT64 offset)
+{
+	if (mHeaps.size() <= group)
+		mHeaps.resize(group + 1);
+
+	TransientHeap& heap = mHeaps[group];
+	if (heap.Size < heapSize)
+	{
+		//扩容：旧堆和上面的纹理延迟释放，新堆上的纹理重新创建
+		if (heap.Allocation != nullptr)
+		{
+			RetiredHeap retired;
+			retired.Heap = std::move(heap);
+			retired.RetiredFrame = mFrameIndex;
+			mRetiredHeaps.push_back(std::move(retired));
+			heap = TransientHeap();
+		}
+
+		const bool tier2 = D3DApp::GetVideoMemoryAllocator()->GetD3D12Options().ResourceHeapTier >= D3D12_RESOURCE_HEAP_TIER_2;
+		D3D12MA::ALLOCATION_DESC allocDesc = {};
+		allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+		if (!tier2)
+			allocDesc.ExtraHeapFlags = group == 0 ? D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES : D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+
+		D3D12_RESOURCE_ALLOCATION_INFO allocInfo = {};
+		allocInfo.SizeInBytes = (heapSize + 0xFFFF) & ~(UINT64)0xFFFF;
+		allocInfo.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		ThrowIfFailed(D3DApp::GetVideoMemoryAllocator()->AllocateMemory(&allocDesc, &allocInfo, &heap.Allocation));
+		heap.Size = allocInfo.SizeInBytes;
+	}
+
+	TransientTexture& transient = heap.Textures[{ key, offset }];
+	if (transient.Texture == nullptr)
+	{
+		FrameGraphTextureDesc& desc = mTransientDescs[key];
+		transient.Texture = std::make_unique<RenderTexture>(desc.Width, desc.Height, desc.Formats, heap.Allocation, offset);
+	}
+
+	transient.LastUsedFrame = mFrameIndex;
+	return transient.Texture.get();
+}
+
+void FrameGraph::ReleaseHeap(TransientHeap& heap)
+{
+	heap.Textures.clear();
+	if (heap.Allocation != nullptr)
+	{
+		heap.Allocation->Release();
+		heap.Allocation = nullptr;
+	}
+	heap.Size = 0;
+}
+
+void FrameGraph::AppendBarriers(const std::vector<FGBarrier>& barriers, std::vector<D3D12_RESOURCE_BARRIER>& out) const
+{
+	FrameGraphResources resources(*this);
+	for (const FGBarrier& barrier : barriers)
+	{
+		ID3D12Resource* resource = resources.GetResource(barrier.Resource);
+		switch (barrier.Type)
+		{
+		case FGBarrier::BarrierType::Transition:
+			out.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource,
+				(D3D12_RESOURCE_STATES)barrier.StateBefore, (D3D12_RESOURCE_STATES)barrier.StateAfter));
+			break;
+		case FGBarrier::BarrierType::UAV:
+			out.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+			break;
+		case FGBarrier::BarrierType::Aliasing:
+			out.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(
+				barrier.ResourceBefore != FGInvalidIndex ? resources.GetResource(barrier.ResourceBefore) : nullptr, resource));
+			break;
+		}
+	}
+}
+
+void FrameGraph::ReleaseUnusedTransients()
+{
+	//超过gNumFrameResources帧没用过的纹理GPU已经不会再访问，可以释放(比如窗口大小改变后旧尺寸的纹理)
+	auto expired = [this](const TransientTexture& transient) {
+		return mFrameIndex - transient.LastUsedFrame > (UINT64)gNumFrameResources;
+	};
+
+	for (auto ite = mTransientPool.begin(); ite != mTransientPool.end();)
+	{
+		std::vector<TransientTexture>& textures = ite->second;
+		textures.erase(std::remove_if(textures.begin(), textures.end(), expired), textures.end());
+
+		if (textures.empty())
+			ite = mTransientPool.erase(ite);
+		else
+			++ite;
+	}
+
+	for (TransientHeap& heap : mHeaps)
+	{
+		for (auto ite = heap.Textures.begin(); ite != heap.Textures.end();)
+		{
+			if (expired(ite->second))
+				ite = heap.Textures.erase(ite);
+			else
+				++ite;
+		}
+	}
+
+	for (auto ite = mRetiredHeaps.begin(); ite != mRetiredHeaps.end();)
+	{
+		if (mFrameIndex - ite->RetiredFrame > (UINT64)gNumFrameResources)
+		{
+			ReleaseHeap(ite->Heap);
+			ite = mRetiredHeaps.erase(ite);
+		}
+		else
+		{
+			++ite;
+		}
+	}
+
+	//没有纹理再引用的描述
+	for (auto ite = mTransientDescs.begin(); ite != mTransientDescs.end();)
+	{
+		bool used = mTransientPool.count(ite->first) != 0;
+		for (const TransientHeap& heap : mHeaps)
+		{
+			auto texture = heap.Textures.lower_bound({ ite->first, 0 });
+			used = used || (texture != heap.Textures.end() && texture->first.first == ite->first);
+		}
+		for (const RetiredHeap& retired : mRetiredHeaps)
+		{
+			auto texture = retired.Heap.Textures.lower_bound({ ite->first, 0 });
+			used = used || (texture != retired.Heap.Textures.end() && texture->first.first == ite->first);
+		}
+
+		if (used)
+			++ite;
+		else
+			ite = mTransientDescs.erase(ite);
+	}
+}
+
+void FrameGraph::Reset()
+{
+	mCompiler.Clear();
+	mResourceEntries.clear();
+	mExecuteFuncs.clear();
+	mSlotTextures.clear();
+	mIsCompiled = false;
+	++mFrameIndex;
+}
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../Common/d3dUtil.h"
+#include "Texture.h"
+#include "Util/FrameGraphCompiler.h"
+
+extern const int gNumFrameResources;
+
+namespace Soco
+{
+
+using FrameGraphResource = uint32_t;
+
+struct FrameGraphTextureDesc
+{
+	UINT Width = 0;
+	UINT Height = 0;
+	RenderTextureFormat Formats;
+};
+
+class FrameGraphPassBuilder
+{
+public:
+	FrameGraphResource Read(FrameGraphResource resource, D3D12_RESOURCE_STATES state)
+	{
+		assert(FGState::IsReadOnly(state) && "Read需要只读状态");
+		mInfo.Accesses.push_back({ resource, (uint32_t)state });
+		return resource;
+	}
+
+	FrameGraphResource Write(FrameGraphResource resource, D3D12_RESOURCE_STATES state)
+	{
+		assert(!FGState::IsReadOnly(state) && "Write需要可写状态");
+		mInfo.Accesses.push_back({ resource, (uint32_t)state });
+		return resource;
+	}
+
+	//没有输出被使用也不会被剔除
+	void SetSideEffect() { mInfo.HasSideEffect = true; }
+
+private:
+	friend class FrameGraph;
+	FrameGraphPassBuilder(FGPassInfo& info) : mInfo(info) {}
+
+	FGPassInfo& mInfo;
+};
+
+class FrameGraph;
+
+//pass执行时通过它拿到资源
+class FrameGraphResources
+{
+public:
+	ID3D12Resource* GetResource(FrameGraphResource resource) const;
+	//Transient和ImportTexture导入的资源才有RenderTexture
+	RenderTexture* GetTexture(FrameGraphResource resource) const;
+
+private:
+	friend class FrameGraph;
+	FrameGraphResources(const FrameGraph& graph) : mGraph(graph) {}
+
+	const FrameGraph& mGraph;
+};
+
+/*
+每帧声明pass和它们读写的资源，Compile时剔除无用pass、按依赖排序、推导屏障并为transient资源分配物理纹理
+Execute时每个pass开始前把需要的屏障合并成一次ResourceBarrier调用
+transient纹理在多帧之间复用，描述相同且生命周期不重叠的资源共用同一张纹理
+transient纹理放置(placed)在每组一个的共享堆上，生命周期不重叠的纹理即使描述不同也共用内存，开始使用前发Aliasing屏障并Discard
+*/
+class FrameGraph
+{
+public:
+	using ExecuteFunc = std::function<void(ID3D12GraphicsCommandList*, const FrameGraphResources&)>;
+
+	FrameGraph() = default;
+	~FrameGraph();
+	FrameGraph(const FrameGraph& other) = delete;
+	FrameGraph& operator= (const FrameGraph& other) = delete;
+
+	FrameGraphResource ImportResource(const std::string& name, ID3D12Resource* resource,
+		D3D12_RESOURCE_STATES currentState, D3D12_RESOURCE_STATES finalState);
+	//状态从RenderTexture中读取，执行完写回
+	FrameGraphResource ImportTexture(const std::string& name, RenderTexture* texture);
+	FrameGraphResource CreateTexture(const std::string& name, const FrameGraphTextureDesc& desc);
+
+	void AddPass(const std::string& name, const std::function<void(FrameGraphPassBuilder&)>& setup, ExecuteFunc execute);
+
+	void Compile();
+	//录制所有存活的pass，之后清空本帧声明
+	void Execute(ID3D12GraphicsCommandList* cmdList);
+
+	bool IsPassCulled(const std::string& name) const;
+
+	//上一次Compile的transient内存：实际堆大小之和，以及不做内存别名时需要的大小
+	UINT64 GetTransientHeapSize() const;
+	UINT64 GetTransientTotalSize() const { return mCompiled.TransientTotalSize; }
+
+private:
+	friend class FrameGraphResources;
+
+	struct ResourceEntry
+	{
+		ID3D12Resource* Resource = nullptr;
+		RenderTexture* Texture = nullptr;
+	};
+
+	struct TransientTexture
+	{
+		std::unique_ptr<RenderTexture> Texture;
+		UINT64 LastUsedFrame = 0;
+	};
+
+	//共享堆和放置在上面的纹理，key是(AliasKey, 堆内偏移)
+	struct TransientHeap
+	{
+		D3D12MA::Allocation* Allocation = nullptr;
+		UINT64 Size = 0;
+		std::map<std::pair<uint64_t, UINT64>, TransientTexture> Textures;
+	};
+
+	//堆扩容后旧堆可能还在被GPU使用，等gNumFrameResources帧后再释放
+	struct RetiredHeap
+	{
+		TransientHeap Heap;
+		UINT64 RetiredFrame = 0;
+	};
+
+	static uint64_t HashDesc(const FrameGraphTextureDesc& desc);
+	uint32_t HeapGroupOf(const FrameGraphTextureDesc& desc) const;
+	RenderTexture* AcquireTransient(uint64_t key, uint32_t ordinal);
+	RenderTexture* AcquirePlaced(uint32_t group, UINT64 heapSize, uint64_t key, UINT64 offset);
+	static void ReleaseHeap(TransientHeap& heap);
+	void AppendBarriers(const std::vector<FGBarrier>& barriers, std::vector<D3D12_RESOURCE_BARRIER>& out) const;
+	void ReleaseUnusedTransients();
+	void Reset();
+
+	FrameGraphCompiler mCompiler;
+	FGCompileResult mCompiled;
+	bool mIsCompiled = false;
+
+	std::vector<ResourceEntry> mResourceEntries;
+	std::vector<ExecuteFunc> mExecuteFuncs;
+
+	std::unordered_map<uint64_t, FrameGraphTextureDesc> mTransientDescs;
+	std::unordered_map<uint64_t, std::vector<TransientTexture>> mTransientPool;
+	std::vector<RenderTexture*> mSlotTextures;
+	std::vector<TransientHeap> mHeaps;
+	std::vector<RetiredHeap> mRetiredHeaps;
+	UINT64 mFrameIndex = 0;
+};
+
+}
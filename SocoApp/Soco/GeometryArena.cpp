@@ -0,0 +1,216 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+#include "Util/Stats.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace Soco
+{
+
+void GeometryArena::Initialize(ID3D12Device* device, UINT64 vertexCapacity, UINT64 indexCapacity)
+{
+	mDevice = device;
+
+	mVertexPool.Name = L"Geometry Arena Vertex Buffer";
+	mVertexPool.Allocator.Reset(vertexCapacity);
+	mVertexPool.Buffer = CreateBuffer(vertexCapacity, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_GENERIC_READ, mVertexPool.Name);
+
+	mIndexPool.Name = L"Geometry Arena Index Buffer";
+	mIndexPool.Allocator.Reset(indexCapacity);
+	mIndexPool.Buffer = CreateBuffer(indexCapacity, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_GENERIC_READ, mIndexPool.Name);
+}
+
+void GeometryArena::Shutdown()
+{
+	mEntries.clear();
+	mRetired.clear();
+	mVertexPool.Buffer = nullptr;
+	mVertexPool.Allocator.Reset(0);
+	mIndexPool.Buffer = nullptr;
+	mIndexPool.Allocator.Reset(0);
+	mDevice = nullptr;
+}
+
+ComPtr<ID3D12Resource> GeometryArena::CreateBuffer(UINT64 size, D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_STATES state, const wchar_t* name)
+{
+	ComPtr<ID3D12Resource> buffer;
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(heapType),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		state,
+		nullptr,
+		IID_PPV_ARGS(buffer.GetAddressOf())));
+	buffer->SetName(name);
+	return buffer;
+}
+
+void GeometryArena::Upload(ID3D12GraphicsCommandList* cmdList, MeshGeometry* geo, const void* vertices, UINT64 vertexBytes,
+	const void* indices, UINT64 indexBytes)
+{
+	assert(mDevice != nullptr && "GeometryArena没有初始化");
+	assert(geo->VertexByteStride > 0 && vertexBytes % geo->VertexByteStride == 0);
+	assert(indexBytes % GetIndexSize(geo->IndexFormat) == 0);
+
+	Release(geo);
+
+	//偏移按步长对齐，BaseVertex和StartIndex才是整数
+	Entry entry;
+	entry.Vertex = Allocate(cmdList, mVertexPool, vertexBytes, geo->VertexByteStride);
+	entry.Index = Allocate(cmdList, mIndexPool, indexBytes, GetIndexSize(geo->IndexFormat));
+	mEntries[geo] = entry;
+
+	ComPtr<ID3D12Resource> upload = CreateBuffer(vertexBytes + indexBytes, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ,
+		L"Geometry Arena Uploader");
+	BYTE* mapped = nullptr;
+	ThrowIfFailed(upload->Map(0, nullptr, reinterpret_cast<void**>(&mapped)));
+	memcpy(mapped, vertices, (size_t)vertexBytes);
+	memcpy(mapped + vertexBytes, indices, (size_t)indexBytes);
+	upload->Unmap(0, nullptr);
+
+	D3D12_RESOURCE_BARRIER toCopy[] = {
+		CD3DX12_RESOURCE_BARRIER::Transition(mVertexPool.Buffer.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST),
+		CD3DX12_RESOURCE_BARRIER::Transition(mIndexPool.Buffer.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST),
+	};
+	cmdList->ResourceBarrier(_countof(toCopy), toCopy);
+	cmdList->CopyBufferRegion(mVertexPool.Buffer.Get(), mVertexPool.Allocator.GetOffset(entry.Vertex), upload.Get(), 0, vertexBytes);
+	cmdList->CopyBufferRegion(mIndexPool.Buffer.Get(), mIndexPool.Allocator.GetOffset(entry.Index), upload.Get(), vertexBytes, indexBytes);
+	D3D12_RESOURCE_BARRIER toRead[] = {
+		CD3DX12_RESOURCE_BARRIER::Transition(mVertexPool.Buffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ),
+		CD3DX12_RESOURCE_BARRIER::Transition(mIndexPool.Buffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ),
+	};
+	cmdList->ResourceBarrier(_countof(toRead), toRead);
+
+	//拷贝执行完之前上传缓冲不能释放，与CreateDefaultBuffer一样交给geo保管
+	geo->VertexBufferUploader = upload;
+	geo->IndexBufferUploader = nullptr;
+	SOCO_STAT_ADD("UploadBufferBytes", vertexBytes + indexBytes);
+
+	Patch(geo, entry);
+}
+
+void GeometryArena::Release(MeshGeometry* geo)
+{
+	auto it = mEntries.find(geo);
+	if (it == mEntries.end())
+		return;
+
+	mVertexPool.Allocator.Free(it->second.Vertex);
+	mVertexPool.Released = true;
+	mIndexPool.Allocator.Free(it->second.Index);
+	mIndexPool.Released = true;
+	mEntries.erase(it);
+
+	//已经录制的命令还在用共享缓冲，geo只是不再引用它
+	geo->VertexBufferGPU = nullptr;
+	geo->IndexBufferGPU = nullptr;
+	geo->ArenaBaseVertex = 0;
+	geo->ArenaStartIndex = 0;
+}
+
+RangeAllocator::Handle GeometryArena::Allocate(ID3D12GraphicsCommandList* cmdList, Pool& pool, UINT64 size, UINT64 alignment)
+{
+	RangeAllocator::Handle handle = pool.Allocator.Allocate(size, alignment);
+	if (handle != RangeAllocator::InvalidHandle)
+		return handle;
+
+	//放不下时容量翻倍，新增部分不小于size + alignment，挤紧后的空闲尾部一定放得下
+	RangeAllocator& allocator = pool.Allocator;
+	const UINT64 capacity = allocator.GetCapacity();
+	Reallocate(cmdList, pool, std::max<UINT64>(capacity * 2, capacity + size + alignment));
+
+	handle = allocator.Allocate(size, alignment);
+	assert(handle != RangeAllocator::InvalidHandle);
+	return handle;
+}
+
+void GeometryArena::Reallocate(ID3D12GraphicsCommandList* cmdList, Pool& pool, UINT64 capacity)
+{
+	//视图的SizeInBytes是UINT
+	assert(capacity <= UINT_MAX);
+
+	RangeAllocator& allocator = pool.Allocator;
+	const bool vertexPool = &pool == &mVertexPool;
+
+	//整理前记下每段的原偏移，挤紧后从旧缓冲的原位置拷到新缓冲的新位置
+	std::vector<std::pair<RangeAllocator::Handle, UINT64>> live;
+	live.reserve(mEntries.size());
+	for (const auto& pair : mEntries)
+	{
+		RangeAllocator::Handle handle = vertexPool ? pair.second.Vertex : pair.second.Index;
+		live.push_back({ handle, allocator.GetOffset(handle) });
+	}
+	allocator.Compact();
+	allocator.Grow(capacity);
+	pool.Released = false;
+
+	ComPtr<ID3D12Resource> buffer = CreateBuffer(allocator.GetCapacity(), D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, pool.Name);
+
+	//旧缓冲一直处于GENERIC_READ，已经包含COPY_SOURCE
+	UINT64 bytesMoved = 0;
+	for (const auto& range : live)
+	{
+		const UINT64 size = allocator.GetSize(range.first);
+		cmdList->CopyBufferRegion(buffer.Get(), allocator.GetOffset(range.first), pool.Buffer.Get(), range.second, size);
+		bytesMoved += size;
+	}
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(buffer.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+	SOCO_STAT_ADD("GeometryArenaBytesMoved", bytesMoved);
+
+	mRetired.push_back({ pool.Buffer, 0 });
+	pool.Buffer = buffer;
+
+	for (const auto& pair : mEntries)
+		Patch(pair.first, pair.second);
+}
+
+bool GeometryArena::MaybeDefragment(ID3D12GraphicsCommandList* cmdList, float threshold)
+{
+	bool defragmented = false;
+	for (Pool* pool : { &mVertexPool, &mIndexPool })
+	{
+		if (pool->Released && pool->Allocator.GetFragmentation() > threshold)
+		{
+			Reallocate(cmdList, *pool, pool->Allocator.GetCapacity());
+			defragmented = true;
+		}
+	}
+	return defragmented;
+}
+
+void GeometryArena::Defragment(ID3D12GraphicsCommandList* cmdList)
+{
+	Reallocate(cmdList, mVertexPool, mVertexPool.Allocator.GetCapacity());
+	Reallocate(cmdList, mIndexPool, mIndexPool.Allocator.GetCapacity());
+}
+
+void GeometryArena::SetRetireFence(UINT64 fenceValue)
+{
+	for (RetiredBuffer& retired : mRetired)
+	{
+		if (retired.Fence == 0)
+			retired.Fence = fenceValue;
+	}
+}
+
+void GeometryArena::ReleaseRetired(UINT64 completedFence)
+{
+	mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(), [completedFence](const RetiredBuffer& retired) {
+		return retired.Fence != 0 && retired.Fence <= completedFence;
+	}), mRetired.end());
+}
+
+void GeometryArena::Patch(MeshGeometry* geo, const Entry& entry)
+{
+	geo->VertexBufferGPU = mVertexPool.Buffer;
+	geo->VertexBufferByteSize = (UINT)mVertexPool.Allocator.GetCapacity();
+	geo->ArenaBaseVertex = (INT)(mVertexPool.Allocator.GetOffset(entry.Vertex) / geo->VertexByteStride);
+
+	geo->IndexBufferGPU = mIndexPool.Buffer;
+	geo->IndexBufferByteSize = (UINT)mIndexPool.Allocator.GetCapacity();
+	geo->ArenaStartIndex = (UINT)(mIndexPool.Allocator.GetOffset(entry.Index) / GetIndexSize(geo->IndexFormat));
+}
+
+}
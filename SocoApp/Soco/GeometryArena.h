@@ -0,0 +1,93 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "../Common/d3dUtil.h"
+#include "Util/RangeAllocator.h"
+
+namespace Soco
+{
+
+/*
+所有MeshGeometry共用的顶点/索引缓冲：一个大的顶点缓冲和一个大的索引缓冲，每个网格从里面分一段
+注册过的MeshGeometry的VertexBufferGPU/IndexBufferGPU指向共享缓冲，视图覆盖整个缓冲，网格自己的位置记在ArenaBaseVertex/ArenaStartIndex
+顶点步长和索引格式相同的网格视图完全一样，相邻的draw不需要重新绑定
+放不下时换成更大的缓冲，释放留下的空洞多了之后整理；两种情况都把存活的数据挤紧拷进新缓冲，旧缓冲等GPU用完再释放
+Upload/Release/Defragment会改写已注册MeshGeometry的字段，只能在主线程、录制draw之前调用
+*/
+class GeometryArena
+{
+public:
+	static GeometryArena* GetInstance()
+	{
+		static GeometryArena* instance = new GeometryArena();
+		return instance;
+	}
+
+	void Initialize(ID3D12Device* device, UINT64 vertexCapacity, UINT64 indexCapacity);
+	// 释放所有缓冲，调用前GPU要已经空闲
+	void Shutdown();
+
+	/*
+	geo的VertexByteStride和IndexFormat要先设置好，数据经过一个临时上传缓冲(存在geo->VertexBufferUploader里)拷进共享缓冲
+	完成后geo的缓冲、视图大小和ArenaBaseVertex/ArenaStartIndex都已填好；同一个geo再次上传会先释放原来的区间
+	*/
+	void Upload(ID3D12GraphicsCommandList* cmdList, MeshGeometry* geo, const void* vertices, UINT64 vertexBytes,
+		const void* indices, UINT64 indexBytes);
+	// 区间还回空闲表，注册过的geo析构前要调用
+	void Release(MeshGeometry* geo);
+
+	// 有释放过的区间、并且空闲空间的碎片程度(见RangeAllocator::GetFragmentation)超过threshold时整理，返回是否整理了
+	bool MaybeDefragment(ID3D12GraphicsCommandList* cmdList, float threshold = 0.5f);
+	void Defragment(ID3D12GraphicsCommandList* cmdList);
+
+	// 到目前为止录制的命令在GPU到达fenceValue时执行完，此前换下来的旧缓冲在那之后释放
+	void SetRetireFence(UINT64 fenceValue);
+	void ReleaseRetired(UINT64 completedFence);
+
+	const RangeAllocator& GetVertexAllocator() const { return mVertexPool.Allocator; }
+	const RangeAllocator& GetIndexAllocator() const { return mIndexPool.Allocator; }
+
+private:
+	struct Pool
+	{
+		RangeAllocator Allocator;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Buffer;
+		const wchar_t* Name = L"";
+		// 上次整理之后是否释放过区间，没释放过时碎片只来自对齐，不值得整理
+		bool Released = false;
+	};
+
+	struct Entry
+	{
+		RangeAllocator::Handle Vertex = RangeAllocator::InvalidHandle;
+		RangeAllocator::Handle Index = RangeAllocator::InvalidHandle;
+	};
+
+	struct RetiredBuffer
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Buffer;
+		// 0表示还没有SetRetireFence
+		UINT64 Fence = 0;
+	};
+
+	GeometryArena() {}
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer(UINT64 size, D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_STATES state, const wchar_t* name);
+	RangeAllocator::Handle Allocate(ID3D12GraphicsCommandList* cmdList, Pool& pool, UINT64 size, UINT64 alignment);
+	// 挤紧所有区间，容量至少为capacity，存活的数据拷进新缓冲，旧缓冲退役
+	void Reallocate(ID3D12GraphicsCommandList* cmdList, Pool& pool, UINT64 capacity);
+	// 把共享缓冲和区间位置写回geo
+	void Patch(MeshGeometry* geo, const Entry& entry);
+
+	static UINT GetIndexSize(DXGI_FORMAT format) { return format == DXGI_FORMAT_R16_UINT ? 2 : 4; }
+
+	ID3D12Device* mDevice = nullptr;
+	Pool mVertexPool;
+	Pool mIndexPool;
+
+	std::unordered_map<MeshGeometry*, Entry> mEntries;
+	std::vector<RetiredBuffer> mRetired;
+};
+
+}
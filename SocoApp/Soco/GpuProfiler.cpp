@@ -0,0 +1,117 @@
+#include "GpuProfiler.h"
+#include "Util/Profiler.h"
+
+namespace Soco
+{
+
+void GpuProfiler::ReadbackSource::ReadTimestamps(uint32_t frameSlot, uint32_t count, uint64_t* timestamps)
+{
+	ID3D12Resource* readback = Readbacks[frameSlot];
+	D3D12_RANGE readRange = { 0, count * sizeof(uint64_t) };
+	void* data = nullptr;
+	ThrowIfFailed(readback->Map(0, &readRange, &data));
+	memcpy(timestamps, data, count * sizeof(uint64_t));
+
+	D3D12_RANGE writtenRange = { 0, 0 };
+	readback->Unmap(0, &writtenRange);
+}
+
+void GpuProfiler::Initialize(ID3D12CommandQueue* queue, uint32_t frameSlotCount)
+{
+	mQueue = queue;
+	mRing.Initialize(frameSlotCount, MaxZonesPerFrame);
+	mSource.Readbacks.assign(frameSlotCount, nullptr);
+	Calibrate();
+}
+
+void GpuProfiler::Calibrate()
+{
+	UINT64 frequency = 1;
+	ThrowIfFailed(mQueue->GetTimestampFrequency(&frequency));
+
+	UINT64 gpuTimestamp = 0;
+	UINT64 cpuTimestamp = 0;
+	ThrowIfFailed(mQueue->GetClockCalibration(&gpuTimestamp, &cpuTimestamp));
+
+	//Profiler::Now用steady_clock，MSVC上它就是QueryPerformanceCounter换算成纳秒
+	LARGE_INTEGER qpcFrequency;
+	QueryPerformanceFrequency(&qpcFrequency);
+	const uint64_t qpf = (uint64_t)qpcFrequency.QuadPart;
+
+	mClock.Frequency = frequency;
+	mClock.GpuTimestamp = gpuTimestamp;
+	mClock.CpuTime = cpuTimestamp / qpf * 1000000000ull + cpuTimestamp % qpf * 1000000000ull / qpf;
+	mFramesSinceCalibration = 0;
+}
+
+void GpuProfiler::BeginFrame(uint32_t frameSlot, ID3D12QueryHeap* queryHeap, ID3D12Resource* readback, uint64_t completedFence)
+{
+	if (mQueue == nullptr)
+		return;
+
+	//两个时钟会慢慢漂移，定期重新对齐
+	if (++mFramesSinceCalibration >= 256)
+		Calibrate();
+
+	Profiler* profiler = Profiler::GetInstance();
+	for (GpuFrameTimings& frame : mRing.Collect(completedFence, mSource, mClock))
+	{
+		std::vector<ProfileEvent> events;
+		events.reserve(frame.Zones.size());
+		for (const GpuZoneTiming& zone : frame.Zones)
+		{
+			ProfileEvent e;
+			e.Name = profiler->InternName(zone.Name);
+			e.Begin = zone.Begin;
+			e.End = zone.End;
+			events.push_back(e);
+		}
+		profiler->AddGpuEvents(frame.FrameIndex, std::move(events));
+	}
+
+	mSource.Readbacks[frameSlot] = readback;
+	mQueryHeap = queryHeap;
+	mReadback = readback;
+	mRing.BeginFrame(profiler->GetFrameIndex(), frameSlot);
+	mRecording = true;
+}
+
+uint32_t GpuProfiler::BeginZone(ID3D12GraphicsCommandList* cmdList, const std::string& name)
+{
+	if (!mRecording)
+		return GpuTimestampRing::InvalidZone;
+
+	uint32_t zone = mRing.BeginZone(name);
+	if (zone != GpuTimestampRing::InvalidZone)
+		cmdList->EndQuery(mQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, GpuTimestampRing::BeginQueryIndex(zone));
+	return zone;
+}
+
+void GpuProfiler::EndZone(ID3D12GraphicsCommandList* cmdList, uint32_t zone)
+{
+	if (zone == GpuTimestampRing::InvalidZone)
+		return;
+
+	cmdList->EndQuery(mQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, GpuTimestampRing::EndQueryIndex(zone));
+}
+
+void GpuProfiler::ResolveFrame(ID3D12GraphicsCommandList* cmdList)
+{
+	if (!mRecording)
+		return;
+
+	uint32_t queryCount = mRing.GetUsedQueryCount();
+	if (queryCount > 0)
+		cmdList->ResolveQueryData(mQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, 0, queryCount, mReadback, 0);
+}
+
+void GpuProfiler::EndFrame(uint64_t fenceValue)
+{
+	if (!mRecording)
+		return;
+
+	mRing.EndFrame(fenceValue);
+	mRecording = false;
+}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../Common/d3dUtil.h"
+#include "Util/GpuTimestampRing.h"
+
+namespace Soco
+{
+
+/*
+GPU计时：每个FrameResource一个时间戳查询堆和readback buffer，zone开始/结束各写一个时间戳
+帧末resolve到readback buffer，等这个FrameResource的fence完成后(通常晚gNumFrameResources帧)再读取，不会等待GPU
+结果换算到CPU时间域，合并进Profiler对应帧的统计和Chrome trace
+*/
+class GpuProfiler
+{
+public:
+	static constexpr uint32_t MaxZonesPerFrame = 64;
+	static constexpr uint32_t QueriesPerFrame = MaxZonesPerFrame * 2;
+
+	static GpuProfiler* GetInstance()
+	{
+		static GpuProfiler* instance = new GpuProfiler();
+		return instance;
+	}
+
+	// queue用于查询时间戳频率和CPU/GPU时钟的对应关系
+	void Initialize(ID3D12CommandQueue* queue, uint32_t frameSlotCount);
+
+	// 帧开始时调用(这个FrameResource的fence已经等待过)：先收集已完成的帧，再开始记录本帧
+	void BeginFrame(uint32_t frameSlot, ID3D12QueryHeap* queryHeap, ID3D12Resource* readback, uint64_t completedFence);
+	// 可以在多个录制线程中调用，返回GpuTimestampRing::InvalidZone时不记录
+	uint32_t BeginZone(ID3D12GraphicsCommandList* cmdList, const std::string& name);
+	void EndZone(ID3D12GraphicsCommandList* cmdList, uint32_t zone);
+	// 所有zone结束后，在本帧最后执行的command list上调用
+	void ResolveFrame(ID3D12GraphicsCommandList* cmdList);
+	// fenceValue是GPU执行完本帧后signal的值
+	void EndFrame(uint64_t fenceValue);
+
+	bool IsRecording() const { return mRecording; }
+
+private:
+	class ReadbackSource : public TimestampSource
+	{
+	public:
+		virtual void ReadTimestamps(uint32_t frameSlot, uint32_t count, uint64_t* timestamps) override;
+
+		std::vector<ID3D12Resource*> Readbacks;
+	};
+
+	GpuProfiler() {}
+	void Calibrate();
+
+	ID3D12CommandQueue* mQueue = nullptr;
+	GpuTimestampRing mRing;
+	ReadbackSource mSource;
+	GpuClockCalibration mClock;
+
+	bool mRecording = false;
+	ID3D12QueryHeap* mQueryHeap = nullptr;
+	ID3D12Resource* mReadback = nullptr;
+	uint32_t mFramesSinceCalibration = 0;
+};
+
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(ID3D12GraphicsCommandList* cmdList, const std::string& name) : mCmdList(cmdList)
+	{
+		mZone = GpuProfiler::GetInstance()->BeginZone(cmdList, name);
+	}
+
+	~GpuProfileScope()
+	{
+		GpuProfiler::GetInstance()->EndZone(mCmdList, mZone);
+	}
+
+	GpuProfileScope(const GpuProfileScope& other) = delete;
+	GpuProfileScope& operator= (const GpuProfileScope& other) = delete;
+
+private:
+	ID3D12GraphicsCommandList* mCmdList;
+	uint32_t mZone;
+};
+
+}
@@ -1,5 +1,8 @@
 #include "Material.h"
 #include "../Common/d3dApp.h"
+#include "TextureResidency.h"
+#include "BindlessTextureTable.h"
+#include "Util/Profiler.h"
 
 namespace Soco{
 Material::Material(Shader* shader, MaterialState* drawState, D3D12_GRAPHICS_PIPELINE_STATE_DESC* psoDesc, const std::string& matCBName)
@@ -98,16 +101,27 @@ void Material::SetTexture(const std::string& name, Texture* texture)
 	if (mTexture.find(name) != mTexture.end())
 	{
 		mTexture[name] = texture;
+		return;
+	}
+
+	const Shader::ConstantBufferVariable* indexVariable = mShader->GetConstantBufferVariable(mConstantBufferName, name + "Index");
+	if (mShader->HasBindlessTable() && indexVariable != nullptr && indexVariable->Size == sizeof(UINT))
+	{
+		//下标不会变化，常驻管理换资源时只改表里的SRV
+		UINT index = texture != nullptr ? texture->BindlessIndex() : BindlessTextureTable::NullIndex;
+		SetMaterialData((BYTE*)&index, indexVariable->Offset, sizeof(UINT));
+		mBindlessTexture[name] = texture;
 	}
 	else
 	{
-		std::cout << "ǰMaterialShaderûΪ" << name << "Texture" << std::endl;
-		//throw std::exception("ǰMaterialShaderûд˲");
+		std::cout << "当前Material的Shader没有名为" << name << "的Texture" << std::endl;
+		//throw std::exception("当前Material的Shader没有此材质");
 	}
 }
 
 void Material::Setup(ID3D12GraphicsCommandList* cmdList, int currentFrame)
 {
+	SOCO_PROFILE_SCOPE("Material::Setup");
 	UINT matCBByteSize = d3dUtil::CalcConstantBufferByteSize(mPerMaterialCBSize);
 
 	if (mResource != nullptr)
@@ -116,13 +130,36 @@ void Material::Setup(ID3D12GraphicsCommandList* cmdList, int currentFrame)
 		mShader->SetConstantBufferView(cmdList, mConstantBufferName, matCBAddress);
 	}
 
+	//记录纹理最后使用的帧，常驻管理据此决定降级哪些纹理
+	TextureResidencyManager* residency = TextureResidencyManager::GetInstance();
 	for (auto ite = mTexture.begin(); ite != mTexture.end(); ++ite)
 	{
 		if (ite->second != nullptr)
 		{
+			residency->MarkUsed(ite->second);
 			mShader->SetTexture(cmdList, ite->first, ite->second->SRV());
 		}
 	}
+	for (auto ite = mBindlessTexture.begin(); ite != mBindlessTexture.end(); ++ite)
+	{
+		if (ite->second != nullptr)
+			residency->MarkUsed(ite->second);
+	}
+}
+
+void Material::RequestTextureDensity(float pixelsPerUv)
+{
+	TextureResidencyManager* residency = TextureResidencyManager::GetInstance();
+	for (auto ite = mTexture.begin(); ite != mTexture.end(); ++ite)
+	{
+		if (ite->second != nullptr)
+			residency->RequestScreenDensity(ite->second, pixelsPerUv);
+	}
+	for (auto ite = mBindlessTexture.begin(); ite != mBindlessTexture.end(); ++ite)
+	{
+		if (ite->second != nullptr)
+			residency->RequestScreenDensity(ite->second, pixelsPerUv);
+	}
 }
 
 void Material::SetRasterizerState(D3D12_RASTERIZER_DESC& rasterizeState)
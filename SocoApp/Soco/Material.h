@@ -4,6 +4,7 @@
 #include "Texture.h"
 #include "../Common/UploadBuffer.h"
 #include "Util/PipelineStateManager.h"
+#include "Util/Stats.h"
 #include <memory>
 
 extern const int gNumFrameResources;
@@ -36,6 +37,7 @@ public:
 		mNumFrameDirty(rhs.mNumFrameDirty),
 		mResource(std::move(rhs.mResource)),
 		mTexture(std::move(rhs.mTexture)),
+		mBindlessTexture(std::move(rhs.mBindlessTexture)),
 		mPSODesc(rhs.mPSODesc)
 	{ 
 		rhs.mShader = nullptr;
@@ -81,8 +83,11 @@ public:
 	}
 
 	void Update(int currentFrame);
+	//shader用无绑定纹理表时，纹理的下标写在材质常量缓冲里名为name + "Index"的uint成员中
 	void SetTexture(const std::string& name, Texture* texture);
 	void Setup(ID3D12GraphicsCommandList* cmdList, int currentFrame);
+	//用这个材质的一个物体在屏幕上每个UV单位覆盖pixelsPerUv个像素，转给常驻管理决定材质纹理需要的mip；可以在多个线程里调用
+	void RequestTextureDensity(float pixelsPerUv);
 
 
 	static bool PipelineStateEqual(const Material& lhs, const Material& rhs);
@@ -94,7 +99,7 @@ public:
 		mShader->SetConstantBufferView(cmdList, variableName, BufferLocation);
 	}
 
-	void SetPipelineState(ID3D12GraphicsCommandList* cmdList) { cmdList->SetPipelineState(mPSO.Get()); }
+	void SetPipelineState(ID3D12GraphicsCommandList* cmdList) { SOCO_STAT_ADD("PipelineStateSets", 1); cmdList->SetPipelineState(mPSO.Get()); }
 
 	const D3D12_SHADER_BUFFER_DESC* GetConstantBufferDesc(const std::string& name) { return mShader->GetConstantBufferDesc(name); }
 
@@ -124,6 +129,8 @@ private:
 	int mNumFrameDirty = gNumFrameResources;
 	std::unique_ptr<UploadBuffer> mResource = nullptr;
 	std::map<std::string, Texture*> mTexture;
+	//通过无绑定纹理表访问的纹理，下标已经写进mPerMaterialCB，绘制时不需要绑定
+	std::map<std::string, Texture*> mBindlessTexture;
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC mPSODesc;
 };
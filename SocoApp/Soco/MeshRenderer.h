@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Renderer.h"
+#include "Util/Meshlet.h"
 
 extern const int gNumFrameResources;
 
@@ -25,7 +26,7 @@ public:
 		}
 		else
 		{
-			std::cout << "[Warnning] ޷\"" << objCBName << "\"ҵobject" << std::endl;
+			std::cout << "[Warnning] 无法根据\"" << objCBName << "\"找到object常量缓冲区" << std::endl;
 		}
 		
 		mMaterial = material;
@@ -34,6 +35,21 @@ public:
 		//StartIndexLocation = submesh.StartIndexLocation;
 		//BaseVertexLocation = submesh.BaseVertexLocation;
 		mSubmeshGeometry = submesh;
+		mFrameLods.assign(gNumFrameResources, 0);
+
+		//带meshlet的子网格每帧绘制剔除后的索引，每个FrameResource一段，初始内容是全部三角形
+		if (const MeshletSet* meshlets = mSubmeshGeometry.Meshlets.get())
+		{
+			mCulledIndexBufferSize = meshlets->TriangleCount * 3 * sizeof(uint32_t);
+			mCulledIndices = std::make_unique<UploadBuffer>(gNumFrameResources, mCulledIndexBufferSize, false);
+			mCulledIndexCounts.assign(gNumFrameResources, 0);
+
+			MeshletCullParams drawAll;
+			drawAll.FrustumCulling = false;
+			drawAll.ConeCulling = false;
+			for (int i = 0; i < gNumFrameResources; ++i)
+				mCulledIndexCounts[i] = Soco::CullMeshlets(*meshlets, drawAll, reinterpret_cast<uint32_t*>(mCulledIndices->GetMappedData(i)));
+		}
 	}
 
 	MeshRenderer(MeshRenderer& other) = delete;
@@ -48,7 +64,11 @@ public:
 		//IndexCount(rhs.IndexCount),
 		//StartIndexLocation(rhs.StartIndexLocation),
 		//BaseVertexLocation(rhs.BaseVertexLocation)
-		mSubmeshGeometry(rhs.mSubmeshGeometry)
+		mSubmeshGeometry(rhs.mSubmeshGeometry),
+		mCulledIndices(std::move(rhs.mCulledIndices)),
+		mCulledIndexBufferSize(rhs.mCulledIndexBufferSize),
+		mCulledIndexCounts(std::move(rhs.mCulledIndexCounts)),
+		mFrameLods(std::move(rhs.mFrameLods))
 	{
 		rhs.mMaterial = nullptr;
 		rhs.mGeo = nullptr;
@@ -75,10 +95,10 @@ public:
 		return *((T*)mPerObjectConstantBufferData.get());
 	}
 
-	//ַܼٿҪע⣺
-	//ǳʼĽṹ帳ֵSetObjectDataṹгʼֵ
-	//GetObjectDataȡַʼʼֵΪ0
-	//ԽʼSetObjectDataGetObjectData<&/*>
+	//下面两种方法能减少拷贝次数，但要注意：
+	//如果是初始化，上面的结构体赋值方法SetObjectData，结构体往往具有初始值
+	//而如果用下面的GetObjectData获取地址初始化，初始值大多为0
+	//所以建议初始化用SetObjectData，更新数据用GetObjectData<&/*>
 
 	//reference
 	template<typename T>
@@ -97,6 +117,41 @@ public:
 	}
 
 
+	//每帧都变化的object常量可以直接写进当前帧的upload buffer，不经过CPU副本再拷贝一次
+	//调用后CPU副本不再上传，调用者需要每帧都写；没有object常量时返回nullptr
+	BYTE* GetFrameObjectData(int currentFrame)
+	{
+		mNumFramesDirty = 0;
+		return mResource != nullptr ? mResource->GetMappedData(currentFrame) : nullptr;
+	}
+
+	bool HasMeshlets() const { return mCulledIndices != nullptr; }
+
+	const SubmeshGeometry& GetSubmesh() const { return mSubmeshGeometry; }
+	//包括完整网格在内的LOD级数
+	UINT GetLodCount() const { return (UINT)mSubmeshGeometry.Lods.size() + 1; }
+	UINT GetLodIndexCount(UINT lod) const { return lod == 0 ? mSubmeshGeometry.IndexCount : mSubmeshGeometry.Lods[lod - 1].IndexCount; }
+
+	//本帧画哪一级LOD，0是完整网格
+	void SetLod(int currentFrame, UINT lod) { mFrameLods[currentFrame] = std::min<UINT>(lod, GetLodCount() - 1); }
+	UINT GetLod(int currentFrame) const { return mFrameLods[currentFrame]; }
+
+	//把可见meshlet的三角形写进本帧的索引段，params在物体空间；本帧用简化LOD时不需要剔除
+	void CullMeshlets(int currentFrame, const MeshletCullParams& params)
+	{
+		if (mCulledIndices == nullptr || mFrameLods[currentFrame] != 0)
+			return;
+
+		const MeshletSet& meshlets = *mSubmeshGeometry.Meshlets;
+		uint32_t visible = 0;
+		uint32_t indexCount = Soco::CullMeshlets(meshlets, params, reinterpret_cast<uint32_t*>(mCulledIndices->GetMappedData(currentFrame)), &visible);
+		mCulledIndexCounts[currentFrame] = indexCount;
+
+		SOCO_STAT_ADD("UploadBufferBytes", indexCount * sizeof(uint32_t));
+		SOCO_STAT_ADD("MeshletsCulled", meshlets.Meshlets.size() - visible);
+		SOCO_STAT_ADD("TrianglesCulled", meshlets.TriangleCount - indexCount / 3);
+	}
+
 	//Update To GPU CBuffer
 	void Update(int currentFrame) override
 	{
@@ -107,11 +162,29 @@ public:
 		}
 	}
 
+	//共享几何缓冲里的网格视图都相同，连续画它们时state会跳过重复的绑定
+	void SetInputAssembler(ID3D12GraphicsCommandList* cmdList, int currentFrame, InputAssemblerState& state) override
+	{
+		state.SetVertexBuffer(cmdList, mGeo->VertexBufferView());
+		mDrawLod = mFrameLods[currentFrame];
+		if (mCulledIndices != nullptr && mDrawLod == 0)
+		{
+			D3D12_INDEX_BUFFER_VIEW ibv;
+			ibv.BufferLocation = mCulledIndices->Resource()->GetGPUVirtualAddress() + (UINT64)currentFrame * mCulledIndexBufferSize;
+			ibv.Format = DXGI_FORMAT_R32_UINT;
+			ibv.SizeInBytes = mCulledIndexBufferSize;
+			state.SetIndexBuffer(cmdList, ibv);
+			mDrawIndexCount = mCulledIndexCounts[currentFrame];
+		}
+		else
+		{
+			state.SetIndexBuffer(cmdList, mGeo->IndexBufferView());
+		}
+	}
+
 	//Setup RootSignature
 	void Setup(ID3D12GraphicsCommandList* cmdList, int currentFrame) override
 	{
-		cmdList->IASetVertexBuffers(0, 1, &mGeo->VertexBufferView());
-		cmdList->IASetIndexBuffer(&mGeo->IndexBufferView());
 		//cmdList->IASetPrimitiveTopology(mPrimitiveType);
 		mMaterial->SetIASetPrimitiveTopology(cmdList);
 
@@ -128,8 +201,30 @@ public:
 
 	void DrawIndexedInstanced(ID3D12GraphicsCommandList* cmdList) override
 	{
+		//网格在共享几何缓冲里的位置；剔除后的索引在自己的缓冲里，只加顶点偏移
+		const INT baseVertex = mSubmeshGeometry.BaseVertexLocation + mGeo->ArenaBaseVertex;
+		if (mDrawLod > 0)
+		{
+			const SubmeshLod& lod = mSubmeshGeometry.Lods[mDrawLod - 1];
+			SOCO_STAT_ADD("DrawCalls", 1);
+			SOCO_STAT_ADD("TrianglesLodReduced", (mSubmeshGeometry.IndexCount - lod.IndexCount) / 3);
+			cmdList->DrawIndexedInstanced(lod.IndexCount, 1, lod.StartIndexLocation + mGeo->ArenaStartIndex, baseVertex, 0);
+			return;
+		}
+
+		if (mCulledIndices != nullptr)
+		{
+			//全部被剔除时不提交draw
+			if (mDrawIndexCount == 0)
+				return;
+			SOCO_STAT_ADD("DrawCalls", 1);
+			cmdList->DrawIndexedInstanced(mDrawIndexCount, 1, 0, baseVertex, 0);
+			return;
+		}
+
+		SOCO_STAT_ADD("DrawCalls", 1);
 		cmdList->DrawIndexedInstanced(mSubmeshGeometry.IndexCount, 1, 
-			mSubmeshGeometry.StartIndexLocation, mSubmeshGeometry.BaseVertexLocation, 0);
+			mSubmeshGeometry.StartIndexLocation + mGeo->ArenaStartIndex, baseVertex, 0);
 	}
 
 
@@ -152,5 +247,16 @@ private:
 	SubmeshGeometry mSubmeshGeometry;
 
 	std::unique_ptr<UploadBuffer> mResource = nullptr;
+
+	//meshlet剔除后的索引，每个FrameResource一段
+	std::unique_ptr<UploadBuffer> mCulledIndices = nullptr;
+	UINT mCulledIndexBufferSize = 0;
+	std::vector<UINT> mCulledIndexCounts;
+	//SetInputAssembler时取本帧的索引数，DrawIndexedInstanced用
+	UINT mDrawIndexCount = 0;
+
+	//每个FrameResource选中的LOD，SetInputAssembler时取出来给DrawIndexedInstanced用
+	std::vector<UINT> mFrameLods;
+	UINT mDrawLod = 0;
 };
 }
@@ -0,0 +1,271 @@
+#include "MipGenerator.h"
+#include "../Common/d3dApp.h"
+#include "../Common/DescriptorHeapAllocator.h"
+#include "../Common/DDSTextureLoader.h"
+#include "Util/PngDecoder.h"
+#include "Util/Profiler.h"
+
+#include <iostream>
+#include <vector>
+
+namespace Soco
+{
+
+void MipGenerator::CreateTexture(ID3D12GraphicsCommandList* cmdList, const uint8_t* pixels, UINT width, UINT height, const MipChainOptions& options,
+	D3D12_RESOURCE_STATES finalState, Microsoft::WRL::ComPtr<ID3D12Resource>& resource, Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer)
+{
+	SOCO_PROFILE_SCOPE("MipGenerator::CreateTexture");
+	const bool gpu = UseGpu(options);
+	const UINT mipCount = GetMipCount(width, height);
+
+	D3D12_RESOURCE_DESC descTex = {};
+	descTex.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	descTex.Width = width;
+	descTex.Height = height;
+	descTex.DepthOrArraySize = 1;
+	descTex.MipLevels = mipCount;
+	//UAV不能是sRGB格式，GPU生成时资源用TYPELESS，读上一级用_SRGB的SRV，写这一级用UNORM的UAV
+	descTex.Format = gpu && options.Srgb ? DXGI_FORMAT_R8G8B8A8_TYPELESS : GetSrvFormat(options.Srgb);
+	descTex.SampleDesc.Count = 1;
+	descTex.SampleDesc.Quality = 0;
+	descTex.Flags = gpu ? D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE;
+
+	ThrowIfFailed(D3DApp::GetDevice()->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&descTex,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(resource.ReleaseAndGetAddressOf())
+	));
+
+	//GPU生成只上传第0级，否则在CPU上生成整条链一起上传
+	std::vector<MipImage> chain;
+	if (!gpu)
+		chain = GenerateMipChain(pixels, width, height, options);
+
+	std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+	subresources.push_back({ pixels, (LONG_PTR)width * 4, (LONG_PTR)width * height * 4 });
+	for (const MipImage& image : chain)
+		subresources.push_back({ image.Pixels.data(), (LONG_PTR)image.Width * 4, (LONG_PTR)image.Pixels.size() });
+
+	const UINT64 uploadSize = GetRequiredIntermediateSize(resource.Get(), 0, (UINT)subresources.size());
+	ThrowIfFailed(D3DApp::GetDevice()->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(uploadSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(uploadBuffer.ReleaseAndGetAddressOf())
+	));
+	UpdateSubresources(cmdList, resource.Get(), uploadBuffer.Get(), 0, 0, (UINT)subresources.size(), subresources.data());
+	SOCO_STAT_ADD("UploadBufferBytes", uploadSize);
+
+	if (gpu)
+	{
+		GenerateOnGpu(cmdList, resource.Get(), options, finalState);
+	}
+	else
+	{
+		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, finalState));
+	}
+}
+
+bool MipGenerator::CreateCompressedTexture(ID3D12GraphicsCommandList* cmdList, const uint8_t* pixels, UINT width, UINT height, const MipChainOptions& options,
+	BCFormat compression, D3D12_RESOURCE_STATES finalState, Microsoft::WRL::ComPtr<ID3D12Resource>& resource, Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer)
+{
+	SOCO_PROFILE_SCOPE("MipGenerator::CreateCompressedTexture");
+	if (width % 4 != 0 || height % 4 != 0)
+	{
+		std::cout << "纹理大小" << width << "x" << height << "不是4的倍数，不能用" << GetBCFormatName(compression) << "压缩，改为不压缩" << std::endl;
+		CreateTexture(cmdList, pixels, width, height, options, finalState, resource, uploadBuffer);
+		return false;
+	}
+
+	std::vector<std::vector<uint8_t>> blocks;
+	std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+	CompressMipChain(pixels, width, height, options, compression, blocks, subresources);
+
+	D3D12_RESOURCE_DESC descTex = {};
+	descTex.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	descTex.Width = width;
+	descTex.Height = height;
+	descTex.DepthOrArraySize = 1;
+	descTex.MipLevels = (UINT16)subresources.size();
+	descTex.Format = GetBCFormat(compression, options.Srgb);
+	descTex.SampleDesc.Count = 1;
+	descTex.SampleDesc.Quality = 0;
+	descTex.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	ThrowIfFailed(D3DApp::GetDevice()->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&descTex,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(resource.ReleaseAndGetAddressOf())
+	));
+
+	const UINT64 uploadSize = GetRequiredIntermediateSize(resource.Get(), 0, (UINT)subresources.size());
+	ThrowIfFailed(D3DApp::GetDevice()->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(uploadSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(uploadBuffer.ReleaseAndGetAddressOf())
+	));
+	UpdateSubresources(cmdList, resource.Get(), uploadBuffer.Get(), 0, 0, (UINT)subresources.size(), subresources.data());
+	SOCO_STAT_ADD("UploadBufferBytes", uploadSize);
+
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, finalState));
+	return true;
+}
+
+bool MipGenerator::CompressTextureToDDS(const char* pngFilename, const std::wstring& ddsFilename, BCFormat compression, const MipChainOptions& options)
+{
+	SOCO_PROFILE_SCOPE("MipGenerator::CompressTextureToDDS");
+	PngImage image;
+	if (!DecodePngFile(pngFilename, PngDecodeOptions(), image))
+	{
+		std::cout << "图片" << pngFilename << "加载错误" << std::endl;
+		return false;
+	}
+	const unsigned width = image.Width, height = image.Height;
+
+	if (width % 4 != 0 || height % 4 != 0)
+	{
+		std::cout << "图片" << pngFilename << "的大小" << width << "x" << height << "不是4的倍数，不能块压缩" << std::endl;
+		return false;
+	}
+
+	std::vector<std::vector<uint8_t>> blocks;
+	std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+	CompressMipChain(image.Pixels.data(), width, height, options, compression, blocks, subresources);
+
+	const HRESULT hr = DirectX::SaveDDSTextureToFile12(ddsFilename.c_str(), GetBCFormat(compression, options.Srgb), width, height,
+		subresources.data(), (uint32_t)subresources.size());
+	if (FAILED(hr))
+	{
+		std::wcout << L"写入" << ddsFilename << L"失败" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+DXGI_FORMAT MipGenerator::GetBCFormat(BCFormat compression, bool srgb)
+{
+	switch (compression)
+	{
+	case BCFormat::BC1: return srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+	case BCFormat::BC4: return DXGI_FORMAT_BC4_UNORM;
+	case BCFormat::BC5: return DXGI_FORMAT_BC5_UNORM;
+	case BCFormat::BC7: return srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+	}
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+void MipGenerator::CompressMipChain(const uint8_t* pixels, UINT width, UINT height, const MipChainOptions& options, BCFormat compression,
+	std::vector<std::vector<uint8_t>>& blocks, std::vector<D3D12_SUBRESOURCE_DATA>& subresources)
+{
+	//压缩前的mip链按RGBA8生成，压缩只是最后一步，所以和不压缩时的滤波结果一致
+	const std::vector<MipImage> chain = GenerateMipChain(pixels, width, height, options);
+
+	blocks.clear();
+	blocks.push_back(EncodeBC(pixels, width, height, compression));
+	for (const MipImage& image : chain)
+		blocks.push_back(EncodeBC(image.Pixels.data(), image.Width, image.Height, compression));
+
+	subresources.clear();
+	for (size_t mip = 0; mip < blocks.size(); ++mip)
+	{
+		const UINT mipWidth = std::max<UINT>(width >> mip, 1);
+		subresources.push_back({ blocks[mip].data(), (LONG_PTR)GetBCRowPitch(compression, mipWidth), (LONG_PTR)blocks[mip].size() });
+	}
+}
+
+void MipGenerator::GenerateOnGpu(ID3D12GraphicsCommandList* cmdList, ID3D12Resource* resource, const MipChainOptions& options, D3D12_RESOURCE_STATES finalState)
+{
+	const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+	const UINT mipCount = desc.MipLevels;
+
+	//第0级转成可读，其他级转成UAV，合并成一次提交
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+	barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, 0));
+	for (UINT mip = 1; mip < mipCount; ++mip)
+		barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, mip));
+	cmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+
+	if (mipCount > 1)
+	{
+		//每一级一个源SRV、一个目标UAV；描述符要保留到命令执行完，加载时生成，直接从全局堆里分配
+		std::vector<DescriptorHeapAllocation> allocations((mipCount - 1) * 2);
+		D3DApp::GetCbvSrvUavAllocate(allocations.data(), (UINT)allocations.size());
+
+		Shader* shader = GetShader(options);
+		ID3D12DescriptorHeap* descriptorHeaps[] = { D3DApp::GetCbvSrvUavHeap() };
+		cmdList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+		shader->SetComputePipelineState(cmdList);
+		shader->SetComputeRootSignature(cmdList);
+
+		for (UINT mip = 1; mip < mipCount; ++mip)
+		{
+			const DescriptorHeapAllocation& srv = allocations[(mip - 1) * 2];
+			const DescriptorHeapAllocation& uav = allocations[(mip - 1) * 2 + 1];
+
+			D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+			srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+			srvDesc.Format = GetSrvFormat(options.Srgb);
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MostDetailedMip = mip - 1;
+			srvDesc.Texture2D.MipLevels = 1;
+			D3DApp::GetDevice()->CreateShaderResourceView(resource, &srvDesc, srv.cpuHandle);
+
+			D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+			uavDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+			uavDesc.Texture2D.MipSlice = mip;
+			D3DApp::GetDevice()->CreateUnorderedAccessView(resource, nullptr, &uavDesc, uav.cpuHandle);
+
+			shader->SetTexture(cmdList, "gSrcMip", srv.gpuHandle);
+			shader->SetTexture(cmdList, "gDstMip", uav.gpuHandle);
+			shader->Dispatch(cmdList, std::max<UINT>((UINT)desc.Width >> mip, 1), std::max<UINT>(desc.Height >> mip, 1));
+
+			//写完的一级马上作为下一级的输入
+			cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource,
+				D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, mip));
+		}
+	}
+
+	if (finalState != D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+	{
+		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource,
+			D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, finalState));
+	}
+}
+
+Shader* MipGenerator::GetShader(const MipChainOptions& options)
+{
+	auto key = std::make_pair(options.Filter, options.Srgb);
+	auto ite = mShaders.find(key);
+	if (ite != mShaders.end())
+		return ite->second.get();
+
+	std::vector<D3D_SHADER_MACRO> defines;
+	if (options.Filter == MipFilter::Min)
+		defines.push_back({ "MIP_MIN", "1" });
+	else if (options.Filter == MipFilter::Max)
+		defines.push_back({ "MIP_MAX", "1" });
+	if (options.Srgb)
+		defines.push_back({ "SRGB", "1" });
+	defines.push_back({ NULL, NULL });
+
+	ShaderStage computeStage;
+	computeStage.cs = "GenerateMipCS";
+	auto shader = std::make_unique<Shader>(L"Shaders\\GenerateMips.hlsl", defines.data(), computeStage);
+	Shader* result = shader.get();
+	mShaders[key] = std::move(shader);
+	return result;
+}
+
+}
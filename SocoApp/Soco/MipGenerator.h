@@ -0,0 +1,69 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../Common/d3dUtil.h"
+#include "../Common/BCEncoder.h"
+#include "Shader.h"
+#include "Util/MipChain.h"
+
+namespace Soco
+{
+
+/*
+给从像素数据创建的纹理生成完整的mip链
+Box/Min/Max在GPU上用compute shader逐级生成，只上传第0级；Kaiser或者关闭了GPU生成时用CPU(SSE2)生成所有级后一起上传
+块压缩的纹理总是在CPU上生成mip链，每级用BCEncoder压缩后上传
+*/
+class MipGenerator
+{
+public:
+	static MipGenerator* GetInstance()
+	{
+		static MipGenerator* instance = new MipGenerator();
+		return instance;
+	}
+
+	// false时所有滤波都在CPU上生成，用于对比或者没有typed UAV的环境
+	void SetUseGpu(bool useGpu) { mUseGpu = useGpu; }
+
+	/*
+	从RGBA8像素创建带完整mip链的纹理，上传和生成的命令录制到cmdList，执行完之后所有mip处于finalState
+	uploadBuffer要保留到命令执行完；sRGB纹理在GPU上生成时资源格式是TYPELESS，SRV用GetSrvFormat的格式
+	*/
+	void CreateTexture(ID3D12GraphicsCommandList* cmdList, const uint8_t* pixels, UINT width, UINT height, const MipChainOptions& options,
+		D3D12_RESOURCE_STATES finalState, Microsoft::WRL::ComPtr<ID3D12Resource>& resource, Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer);
+
+	/*
+	同上，但每级压缩成compression格式，资源和SRV都用GetBCFormat的格式
+	块压缩要求第0级宽高是4的倍数，不满足时打印提示并退回未压缩的CreateTexture，返回false
+	*/
+	bool CreateCompressedTexture(ID3D12GraphicsCommandList* cmdList, const uint8_t* pixels, UINT width, UINT height, const MipChainOptions& options,
+		BCFormat compression, D3D12_RESOURCE_STATES finalState, Microsoft::WRL::ComPtr<ID3D12Resource>& resource, Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer);
+
+	// 离线压缩：读PNG，生成mip链，每级压缩后写成DDS，之后可以直接用DDS加载(包括按mip流式加载)
+	static bool CompressTextureToDDS(const char* pngFilename, const std::wstring& ddsFilename, BCFormat compression, const MipChainOptions& options);
+
+	static DXGI_FORMAT GetSrvFormat(bool srgb) { return srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM; }
+	// BC4/BC5没有sRGB格式，srgb只影响BC1/BC7
+	static DXGI_FORMAT GetBCFormat(BCFormat compression, bool srgb);
+
+private:
+	MipGenerator() {}
+
+	bool UseGpu(const MipChainOptions& options) const { return mUseGpu && options.Filter != MipFilter::Kaiser; }
+	// 资源已经在COPY_DEST，第0级已经写入
+	void GenerateOnGpu(ID3D12GraphicsCommandList* cmdList, ID3D12Resource* resource, const MipChainOptions& options, D3D12_RESOURCE_STATES finalState);
+	Shader* GetShader(const MipChainOptions& options);
+	// 第0级和CPU生成的mip链逐级压缩，subresources指向blocks里的数据
+	static void CompressMipChain(const uint8_t* pixels, UINT width, UINT height, const MipChainOptions& options, BCFormat compression,
+		std::vector<std::vector<uint8_t>>& blocks, std::vector<D3D12_SUBRESOURCE_DATA>& subresources);
+
+	bool mUseGpu = true;
+	// 按滤波和是否sRGB区分的变体，第一次用到时编译
+	std::map<std::pair<MipFilter, bool>, std::unique_ptr<Shader>> mShaders;
+};
+
+}
@@ -11,6 +11,52 @@
 
 namespace Soco
 {
+//一个command list上当前绑定的顶点/索引缓冲视图，与上一次相同时不再调用IASet*
+//command list之间不继承状态，每个command list开始录制时Reset
+class InputAssemblerState
+{
+public:
+	void Reset()
+	{
+		mVertexBufferValid = false;
+		mIndexBufferValid = false;
+	}
+
+	void SetVertexBuffer(ID3D12GraphicsCommandList* cmdList, const D3D12_VERTEX_BUFFER_VIEW& view)
+	{
+		if (mVertexBufferValid && mVertexBuffer.BufferLocation == view.BufferLocation &&
+			mVertexBuffer.StrideInBytes == view.StrideInBytes && mVertexBuffer.SizeInBytes == view.SizeInBytes)
+		{
+			SOCO_STAT_ADD("IABindsSkipped", 1);
+			return;
+		}
+		SOCO_STAT_ADD("IABinds", 1);
+		cmdList->IASetVertexBuffers(0, 1, &view);
+		mVertexBuffer = view;
+		mVertexBufferValid = true;
+	}
+
+	void SetIndexBuffer(ID3D12GraphicsCommandList* cmdList, const D3D12_INDEX_BUFFER_VIEW& view)
+	{
+		if (mIndexBufferValid && mIndexBuffer.BufferLocation == view.BufferLocation &&
+			mIndexBuffer.Format == view.Format && mIndexBuffer.SizeInBytes == view.SizeInBytes)
+		{
+			SOCO_STAT_ADD("IABindsSkipped", 1);
+			return;
+		}
+		SOCO_STAT_ADD("IABinds", 1);
+		cmdList->IASetIndexBuffer(&view);
+		mIndexBuffer = view;
+		mIndexBufferValid = true;
+	}
+
+private:
+	D3D12_VERTEX_BUFFER_VIEW mVertexBuffer = {};
+	D3D12_INDEX_BUFFER_VIEW mIndexBuffer = {};
+	bool mVertexBufferValid = false;
+	bool mIndexBufferValid = false;
+};
+
 class Renderer
 {
 protected:
@@ -27,7 +73,11 @@ protected:
 	Material* mMaterial = nullptr;
 
 public:
+	Material* GetMaterial() const { return mMaterial; }
+
 	virtual void Update(int currentFrame){};
+	//在Setup之前调用，绑定顶点/索引缓冲；不用顶点缓冲的renderer不需要实现
+	virtual void SetInputAssembler(ID3D12GraphicsCommandList* cmdList, int currentFrame, InputAssemblerState& state) {}
 	virtual void Setup(ID3D12GraphicsCommandList* cmdList, int currnetFrame) = 0;
 	virtual void DrawIndexedInstanced(ID3D12GraphicsCommandList* cmdList) = 0;
 
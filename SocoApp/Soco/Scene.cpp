@@ -0,0 +1,282 @@
+#include "Scene.h"
+#include "MeshRenderer.h"
+#include "Util/Profiler.h"
+#include "Util/MipStreaming.h"
+#include "Util/Stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+namespace Soco
+{
+
+namespace
+{
+
+static_assert(sizeof(OrbitComponent) == 2 * sizeof(XMFLOAT4A), "OrbitComponent要正好是两个float4");
+
+// 计算4个连续实体的轨道，count小于4时只写前count个(读的是补齐后的副本)
+void AnimateOrbitPacket(OrbitComponent* orbits, Transform* transforms, WorldMatrixComponent* worlds, size_t count, FXMVECTOR dt)
+{
+	OrbitComponent padded[4];
+	OrbitComponent* source = orbits;
+	if (count < 4)
+	{
+		std::copy(orbits, orbits + count, padded);
+		source = padded;
+	}
+
+	//AoS转SoA：前半是Radius Height Speed Theta，后半是SpinSpeed SpinAngle
+	const XMFLOAT4A* raw = reinterpret_cast<const XMFLOAT4A*>(source);
+	XMMATRIX front = XMMatrixTranspose(XMMATRIX(XMLoadFloat4A(raw), XMLoadFloat4A(raw + 2), XMLoadFloat4A(raw + 4), XMLoadFloat4A(raw + 6)));
+	XMMATRIX back = XMMatrixTranspose(XMMATRIX(XMLoadFloat4A(raw + 1), XMLoadFloat4A(raw + 3), XMLoadFloat4A(raw + 5), XMLoadFloat4A(raw + 7)));
+
+	//角度保持在[-π, π)，长时间运行也不丢精度
+	XMVECTOR theta = XMVectorModAngles(XMVectorMultiplyAdd(dt, front.r[2], front.r[3]));
+	XMVECTOR spin = XMVectorModAngles(XMVectorMultiplyAdd(dt, back.r[0], back.r[1]));
+
+	XMVECTOR sinTheta, cosTheta, sinHalfSpin, cosHalfSpin;
+	XMVectorSinCos(&sinTheta, &cosTheta, theta);
+	XMVectorSinCos(&sinHalfSpin, &cosHalfSpin, XMVectorScale(spin, 0.5f));
+
+	//四元数用半角，矩阵用倍角公式，只需要一次SinCos
+	XMVECTOR sinSpin = XMVectorScale(XMVectorMultiply(sinHalfSpin, cosHalfSpin), 2.0f);
+	XMVECTOR cosSpin = XMVectorNegativeMultiplySubtract(sinHalfSpin, sinHalfSpin, XMVectorMultiply(cosHalfSpin, cosHalfSpin));
+
+	XMFLOAT4A x, z, h, s, c, qs, qc;
+	XMStoreFloat4A(&x, XMVectorMultiply(front.r[0], cosTheta));
+	XMStoreFloat4A(&z, XMVectorMultiply(front.r[0], sinTheta));
+	XMStoreFloat4A(&h, front.r[1]);
+	XMStoreFloat4A(&s, sinSpin);
+	XMStoreFloat4A(&c, cosSpin);
+	XMStoreFloat4A(&qs, sinHalfSpin);
+	XMStoreFloat4A(&qc, cosHalfSpin);
+
+	front.r[3] = theta;
+	back.r[1] = spin;
+	front = XMMatrixTranspose(front);
+	back = XMMatrixTranspose(back);
+	for (size_t i = 0; i < count; ++i)
+	{
+		XMFLOAT4A* out = reinterpret_cast<XMFLOAT4A*>(orbits + i);
+		XMStoreFloat4A(out, front.r[i]);
+		XMStoreFloat4A(out + 1, back.r[i]);
+	}
+
+	//世界矩阵 = 缩放 * 绕Y轴自转 * 平移
+	const float* xs = &x.x; const float* zs = &z.x; const float* hs = &h.x;
+	const float* ss = &s.x; const float* cs = &c.x; const float* qss = &qs.x; const float* qcs = &qc.x;
+	for (size_t i = 0; i < count; ++i)
+	{
+		Transform& transform = transforms[i];
+		transform.SetLocalPosition({ xs[i], hs[i], zs[i] });
+		transform.SetLocalRotationQuat({ 0, qss[i], 0, qcs[i] });
+
+		XMFLOAT3 scale = transform.GetLocalScale();
+		worlds[i].World = XMFLOAT4X4(
+			scale.x * cs[i], 0, -scale.x * ss[i], 0,
+			0, scale.y, 0, 0,
+			scale.z * ss[i], 0, scale.z * cs[i], 0,
+			xs[i], hs[i], zs[i], 1);
+	}
+}
+
+}
+
+void UpdateOrbits(EntityWorld& world, float dt, size_t grainSize)
+{
+	SOCO_PROFILE_SCOPE("UpdateOrbits");
+
+	//分段按4对齐，只有每个archetype的最后一组可能不满4个
+	if (grainSize < SIZE_MAX - 3)
+		grainSize = (grainSize + 3) & ~size_t(3);
+
+	for (Archetype* archetype : world.Query<OrbitComponent, Transform, WorldMatrixComponent>())
+	{
+		OrbitComponent* orbits = archetype->GetColumn<OrbitComponent>();
+		Transform* transforms = archetype->GetColumn<Transform>();
+		WorldMatrixComponent* worlds = archetype->GetColumn<WorldMatrixComponent>();
+		JobSystem::GetInstance()->ParallelFor(0, archetype->Size(), grainSize, [=](size_t first, size_t last) {
+			const XMVECTOR dtV = XMVectorReplicate(dt);
+			for (size_t i = first; i < last; i += 4)
+				AnimateOrbitPacket(orbits + i, transforms + i, worlds + i, std::min<size_t>(4, last - i), dtV);
+		});
+	}
+}
+
+void UpdateCurveAnimations(EntityWorld& world, float dt, size_t grainSize)
+{
+	SOCO_PROFILE_SCOPE("UpdateCurveAnimations");
+	world.ParallelForEach<CurveAnimationComponent, Transform>(grainSize, [dt](CurveAnimationComponent& animation, Transform& transform) {
+		const std::vector<XMFLOAT3>& keys = animation.Curve->Keys;
+		const float duration = animation.Curve->KeyInterval * keys.size();
+		animation.Time = fmodf(animation.Time + dt * animation.Speed, duration);
+		if (animation.Time < 0)
+			animation.Time += duration;
+
+		const float key = animation.Time / animation.Curve->KeyInterval;
+		const size_t index = std::min<size_t>((size_t)key, keys.size() - 1);
+		const size_t next = index + 1 < keys.size() ? index + 1 : 0;
+		XMFLOAT3 position;
+		XMStoreFloat3(&position, XMVectorLerp(XMLoadFloat3(&keys[index]), XMLoadFloat3(&keys[next]), key - index));
+		transform.SetLocalPosition(position);
+	});
+}
+
+void UpdateWorldMatrices(EntityWorld& world, size_t grainSize)
+{
+	SOCO_PROFILE_SCOPE("UpdateWorldMatrices");
+	world.ParallelForEach<Transform, WorldMatrixComponent>(grainSize, [](Transform& transform, WorldMatrixComponent& worldMatrix) {
+		XMStoreFloat4x4(&worldMatrix.World, transform.GetLocalMatrixM());
+	}, { GetComponentTypeId<ParentComponent>(), GetComponentTypeId<OrbitComponent>() });
+
+	//父节点的世界矩阵已经在上面或UpdateOrbits中算完，这里只读
+	world.ParallelForEach<Transform, ParentComponent, WorldMatrixComponent>(grainSize,
+		[&world](Transform& transform, ParentComponent& parent, WorldMatrixComponent& worldMatrix) {
+		const WorldMatrixComponent* parentWorld = world.Get<WorldMatrixComponent>(parent.Parent);
+		assert(parentWorld != nullptr && world.Get<ParentComponent>(parent.Parent) == nullptr);
+		XMStoreFloat4x4(&worldMatrix.World, transform.GetLocalMatrixM() * XMLoadFloat4x4(&parentWorld->World));
+	});
+}
+
+void UpdateMeshRendererObjects(EntityWorld& world, int currentFrame, size_t grainSize)
+{
+	SOCO_PROFILE_SCOPE("UpdateMeshRendererObjects");
+	for (Archetype* archetype : world.Query<WorldMatrixComponent, MeshRendererComponent>())
+	{
+		WorldMatrixComponent* worlds = archetype->GetColumn<WorldMatrixComponent>();
+		MeshRendererComponent* renderers = archetype->GetColumn<MeshRendererComponent>();
+		JobSystem::GetInstance()->ParallelFor(0, archetype->Size(), grainSize, [=](size_t first, size_t last) {
+			int64_t bytes = 0;
+			for (size_t i = first; i < last; ++i)
+			{
+				BYTE* data = renderers[i].Renderer->GetFrameObjectData(currentFrame);
+				if (data == nullptr)
+					continue;
+				XMStoreFloat4x4(reinterpret_cast<XMFLOAT4X4*>(data), XMMatrixTranspose(XMLoadFloat4x4(&worlds[i].World)));
+				bytes += sizeof(XMFLOAT4X4);
+			}
+			SOCO_STAT_ADD("UploadBufferBytes", bytes);
+		});
+	}
+}
+
+void SelectMeshLods(EntityWorld& world, const XMFLOAT3& eyePosition, float fovY, float viewportHeight, float maxScreenError,
+	int currentFrame, size_t grainSize)
+{
+	SOCO_PROFILE_SCOPE("SelectMeshLods");
+
+	//物体空间的误差e经过缩放s、在距离d处投影到屏幕上约为e * s * projScale / d个像素
+	const float projScale = viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+	const XMVECTOR eye = XMLoadFloat3(&eyePosition);
+
+	world.ParallelForEach<MeshRendererComponent, WorldMatrixComponent>(grainSize,
+		[&](MeshRendererComponent& renderer, WorldMatrixComponent& worldMatrix) {
+			if (renderer.Renderer == nullptr || renderer.Renderer->GetLodCount() <= 1)
+				return;
+
+			const SubmeshGeometry& submesh = renderer.Renderer->GetSubmesh();
+			XMMATRIX W = XMLoadFloat4x4(&worldMatrix.World);
+			float scale = std::max<float>({ XMVectorGetX(XMVector3Length(W.r[0])), XMVectorGetX(XMVector3Length(W.r[1])),
+				XMVectorGetX(XMVector3Length(W.r[2])) });
+
+			//包围盒的外接球
+			XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&submesh.Bounds.Center), W);
+			float radius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&submesh.Bounds.Extents))) * scale;
+			float distance = XMVectorGetX(XMVector3Length(center - eye)) - radius;
+
+			//相机在包围球里时用完整网格
+			UINT lod = 0;
+			if (distance > 0.0f)
+			{
+				const float pixelsPerUnit = scale * projScale / distance;
+				while (lod < submesh.Lods.size() && submesh.Lods[lod].Error * pixelsPerUnit <= maxScreenError)
+					++lod;
+			}
+			renderer.Renderer->SetLod(currentFrame, lod);
+		});
+}
+
+void CullMeshletRenderers(EntityWorld& world, const XMFLOAT3& eyePosition, const XMFLOAT4X4& viewProj, int currentFrame, size_t grainSize)
+{
+	SOCO_PROFILE_SCOPE("CullMeshletRenderers");
+
+	float worldPlanes[6][4];
+	ExtractFrustumPlanes(&viewProj.m[0][0], worldPlanes);
+	const XMVECTOR eye = XMLoadFloat3(&eyePosition);
+
+	world.ParallelForEach<MeshRendererComponent, WorldMatrixComponent>(grainSize,
+		[&](MeshRendererComponent& renderer, WorldMatrixComponent& worldMatrix) {
+			if (renderer.Renderer == nullptr || !renderer.Renderer->HasMeshlets())
+				return;
+
+			XMMATRIX W = XMLoadFloat4x4(&worldMatrix.World);
+			XMVECTOR determinant;
+			XMMATRIX invW = XMMatrixInverse(&determinant, W);
+
+			MeshletCullParams params;
+			XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(params.CameraPosition), XMVector3TransformCoord(eye, invW));
+
+			//行向量约定下x_w = x_o * W，物体空间的平面是p * W^T，算出的距离仍是世界单位
+			XMMATRIX planeTransform = XMMatrixTranspose(W);
+			for (int i = 0; i < 6; ++i)
+			{
+				XMVECTOR plane = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(worldPlanes[i]));
+				XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(params.FrustumPlanes[i]), XMVector4Transform(plane, planeTransform));
+			}
+
+			//半径按最大缩放放大；不均匀缩放下法线锥不再成立，关掉锥剔除
+			float scaleX = XMVectorGetX(XMVector3Length(W.r[0]));
+			float scaleY = XMVectorGetX(XMVector3Length(W.r[1]));
+			float scaleZ = XMVectorGetX(XMVector3Length(W.r[2]));
+			float maxScale = std::max<float>({ scaleX, scaleY, scaleZ });
+			float minScale = std::min<float>({ scaleX, scaleY, scaleZ });
+			params.RadiusScale = maxScale;
+			params.ConeCulling = maxScale - minScale <= 1e-3f * maxScale;
+
+			renderer.Renderer->CullMeshlets(currentFrame, params);
+		});
+}
+
+void RequestTextureDensities(EntityWorld& world, const XMFLOAT4X4& viewProj, float fovY, float viewportHeight, size_t grainSize)
+{
+	SOCO_PROFILE_SCOPE("RequestTextureDensities");
+
+	const float projScale = viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+	float planes[6][4];
+	ExtractFrustumPlanes(&viewProj.m[0][0], planes);
+	//行向量约定下clip.w是点和第4列的点积，透视投影的w就是视空间深度
+	const XMVECTOR depthColumn = XMVectorSet(viewProj._14, viewProj._24, viewProj._34, viewProj._44);
+
+	world.ParallelForEach<MeshRendererComponent, WorldMatrixComponent>(grainSize,
+		[&](MeshRendererComponent& renderer, WorldMatrixComponent& worldMatrix) {
+			if (renderer.Renderer == nullptr || renderer.Renderer->GetMaterial() == nullptr)
+				return;
+			const SubmeshGeometry& submesh = renderer.Renderer->GetSubmesh();
+			if (submesh.UvDensity <= 0.0f)
+				return;
+
+			XMMATRIX W = XMLoadFloat4x4(&worldMatrix.World);
+			float scale = std::max<float>({ XMVectorGetX(XMVector3Length(W.r[0])), XMVectorGetX(XMVector3Length(W.r[1])),
+				XMVectorGetX(XMVector3Length(W.r[2])) });
+			XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&submesh.Bounds.Center), W);
+			float radius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&submesh.Bounds.Extents))) * scale;
+
+			//视锥外的物体不请求，只被它用到的纹理过一段时间会丢掉精细的mip
+			XMFLOAT3 c;
+			XMStoreFloat3(&c, center);
+			for (int i = 0; i < 6; ++i)
+			{
+				if (planes[i][0] * c.x + planes[i][1] * c.y + planes[i][2] * c.z + planes[i][3] < -radius)
+					return;
+			}
+
+			float depth = XMVectorGetX(XMVector4Dot(XMVectorSetW(center, 1.0f), depthColumn)) - radius;
+			renderer.Renderer->GetMaterial()->RequestTextureDensity(ComputeScreenUvDensity(submesh.UvDensity, scale, depth, projScale));
+		});
+}
+
+}
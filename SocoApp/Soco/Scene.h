@@ -0,0 +1,81 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+#include "Transform.h"
+#include "Util/Ecs.h"
+
+namespace Soco
+{
+
+class MeshRenderer;
+
+// 场景实体的组件，变换直接使用Soco::Transform(parent指针保持为空，层级用ParentComponent表示)
+
+// 绕原点的圆轨道：每帧Theta增加Speed*dt，同时绕自身Y轴自转SpinSpeed*dt
+// 有轨道的实体由UpdateOrbits直接写世界矩阵，Transform的位置和旋转同步更新，构造时给的旋转被自转角取代
+// 两个float4大小，系统一次读4个实体再转置成SoA
+struct alignas(16) OrbitComponent
+{
+	float Radius = 0;
+	float Height = 0;
+	float Speed = 0;
+	float Theta = 0;
+	float SpinSpeed = 0;
+	float SpinAngle = 0;
+	float Padding[2] = {};
+};
+
+// 均匀间隔的位置关键帧，循环播放，最后一帧之后插值回第一帧
+struct AnimationCurve
+{
+	float KeyInterval = 1;
+	std::vector<DirectX::XMFLOAT3> Keys;
+};
+
+// Curve由调用者持有，要比实体活得久
+struct CurveAnimationComponent
+{
+	const AnimationCurve* Curve = nullptr;
+	float Time = 0;
+	float Speed = 1;
+};
+
+// 父节点本身不能再有父节点
+struct ParentComponent
+{
+	Entity Parent;
+};
+
+struct WorldMatrixComponent
+{
+	DirectX::XMFLOAT4X4 World;
+};
+
+// renderer的object常量第一个成员必须是World矩阵
+struct MeshRendererComponent
+{
+	MeshRenderer* Renderer = nullptr;
+};
+
+// 系统：按archetype线性遍历，grainSize为SIZE_MAX时在调用线程上执行
+// 轨道：4个实体一组用XMVectorSinCos计算，直接写世界矩阵
+void UpdateOrbits(EntityWorld& world, float dt, size_t grainSize);
+// 关键帧曲线：更新Transform的位置，世界矩阵由UpdateWorldMatrices计算
+void UpdateCurveAnimations(EntityWorld& world, float dt, size_t grainSize);
+// 没有轨道的实体：先算没有父节点的，再算子节点
+void UpdateWorldMatrices(EntityWorld& world, size_t grainSize);
+// 把世界矩阵转置后直接写进renderer在currentFrame的object常量upload buffer
+void UpdateMeshRendererObjects(EntityWorld& world, int currentFrame, size_t grainSize);
+// 子网格带LOD链的renderer：把每级LOD的误差按包围球上离相机最近的距离投影到屏幕，选不超过maxScreenError像素的最粗一级
+// 要在CullMeshletRenderers之前调用，选了简化LOD的renderer不做meshlet剔除
+void SelectMeshLods(EntityWorld& world, const DirectX::XMFLOAT3& eyePosition, float fovY, float viewportHeight, float maxScreenError,
+	int currentFrame, size_t grainSize);
+// 子网格带meshlet的renderer：把相机和视锥变换到物体空间做CPU剔除，写本帧的索引
+void CullMeshletRenderers(EntityWorld& world, const DirectX::XMFLOAT3& eyePosition, const DirectX::XMFLOAT4X4& viewProj, int currentFrame, size_t grainSize);
+// 子网格知道UV密度的renderer：视锥内的按包围球上离相机最近处的深度算出屏幕上每个UV单位的像素数，由材质请求纹理需要的mip
+void RequestTextureDensities(EntityWorld& world, const DirectX::XMFLOAT4X4& viewProj, float fovY, float viewportHeight, size_t grainSize);
+
+}
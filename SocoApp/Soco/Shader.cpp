@@ -4,15 +4,18 @@
 //#include "../Common/magic_enum.hpp"
 #include "Util/Redefine.h"
 #include "Util/RootSignatureManager.h"
+#include "Util/Profiler.h"
+#include "Util/Stats.h"
+#include "BindlessTextureTable.h"
 
 using Microsoft::WRL::ComPtr;
 
 namespace Soco{
 
-//Shader࣬ʱҪһCD3DX12_DESCRIPTOR_RANGE
-//ǩʱǴַ˲ظʹһRANGE
-//Գػʱȡͷ
-//֮ԲֱvectorΪʱvector·ַռ䣬עʱݷ仯
+//Shader工具类，当申请描述符表时需要一个CD3DX12_DESCRIPTOR_RANGE对象
+//但传入根签名时是传入地址，因此不能重复使用一个RANGE对象
+//所以池化，用时获取，用完释放
+//之所以不直接用vector，是因为当触发扩容时，vector会重新分配地址空间，导致注册根参数时的数据发生变化
 class DescriptorRangePool
 {
 public:
@@ -64,11 +67,12 @@ private:
 
 //Shader::Shader(ID3D12Device* device, const std::wstring& filename, const D3D_SHADER_MACRO* defines, ShaderStage stage) {
 Shader::Shader(const std::wstring& filename, const D3D_SHADER_MACRO* defines, ShaderStage stage, std::vector<D3D12_INPUT_ELEMENT_DESC>* inputLayout) {
+	SOCO_PROFILE_SCOPE("Shader::Shader");
 	mName = filename;
 
 	//stage = (ShaderStage::VS | ShaderStage::PS);
 	if (stage.cs == nullptr && (stage.vs == nullptr || stage.ps == nullptr)) {
-		throw std::exception("Compute ShaderVSPS׶Ϊѡ");
+		throw std::exception("非Compute Shader的VS或PS阶段为必选项");
 	}
 
 	if (stage.cs == nullptr)
@@ -121,6 +125,24 @@ void Shader::BuildRootSignature()
 			slotRootParameter.back().InitAsConstantBufferView(variable.BindPoint, variable.Space);
 			variable.rootSlot = slotRootParameter.size() - 1;
 		}
+		else if (variable.Type == D3D_SHADER_INPUT_TYPE::D3D_SIT_TEXTURE && variable.BindCount == 0) {
+			//没有大小的纹理数组是无绑定纹理表，大小由BindlessTextureTable决定
+			if (mBindlessSlot != -1) {
+				std::string res = "一个shader只能有一个无绑定纹理表，重复的名称为: " + variable.Name;
+				std::cout << res << std::endl;
+				throw std::exception(res.c_str());
+			}
+			assert(BindlessTextureTable::GetInstance()->GetCapacity() > 0 && "编译shader前要初始化BindlessTextureTable");
+
+			CD3DX12_DESCRIPTOR_RANGE* texTable = DescriptorRangePool::GetInstance()->GetDescriptorRange(1);
+			texTable->Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, BindlessTextureTable::GetInstance()->GetCapacity(), variable.BindPoint, variable.Space);
+
+			slotRootParameter.emplace_back();
+			slotRootParameter.back().InitAsDescriptorTable(1, texTable, variable.Visiblity);
+
+			variable.rootSlot = slotRootParameter.size() - 1;
+			mBindlessSlot = variable.rootSlot;
+		}
 		else if (variable.Type == D3D_SHADER_INPUT_TYPE::D3D_SIT_TEXTURE) {
 
 			CD3DX12_DESCRIPTOR_RANGE* texTable = DescriptorRangePool::GetInstance()->GetDescriptorRange(1);
@@ -134,6 +156,12 @@ void Shader::BuildRootSignature()
 			mTextureSlot[variable.Name] = variable.rootSlot;
 			
 		}
+		else if (variable.Type == D3D_SHADER_INPUT_TYPE::D3D_SIT_STRUCTURED && variable.BindCount == 1) {
+			//StructuredBuffer用根描述符，直接给缓冲的GPU地址，不占描述符堆
+			slotRootParameter.emplace_back();
+			slotRootParameter.back().InitAsShaderResourceView(variable.BindPoint, variable.Space, variable.Visiblity);
+			variable.rootSlot = slotRootParameter.size() - 1;
+		}
 		else if (variable.Type == D3D_SHADER_INPUT_TYPE::D3D_SIT_SAMPLER) {
 			continue;
 		}
@@ -148,12 +176,12 @@ void Shader::BuildRootSignature()
 
 		}
 		else {
-			std::string res = "shader variableδ鲢.\n";
-			res += "Ϊ: ";
+			std::string res = "此shader variable类型未做处理，请检查并添加.\n";
+			res += "名称为: ";
 			res += variable.Name;
-			res += " ֵΪ: ";
+			res += " 值为: ";
 			res += std::to_string(variable.Type);
-			res += " Ϊ: ";
+			res += " 类型为: ";
 			res += magic_enum::enum_name(static_cast<Redefine::D3D_SHADER_INPUT_TYPE>(variable.Type));
 			std::cout << res << std::endl;
 			throw std::exception(res.c_str());
@@ -282,6 +310,10 @@ void Shader::BuildInputLayout(ComPtr<ID3DBlob> shader)
 	UINT offset = 0;
 	while (SUCCEEDED(reflection->GetInputParameterDesc(i++, &spd)))
 	{
+		//SV_VertexID等系统值由管线生成，不是顶点数据
+		if (spd.SystemValueType != D3D_NAME_UNDEFINED)
+			continue;
+
 		auto [format, size] = GetFormatFromReflectionDesc(spd.ComponentType, spd.Mask);
 
 		mInputLayout.push_back({ spd.SemanticName, 0u, format, 0u, offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0u });
@@ -289,7 +321,7 @@ void Shader::BuildInputLayout(ComPtr<ID3DBlob> shader)
 	}
 }
 
-//ݵǰ׶ηϢmVariables
+//根据当前阶段反射信息，构造mVariables
 void Shader::InitInput(ComPtr<ID3DBlob> shader, D3D12_SHADER_VISIBILITY visibility)
 {
 	if (shader == nullptr)
@@ -338,6 +370,15 @@ void Shader::InitInput(ComPtr<ID3DBlob> shader, D3D12_SHADER_VISIBILITY visibili
 		if (mConstantBufferDescs.find(sbDesc.Name) == mConstantBufferDescs.end())
 		{
 			mConstantBufferDescs[sbDesc.Name] = sbDesc;
+
+			//记下每个成员的偏移，材质按名字写无绑定纹理的下标
+			std::map<std::string, ConstantBufferVariable>& variables = mConstantBufferVariables[sbDesc.Name];
+			for (UINT v = 0; v < sbDesc.Variables; ++v)
+			{
+				D3D12_SHADER_VARIABLE_DESC variableDesc;
+				cbuffer->GetVariableByIndex(v)->GetDesc(&variableDesc);
+				variables[variableDesc.Name] = { variableDesc.StartOffset, variableDesc.Size };
+			}
 		}
 		lastName = (char*)sbDesc.Name;
 	}
@@ -354,7 +395,7 @@ UINT Shader::GetSlot(std::string variableName) const {
 	if (auto ite = mVariables.find(variableName); ite != mVariables.end())
 		return ite->second.rootSlot;
 	else {
-		//std::string res = "δܸvariableҵӦ, δҵΪ";
+		//std::string res = "未能根据variable名称找到对应插槽, 未找到的名称为：";
 		//res += variableName;
 		//std::cout << res << std::endl;
 		//throw std::exception(res.c_str());
@@ -373,12 +414,36 @@ const D3D12_SHADER_BUFFER_DESC* Shader::GetConstantBufferDesc(const std::string&
 		
 }
 
+const Shader::ConstantBufferVariable* Shader::GetConstantBufferVariable(const std::string& bufferName, const std::string& variableName) const
+{
+	auto buffer = mConstantBufferVariables.find(bufferName);
+	if (buffer == mConstantBufferVariables.end())
+		return nullptr;
+
+	auto ite = buffer->second.find(variableName);
+	return ite != buffer->second.end() ? &(ite->second) : nullptr;
+}
+
+//无绑定纹理表跟着根签名一起设置，和这次draw用到几张纹理无关
+void Shader::SetBindlessTable(ID3D12GraphicsCommandList* cmdList)
+{
+	if (mBindlessSlot == -1)
+		return;
+
+	SOCO_STAT_ADD("BindlessTableSets", 1);
+	if (IsComputeShader())
+		cmdList->SetComputeRootDescriptorTable(mBindlessSlot, BindlessTextureTable::GetInstance()->GetTableStart());
+	else
+		cmdList->SetGraphicsRootDescriptorTable(mBindlessSlot, BindlessTextureTable::GetInstance()->GetTableStart());
+}
+
 void Shader::SetConstantBufferView(ID3D12GraphicsCommandList* cmdList, const std::string& variableName,
 	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) 
 {
 	UINT Slot = GetSlot(variableName);
 	if (Slot != -1)
 	{
+		SOCO_STAT_ADD("RootCBVSets", 1);
 		if (IsGraphicsShader())
 		{
 			cmdList->SetGraphicsRootConstantBufferView(Slot, BufferLocation);
@@ -392,11 +457,30 @@ void Shader::SetConstantBufferView(ID3D12GraphicsCommandList* cmdList, const std
 		
 }
 
+void Shader::SetShaderResourceView(ID3D12GraphicsCommandList* cmdList, const std::string& variableName,
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+{
+	UINT Slot = GetSlot(variableName);
+	if (Slot != -1)
+	{
+		SOCO_STAT_ADD("RootSRVSets", 1);
+		if (IsGraphicsShader())
+		{
+			cmdList->SetGraphicsRootShaderResourceView(Slot, BufferLocation);
+		}
+		else if (IsComputeShader())
+		{
+			cmdList->SetComputeRootShaderResourceView(Slot, BufferLocation);
+		}
+	}
+}
+
 void Shader::SetTexture(ID3D12GraphicsCommandList* cmdList, const std::string& textureName, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor)
 {
 	UINT Slot = GetSlot(textureName);
 	if (Slot != -1)
 	{
+		SOCO_STAT_ADD("DescriptorTableSets", 1);
 		if (IsGraphicsShader())
 		{
 			cmdList->SetGraphicsRootDescriptorTable(Slot, BaseDescriptor);
@@ -461,6 +545,20 @@ void Shader::BuildComputePipelineState()
 	};
 	psoDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
 	ThrowIfFailed(D3DApp::GetDevice()->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&mComputePSO)));
+
+	ComPtr<ID3D12ShaderReflection> reflection;
+	ThrowIfFailed(::D3DReflect(CS->GetBufferPointer(), CS->GetBufferSize(), IID_PPV_ARGS(&reflection)));
+	reflection->GetThreadGroupSize(&mThreadGroupSize[0], &mThreadGroupSize[1], &mThreadGroupSize[2]);
+}
+
+void Shader::Dispatch(ID3D12GraphicsCommandList* cmdList, UINT threadCountX, UINT threadCountY, UINT threadCountZ)
+{
+	assert(IsComputeShader());
+	SOCO_STAT_ADD("Dispatches", 1);
+	cmdList->Dispatch(
+		(threadCountX + mThreadGroupSize[0] - 1) / mThreadGroupSize[0],
+		(threadCountY + mThreadGroupSize[1] - 1) / mThreadGroupSize[1],
+		(threadCountZ + mThreadGroupSize[2] - 1) / mThreadGroupSize[2]);
 }
 
 }
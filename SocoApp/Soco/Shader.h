@@ -3,6 +3,7 @@
 #include <map>
 #include <vector>
 #include "../Common/d3dUtil.h"
+#include "Util/Stats.h"
 #include <winnt.h>
 
 #include <iostream>
@@ -46,6 +47,13 @@ namespace Soco {
 			UINT rootSlot = -1;
 		};
 
+		//常量缓冲里一个成员的位置，单位字节
+		struct ConstantBufferVariable
+		{
+			UINT Offset;
+			UINT Size;
+		};
+
 	public:
 		Shader(const std::wstring& filename, const D3D_SHADER_MACRO* defines, ShaderStage stage, std::vector<D3D12_INPUT_ELEMENT_DESC>* inputLayout = nullptr);
 
@@ -55,10 +63,14 @@ namespace Soco {
 		Shader(Shader&& rhs) :
 			mName(std::move(rhs.mName)),
 			VS(rhs.VS), PS(rhs.PS), HS(rhs.HS), DS(rhs.DS), GS(rhs.GS),
+			CS(rhs.CS), mComputePSO(rhs.mComputePSO),
+			mThreadGroupSize{ rhs.mThreadGroupSize[0], rhs.mThreadGroupSize[1], rhs.mThreadGroupSize[2] },
 			mRootSignature(rhs.mRootSignature),
 			mVariables(std::move(rhs.mVariables)),
 			mConstantBufferDescs(std::move(rhs.mConstantBufferDescs)),
+			mConstantBufferVariables(std::move(rhs.mConstantBufferVariables)),
 			mTextureSlot(std::move(rhs.mTextureSlot)),
+			mBindlessSlot(rhs.mBindlessSlot),
 			mInputLayout(std::move(rhs.mInputLayout)),
 			mPrimitiveType(rhs.mPrimitiveType)
 		{
@@ -70,6 +82,8 @@ namespace Soco {
 			rhs.HS = nullptr;
 			rhs.DS = nullptr;
 			rhs.GS = nullptr;
+			rhs.CS = nullptr;
+			rhs.mComputePSO = nullptr;
 			rhs.mRootSignature = nullptr;
 		}
 
@@ -84,31 +98,49 @@ namespace Soco {
 			HS = rhs.HS; rhs.HS = nullptr;
 			DS = rhs.DS; rhs.DS = nullptr;
 			GS = rhs.GS; rhs.GS = nullptr;
+			CS = rhs.CS; rhs.CS = nullptr;
+			mComputePSO = rhs.mComputePSO; rhs.mComputePSO = nullptr;
+			std::copy(std::begin(rhs.mThreadGroupSize), std::end(rhs.mThreadGroupSize), mThreadGroupSize);
 			mRootSignature = rhs.mRootSignature; rhs.mRootSignature = nullptr;
 			mVariables = std::move(rhs.mVariables);
 			mConstantBufferDescs = std::move(rhs.mConstantBufferDescs);
+			mConstantBufferVariables = std::move(rhs.mConstantBufferVariables);
+			mTextureSlot = std::move(rhs.mTextureSlot);
+			mBindlessSlot = rhs.mBindlessSlot;
+			mInputLayout = std::move(rhs.mInputLayout);
+			mPrimitiveType = rhs.mPrimitiveType;
 
 			return *this;
 		}
 
 		UINT GetSlot(std::string variableName) const;
 		const D3D12_SHADER_BUFFER_DESC* GetConstantBufferDesc(const std::string& name) const;
+		//找不到常量缓冲或成员时返回nullptr
+		const ConstantBufferVariable* GetConstantBufferVariable(const std::string& bufferName, const std::string& variableName) const;
+		//shader声明了没有大小的纹理数组，纹理通过BindlessTextureTable的下标访问
+		bool HasBindlessTable() const { return mBindlessSlot != -1; }
 
 		bool HasTessellationStage() { return DS != nullptr && HS != nullptr; }
 		bool IsComputeShader() { return CS != nullptr; }
 		bool IsGraphicsShader() { return VS != nullptr && PS != nullptr; }
 
 		void SetConstantBufferView(ID3D12GraphicsCommandList* cmdList, const std::string& variableName, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation);
+		//StructuredBuffer，BufferLocation是缓冲里第一个元素的地址
+		void SetShaderResourceView(ID3D12GraphicsCommandList* cmdList, const std::string& variableName, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation);
 		void SetTexture(ID3D12GraphicsCommandList* cmdList, const std::string& textureName, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor);
 		//void SetUnorderAccessView(ID3D12GraphicsCommandList* cmdList, const std::string& variableName, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor);
 
 		//Graphics Setup
-		void SetGraphicsRootSignature(ID3D12GraphicsCommandList* cmdList) { assert(IsGraphicsShader()); cmdList->SetGraphicsRootSignature(mRootSignature.Get());}
+		void SetGraphicsRootSignature(ID3D12GraphicsCommandList* cmdList) { assert(IsGraphicsShader()); SOCO_STAT_ADD("RootSignatureSets", 1); cmdList->SetGraphicsRootSignature(mRootSignature.Get()); SetBindlessTable(cmdList); }
 		void SetIASetPrimitiveTopology(ID3D12GraphicsCommandList* cmdList){ assert(IsGraphicsShader()); cmdList->IASetPrimitiveTopology(mPrimitiveType); }
 
 		//Setup Compute Shader
-		void SetComputeRootSignature(ID3D12GraphicsCommandList* cmdList) { assert(IsComputeShader()); cmdList->SetComputeRootSignature(mRootSignature.Get()); }
-		void SetComputePipelineState(ID3D12GraphicsCommandList* cmdList) { assert(IsComputeShader()); cmdList->SetPipelineState(mComputePSO.Get()); }
+		void SetComputeRootSignature(ID3D12GraphicsCommandList* cmdList) { assert(IsComputeShader()); SOCO_STAT_ADD("RootSignatureSets", 1); cmdList->SetComputeRootSignature(mRootSignature.Get()); SetBindlessTable(cmdList); }
+		void SetComputePipelineState(ID3D12GraphicsCommandList* cmdList) { assert(IsComputeShader()); SOCO_STAT_ADD("PipelineStateSets", 1); cmdList->SetPipelineState(mComputePSO.Get()); }
+		//反射得到的numthreads
+		std::tuple<UINT, UINT, UINT> GetThreadGroupSize() const { return { mThreadGroupSize[0], mThreadGroupSize[1], mThreadGroupSize[2] }; }
+		//按线程总数和numthreads计算线程组数量并Dispatch
+		void Dispatch(ID3D12GraphicsCommandList* cmdList, UINT threadCountX, UINT threadCountY, UINT threadCountZ = 1);
 
 		//Initialize Graphics PSO Desc
 		void SetPSODescShader(D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc);
@@ -126,6 +158,7 @@ namespace Soco {
 
 	private:
 		void BuildRootSignature();
+		void SetBindlessTable(ID3D12GraphicsCommandList* cmdList);
 
 		static std::tuple<DXGI_FORMAT, size_t> GetFormatFromReflectionDesc(D3D_REGISTER_COMPONENT_TYPE type, BYTE mask);
 		void BuildInputLayout(Microsoft::WRL::ComPtr<ID3DBlob> shader);
@@ -143,14 +176,18 @@ namespace Soco {
 
 		Microsoft::WRL::ComPtr<ID3DBlob> CS;
 		Microsoft::WRL::ComPtr<ID3D12PipelineState> mComputePSO;
+		UINT mThreadGroupSize[3] = { 1, 1, 1 };
 
 		std::map<std::string, ShaderVariable> mVariables;
 		Microsoft::WRL::ComPtr<ID3D12RootSignature> mRootSignature;
 		std::map<std::string, D3D12_SHADER_BUFFER_DESC> mConstantBufferDescs;
+		std::map<std::string, std::map<std::string, ConstantBufferVariable>> mConstantBufferVariables;
 		std::map<std::string, UINT> mTextureSlot;
+		//无绑定纹理表的根参数，没有时为-1
+		UINT mBindlessSlot = -1;
 		std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
 
-		//ʼ⵽DomainShaderʱıΪƵͼԪ
+		//当初始化检测到存在DomainShader时，会改变为控制点图元
 		D3D12_PRIMITIVE_TOPOLOGY mPrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 	};
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Renderer.h"
+#include "GeometryArena.h"
 
 namespace Soco
 {
@@ -33,10 +34,19 @@ public:
 		mMaterial = material;
 	}
 
+	~SkyboxRenderer()
+	{
+		GeometryArena::GetInstance()->Release(mSkyboxMesh.get());
+	}
+
+	void SetInputAssembler(ID3D12GraphicsCommandList* cmdList, int currentFrame, InputAssemblerState& state) override
+	{
+		state.SetVertexBuffer(cmdList, mSkyboxMesh->VertexBufferView());
+		state.SetIndexBuffer(cmdList, mSkyboxMesh->IndexBufferView());
+	}
+
 	void Setup(ID3D12GraphicsCommandList* cmdList, int currentFrame) override
 	{
-		cmdList->IASetVertexBuffers(0, 1, &mSkyboxMesh->VertexBufferView());
-		cmdList->IASetIndexBuffer(&mSkyboxMesh->IndexBufferView());
 		cmdList->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 		mMaterial->Setup(cmdList, currentFrame);
@@ -45,17 +55,19 @@ public:
 	void DrawIndexedInstanced(ID3D12GraphicsCommandList* cmdList) override
 	{
 		SubmeshGeometry& submesh = mSkyboxMesh->DrawArgs[mSubmeshName];
-		cmdList->DrawIndexedInstanced(submesh.IndexCount, 1, submesh.StartIndexLocation, submesh.BaseVertexLocation, 0);
+		SOCO_STAT_ADD("DrawCalls", 1);
+		cmdList->DrawIndexedInstanced(submesh.IndexCount, 1, submesh.StartIndexLocation + mSkyboxMesh->ArenaStartIndex,
+			submesh.BaseVertexLocation + mSkyboxMesh->ArenaBaseVertex, 0);
 	}
 
 private:
-	//Ĭ
-	//ҪShaderInputLayoutӦҪֶMesh
+	//构造默认网格数据
+	//需要传入的Shader与InputLayout对应，否则需要手动传入Mesh
 	void BuildBox()
 	{
 		GeometryGenerator geoGen;
 		//[-1, 1]x[-1, 1]x[-1, 1]
-		//ndcĵ
+		//ndc下相机的四点
 		GeometryGenerator::MeshData box = geoGen.CreateBox(2.0f, 2.0f, 2.0f, 0);
 
 		std::vector<Vertex> vertices(box.Vertices.size());
@@ -81,20 +93,10 @@ private:
 		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
 		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-		geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(D3DApp::GetApp()->GetDevice(),
-			D3DApp::GetApp()->GetCommandList(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-		geo->VertexBufferGPU->SetName(L"Skybox Vertex Buffer");
-		geo->VertexBufferUploader->SetName(L"Skybox Vertex Buffer Uploader");
-
-		geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(D3DApp::GetApp()->GetDevice(),
-			D3DApp::GetApp()->GetCommandList(), indices.data(), ibByteSize, geo->IndexBufferUploader);
-		geo->IndexBufferGPU->SetName(L"Skybox Index Buffer");
-		geo->IndexBufferUploader->SetName(L"Skybox Index Buffer Uploader");
-
 		geo->VertexByteStride = sizeof(Vertex);
-		geo->VertexBufferByteSize = vbByteSize;
 		geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-		geo->IndexBufferByteSize = ibByteSize;
+		GeometryArena::GetInstance()->Upload(D3DApp::GetApp()->GetCommandList(), geo.get(),
+			vertices.data(), vbByteSize, indices.data(), ibByteSize);
 
 		SubmeshGeometry submesh;
 		submesh.IndexCount = (UINT)indices.size();
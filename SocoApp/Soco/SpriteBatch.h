@@ -0,0 +1,183 @@
+#pragma once
+#include "Renderer.h"
+#include "Texture.h"
+#include "TextureResidency.h"
+#include "Util/PipelineStateManager.h"
+#include "Util/SpriteBatchBuilder.h"
+
+extern const int gNumFrameResources;
+
+namespace Soco
+{
+/*
+屏幕上的2D精灵：每帧用Draw提交，所有精灵共用一个shader和PSO
+Update时按(层, 纹理)排好序写进这一帧的实例缓冲，纹理通过无绑定纹理表的下标访问，所以不管多少张纹理都只有一次DrawInstanced
+Draw只能在主线程、Update的job开始之前调用，提交的精灵只画一帧
+*/
+class SpriteBatch : public Renderer
+{
+public:
+	static constexpr UINT InitialCapacity = 256;
+
+	SpriteBatch()
+		:Renderer(nullptr), mShader(GetShader())
+	{
+		BuildPSODesc();
+		mInstanceBuffers.resize(gNumFrameResources);
+		mInstanceCapacity.resize(gNumFrameResources, 0);
+		mFrameTextures.resize(gNumFrameResources);
+	}
+
+	// size和offset以整个屏幕为1，offset是左下角；uvRect的xy是纹理上的起点，zw是大小；layer小的先画
+	void Draw(Texture* texture, DirectX::XMFLOAT2 size, DirectX::XMFLOAT2 offset,
+		DirectX::XMFLOAT4 uvRect = { 0, 0, 1, 1 }, uint32_t layer = 0)
+	{
+		SpriteInstance sprite;
+		sprite.Size[0] = size.x;
+		sprite.Size[1] = size.y;
+		sprite.Offset[0] = offset.x;
+		sprite.Offset[1] = offset.y;
+		sprite.UvRect[0] = uvRect.x;
+		sprite.UvRect[1] = uvRect.y;
+		sprite.UvRect[2] = uvRect.z;
+		sprite.UvRect[3] = uvRect.w;
+		sprite.TextureIndex = texture->BindlessIndex();
+		mBuilder.Add(sprite, layer);
+
+		//每张纹理每帧只记一次，录制时告诉常驻管理用到了
+		if (sprite.TextureIndex >= mTextureFrame.size())
+			mTextureFrame.resize(sprite.TextureIndex + 1, 0);
+		if (mTextureFrame[sprite.TextureIndex] != mSubmitFrame)
+		{
+			mTextureFrame[sprite.TextureIndex] = mSubmitFrame;
+			mTextures.push_back(texture);
+		}
+	}
+
+	void Update(int currentFrame) override
+	{
+		const UINT count = mBuilder.GetCount();
+		if (count > mInstanceCapacity[currentFrame])
+		{
+			//这个FrameResource的GPU工作已经完成，只换掉它自己的缓冲
+			UINT capacity = std::max(InitialCapacity, mInstanceCapacity[currentFrame]);
+			while (capacity < count)
+				capacity *= 2;
+			mInstanceBuffers[currentFrame] = std::make_unique<UploadBuffer>(capacity, (UINT)sizeof(SpriteInstance), false);
+			mInstanceCapacity[currentFrame] = capacity;
+		}
+
+		if (count > 0)
+		{
+			const uint32_t runs = mBuilder.Build((SpriteInstance*)mInstanceBuffers[currentFrame]->GetMappedData(0));
+			SOCO_STAT_ADD("UploadBufferBytes", count * sizeof(SpriteInstance));
+			SOCO_STAT_ADD("Sprites", count);
+			SOCO_STAT_ADD("SpriteTextureRuns", runs);
+		}
+		mFrameCount = count;
+		mFrameTextures[currentFrame].swap(mTextures);
+
+		mBuilder.Clear();
+		mTextures.clear();
+		++mSubmitFrame;
+	}
+
+	void Setup(ID3D12GraphicsCommandList* cmdList, int currnetFrame) override
+	{
+		cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+		if (mFrameCount == 0)
+			return;
+
+		mShader->SetShaderResourceView(cmdList, mInstanceBufferName, mInstanceBuffers[currnetFrame]->Resource()->GetGPUVirtualAddress());
+		TextureResidencyManager* residency = TextureResidencyManager::GetInstance();
+		for (Texture* texture : mFrameTextures[currnetFrame])
+			residency->MarkUsed(texture);
+	}
+
+	void DrawIndexedInstanced(ID3D12GraphicsCommandList* cmdList) override
+	{
+		if (mFrameCount == 0)
+			return;
+		SOCO_STAT_ADD("DrawCalls", 1);
+		cmdList->DrawInstanced(4, mFrameCount, 0, 0);
+	}
+
+	void SetGraphicsRootSignature(ID3D12GraphicsCommandList* cmdList) override
+	{
+		mShader->SetGraphicsRootSignature(cmdList);
+	}
+	void SetPipelineState(ID3D12GraphicsCommandList* cmdList) override
+	{
+		SOCO_STAT_ADD("PipelineStateSets", 1);
+		cmdList->SetPipelineState(mPSO.Get());
+	}
+	void SetCBV(ID3D12GraphicsCommandList* cmdList, const std::string& cbName, D3D12_GPU_VIRTUAL_ADDRESS address) override
+	{
+		mShader->SetConstantBufferView(cmdList, cbName, address);
+	}
+
+private:
+	static Shader* GetShader()
+	{
+		static Shader* shader = []() {
+			Soco::ShaderStage ss;
+			ss.vs = "VS";
+			ss.ps = "PS";
+			return new Shader(L"Shaders\\Sprite.hlsl", nullptr, ss);
+		}();
+		return shader;
+	}
+
+	void BuildPSODesc()
+	{
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC tempPSODesc;
+		ZeroMemory(&tempPSODesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
+		tempPSODesc.SampleMask = UINT_MAX;
+		tempPSODesc.NumRenderTargets = 1;
+
+		tempPSODesc.RTVFormats[0] = D3DApp::GetBackBufferFormat();
+		tempPSODesc.DSVFormat = D3DApp::GetDepthStencilFormat();
+		auto[MsaaState, MsaaQuality] = D3DApp::GetMSAAState();
+		tempPSODesc.SampleDesc.Count = MsaaState ? 4 : 1;
+		tempPSODesc.SampleDesc.Quality = MsaaState ? (MsaaQuality - 1) : 0;
+
+		tempPSODesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+		//精灵按提交顺序互相覆盖，用alpha混合
+		tempPSODesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+		D3D12_RENDER_TARGET_BLEND_DESC& blend = tempPSODesc.BlendState.RenderTarget[0];
+		blend.BlendEnable = TRUE;
+		blend.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+		blend.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+		blend.BlendOp = D3D12_BLEND_OP_ADD;
+		tempPSODesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+		tempPSODesc.DepthStencilState.DepthEnable = FALSE;
+		tempPSODesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_ALWAYS;
+		tempPSODesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+
+		mShader->SetPSODescRootSignature(&tempPSODesc);
+		mShader->SetPSODescShader(&tempPSODesc);
+		mShader->SetPSODescInputLayout(&tempPSODesc);
+		mShader->SetPSODescTopology(&tempPSODesc);
+
+		mPSO = PipelineStateManager::GetInstance()->GetPipelineState(D3DApp::GetDevice(), &tempPSODesc);
+	}
+
+private:
+	const char* mInstanceBufferName = "gSprites";
+
+	Shader* mShader;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> mPSO;
+
+	SpriteBatchBuilder mBuilder;
+	// 每个FrameResource一个实例缓冲，不够时翻倍
+	std::vector<std::unique_ptr<UploadBuffer>> mInstanceBuffers;
+	std::vector<UINT> mInstanceCapacity;
+	UINT mFrameCount = 0;
+
+	// 这一帧提交的精灵用到的纹理，按无绑定下标去重
+	std::vector<Texture*> mTextures;
+	std::vector<uint64_t> mTextureFrame;
+	uint64_t mSubmitFrame = 1;
+	std::vector<std::vector<Texture*>> mFrameTextures;
+};
+}
@@ -1,90 +1,68 @@
 #include "Terrain.h"
 #include <iostream>
 #include "../Common/DescriptorHeapAllocator.h"
+#include "MipGenerator.h"
+#include "Util/PngDecoder.h"
 #include "Util/PrintHelper.h"
+#include "Util/Profiler.h"
+#include "Util/VertexCompression.h"
 
 #include <algorithm>
 
 namespace Soco
 {
-Terrain::Terrain(const char* HeightMapFilename)
+Terrain::Terrain(const char* HeightMapFilename, UINT meshDownScale, bool packedVertices)
+	: mMeshDownScale(meshDownScale), mPackedVertices(packedVertices)
 {
 	LoadHeightMap(HeightMapFilename);
 	BuildTerrainMesh();
 }
 
-void Terrain::LoadHeightMap(const char* HeightMapFilename)
+void Terrain::TerrainTexture::WriteSRV(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle)
 {
-	UINT width, height;
-	unsigned char* data;
+	const D3D12_RESOURCE_DESC descTex = Resource->GetDesc();
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = descTex.Format;
+	//BC4只有R通道，把R复制到GB、A固定为1，像素着色器把高度图当颜色采样时和未压缩的灰度图一样
+	srvDesc.Shader4ComponentMapping = descTex.Format == DXGI_FORMAT_BC4_UNORM
+		? D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(0, 0, 0, D3D12_SHADER_COMPONENT_MAPPING_FORCE_VALUE_1)
+		: D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = descTex.MipLevels;
 
-	UINT error = lodepng_decode32_file(&data, &width, &height, HeightMapFilename);
-	if (error)
+	D3DApp::GetDevice()->CreateShaderResourceView(Resource.Get(), &srvDesc, cpuHandle);
+}
+
+void Terrain::LoadHeightMap(const char* HeightMapFilename)
+{
+	SOCO_PROFILE_SCOPE("LoadHeightMap");
+	//解码直接输出RGBA8，inflate和反滤波流水线进行
+	PngImage image;
+	if (!DecodePngFile(HeightMapFilename, PngDecodeOptions(), image))
 	{
-		std::cout << "߶ͼ" << HeightMapFilename << "ش" << std::endl;
+		std::cout << "高度图" << HeightMapFilename << "加载错误" << std::endl;
 		throw std::exception();
 	}
 
-	mHeightMapData = std::unique_ptr<unsigned char>(data);
-
-	D3D12_RESOURCE_DESC descTex = {};
-	descTex.MipLevels = 1;
-	descTex.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	descTex.Width = width;
-	descTex.Height = height;
-	descTex.Flags = D3D12_RESOURCE_FLAG_NONE;
-	descTex.DepthOrArraySize = 1;
-	descTex.SampleDesc.Count = 1;
-	descTex.SampleDesc.Quality = 0;
-	descTex.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-
-	ThrowIfFailed(D3DApp::GetApp()->GetDevice()->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&descTex,
-		D3D12_RESOURCE_STATE_COPY_DEST,
-		nullptr,
-		IID_PPV_ARGS(mHeightMapResource.GetAddressOf())
-	));
-	mHeightMapResource->SetName(L"Height Map");
-
-	D3D12_SUBRESOURCE_DATA dataTex = {};
-	dataTex.pData = data;
-	dataTex.RowPitch = width * 4 * sizeof(unsigned char);
-	dataTex.SlicePitch = height * width * 4 * sizeof(unsigned char);
-
-	const UINT num2DSubresources = descTex.MipLevels * descTex.DepthOrArraySize;
-
-	auto size = GetRequiredIntermediateSize(mHeightMapResource.Get(), 0, num2DSubresources);
-	size = (UINT64)pow(2.0, ceil(log(size) / log(2)));
-	ThrowIfFailed(D3DApp::GetApp()->GetDevice()->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(size),
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(mUploadBuffer.GetAddressOf())
-	));
+	const UINT width = image.Width, height = image.Height;
+	mHeightMapData = std::move(image.Pixels);
+	const unsigned char* data = mHeightMapData.data();
 
+	//远处的地形要采样低一级的mip，按面积平均生成完整的mip链；域着色器也会采样，所以两种shader resource状态都要有
+	//shader只读高度(R通道)，压缩成BC4，显存是RGBA8的1/8；CPU上的顶点高度仍然用原始数据
+	MipChainOptions mipOptions;
+	mipOptions.Filter = MipFilter::Box;
+	MipGenerator::GetInstance()->CreateCompressedTexture(D3DApp::GetCommandList(), data, width, height, mipOptions, BCFormat::BC4,
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, mHeightMapResource, mUploadBuffer);
+	mHeightMapResource->SetName(L"Height Map");
 	mUploadBuffer->SetName(L"Height Map Upload Buffer");
-	UpdateSubresources(D3DApp::GetApp()->GetCommandList(), mHeightMapResource.Get(), mUploadBuffer.Get(), 0, 0, num2DSubresources, &dataTex);
-	D3DApp::GetApp()->GetCommandList()->ResourceBarrier(1,
-		&CD3DX12_RESOURCE_BARRIER::Transition(mHeightMapResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE)
-	);
 
 	DescriptorHeapAllocation allocation;
 	D3DApp::GetCbvSrvUavAllocate(&allocation, 1);
-
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Format = descTex.Format;
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MipLevels = descTex.MipLevels;
-
-	D3DApp::GetApp()->GetDevice()->CreateShaderResourceView(mHeightMapResource.Get(), &srvDesc, allocation.cpuHandle);
 	mSrv = allocation.gpuHandle;
 
-	mTexture = std::make_unique<TerrainTexture>(mHeightMapResource, mUploadBuffer, mSrv);
+	mTexture = std::make_unique<TerrainTexture>(mHeightMapResource, mUploadBuffer, allocation);
 
 	//for (int i = 0; i < mTexture->Height(); ++i)
 	//{
@@ -102,11 +80,14 @@ void Terrain::BuildTerrainMesh()
 	//GeometryGenerator geoGen;
 	//GeometryGenerator::MeshData grid = geoGen.CreateTerrain(mTexture->Width(), mTexture->Height(), mTexture->Width() / 16, mTexture->Height() / 16);
 	
-	float MeshDownScale = 16;//
-	//float HeightScale = 50;//߶
+	float MeshDownScale = (float)mMeshDownScale;
+	//float HeightScale = 50;//高度缩放
 
 	float width = mTexture->Width(), height = mTexture->Height();
-	float m = width / MeshDownScale, n = height / MeshDownScale;
+	//顶点数取整，行跨度是m，压缩顶点在shader里按同样的规则从SV_VertexID还原行列
+	UINT m = std::max<UINT>(mTexture->Width() / mMeshDownScale, 2), n = std::max<UINT>(mTexture->Height() / mMeshDownScale, 2);
+	mGridColumns = m;
+	mGridRows = n;
 
 	uint32_t vertexCount = m * n;
 	uint32_t quadFaceCount = (m - 1) * (n - 1);
@@ -120,7 +101,9 @@ void Terrain::BuildTerrainMesh()
 	float du = 1.0f / (m - 1);
 	float dv = 1.0f / (n - 1);
 
-	std::vector<TerrainVertex> vertices(vertexCount);
+	//压缩顶点只存高度，x/z和uv都是网格的函数
+	std::vector<TerrainVertex> vertices(mPackedVertices ? 0 : vertexCount);
+	std::vector<PackedTerrainVertex> packedVertices(mPackedVertices ? vertexCount : 0);
 	for (uint32_t i = 0; i < n; ++i)
 	{
 		float z = -halfHeight + i * dz;
@@ -130,10 +113,16 @@ void Terrain::BuildTerrainMesh()
 
 			float height = GetHeightMapValue({ static_cast<int>(j * MeshDownScale), static_cast<int>(i * MeshDownScale) }).y * mHeightScale;
 
-			vertices[i*n + j].position = DirectX::XMFLOAT3(x, height, z);
+			if (mPackedVertices)
+			{
+				packedVertices[i*m + j].height = FloatToUnorm16(height / mHeightScale);
+				continue;
+			}
+
+			vertices[i*m + j].position = DirectX::XMFLOAT3(x, height, z);
 
-			vertices[i*n + j].uv.x = j * du;
-			vertices[i*n + j].uv.y = i * dv;
+			vertices[i*m + j].uv.x = j * du;
+			vertices[i*m + j].uv.y = i * dv;
 		}
 	}
 
@@ -145,23 +134,26 @@ void Terrain::BuildTerrainMesh()
 		for (uint32_t j = 0; j < m - 1; ++j)
 		{
 
-			indices[k] = (i + 1) * n + j;
-			indices[k + 1] = (i + 1) * n + j + 1;
-			indices[k + 2] = i * n + j;
-			indices[k + 3] = i * n + j + 1;
+			indices[k] = (i + 1) * m + j;
+			indices[k + 1] = (i + 1) * m + j + 1;
+			indices[k + 2] = i * m + j;
+			indices[k + 3] = i * m + j + 1;
 
 			k += 4;
 		}
 	}
 
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(TerrainVertex);
+	const UINT vertexStride = mPackedVertices ? sizeof(PackedTerrainVertex) : sizeof(TerrainVertex);
+	const void* vertexData = mPackedVertices ? (const void*)packedVertices.data() : (const void*)vertices.data();
+	const UINT vbByteSize = vertexCount * vertexStride;
 	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint32_t);
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->Name = "TerrainGeo";
 
+	//压缩格式的shader用SV_VertexID重建网格坐标，放进共享几何缓冲后顶点序号会带上BaseVertex偏移，所以地形单独创建缓冲
 	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(D3DApp::GetDevice(),
-		D3DApp::GetCommandList(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
+		D3DApp::GetCommandList(), vertexData, vbByteSize, geo->VertexBufferUploader);
 	geo->VertexBufferGPU->SetName(L"Terrain Vertex Buffer");
 	geo->VertexBufferUploader->SetName(L"Terrain Vertex Buffer Uploader");
 
@@ -170,7 +162,7 @@ void Terrain::BuildTerrainMesh()
 	geo->IndexBufferGPU->SetName(L"Terrain Index Buffer");
 	geo->IndexBufferUploader->SetName(L"Terrain Index Buffer Uploader");
 
-	geo->VertexByteStride = sizeof(TerrainVertex);
+	geo->VertexByteStride = vertexStride;
 	geo->VertexBufferByteSize = vbByteSize;
 	geo->IndexFormat = DXGI_FORMAT_R32_UINT;
 	geo->IndexBufferByteSize = ibByteSize;
@@ -188,11 +180,11 @@ void Terrain::BuildTerrainMesh()
 DirectX::XMFLOAT4 Terrain::GetHeightMapValue(DirectX::XMINT2 index)
 {
 	const int DEPTH = 4;
-	unsigned char* data = mHeightMapData.get();
+	const unsigned char* data = mHeightMapData.data();
 	int x = std::clamp(index.x, 0, static_cast<std::int32_t>(mTexture->Width() - 1));
 	int y = std::clamp(index.y, 0, static_cast<std::int32_t>(mTexture->Height() - 1));
 
-	unsigned char* target = data + (y * mTexture->Width() + x) * DEPTH;
+	const unsigned char* target = data + (y * mTexture->Width() + x) * DEPTH;
 	return { (float)*target / 255.0f, (float)*(target + 1) / 255.0f, (float)*(target + 2) / 255.0f, (float)*(target + 3) / 255.0f };
 }
 }
\ No newline at end of file
@@ -6,8 +6,8 @@
 
 #include "Texture.h"
 
-// ƣ
-// 벼֡ShaderMaterialMesh
+// 非自由限制：
+// 输入布局、Shader、Material、Mesh
 
 
 namespace Soco
@@ -23,24 +23,41 @@ public:
 		DirectX::XMFLOAT2 uv;
 	};
 
+	// 压缩顶点：高度按[0, mHeightScale]存unorm16，x/z和uv由shader从顶点序号算出
+	struct PackedTerrainVertex
+	{
+		uint16_t height;
+		uint16_t padding = 0;
+	};
+
 	class TerrainTexture : public Texture
 	{
 	public:
-		TerrainTexture(Microsoft::WRL::ComPtr<ID3D12Resource>& resource, Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer, CD3DX12_GPU_DESCRIPTOR_HANDLE& gpuHandle)
-			: Texture(resource, uploadBuffer, gpuHandle) {
+		//在allocation处写SRV
+		TerrainTexture(Microsoft::WRL::ComPtr<ID3D12Resource>& resource, Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer, DescriptorHeapAllocation& allocation)
+			: Texture(resource, uploadBuffer, allocation.gpuHandle) {
+			WriteSRV(allocation.cpuHandle);
+			mSrvCreated = true;
 		}
 
 	private:
+		//SRV由Terrain创建，不参与常驻管理
 		virtual void CreateSRV() override {}
+		//无绑定纹理表也通过它写SRV
+		virtual void WriteSRV(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle) override;
 	};
 
 public:
-	Terrain(const char* HeightMapFilename);
+	// meshDownScale：网格顶点间隔多少个高度图像素，越小网格越密
+	// packedVertices：使用PackedTerrainVertex，shader要定义PACKED_VERTEX
+	Terrain(const char* HeightMapFilename, UINT meshDownScale = 16, bool packedVertices = false);
 
 	TerrainTexture* GetTexture() { return mTexture.get(); }
 	MeshGeometry* GetMesh() { return mGeo.get(); }
 	SubmeshGeometry* GetSubmesh() { return &(mGeo->DrawArgs[mSubmeshName]); }
 	float GetHeightScale() { return mHeightScale; }
+	UINT GetGridColumns() { return mGridColumns; }
+	UINT GetGridRows() { return mGridRows; }
 
 private:
 	void LoadHeightMap(const char* HeightMapFilename);
@@ -54,12 +71,16 @@ private:
 	Microsoft::WRL::ComPtr<ID3D12Resource> mHeightMapResource;
 	CD3DX12_GPU_DESCRIPTOR_HANDLE mSrv;
 	Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
-	std::unique_ptr<unsigned char> mHeightMapData;
+	std::vector<unsigned char> mHeightMapData;
 	std::unique_ptr<TerrainTexture> mTexture;
 
 	std::unique_ptr<MeshGeometry> mGeo;
 	const std::string mSubmeshName = "grid";
 	const float mHeightScale = 200;
+	const UINT mMeshDownScale;
+	const bool mPackedVertices;
+	UINT mGridColumns = 0;
+	UINT mGridRows = 0;
 
 };
 }
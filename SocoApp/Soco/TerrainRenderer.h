@@ -3,8 +3,8 @@
 #include "MeshRenderer.h"
 #include "Terrain.h"
 
-//
-//׼ĶݣҪͨShader
+//依赖梳理
+//准备的顶点数据，需要通过Shader布局
 
 namespace Soco
 {
@@ -14,6 +14,8 @@ struct TerrainObjectConstants
 	float texWidth;
 	float texHeight;
 	float height;
+	float gridColumns;
+	float gridRows;
 };
 
 class TerrainRenderer : public MeshRenderer
@@ -32,6 +34,8 @@ public:
 			terrainOC->texHeight = terrain->GetTexture()->Height();
 			terrainOC->texWidth = terrain->GetTexture()->Width();
 			terrainOC->height = terrain->GetHeightScale();
+			terrainOC->gridColumns = (float)terrain->GetGridColumns();
+			terrainOC->gridRows = (float)terrain->GetGridRows();
 		}
 		
 		//SetPrimitiveType(D3D_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST);
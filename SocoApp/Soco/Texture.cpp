@@ -1 +1,57 @@
 #include "Texture.h"
+#include "MipGenerator.h"
+#include "BindlessTextureTable.h"
+
+namespace Soco
+{
+
+Texture::Texture(const std::string& name, const uint8_t* pixels, UINT width, UINT height, const MipChainOptions& options)
+	: Name(name)
+{
+	SOCO_PROFILE_SCOPE("CreatePixelTexture");
+	MipGenerator::GetInstance()->CreateTexture(D3DApp::GetCommandList(), pixels, width, height, options,
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, Resource, UploadHeap);
+	mSrvFormat = MipGenerator::GetSrvFormat(options.Srgb);
+	Resource->SetName(std::wstring(name.begin(), name.end()).c_str());
+}
+
+Texture::Texture(const std::string& name, const uint8_t* pixels, UINT width, UINT height, const MipChainOptions& options, BCFormat compression)
+	: Name(name)
+{
+	SOCO_PROFILE_SCOPE("CreateCompressedTexture");
+	const bool compressed = MipGenerator::GetInstance()->CreateCompressedTexture(D3DApp::GetCommandList(), pixels, width, height, options, compression,
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, Resource, UploadHeap);
+	//压缩格式直接用资源格式作为SRV格式，退回未压缩时和上面一样
+	mSrvFormat = compressed ? DXGI_FORMAT_UNKNOWN : MipGenerator::GetSrvFormat(options.Srgb);
+	Resource->SetName(std::wstring(name.begin(), name.end()).c_str());
+}
+
+Texture::~Texture()
+{
+	if (mBindlessIndex != InvalidBindlessIndex)
+		BindlessTextureTable::GetInstance()->Release(mBindlessIndex);
+}
+
+//材质可能在录制线程里第一次设置纹理，和SRV()一样双重检查
+uint32_t Texture::BindlessIndex()
+{
+	uint32_t index = mBindlessIndex.load(std::memory_order_acquire);
+	if (index == InvalidBindlessIndex)
+	{
+		std::lock_guard<std::mutex> lock(mSrvMutex);
+		index = mBindlessIndex.load(std::memory_order_relaxed);
+		if (index == InvalidBindlessIndex)
+		{
+			index = BindlessTextureTable::GetInstance()->Register(this);
+			mBindlessIndex.store(index, std::memory_order_release);
+		}
+	}
+	return index;
+}
+
+void Texture::RefreshBindless()
+{
+	BindlessTextureTable::GetInstance()->Refresh(this);
+}
+
+}
@@ -1,14 +1,28 @@
 #pragma once
 #include <string>
+#include <atomic>
+#include <mutex>
 #include "../Common/d3dUtil.h"
 #include "../Common/d3dApp.h"
+#include "Util/Profiler.h"
+#include "Util/MipChain.h"
+#include "../Common/BCEncoder.h"
 //#include "DescriptorHeapManager/DescriptorHeapAllocator.h"
 
 namespace Soco 
 {
+class TextureResidencyManager;
+class BindlessTextureTable;
+
 class Texture
 {
+	//常驻管理会替换Resource并切换SRV
+	friend class TextureResidencyManager;
+	//无绑定纹理表在自己的堆里写SRV
+	friend class BindlessTextureTable;
 public:
+	static constexpr uint32_t InvalidBindlessIndex = ~0u;
+
 	const std::string Name;
 	const std::wstring Filename;
 
@@ -17,30 +31,46 @@ public:
 		return Resource.Get();
 	}
 
+	//多个录制线程可能同时第一次访问SRV，双重检查保证只创建一次
 	CD3DX12_GPU_DESCRIPTOR_HANDLE SRV() 
 	{ 
-		if (!mSrvCreated)
+		if (!mSrvCreated.load(std::memory_order_acquire))
 		{
-			CreateSRV();
-			mSrvCreated = true;
+			std::lock_guard<std::mutex> lock(mSrvMutex);
+			if (!mSrvCreated.load(std::memory_order_relaxed))
+			{
+				CreateSRV();
+				mSrvCreated.store(true, std::memory_order_release);
+			}
 		}
 			
 		return mGpuHandle;
 	}
+
+	//在无绑定纹理表里的下标，第一次访问时分配，之后不再变化；只用于2D纹理
+	uint32_t BindlessIndex();
+
 	UINT Width() { return Resource->GetDesc().Width; }
 	UINT Height() { return Resource->GetDesc().Height; }
 
-	virtual ~Texture() {}
+	virtual ~Texture();
 
 protected:
-	Texture(const std::string name, const std::wstring filename)
+	//maxSize不为0时跳过宽或高超过它的mip
+	Texture(const std::string name, const std::wstring filename, size_t maxSize = 0)
 		: Name(name), Filename(filename)
 	{ 
+		SOCO_PROFILE_SCOPE("LoadDDSTexture");
 		ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(D3DApp::GetApp()->GetDevice(), D3DApp::GetApp()->GetCommandList(),
-			Filename.c_str(), Resource, UploadHeap));
+			Filename.c_str(), Resource, UploadHeap, maxSize));
 		Resource->SetName(filename.c_str());
 	}
 
+	//从RGBA8像素创建，由MipGenerator生成完整的mip链
+	Texture(const std::string& name, const uint8_t* pixels, UINT width, UINT height, const MipChainOptions& options);
+	//同上，每级mip在加载时块压缩
+	Texture(const std::string& name, const uint8_t* pixels, UINT width, UINT height, const MipChainOptions& options, BCFormat compression);
+
 	Texture(Microsoft::WRL::ComPtr<ID3D12Resource>& resource, Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer, CD3DX12_GPU_DESCRIPTOR_HANDLE& gpuHandle)
 	{
 		Resource = resource;
@@ -48,26 +78,48 @@ protected:
 		mGpuHandle = gpuHandle;
 	}
 
-	//뱣֤ڳʼԴ󣬵DelayInit
+	//必须保证在初始化资源后，调用DelayInit
 	Texture() {}
 
 	virtual void CreateSRV() = 0;
+	//按当前Resource在cpuHandle处写SRV，Resource的第0级就是最精细的一级
+	virtual void WriteSRV(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle) = 0;
+	//Resource变了之后重写无绑定纹理表里的SRV
+	void RefreshBindless();
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> Resource = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12Resource> UploadHeap = nullptr;
 	CD3DX12_GPU_DESCRIPTOR_HANDLE mGpuHandle;
+	//资源格式是TYPELESS时SRV用的格式，否则为UNKNOWN，直接用资源格式
+	DXGI_FORMAT mSrvFormat = DXGI_FORMAT_UNKNOWN;
+
+	std::atomic<bool> mSrvCreated = false;
+	std::mutex mSrvMutex;
 
-	bool mSrvCreated = false;
+	//在TextureResidencyManager里的编号，没有注册时为~0u
+	uint32_t mResidencyId = ~0u;
+	std::atomic<uint32_t> mBindlessIndex = InvalidBindlessIndex;
 private:
 
 };
 
-//Texture2DΪShader Resource
+//Texture2D仅作为Shader Resource
 class Texture2D : public Texture
 {
 public:
-	Texture2D(const std::string& name, const std::wstring& filename)
-		: Texture(name, filename)
+	//maxSize不为0时只加载尾部的小mip，更精细的由TextureResidencyManager按屏幕上的需要流式加载
+	Texture2D(const std::string& name, const std::wstring& filename, size_t maxSize = 0)
+		: Texture(name, filename, maxSize)
+	{}
+
+	//像素数据会被复制到上传缓冲，调用后可以释放
+	Texture2D(const std::string& name, const uint8_t* pixels, UINT width, UINT height, const MipChainOptions& options = MipChainOptions())
+		: Texture(name, pixels, width, height, options)
+	{}
+
+	//压缩在CPU上进行，宽高不是4的倍数时退回不压缩
+	Texture2D(const std::string& name, const uint8_t* pixels, UINT width, UINT height, BCFormat compression, const MipChainOptions& options = MipChainOptions())
+		: Texture(name, pixels, width, height, options, compression)
 	{}
 
 private:
@@ -76,15 +128,20 @@ private:
 		DescriptorHeapAllocation allocation;
 		D3DApp::GetCbvSrvUavAllocate(&allocation, 1);
 
+		WriteSRV(allocation.cpuHandle);
+		mGpuHandle = allocation.gpuHandle;
+	}
+
+	virtual void WriteSRV(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle) override
+	{
 		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		srvDesc.Format = Resource->GetDesc().Format;
+		srvDesc.Format = mSrvFormat != DXGI_FORMAT_UNKNOWN ? mSrvFormat : Resource->GetDesc().Format;
 		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 		srvDesc.Texture2D.MostDetailedMip = 0;
 		srvDesc.Texture2D.MipLevels = -1;
 
-		D3DApp::GetDevice()->CreateShaderResourceView(Resource.Get(), &srvDesc, allocation.cpuHandle);
-		mGpuHandle = allocation.gpuHandle;
+		D3DApp::GetDevice()->CreateShaderResourceView(Resource.Get(), &srvDesc, cpuHandle);
 	}
 };
 
@@ -101,6 +158,12 @@ private:
 		DescriptorHeapAllocation allocation;
 		D3DApp::GetCbvSrvUavAllocate(&allocation, 1);
 
+		WriteSRV(allocation.cpuHandle);
+		mGpuHandle = allocation.gpuHandle;
+	}
+
+	virtual void WriteSRV(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle) override
+	{
 		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 		srvDesc.Format = Resource->GetDesc().Format;
 		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
@@ -109,13 +172,12 @@ private:
 		srvDesc.TextureCube.MipLevels = Resource->GetDesc().MipLevels;
 		srvDesc.TextureCube.ResourceMinLODClamp = 0.0f;
 
-		D3DApp::GetDevice()->CreateShaderResourceView(Resource.Get(), &srvDesc, allocation.cpuHandle);
-		mGpuHandle = allocation.gpuHandle;
+		D3DApp::GetDevice()->CreateShaderResourceView(Resource.Get(), &srvDesc, cpuHandle);
 	}
 };
 
 /***
-DsvFormat DSVʽRtvʽUAVʽһ
+DsvFormat DSV格式，不能与Rtv格式、UAV格式一起设置
 */
 
 
@@ -133,17 +195,83 @@ class RenderTexture : public Texture
 public:
 	RenderTexture(UINT Width, UINT Height, RenderTextureFormat& Formats) : mViewFormats(Formats)
 	{
-		assert(Formats.ResourceFormat != DXGI_FORMAT_UNKNOWN && "ԴʽҪ");
-		assert(Formats.SrvFormat != DXGI_FORMAT_UNKNOWN && "SRVʽҪ");
+		assert(Formats.ResourceFormat != DXGI_FORMAT_UNKNOWN && "资源格式需要设置");
+		assert(Formats.SrvFormat != DXGI_FORMAT_UNKNOWN && "SRV格式需要设置");
 		if (Formats.DsvFormat != DXGI_FORMAT_UNKNOWN && (Formats.RtvFormat != DXGI_FORMAT_UNKNOWN || Formats.UavFormat != DXGI_FORMAT_UNKNOWN))
 		{
-			std::cout << "DsvFormat DSVʽRtvʽUAVʽһ" << std::endl;
+			std::cout << "DsvFormat DSV格式，不能与Rtv格式、UAV格式一起设置" << std::endl;
 			assert(0);
 		}
 
 		BuildResource(Width, Height);
 	}
 
+	//放置在外部堆内存(heap + offset)上的纹理，和同一段内存上的其他纹理互为别名，由FrameGraph管理
+	//heap必须是AllocateMemory得到的非committed内存，offset需要满足GetResourceAllocationInfo的对齐
+	RenderTexture(UINT Width, UINT Height, RenderTextureFormat& Formats, D3D12MA::Allocation* heap, UINT64 offset) : mViewFormats(Formats)
+	{
+		assert(Formats.ResourceFormat != DXGI_FORMAT_UNKNOWN && "资源格式需要设置");
+		assert(Formats.SrvFormat != DXGI_FORMAT_UNKNOWN && "SRV格式需要设置");
+		assert(heap != nullptr && "放置纹理需要堆内存");
+
+		D3D12_RESOURCE_DESC texDesc = BuildDesc(Width, Height, mViewFormats);
+		ThrowIfFailed(D3DApp::GetVideoMemoryAllocator()->CreateAliasingResource(
+			heap,
+			offset,
+			&texDesc,
+			D3D12_RESOURCE_STATE_COMMON,
+			nullptr,
+			IID_PPV_ARGS(&Resource)
+		));
+
+		mCurrState = D3D12_RESOURCE_STATE_COMMON;
+		mPlaced = true;
+	}
+
+	//描述符还给各自的堆，之后新建的纹理会复用；调用者保证GPU已经不再使用这张纹理(FrameGraph等在飞的帧执行完才释放)
+	~RenderTexture()
+	{
+		D3DApp::FreeCbvSrvUavAllocate(mSrvAllocation);
+		D3DApp::FreeCbvSrvUavAllocate(mUavAllocation);
+		if (mViewFormats.DsvFormat != DXGI_FORMAT_UNKNOWN)
+			D3DApp::FreeDsvAllocate(mDsvAllocation);
+		else
+			D3DApp::FreeRtvAllocate(mRtvAllocation);
+	}
+
+	//纹理资源描述，FrameGraph用它查询放置需要的大小和对齐
+	static D3D12_RESOURCE_DESC BuildDesc(UINT Width, UINT Height, const RenderTextureFormat& Formats)
+	{
+		D3D12_RESOURCE_DESC texDesc;
+		ZeroMemory(&texDesc, sizeof(D3D12_RESOURCE_DESC));
+		texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		texDesc.Alignment = 0;
+		texDesc.Width = Width;
+		texDesc.Height = Height;
+		texDesc.DepthOrArraySize = 1;
+		texDesc.MipLevels = 1;
+		texDesc.Format = Formats.ResourceFormat;
+		texDesc.SampleDesc.Count = 1;
+		texDesc.SampleDesc.Quality = 0;
+		texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+
+		texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+		if (Formats.UavFormat != DXGI_FORMAT_UNKNOWN)
+		{
+			texDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+		}
+		if (Formats.RtvFormat != DXGI_FORMAT_UNKNOWN)
+		{
+			texDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+		}
+		if (Formats.DsvFormat != DXGI_FORMAT_UNKNOWN)
+		{
+			texDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+		}
+
+		return texDesc;
+	}
+
 	CD3DX12_GPU_DESCRIPTOR_HANDLE UAV()
 	{
 		if (!mUavCreate)
@@ -178,20 +306,35 @@ public:
 	}
 
 	void TransitionTo(ID3D12GraphicsCommandList* cmdList, D3D12_RESOURCE_STATES nextState)
+	{
+		std::vector<D3D12_RESOURCE_BARRIER> barriers;
+		TransitionTo(barriers, nextState);
+		if (!barriers.empty())
+			cmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+	}
+
+	//只把屏障追加到数组里，由调用者和其他屏障合并后一次提交
+	void TransitionTo(std::vector<D3D12_RESOURCE_BARRIER>& barriers, D3D12_RESOURCE_STATES nextState)
 	{
 		if (nextState != mCurrState)
 		{
-			cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Resource.Get(),
-				mCurrState, nextState));
+			barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(Resource.Get(), mCurrState, nextState));
 			mCurrState = nextState;
 		}
 	}
 
+	D3D12_RESOURCE_STATES GetCurrentState() const { return mCurrState; }
+
+	//屏障已经由外部(FrameGraph)发出时，只同步记录的状态
+	void SetCurrentState(D3D12_RESOURCE_STATES state) { mCurrState = state; }
+
 	void Resize(UINT newWidth, UINT newHeight)
 	{
+		assert(!mPlaced && "放置在外部堆上的纹理不能改变大小");
 		if (newWidth != Resource->GetDesc().Width || newHeight != Resource->GetDesc().Height)
 		{
 			BuildResource(newWidth, newHeight);
+			RefreshBindless();
 			mSrvCreated = false;
 			mUavCreate = false;
 			mRtvCreate = false;
@@ -202,32 +345,7 @@ public:
 private:
 	void BuildResource(UINT Width, UINT Height)
 	{
-		D3D12_RESOURCE_DESC texDesc;
-		ZeroMemory(&texDesc, sizeof(D3D12_RESOURCE_DESC));
-		texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-		texDesc.Alignment = 0;
-		texDesc.Width = Width;
-		texDesc.Height = Height;
-		texDesc.DepthOrArraySize = 1;
-		texDesc.MipLevels = 1;
-		texDesc.Format = mViewFormats.ResourceFormat;
-		texDesc.SampleDesc.Count = 1;
-		texDesc.SampleDesc.Quality = 0;
-		texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-
-		texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-		if (mViewFormats.UavFormat != DXGI_FORMAT_UNKNOWN)
-		{
-			texDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-		}
-		if (mViewFormats.RtvFormat != DXGI_FORMAT_UNKNOWN)
-		{
-			texDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
-		}
-		if (mViewFormats.DsvFormat != DXGI_FORMAT_UNKNOWN)
-		{
-			texDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-		}
+		D3D12_RESOURCE_DESC texDesc = BuildDesc(Width, Height, mViewFormats);
 
 		ThrowIfFailed(D3DApp::GetDevice()->CreateCommittedResource(
 			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
@@ -247,6 +365,12 @@ private:
 		if(mSrvAllocation.IsNull())
 			D3DApp::GetCbvSrvUavAllocate(&mSrvAllocation, 1);
 
+		WriteSRV(mSrvAllocation.cpuHandle);
+		mGpuHandle = mSrvAllocation.gpuHandle;
+	}
+
+	virtual void WriteSRV(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle) override
+	{
 		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
 		srvDesc.Format = mViewFormats.SrvFormat;
@@ -254,13 +378,12 @@ private:
 		srvDesc.Texture2D.MostDetailedMip = 0;
 		srvDesc.Texture2D.MipLevels = -1;
 
-		D3DApp::GetDevice()->CreateShaderResourceView(Resource.Get(), &srvDesc, mSrvAllocation.cpuHandle);
-		mGpuHandle = mSrvAllocation.gpuHandle;
+		D3DApp::GetDevice()->CreateShaderResourceView(Resource.Get(), &srvDesc, cpuHandle);
 	}
 
 	void CreateUAV()
 	{
-		assert(mViewFormats.UavFormat != DXGI_FORMAT_UNKNOWN && "UAVʽΪDXGI_FORMAT_UNKNOWN");
+		assert(mViewFormats.UavFormat != DXGI_FORMAT_UNKNOWN && "创建UAV的纹理格式不能为DXGI_FORMAT_UNKNOWN");
 		if(mUavAllocation.IsNull())
 			D3DApp::GetCbvSrvUavAllocate(&mUavAllocation, 1);
 
@@ -275,7 +398,7 @@ private:
 
 	void CreateRTV()
 	{
-		assert(mViewFormats.RtvFormat != DXGI_FORMAT_UNKNOWN && "RTVʽΪDXGI_FORMAT_UNKNOWN");
+		assert(mViewFormats.RtvFormat != DXGI_FORMAT_UNKNOWN && "创建RTV的纹理格式不能为DXGI_FORMAT_UNKNOWN");
 		if(mRtvAllocation.IsNull())
 			D3DApp::GetRtvAllocate(&mRtvAllocation, 1);
 
@@ -290,7 +413,7 @@ private:
 
 	void CreateDsv()
 	{
-		assert(mViewFormats.DsvFormat != DXGI_FORMAT_UNKNOWN && "DSVʽΪDXGI_FORMAT_UNKNOWN");
+		assert(mViewFormats.DsvFormat != DXGI_FORMAT_UNKNOWN && "创建DSV的纹理格式不能为DXGI_FORMAT_UNKNOWN");
 		if(mDsvAllocation.IsNull())
 			D3DApp::GetDsvAllocate(&mDsvAllocation, 1);
 
@@ -309,6 +432,7 @@ private:
 	bool mUavCreate = false;
 	bool mRtvCreate = false;
 	bool mDsvCreate = false;
+	bool mPlaced = false;
 
 	RenderTextureFormat mViewFormats;
 
@@ -13,28 +13,29 @@ public:
 	{
 		DirectX::XMFLOAT2 size = {1, 1};
 		DirectX::XMFLOAT2 offset = {0, 0};
+		//纹理在无绑定纹理表里的下标，由SetTexture写入
+		UINT textureIndex = 0;
+		UINT padding[3] = {};
 	};
 
 
 	TextureRenderer(Texture* texture, DirectX::XMFLOAT2 size = {1, 1}, DirectX::XMFLOAT2 offset = {0, 0})
-		:Renderer(nullptr), mTexture(texture)
+		:Renderer(nullptr), mShader(GetShader())
 	{
-		Soco::ShaderStage ss;
-		ss.vs = "VS";
-		ss.ps = "PS";
-
-		mShader = std::make_unique<Shader>(L"Shaders\\Draw2D.hlsl", nullptr, ss);
 		//mTextureSlot = mShader->GetSlot("MainTex");
 		BuildPSODesc();
 		BuildResource();
 
 		mTexPositionCB.size = size;
 		mTexPositionCB.offset = offset;
+		SetTexture(texture);
 	}
 
 	void SetTexture(Texture* texture)
 	{
 		mTexture = texture;
+		mTexPositionCB.textureIndex = texture->BindlessIndex();
+		mNumFramesDirty = gNumFrameResources;
 	}
 
 	TexPositionCB& GetTexPosCB()
@@ -55,7 +56,6 @@ public:
 	void Setup(ID3D12GraphicsCommandList* cmdList, int currnetFrame)override
 	{
 		cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-		mShader->SetTexture(cmdList, "MainTex", mTexture->SRV());
 
 		if (mResource != nullptr)
 		{
@@ -72,6 +72,7 @@ public:
 
 	void DrawIndexedInstanced(ID3D12GraphicsCommandList* cmdList)
 	{
+		SOCO_STAT_ADD("DrawCalls", 1);
 		cmdList->DrawInstanced(4, 1, 0, 0);
 	}
 
@@ -82,6 +83,7 @@ public:
 	}
 	void SetPipelineState(ID3D12GraphicsCommandList* cmdList)override
 	{
+		SOCO_STAT_ADD("PipelineStateSets", 1);
 		cmdList->SetPipelineState(mPSO.Get());
 	}
 	void SetCBV(ID3D12GraphicsCommandList* cmdList, const std::string& cbName, D3D12_GPU_VIRTUAL_ADDRESS address) override
@@ -90,6 +92,18 @@ public:
 	}
 
 private:
+	//所有TextureRenderer共用一个shader，PSO由PipelineStateManager去重
+	static Shader* GetShader()
+	{
+		static Shader* shader = []() {
+			Soco::ShaderStage ss;
+			ss.vs = "VS";
+			ss.ps = "PS";
+			return new Shader(L"Shaders\\Draw2D.hlsl", nullptr, ss);
+		}();
+		return shader;
+	}
+
 	void BuildPSODesc()
 	{
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC tempPSODesc;
@@ -133,8 +147,8 @@ private:
 	int mNumFramesDirty = gNumFrameResources;
 	const char* mTexPositionCBName = "cbTexPosition";
 
-	Texture* mTexture;
-	std::unique_ptr<Shader> mShader;
+	Texture* mTexture = nullptr;
+	Shader* mShader;
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> mPSO;
 	std::unique_ptr<UploadBuffer> mResource = nullptr;
 	TexPositionCB mTexPositionCB;
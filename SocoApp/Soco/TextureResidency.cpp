@@ -0,0 +1,520 @@
+#include "TextureResidency.h"
+
+#include <algorithm>
+#include "Util/MipStreaming.h"
+#include "Util/Stats.h"
+#include "BindlessTextureTable.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace Soco
+{
+
+namespace
+{
+
+bool IsBlockCompressed(DXGI_FORMAT format)
+{
+	return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM)
+		|| (format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+}
+
+UINT64 MipExtent(UINT64 size, UINT mip)
+{
+	return std::max<UINT64>(size >> mip, 1);
+}
+
+}
+
+void TextureResidencyManager::Initialize(ID3D12Device* device, IDXGIAdapter1* adapter, UINT64 budgetBytes, UINT framesInFlight)
+{
+	mDevice = device;
+	mDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	//其它资源(几何、渲染目标、常量缓冲)也要用本地显存，纹理默认只用预算的一半
+	ComPtr<IDXGIAdapter3> adapter3;
+	if (budgetBytes == 0 && adapter != nullptr && SUCCEEDED(adapter->QueryInterface(IID_PPV_ARGS(&adapter3))))
+	{
+		DXGI_QUERY_VIDEO_MEMORY_INFO info = {};
+		if (SUCCEEDED(adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info)))
+			budgetBytes = info.Budget / 2;
+	}
+
+	ResidencyPolicyConfig config;
+	config.ProtectFrames = framesInFlight;
+	mPolicy.SetConfig(config);
+	SetBudget(budgetBytes);
+
+	mStopLoader = false;
+	mLoader = std::thread(&TextureResidencyManager::LoaderThread, this);
+}
+
+void TextureResidencyManager::Shutdown()
+{
+	if (mLoader.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mLoadMutex);
+			mStopLoader = true;
+		}
+		mLoadCondition.notify_one();
+		mLoader.join();
+	}
+	mLoadQueue.clear();
+	mLoads.clear();
+
+	mRetired.clear();
+	mPending.clear();
+	mRecords.clear();
+	mDevice = nullptr;
+}
+
+void TextureResidencyManager::SetBudget(UINT64 budgetBytes)
+{
+	ResidencyPolicyConfig config = mPolicy.GetConfig();
+	config.BudgetBytes = budgetBytes != 0 ? budgetBytes : UINT64_MAX;
+	mPolicy.SetConfig(config);
+
+	if (budgetBytes != 0)
+		std::cout << "纹理显存预算：" << budgetBytes / (1024 * 1024) << "MB" << std::endl;
+	else
+		std::cout << "纹理显存预算：不限制" << std::endl;
+}
+
+void TextureResidencyManager::SetStreamingUploadBudget(UINT64 bytesPerFrame)
+{
+	ResidencyPolicyConfig config = mPolicy.GetConfig();
+	config.MaxPromoteBytesPerFrame = bytesPerFrame != 0 ? bytesPerFrame : UINT64_MAX;
+	mPolicy.SetConfig(config);
+}
+
+void TextureResidencyManager::Register(Texture* texture)
+{
+	assert(mDevice != nullptr && "TextureResidencyManager没有初始化");
+	assert(!texture->Filename.empty() && "只有从DDS文件加载的纹理可以降级后重新加载");
+	assert(texture->mResidencyId == ResidencyPolicy::InvalidId);
+
+	//启动时可能只加载了尾部的mip，完整mip链的大小从文件头读
+	D3D12_RESOURCE_DESC desc;
+	ThrowIfFailed(DirectX::GetDDSTextureDescFromFile12(texture->Filename.c_str(), desc));
+	const D3D12_RESOURCE_DESC residentDesc = texture->Resource->GetDesc();
+	assert(residentDesc.MipLevels <= desc.MipLevels && residentDesc.Format == desc.Format && "纹理资源与文件不一致");
+	const UINT residentMip = desc.MipLevels - residentDesc.MipLevels;
+
+	Record record;
+	record.Tex = texture;
+	record.Width = desc.Width;
+	record.Height = desc.Height;
+	record.MipCount = desc.MipLevels;
+	record.ArraySize = desc.DepthOrArraySize;
+	record.TailMip = residentMip;
+
+	//每级mip的大小按拷贝布局算，包括所有数组层
+	std::vector<uint64_t> mipBytes(record.MipCount, 0);
+	for (UINT mip = 0; mip < record.MipCount; ++mip)
+	{
+		for (UINT slice = 0; slice < record.ArraySize; ++slice)
+		{
+			UINT64 bytes = 0;
+			mDevice->GetCopyableFootprints(&desc, D3D12CalcSubresource(mip, slice, 0, record.MipCount, record.ArraySize), 1, 0,
+				nullptr, nullptr, nullptr, &bytes);
+			mipBytes[mip] += bytes;
+		}
+	}
+
+	//BC格式的纹理宽高要是4的倍数，最精细的一级只能降到宽高仍是4的倍数的那一级
+	UINT maxMostDetailedMip = record.MipCount - 1;
+	if (IsBlockCompressed(desc.Format))
+	{
+		while (maxMostDetailedMip > 0 && (MipExtent(record.Width, maxMostDetailedMip) % 4 != 0 || MipExtent(record.Height, maxMostDetailedMip) % 4 != 0))
+			--maxMostDetailedMip;
+	}
+	maxMostDetailedMip = std::max(maxMostDetailedMip, residentMip);
+
+	const uint32_t id = mPolicy.Register(mipBytes.data(), record.MipCount, maxMostDetailedMip, residentMip, mFrame);
+	if (id >= mRecords.size())
+		mRecords.resize(id + 1);
+	while (mRequestedDensity.size() < mRecords.size())
+		mRequestedDensity.emplace_back(0);
+	mRequestedDensity[id].store(0, std::memory_order_relaxed);
+
+	//Allocate会写满传入的数组，两个槽只记第一个
+	DescriptorHeapAllocation slots[2];
+	D3DApp::GetCbvSrvUavAllocate(slots, 2);
+	record.Srv = slots[0];
+	texture->WriteSRV(record.Srv.cpuHandle);
+	texture->mGpuHandle = record.Srv.gpuHandle;
+	texture->mSrvCreated.store(true, std::memory_order_release);
+	texture->mResidencyId = id;
+	mRecords[id] = record;
+}
+
+void TextureResidencyManager::BeginFrame(ID3D12GraphicsCommandList* cmdList)
+{
+	SOCO_PROFILE_SCOPE("TextureResidency");
+	++mFrame;
+
+	ApplyFinishedLoads(cmdList);
+	ApplyDensityRequests();
+
+	for (const ResidencyChange& change : mPolicy.Update(mFrame))
+	{
+		Record& record = mRecords[change.Texture];
+		mPolicy.SetBusy(change.Texture, true);
+
+		//加载完成、拷贝在GPU上执行完之前一直保持Busy
+		if (change.NewMostDetailedMip < change.OldMostDetailedMip)
+		{
+			StartLoad(change.Texture, change.OldMostDetailedMip, change.NewMostDetailedMip);
+			SOCO_STAT_ADD("TexturePromotions", 1);
+			continue;
+		}
+
+		if (change.NewMostDetailedMip > change.OldMostDetailedMip)
+		{
+			Swap(record, Demote(cmdList, record, change.OldMostDetailedMip, change.NewMostDetailedMip));
+			SOCO_STAT_ADD("TextureDemotions", 1);
+		}
+
+		//降级的拷贝和在飞的帧都还要读这个资源，换出等到它们执行完
+		if (change.NewEvicted && !change.OldEvicted)
+		{
+			record.PendingEvict = true;
+			SOCO_STAT_ADD("TextureEvictions", 1);
+		}
+
+		mPending.push_back({ change.Texture, 0 });
+	}
+
+	PublishStats();
+}
+
+void TextureResidencyManager::ApplyDensityRequests()
+{
+	for (uint32_t id = 0; id < mRecords.size(); ++id)
+	{
+		Record& record = mRecords[id];
+		if (record.Tex == nullptr)
+			continue;
+
+		const uint32_t bits = mRequestedDensity[id].exchange(0, std::memory_order_relaxed);
+		if (bits != 0)
+		{
+			float pixelsPerUv;
+			memcpy(&pixelsPerUv, &bits, sizeof(pixelsPerUv));
+			record.Streamed = true;
+			mPolicy.SetWantedMip(id, EstimateMipLevel(record.Width, record.Height, record.MipCount, pixelsPerUv), mFrame);
+		}
+		else if (record.Streamed)
+		{
+			//这一帧没有物体需要它，精细的mip要连续TrimAfterFrames帧用不上才丢
+			mPolicy.SetWantedMip(id, record.TailMip, mFrame);
+		}
+	}
+}
+
+ComPtr<ID3D12Resource> TextureResidencyManager::Demote(ID3D12GraphicsCommandList* cmdList, Record& record, UINT oldMip, UINT newMip)
+{
+	ID3D12Resource* oldResource = record.Tex->Resource.Get();
+	const UINT oldMipCount = record.MipCount - oldMip;
+	const UINT newMipCount = record.MipCount - newMip;
+
+	D3D12_RESOURCE_DESC desc = oldResource->GetDesc();
+	desc.Alignment = 0;
+	desc.Width = MipExtent(record.Width, newMip);
+	desc.Height = (UINT)MipExtent(record.Height, newMip);
+	desc.MipLevels = (UINT16)newMipCount;
+
+	ComPtr<ID3D12Resource> resource;
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&desc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(resource.GetAddressOf())));
+	resource->SetName(record.Tex->Filename.c_str());
+
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(oldResource,
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE));
+
+	for (UINT slice = 0; slice < record.ArraySize; ++slice)
+	{
+		for (UINT mip = 0; mip < newMipCount; ++mip)
+		{
+			CD3DX12_TEXTURE_COPY_LOCATION dst(resource.Get(), D3D12CalcSubresource(mip, slice, 0, newMipCount, record.ArraySize));
+			CD3DX12_TEXTURE_COPY_LOCATION src(oldResource, D3D12CalcSubresource(mip + newMip - oldMip, slice, 0, oldMipCount, record.ArraySize));
+			cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+		}
+	}
+	UINT64 bytes = 0;
+	mDevice->GetCopyableFootprints(&desc, 0, newMipCount * record.ArraySize, 0, nullptr, nullptr, nullptr, &bytes);
+	mBytesCopied += bytes;
+
+	//旧资源可能还要被换出，恢复成和其它纹理一样的状态
+	D3D12_RESOURCE_BARRIER toRead[] = {
+		CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+		CD3DX12_RESOURCE_BARRIER::Transition(oldResource, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+	};
+	cmdList->ResourceBarrier(_countof(toRead), toRead);
+	return resource;
+}
+
+void TextureResidencyManager::StartLoad(uint32_t id, UINT oldMip, UINT newMip)
+{
+	Record& record = mRecords[id];
+	const UINT newMipCount = record.MipCount - newMip;
+	const UINT addedMips = oldMip - newMip;
+
+	auto load = std::make_unique<StreamLoad>();
+	load->Id = id;
+	load->Filename = record.Tex->Filename;
+	load->MipCount = record.MipCount;
+	load->ArraySize = record.ArraySize;
+	load->OldMip = oldMip;
+	load->NewMip = newMip;
+
+	D3D12_RESOURCE_DESC desc = record.Tex->Resource->GetDesc();
+	desc.Alignment = 0;
+	desc.Width = MipExtent(record.Width, newMip);
+	desc.Height = (UINT)MipExtent(record.Height, newMip);
+	desc.MipLevels = (UINT16)newMipCount;
+
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&desc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(load->Resource.GetAddressOf())));
+	load->Resource->SetName(record.Tex->Filename.c_str());
+
+	//上传缓冲只放新增的mip，已有的mip在GPU上从旧纹理拷贝
+	load->Layouts.resize(addedMips * record.ArraySize);
+	load->NumRows.resize(addedMips * record.ArraySize);
+	load->RowSizes.resize(addedMips * record.ArraySize);
+	for (UINT slice = 0; slice < record.ArraySize; ++slice)
+	{
+		const UINT first = slice * addedMips;
+		mDevice->GetCopyableFootprints(&desc, D3D12CalcSubresource(0, slice, 0, newMipCount, record.ArraySize), addedMips, load->UploadBytes,
+			&load->Layouts[first], &load->NumRows[first], &load->RowSizes[first], nullptr);
+		//下一层从这一层最后一个mip之后开始，偏移要按512对齐
+		const UINT last = first + addedMips - 1;
+		const D3D12_SUBRESOURCE_FOOTPRINT& footprint = load->Layouts[last].Footprint;
+		const UINT64 end = load->Layouts[last].Offset + (UINT64)footprint.RowPitch * load->NumRows[last] * footprint.Depth;
+		load->UploadBytes = (end + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~(UINT64)(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+	}
+
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(load->UploadBytes),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(load->Upload.GetAddressOf())));
+	ThrowIfFailed(load->Upload->Map(0, nullptr, reinterpret_cast<void**>(&load->MappedUpload)));
+	SOCO_STAT_ADD("UploadBufferBytes", load->UploadBytes);
+
+	{
+		std::lock_guard<std::mutex> lock(mLoadMutex);
+		mLoadQueue.push_back(load.get());
+	}
+	mLoadCondition.notify_one();
+	mLoads.push_back(std::move(load));
+}
+
+void TextureResidencyManager::LoaderThread()
+{
+	for (;;)
+	{
+		StreamLoad* load = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mLoadMutex);
+			mLoadCondition.wait(lock, [this]() { return mStopLoader || !mLoadQueue.empty(); });
+			if (mStopLoader)
+				return;
+			load = mLoadQueue.front();
+			mLoadQueue.pop_front();
+		}
+
+		SOCO_PROFILE_SCOPE("StreamTextureMips");
+		std::unique_ptr<uint8_t[]> ddsData;
+		D3D12_RESOURCE_DESC desc;
+		std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+		HRESULT hr = DirectX::LoadDDSTextureDataFromFile12(load->Filename.c_str(), ddsData, desc, subresources);
+		//文件在注册之后被改过
+		if (SUCCEEDED(hr) && (desc.MipLevels != load->MipCount || desc.DepthOrArraySize != load->ArraySize))
+			hr = E_FAIL;
+
+		if (SUCCEEDED(hr))
+		{
+			const UINT addedMips = load->OldMip - load->NewMip;
+			for (UINT slice = 0; slice < load->ArraySize; ++slice)
+			{
+				for (UINT mip = 0; mip < addedMips; ++mip)
+				{
+					const UINT i = slice * addedMips + mip;
+					const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& layout = load->Layouts[i];
+					D3D12_MEMCPY_DEST dst = { load->MappedUpload + layout.Offset, layout.Footprint.RowPitch,
+						(SIZE_T)layout.Footprint.RowPitch * load->NumRows[i] };
+					const D3D12_SUBRESOURCE_DATA& src = subresources[D3D12CalcSubresource(load->NewMip + mip, slice, 0, load->MipCount, load->ArraySize)];
+					MemcpySubresource(&dst, &src, (SIZE_T)load->RowSizes[i], load->NumRows[i], layout.Footprint.Depth);
+				}
+			}
+		}
+
+		load->Result = hr;
+		load->Done.store(true, std::memory_order_release);
+	}
+}
+
+void TextureResidencyManager::ApplyFinishedLoads(ID3D12GraphicsCommandList* cmdList)
+{
+	auto end = std::remove_if(mLoads.begin(), mLoads.end(), [this, cmdList](const std::unique_ptr<StreamLoad>& load) {
+		if (!load->Done.load(std::memory_order_acquire))
+			return false;
+		ThrowIfFailed(load->Result);
+
+		Record& record = mRecords[load->Id];
+		ID3D12Resource* oldResource = record.Tex->Resource.Get();
+		const UINT addedMips = load->OldMip - load->NewMip;
+		const UINT newMipCount = record.MipCount - load->NewMip;
+		const UINT oldMipCount = record.MipCount - load->OldMip;
+
+		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(oldResource,
+			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE));
+
+		for (UINT slice = 0; slice < record.ArraySize; ++slice)
+		{
+			for (UINT mip = 0; mip < addedMips; ++mip)
+			{
+				CD3DX12_TEXTURE_COPY_LOCATION dst(load->Resource.Get(), D3D12CalcSubresource(mip, slice, 0, newMipCount, record.ArraySize));
+				CD3DX12_TEXTURE_COPY_LOCATION src(load->Upload.Get(), load->Layouts[slice * addedMips + mip]);
+				cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+			}
+			for (UINT mip = 0; mip < oldMipCount; ++mip)
+			{
+				CD3DX12_TEXTURE_COPY_LOCATION dst(load->Resource.Get(), D3D12CalcSubresource(mip + addedMips, slice, 0, newMipCount, record.ArraySize));
+				CD3DX12_TEXTURE_COPY_LOCATION src(oldResource, D3D12CalcSubresource(mip, slice, 0, oldMipCount, record.ArraySize));
+				cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+			}
+		}
+
+		D3D12_RESOURCE_BARRIER toRead[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(load->Resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(oldResource, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+		};
+		cmdList->ResourceBarrier(_countof(toRead), toRead);
+		mBytesStreamed += load->UploadBytes;
+
+		Retire(load->Upload);
+		Swap(record, load->Resource);
+		mPending.push_back({ load->Id, 0 });
+		return true;
+	});
+	mLoads.erase(end, mLoads.end());
+}
+
+void TextureResidencyManager::Swap(Record& record, ComPtr<ID3D12Resource> resource)
+{
+	Texture* texture = record.Tex;
+	Retire(texture->Resource);
+	texture->Resource = resource;
+
+	//录制线程还没开始，可以直接改句柄；旧槽在飞的帧还在读，写到另一个槽
+	record.Slot ^= 1;
+	CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(record.Srv.cpuHandle, record.Slot, mDescriptorSize);
+	texture->WriteSRV(cpuHandle);
+	texture->mGpuHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(record.Srv.gpuHandle, record.Slot, mDescriptorSize);
+	//通过下标访问的材质不用改，只更新表里的SRV
+	BindlessTextureTable::GetInstance()->Refresh(texture);
+}
+
+void TextureResidencyManager::Retire(ComPtr<ID3D12Resource> resource)
+{
+	mRetired.push_back({ resource, 0 });
+}
+
+void TextureResidencyManager::MakeUsedResident()
+{
+	mMakeResident.clear();
+	for (uint32_t id : mPolicy.RestoreUsedEvicted(mFrame))
+	{
+		Record& record = mRecords[id];
+		//还没来得及换出，取消就行
+		if (record.PendingEvict)
+		{
+			record.PendingEvict = false;
+		}
+		else if (!record.Resident)
+		{
+			mMakeResident.push_back(record.Tex->Resource.Get());
+			record.Resident = true;
+		}
+	}
+
+	//MakeResident会阻塞到资源重新进入显存，只有长时间没用过的纹理才会走到这里
+	if (!mMakeResident.empty())
+	{
+		ThrowIfFailed(mDevice->MakeResident((UINT)mMakeResident.size(), mMakeResident.data()));
+		SOCO_STAT_ADD("TextureRestores", mMakeResident.size());
+	}
+}
+
+void TextureResidencyManager::SetRetireFence(UINT64 fenceValue)
+{
+	for (RetiredResource& retired : mRetired)
+	{
+		if (retired.Fence == 0)
+			retired.Fence = fenceValue;
+	}
+	for (PendingChange& pending : mPending)
+	{
+		if (pending.Fence == 0)
+			pending.Fence = fenceValue;
+	}
+}
+
+void TextureResidencyManager::ReleaseRetired(UINT64 completedFence)
+{
+	auto done = [completedFence](UINT64 fence) { return fence != 0 && fence <= completedFence; };
+
+	mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(), [&done](const RetiredResource& retired) {
+		return done(retired.Fence);
+	}), mRetired.end());
+
+	auto pendingEnd = std::remove_if(mPending.begin(), mPending.end(), [this, &done](const PendingChange& pending) {
+		if (!done(pending.Fence))
+			return false;
+
+		Record& record = mRecords[pending.Id];
+		if (record.PendingEvict)
+		{
+			ID3D12Pageable* pageable = record.Tex->Resource.Get();
+			ThrowIfFailed(mDevice->Evict(1, &pageable));
+			record.PendingEvict = false;
+			record.Resident = false;
+		}
+		mPolicy.SetBusy(pending.Id, false);
+		return true;
+	});
+	mPending.erase(pendingEnd, mPending.end());
+}
+
+void TextureResidencyManager::PublishStats()
+{
+	const ResidencyStats stats = mPolicy.GetStats();
+	SOCO_STAT_GAUGE_SET("TextureResidentBytes", (int64_t)stats.ResidentBytes);
+	SOCO_STAT_GAUGE_SET("TextureBudgetBytes", stats.BudgetBytes == UINT64_MAX ? 0 : (int64_t)stats.BudgetBytes);
+	SOCO_STAT_GAUGE_SET("TexturesFullyResident", stats.FullyResident);
+	SOCO_STAT_GAUGE_SET("TexturesDemoted", stats.Demoted);
+	SOCO_STAT_GAUGE_SET("TexturesEvicted", stats.Evicted);
+	SOCO_STAT_GAUGE_SET("TextureOverBudget", stats.OverBudget ? 1 : 0);
+	SOCO_STAT_GAUGE_SET("TextureStreamingLoads", (int64_t)mLoads.size());
+	SOCO_STAT_ADD("TextureResidencyBytesCopied", mBytesCopied);
+	SOCO_STAT_ADD("TextureStreamedBytes", mBytesStreamed);
+	mBytesCopied = 0;
+	mBytesStreamed = 0;
+}
+
+}
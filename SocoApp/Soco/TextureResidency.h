@@ -0,0 +1,174 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Texture.h"
+#include "Util/ResidencyPolicy.h"
+
+namespace Soco
+{
+
+/*
+纹理常驻管理：按显存预算和每张纹理最后使用的帧号决定保留哪些mip，决策由ResidencyPolicy做，这里负责执行
+降级：新建只包含[m, MipCount)的纹理，从旧纹理拷过去
+升级：后台的加载线程读DDS文件，把新增的mip写进映射好的上传缓冲；之后某一帧的BeginFrame把它们和旧纹理已有的mip拷到新纹理上
+换出：ID3D12Device::Evict，换出的纹理在某一帧又被用到时，提交前MakeResident
+纹理可以启动时只加载尾部的小mip，之后按RequestScreenDensity报告的屏幕纹素密度流式加载需要的mip，每帧新增的mip大小不超过上传预算
+每张纹理有两个SRV槽，变化时在另一个槽写新的SRV再切换；旧槽和旧资源等在飞的帧执行完后才能再用，期间这张纹理不会再变化
+*/
+class TextureResidencyManager
+{
+public:
+	static TextureResidencyManager* GetInstance()
+	{
+		static TextureResidencyManager* instance = new TextureResidencyManager();
+		return instance;
+	}
+
+	// budgetBytes为0时使用显卡本地显存预算的一半，查询不到时不限制；framesInFlight帧内用过的纹理不会被换出
+	void Initialize(ID3D12Device* device, IDXGIAdapter1* adapter, UINT64 budgetBytes, UINT framesInFlight);
+	// 释放所有旧资源，调用前GPU要已经空闲
+	void Shutdown();
+	void SetBudget(UINT64 budgetBytes);
+	// 每帧开始加载的新增mip大小之和的上限，0表示不限制
+	void SetStreamingUploadBudget(UINT64 bytesPerFrame);
+
+	// 只支持从DDS文件加载的纹理，可以只加载了尾部的mip；在主线程注册，之后纹理的Resource和SRV由这里管理
+	void Register(Texture* texture);
+
+	// 录制线程绑定纹理时调用
+	void MarkUsed(Texture* texture)
+	{
+		if (texture->mResidencyId != ResidencyPolicy::InvalidId)
+			mPolicy.MarkUsed(texture->mResidencyId, mFrame);
+	}
+
+	/*
+	用到这张纹理的一个物体在屏幕上每个UV单位覆盖pixelsPerUv个像素，可以在多个线程里调用，每帧取最大值
+	收到过请求的纹理在某一帧没有请求时只需要尾部的mip；从来没有请求的纹理(天空盒等)保持完整精度
+	*/
+	void RequestScreenDensity(Texture* texture, float pixelsPerUv)
+	{
+		if (texture->mResidencyId == ResidencyPolicy::InvalidId || !(pixelsPerUv > 0.0f))
+			return;
+		//正的float按位比较和按值比较的顺序一致
+		uint32_t bits;
+		memcpy(&bits, &pixelsPerUv, sizeof(bits));
+		std::atomic<uint32_t>& requested = mRequestedDensity[texture->mResidencyId];
+		uint32_t current = requested.load(std::memory_order_relaxed);
+		while (bits > current && !requested.compare_exchange_weak(current, bits, std::memory_order_relaxed)) {}
+	}
+
+	// 每帧录制draw之前调用：按预算和屏幕密度降级、开始升级、换出，降级和已加载完的升级的拷贝录制在cmdList里
+	void BeginFrame(ID3D12GraphicsCommandList* cmdList);
+	// 录制之后、ExecuteCommandLists之前调用：这一帧用到的已换出纹理重新MakeResident
+	void MakeUsedResident();
+
+	// 到目前为止录制的命令在GPU到达fenceValue时执行完，此前换下来的资源在那之后释放
+	void SetRetireFence(UINT64 fenceValue);
+	void ReleaseRetired(UINT64 completedFence);
+
+	ResidencyStats GetStats() const { return mPolicy.GetStats(); }
+
+private:
+	struct Record
+	{
+		Texture* Tex = nullptr;
+		// 完整mip链的大小和格式
+		UINT64 Width = 0;
+		UINT Height = 0;
+		UINT MipCount = 0;
+		UINT ArraySize = 0;
+		// 注册时常驻的最精细一级，启动时只加载了尾部mip的纹理大于0
+		UINT TailMip = 0;
+		// 收到过屏幕密度请求
+		bool Streamed = false;
+		// 两个相邻的SRV槽，Slot是当前使用的一个
+		DescriptorHeapAllocation Srv;
+		UINT Slot = 0;
+		// 换出的决定要等旧资源不再被使用后才执行，在那之前又被用到就取消
+		bool PendingEvict = false;
+		bool Resident = true;
+	};
+
+	struct RetiredResource
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		// 0表示还没有SetRetireFence
+		UINT64 Fence = 0;
+	};
+
+	struct PendingChange
+	{
+		uint32_t Id;
+		UINT64 Fence = 0;
+	};
+
+	// 一次升级：主线程建好新纹理和上传缓冲，加载线程读文件写上传缓冲，Done之后由主线程录制拷贝
+	struct StreamLoad
+	{
+		uint32_t Id = 0;
+		std::wstring Filename;
+		UINT MipCount = 0;
+		UINT ArraySize = 0;
+		UINT OldMip = 0;
+		UINT NewMip = 0;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Upload;
+		BYTE* MappedUpload = nullptr;
+		UINT64 UploadBytes = 0;
+		// 新增的mip[NewMip, OldMip)在上传缓冲里的布局，按数组层排列，层内由细到粗
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts;
+		std::vector<UINT> NumRows;
+		std::vector<UINT64> RowSizes;
+		HRESULT Result = S_OK;
+		std::atomic<bool> Done{ false };
+	};
+
+	TextureResidencyManager() {}
+
+	// 把这一帧收到的屏幕密度换算成每张纹理需要的mip
+	void ApplyDensityRequests();
+	// 新建只包含[newMip, MipCount)的纹理，从当前资源拷贝这些mip
+	Microsoft::WRL::ComPtr<ID3D12Resource> Demote(ID3D12GraphicsCommandList* cmdList, Record& record, UINT oldMip, UINT newMip);
+	// 新建只包含[newMip, MipCount)的纹理和新增mip的上传缓冲，交给加载线程
+	void StartLoad(uint32_t id, UINT oldMip, UINT newMip);
+	// 已经加载完的升级：新增的mip从上传缓冲拷贝，其余从当前资源拷贝，然后换成新资源
+	void ApplyFinishedLoads(ID3D12GraphicsCommandList* cmdList);
+	void LoaderThread();
+	// 换成新资源，写另一个SRV槽，旧资源退役
+	void Swap(Record& record, Microsoft::WRL::ComPtr<ID3D12Resource> resource);
+	void Retire(Microsoft::WRL::ComPtr<ID3D12Resource> resource);
+	void PublishStats();
+
+	ID3D12Device* mDevice = nullptr;
+	ResidencyPolicy mPolicy;
+	std::vector<Record> mRecords;
+	std::vector<RetiredResource> mRetired;
+	std::vector<PendingChange> mPending;
+	std::vector<ID3D12Pageable*> mMakeResident;
+	// 每张纹理这一帧收到的最大屏幕密度(float的位)，0表示没有请求；deque扩容时不移动已有元素
+	std::deque<std::atomic<uint32_t>> mRequestedDensity;
+
+	// 读文件会阻塞，放在JobSystem的工作线程上会占住它们，单独用一个加载线程
+	std::vector<std::unique_ptr<StreamLoad>> mLoads;
+	std::deque<StreamLoad*> mLoadQueue;
+	std::mutex mLoadMutex;
+	std::condition_variable mLoadCondition;
+	bool mStopLoader = false;
+	std::thread mLoader;
+
+	UINT mDescriptorSize = 0;
+	// 策略使用的帧号，BeginFrame时加一
+	uint64_t mFrame = 0;
+	UINT64 mBytesCopied = 0;
+	UINT64 mBytesStreamed = 0;
+};
+
+}
@@ -42,6 +42,10 @@ public:
 		DirectX::XMStoreFloat4(&(this->localRotationQuat), quat);
 	}
 
+	void SetLocalRotationQuat(DirectX::XMFLOAT4 quat) {
+		this->localRotationQuat = quat;
+	}
+
 	void SetLocalScale(DirectX::XMFLOAT3 scale) {
 		this->localScale = scale;
 	}
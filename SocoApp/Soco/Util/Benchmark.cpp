@@ -0,0 +1,326 @@
+#include "Benchmark.h"
+#include "Profiler.h"
+#include "Stats.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace Soco
+{
+
+namespace
+{
+
+std::string EscapeJson(const std::string& s)
+{
+	std::string result;
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\')
+			result += '\\';
+		result += c;
+	}
+	return result;
+}
+
+}
+
+bool ParseBenchmarkArgs(const char* cmdLine, BenchmarkConfig& config)
+{
+	const char* benchmark = strstr(cmdLine, "-benchmark");
+	if (benchmark == nullptr)
+		return false;
+
+	std::istringstream args(benchmark + strlen("-benchmark"));
+	std::string token;
+	while (args >> token)
+	{
+		//遇到下一个-开头的选项为止
+		if (token[0] == '-')
+			break;
+
+		size_t eq = token.find('=');
+		if (eq == std::string::npos)
+		{
+			std::cout << "benchmark参数格式应为key=value：" << token << std::endl;
+			continue;
+		}
+
+		std::string key = token.substr(0, eq);
+		std::string value = token.substr(eq + 1);
+		if (key == "frames")
+			config.FrameCount = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+		else if (key == "warmup")
+			config.WarmupFrames = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+		else if (key == "dt")
+			config.FixedDeltaTime = strtod(value.c_str(), nullptr);
+		else if (key == "planets")
+			config.PlanetCount = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+		else if (key == "terrain")
+			config.TerrainDownScale = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+		else if (key == "sprites")
+			config.SpriteCount = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+		else if (key == "script")
+			config.InputScriptPath = value;
+		else if (key == "report")
+			config.ReportPath = value;
+		else if (key == "label")
+			config.Label = value;
+		else if (key == "churn")
+			config.FrameGraphChurn = value != "0";
+		else
+			std::cout << "未知的benchmark参数：" << key << std::endl;
+	}
+
+	//第0帧的计数里有初始化时的上传，至少预热一帧
+	config.WarmupFrames = std::max<uint32_t>(config.WarmupFrames, 1);
+	config.TerrainDownScale = std::max<uint32_t>(config.TerrainDownScale, 1);
+	if (config.FixedDeltaTime <= 0.0)
+		config.FixedDeltaTime = 1.0 / 60.0;
+	return true;
+}
+
+bool InputScript::Load(const std::string& path)
+{
+	std::ifstream in(path);
+	if (!in)
+	{
+		std::cout << "无法打开输入脚本：" << path << std::endl;
+		return false;
+	}
+	return Parse(in);
+}
+
+bool InputScript::Parse(std::istream& in)
+{
+	mEvents.clear();
+	mNext = 0;
+
+	std::string line;
+	uint32_t lineNumber = 0;
+	while (std::getline(in, line))
+	{
+		++lineNumber;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.resize(comment);
+
+		std::istringstream fields(line);
+		uint32_t frame;
+		std::string keyName, action;
+		if (!(fields >> frame))
+			continue;
+
+		int key = (fields >> keyName >> action) ? ParseKey(keyName) : -1;
+		if (key < 0 || (action != "down" && action != "up" && action != "tap"))
+		{
+			std::cout << "输入脚本第" << lineNumber << "行无法解析：" << line << std::endl;
+			return false;
+		}
+
+		AddEvent(frame, (uint8_t)key, action != "up");
+		if (action == "tap")
+			AddEvent(frame + 1, (uint8_t)key, false);
+	}
+
+	//同一帧内保持脚本中的顺序
+	std::stable_sort(mEvents.begin(), mEvents.end(),
+		[](const ScriptedKeyEvent& a, const ScriptedKeyEvent& b) { return a.Frame < b.Frame; });
+	return true;
+}
+
+void InputScript::LoadDefault(uint32_t warmupFrames, uint32_t frameCount)
+{
+	mEvents.clear();
+	mNext = 0;
+
+	//按键码和DirectX::Keyboard::Keys相同：'1'是D1，'2'是D2
+	const uint32_t begin = warmupFrames;
+	AddEvent(begin + frameCount / 4, '2', true);
+	AddEvent(begin + frameCount / 4 + 1, '2', false);
+	AddEvent(begin + frameCount / 2, '1', true);
+	AddEvent(begin + frameCount / 2 + 1, '1', false);
+	AddEvent(begin + frameCount * 3 / 4, '2', true);
+	AddEvent(begin + frameCount * 3 / 4 + 1, '2', false);
+	AddEvent(begin + frameCount * 7 / 8, '1', true);
+	AddEvent(begin + frameCount * 7 / 8 + 1, '1', false);
+
+	std::stable_sort(mEvents.begin(), mEvents.end(),
+		[](const ScriptedKeyEvent& a, const ScriptedKeyEvent& b) { return a.Frame < b.Frame; });
+}
+
+void InputScript::Apply(uint32_t frame, std::bitset<256>& keys)
+{
+	while (mNext < mEvents.size() && mEvents[mNext].Frame <= frame)
+	{
+		const ScriptedKeyEvent& e = mEvents[mNext++];
+		keys[e.Key] = e.Down;
+	}
+}
+
+int InputScript::ParseKey(const std::string& name)
+{
+	if (name.size() == 1 && isalnum((unsigned char)name[0]))
+		return toupper((unsigned char)name[0]);
+
+	static const std::pair<const char*, int> names[] =
+	{
+		{ "Tab", 0x09 }, { "Enter", 0x0D }, { "Escape", 0x1B }, { "Space", 0x20 },
+		{ "Left", 0x25 }, { "Up", 0x26 }, { "Right", 0x27 }, { "Down", 0x28 },
+		{ "LeftShift", 0xA0 }, { "RightShift", 0xA1 }, { "LeftControl", 0xA2 }, { "RightControl", 0xA3 },
+	};
+	for (auto& [keyName, code] : names)
+	{
+		if (name == keyName)
+			return code;
+	}
+
+	char* end = nullptr;
+	long code = strtol(name.c_str(), &end, 10);
+	return (*end == '\0' && code > 0 && code < 256) ? (int)code : -1;
+}
+
+void InputScript::AddEvent(uint32_t frame, uint8_t key, bool down)
+{
+	ScriptedKeyEvent e;
+	e.Frame = frame;
+	e.Key = key;
+	e.Down = down;
+	mEvents.push_back(e);
+}
+
+Benchmark::Benchmark(const BenchmarkConfig& config)
+	: mConfig(config)
+{
+	const bool loaded = !mConfig.InputScriptPath.empty() && mScript.Load(mConfig.InputScriptPath);
+	//churn自己切换后处理，内置脚本的切换会打乱它和上一轮同一时刻的比较
+	if (!loaded && !mConfig.FrameGraphChurn)
+		mScript.LoadDefault(mConfig.WarmupFrames, mConfig.FrameCount);
+
+	mFrameTimes.reserve(mConfig.FrameCount);
+}
+
+void Benchmark::BeginFrame(std::bitset<256>& keys)
+{
+	mScript.Apply(mFrameIndex, keys);
+
+	if (IsFirstMeasuredFrame())
+		StatsRegistry::GetInstance()->ResetTotals();
+}
+
+void Benchmark::EndFrame(uint64_t frameTime, const ProfileFrame* profile)
+{
+	if (!IsWarmingUp() && !IsFinished())
+	{
+		mFrameTimes.push_back(frameTime * 1e-6);
+
+		if (profile != nullptr)
+		{
+			for (const ProfileZoneStats& zone : profile->Zones)
+				mZoneTimes[zone.Name].push_back(zone.TotalTime * 1e-6);
+		}
+	}
+
+	++mFrameIndex;
+}
+
+BenchmarkDistribution Benchmark::Summarize(std::vector<double> samples)
+{
+	BenchmarkDistribution d;
+	d.Samples = samples.size();
+	if (samples.empty())
+		return d;
+
+	std::sort(samples.begin(), samples.end());
+	d.Min = samples.front();
+	d.Max = samples.back();
+
+	double sum = 0.0;
+	for (double sample : samples)
+		sum += sample;
+	d.Avg = sum / samples.size();
+
+	double variance = 0.0;
+	for (double sample : samples)
+		variance += (sample - d.Avg) * (sample - d.Avg);
+	d.StdDev = std::sqrt(variance / samples.size());
+
+	//不小于p%样本的最小值
+	auto percentile = [&samples](size_t p) { return samples[(samples.size() * p + 99) / 100 - 1]; };
+	d.P50 = percentile(50);
+	d.P90 = percentile(90);
+	d.P99 = percentile(99);
+	return d;
+}
+
+void Benchmark::WriteDistribution(std::ostream& out, const BenchmarkDistribution& d)
+{
+	out << "{\"min\":" << d.Min << ",\"avg\":" << d.Avg << ",\"stddev\":" << d.StdDev << ",\"p50\":" << d.P50
+		<< ",\"p90\":" << d.P90 << ",\"p99\":" << d.P99 << ",\"max\":" << d.Max << ",\"samples\":" << d.Samples << "}";
+}
+
+bool Benchmark::WriteReport() const
+{
+	std::ofstream out(mConfig.ReportPath, std::ios::out | std::ios::trunc);
+	if (!out)
+		return false;
+
+	out << std::setprecision(6);
+	out << "{\n";
+	out << "\"label\":\"" << EscapeJson(mConfig.Label) << "\",\n";
+	out << "\"config\":{\"frames\":" << mConfig.FrameCount << ",\"warmup\":" << mConfig.WarmupFrames
+		<< ",\"dt\":" << mConfig.FixedDeltaTime << ",\"planets\":" << mConfig.PlanetCount
+		<< ",\"terrain\":" << mConfig.TerrainDownScale << ",\"sprites\":" << mConfig.SpriteCount << ",\"script\":\"" << EscapeJson(mConfig.InputScriptPath)
+		<< "\",\"churn\":" << (mConfig.FrameGraphChurn ? 1 : 0) << "},\n";
+
+	out << "\"frameTimeMs\":";
+	WriteDistribution(out, Summarize(mFrameTimes));
+	out << ",\n";
+
+	out << "\"zonesMs\":{";
+	bool first = true;
+	for (auto& [name, samples] : mZoneTimes)
+	{
+		out << (first ? "\n" : ",\n") << "\"" << EscapeJson(name) << "\":";
+		WriteDistribution(out, Summarize(samples));
+		first = false;
+	}
+	out << "},\n";
+
+	//计数是测量帧的总量，确定性回放下同一份代码每次运行都相同
+	out << "\"totals\":{";
+	first = true;
+	StatsRegistry* stats = StatsRegistry::GetInstance();
+	for (const std::string& name : stats->GetNames())
+	{
+		out << (first ? "\n" : ",\n") << "\"" << EscapeJson(name) << "\":" << stats->GetSummary(name).Total;
+		first = false;
+	}
+	for (auto& [name, value] : mExtraTotals)
+	{
+		out << (first ? "\n" : ",\n") << "\"" << EscapeJson(name) << "\":" << value;
+		first = false;
+	}
+	out << "},\n";
+
+	out << "\"failures\":[";
+	for (size_t i = 0; i < mFailures.size(); ++i)
+		out << (i == 0 ? "" : ",") << "\"" << EscapeJson(mFailures[i]) << "\"";
+	out << "],\n";
+
+	out << "\"frameTimesMs\":[";
+	for (size_t i = 0; i < mFrameTimes.size(); ++i)
+		out << (i == 0 ? "" : ",") << mFrameTimes[i];
+	out << "]\n}\n";
+
+	return (bool)out;
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Soco
+{
+
+struct ProfileFrame;
+
+struct BenchmarkConfig
+{
+	// 预热帧不计入统计，只用来让PSO、上传堆、job线程等进入稳定状态，至少为1
+	uint32_t WarmupFrames = 60;
+	uint32_t FrameCount = 600;
+	// 固定时间步长(秒)，动画和相机路径只由帧号决定
+	double FixedDeltaTime = 1.0 / 60.0;
+	// 场景规模：额外行星数量，地形网格相对高度图的降采样倍数(越小网格越密)，每帧额外提交的2D精灵数量
+	uint32_t PlanetCount = 0;
+	uint32_t TerrainDownScale = 16;
+	uint32_t SpriteCount = 0;
+	// 输入脚本，为空时使用内置脚本
+	std::string InputScriptPath;
+	std::string ReportPath = "BenchmarkReport.json";
+	// 写进报告，用来区分被比较的两个构建
+	std::string Label;
+	// 每隔几帧切换ShadeRed并改变窗口大小，检查FrameGraph的描述符用量不随切换次数增长，这时不使用内置输入脚本
+	bool FrameGraphChurn = false;
+};
+
+/*
+解析命令行中的 -benchmark key=value ...，没有-benchmark时返回false
+可用的key：frames warmup dt planets terrain sprites script report label churn，值中不能有空格
+*/
+bool ParseBenchmarkArgs(const char* cmdLine, BenchmarkConfig& config);
+
+struct ScriptedKeyEvent
+{
+	uint32_t Frame = 0;
+	// 虚拟键码，和DirectX::Keyboard::Keys的值一致
+	uint8_t Key = 0;
+	bool Down = false;
+};
+
+/*
+按帧号回放的键盘输入，每行"帧号 键 动作"，#开头为注释
+键：单个字母或数字、LeftShift/Space等名字，或者十进制键码
+动作：down按下，up松开，tap在这一帧按下、下一帧松开
+*/
+class InputScript
+{
+public:
+	bool Load(const std::string& path);
+	bool Parse(std::istream& in);
+	// 内置脚本：在固定的帧切换后处理方式和地形线框，覆盖两种后处理路径和PSO切换
+	void LoadDefault(uint32_t warmupFrames, uint32_t frameCount);
+
+	// 把第frame帧的事件应用到keys上，frame必须逐帧递增
+	void Apply(uint32_t frame, std::bitset<256>& keys);
+
+	const std::vector<ScriptedKeyEvent>& GetEvents() const { return mEvents; }
+
+private:
+	static int ParseKey(const std::string& name);
+	void AddEvent(uint32_t frame, uint8_t key, bool down);
+
+	// 按帧号排序
+	std::vector<ScriptedKeyEvent> mEvents;
+	size_t mNext = 0;
+};
+
+// 单位是毫秒
+struct BenchmarkDistribution
+{
+	double Min = 0.0;
+	double Avg = 0.0;
+	double StdDev = 0.0;
+	double P50 = 0.0;
+	double P90 = 0.0;
+	double P99 = 0.0;
+	double Max = 0.0;
+	size_t Samples = 0;
+};
+
+/*
+确定性回放benchmark：固定步长、脚本化输入和相机路径，运行Warmup+FrameCount帧后结束
+记录每帧CPU耗时和各profile zone的耗时分布，结束时把分布、StatsRegistry的计数总量写成一个JSON报告
+同样的参数在两个构建上运行，报告可以直接比较
+*/
+class Benchmark
+{
+public:
+	explicit Benchmark(const BenchmarkConfig& config);
+
+	const BenchmarkConfig& GetConfig() const { return mConfig; }
+	uint32_t GetFrameIndex() const { return mFrameIndex; }
+	bool IsWarmingUp() const { return mFrameIndex < mConfig.WarmupFrames; }
+	bool IsFirstMeasuredFrame() const { return mFrameIndex == mConfig.WarmupFrames; }
+	bool IsFinished() const { return mFrameIndex >= mConfig.WarmupFrames + mConfig.FrameCount; }
+
+	// 帧开始时调用，回放这一帧的输入；第一个测量帧时清零StatsRegistry的Total
+	void BeginFrame(std::bitset<256>& keys);
+	// 帧结束时调用，frameTime是这一帧的CPU耗时(纳秒)，profile是Profiler刚结束的那一帧
+	void EndFrame(uint64_t frameTime, const ProfileFrame* profile);
+
+	// 不在StatsRegistry中的计数
+	void SetExtraTotal(const std::string& name, uint64_t value) { mExtraTotals[name] = value; }
+	// 回放中的检查失败，写进报告，程序的退出码为1
+	void AddFailure(const std::string& message) { mFailures.push_back(message); }
+	const std::vector<std::string>& GetFailures() const { return mFailures; }
+
+	bool WriteReport() const;
+
+	static BenchmarkDistribution Summarize(std::vector<double> samples);
+
+private:
+	static void WriteDistribution(std::ostream& out, const BenchmarkDistribution& d);
+
+	BenchmarkConfig mConfig;
+	InputScript mScript;
+	uint32_t mFrameIndex = 0;
+
+	std::vector<double> mFrameTimes;
+	// 按zone名字，同名zone在一帧内的总耗时(包括工作线程上的)
+	std::map<std::string, std::vector<double>> mZoneTimes;
+	std::map<std::string, uint64_t> mExtraTotals;
+	std::vector<std::string> mFailures;
+};
+
+}
@@ -0,0 +1,88 @@
+#include "BindlessIndexAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Soco
+{
+
+BindlessIndexAllocator::BindlessIndexAllocator(uint32_t capacity, uint32_t frameCopies)
+	: mCapacity(capacity), mFrameCopies(frameCopies)
+{
+	assert(frameCopies > 0 && frameCopies <= 32);
+	mState.assign(capacity, State::Free);
+	mDirtyCopies.assign(capacity, 0);
+	mDirty.resize(frameCopies);
+	mFreeList.reserve(capacity);
+	for (uint32_t i = capacity; i > 0; --i)
+		mFreeList.push_back(i - 1);
+}
+
+uint32_t BindlessIndexAllocator::Allocate()
+{
+	if (mFreeList.empty())
+		return InvalidIndex;
+
+	const uint32_t index = mFreeList.back();
+	mFreeList.pop_back();
+	mState[index] = State::Live;
+	++mLiveCount;
+	mHighWater = std::max(mHighWater, index + 1);
+	return index;
+}
+
+bool BindlessIndexAllocator::Free(uint32_t index)
+{
+	if (!IsLive(index))
+		return false;
+
+	//副本里原来的描述符留着，下标再分配时会被覆盖
+	mState[index] = State::Retired;
+	--mLiveCount;
+	mRetired.push_back({ index, mFrame });
+	return true;
+}
+
+bool BindlessIndexAllocator::MarkDirty(uint32_t index)
+{
+	if (!IsLive(index))
+		return false;
+
+	//当前帧的副本由调用者直接写
+	uint32_t copies = mFrameCopies == 32 ? ~0u : (1u << mFrameCopies) - 1;
+	if (mCurrentCopy != InvalidIndex)
+		copies &= ~(1u << mCurrentCopy);
+	const uint32_t added = copies & ~mDirtyCopies[index];
+	for (uint32_t copy = 0; copy < mFrameCopies; ++copy)
+	{
+		if (added & (1u << copy))
+			mDirty[copy].push_back(index);
+	}
+	mDirtyCopies[index] |= copies;
+	return true;
+}
+
+const std::vector<uint32_t>& BindlessIndexAllocator::BeginFrame(uint32_t copy)
+{
+	assert(copy < mFrameCopies);
+	++mFrame;
+	mCurrentCopy = copy;
+
+	//第f帧退役的下标，到第f + frameCopies帧开始时GPU已经执行完第f帧
+	while (!mRetired.empty() && mRetired.front().Frame + mFrameCopies <= mFrame)
+	{
+		const uint32_t index = mRetired.front().Index;
+		mRetired.pop_front();
+		mState[index] = State::Free;
+		mFreeList.push_back(index);
+	}
+
+	mTaken.clear();
+	mTaken.swap(mDirty[copy]);
+	for (uint32_t index : mTaken)
+		mDirtyCopies[index] &= ~(1u << copy);
+	std::sort(mTaken.begin(), mTaken.end());
+	return mTaken;
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace Soco
+{
+
+/*
+无绑定纹理表的下标分配，只管下标和描述符副本的同步，不碰GPU，可以用模拟的序列单独测试
+表在着色器可见的堆里有frameCopies份(每个FrameResource一份)，每帧只用其中一份：
+描述符变化时调用者马上写当前帧的副本，其他副本标记为要更新，每份在下次轮到自己时更新，这时GPU已经执行完上次用这份副本的帧
+释放的下标要等frameCopies帧之后才能再分配，在飞的帧可能还在用它原来的描述符
+*/
+class BindlessIndexAllocator
+{
+public:
+	static constexpr uint32_t InvalidIndex = ~0u;
+
+	// frameCopies不超过32
+	BindlessIndexAllocator(uint32_t capacity, uint32_t frameCopies);
+
+	// 满时返回InvalidIndex；新分配的下标的描述符还没写，调用者写好后要MarkDirty
+	uint32_t Allocate();
+	// 下标不是已分配的时返回false(重复释放)
+	bool Free(uint32_t index);
+	// 描述符变了，当前帧以外的副本都要更新(不在BeginFrame和EndFrame之间时是所有副本)；下标不是已分配的时返回false
+	bool MarkDirty(uint32_t index);
+
+	/*
+	开始新的一帧，这一帧使用第copy份副本：回收退役够frameCopies帧的下标，
+	返回这份副本需要更新的下标，升序，每个只出现一次；返回的数组在下次BeginFrame之前有效
+	*/
+	const std::vector<uint32_t>& BeginFrame(uint32_t copy);
+	// 这一帧提交之后调用，到下次BeginFrame之前没有当前副本，描述符的变化都留给各副本自己更新
+	void EndFrame() { mCurrentCopy = InvalidIndex; }
+
+	bool IsLive(uint32_t index) const { return index < mCapacity && mState[index] == State::Live; }
+	uint32_t GetCapacity() const { return mCapacity; }
+	uint32_t GetFrameCopies() const { return mFrameCopies; }
+	uint32_t GetLiveCount() const { return mLiveCount; }
+	uint32_t GetRetiredCount() const { return (uint32_t)mRetired.size(); }
+	// 分配过的最大下标加1
+	uint32_t GetHighWater() const { return mHighWater; }
+	uint64_t GetFrame() const { return mFrame; }
+	// 当前帧使用的副本，不在BeginFrame和EndFrame之间时是InvalidIndex
+	uint32_t GetCurrentCopy() const { return mCurrentCopy; }
+
+private:
+	enum class State : uint8_t
+	{
+		Free,
+		Live,
+		Retired,
+	};
+
+	struct RetiredIndex
+	{
+		uint32_t Index;
+		uint64_t Frame;
+	};
+
+	uint32_t mCapacity;
+	uint32_t mFrameCopies;
+	std::vector<State> mState;
+	// 每个下标还有哪些副本没更新，按位
+	std::vector<uint32_t> mDirtyCopies;
+	// 每份副本要更新的下标
+	std::vector<std::vector<uint32_t>> mDirty;
+	std::vector<uint32_t> mTaken;
+	// 栈，初始时从大到小放，先分配小的下标
+	std::vector<uint32_t> mFreeList;
+	// 按退役的帧排序
+	std::deque<RetiredIndex> mRetired;
+	uint32_t mLiveCount = 0;
+	uint32_t mHighWater = 0;
+	// 第一次BeginFrame之前是0
+	uint64_t mFrame = 0;
+	uint32_t mCurrentCopy = InvalidIndex;
+};
+
+}
@@ -0,0 +1,141 @@
+#include "Ecs.h"
+
+#include <atomic>
+
+namespace Soco
+{
+
+ComponentTypeId NextComponentTypeId()
+{
+	static std::atomic<ComponentTypeId> next{ 0 };
+	return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+Archetype::Archetype(std::vector<ComponentInfo> components)
+	: mComponents(std::move(components)), mColumns(mComponents.size(), nullptr)
+{
+}
+
+Archetype::~Archetype()
+{
+	for (size_t i = 0; i < mColumns.size(); ++i)
+		::operator delete(mColumns[i], std::align_val_t(mComponents[i].Align));
+}
+
+int Archetype::FindColumn(ComponentTypeId id) const
+{
+	//组件种类很少，线性查找比二分更快
+	for (size_t i = 0; i < mComponents.size(); ++i)
+	{
+		if (mComponents[i].Id == id)
+			return (int)i;
+	}
+	return -1;
+}
+
+size_t Archetype::PushBack(Entity entity)
+{
+	if (mEntities.size() == mCapacity)
+		Grow();
+
+	mEntities.push_back(entity);
+	return mEntities.size() - 1;
+}
+
+Entity Archetype::SwapRemove(size_t row)
+{
+	assert(row < mEntities.size());
+	const size_t last = mEntities.size() - 1;
+
+	Entity moved;
+	if (row != last)
+	{
+		for (size_t i = 0; i < mColumns.size(); ++i)
+			memcpy(GetComponent((int)i, row), GetComponent((int)i, last), mComponents[i].Size);
+		mEntities[row] = mEntities[last];
+		moved = mEntities[row];
+	}
+
+	mEntities.pop_back();
+	return moved;
+}
+
+void Archetype::Grow()
+{
+	const size_t capacity = std::max<size_t>(mCapacity * 2, 64);
+	for (size_t i = 0; i < mColumns.size(); ++i)
+	{
+		const ComponentInfo& info = mComponents[i];
+		std::byte* column = static_cast<std::byte*>(::operator new(capacity * info.Size, std::align_val_t(info.Align)));
+		if (mColumns[i] != nullptr)
+		{
+			memcpy(column, mColumns[i], mEntities.size() * info.Size);
+			::operator delete(mColumns[i], std::align_val_t(info.Align));
+		}
+		mColumns[i] = column;
+	}
+	mCapacity = capacity;
+}
+
+void EntityWorld::Destroy(Entity entity)
+{
+	if (!IsAlive(entity))
+		return;
+
+	EntityRecord& record = mRecords[entity.Index];
+	Entity moved = mArchetypes[record.Archetype]->SwapRemove(record.Row);
+	if (moved.IsValid())
+		mRecords[moved.Index].Row = record.Row;
+
+	record.Archetype = UINT32_MAX;
+	++record.Generation;
+	mFreeIndices.push_back(entity.Index);
+	--mEntityCount;
+}
+
+bool EntityWorld::IsAlive(Entity entity) const
+{
+	return entity.Index < mRecords.size() && mRecords[entity.Index].Generation == entity.Generation
+		&& mRecords[entity.Index].Archetype != UINT32_MAX;
+}
+
+Entity EntityWorld::AllocateEntity()
+{
+	Entity entity;
+	if (!mFreeIndices.empty())
+	{
+		entity.Index = mFreeIndices.back();
+		mFreeIndices.pop_back();
+	}
+	else
+	{
+		entity.Index = (uint32_t)mRecords.size();
+		mRecords.emplace_back();
+	}
+
+	entity.Generation = mRecords[entity.Index].Generation;
+	++mEntityCount;
+	return entity;
+}
+
+uint32_t EntityWorld::GetOrCreateArchetype(std::vector<ComponentInfo> components)
+{
+	std::sort(components.begin(), components.end(),
+		[](const ComponentInfo& a, const ComponentInfo& b) { return a.Id < b.Id; });
+
+	std::vector<ComponentTypeId> key;
+	for (const ComponentInfo& info : components)
+		key.push_back(info.Id);
+	assert(std::adjacent_find(key.begin(), key.end()) == key.end() && "同一个实体不能有两个同类组件");
+
+	auto ite = mArchetypeIndex.find(key);
+	if (ite != mArchetypeIndex.end())
+		return ite->second;
+
+	uint32_t index = (uint32_t)mArchetypes.size();
+	mArchetypes.push_back(std::make_unique<Archetype>(std::move(components)));
+	mArchetypeIndex.emplace(std::move(key), index);
+	return index;
+}
+
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "JobSystem.h"
+
+namespace Soco
+{
+
+// 实体句柄：Index指向记录表，Generation在实体销毁后递增，旧句柄因此失效
+struct Entity
+{
+	uint32_t Index = UINT32_MAX;
+	uint32_t Generation = 0;
+
+	bool IsValid() const { return Index != UINT32_MAX; }
+	bool operator== (const Entity& other) const { return Index == other.Index && Generation == other.Generation; }
+	bool operator!= (const Entity& other) const { return !(*this == other); }
+};
+
+using ComponentTypeId = uint32_t;
+
+ComponentTypeId NextComponentTypeId();
+
+// 每个组件类型一个编号，第一次使用时分配
+template<typename T>
+ComponentTypeId GetComponentTypeId()
+{
+	static const ComponentTypeId id = NextComponentTypeId();
+	return id;
+}
+
+struct ComponentInfo
+{
+	ComponentTypeId Id = 0;
+	size_t Size = 0;
+	size_t Align = 0;
+};
+
+/*
+archetype：组件类型集合完全相同的实体放在一起，每种组件一个连续数组(SoA)，第i行是第i个实体
+组件必须是可平凡复制的，增长和删除都直接按字节搬运
+*/
+class Archetype
+{
+public:
+	// components按Id从小到大
+	explicit Archetype(std::vector<ComponentInfo> components);
+	~Archetype();
+
+	Archetype(const Archetype& other) = delete;
+	Archetype& operator= (const Archetype& other) = delete;
+
+	const std::vector<ComponentInfo>& GetComponents() const { return mComponents; }
+	size_t Size() const { return mEntities.size(); }
+	const Entity* GetEntities() const { return mEntities.data(); }
+
+	// 没有这个组件时返回-1
+	int FindColumn(ComponentTypeId id) const;
+	bool Has(ComponentTypeId id) const { return FindColumn(id) >= 0; }
+
+	template<typename T>
+	T* GetColumn()
+	{
+		int column = FindColumn(GetComponentTypeId<T>());
+		return column >= 0 ? reinterpret_cast<T*>(mColumns[column]) : nullptr;
+	}
+
+	void* GetComponent(int column, size_t row) { return mColumns[column] + row * mComponents[column].Size; }
+
+	// 在末尾加一行，组件数据由调用者写入，返回行号
+	size_t PushBack(Entity entity);
+	// 把最后一行搬到row，返回被搬动的实体(row本身是最后一行时返回无效实体)
+	Entity SwapRemove(size_t row);
+
+private:
+	void Grow();
+
+	std::vector<ComponentInfo> mComponents;
+	std::vector<std::byte*> mColumns;
+	std::vector<Entity> mEntities;
+	size_t mCapacity = 0;
+};
+
+/*
+实体存储：按组件集合把实体分到archetype，系统按archetype遍历连续数组，没有按名字查找
+组件集合在创建时确定，不支持之后增删组件
+*/
+class EntityWorld
+{
+public:
+	EntityWorld() = default;
+	EntityWorld(const EntityWorld& other) = delete;
+	EntityWorld& operator= (const EntityWorld& other) = delete;
+
+	template<typename... Components>
+	Entity Create(const Components&... components)
+	{
+		static_assert(sizeof...(Components) > 0, "实体至少要有一个组件");
+		static_assert(std::conjunction_v<std::is_trivially_copyable<Components>...>, "组件必须可平凡复制");
+
+		std::vector<ComponentInfo> infos = { ComponentInfo{ GetComponentTypeId<Components>(), sizeof(Components), alignof(Components) }... };
+		uint32_t archetypeIndex = GetOrCreateArchetype(std::move(infos));
+		Archetype* archetype = mArchetypes[archetypeIndex].get();
+
+		Entity entity = AllocateEntity();
+		size_t row = archetype->PushBack(entity);
+		mRecords[entity.Index].Archetype = archetypeIndex;
+		mRecords[entity.Index].Row = (uint32_t)row;
+
+		(memcpy(archetype->GetComponent(archetype->FindColumn(GetComponentTypeId<Components>()), row), &components, sizeof(Components)), ...);
+		return entity;
+	}
+
+	void Destroy(Entity entity);
+	bool IsAlive(Entity entity) const;
+	size_t GetEntityCount() const { return mEntityCount; }
+
+	// 实体没有这个组件或已经销毁时返回nullptr
+	template<typename T>
+	T* Get(Entity entity)
+	{
+		if (!IsAlive(entity))
+			return nullptr;
+		const EntityRecord& record = mRecords[entity.Index];
+		Archetype* archetype = mArchetypes[record.Archetype].get();
+		int column = archetype->FindColumn(GetComponentTypeId<T>());
+		return column >= 0 ? reinterpret_cast<T*>(archetype->GetComponent(column, record.Row)) : nullptr;
+	}
+
+	// 包含全部Components、且不包含exclude中任何类型的archetype
+	template<typename... Components>
+	std::vector<Archetype*> Query(std::initializer_list<ComponentTypeId> exclude = {})
+	{
+		const ComponentTypeId required[] = { GetComponentTypeId<Components>()... };
+		std::vector<Archetype*> result;
+		for (const std::unique_ptr<Archetype>& archetype : mArchetypes)
+		{
+			if (archetype->Size() == 0)
+				continue;
+			bool match = std::all_of(std::begin(required), std::end(required), [&](ComponentTypeId id) { return archetype->Has(id); })
+				&& std::none_of(exclude.begin(), exclude.end(), [&](ComponentTypeId id) { return archetype->Has(id); });
+			if (match)
+				result.push_back(archetype.get());
+		}
+		return result;
+	}
+
+	// 对每个匹配的实体调用func(Components&...)，按archetype顺序线性遍历
+	template<typename... Components, typename F>
+	void ForEach(F&& func, std::initializer_list<ComponentTypeId> exclude = {})
+	{
+		for (Archetype* archetype : Query<Components...>(exclude))
+		{
+			auto columns = std::make_tuple(archetype->GetColumn<Components>()...);
+			const size_t size = archetype->Size();
+			std::apply([&](auto*... column) {
+				for (size_t i = 0; i < size; ++i)
+					func(column[i]...);
+			}, columns);
+		}
+	}
+
+	// 同ForEach，每个archetype按grainSize切段在JobSystem上并行，func不能增删实体
+	template<typename... Components, typename F>
+	void ParallelForEach(size_t grainSize, F&& func, std::initializer_list<ComponentTypeId> exclude = {})
+	{
+		for (Archetype* archetype : Query<Components...>(exclude))
+		{
+			auto columns = std::make_tuple(archetype->GetColumn<Components>()...);
+			JobSystem::GetInstance()->ParallelFor(0, archetype->Size(), grainSize, [&func, &columns](size_t first, size_t last) {
+				std::apply([&](auto*... column) {
+					for (size_t i = first; i < last; ++i)
+						func(column[i]...);
+				}, columns);
+			});
+		}
+	}
+
+private:
+	struct EntityRecord
+	{
+		uint32_t Generation = 0;
+		uint32_t Archetype = UINT32_MAX;
+		uint32_t Row = 0;
+	};
+
+	Entity AllocateEntity();
+	uint32_t GetOrCreateArchetype(std::vector<ComponentInfo> components);
+
+	std::vector<EntityRecord> mRecords;
+	std::vector<uint32_t> mFreeIndices;
+	size_t mEntityCount = 0;
+
+	std::vector<std::unique_ptr<Archetype>> mArchetypes;
+	// 排好序的组件Id列表 -> mArchetypes下标
+	std::map<std::vector<ComponentTypeId>, uint32_t> mArchetypeIndex;
+};
+
+}
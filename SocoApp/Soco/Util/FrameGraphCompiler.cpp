@@ -0,0 +1,424 @@
+#include "FrameGraphCompiler.h"
+#include "TransientHeapPacker.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+namespace Soco
+{
+
+uint32_t FrameGraphCompiler::AddResource(const FGResourceInfo& info)
+{
+	mResources.push_back(info);
+	return (uint32_t)(mResources.size() - 1);
+}
+
+uint32_t FrameGraphCompiler::AddPass(const FGPassInfo& info)
+{
+#if defined(DEBUG) | defined(_DEBUG)
+	for (const FGAccess& access : info.Accesses)
+		assert(access.Resource < mResources.size() && "pass访问了未声明的资源");
+#endif
+	mPasses.push_back(info);
+	return (uint32_t)(mPasses.size() - 1);
+}
+
+void FrameGraphCompiler::Clear()
+{
+	mResources.clear();
+	mPasses.clear();
+}
+
+std::vector<FGAccess> FrameGraphCompiler::MergedAccesses(uint32_t pass) const
+{
+	std::vector<FGAccess> merged;
+	for (const FGAccess& access : mPasses[pass].Accesses)
+	{
+		auto ite = std::find_if(merged.begin(), merged.end(),
+			[&access](const FGAccess& other) { return other.Resource == access.Resource; });
+		if (ite == merged.end())
+			merged.push_back(access);
+		else
+			ite->State |= access.State;
+	}
+
+	//写状态之间、写状态与读状态之间都不能组合
+	for (const FGAccess& access : merged)
+	{
+		uint32_t writeBits = access.State & ~FGState::ReadOnlyMask;
+		(void)writeBits;
+		assert((writeBits == 0 || (writeBits & (writeBits - 1)) == 0) && "一个pass对同一资源只能有一种写状态");
+		assert((writeBits == 0 || (access.State & FGState::ReadOnlyMask) == 0) && "写状态不能与读状态组合");
+	}
+	return merged;
+}
+
+std::vector<FrameGraphCompiler::Edge> FrameGraphCompiler::BuildEdges(const std::vector<std::vector<FGAccess>>& accesses) const
+{
+	std::vector<Edge> edges;
+	std::vector<uint32_t> lastWriter(mResources.size(), FGInvalidIndex);
+	std::vector<std::vector<uint32_t>> readersSinceWrite(mResources.size());
+
+	//声明顺序就是同一资源上读写的先后顺序
+	for (uint32_t pass = 0; pass < mPasses.size(); ++pass)
+	{
+		for (const FGAccess& access : accesses[pass])
+		{
+			uint32_t r = access.Resource;
+			if (FGState::IsReadOnly(access.State))
+			{
+				if (lastWriter[r] != FGInvalidIndex)
+					edges.push_back({ lastWriter[r], pass, true });
+				readersSinceWrite[r].push_back(pass);
+			}
+			else
+			{
+				if (lastWriter[r] != FGInvalidIndex)
+					edges.push_back({ lastWriter[r], pass, true });
+				for (uint32_t reader : readersSinceWrite[r])
+					edges.push_back({ reader, pass, false });
+
+				lastWriter[r] = pass;
+				readersSinceWrite[r].clear();
+			}
+		}
+	}
+	return edges;
+}
+
+std::vector<uint32_t> FrameGraphCompiler::SortPasses(const std::vector<Edge>& edges) const
+{
+	std::vector<uint32_t> inDegree(mPasses.size(), 0);
+	std::vector<std::vector<uint32_t>> successors(mPasses.size());
+	for (const Edge& edge : edges)
+	{
+		successors[edge.From].push_back(edge.To);
+		inDegree[edge.To]++;
+	}
+
+	//Kahn拓扑排序，同时就绪的pass按声明顺序执行，结果稳定
+	std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+	for (uint32_t pass = 0; pass < mPasses.size(); ++pass)
+	{
+		if (inDegree[pass] == 0)
+			ready.push(pass);
+	}
+
+	std::vector<uint32_t> order;
+	order.reserve(mPasses.size());
+	while (!ready.empty())
+	{
+		uint32_t pass = ready.top();
+		ready.pop();
+		order.push_back(pass);
+		for (uint32_t successor : successors[pass])
+		{
+			if (--inDegree[successor] == 0)
+				ready.push(successor);
+		}
+	}
+
+	assert(order.size() == mPasses.size() && "FrameGraph存在环形依赖");
+	return order;
+}
+
+std::vector<bool> FrameGraphCompiler::CullPasses(const std::vector<std::vector<FGAccess>>& accesses, const std::vector<Edge>& edges) const
+{
+	std::vector<std::vector<uint32_t>> producers(mPasses.size());
+	for (const Edge& edge : edges)
+	{
+		if (edge.DataDependency)
+			producers[edge.To].push_back(edge.From);
+	}
+
+	//有副作用或者写了外部资源的pass是根，沿数据依赖反向标记
+	std::vector<bool> needed(mPasses.size(), false);
+	std::vector<uint32_t> stack;
+	for (uint32_t pass = 0; pass < mPasses.size(); ++pass)
+	{
+		bool root = mPasses[pass].HasSideEffect;
+		for (const FGAccess& access : accesses[pass])
+		{
+			if (mResources[access.Resource].Imported && !FGState::IsReadOnly(access.State))
+				root = true;
+		}
+
+		if (root)
+		{
+			needed[pass] = true;
+			stack.push_back(pass);
+		}
+	}
+
+	while (!stack.empty())
+	{
+		uint32_t pass = stack.back();
+		stack.pop_back();
+		for (uint32_t producer : producers[pass])
+		{
+			if (!needed[producer])
+			{
+				needed[producer] = true;
+				stack.push_back(producer);
+			}
+		}
+	}
+
+	std::vector<bool> culled(mPasses.size());
+	for (uint32_t pass = 0; pass < mPasses.size(); ++pass)
+		culled[pass] = !needed[pass];
+	return culled;
+}
+
+FGCompileResult FrameGraphCompiler::Compile(const SlotStateQuery& slotState) const
+{
+	FGCompileResult result;
+
+	std::vector<std::vector<FGAccess>> accesses(mPasses.size());
+	for (uint32_t pass = 0; pass < mPasses.size(); ++pass)
+		accesses[pass] = MergedAccesses(pass);
+
+	std::vector<Edge> edges = BuildEdges(accesses);
+	std::vector<uint32_t> order = SortPasses(edges);
+	result.PassCulled = CullPasses(accesses, edges);
+
+	std::vector<uint32_t> liveOrder;
+	for (uint32_t pass : order)
+	{
+		if (!result.PassCulled[pass])
+			liveOrder.push_back(pass);
+	}
+
+	//资源生命周期：第一次和最后一次被存活pass访问的位置
+	std::vector<uint32_t> firstUse(mResources.size(), FGInvalidIndex);
+	std::vector<uint32_t> lastUse(mResources.size(), FGInvalidIndex);
+	for (uint32_t i = 0; i < liveOrder.size(); ++i)
+	{
+		for (const FGAccess& access : accesses[liveOrder[i]])
+		{
+			if (firstUse[access.Resource] == FGInvalidIndex)
+				firstUse[access.Resource] = i;
+			lastUse[access.Resource] = i;
+		}
+	}
+
+	result.ResourceCulled.resize(mResources.size());
+	for (uint32_t r = 0; r < mResources.size(); ++r)
+		result.ResourceCulled[r] = firstUse[r] == FGInvalidIndex;
+
+	//别名：按第一次使用的先后分配，AliasKey相同且上一个使用者已经结束的slot可以复用
+	result.PhysicalSlot.assign(mResources.size(), FGInvalidIndex);
+	std::vector<uint32_t> slotFirstUse;
+	std::vector<uint32_t> slotLastUse;
+	std::vector<uint32_t> slotFirstResource;
+	std::vector<uint32_t> slotLastResource;
+	std::unordered_map<uint64_t, std::vector<uint32_t>> slotsByKey;
+	std::vector<uint32_t> transientByFirstUse;
+	for (uint32_t r = 0; r < mResources.size(); ++r)
+	{
+		if (!mResources[r].Imported && !result.ResourceCulled[r])
+			transientByFirstUse.push_back(r);
+	}
+	std::stable_sort(transientByFirstUse.begin(), transientByFirstUse.end(),
+		[&firstUse](uint32_t a, uint32_t b) { return firstUse[a] < firstUse[b]; });
+
+	for (uint32_t r : transientByFirstUse)
+	{
+		std::vector<uint32_t>& candidates = slotsByKey[mResources[r].AliasKey];
+		uint32_t slot = FGInvalidIndex;
+		for (uint32_t candidate : candidates)
+		{
+			if (slotLastUse[candidate] < firstUse[r])
+			{
+				slot = candidate;
+				break;
+			}
+		}
+
+		if (slot == FGInvalidIndex)
+		{
+			slot = (uint32_t)result.SlotAliasKey.size();
+			result.SlotAliasKey.push_back(mResources[r].AliasKey);
+			result.SlotOrdinal.push_back((uint32_t)candidates.size());
+			slotFirstUse.push_back(firstUse[r]);
+			slotLastUse.push_back(0);
+			slotFirstResource.push_back(r);
+			slotLastResource.push_back(r);
+			candidates.push_back(slot);
+		}
+
+		slotLastUse[slot] = lastUse[r];
+		slotLastResource[slot] = r;
+		result.PhysicalSlot[r] = slot;
+	}
+
+	//堆布局：每组一个堆，slot在[第一次使用, 最后一次使用]内独占自己那段内存
+	const uint32_t slotCount = (uint32_t)result.SlotAliasKey.size();
+	result.SlotHeapGroup.assign(slotCount, FGInvalidIndex);
+	result.SlotHeapOffset.assign(slotCount, 0);
+	std::vector<std::vector<uint32_t>> groupSlots;
+	for (uint32_t slot = 0; slot < slotCount; ++slot)
+	{
+		const FGResourceInfo& info = mResources[slotFirstResource[slot]];
+		if (info.Size == 0)
+			continue;
+
+		if (groupSlots.size() <= info.HeapGroup)
+			groupSlots.resize(info.HeapGroup + 1);
+		groupSlots[info.HeapGroup].push_back(slot);
+		result.SlotHeapGroup[slot] = info.HeapGroup;
+	}
+
+	result.HeapSize.assign(groupSlots.size(), 0);
+	for (uint32_t group = 0; group < groupSlots.size(); ++group)
+	{
+		std::vector<TransientAllocationRequest> requests;
+		for (uint32_t slot : groupSlots[group])
+		{
+			const FGResourceInfo& info = mResources[slotFirstResource[slot]];
+			requests.push_back({ info.Size, info.Alignment, slotFirstUse[slot], slotLastUse[slot] });
+		}
+
+		TransientPackResult packed = PackTransientLifetimes(requests);
+		for (size_t i = 0; i < groupSlots[group].size(); ++i)
+			result.SlotHeapOffset[groupSlots[group][i]] = packed.Offsets[i];
+		result.HeapSize[group] = packed.HeapSize;
+		result.TransientTotalSize += packed.TotalSize;
+	}
+
+	//每个slot开始占用内存时，之前占用重叠内存的最后一个资源
+	std::vector<uint32_t> slotAliasedBefore(slotCount, FGInvalidIndex);
+	for (uint32_t slot = 0; slot < slotCount; ++slot)
+	{
+		if (result.SlotHeapGroup[slot] == FGInvalidIndex)
+			continue;
+
+		const uint64_t begin = result.SlotHeapOffset[slot];
+		const uint64_t end = begin + mResources[slotFirstResource[slot]].Size;
+		uint32_t latestLastUse = 0;
+		for (uint32_t other = 0; other < slotCount; ++other)
+		{
+			if (other == slot || result.SlotHeapGroup[other] != result.SlotHeapGroup[slot] || slotLastUse[other] >= slotFirstUse[slot])
+				continue;
+
+			const uint64_t otherBegin = result.SlotHeapOffset[other];
+			const uint64_t otherEnd = otherBegin + mResources[slotFirstResource[other]].Size;
+			if (otherBegin < end && begin < otherEnd && (slotAliasedBefore[slot] == FGInvalidIndex || slotLastUse[other] >= latestLastUse))
+			{
+				slotAliasedBefore[slot] = slotLastResource[other];
+				latestLastUse = slotLastUse[other];
+			}
+		}
+	}
+
+	std::vector<uint32_t> slotInitialState(slotCount);
+	for (uint32_t slot = 0; slot < slotCount; ++slot)
+		slotInitialState[slot] = slotState ? slotState(result, slot) : mResources[slotFirstResource[slot]].InitialState;
+
+	//状态跟踪：Imported资源按资源跟踪，transient资源按物理slot跟踪
+	std::vector<uint32_t> importedState(mResources.size(), FGState::Common);
+	for (uint32_t r = 0; r < mResources.size(); ++r)
+		importedState[r] = mResources[r].InitialState;
+	result.SlotFinalState = slotInitialState;
+
+	auto trackedState = [&](uint32_t r) -> uint32_t& {
+		return mResources[r].Imported ? importedState[r] : result.SlotFinalState[result.PhysicalSlot[r]];
+	};
+
+	result.ResourceFinalState.assign(mResources.size(), FGState::Common);
+	for (uint32_t r = 0; r < mResources.size(); ++r)
+		result.ResourceFinalState[r] = mResources[r].InitialState;
+
+	for (uint32_t i = 0; i < liveOrder.size(); ++i)
+	{
+		FGCompiledPass compiled;
+		compiled.Pass = liveOrder[i];
+
+		//放在共享堆里的slot开始占用内存：先发Aliasing屏障，内容未定义
+		for (const FGAccess& access : accesses[liveOrder[i]])
+		{
+			uint32_t slot = result.PhysicalSlot[access.Resource];
+			if (slot == FGInvalidIndex || slotFirstResource[slot] != access.Resource || firstUse[access.Resource] != i ||
+				result.SlotHeapGroup[slot] == FGInvalidIndex)
+				continue;
+
+			FGBarrier aliasing;
+			aliasing.Type = FGBarrier::BarrierType::Aliasing;
+			aliasing.Resource = access.Resource;
+			aliasing.ResourceBefore = slotAliasedBefore[slot];
+			compiled.Barriers.push_back(aliasing);
+			compiled.Activated.push_back(access);
+		}
+
+		for (const FGAccess& access : accesses[liveOrder[i]])
+		{
+			uint32_t& current = trackedState(access.Resource);
+
+			if (FGState::IsReadOnly(access.State))
+			{
+				//当前状态已经包含需要的读状态，不需要屏障
+				if (FGState::IsReadOnly(current) && (current & access.State) == access.State)
+				{
+					result.ResourceFinalState[access.Resource] = current;
+					continue;
+				}
+
+				//往后看：下一次写之前的连续读合并成一个组合读状态，后面的读就不再需要屏障
+				uint32_t combined = access.State;
+				for (uint32_t j = i + 1; j < liveOrder.size(); ++j)
+				{
+					bool written = false;
+					for (const FGAccess& next : accesses[liveOrder[j]])
+					{
+						if (next.Resource != access.Resource)
+							continue;
+						if (FGState::IsReadOnly(next.State))
+							combined |= next.State;
+						else
+							written = true;
+					}
+					if (written)
+						break;
+				}
+
+				compiled.Barriers.push_back({ FGBarrier::BarrierType::Transition, access.Resource, current, combined });
+				current = combined;
+			}
+			else if (current != access.State)
+			{
+				compiled.Barriers.push_back({ FGBarrier::BarrierType::Transition, access.Resource, current, access.State });
+				current = access.State;
+			}
+			else if (access.State == FGState::UnorderedAccess)
+			{
+				//连续两个pass写同一个UAV，需要等上一个写完
+				compiled.Barriers.push_back({ FGBarrier::BarrierType::UAV, access.Resource, current, current });
+			}
+
+			result.ResourceFinalState[access.Resource] = current;
+		}
+
+		result.Passes.push_back(std::move(compiled));
+	}
+
+	for (uint32_t r = 0; r < mResources.size(); ++r)
+	{
+		const FGResourceInfo& info = mResources[r];
+		if (!info.Imported || info.FinalState == FGState::Keep)
+			continue;
+
+		if (importedState[r] != info.FinalState)
+		{
+			result.FinalBarriers.push_back({ FGBarrier::BarrierType::Transition, r, importedState[r], info.FinalState });
+			importedState[r] = info.FinalState;
+		}
+		result.ResourceFinalState[r] = info.FinalState;
+	}
+
+	return result;
+}
+
+}
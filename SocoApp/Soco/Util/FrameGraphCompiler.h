@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Soco
+{
+
+// 资源状态，取值与D3D12_RESOURCE_STATES一致
+// 编译器只做依赖排序、剔除、屏障计算和别名分配，不依赖d3d12头文件
+namespace FGState
+{
+	constexpr uint32_t Common = 0;
+	constexpr uint32_t Present = 0;
+	constexpr uint32_t VertexAndConstantBuffer = 0x1;
+	constexpr uint32_t IndexBuffer = 0x2;
+	constexpr uint32_t RenderTarget = 0x4;
+	constexpr uint32_t UnorderedAccess = 0x8;
+	constexpr uint32_t DepthWrite = 0x10;
+	constexpr uint32_t DepthRead = 0x20;
+	constexpr uint32_t NonPixelShaderResource = 0x40;
+	constexpr uint32_t PixelShaderResource = 0x80;
+	constexpr uint32_t IndirectArgument = 0x200;
+	constexpr uint32_t CopyDest = 0x400;
+	constexpr uint32_t CopySource = 0x800;
+	constexpr uint32_t ResolveDest = 0x1000;
+	constexpr uint32_t ResolveSource = 0x2000;
+
+	constexpr uint32_t ReadOnlyMask = VertexAndConstantBuffer | IndexBuffer | DepthRead | NonPixelShaderResource |
+		PixelShaderResource | IndirectArgument | CopySource | ResolveSource;
+
+	// 不需要转换到FinalState时使用
+	constexpr uint32_t Keep = 0xFFFFFFFF;
+
+	inline bool IsReadOnly(uint32_t state) { return state != Common && (state & ~ReadOnlyMask) == 0; }
+}
+
+constexpr uint32_t FGInvalidIndex = 0xFFFFFFFF;
+
+struct FGResourceInfo
+{
+	std::string Name;
+	// 外部导入的资源(back buffer等)由外部持有，对外可见，写它的pass不会被剔除
+	bool Imported = false;
+	// Imported资源的当前状态；transient资源在没有SlotState回调时以此为初始状态
+	uint32_t InitialState = FGState::Common;
+	// 帧末需要转换到的状态，只对Imported资源有效
+	uint32_t FinalState = FGState::Keep;
+	// 描述相同(宽高、格式等)的transient资源AliasKey相同，生命周期不重叠时共用一个物理资源
+	uint64_t AliasKey = 0;
+	// transient资源的内存需求，Size不为0时物理资源按生命周期放置进共享堆，内存不重叠的才能同时存活
+	uint64_t Size = 0;
+	uint64_t Alignment = 1;
+	// 只能放进同一种堆的资源分为一组(比如Resource Heap Tier 1下RT/DS纹理和其他纹理)，每组一个堆
+	uint32_t HeapGroup = 0;
+};
+
+struct FGAccess
+{
+	uint32_t Resource = FGInvalidIndex;
+	uint32_t State = FGState::Common;
+};
+
+struct FGPassInfo
+{
+	std::string Name;
+	// 状态为只读状态的是读，否则是写
+	std::vector<FGAccess> Accesses;
+	// 有副作用的pass(比如写回读缓冲、Present前的最后一步)不会被剔除
+	bool HasSideEffect = false;
+};
+
+struct FGBarrier
+{
+	enum class BarrierType
+	{
+		Transition,
+		UAV,
+		Aliasing,
+	};
+
+	BarrierType Type = BarrierType::Transition;
+	uint32_t Resource = FGInvalidIndex;
+	uint32_t StateBefore = FGState::Common;
+	uint32_t StateAfter = FGState::Common;
+	// Aliasing屏障之前占用这段内存的资源，FGInvalidIndex表示不确定(帧开始时)
+	uint32_t ResourceBefore = FGInvalidIndex;
+};
+
+struct FGCompiledPass
+{
+	uint32_t Pass = FGInvalidIndex;
+	// pass开始前一次性提交的屏障
+	std::vector<FGBarrier> Barriers;
+	// 在这个pass开始占用堆内存的transient资源和它第一次访问的状态，内容未定义，需要Discard或完整写入
+	std::vector<FGAccess> Activated;
+};
+
+struct FGCompileResult
+{
+	// 存活的pass，按执行顺序
+	std::vector<FGCompiledPass> Passes;
+	// 所有pass结束后把Imported资源转换到FinalState
+	std::vector<FGBarrier> FinalBarriers;
+
+	std::vector<bool> PassCulled;
+	std::vector<bool> ResourceCulled;
+
+	// 每个transient资源对应的物理资源下标，Imported和被剔除的资源为FGInvalidIndex
+	std::vector<uint32_t> PhysicalSlot;
+	std::vector<uint64_t> SlotAliasKey;
+	// 同一AliasKey的第几个slot
+	std::vector<uint32_t> SlotOrdinal;
+	// 放置在共享堆中的位置，Size为0的资源不参与
+	std::vector<uint32_t> SlotHeapGroup;
+	std::vector<uint64_t> SlotHeapOffset;
+	std::vector<uint64_t> HeapSize;
+	// 不做内存别名时transient资源的总大小，和实际所有堆大小之和对比
+	uint64_t TransientTotalSize = 0;
+	// 帧末每个物理资源的状态，运行时据此更新自己记录的状态
+	std::vector<uint32_t> SlotFinalState;
+	// 帧末每个资源的状态
+	std::vector<uint32_t> ResourceFinalState;
+};
+
+class FrameGraphCompiler
+{
+public:
+	// 返回物理资源slot当前所处的状态，用于计算transient资源第一次使用前的屏障
+	// 调用时layout中的slot和堆布局已经确定
+	using SlotStateQuery = std::function<uint32_t(const FGCompileResult& layout, uint32_t slot)>;
+
+	uint32_t AddResource(const FGResourceInfo& info);
+	uint32_t AddPass(const FGPassInfo& info);
+	void Clear();
+
+	const FGResourceInfo& GetResource(uint32_t index) const { return mResources[index]; }
+	const FGPassInfo& GetPass(uint32_t index) const { return mPasses[index]; }
+	size_t ResourceCount() const { return mResources.size(); }
+	size_t PassCount() const { return mPasses.size(); }
+
+	// slotState为空时transient资源以自己的InitialState开始
+	FGCompileResult Compile(const SlotStateQuery& slotState = nullptr) const;
+
+private:
+	struct Edge
+	{
+		uint32_t From;
+		uint32_t To;
+		// 写后读/写后写是数据依赖，读后写只约束顺序，剔除时不沿它传播
+		bool DataDependency;
+	};
+
+	// 同一个pass对同一个资源的多次访问合并成一次
+	std::vector<FGAccess> MergedAccesses(uint32_t pass) const;
+	std::vector<Edge> BuildEdges(const std::vector<std::vector<FGAccess>>& accesses) const;
+	std::vector<uint32_t> SortPasses(const std::vector<Edge>& edges) const;
+	std::vector<bool> CullPasses(const std::vector<std::vector<FGAccess>>& accesses, const std::vector<Edge>& edges) const;
+
+	std::vector<FGResourceInfo> mResources;
+	std::vector<FGPassInfo> mPasses;
+};
+
+}
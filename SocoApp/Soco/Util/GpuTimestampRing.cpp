@@ -0,0 +1,115 @@
+#include "GpuTimestampRing.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Soco
+{
+
+uint64_t GpuClockCalibration::ToCpuTime(uint64_t gpuTimestamp) const
+{
+	//分开算整数和小数部分，避免tick * 1e9溢出
+	const bool after = gpuTimestamp >= GpuTimestamp;
+	const uint64_t delta = after ? gpuTimestamp - GpuTimestamp : GpuTimestamp - gpuTimestamp;
+	const uint64_t ns = delta / Frequency * 1000000000ull + delta % Frequency * 1000000000ull / Frequency;
+	return after ? CpuTime + ns : CpuTime - std::min<uint64_t>(CpuTime, ns);
+}
+
+void GpuTimestampRing::Initialize(uint32_t frameSlotCount, uint32_t maxZonesPerFrame)
+{
+	assert(frameSlotCount > 0 && maxZonesPerFrame > 0);
+	mFrameSlotCount = frameSlotCount;
+	mMaxZonesPerFrame = maxZonesPerFrame;
+	mZoneNames.assign(maxZonesPerFrame, std::string());
+	mPendingFrames.clear();
+	mRecording = false;
+}
+
+void GpuTimestampRing::BeginFrame(uint64_t frameIndex, uint32_t frameSlot)
+{
+	assert(!mRecording && "上一帧还没有EndFrame");
+	assert(frameSlot < mFrameSlotCount);
+
+	//这个slot的查询马上要被覆盖
+	auto overwritten = std::remove_if(mPendingFrames.begin(), mPendingFrames.end(),
+		[frameSlot](const PendingFrame& pending) { return pending.FrameSlot == frameSlot; });
+	mDroppedFrames += mPendingFrames.end() - overwritten;
+	mPendingFrames.erase(overwritten, mPendingFrames.end());
+
+	mRecording = true;
+	mFrameIndex = frameIndex;
+	mFrameSlot = frameSlot;
+	mZoneCount.store(0, std::memory_order_relaxed);
+}
+
+uint32_t GpuTimestampRing::BeginZone(const std::string& name)
+{
+	assert(mRecording);
+	uint32_t zone = mZoneCount.fetch_add(1, std::memory_order_relaxed);
+	if (zone >= mMaxZonesPerFrame)
+	{
+		mDroppedZones.fetch_add(1, std::memory_order_relaxed);
+		return InvalidZone;
+	}
+
+	mZoneNames[zone] = name;
+	return zone;
+}
+
+uint32_t GpuTimestampRing::GetUsedQueryCount() const
+{
+	return std::min<uint32_t>(mZoneCount.load(std::memory_order_relaxed), mMaxZonesPerFrame) * 2;
+}
+
+void GpuTimestampRing::EndFrame(uint64_t fenceValue)
+{
+	assert(mRecording);
+	mRecording = false;
+
+	const uint32_t zoneCount = GetUsedQueryCount() / 2;
+	if (zoneCount == 0)
+		return;
+
+	PendingFrame pending;
+	pending.FrameIndex = mFrameIndex;
+	pending.FrameSlot = mFrameSlot;
+	pending.Fence = fenceValue;
+	pending.ZoneNames.assign(mZoneNames.begin(), mZoneNames.begin() + zoneCount);
+	mPendingFrames.push_back(std::move(pending));
+}
+
+std::vector<GpuFrameTimings> GpuTimestampRing::Collect(uint64_t completedFence, TimestampSource& source, const GpuClockCalibration& clock)
+{
+	std::vector<GpuFrameTimings> result;
+	std::vector<uint64_t> timestamps;
+
+	//按提交顺序，fence单调递增，遇到没完成的帧后面的也不会完成
+	size_t collected = 0;
+	for (; collected < mPendingFrames.size(); ++collected)
+	{
+		PendingFrame& pending = mPendingFrames[collected];
+		if (pending.Fence > completedFence)
+			break;
+
+		const uint32_t queryCount = (uint32_t)pending.ZoneNames.size() * 2;
+		timestamps.assign(queryCount, 0);
+		source.ReadTimestamps(pending.FrameSlot, queryCount, timestamps.data());
+
+		GpuFrameTimings frame;
+		frame.FrameIndex = pending.FrameIndex;
+		frame.Zones.resize(pending.ZoneNames.size());
+		for (uint32_t zone = 0; zone < pending.ZoneNames.size(); ++zone)
+		{
+			GpuZoneTiming& timing = frame.Zones[zone];
+			timing.Name = std::move(pending.ZoneNames[zone]);
+			timing.Begin = clock.ToCpuTime(timestamps[BeginQueryIndex(zone)]);
+			timing.End = std::max<uint64_t>(timing.Begin, clock.ToCpuTime(timestamps[EndQueryIndex(zone)]));
+		}
+		result.push_back(std::move(frame));
+	}
+
+	mPendingFrames.erase(mPendingFrames.begin(), mPendingFrames.begin() + collected);
+	return result;
+}
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Soco
+{
+
+// 读回的时间戳来源：实际实现读取每个frame slot的readback buffer，测试时可以换成假的
+class TimestampSource
+{
+public:
+	virtual ~TimestampSource() = default;
+	// 读取frameSlot的前count个时间戳(GPU tick)
+	virtual void ReadTimestamps(uint32_t frameSlot, uint32_t count, uint64_t* timestamps) = 0;
+};
+
+// GPU tick和CPU时间(纳秒，Profiler::Now的时间域)的对应关系
+struct GpuClockCalibration
+{
+	uint64_t Frequency = 1;
+	uint64_t GpuTimestamp = 0;
+	uint64_t CpuTime = 0;
+
+	uint64_t ToCpuTime(uint64_t gpuTimestamp) const;
+};
+
+struct GpuZoneTiming
+{
+	std::string Name;
+	uint64_t Begin = 0;
+	uint64_t End = 0;
+};
+
+struct GpuFrameTimings
+{
+	uint64_t FrameIndex = 0;
+	std::vector<GpuZoneTiming> Zones;
+};
+
+/*
+GPU时间戳的延迟读回簿记：每个frame slot(对应一个FrameResource)有自己的一段查询，
+每个zone占两个查询(开始、结束)，帧录制完记下GPU完成这一帧时的fence值，
+之后只收集fence已经完成的帧，不等待GPU
+*/
+class GpuTimestampRing
+{
+public:
+	static constexpr uint32_t InvalidZone = 0xFFFFFFFF;
+
+	void Initialize(uint32_t frameSlotCount, uint32_t maxZonesPerFrame);
+
+	uint32_t GetFrameSlotCount() const { return mFrameSlotCount; }
+	uint32_t GetMaxZonesPerFrame() const { return mMaxZonesPerFrame; }
+	uint32_t GetQueriesPerFrame() const { return mMaxZonesPerFrame * 2; }
+
+	// 开始记录frameIndex，使用frameSlot的查询
+	// 这个slot上还没收集的帧会被覆盖，计入丢弃
+	void BeginFrame(uint64_t frameIndex, uint32_t frameSlot);
+
+	// 线程安全，返回zone编号，超过上限返回InvalidZone
+	uint32_t BeginZone(const std::string& name);
+	static uint32_t BeginQueryIndex(uint32_t zone) { return zone * 2; }
+	static uint32_t EndQueryIndex(uint32_t zone) { return zone * 2 + 1; }
+
+	// 本帧用到的查询数量，resolve前所有zone都必须已经结束
+	uint32_t GetUsedQueryCount() const;
+
+	// 本帧录制结束，fenceValue是GPU执行完这一帧后signal的值
+	void EndFrame(uint64_t fenceValue);
+
+	// 收集fence不超过completedFence的帧，按帧顺序返回
+	std::vector<GpuFrameTimings> Collect(uint64_t completedFence, TimestampSource& source, const GpuClockCalibration& clock);
+
+	uint32_t GetPendingFrameCount() const { return (uint32_t)mPendingFrames.size(); }
+	uint64_t GetDroppedFrameCount() const { return mDroppedFrames; }
+	uint64_t GetDroppedZoneCount() const { return mDroppedZones.load(std::memory_order_relaxed); }
+
+private:
+	struct PendingFrame
+	{
+		uint64_t FrameIndex = 0;
+		uint32_t FrameSlot = 0;
+		uint64_t Fence = 0;
+		std::vector<std::string> ZoneNames;
+	};
+
+	uint32_t mFrameSlotCount = 0;
+	uint32_t mMaxZonesPerFrame = 0;
+
+	bool mRecording = false;
+	uint64_t mFrameIndex = 0;
+	uint32_t mFrameSlot = 0;
+	std::atomic<uint32_t> mZoneCount{ 0 };
+	std::vector<std::string> mZoneNames;
+
+	std::vector<PendingFrame> mPendingFrames;
+	uint64_t mDroppedFrames = 0;
+	std::atomic<uint64_t> mDroppedZones{ 0 };
+};
+
+}
@@ -0,0 +1,233 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Soco
+{
+
+namespace
+{
+// 工作线程的队列下标，主线程和其他非工作线程都用0号队列
+thread_local uint32_t tQueueIndex = 0;
+}
+
+void JobSystem::Initialize(uint32_t threadCount)
+{
+	Shutdown();
+
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+
+	mQueues.clear();
+	for (uint32_t i = 0; i < threadCount; ++i)
+		mQueues.push_back(std::make_unique<WorkQueue>());
+
+	mStop = false;
+	for (uint32_t i = 1; i < threadCount; ++i)
+		mWorkers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mStop = true;
+	}
+	mWakeCondition.notify_all();
+
+	for (std::thread& worker : mWorkers)
+		worker.join();
+	mWorkers.clear();
+}
+
+void JobSystem::Run(Job job, JobCounter* counter)
+{
+	if (counter != nullptr)
+		counter->Add(1);
+
+	WorkQueue& queue = *mQueues[CurrentQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Tasks.push_back({ std::move(job), counter });
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mQueuedTasks.fetch_add(1, std::memory_order_release);
+	}
+	mWakeCondition.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	const uint32_t index = CurrentQueueIndex();
+	while (!counter.IsDone())
+	{
+		if (!ExecuteOne(index))
+			std::this_thread::yield();
+	}
+
+	if (counter.mException != nullptr)
+	{
+		std::exception_ptr e = counter.mException;
+		counter.mException = nullptr;
+		std::rethrow_exception(e);
+	}
+}
+
+bool JobSystem::TryPop(uint32_t index, Task& task)
+{
+	WorkQueue& queue = *mQueues[index];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Tasks.empty())
+		return false;
+
+	task = std::move(queue.Tasks.back());
+	queue.Tasks.pop_back();
+	return true;
+}
+
+bool JobSystem::TrySteal(uint32_t thief, Task& task)
+{
+	const uint32_t count = (uint32_t)mQueues.size();
+	for (uint32_t i = 1; i < count; ++i)
+	{
+		WorkQueue& queue = *mQueues[(thief + i) % count];
+		std::unique_lock<std::mutex> lock(queue.Mutex, std::try_to_lock);
+		if (!lock.owns_lock() || queue.Tasks.empty())
+			continue;
+
+		task = std::move(queue.Tasks.front());
+		queue.Tasks.pop_front();
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::ExecuteOne(uint32_t index)
+{
+	Task task;
+	if (!TryPop(index, task) && !TrySteal(index, task))
+		return false;
+
+	mQueuedTasks.fetch_sub(1, std::memory_order_acq_rel);
+	Execute(task);
+	return true;
+}
+
+void JobSystem::Execute(Task& task)
+{
+	try
+	{
+		task.Func();
+	}
+	catch (...)
+	{
+		if (task.Counter == nullptr)
+			throw;
+		task.Counter->SetException(std::current_exception());
+	}
+
+	if (task.Counter != nullptr)
+		task.Counter->Done();
+}
+
+void JobSystem::WorkerLoop(uint32_t index)
+{
+	tQueueIndex = index;
+	while (true)
+	{
+		if (ExecuteOne(index))
+			continue;
+
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mWakeCondition.wait(lock, [this]() {
+			return mStop.load() || mQueuedTasks.load(std::memory_order_acquire) > 0;
+		});
+		if (mStop.load())
+			return;
+	}
+}
+
+uint32_t JobSystem::CurrentQueueIndex() const
+{
+	return tQueueIndex < mQueues.size() ? tQueueIndex : 0;
+}
+
+JobGraph::NodeId JobGraph::AddJob(const std::string& name, JobSystem::Job func)
+{
+	auto node = std::make_unique<Node>();
+	node->Name = name;
+	node->Func = std::move(func);
+	mNodes.push_back(std::move(node));
+	return (NodeId)(mNodes.size() - 1);
+}
+
+void JobGraph::AddDependency(NodeId before, NodeId after)
+{
+	assert(before < mNodes.size() && after < mNodes.size() && before != after);
+	mNodes[before]->Successors.push_back(after);
+	mNodes[after]->DependencyCount++;
+}
+
+void JobGraph::Execute(JobSystem* jobSystem)
+{
+	assert(IsAcyclic() && "JobGraph存在环形依赖");
+
+	for (std::unique_ptr<Node>& node : mNodes)
+		node->Remaining.store(node->DependencyCount, std::memory_order_relaxed);
+
+	JobCounter counter;
+	for (NodeId id = 0; id < mNodes.size(); ++id)
+	{
+		if (mNodes[id]->DependencyCount == 0)
+			Schedule(jobSystem, id, counter);
+	}
+	jobSystem->Wait(counter);
+}
+
+void JobGraph::Schedule(JobSystem* jobSystem, NodeId id, JobCounter& counter)
+{
+	jobSystem->Run([this, jobSystem, id, &counter]() {
+		Node& node = *mNodes[id];
+		node.Func();
+
+		// 先把后继入队再结束自己，counter不会提前归零
+		for (NodeId successor : node.Successors)
+		{
+			if (mNodes[successor]->Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				Schedule(jobSystem, successor, counter);
+		}
+	}, &counter);
+}
+
+bool JobGraph::IsAcyclic() const
+{
+	std::vector<uint32_t> remaining(mNodes.size());
+	std::vector<NodeId> ready;
+	for (NodeId id = 0; id < mNodes.size(); ++id)
+	{
+		remaining[id] = mNodes[id]->DependencyCount;
+		if (remaining[id] == 0)
+			ready.push_back(id);
+	}
+
+	size_t visited = 0;
+	while (!ready.empty())
+	{
+		NodeId id = ready.back();
+		ready.pop_back();
+		++visited;
+		for (NodeId successor : mNodes[id]->Successors)
+		{
+			if (--remaining[successor] == 0)
+				ready.push_back(successor);
+		}
+	}
+	return visited == mNodes.size();
+}
+
+}
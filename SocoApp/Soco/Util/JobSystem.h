@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Soco
+{
+
+// 记录一组job还有多少没完成，Wait时等到归零
+// 组内任一job抛出的第一个异常会在Wait时重新抛出
+class JobCounter
+{
+public:
+	JobCounter() = default;
+	JobCounter(const JobCounter& other) = delete;
+	JobCounter& operator= (const JobCounter& other) = delete;
+
+	bool IsDone() const { return mPending.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+
+	void Add(int count) { mPending.fetch_add(count, std::memory_order_acq_rel); }
+	void Done() { mPending.fetch_sub(1, std::memory_order_acq_rel); }
+
+	void SetException(std::exception_ptr e)
+	{
+		std::lock_guard<std::mutex> lock(mExceptionMutex);
+		if (mException == nullptr)
+			mException = e;
+	}
+
+	std::atomic<int> mPending = 0;
+	std::mutex mExceptionMutex;
+	std::exception_ptr mException = nullptr;
+};
+
+// Work-stealing调度器
+// 每个线程(包括主线程，下标0)一个双端队列：自己从队尾取(LIFO，缓存友好)，偷别人时从队头取(FIFO，偷大块)
+// Wait不会阻塞调用线程，而是边等边执行job，所以job里可以嵌套ParallelFor/Wait
+class JobSystem
+{
+public:
+	using Job = std::function<void()>;
+
+	static JobSystem* GetInstance()
+	{
+		static JobSystem* instance = new JobSystem();
+		return instance;
+	}
+
+	JobSystem(const JobSystem& other) = delete;
+	JobSystem& operator= (const JobSystem& other) = delete;
+
+	// 调整工作线程数，threadCount包括主线程，0表示按CPU核数
+	// 只能在没有job运行时调用
+	void Initialize(uint32_t threadCount = 0);
+	void Shutdown();
+
+	// 参与执行job的线程数，包括主线程
+	uint32_t GetThreadCount() const { return (uint32_t)mQueues.size(); }
+
+	void Run(Job job, JobCounter* counter = nullptr);
+	void Wait(JobCounter& counter);
+
+	// 把[begin, end)切成不大于grainSize的段并行执行func(first, last)，返回时全部完成
+	template<typename F>
+	void ParallelFor(size_t begin, size_t end, size_t grainSize, F&& func)
+	{
+		if (begin >= end)
+			return;
+		if (grainSize == 0)
+			grainSize = 1;
+
+		if (end - begin <= grainSize || GetThreadCount() == 1)
+		{
+			func(begin, end);
+			return;
+		}
+
+		JobCounter counter;
+		for (size_t first = begin; first < end; first += grainSize)
+		{
+			size_t last = end - first > grainSize ? first + grainSize : end;
+			Run([&func, first, last]() { func(first, last); }, &counter);
+		}
+		Wait(counter);
+	}
+
+private:
+	JobSystem() { Initialize(); }
+
+	struct Task
+	{
+		Job Func;
+		JobCounter* Counter = nullptr;
+	};
+
+	struct WorkQueue
+	{
+		std::mutex Mutex;
+		std::deque<Task> Tasks;
+	};
+
+	bool TryPop(uint32_t index, Task& task);
+	bool TrySteal(uint32_t thief, Task& task);
+	bool ExecuteOne(uint32_t index);
+	void Execute(Task& task);
+	void WorkerLoop(uint32_t index);
+	uint32_t CurrentQueueIndex() const;
+
+	std::vector<std::unique_ptr<WorkQueue>> mQueues;
+	std::vector<std::thread> mWorkers;
+
+	std::atomic<int> mQueuedTasks = 0;
+	std::atomic<bool> mStop = false;
+	std::mutex mWakeMutex;
+	std::condition_variable mWakeCondition;
+};
+
+// 有依赖关系的job图，每帧可以重复Execute
+// 没有依赖的节点立即入队，节点完成后把依赖计数归零的后继节点入队
+class JobGraph
+{
+public:
+	using NodeId = uint32_t;
+
+	NodeId AddJob(const std::string& name, JobSystem::Job func);
+	// before完成后after才会开始
+	void AddDependency(NodeId before, NodeId after);
+
+	void Execute(JobSystem* jobSystem = JobSystem::GetInstance());
+	void Clear() { mNodes.clear(); }
+
+	size_t Size() const { return mNodes.size(); }
+	const std::string& GetName(NodeId id) const { return mNodes[id]->Name; }
+
+private:
+	struct Node
+	{
+		std::string Name;
+		JobSystem::Job Func;
+		std::vector<NodeId> Successors;
+		uint32_t DependencyCount = 0;
+		std::atomic<uint32_t> Remaining = 0;
+	};
+
+	void Schedule(JobSystem* jobSystem, NodeId id, JobCounter& counter);
+	bool IsAcyclic() const;
+
+	std::vector<std::unique_ptr<Node>> mNodes;
+};
+
+}
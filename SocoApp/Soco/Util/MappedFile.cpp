@@ -0,0 +1,77 @@
+#include "MappedFile.h"
+
+#include <iostream>
+
+namespace Soco
+{
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "无法打开文件：" << path << "，错误码" << GetLastError() << std::endl;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+	{
+		std::cout << "文件为空或无法获取大小：" << path << std::endl;
+		Close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMapping == nullptr)
+	{
+		std::cout << "无法创建文件映射：" << path << "，错误码" << GetLastError() << std::endl;
+		Close();
+		return false;
+	}
+
+	mData = MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+	if (mData == nullptr)
+	{
+		std::cout << "无法映射文件：" << path << "，错误码" << GetLastError() << std::endl;
+		Close();
+		return false;
+	}
+
+	mSize = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+	if (mMapping != nullptr)
+		CloseHandle(mMapping);
+	if (mFile != INVALID_HANDLE_VALUE)
+		CloseHandle(mFile);
+
+	mData = nullptr;
+	mMapping = nullptr;
+	mFile = INVALID_HANDLE_VALUE;
+	mSize = 0;
+}
+
+void MappedFile::Prefetch() const
+{
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN8
+	if (mData == nullptr)
+		return;
+
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = const_cast<void*>(mData);
+	range.NumberOfBytes = mSize;
+	//只是提示，失败了也会在访问时正常缺页读入
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+}
+
+}
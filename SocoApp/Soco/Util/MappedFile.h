@@ -0,0 +1,40 @@
+#pragma once
+
+#include <windows.h>
+#include <string>
+
+namespace Soco
+{
+
+/*
+只读的内存映射文件，打开时只建立映射，页面在第一次访问时才从磁盘读入
+Data()在Close或析构之前一直有效，可以直接交给CreateDefaultBuffer之类的拷贝函数
+*/
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { Close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// 失败时打印原因并返回false，空文件也算失败
+	bool Open(const std::string& path);
+	void Close();
+
+	// 提示系统把整个文件按大块读进来，之后顺序访问不会再逐页缺页
+	void Prefetch() const;
+
+	bool IsOpen() const { return mData != nullptr; }
+	const void* Data() const { return mData; }
+	size_t Size() const { return mSize; }
+
+private:
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+	const void* mData = nullptr;
+	size_t mSize = 0;
+};
+
+}
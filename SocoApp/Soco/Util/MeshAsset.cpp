@@ -0,0 +1,619 @@
+#include "MeshAsset.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+#include "../../Common/d3dUtil.h"
+#include "../GeometryArena.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+#include "VertexCompression.h"
+
+using Vertex = GeometryGenerator::Vertex;
+using MeshData = GeometryGenerator::MeshData;
+using DirectX::XMFLOAT2;
+using DirectX::XMFLOAT3;
+
+namespace Soco
+{
+
+namespace
+{
+
+uint64_t AlignOffset(uint64_t offset)
+{
+	return (offset + MeshAssetAlignment - 1) / MeshAssetAlignment * MeshAssetAlignment;
+}
+
+bool SectionInRange(uint64_t offset, uint64_t byteSize, size_t fileSize)
+{
+	return offset % MeshAssetAlignment == 0 && offset <= fileSize && byteSize <= fileSize - offset;
+}
+
+template<class T>
+void AppendBytes(std::vector<uint8_t>& bytes, const T* data, size_t count)
+{
+	const uint8_t* begin = (const uint8_t*)data;
+	bytes.insert(bytes.end(), begin, begin + count * sizeof(T));
+}
+
+void EncodeVertices(const std::vector<Vertex>& vertices, MeshVertexFormat format, std::vector<uint8_t>& out)
+{
+	if (format == MeshVertexFormat::Packed)
+	{
+		std::vector<PackedVertex> packed = PackVertices(vertices);
+		AppendBytes(out, packed.data(), packed.size());
+		return;
+	}
+
+	for (const Vertex& v : vertices)
+	{
+		const float data[8] = { v.Position.x, v.Position.y, v.Position.z, v.Normal.x, v.Normal.y, v.Normal.z, v.TexC.x, v.TexC.y };
+		AppendBytes(out, data, 8);
+	}
+}
+
+struct Float3
+{
+	float x = 0, y = 0, z = 0;
+
+	Float3() = default;
+	Float3(float x, float y, float z) : x(x), y(y), z(z) {}
+	Float3(const XMFLOAT3& v) : x(v.x), y(v.y), z(v.z) {}
+
+	Float3 operator+ (const Float3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+	Float3 operator- (const Float3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+	Float3 operator* (float s) const { return { x * s, y * s, z * s }; }
+	float Dot(const Float3& o) const { return x * o.x + y * o.y + z * o.z; }
+	Float3 Cross(const Float3& o) const { return { y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x }; }
+	float Length() const { return std::sqrt(Dot(*this)); }
+	XMFLOAT3 Normalized() const
+	{
+		float length = Length();
+		return length > 0.0f ? XMFLOAT3(x / length, y / length, z / length) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+	}
+};
+
+// 给没有法线的顶点补面积加权法线，再由UV计算切线；三角形正面按D3D的顺时针
+void ComputeNormalsAndTangents(MeshData& mesh, const std::vector<bool>& missingNormal)
+{
+	std::vector<Float3> normals(mesh.Vertices.size());
+	std::vector<Float3> tangents(mesh.Vertices.size());
+	for (size_t t = 0; t + 2 < mesh.Indices32.size(); t += 3)
+	{
+		const uint32_t i0 = mesh.Indices32[t], i1 = mesh.Indices32[t + 1], i2 = mesh.Indices32[t + 2];
+		const Vertex& v0 = mesh.Vertices[i0];
+		const Vertex& v1 = mesh.Vertices[i1];
+		const Vertex& v2 = mesh.Vertices[i2];
+
+		Float3 e1 = Float3(v1.Position) - Float3(v0.Position);
+		Float3 e2 = Float3(v2.Position) - Float3(v0.Position);
+		//叉积长度是面积的两倍，不归一化就是面积加权
+		Float3 faceNormal = e1.Cross(e2);
+
+		float du1 = v1.TexC.x - v0.TexC.x, dv1 = v1.TexC.y - v0.TexC.y;
+		float du2 = v2.TexC.x - v0.TexC.x, dv2 = v2.TexC.y - v0.TexC.y;
+		float det = du1 * dv2 - du2 * dv1;
+		Float3 faceTangent = std::abs(det) > 1e-12f ? (e1 * dv2 - e2 * dv1) * (1.0f / det) : Float3();
+
+		for (uint32_t i : { i0, i1, i2 })
+		{
+			normals[i] = normals[i] + faceNormal;
+			tangents[i] = tangents[i] + faceTangent;
+		}
+	}
+
+	for (size_t i = 0; i < mesh.Vertices.size(); ++i)
+	{
+		Vertex& v = mesh.Vertices[i];
+		v.Normal = missingNormal[i] ? normals[i].Normalized() : Float3(v.Normal).Normalized();
+
+		//切线对法线做Gram-Schmidt，UV退化时取任意一个垂直方向
+		Float3 n(v.Normal);
+		Float3 tangent = tangents[i] - n * n.Dot(tangents[i]);
+		if (tangent.Length() < 1e-6f)
+		{
+			Float3 axis = std::abs(n.x) < 0.9f ? Float3(1.0f, 0.0f, 0.0f) : Float3(0.0f, 1.0f, 0.0f);
+			tangent = axis - n * n.Dot(axis);
+		}
+		v.TangentU = tangent.Normalized();
+	}
+}
+
+// OBJ索引从1开始，负数相对当前末尾；缺省返回-1，越界返回false
+bool ResolveObjIndex(const std::string& token, size_t count, int& out)
+{
+	out = -1;
+	if (token.empty())
+		return true;
+
+	long index = strtol(token.c_str(), nullptr, 10);
+	long resolved = index > 0 ? index - 1 : (long)count + index;
+	if (index == 0 || resolved < 0 || resolved >= (long)count)
+		return false;
+	out = (int)resolved;
+	return true;
+}
+
+bool ParseObj(const std::string& path, std::vector<MeshAssetSourceSubmesh>& out)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cout << "无法打开OBJ文件：" << path << std::endl;
+		return false;
+	}
+
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT3> normals;
+	std::vector<XMFLOAT2> texcoords;
+
+	std::string groupName = "default";
+	std::string materialName;
+	MeshAssetSourceSubmesh current;
+	std::map<std::tuple<int, int, int>, uint32_t> remap;
+	std::vector<bool> missingNormal;
+	size_t skippedFaces = 0;
+
+	auto flush = [&]() {
+		if (!current.Mesh.Indices32.empty())
+		{
+			ComputeNormalsAndTangents(current.Mesh, missingNormal);
+			out.push_back(std::move(current));
+		}
+		current = MeshAssetSourceSubmesh();
+		current.Name = materialName.empty() ? groupName : groupName + "/" + materialName;
+		remap.clear();
+		missingNormal.clear();
+	};
+	flush();
+
+	std::string line;
+	std::vector<uint32_t> face;
+	while (std::getline(file, line))
+	{
+		std::istringstream ls(line);
+		std::string tag;
+		ls >> tag;
+
+		//转到左手系：z取反；V坐标从下往上改成从上往下
+		if (tag == "v")
+		{
+			XMFLOAT3 p;
+			ls >> p.x >> p.y >> p.z;
+			positions.push_back({ p.x, p.y, -p.z });
+		}
+		else if (tag == "vt")
+		{
+			XMFLOAT2 uv;
+			ls >> uv.x >> uv.y;
+			texcoords.push_back({ uv.x, 1.0f - uv.y });
+		}
+		else if (tag == "vn")
+		{
+			XMFLOAT3 n;
+			ls >> n.x >> n.y >> n.z;
+			normals.push_back({ n.x, n.y, -n.z });
+		}
+		else if (tag == "o" || tag == "g" || tag == "usemtl")
+		{
+			std::string name;
+			std::getline(ls >> std::ws, name);
+			while (!name.empty() && (name.back() == '\r' || name.back() == ' '))
+				name.pop_back();
+
+			if (tag == "usemtl")
+				materialName = name;
+			else
+				groupName = name.empty() ? "default" : name;
+			flush();
+		}
+		else if (tag == "f")
+		{
+			face.clear();
+			bool valid = true;
+			std::string token;
+			while (ls >> token)
+			{
+				//v、v/vt、v//vn、v/vt/vn
+				std::string parts[3];
+				size_t start = 0;
+				for (int k = 0; k < 3 && start <= token.size(); ++k)
+				{
+					size_t slash = token.find('/', start);
+					parts[k] = token.substr(start, slash == std::string::npos ? std::string::npos : slash - start);
+					if (slash == std::string::npos)
+						break;
+					start = slash + 1;
+				}
+
+				int p, t, n;
+				if (parts[0].empty() || !ResolveObjIndex(parts[0], positions.size(), p) ||
+					!ResolveObjIndex(parts[1], texcoords.size(), t) || !ResolveObjIndex(parts[2], normals.size(), n))
+				{
+					valid = false;
+					break;
+				}
+
+				auto key = std::make_tuple(p, t, n);
+				auto found = remap.find(key);
+				if (found == remap.end())
+				{
+					Vertex v;
+					v.Position = positions[p];
+					v.Normal = n >= 0 ? normals[n] : XMFLOAT3(0.0f, 0.0f, 0.0f);
+					v.TangentU = XMFLOAT3(0.0f, 0.0f, 0.0f);
+					v.TexC = t >= 0 ? texcoords[t] : XMFLOAT2(0.0f, 0.0f);
+					found = remap.emplace(key, (uint32_t)current.Mesh.Vertices.size()).first;
+					current.Mesh.Vertices.push_back(v);
+					missingNormal.push_back(n < 0);
+				}
+				face.push_back(found->second);
+			}
+
+			if (!valid || face.size() < 3)
+			{
+				++skippedFaces;
+				continue;
+			}
+
+			//扇形三角化，镜像之后绕序要翻转才是顺时针
+			for (size_t k = 1; k + 1 < face.size(); ++k)
+			{
+				current.Mesh.Indices32.push_back(face[0]);
+				current.Mesh.Indices32.push_back(face[k + 1]);
+				current.Mesh.Indices32.push_back(face[k]);
+			}
+		}
+	}
+	flush();
+
+	if (skippedFaces > 0)
+		std::cout << "OBJ里有" << skippedFaces << "个面的索引无效，已跳过" << std::endl;
+	if (out.empty())
+	{
+		std::cout << "OBJ里没有三角形：" << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+}
+
+uint32_t GetVertexStride(MeshVertexFormat format)
+{
+	return format == MeshVertexFormat::Packed ? (uint32_t)sizeof(PackedVertex) : FloatVertexStride;
+}
+
+bool MeshAssetView::Open(const void* data, size_t size)
+{
+	mData = nullptr;
+	mHeader = nullptr;
+	mSubmeshes = nullptr;
+
+	auto fail = [](const char* reason) {
+		std::cout << "网格文件无效：" << reason << std::endl;
+		return false;
+	};
+
+	if (size < sizeof(MeshAssetHeader))
+		return fail("比文件头还小");
+
+	const MeshAssetHeader* header = (const MeshAssetHeader*)data;
+	if (header->Magic != MeshAssetMagic)
+		return fail("文件标识不对");
+	if (header->Version != MeshAssetVersion)
+		return fail("版本不支持");
+	if (header->FileSize != size)
+		return fail("文件大小与文件头不符，可能被截断");
+	if (header->VertexFormat > (uint32_t)MeshVertexFormat::Packed || header->VertexStride != GetVertexStride((MeshVertexFormat)header->VertexFormat))
+		return fail("顶点格式不对");
+	if (header->IndexStride != 2 && header->IndexStride != 4)
+		return fail("索引格式不对");
+	if (header->VertexCount == 0 || header->IndexCount == 0 || header->SubmeshCount == 0)
+		return fail("网格是空的");
+
+	if (!SectionInRange(header->VertexOffset, (uint64_t)header->VertexCount * header->VertexStride, size) ||
+		!SectionInRange(header->IndexOffset, (uint64_t)header->IndexCount * header->IndexStride, size) ||
+		!SectionInRange(header->SubmeshOffset, (uint64_t)header->SubmeshCount * sizeof(MeshAssetSubmesh), size) ||
+		!SectionInRange(header->MeshletOffset, (uint64_t)header->MeshletCount * sizeof(Meshlet), size) ||
+		!SectionInRange(header->MeshletBoundsOffset, (uint64_t)header->MeshletCount * sizeof(MeshletBounds), size) ||
+		!SectionInRange(header->MeshletVertexOffset, (uint64_t)header->MeshletVertexCount * sizeof(uint32_t), size) ||
+		!SectionInRange(header->MeshletTriangleOffset, header->MeshletTriangleByteCount, size))
+		return fail("段超出文件范围");
+
+	//只检查子网格的范围；索引值本身不检查，越界的顶点读取在D3D12里返回0
+	const MeshAssetSubmesh* submeshes = (const MeshAssetSubmesh*)((const uint8_t*)data + header->SubmeshOffset);
+	for (uint32_t i = 0; i < header->SubmeshCount; ++i)
+	{
+		const MeshAssetSubmesh& s = submeshes[i];
+		if ((uint64_t)s.StartIndex + s.IndexCount > header->IndexCount ||
+			s.BaseVertex < 0 || (uint64_t)s.BaseVertex + s.VertexCount > header->VertexCount ||
+			(uint64_t)s.FirstMeshlet + s.MeshletCount > header->MeshletCount ||
+			(uint64_t)s.FirstMeshletVertex + s.MeshletVertexCount > header->MeshletVertexCount ||
+			(uint64_t)s.FirstMeshletTriangleByte + s.MeshletTriangleByteCount > header->MeshletTriangleByteCount ||
+			s.Name[MeshAssetNameLength - 1] != '\0')
+			return fail("子网格范围越界");
+	}
+
+	mData = (const uint8_t*)data;
+	mHeader = header;
+	mSubmeshes = submeshes;
+	return true;
+}
+
+bool MeshAssetView::CopyMeshlets(uint32_t submesh, MeshletSet& out) const
+{
+	const MeshAssetSubmesh& s = mSubmeshes[submesh];
+	const Meshlet* meshlets = (const Meshlet*)(mData + mHeader->MeshletOffset) + s.FirstMeshlet;
+	const MeshletBounds* bounds = (const MeshletBounds*)(mData + mHeader->MeshletBoundsOffset) + s.FirstMeshlet;
+	const uint32_t* vertices = (const uint32_t*)(mData + mHeader->MeshletVertexOffset) + s.FirstMeshletVertex;
+	const uint8_t* triangles = mData + mHeader->MeshletTriangleOffset + s.FirstMeshletTriangleByte;
+
+	out.Meshlets.assign(meshlets, meshlets + s.MeshletCount);
+	out.Bounds.assign(bounds, bounds + s.MeshletCount);
+	out.Vertices.assign(vertices, vertices + s.MeshletVertexCount);
+	out.Triangles.assign(triangles, triangles + s.MeshletTriangleByteCount);
+	out.TriangleCount = s.MeshletTriangleCount;
+
+	//CullMeshlets按这些偏移和序号直接取数组，坏文件不能让它越界
+	uint64_t triangleCount = 0;
+	for (const Meshlet& m : out.Meshlets)
+	{
+		if (m.VertexCount > MaxMeshletVertices || m.TriangleCount > MaxMeshletTriangles ||
+			(uint64_t)m.VertexOffset + m.VertexCount > out.Vertices.size() ||
+			((uint64_t)m.TriangleOffset + m.TriangleCount) * 3 > out.Triangles.size())
+			return false;
+
+		const uint8_t* local = &out.Triangles[(size_t)m.TriangleOffset * 3];
+		for (uint32_t i = 0; i < m.TriangleCount * 3; ++i)
+			if (local[i] >= m.VertexCount)
+				return false;
+		triangleCount += m.TriangleCount;
+	}
+	for (uint32_t v : out.Vertices)
+		if (v >= s.VertexCount)
+			return false;
+
+	return triangleCount == out.TriangleCount;
+}
+
+bool WriteMeshAsset(const std::string& path, const std::vector<MeshAssetSourceSubmesh>& submeshes, MeshVertexFormat format, bool buildMeshlets)
+{
+	MeshAssetHeader header = {};
+	header.Magic = MeshAssetMagic;
+	header.Version = MeshAssetVersion;
+	header.VertexFormat = (uint32_t)format;
+	header.VertexStride = GetVertexStride(format);
+	header.SubmeshCount = (uint32_t)submeshes.size();
+
+	//索引相对子网格自己的顶点，只看最大的子网格
+	size_t maxVertexCount = 0;
+	for (const MeshAssetSourceSubmesh& source : submeshes)
+		maxVertexCount = std::max<size_t>(maxVertexCount, source.Mesh.Vertices.size());
+	header.IndexStride = maxVertexCount <= 0x10000 ? 2 : 4;
+
+	std::vector<MeshAssetSubmesh> table(submeshes.size());
+	std::vector<uint8_t> vertexBytes;
+	std::vector<uint8_t> indexBytes;
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshletBounds> meshletBounds;
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint8_t> meshletTriangles;
+
+	for (size_t i = 0; i < submeshes.size(); ++i)
+	{
+		const MeshData& mesh = submeshes[i].Mesh;
+		MeshAssetSubmesh& entry = table[i];
+		memset(&entry, 0, sizeof(entry));
+		memcpy(entry.Name, submeshes[i].Name.data(), std::min<size_t>(submeshes[i].Name.size(), MeshAssetNameLength - 1));
+		entry.IndexCount = (uint32_t)mesh.Indices32.size();
+		entry.StartIndex = header.IndexCount;
+		entry.BaseVertex = (int32_t)header.VertexCount;
+		entry.VertexCount = (uint32_t)mesh.Vertices.size();
+
+		if (!mesh.Vertices.empty())
+		{
+			const XMFLOAT3& first = mesh.Vertices[0].Position;
+			float boundsMin[3] = { first.x, first.y, first.z };
+			float boundsMax[3] = { first.x, first.y, first.z };
+			for (const Vertex& v : mesh.Vertices)
+			{
+				const float p[3] = { v.Position.x, v.Position.y, v.Position.z };
+				for (int k = 0; k < 3; ++k)
+				{
+					boundsMin[k] = std::min<float>(boundsMin[k], p[k]);
+					boundsMax[k] = std::max<float>(boundsMax[k], p[k]);
+				}
+			}
+			memcpy(entry.BoundsMin, boundsMin, sizeof(boundsMin));
+			memcpy(entry.BoundsMax, boundsMax, sizeof(boundsMax));
+		}
+
+		EncodeVertices(mesh.Vertices, format, vertexBytes);
+		if (header.IndexStride == 2)
+		{
+			for (uint32_t index : mesh.Indices32)
+			{
+				uint16_t index16 = (uint16_t)index;
+				AppendBytes(indexBytes, &index16, 1);
+			}
+		}
+		else
+		{
+			AppendBytes(indexBytes, mesh.Indices32.data(), mesh.Indices32.size());
+		}
+
+		if (buildMeshlets && !mesh.Indices32.empty())
+		{
+			MeshletSet set = BuildMeshlets(mesh.Indices32.data(), mesh.Indices32.size(),
+				&mesh.Vertices[0].Position.x, mesh.Vertices.size(), sizeof(Vertex));
+
+			entry.FirstMeshlet = (uint32_t)meshlets.size();
+			entry.MeshletCount = (uint32_t)set.Meshlets.size();
+			entry.FirstMeshletVertex = (uint32_t)meshletVertices.size();
+			entry.MeshletVertexCount = (uint32_t)set.Vertices.size();
+			entry.FirstMeshletTriangleByte = (uint32_t)meshletTriangles.size();
+			entry.MeshletTriangleByteCount = (uint32_t)set.Triangles.size();
+			entry.MeshletTriangleCount = set.TriangleCount;
+
+			meshlets.insert(meshlets.end(), set.Meshlets.begin(), set.Meshlets.end());
+			meshletBounds.insert(meshletBounds.end(), set.Bounds.begin(), set.Bounds.end());
+			meshletVertices.insert(meshletVertices.end(), set.Vertices.begin(), set.Vertices.end());
+			meshletTriangles.insert(meshletTriangles.end(), set.Triangles.begin(), set.Triangles.end());
+		}
+
+		header.VertexCount += entry.VertexCount;
+		header.IndexCount += entry.IndexCount;
+	}
+
+	header.MeshletCount = (uint32_t)meshlets.size();
+	header.MeshletVertexCount = (uint32_t)meshletVertices.size();
+	header.MeshletTriangleByteCount = (uint32_t)meshletTriangles.size();
+
+	struct Section
+	{
+		uint64_t* Offset;
+		const void* Data;
+		size_t Size;
+	};
+	const Section sections[] =
+	{
+		{ &header.VertexOffset, vertexBytes.data(), vertexBytes.size() },
+		{ &header.IndexOffset, indexBytes.data(), indexBytes.size() },
+		{ &header.SubmeshOffset, table.data(), table.size() * sizeof(MeshAssetSubmesh) },
+		{ &header.MeshletOffset, meshlets.data(), meshlets.size() * sizeof(Meshlet) },
+		{ &header.MeshletBoundsOffset, meshletBounds.data(), meshletBounds.size() * sizeof(MeshletBounds) },
+		{ &header.MeshletVertexOffset, meshletVertices.data(), meshletVertices.size() * sizeof(uint32_t) },
+		{ &header.MeshletTriangleOffset, meshletTriangles.data(), meshletTriangles.size() },
+	};
+
+	uint64_t offset = sizeof(MeshAssetHeader);
+	for (const Section& section : sections)
+	{
+		offset = AlignOffset(offset);
+		*section.Offset = offset;
+		offset += section.Size;
+	}
+	header.FileSize = offset;
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "无法写入网格文件：" << path << std::endl;
+		return false;
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	uint64_t written = sizeof(header);
+	const char padding[MeshAssetAlignment] = {};
+	for (const Section& section : sections)
+	{
+		file.write(padding, *section.Offset - written);
+		file.write((const char*)section.Data, section.Size);
+		written = *section.Offset + section.Size;
+	}
+	return (bool)file;
+}
+
+bool ConvertObjToMeshAsset(const std::string& objPath, const std::string& outPath, MeshVertexFormat format)
+{
+	uint64_t begin = Profiler::Now();
+
+	std::vector<MeshAssetSourceSubmesh> submeshes;
+	if (!ParseObj(objPath, submeshes))
+		return false;
+
+	size_t vertexCount = 0;
+	size_t triangleCount = 0;
+	for (MeshAssetSourceSubmesh& submesh : submeshes)
+	{
+		OptimizeMesh(submesh.Mesh);
+		vertexCount += submesh.Mesh.Vertices.size();
+		triangleCount += submesh.Mesh.Indices32.size() / 3;
+
+		//重复平铺的UV和超出half范围的坐标不能压缩
+		if (format == MeshVertexFormat::Packed && !CheckQuantizationError(submesh.Mesh.Vertices, PackVertices(submesh.Mesh.Vertices)))
+		{
+			std::cout << "子网格" << submesh.Name << "不适合压缩，改用Float顶点格式" << std::endl;
+			format = MeshVertexFormat::Float;
+		}
+	}
+
+	if (!WriteMeshAsset(outPath, submeshes, format))
+		return false;
+
+	std::cout << "转换完成：" << objPath << " -> " << outPath << "，" << submeshes.size() << "个子网格，"
+		<< vertexCount << "个顶点，" << triangleCount << "个三角形，"
+		<< (format == MeshVertexFormat::Packed ? "Packed" : "Float") << "顶点，耗时"
+		<< (Profiler::Now() - begin) / 1e6 << "ms" << std::endl;
+	return true;
+}
+
+std::unique_ptr<MeshGeometry> LoadMeshGeometry(const std::string& path, const std::string& name, MeshVertexFormat expectedFormat,
+	ID3D12GraphicsCommandList* cmdList)
+{
+	uint64_t begin = Profiler::Now();
+
+	MappedFile file;
+	if (!file.Open(path))
+		return nullptr;
+
+	MeshAssetView asset;
+	if (!asset.Open(file.Data(), file.Size()))
+		return nullptr;
+	if (asset.GetVertexFormat() != expectedFormat)
+	{
+		std::cout << "网格文件的顶点格式与当前shader不一致，需要重新转换：" << path << std::endl;
+		return nullptr;
+	}
+
+	//顶点和索引占了文件的绝大部分，一次预读，拷贝时不再逐页缺页
+	file.Prefetch();
+
+	const MeshAssetHeader& header = asset.GetHeader();
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = name;
+
+	geo->VertexByteStride = header.VertexStride;
+	geo->IndexFormat = header.IndexStride == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	GeometryArena::GetInstance()->Upload(cmdList, geo.get(), asset.GetVertexData(), asset.GetVertexDataSize(),
+		asset.GetIndexData(), asset.GetIndexDataSize());
+
+	for (uint32_t i = 0; i < asset.GetSubmeshCount(); ++i)
+	{
+		const MeshAssetSubmesh& source = asset.GetSubmesh(i);
+
+		SubmeshGeometry submesh;
+		submesh.IndexCount = source.IndexCount;
+		submesh.StartIndexLocation = source.StartIndex;
+		submesh.BaseVertexLocation = source.BaseVertex;
+
+		DirectX::XMFLOAT3 boundsMin(source.BoundsMin);
+		DirectX::XMFLOAT3 boundsMax(source.BoundsMax);
+		DirectX::BoundingBox::CreateFromPoints(submesh.Bounds, DirectX::XMLoadFloat3(&boundsMin), DirectX::XMLoadFloat3(&boundsMax));
+
+		if (source.MeshletCount > 0)
+		{
+			auto meshlets = std::make_shared<MeshletSet>();
+			if (asset.CopyMeshlets(i, *meshlets))
+				submesh.Meshlets = std::move(meshlets);
+			else
+				std::cout << "meshlet数据损坏，子网格不做剔除：" << source.Name << std::endl;
+		}
+
+		geo->DrawArgs[source.Name] = submesh;
+	}
+
+	std::cout << "加载网格" << path << "：" << file.Size() / 1024 << "KB，耗时" << (Profiler::Now() - begin) / 1e6 << "ms" << std::endl;
+	return geo;
+}
+
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../Common/GeometryGenerator.h"
+#include "Meshlet.h"
+
+struct MeshGeometry;
+struct ID3D12GraphicsCommandList;
+
+namespace Soco
+{
+
+/*
+二进制网格文件(.smesh)，小端，所有段按MeshAssetAlignment对齐，加载时不做任何解析：
+[MeshAssetHeader][顶点][索引][MeshAssetSubmesh表][Meshlet表][MeshletBounds表][meshlet顶点映射][meshlet三角形]
+顶点和索引段就是GPU缓冲的内容，映射文件后直接拷进上传堆
+每个子网格的索引相对自己的BaseVertex，meshlet的各项偏移相对子网格自己的那一段，与MeshletSet一致
+*/
+constexpr uint32_t MeshAssetMagic = 0x48534D53; // "SMSH"
+constexpr uint32_t MeshAssetVersion = 1;
+constexpr uint32_t MeshAssetAlignment = 16;
+constexpr uint32_t MeshAssetNameLength = 32;
+
+enum class MeshVertexFormat : uint32_t
+{
+	// Pos/Normal float3 + TexC float2，32字节，与SocoApp的Vertex相同
+	Float = 0,
+	// PackedVertex，20字节，见VertexCompression.h
+	Packed = 1,
+};
+
+constexpr uint32_t FloatVertexStride = 32;
+
+uint32_t GetVertexStride(MeshVertexFormat format);
+
+struct MeshAssetHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t VertexFormat;
+	uint32_t VertexStride;
+	uint32_t VertexCount;
+	// 2或4
+	uint32_t IndexStride;
+	uint32_t IndexCount;
+	uint32_t SubmeshCount;
+	uint32_t MeshletCount;
+	uint32_t MeshletVertexCount;
+	uint32_t MeshletTriangleByteCount;
+	uint32_t Reserved;
+
+	uint64_t VertexOffset;
+	uint64_t IndexOffset;
+	uint64_t SubmeshOffset;
+	uint64_t MeshletOffset;
+	uint64_t MeshletBoundsOffset;
+	uint64_t MeshletVertexOffset;
+	uint64_t MeshletTriangleOffset;
+	uint64_t FileSize;
+};
+
+struct MeshAssetSubmesh
+{
+	// 以0结尾，超长的名字被截断
+	char Name[MeshAssetNameLength];
+	uint32_t IndexCount;
+	uint32_t StartIndex;
+	int32_t BaseVertex;
+	uint32_t VertexCount;
+	float BoundsMin[3];
+	float BoundsMax[3];
+
+	// 在各meshlet表里的范围，没有meshlet时都是0
+	uint32_t FirstMeshlet;
+	uint32_t MeshletCount;
+	uint32_t FirstMeshletVertex;
+	uint32_t MeshletVertexCount;
+	uint32_t FirstMeshletTriangleByte;
+	uint32_t MeshletTriangleByteCount;
+	uint32_t MeshletTriangleCount;
+	uint32_t Reserved;
+};
+
+static_assert(sizeof(MeshAssetHeader) == 112, "MeshAssetHeader布局变了需要升级MeshAssetVersion");
+static_assert(sizeof(MeshAssetSubmesh) == 104, "MeshAssetSubmesh布局变了需要升级MeshAssetVersion");
+static_assert(sizeof(Meshlet) == 16 && sizeof(MeshletBounds) == 32, "Meshlet布局变了需要升级MeshAssetVersion");
+
+/*
+对一块内存里的.smesh做只读访问，Open只检查头和各段的范围，返回的指针都指向原内存
+内存(通常是MappedFile)要比这个对象活得久
+*/
+class MeshAssetView
+{
+public:
+	// 失败时打印原因并返回false
+	bool Open(const void* data, size_t size);
+
+	const MeshAssetHeader& GetHeader() const { return *mHeader; }
+	MeshVertexFormat GetVertexFormat() const { return (MeshVertexFormat)mHeader->VertexFormat; }
+
+	const void* GetVertexData() const { return mData + mHeader->VertexOffset; }
+	size_t GetVertexDataSize() const { return (size_t)mHeader->VertexCount * mHeader->VertexStride; }
+	const void* GetIndexData() const { return mData + mHeader->IndexOffset; }
+	size_t GetIndexDataSize() const { return (size_t)mHeader->IndexCount * mHeader->IndexStride; }
+
+	uint32_t GetSubmeshCount() const { return mHeader->SubmeshCount; }
+	const MeshAssetSubmesh& GetSubmesh(uint32_t i) const { return mSubmeshes[i]; }
+
+	// 把子网格的meshlet拷成MeshletSet，meshlet内的偏移或序号越界时返回false
+	bool CopyMeshlets(uint32_t submesh, MeshletSet& out) const;
+
+private:
+	const uint8_t* mData = nullptr;
+	const MeshAssetHeader* mHeader = nullptr;
+	const MeshAssetSubmesh* mSubmeshes = nullptr;
+};
+
+// 写文件前的一个子网格，索引相对这个子网格自己的顶点
+struct MeshAssetSourceSubmesh
+{
+	std::string Name;
+	GeometryGenerator::MeshData Mesh;
+};
+
+/*
+按format编码顶点，为每个子网格计算包围盒并构建meshlet，写出.smesh
+所有子网格的顶点数都不超过65535时使用16位索引
+*/
+bool WriteMeshAsset(const std::string& path, const std::vector<MeshAssetSourceSubmesh>& submeshes, MeshVertexFormat format, bool buildMeshlets = true);
+
+/*
+离线转换：读取Wavefront OBJ(v/vt/vn/f，o、g、usemtl开始新的子网格，多边形按扇形三角化)
+转换到D3D的左手系(z取反、翻转绕序)，V坐标翻转，没有法线的补面积加权法线，切线由UV计算
+每个子网格经过OptimizeMesh后写出；Packed格式要求UV在[0,1]内，量化误差超限时退回Float格式
+*/
+bool ConvertObjToMeshAsset(const std::string& objPath, const std::string& outPath, MeshVertexFormat format);
+
+/*
+映射.smesh，顶点和索引从映射的页面直接拷进上传堆，再放进共享几何缓冲(GeometryArena)，不保留CPU副本
+顶点格式与expectedFormat不一致时返回nullptr(shader的输入布局是按格式编译的)
+每个子网格按名字放进DrawArgs，带meshlet的子网格同时填好Meshlets
+*/
+std::unique_ptr<MeshGeometry> LoadMeshGeometry(const std::string& path, const std::string& name, MeshVertexFormat expectedFormat,
+	ID3D12GraphicsCommandList* cmdList);
+
+}
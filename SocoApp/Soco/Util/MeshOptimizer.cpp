@@ -0,0 +1,380 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+using Vertex = GeometryGenerator::Vertex;
+using MeshData = GeometryGenerator::MeshData;
+
+namespace Soco
+{
+
+namespace
+{
+
+// 每个顶点引用它的三角形，CSR格式
+struct VertexAdjacency
+{
+	std::vector<uint32_t> Offsets;
+	std::vector<uint32_t> Triangles;
+
+	VertexAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount)
+		: Offsets(vertexCount + 1, 0), Triangles(indices.size())
+	{
+		for (uint32_t index : indices)
+			++Offsets[index + 1];
+		std::partial_sum(Offsets.begin(), Offsets.end(), Offsets.begin());
+
+		std::vector<uint32_t> cursor(Offsets.begin(), Offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i)
+			Triangles[cursor[indices[i]]++] = (uint32_t)(i / 3);
+	}
+
+	uint32_t Count(uint32_t v) const { return Offsets[v + 1] - Offsets[v]; }
+};
+
+// FIFO缓存：未命中时记下时间戳，时间戳相差不超过cacheSize的顶点还在缓存里
+class FifoCache
+{
+public:
+	FifoCache(size_t vertexCount, uint32_t cacheSize)
+		: mTimestamps(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1)
+	{
+	}
+
+	// 返回是否未命中
+	bool Access(uint32_t v)
+	{
+		if (mTime - mTimestamps[v] <= mCacheSize)
+			return false;
+		mTimestamps[v] = mTime++;
+		return true;
+	}
+
+	void Reset() { mTime += mCacheSize + 1; }
+
+private:
+	std::vector<uint32_t> mTimestamps;
+	uint32_t mCacheSize;
+	uint32_t mTime;
+};
+
+struct Float3
+{
+	float x = 0, y = 0, z = 0;
+
+	Float3() = default;
+	Float3(float x, float y, float z) : x(x), y(y), z(z) {}
+	Float3(const DirectX::XMFLOAT3& v) : x(v.x), y(v.y), z(v.z) {}
+
+	Float3 operator+ (const Float3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+	Float3 operator- (const Float3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+	Float3 operator* (float s) const { return { x * s, y * s, z * s }; }
+	float Dot(const Float3& o) const { return x * o.x + y * o.y + z * o.z; }
+	Float3 Cross(const Float3& o) const { return { y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x }; }
+};
+
+using WeldKey = std::array<int64_t, 11>;
+
+struct WeldKeyHash
+{
+	size_t operator() (const WeldKey& key) const
+	{
+		size_t h = 14695981039346656037ull;
+		for (int64_t v : key)
+			h = (h ^ (size_t)v) * 1099511628211ull;
+		return h;
+	}
+};
+
+WeldKey MakeWeldKey(const Vertex& v, float epsilon)
+{
+	const float values[11] = { v.Position.x, v.Position.y, v.Position.z, v.Normal.x, v.Normal.y, v.Normal.z,
+		v.TangentU.x, v.TangentU.y, v.TangentU.z, v.TexC.x, v.TexC.y };
+	WeldKey key;
+	for (int i = 0; i < 11; ++i)
+		key[i] = std::llround(values[i] / epsilon);
+	return key;
+}
+
+int GetNextVertexDeadEnd(std::vector<uint32_t>& deadEnd, uint32_t& cursor, const std::vector<uint32_t>& liveTriangles)
+{
+	while (!deadEnd.empty())
+	{
+		uint32_t v = deadEnd.back();
+		deadEnd.pop_back();
+		if (liveTriangles[v] > 0)
+			return (int)v;
+	}
+
+	while (cursor < liveTriangles.size())
+	{
+		if (liveTriangles[cursor] > 0)
+			return (int)cursor;
+		++cursor;
+	}
+	return -1;
+}
+
+}
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats;
+	if (indices.empty())
+		return stats;
+
+	FifoCache cache(vertexCount, cacheSize);
+	std::vector<bool> used(vertexCount, false);
+	size_t usedCount = 0;
+	for (uint32_t index : indices)
+	{
+		if (cache.Access(index))
+			++stats.Misses;
+		if (!used[index])
+		{
+			used[index] = true;
+			++usedCount;
+		}
+	}
+
+	stats.Acmr = (float)stats.Misses / (indices.size() / 3);
+	stats.Atvr = (float)stats.Misses / usedCount;
+	return stats;
+}
+
+size_t WeldVertices(MeshData& mesh, float epsilon)
+{
+	std::unordered_map<WeldKey, uint32_t, WeldKeyHash> unique;
+	unique.reserve(mesh.Vertices.size());
+
+	std::vector<uint32_t> remap(mesh.Vertices.size());
+	std::vector<Vertex> vertices;
+	vertices.reserve(mesh.Vertices.size());
+	for (size_t i = 0; i < mesh.Vertices.size(); ++i)
+	{
+		auto [ite, inserted] = unique.emplace(MakeWeldKey(mesh.Vertices[i], epsilon), (uint32_t)vertices.size());
+		if (inserted)
+			vertices.push_back(mesh.Vertices[i]);
+		remap[i] = ite->second;
+	}
+
+	for (uint32_t& index : mesh.Indices32)
+		index = remap[index];
+
+	size_t removed = mesh.Vertices.size() - vertices.size();
+	mesh.Vertices = std::move(vertices);
+	return removed;
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* clusters)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if (clusters != nullptr)
+		clusters->assign(1, 0);
+	if (triangleCount == 0)
+		return;
+
+	VertexAdjacency adjacency(indices, vertexCount);
+
+	std::vector<uint32_t> liveTriangles(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		liveTriangles[v] = adjacency.Count(v);
+
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	uint32_t cursor = 0;
+	int fanning = GetNextVertexDeadEnd(deadEnd, cursor, liveTriangles);
+	while (fanning >= 0)
+	{
+		//把fanning周围还没输出的三角形全部输出
+		candidates.clear();
+		for (uint32_t k = adjacency.Offsets[fanning]; k < adjacency.Offsets[fanning + 1]; ++k)
+		{
+			uint32_t triangle = adjacency.Triangles[k];
+			if (emitted[triangle])
+				continue;
+
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				uint32_t v = indices[triangle * 3 + corner];
+				result.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				--liveTriangles[v];
+				if (time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+			emitted[triangle] = true;
+		}
+
+		//下一个扇形中心：输出它剩下的三角形后仍在缓存里的顶点中，进入缓存最早的
+		int next = -1;
+		uint32_t bestPriority = 0;
+		for (uint32_t v : candidates)
+		{
+			if (liveTriangles[v] == 0)
+				continue;
+
+			uint32_t priority = 0;
+			if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+				priority = time - cacheTime[v];
+			if (next < 0 || priority > bestPriority)
+			{
+				next = (int)v;
+				bestPriority = priority;
+			}
+		}
+
+		if (next < 0)
+		{
+			next = GetNextVertexDeadEnd(deadEnd, cursor, liveTriangles);
+			if (next >= 0 && clusters != nullptr)
+				clusters->push_back((uint32_t)(result.size() / 3));
+		}
+		fanning = next;
+	}
+
+	indices = std::move(result);
+}
+
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+	const std::vector<uint32_t>& hardClusters, uint32_t cacheSize, float threshold)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0 || hardClusters.empty())
+		return;
+
+	//软边界：从硬分块开头重新模拟缓存，ACMR降到分块整体的threshold倍以内时就可以切开，切开后缓存重新开始
+	std::vector<uint32_t> clusters;
+	FifoCache cache(vertices.size(), cacheSize);
+	for (size_t c = 0; c < hardClusters.size(); ++c)
+	{
+		const uint32_t begin = hardClusters[c];
+		const uint32_t end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : (uint32_t)triangleCount;
+		if (begin >= end)
+			continue;
+
+		cache.Reset();
+		size_t clusterMisses = 0;
+		for (uint32_t t = begin; t < end; ++t)
+		{
+			for (int corner = 0; corner < 3; ++corner)
+				clusterMisses += cache.Access(indices[t * 3 + corner]);
+		}
+		const float clusterThreshold = threshold * clusterMisses / (end - begin);
+
+		clusters.push_back(begin);
+		cache.Reset();
+		size_t misses = 0, faces = 0;
+		for (uint32_t t = begin; t < end; ++t)
+		{
+			for (int corner = 0; corner < 3; ++corner)
+				misses += cache.Access(indices[t * 3 + corner]);
+			++faces;
+
+			if (t + 1 < end && (float)misses / faces <= clusterThreshold)
+			{
+				clusters.push_back(t + 1);
+				cache.Reset();
+				misses = faces = 0;
+			}
+		}
+	}
+
+	//每个分块的面积加权中心和法线
+	struct ClusterInfo
+	{
+		uint32_t Begin = 0;
+		uint32_t End = 0;
+		float Sort = 0;
+	};
+	std::vector<ClusterInfo> infos(clusters.size());
+	std::vector<Float3> centroids(clusters.size());
+	std::vector<Float3> normals(clusters.size());
+	Float3 meshCentroid;
+	float meshArea = 0;
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		infos[c].Begin = clusters[c];
+		infos[c].End = c + 1 < clusters.size() ? clusters[c + 1] : (uint32_t)triangleCount;
+
+		float clusterArea = 0;
+		for (uint32_t t = infos[c].Begin; t < infos[c].End; ++t)
+		{
+			Float3 p0 = vertices[indices[t * 3]].Position;
+			Float3 p1 = vertices[indices[t * 3 + 1]].Position;
+			Float3 p2 = vertices[indices[t * 3 + 2]].Position;
+
+			Float3 normal = (p1 - p0).Cross(p2 - p0);
+			float area = std::sqrt(normal.Dot(normal));
+			Float3 center = (p0 + p1 + p2) * (area / 3.0f);
+
+			centroids[c] = centroids[c] + center;
+			normals[c] = normals[c] + normal;
+			clusterArea += area;
+		}
+
+		meshCentroid = meshCentroid + centroids[c];
+		meshArea += clusterArea;
+		if (clusterArea > 0)
+			centroids[c] = centroids[c] * (1.0f / clusterArea);
+	}
+	if (meshArea > 0)
+		meshCentroid = meshCentroid * (1.0f / meshArea);
+
+	for (size_t c = 0; c < infos.size(); ++c)
+	{
+		float length = std::sqrt(normals[c].Dot(normals[c]));
+		infos[c].Sort = length > 0 ? (centroids[c] - meshCentroid).Dot(normals[c]) / length : 0;
+	}
+
+	std::stable_sort(infos.begin(), infos.end(), [](const ClusterInfo& a, const ClusterInfo& b) { return a.Sort > b.Sort; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (const ClusterInfo& info : infos)
+		result.insert(result.end(), indices.begin() + info.Begin * 3, indices.begin() + info.End * 3);
+	indices = std::move(result);
+}
+
+size_t OptimizeVertexFetch(MeshData& mesh)
+{
+	std::vector<uint32_t> remap(mesh.Vertices.size(), UINT32_MAX);
+	std::vector<Vertex> vertices;
+	vertices.reserve(mesh.Vertices.size());
+	for (uint32_t& index : mesh.Indices32)
+	{
+		if (remap[index] == UINT32_MAX)
+		{
+			remap[index] = (uint32_t)vertices.size();
+			vertices.push_back(mesh.Vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	mesh.Vertices = std::move(vertices);
+	return mesh.Vertices.size();
+}
+
+void OptimizeMesh(MeshData& mesh, float overdrawThreshold)
+{
+	WeldVertices(mesh);
+
+	std::vector<uint32_t> clusters;
+	OptimizeVertexCache(mesh.Indices32, mesh.Vertices.size(), DefaultVertexCacheSize, &clusters);
+	OptimizeOverdraw(mesh.Indices32, mesh.Vertices, clusters, DefaultVertexCacheSize, overdrawThreshold);
+	OptimizeVertexFetch(mesh);
+}
+
+}
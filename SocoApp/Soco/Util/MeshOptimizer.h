@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../../Common/GeometryGenerator.h"
+
+namespace Soco
+{
+
+// 顶点后变换缓存的模拟结果，按FIFO缓存计算
+struct VertexCacheStats
+{
+	// 每个三角形平均需要shade的顶点数(ACMR)，理想值约0.5，最差3
+	float Acmr = 0;
+	// 每个顶点平均被shade的次数(ATVR)，理想值1
+	float Atvr = 0;
+	size_t Misses = 0;
+};
+
+// 典型的后变换缓存大小
+constexpr uint32_t DefaultVertexCacheSize = 16;
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = DefaultVertexCacheSize);
+
+// 合并所有属性都在epsilon内相同的顶点(Subdivide对共享边的中点每个三角形各生成一次)，返回合并掉的顶点数
+size_t WeldVertices(GeometryGenerator::MeshData& mesh, float epsilon = 1e-6f);
+
+// Tipsify(Sander 2007)：沿顶点扇形展开三角形，优先选还在缓存里、剩余三角形少的顶点
+// clusters不为空时写入硬边界：走进死胡同需要跳到别处的位置(三角形序号，第一个总是0)
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = DefaultVertexCacheSize,
+	std::vector<uint32_t>* clusters = nullptr);
+
+// 在硬边界内再按threshold切软边界(ACMR允许变差的倍数)，然后按朝外程度排序分块：
+// 分块中心相对网格中心的方向和分块法线越一致越靠外，先画外侧减少overdraw
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<GeometryGenerator::Vertex>& vertices,
+	const std::vector<uint32_t>& hardClusters, uint32_t cacheSize = DefaultVertexCacheSize, float threshold = 1.05f);
+
+// 按索引第一次出现的顺序重排顶点，去掉没有用到的顶点，返回剩下的顶点数
+size_t OptimizeVertexFetch(GeometryGenerator::MeshData& mesh);
+
+// 依次做合并、缓存优化、overdraw排序和取顶点重排，要在GetIndices16之前调用
+void OptimizeMesh(GeometryGenerator::MeshData& mesh, float overdrawThreshold = 1.05f);
+
+}
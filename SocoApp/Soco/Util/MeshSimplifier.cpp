@@ -0,0 +1,409 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace Soco
+{
+
+namespace
+{
+
+struct Vec3
+{
+	float x = 0, y = 0, z = 0;
+
+	Vec3() = default;
+	Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+	explicit Vec3(const float* p) : x(p[0]), y(p[1]), z(p[2]) {}
+
+	Vec3 operator+ (const Vec3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+	Vec3 operator- (const Vec3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+	Vec3 operator* (float s) const { return { x * s, y * s, z * s }; }
+	float Dot(const Vec3& o) const { return x * o.x + y * o.y + z * o.z; }
+	Vec3 Cross(const Vec3& o) const { return { y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x }; }
+	float Length() const { return std::sqrt(Dot(*this)); }
+};
+
+Vec3 GetPosition(const float* positions, size_t stride, uint32_t v)
+{
+	return Vec3(reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * stride));
+}
+
+// 平面距离平方的加权和：Q(p) = p^T A p + 2 b·p + c，除以总权重得到均方距离
+struct Quadric
+{
+	double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+	double b0 = 0, b1 = 0, b2 = 0;
+	double c = 0;
+	double w = 0;
+
+	void AddPlane(const Vec3& n, float d, float weight)
+	{
+		a00 += weight * n.x * n.x; a01 += weight * n.x * n.y; a02 += weight * n.x * n.z;
+		a11 += weight * n.y * n.y; a12 += weight * n.y * n.z; a22 += weight * n.z * n.z;
+		b0 += weight * n.x * d; b1 += weight * n.y * d; b2 += weight * n.z * d;
+		c += weight * d * d;
+		w += weight;
+	}
+
+	Quadric operator+ (const Quadric& o) const
+	{
+		Quadric q;
+		q.a00 = a00 + o.a00; q.a01 = a01 + o.a01; q.a02 = a02 + o.a02;
+		q.a11 = a11 + o.a11; q.a12 = a12 + o.a12; q.a22 = a22 + o.a22;
+		q.b0 = b0 + o.b0; q.b1 = b1 + o.b1; q.b2 = b2 + o.b2;
+		q.c = c + o.c;
+		q.w = w + o.w;
+		return q;
+	}
+
+	// 均方根距离
+	float Error(const Vec3& p) const
+	{
+		if (w <= 0)
+			return 0;
+		double e = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z
+			+ 2 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z)
+			+ 2 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+		return (float)std::sqrt(std::max(e / w, 0.0));
+	}
+};
+
+struct Collapse
+{
+	uint32_t From;
+	uint32_t To;
+	float Error;
+};
+
+uint64_t EdgeKey(uint32_t a, uint32_t b)
+{
+	return ((uint64_t)a << 32) | b;
+}
+
+// 点到三角形的最近距离(Ericson, Real-Time Collision Detection 5.1.5)
+float PointTriangleDistance(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+{
+	Vec3 ab = b - a, ac = c - a, ap = p - a;
+	float d1 = ab.Dot(ap), d2 = ac.Dot(ap);
+	if (d1 <= 0 && d2 <= 0)
+		return ap.Length();
+
+	Vec3 bp = p - b;
+	float d3 = ab.Dot(bp), d4 = ac.Dot(bp);
+	if (d3 >= 0 && d4 <= d3)
+		return bp.Length();
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0)
+		return (p - (a + ab * (d1 / (d1 - d3)))).Length();
+
+	Vec3 cp = p - c;
+	float d5 = ab.Dot(cp), d6 = ac.Dot(cp);
+	if (d6 >= 0 && d5 <= d6)
+		return cp.Length();
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0)
+		return (p - (a + ac * (d2 / (d2 - d6)))).Length();
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+		return (p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))))).Length();
+
+	float denom = 1.0f / (va + vb + vc);
+	return (p - (a + ab * (vb * denom) + ac * (vc * denom))).Length();
+}
+
+float PointMeshDistance(const Vec3& p, const uint32_t* indices, size_t indexCount, const float* positions, size_t stride)
+{
+	float best = INFINITY;
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+		best = std::min(best, PointTriangleDistance(p, GetPosition(positions, stride, indices[i]),
+			GetPosition(positions, stride, indices[i + 1]), GetPosition(positions, stride, indices[i + 2])));
+	return best;
+}
+
+/*
+依次简化到targetIndexCounts里的每个目标(从大到小)，每到一个目标记录一次结果
+二次误差一直累积，所以后面的结果误差也是相对原网格的，一次简化就得到整条LOD链
+*/
+std::vector<SimplifyResult> SimplifyToTargets(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+	const std::vector<size_t>& targetIndexCounts, float targetError)
+{
+	std::vector<SimplifyResult> snapshots;
+	SimplifyResult result;
+	result.Indices.assign(indices, indices + indexCount);
+
+	//位置相同的顶点归到同一个代表顶点上，拓扑、二次误差和锁定都按代表顶点算
+	std::vector<uint32_t> canonical(vertexCount);
+	std::vector<uint32_t> groupSize(vertexCount, 0);
+	{
+		struct PositionHash
+		{
+			size_t operator()(const Vec3& p) const
+			{
+				uint32_t bits[3];
+				memcpy(bits, &p, sizeof(bits));
+				return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+			}
+		};
+		struct PositionEqual
+		{
+			bool operator()(const Vec3& a, const Vec3& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+		};
+		std::unordered_map<Vec3, uint32_t, PositionHash, PositionEqual> first;
+		first.reserve(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			canonical[v] = first.emplace(GetPosition(positions, positionStride, v), v).first->second;
+			++groupSize[canonical[v]];
+		}
+	}
+
+	//按面积加权的三角形平面
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		Vec3 p0 = GetPosition(positions, positionStride, indices[i]);
+		Vec3 p1 = GetPosition(positions, positionStride, indices[i + 1]);
+		Vec3 p2 = GetPosition(positions, positionStride, indices[i + 2]);
+		Vec3 n = (p1 - p0).Cross(p2 - p0);
+		float doubleArea = n.Length();
+		if (doubleArea == 0)
+			continue;
+		n = n * (1.0f / doubleArea);
+		float d = -n.Dot(p0);
+		for (int k = 0; k < 3; ++k)
+			quadrics[canonical[indices[i + k]]].AddPlane(n, d, doubleArea * 0.5f);
+	}
+
+	//接缝顶点、开放边界和非流形边上的顶点不能移动
+	std::vector<bool> locked(vertexCount, false);
+	{
+		std::unordered_map<uint64_t, uint32_t> directedEdges;
+		directedEdges.reserve(indexCount);
+		for (size_t i = 0; i + 2 < indexCount; i += 3)
+			for (int k = 0; k < 3; ++k)
+				++directedEdges[EdgeKey(canonical[indices[i + k]], canonical[indices[i + (k + 1) % 3]])];
+
+		for (const auto& edge : directedEdges)
+		{
+			uint32_t a = (uint32_t)(edge.first >> 32), b = (uint32_t)edge.first;
+			auto opposite = directedEdges.find(EdgeKey(b, a));
+			if (edge.second != 1 || opposite == directedEdges.end() || opposite->second != 1)
+				locked[a] = locked[b] = true;
+		}
+		for (uint32_t v = 0; v < vertexCount; ++v)
+			if (groupSize[canonical[v]] > 1)
+				locked[canonical[v]] = true;
+	}
+
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<bool> touched(vertexCount);
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+
+	for (size_t targetIndexCount : targetIndexCounts)
+	{
+		const size_t targetTriangles = targetIndexCount / 3;
+		while (result.Indices.size() / 3 > targetTriangles)
+		{
+			std::vector<uint32_t>& current = result.Indices;
+			const size_t triangleCount = current.size() / 3;
+
+			//候选：三角形的每条边两个方向，起点必须可移动；目标用这个三角形里实际引用的顶点，接缝上的目标就取对的那一侧属性
+			collapses.clear();
+			for (size_t i = 0; i < current.size(); i += 3)
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					uint32_t u = current[i + k];
+					if (locked[canonical[u]])
+						continue;
+					for (int j = 1; j <= 2; ++j)
+					{
+						uint32_t v = current[i + (k + j) % 3];
+						float error = (quadrics[u] + quadrics[canonical[v]]).Error(GetPosition(positions, positionStride, v));
+						collapses.push_back({ u, v, error });
+					}
+				}
+			}
+			if (collapses.empty())
+				break;
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+				return a.Error != b.Error ? a.Error < b.Error : (a.From != b.From ? a.From < b.From : a.To < b.To);
+			});
+
+			//代表顶点到三角形的邻接，翻转检查用
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (uint32_t index : current)
+				++adjacencyOffsets[canonical[index] + 1];
+			for (size_t v = 0; v < vertexCount; ++v)
+				adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+			adjacency.resize(current.size());
+			{
+				std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (size_t i = 0; i < current.size(); ++i)
+					adjacency[cursor[canonical[current[i]]]++] = (uint32_t)(i / 3);
+			}
+
+			for (uint32_t v = 0; v < vertexCount; ++v)
+				remap[v] = v;
+			std::fill(touched.begin(), touched.end(), false);
+
+			size_t removed = 0;
+			size_t applied = 0;
+			for (const Collapse& collapse : collapses)
+			{
+				if (collapse.Error > targetError || triangleCount - removed <= targetTriangles)
+					break;
+
+				const uint32_t cu = canonical[collapse.From];
+				const uint32_t cv = canonical[collapse.To];
+				if (touched[cu] || touched[cv])
+					continue;
+
+				//u的三角形里不含v的那些，移动后法线不能反向
+				const Vec3 target = GetPosition(positions, positionStride, collapse.To);
+				bool flipped = false;
+				size_t degenerate = 0;
+				for (uint32_t a = adjacencyOffsets[cu]; a < adjacencyOffsets[cu + 1] && !flipped; ++a)
+				{
+					const uint32_t* triangle = &current[adjacency[a] * 3];
+					Vec3 before[3], after[3];
+					bool hasV = false;
+					for (int k = 0; k < 3; ++k)
+					{
+						before[k] = GetPosition(positions, positionStride, triangle[k]);
+						after[k] = canonical[triangle[k]] == cu ? target : before[k];
+						hasV |= canonical[triangle[k]] == cv;
+					}
+					if (hasV)
+					{
+						++degenerate;
+						continue;
+					}
+
+					Vec3 n0 = (before[1] - before[0]).Cross(before[2] - before[0]);
+					Vec3 n1 = (after[1] - after[0]).Cross(after[2] - after[0]);
+					flipped = n0.Dot(n1) <= 0;
+				}
+				if (flipped)
+					continue;
+
+				remap[collapse.From] = collapse.To;
+				quadrics[cv] = quadrics[cv] + quadrics[cu];
+				result.Error = std::max(result.Error, collapse.Error);
+				removed += degenerate;
+				++applied;
+
+				//u的一环邻域的三角形变了，本轮不再参与
+				for (uint32_t a = adjacencyOffsets[cu]; a < adjacencyOffsets[cu + 1]; ++a)
+					for (int k = 0; k < 3; ++k)
+						touched[canonical[current[adjacency[a] * 3 + k]]] = true;
+			}
+			if (applied == 0)
+				break;
+
+			//应用折叠，去掉退化的三角形
+			size_t write = 0;
+			for (size_t i = 0; i < current.size(); i += 3)
+			{
+				uint32_t a = remap[current[i]], b = remap[current[i + 1]], c = remap[current[i + 2]];
+				if (canonical[a] == canonical[b] || canonical[b] == canonical[c] || canonical[a] == canonical[c])
+					continue;
+				current[write++] = a;
+				current[write++] = b;
+				current[write++] = c;
+			}
+			current.resize(write);
+		}
+		snapshots.push_back(result);
+	}
+
+	return snapshots;
+}
+
+}
+
+SimplifyResult SimplifyMesh(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+	size_t targetIndexCount, float targetError)
+{
+	return std::move(SimplifyToTargets(indices, indexCount, positions, vertexCount, positionStride, { targetIndexCount }, targetError)[0]);
+}
+
+std::vector<MeshLodLevel> BuildLodChain(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+	uint32_t maxLevels, float reduction, float maxError)
+{
+	std::vector<size_t> targets;
+	size_t targetCount = indexCount;
+	for (uint32_t level = 0; level < maxLevels; ++level)
+	{
+		targetCount = (size_t)(targetCount * reduction) / 3 * 3;
+		targets.push_back(targetCount);
+	}
+
+	std::vector<SimplifyResult> simplified = SimplifyToTargets(indices, indexCount, positions, vertexCount, positionStride, targets, maxError);
+
+	std::vector<MeshLodLevel> levels;
+	size_t previousCount = indexCount;
+	for (SimplifyResult& result : simplified)
+	{
+		if (result.Indices.empty() || result.Indices.size() > previousCount * 9 / 10)
+			break;
+
+		MeshLodLevel lod;
+		lod.Indices = std::move(result.Indices);
+		lod.Error = result.Error;
+		OptimizeVertexCache(lod.Indices, vertexCount);
+		previousCount = lod.Indices.size();
+		levels.push_back(std::move(lod));
+	}
+	return levels;
+}
+
+float MeasureSimplificationError(const uint32_t* original, size_t originalCount, const uint32_t* simplified, size_t simplifiedCount,
+	const float* positions, size_t vertexCount, size_t positionStride)
+{
+	float error = 0;
+
+	std::vector<bool> used(vertexCount, false);
+	for (size_t i = 0; i < originalCount; ++i)
+		used[original[i]] = true;
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		if (used[v])
+			error = std::max(error, PointMeshDistance(GetPosition(positions, positionStride, v), simplified, simplifiedCount, positions, positionStride));
+
+	//简化网格的顶点都是原顶点，距离为0，只需要检查重心
+	for (size_t i = 0; i + 2 < simplifiedCount; i += 3)
+	{
+		Vec3 centroid = (GetPosition(positions, positionStride, simplified[i]) + GetPosition(positions, positionStride, simplified[i + 1])
+			+ GetPosition(positions, positionStride, simplified[i + 2])) * (1.0f / 3.0f);
+		error = std::max(error, PointMeshDistance(centroid, original, originalCount, positions, positionStride));
+	}
+	return error;
+}
+
+bool CheckSimplificationError(const uint32_t* original, size_t originalCount, const MeshLodLevel& level,
+	const float* positions, size_t vertexCount, size_t positionStride)
+{
+	float measured = MeasureSimplificationError(original, originalCount, level.Indices.data(), level.Indices.size(), positions, vertexCount, positionStride);
+	//平面上的折叠报告误差是0，留一点浮点容差
+	float bound = level.Error * SimplificationErrorSlack + 1e-5f;
+	if (measured > bound)
+	{
+		std::cout << "简化误差超出上限：实测" << measured << " > " << bound << "(报告" << level.Error << ")" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Soco
+{
+
+struct SimplifyResult
+{
+	std::vector<uint32_t> Indices;
+	// 物体空间的距离：所有折叠中到累积平面的均方根距离的最大值
+	float Error = 0;
+};
+
+/*
+二次误差度量(Garland-Heckbert)的半边折叠：顶点u移到相邻顶点v上，不产生新顶点，结果索引仍指向原顶点缓冲
+位置相同、属性不同的接缝顶点和开放边界上的顶点不会被移走，只能作为折叠目标，所以接缝和边界保持不变
+每一轮按误差从小到大折叠，折叠过的顶点及其一环邻域本轮不再参与；会翻转三角形朝向的折叠被拒绝
+三角形数降到targetIndexCount / 3以下，或者下一个折叠的误差超过targetError时停止
+*/
+SimplifyResult SimplifyMesh(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+	size_t targetIndexCount, float targetError);
+
+struct MeshLodLevel
+{
+	std::vector<uint32_t> Indices;
+	float Error = 0;
+};
+
+/*
+LOD链，不含原网格：每一级的目标三角形数是上一级的reduction倍，都从原网格简化，误差相对原网格
+三角形减少不到10%(剩下的都是锁住的接缝/边界或者再折叠误差超过maxError)时停止，每一级的索引都做过顶点缓存优化
+*/
+std::vector<MeshLodLevel> BuildLodChain(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+	uint32_t maxLevels = 4, float reduction = 0.5f, float maxError = 1e30f);
+
+// 双向的最大距离：原网格顶点到简化网格、简化网格的顶点和三角形重心到原网格，暴力计算，只用于检查和测试
+float MeasureSimplificationError(const uint32_t* original, size_t originalCount, const uint32_t* simplified, size_t simplifiedCount,
+	const float* positions, size_t vertexCount, size_t positionStride);
+
+// 实测误差允许超出报告误差的倍数：二次误差是到累积平面的均方根距离，不是严格的Hausdorff上界
+constexpr float SimplificationErrorSlack = 2.0f;
+
+// 实测误差不超过max(报告误差, targetError) * SimplificationErrorSlack，超出时打印
+bool CheckSimplificationError(const uint32_t* original, size_t originalCount, const MeshLodLevel& level,
+	const float* positions, size_t vertexCount, size_t positionStride);
+
+}
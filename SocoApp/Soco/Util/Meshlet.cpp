@@ -0,0 +1,279 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace Soco
+{
+
+namespace
+{
+
+struct Vec3
+{
+	float x = 0, y = 0, z = 0;
+
+	Vec3() = default;
+	Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+	explicit Vec3(const float* p) : x(p[0]), y(p[1]), z(p[2]) {}
+
+	Vec3 operator+ (const Vec3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+	Vec3 operator- (const Vec3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+	Vec3 operator* (float s) const { return { x * s, y * s, z * s }; }
+	float Dot(const Vec3& o) const { return x * o.x + y * o.y + z * o.z; }
+	Vec3 Cross(const Vec3& o) const { return { y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x }; }
+	float Length() const { return std::sqrt(Dot(*this)); }
+	Vec3 Normalized() const { float l = Length(); return l > 0 ? *this * (1.0f / l) : *this; }
+};
+
+const float* GetPosition(const float* positions, size_t stride, uint32_t v)
+{
+	return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * stride);
+}
+
+MeshletBounds ComputeBounds(const MeshletSet& set, const Meshlet& meshlet, const float* positions, size_t stride)
+{
+	MeshletBounds bounds;
+
+	//包围球：AABB中心，半径取最远顶点
+	Vec3 minP(INFINITY, INFINITY, INFINITY), maxP(-INFINITY, -INFINITY, -INFINITY);
+	for (uint32_t i = 0; i < meshlet.VertexCount; ++i)
+	{
+		Vec3 p(GetPosition(positions, stride, set.Vertices[meshlet.VertexOffset + i]));
+		minP = { std::min(minP.x, p.x), std::min(minP.y, p.y), std::min(minP.z, p.z) };
+		maxP = { std::max(maxP.x, p.x), std::max(maxP.y, p.y), std::max(maxP.z, p.z) };
+	}
+	Vec3 center = (minP + maxP) * 0.5f;
+	float radius = 0;
+	for (uint32_t i = 0; i < meshlet.VertexCount; ++i)
+		radius = std::max(radius, (Vec3(GetPosition(positions, stride, set.Vertices[meshlet.VertexOffset + i])) - center).Length());
+
+	bounds.Center[0] = center.x;
+	bounds.Center[1] = center.y;
+	bounds.Center[2] = center.z;
+	bounds.Radius = radius;
+
+	//法线锥：轴取法线平均方向，张角取与轴夹角最大的法线
+	std::vector<Vec3> normals;
+	normals.reserve(meshlet.TriangleCount);
+	Vec3 axis;
+	for (uint32_t t = 0; t < meshlet.TriangleCount; ++t)
+	{
+		const uint8_t* triangle = &set.Triangles[(meshlet.TriangleOffset + t) * 3];
+		Vec3 p0(GetPosition(positions, stride, set.Vertices[meshlet.VertexOffset + triangle[0]]));
+		Vec3 p1(GetPosition(positions, stride, set.Vertices[meshlet.VertexOffset + triangle[1]]));
+		Vec3 p2(GetPosition(positions, stride, set.Vertices[meshlet.VertexOffset + triangle[2]]));
+
+		Vec3 normal = (p1 - p0).Cross(p2 - p0);
+		if (normal.Length() == 0)
+			continue;
+		normals.push_back(normal.Normalized());
+		axis = axis + normals.back();
+	}
+
+	if (normals.empty() || axis.Length() == 0)
+		return bounds;
+	axis = axis.Normalized();
+
+	float minDot = 1;
+	for (const Vec3& normal : normals)
+		minDot = std::min(minDot, normal.Dot(axis));
+
+	bounds.ConeAxis[0] = axis.x;
+	bounds.ConeAxis[1] = axis.y;
+	bounds.ConeAxis[2] = axis.z;
+	bounds.ConeCutoff = minDot <= 0 ? 1.0f : std::sqrt(1 - minDot * minDot);
+	return bounds;
+}
+
+}
+
+MeshletSet BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride)
+{
+	MeshletSet set;
+	const uint32_t triangleCount = (uint32_t)(indexCount / 3);
+	set.TriangleCount = triangleCount;
+	if (triangleCount == 0)
+		return set;
+
+	//每个顶点引用它的三角形，CSR格式
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < indexCount; ++i)
+		++offsets[indices[i] + 1];
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+	std::vector<uint32_t> adjacency(indexCount);
+	{
+		std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indexCount; ++i)
+			adjacency[cursor[indices[i]]++] = (uint32_t)(i / 3);
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	//顶点在当前meshlet里的局部序号，stamp不等于当前meshlet编号时视为不在
+	std::vector<uint8_t> localIndex(vertexCount, 0);
+	std::vector<uint32_t> stamp(vertexCount, UINT32_MAX);
+	std::vector<uint32_t> candidates;
+
+	uint32_t cursor = 0;
+	uint32_t emittedCount = 0;
+	while (emittedCount < triangleCount)
+	{
+		while (emitted[cursor])
+			++cursor;
+
+		const uint32_t meshletIndex = (uint32_t)set.Meshlets.size();
+		Meshlet meshlet;
+		meshlet.VertexOffset = (uint32_t)set.Vertices.size();
+		meshlet.TriangleOffset = (uint32_t)(set.Triangles.size() / 3);
+		candidates.clear();
+
+		auto newVertexCount = [&](uint32_t triangle) {
+			uint32_t count = 0;
+			for (int corner = 0; corner < 3; ++corner)
+				count += stamp[indices[triangle * 3 + corner]] != meshletIndex;
+			return count;
+		};
+
+		auto addTriangle = [&](uint32_t triangle) {
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				uint32_t v = indices[triangle * 3 + corner];
+				if (stamp[v] != meshletIndex)
+				{
+					stamp[v] = meshletIndex;
+					localIndex[v] = (uint8_t)meshlet.VertexCount++;
+					set.Vertices.push_back(v);
+					for (uint32_t k = offsets[v]; k < offsets[v + 1]; ++k)
+					{
+						if (!emitted[adjacency[k]])
+							candidates.push_back(adjacency[k]);
+					}
+				}
+				set.Triangles.push_back(localIndex[v]);
+			}
+			emitted[triangle] = true;
+			++meshlet.TriangleCount;
+			++emittedCount;
+		};
+
+		addTriangle(cursor);
+		while (meshlet.TriangleCount < MaxMeshletTriangles)
+		{
+			//新增顶点最少的相邻三角形，同分取先进入候选的；顺便去掉已经分配的候选
+			int best = -1;
+			uint32_t bestNew = UINT32_MAX;
+			size_t alive = 0;
+			for (size_t i = 0; i < candidates.size(); ++i)
+			{
+				uint32_t triangle = candidates[i];
+				if (emitted[triangle])
+					continue;
+				candidates[alive++] = triangle;
+
+				uint32_t newVertices = newVertexCount(triangle);
+				if (meshlet.VertexCount + newVertices <= MaxMeshletVertices && newVertices < bestNew)
+				{
+					best = (int)triangle;
+					bestNew = newVertices;
+				}
+			}
+			candidates.resize(alive);
+
+			if (best < 0)
+				break;
+			addTriangle((uint32_t)best);
+		}
+
+		set.Meshlets.push_back(meshlet);
+	}
+
+	set.Bounds.reserve(set.Meshlets.size());
+	for (const Meshlet& meshlet : set.Meshlets)
+		set.Bounds.push_back(ComputeBounds(set, meshlet, positions, positionStride));
+	return set;
+}
+
+bool IsMeshletCulled(const MeshletBounds& bounds, const MeshletCullParams& params)
+{
+	const Vec3 center(bounds.Center);
+
+	if (params.FrustumCulling)
+	{
+		const float radius = bounds.Radius * params.RadiusScale;
+		for (int i = 0; i < 6; ++i)
+		{
+			const float* plane = params.FrustumPlanes[i];
+			if (center.Dot(Vec3(plane)) + plane[3] < -radius)
+				return true;
+		}
+	}
+
+	//整个包围球看到的都是法线锥的背面：dot(c - eye, axis) - r >= sin(a) * (|c - eye| + r)
+	if (params.ConeCulling && bounds.ConeCutoff < 1.0f)
+	{
+		Vec3 view = center - Vec3(params.CameraPosition);
+		if (view.Dot(Vec3(bounds.ConeAxis)) - bounds.Radius >= bounds.ConeCutoff * (view.Length() + bounds.Radius))
+			return true;
+	}
+	return false;
+}
+
+uint32_t CullMeshlets(const MeshletSet& set, const MeshletCullParams& params, uint32_t* outIndices, uint32_t* visibleMeshlets)
+{
+	uint32_t indexCount = 0;
+	uint32_t visible = 0;
+	for (size_t m = 0; m < set.Meshlets.size(); ++m)
+	{
+		if (IsMeshletCulled(set.Bounds[m], params))
+			continue;
+
+		const Meshlet& meshlet = set.Meshlets[m];
+		const uint32_t* vertices = &set.Vertices[meshlet.VertexOffset];
+		const uint8_t* triangles = &set.Triangles[meshlet.TriangleOffset * 3];
+		for (uint32_t i = 0; i < meshlet.TriangleCount * 3; ++i)
+			outIndices[indexCount++] = vertices[triangles[i]];
+		++visible;
+	}
+
+	if (visibleMeshlets != nullptr)
+		*visibleMeshlets = visible;
+	return indexCount;
+}
+
+void ExtractFrustumPlanes(const float viewProj[16], float planes[6][4])
+{
+	//clip = v * M，第j个裁剪坐标是v与M第j列的点积
+	auto column = [viewProj](int j, float out[4]) {
+		for (int r = 0; r < 4; ++r)
+			out[r] = viewProj[r * 4 + j];
+	};
+
+	float c0[4], c1[4], c2[4], c3[4];
+	column(0, c0);
+	column(1, c1);
+	column(2, c2);
+	column(3, c3);
+
+	for (int i = 0; i < 4; ++i)
+	{
+		planes[0][i] = c3[i] + c0[i];
+		planes[1][i] = c3[i] - c0[i];
+		planes[2][i] = c3[i] + c1[i];
+		planes[3][i] = c3[i] - c1[i];
+		planes[4][i] = c2[i];
+		planes[5][i] = c3[i] - c2[i];
+	}
+
+	for (int p = 0; p < 6; ++p)
+	{
+		float length = Vec3(planes[p]).Length();
+		if (length > 0)
+		{
+			for (int i = 0; i < 4; ++i)
+				planes[p][i] /= length;
+		}
+	}
+}
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Soco
+{
+
+// 一个meshlet最多的顶点和三角形数，与mesh shader常用的上限相同
+constexpr uint32_t MaxMeshletVertices = 64;
+constexpr uint32_t MaxMeshletTriangles = 124;
+
+struct Meshlet
+{
+	uint32_t VertexOffset = 0;
+	uint32_t TriangleOffset = 0;
+	uint32_t VertexCount = 0;
+	uint32_t TriangleCount = 0;
+};
+
+/*
+剔除数据，都在物体空间：
+包围球(Center, Radius)
+法线锥：所有三角形法线与ConeAxis的夹角不超过a，ConeCutoff = sin(a)；夹角可能达到90度时ConeCutoff为1，锥剔除永远不成立
+三角形正面按D3D默认的顺时针，法线为cross(p1 - p0, p2 - p0)
+*/
+struct MeshletBounds
+{
+	float Center[3] = {};
+	float Radius = 0;
+	float ConeAxis[3] = {};
+	float ConeCutoff = 1;
+};
+
+/*
+一个子网格的全部meshlet：
+Vertices是meshlet局部顶点到子网格顶点(相对BaseVertexLocation)的映射
+Triangles是局部顶点序号，每个三角形3个
+*/
+struct MeshletSet
+{
+	std::vector<Meshlet> Meshlets;
+	std::vector<MeshletBounds> Bounds;
+	std::vector<uint32_t> Vertices;
+	std::vector<uint8_t> Triangles;
+	uint32_t TriangleCount = 0;
+};
+
+/*
+贪心构建：从还没分配的第一个三角形开始，每次加入与当前meshlet共享顶点最多(新增顶点最少)的相邻三角形，装不下或没有相邻三角形时换下一个meshlet
+索引最好先经过OptimizeMesh，起点按索引顺序取，缓存友好的顺序能让meshlet更紧凑
+positions指向第一个顶点的位置(3个float)，positionStride是相邻顶点之间的字节数
+*/
+MeshletSet BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride);
+
+// 剔除参数，都在物体空间
+struct MeshletCullParams
+{
+	float CameraPosition[3] = {};
+	// 平面ax+by+cz+d，内侧为正；由世界空间平面变换过来时未必归一化，乘上RadiusScale后与半径比较
+	float FrustumPlanes[6][4] = {};
+	// 物体空间半径换算到平面距离单位的系数(物体的最大缩放)
+	float RadiusScale = 1;
+	bool FrustumCulling = true;
+	// 锥剔除要求均匀缩放
+	bool ConeCulling = true;
+};
+
+bool IsMeshletCulled(const MeshletBounds& bounds, const MeshletCullParams& params);
+
+// 把可见meshlet的三角形写成子网格的索引(相对BaseVertexLocation)，outIndices至少要能放下set.TriangleCount * 3个，返回写入的索引数
+uint32_t CullMeshlets(const MeshletSet& set, const MeshletCullParams& params, uint32_t* outIndices, uint32_t* visibleMeshlets = nullptr);
+
+// 从行向量约定(clip = v * viewProj)的矩阵提取视锥平面，顺序为左右下上近远，深度范围[0, w]，平面已归一化
+void ExtractFrustumPlanes(const float viewProj[16], float planes[6][4]);
+
+}
@@ -0,0 +1,423 @@
+#include "MipChain.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include "Profiler.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SOCO_MIP_SSE2 1
+#else
+#define SOCO_MIP_SSE2 0
+#endif
+
+namespace Soco
+{
+
+namespace
+{
+
+const double Pi = 3.14159265358979323846;
+// 半径以目标像素为单位，缩小一半时覆盖源图像的12个像素
+const double KaiserRadius = 3.0;
+const double KaiserAlpha = 4.0;
+
+double BesselI0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for (int k = 1; k < 64 && term > 1e-14 * sum; ++k)
+	{
+		const double half = x / (2.0 * k);
+		term *= half * half;
+		sum += term;
+	}
+	return sum;
+}
+
+// x以目标像素为单位
+double KaiserSinc(double x)
+{
+	if (std::abs(x) >= KaiserRadius)
+		return 0.0;
+	const double sinc = x == 0.0 ? 1.0 : std::sin(Pi * x) / (Pi * x);
+	const double r = x / KaiserRadius;
+	return sinc * BesselI0(KaiserAlpha * std::sqrt(1.0 - r * r)) / BesselI0(KaiserAlpha);
+}
+
+double SrgbToLinear(double c)
+{
+	return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+}
+
+struct SrgbTables
+{
+	float Decode[256];
+	// Thresholds[k]是编码成k和k + 1的分界，编码结果就是不大于线性值的分界个数，和按公式编码后四舍五入相同
+	// 最后一个是哨兵，比任何截断后的线性值都大
+	float Thresholds[256];
+	// EncodeStart[i]是线性值i / EncodeSteps的编码结果，[i, i + 1) / EncodeSteps内最多只有一个分界，编码时最多往上走一步
+	static const int EncodeSteps = 4096;
+	uint8_t EncodeStart[EncodeSteps + 1];
+
+	SrgbTables()
+	{
+		for (int i = 0; i < 256; ++i)
+			Decode[i] = (float)SrgbToLinear(i / 255.0);
+		for (int k = 0; k < 255; ++k)
+			Thresholds[k] = (float)SrgbToLinear((k + 0.5) / 255.0);
+		Thresholds[255] = FLT_MAX;
+		for (int i = 0; i <= EncodeSteps; ++i)
+		{
+			EncodeStart[i] = (uint8_t)(std::upper_bound(Thresholds, Thresholds + 255, (float)i / EncodeSteps) - Thresholds);
+			assert(i == 0 || EncodeStart[i] - EncodeStart[i - 1] <= 1);
+		}
+	}
+};
+
+const SrgbTables& GetSrgbTables()
+{
+	static const SrgbTables tables;
+	return tables;
+}
+
+uint8_t EncodeUnorm(float v)
+{
+	return (uint8_t)(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+uint8_t EncodeSrgb(float v, const SrgbTables& tables)
+{
+	v = std::min(std::max(v, 0.0f), 1.0f);
+	//乘EncodeSteps是精确的，截断就是所在区间；区间内最多一个分界，不用循环，没有难预测的分支
+	const int k = tables.EncodeStart[(int)(v * SrgbTables::EncodeSteps)];
+	return (uint8_t)(k + (v >= tables.Thresholds[k] ? 1 : 0));
+}
+
+/*
+一个方向上每个目标像素的源像素下标和权重，每个目标像素都是Count个，不够的权重为0
+下标已经按寻址方式回绕或截断过
+*/
+struct AxisTaps
+{
+	uint32_t Count = 0;
+	std::vector<int32_t> Index;
+	std::vector<float> Weights;
+};
+
+AxisTaps BuildTaps(uint32_t srcSize, MipFilter filter, bool wrap)
+{
+	const uint32_t dstSize = std::max(1u, srcSize / 2);
+	AxisTaps taps;
+
+	if (filter != MipFilter::Kaiser)
+	{
+		//Box和Min/Max用相同的足迹：偶数两个像素；奇数2n+1缩到n时，第i个目标像素覆盖源像素2i、2i+1、2i+2的(n-i)、n、(i+1)份
+		taps.Count = srcSize == 1 ? 1 : (srcSize % 2 == 0 ? 2 : 3);
+		taps.Index.resize(dstSize * taps.Count);
+		taps.Weights.resize(dstSize * taps.Count);
+		for (uint32_t i = 0; i < dstSize; ++i)
+		{
+			int32_t* index = &taps.Index[i * taps.Count];
+			float* weights = &taps.Weights[i * taps.Count];
+			if (taps.Count == 1)
+			{
+				index[0] = 0;
+				weights[0] = 1.0f;
+			}
+			else if (taps.Count == 2)
+			{
+				index[0] = 2 * i;
+				index[1] = 2 * i + 1;
+				weights[0] = weights[1] = 0.5f;
+			}
+			else
+			{
+				const float n = (float)dstSize;
+				index[0] = 2 * i;
+				index[1] = 2 * i + 1;
+				index[2] = 2 * i + 2;
+				weights[0] = (n - i) / srcSize;
+				weights[1] = n / srcSize;
+				weights[2] = (i + 1) / (float)srcSize;
+			}
+		}
+		return taps;
+	}
+
+	const double scale = (double)srcSize / dstSize;
+	const double support = KaiserRadius * scale;
+	taps.Count = (uint32_t)std::ceil(2.0 * support) + 1;
+	taps.Index.resize(dstSize * taps.Count);
+	taps.Weights.resize(dstSize * taps.Count);
+
+	std::vector<double> weights(taps.Count);
+	for (uint32_t i = 0; i < dstSize; ++i)
+	{
+		const double center = (i + 0.5) * scale;
+		const int32_t first = (int32_t)std::floor(center - support - 0.5) + 1;
+
+		double sum = 0.0;
+		for (uint32_t k = 0; k < taps.Count; ++k)
+		{
+			weights[k] = KaiserSinc(((double)first + k + 0.5 - center) / scale);
+			sum += weights[k];
+		}
+
+		for (uint32_t k = 0; k < taps.Count; ++k)
+		{
+			const int32_t j = first + (int32_t)k;
+			const int32_t n = (int32_t)srcSize;
+			taps.Index[i * taps.Count + k] = wrap ? ((j % n) + n) % n : std::min(std::max(j, 0), n - 1);
+			taps.Weights[i * taps.Count + k] = (float)(weights[k] / sum);
+		}
+	}
+	return taps;
+}
+
+enum class Reduce
+{
+	Weighted,
+	Min,
+	Max,
+};
+
+// 标量实现，没有SSE2的平台和基准测试对比用
+struct ScalarOps
+{
+	struct V
+	{
+		float x[4];
+	};
+
+	static V Set1(float f) { return { { f, f, f, f } }; }
+	static V Add(const V& a, const V& b) { return { { a.x[0] + b.x[0], a.x[1] + b.x[1], a.x[2] + b.x[2], a.x[3] + b.x[3] } }; }
+	static V Mul(const V& a, const V& b) { return { { a.x[0] * b.x[0], a.x[1] * b.x[1], a.x[2] * b.x[2], a.x[3] * b.x[3] } }; }
+	static V Min(const V& a, const V& b) { return { { std::min(a.x[0], b.x[0]), std::min(a.x[1], b.x[1]), std::min(a.x[2], b.x[2]), std::min(a.x[3], b.x[3]) } }; }
+	static V Max(const V& a, const V& b) { return { { std::max(a.x[0], b.x[0]), std::max(a.x[1], b.x[1]), std::max(a.x[2], b.x[2]), std::max(a.x[3], b.x[3]) } }; }
+
+	static V Decode(const uint8_t* texel, bool srgb)
+	{
+		const float* table = GetSrgbTables().Decode;
+		if (srgb)
+			return { { table[texel[0]], table[texel[1]], table[texel[2]], texel[3] / 255.0f } };
+		return { { texel[0] / 255.0f, texel[1] / 255.0f, texel[2] / 255.0f, texel[3] / 255.0f } };
+	}
+
+	static void Encode(const V& v, uint8_t* texel, bool srgb)
+	{
+		const SrgbTables& tables = GetSrgbTables();
+		for (int c = 0; c < 3; ++c)
+			texel[c] = srgb ? EncodeSrgb(v.x[c], tables) : EncodeUnorm(v.x[c]);
+		texel[3] = EncodeUnorm(v.x[3]);
+	}
+};
+
+#if SOCO_MIP_SSE2
+// 一个RGBA像素正好是一个__m128，四个通道一起滤波
+// sRGB的解码和编码要按通道查表，SSE2没有gather，这两步仍然是逐通道的标量读表
+struct SseOps
+{
+	struct V
+	{
+		__m128 x;
+	};
+
+	static V Set1(float f) { return { _mm_set1_ps(f) }; }
+	static V Add(const V& a, const V& b) { return { _mm_add_ps(a.x, b.x) }; }
+	static V Mul(const V& a, const V& b) { return { _mm_mul_ps(a.x, b.x) }; }
+	static V Min(const V& a, const V& b) { return { _mm_min_ps(a.x, b.x) }; }
+	static V Max(const V& a, const V& b) { return { _mm_max_ps(a.x, b.x) }; }
+
+	static V Decode(const uint8_t* texel, bool srgb)
+	{
+		if (srgb)
+		{
+			const float* table = GetSrgbTables().Decode;
+			return { _mm_set_ps(texel[3] * (1.0f / 255.0f), table[texel[2]], table[texel[1]], table[texel[0]]) };
+		}
+		int32_t packed;
+		memcpy(&packed, texel, sizeof(packed));
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+		return { _mm_mul_ps(_mm_cvtepi32_ps(wide), _mm_set1_ps(1.0f / 255.0f)) };
+	}
+
+	static void Encode(const V& v, uint8_t* texel, bool srgb)
+	{
+		const __m128 clamped = _mm_min_ps(_mm_max_ps(v.x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		__m128i scaled = _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)));
+		if (srgb)
+		{
+			//和EncodeSrgb相同：查区间起点，再和一个分界比较；三次查表是标量的，比较和打包在寄存器里
+			const SrgbTables& tables = GetSrgbTables();
+			alignas(16) int32_t step[4];
+			_mm_store_si128((__m128i*)step, _mm_cvttps_epi32(_mm_mul_ps(clamped, _mm_set1_ps((float)SrgbTables::EncodeSteps))));
+			const int32_t r = tables.EncodeStart[step[0]];
+			const int32_t g = tables.EncodeStart[step[1]];
+			const int32_t b = tables.EncodeStart[step[2]];
+			const __m128 thresholds = _mm_set_ps(FLT_MAX, tables.Thresholds[b], tables.Thresholds[g], tables.Thresholds[r]);
+			//比较结果是全1，减去它就是加1
+			const __m128i encoded = _mm_sub_epi32(_mm_set_epi32(0, b, g, r), _mm_castps_si128(_mm_cmpge_ps(clamped, thresholds)));
+			const __m128i alphaMask = _mm_set_epi32(-1, 0, 0, 0);
+			scaled = _mm_or_si128(_mm_andnot_si128(alphaMask, encoded), _mm_and_si128(alphaMask, scaled));
+		}
+		const int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(scaled, scaled), scaled));
+		memcpy(texel, &packed, sizeof(packed));
+	}
+};
+#endif
+
+template<typename Ops, Reduce R>
+typename Ops::V Accumulate(const typename Ops::V& acc, const typename Ops::V& texel, float weight)
+{
+	if constexpr (R == Reduce::Min)
+		return Ops::Min(acc, texel);
+	else if constexpr (R == Reduce::Max)
+		return Ops::Max(acc, texel);
+	else
+		return Ops::Add(acc, Ops::Mul(texel, Ops::Set1(weight)));
+}
+
+template<typename Ops, Reduce R>
+typename Ops::V InitialValue()
+{
+	if constexpr (R == Reduce::Min)
+		return Ops::Set1(FLT_MAX);
+	else if constexpr (R == Reduce::Max)
+		return Ops::Set1(-FLT_MAX);
+	else
+		return Ops::Set1(0.0f);
+}
+
+/*
+可分离滤波：每个目标行先在竖直方向把用到的源行累加成一行，再在水平方向累加
+Min/Max也是可分离的，先逐列取极值再逐行取极值和二维足迹上取极值相同
+*/
+template<typename Ops, Reduce R>
+void DownsampleSeparable(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst, bool srgb,
+	const AxisTaps& tapsX, const AxisTaps& tapsY)
+{
+	using V = typename Ops::V;
+	const uint32_t dstWidth = std::max(1u, width / 2);
+	const uint32_t dstHeight = std::max(1u, height / 2);
+
+	//解码后的源行缓存：Kaiser竖直方向一个源行会被6个左右的目标行用到，sRGB解码要查表，每行只解码一次
+	//一个目标行最多用到tapsY.Count个不同的源行，槽位数和它相同时总有不被当前目标行使用的槽位可以替换
+	std::vector<V> decoded((size_t)tapsY.Count * width);
+	std::vector<int32_t> slotRow(tapsY.Count, -1);
+	std::vector<uint32_t> slotUsed(tapsY.Count, 0);
+	auto decodedRow = [&](int32_t sourceRow, uint32_t y) {
+		uint32_t slot = 0;
+		while (slot < tapsY.Count && slotRow[slot] != sourceRow)
+			++slot;
+		if (slot == tapsY.Count)
+		{
+			slot = 0;
+			while (slotUsed[slot] == y + 1)
+				++slot;
+			slotRow[slot] = sourceRow;
+			const uint8_t* row = src + (size_t)sourceRow * width * 4;
+			V* out = &decoded[(size_t)slot * width];
+			for (uint32_t x = 0; x < width; ++x)
+				out[x] = Ops::Decode(row + x * 4, srgb);
+		}
+		slotUsed[slot] = y + 1;
+		return &decoded[(size_t)slot * width];
+	};
+
+	std::vector<V> column(width);
+	for (uint32_t y = 0; y < dstHeight; ++y)
+	{
+		std::fill(column.begin(), column.end(), InitialValue<Ops, R>());
+		for (uint32_t k = 0; k < tapsY.Count; ++k)
+		{
+			const float weight = tapsY.Weights[y * tapsY.Count + k];
+			if (R == Reduce::Weighted && weight == 0.0f)
+				continue;
+			const V* row = decodedRow(tapsY.Index[y * tapsY.Count + k], y);
+			for (uint32_t x = 0; x < width; ++x)
+				column[x] = Accumulate<Ops, R>(column[x], row[x], weight);
+		}
+
+		uint8_t* dstRow = dst + (size_t)y * dstWidth * 4;
+		for (uint32_t x = 0; x < dstWidth; ++x)
+		{
+			const int32_t* index = &tapsX.Index[x * tapsX.Count];
+			const float* weights = &tapsX.Weights[x * tapsX.Count];
+			V acc = InitialValue<Ops, R>();
+			for (uint32_t k = 0; k < tapsX.Count; ++k)
+				acc = Accumulate<Ops, R>(acc, column[index[k]], weights[k]);
+			Ops::Encode(acc, dstRow + x * 4, srgb);
+		}
+	}
+}
+
+template<typename Ops>
+void DownsampleWith(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst, const MipChainOptions& options)
+{
+	const AxisTaps tapsX = BuildTaps(width, options.Filter, options.Wrap);
+	const AxisTaps tapsY = BuildTaps(height, options.Filter, options.Wrap);
+	switch (options.Filter)
+	{
+	case MipFilter::Min:
+		DownsampleSeparable<Ops, Reduce::Min>(src, width, height, dst, options.Srgb, tapsX, tapsY);
+		break;
+	case MipFilter::Max:
+		DownsampleSeparable<Ops, Reduce::Max>(src, width, height, dst, options.Srgb, tapsX, tapsY);
+		break;
+	default:
+		DownsampleSeparable<Ops, Reduce::Weighted>(src, width, height, dst, options.Srgb, tapsX, tapsY);
+		break;
+	}
+}
+
+}
+
+uint32_t GetMipCount(uint32_t width, uint32_t height)
+{
+	uint32_t count = 1;
+	for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+		++count;
+	return count;
+}
+
+void DownsampleRgba8(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst, const MipChainOptions& options)
+{
+#if SOCO_MIP_SSE2
+	if (options.UseSimd)
+	{
+		DownsampleWith<SseOps>(src, width, height, dst, options);
+		return;
+	}
+#endif
+	DownsampleWith<ScalarOps>(src, width, height, dst, options);
+}
+
+std::vector<MipImage> GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, const MipChainOptions& options)
+{
+	SOCO_PROFILE_SCOPE("GenerateMipChain");
+	std::vector<MipImage> chain;
+	const uint8_t* src = pixels;
+	for (uint32_t level = 1; level < GetMipCount(width, height); ++level)
+	{
+		const uint32_t srcWidth = std::max(1u, width >> (level - 1));
+		const uint32_t srcHeight = std::max(1u, height >> (level - 1));
+
+		MipImage image;
+		image.Width = std::max(1u, width >> level);
+		image.Height = std::max(1u, height >> level);
+		image.Pixels.resize((size_t)image.Width * image.Height * 4);
+		DownsampleRgba8(src, srcWidth, srcHeight, image.Pixels.data(), options);
+
+		chain.push_back(std::move(image));
+		src = chain.back().Pixels.data();
+	}
+	return chain;
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Soco
+{
+
+enum class MipFilter
+{
+	// 按面积平均，奇数宽高时每个目标像素覆盖2又1/n个源像素
+	Box,
+	// 半径3个目标像素的Kaiser窗sinc(alpha = 4)，比Box锐利，会有轻微的振铃，结果截断到[0, 1]
+	Kaiser,
+	// 覆盖范围内的最小、最大值，用于高度图的保守包围(比如按mip剔除地形块)
+	Min,
+	Max,
+};
+
+struct MipChainOptions
+{
+	MipFilter Filter = MipFilter::Box;
+	// RGB按sRGB编码：先转到线性空间滤波再编码回去，alpha始终按线性处理
+	bool Srgb = false;
+	// 超出边缘的采样回绕还是截断，只影响Kaiser
+	bool Wrap = false;
+	// 一个RGBA像素作为一个SSE2向量滤波，关闭时用逐通道的标量实现，没有SSE2的平台总是标量
+	// sRGB的查表解码/编码两种实现都是标量的，SIMD只加速滤波累加
+	bool UseSimd = true;
+};
+
+struct MipImage
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	// RGBA8，行之间没有间隙
+	std::vector<uint8_t> Pixels;
+};
+
+// 包括第0级、一直到1x1的mip数
+uint32_t GetMipCount(uint32_t width, uint32_t height);
+
+// 把width x height的RGBA8图像缩小一级写到dst，dst的宽高是max(1, width / 2) x max(1, height / 2)
+void DownsampleRgba8(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst, const MipChainOptions& options);
+
+// 第0级之外的所有mip，第i个元素是第i + 1级，每级都由上一级缩小得到(和GPU上逐级生成的方式相同)
+std::vector<MipImage> GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, const MipChainOptions& options);
+
+}
@@ -0,0 +1,58 @@
+#include "MipStreaming.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace Soco
+{
+
+float ComputeUvDensity(const float* positions, size_t positionStride, const float* uvs, size_t uvStride,
+	const uint32_t* indices, size_t indexCount)
+{
+	auto position = [&](uint32_t i) { return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + i * positionStride); };
+	auto uv = [&](uint32_t i) { return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(uvs) + i * uvStride); };
+
+	double worldArea = 0;
+	double uvArea = 0;
+	for (size_t t = 0; t + 2 < indexCount; t += 3)
+	{
+		const float* p0 = position(indices[t]);
+		const float* p1 = position(indices[t + 1]);
+		const float* p2 = position(indices[t + 2]);
+		const double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		const double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		const double cross[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		worldArea += 0.5 * std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+
+		const float* t0 = uv(indices[t]);
+		const float* t1 = uv(indices[t + 1]);
+		const float* t2 = uv(indices[t + 2]);
+		uvArea += 0.5 * std::abs((double)(t1[0] - t0[0]) * (t2[1] - t0[1]) - (double)(t1[1] - t0[1]) * (t2[0] - t0[0]));
+	}
+
+	if (worldArea <= 0)
+		return 0.0f;
+	return (float)std::sqrt(uvArea / worldArea);
+}
+
+float ComputeScreenUvDensity(float uvDensity, float scale, float depth, float projScale)
+{
+	if (depth <= 0.0f)
+		return FLT_MAX;
+	//一个UV单位是scale / uvDensity个世界单位，在深度depth处每个世界单位约projScale / depth个像素
+	return scale * projScale / (depth * std::max(uvDensity, 1e-12f));
+}
+
+uint32_t EstimateMipLevel(uint64_t width, uint32_t height, uint32_t mipCount, float pixelsPerUv)
+{
+	if (mipCount == 0)
+		return 0;
+	const double texelsPerPixel = (double)std::max<uint64_t>(width, height) / (double)pixelsPerUv;
+	if (!(texelsPerPixel > 1.0))
+		return 0;
+	const double mip = std::floor(std::log2(texelsPerPixel));
+	return (uint32_t)std::min<double>(mip, mipCount - 1);
+}
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Soco
+{
+
+/*
+网格的UV密度：每个世界单位(物体空间)对应多少UV单位，等于sqrt(UV面积之和 / 三角形面积之和)
+纹理宽W的贴图上，一个世界单位大约覆盖W * density个纹素；退化网格返回0
+*/
+float ComputeUvDensity(const float* positions, size_t positionStride, const float* uvs, size_t uvStride,
+	const uint32_t* indices, size_t indexCount);
+
+/*
+屏幕上每个UV单位覆盖的像素数：物体缩放scale、UV密度uvDensity，离相机最近处的视空间深度为depth，
+projScale = viewportHeight / (2 * tan(fovY / 2))；用深度而不是距离，偏离视线中心的物体也不会估粗
+depth <= 0(相机在包围球里)时返回FLT_MAX，即需要最精细一级
+*/
+float ComputeScreenUvDensity(float uvDensity, float scale, float depth, float projScale);
+
+// 一个像素覆盖不到一个纹素时用第0级，否则是floor(log2(纹素/像素))，不超过最粗一级
+uint32_t EstimateMipLevel(uint64_t width, uint32_t height, uint32_t mipCount, float pixelsPerUv);
+
+}
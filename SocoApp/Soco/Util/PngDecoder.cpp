@@ -0,0 +1,952 @@
+#include "PngDecoder.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "../../Common/lodepng.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SOCO_PNG_SSE2 1
+#else
+#define SOCO_PNG_SSE2 0
+#endif
+
+namespace Soco
+{
+
+namespace
+{
+
+//---------------------------------------- inflate ----------------------------------------
+
+// deflate的位流从低位开始读，一次补满到至少56位，一个长度/距离对最多用48位，每个符号只需补一次
+class BitStream
+{
+public:
+	BitStream(const uint8_t* data, size_t size) : mData(data), mSize(size) {}
+
+	void Refill()
+	{
+		if (mPos + 8 <= mSize)
+		{
+			//多读进来的高位和下次要读的字节相同，重复或上去不影响结果
+			uint64_t value;
+			memcpy(&value, mData + mPos, 8);
+			mBits |= value << mCount;
+			mPos += (63 - mCount) >> 3;
+			mCount |= 56;
+		}
+		else
+		{
+			//末尾不够8字节时逐字节补，超出的部分补0，最后由Overrun检查
+			while (mCount <= 56)
+			{
+				const uint64_t value = mPos < mSize ? mData[mPos] : 0;
+				mBits |= value << mCount;
+				++mPos;
+				mCount += 8;
+			}
+		}
+	}
+
+	uint64_t Peek() const { return mBits; }
+	void Consume(uint32_t count) { mBits >>= count; mCount -= count; }
+	uint32_t Bits(uint32_t count)
+	{
+		const uint32_t value = (uint32_t)(mBits & ((1ull << count) - 1));
+		Consume(count);
+		return value;
+	}
+
+	// 跳到下一个字节边界，返回之后第一个未读字节的位置，缓冲的位清空
+	size_t AlignToByte()
+	{
+		Consume(mCount & 7);
+		const size_t position = mPos - mCount / 8;
+		mPos = position;
+		mBits = 0;
+		mCount = 0;
+		return position;
+	}
+	void Skip(size_t position) { mPos = position; }
+
+	bool Overrun() const { return mPos * 8 - mCount > mSize * 8; }
+
+private:
+	const uint8_t* mData;
+	size_t mSize;
+	size_t mPos = 0;
+	uint64_t mBits = 0;
+	uint32_t mCount = 0;
+};
+
+// 码长不超过FastBits的符号直接查表，更长的按规范哈夫曼码逐位找
+class HuffmanTable
+{
+public:
+	static const uint32_t FastBits = 10;
+
+	bool Build(const uint8_t* lengths, uint32_t count)
+	{
+		memset(mCounts, 0, sizeof(mCounts));
+		for (uint32_t i = 0; i < count; ++i)
+			++mCounts[lengths[i]];
+		mCounts[0] = 0;
+
+		//过度订阅的码无效，不完整的码允许(只有一个距离码时就是这样)，用到缺的码时解码失败
+		int left = 1;
+		for (uint32_t length = 1; length <= 15; ++length)
+		{
+			left = (left << 1) - mCounts[length];
+			if (left < 0)
+				return false;
+		}
+
+		uint16_t offsets[16] = {};
+		for (uint32_t length = 1; length < 15; ++length)
+			offsets[length + 1] = offsets[length] + mCounts[length];
+		for (uint32_t symbol = 0; symbol < count; ++symbol)
+			if (lengths[symbol] != 0)
+				mSymbols[offsets[lengths[symbol]]++] = (uint16_t)symbol;
+
+		//码是从高位开始定义的，位流从低位读，查表的下标要把码反过来
+		memset(mFast, 0, sizeof(mFast));
+		uint32_t code = 0, index = 0;
+		for (uint32_t length = 1; length <= FastBits; ++length)
+		{
+			for (uint32_t k = 0; k < mCounts[length]; ++k, ++code)
+			{
+				uint32_t reversed = 0;
+				for (uint32_t bit = 0; bit < length; ++bit)
+					reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+				const uint16_t entry = (uint16_t)((mSymbols[index++] << 4) | length);
+				for (uint32_t j = reversed; j < (1u << FastBits); j += 1u << length)
+					mFast[j] = entry;
+			}
+			code <<= 1;
+		}
+		return true;
+	}
+
+	// bits至少有15位有效，返回符号，码无效时返回-1
+	int Decode(uint64_t bits, uint32_t& length) const
+	{
+		const uint16_t entry = mFast[bits & ((1u << FastBits) - 1)];
+		if (entry != 0)
+		{
+			length = entry & 15;
+			return entry >> 4;
+		}
+
+		int code = 0, first = 0, index = 0;
+		for (uint32_t bitLength = 1; bitLength <= 15; ++bitLength)
+		{
+			code |= (int)((bits >> (bitLength - 1)) & 1);
+			const int count = mCounts[bitLength];
+			if (code - first < count)
+			{
+				length = bitLength;
+				return mSymbols[index + code - first];
+			}
+			index += count;
+			first = (first + count) << 1;
+			code <<= 1;
+		}
+		return -1;
+	}
+
+private:
+	// (符号 << 4) | 码长，0表示不在表里
+	uint16_t mFast[1 << FastBits];
+	uint16_t mCounts[16];
+	uint16_t mSymbols[288];
+};
+
+const uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+	1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// 每解压出这么多字节通知一次，让另一个线程开始处理已经完整的行
+const size_t ProgressBytes = 64 * 1024;
+
+const char* ReadDynamicTables(BitStream& bits, HuffmanTable& literals, HuffmanTable& distances)
+{
+	static const uint8_t CodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	bits.Refill();
+	const uint32_t literalCount = bits.Bits(5) + 257;
+	const uint32_t distanceCount = bits.Bits(5) + 1;
+	const uint32_t codeLengthCount = bits.Bits(4) + 4;
+	if (literalCount > 286 || distanceCount > 30)
+		return "哈夫曼表的大小无效";
+
+	uint8_t codeLengths[19] = {};
+	for (uint32_t i = 0; i < codeLengthCount; ++i)
+	{
+		bits.Refill();
+		codeLengths[CodeLengthOrder[i]] = (uint8_t)bits.Bits(3);
+	}
+	HuffmanTable codeLengthTable;
+	if (!codeLengthTable.Build(codeLengths, 19))
+		return "码长的哈夫曼表无效";
+
+	uint8_t lengths[286 + 30] = {};
+	const uint32_t total = literalCount + distanceCount;
+	for (uint32_t i = 0; i < total;)
+	{
+		bits.Refill();
+		uint32_t codeLength = 0;
+		const int symbol = codeLengthTable.Decode(bits.Peek(), codeLength);
+		if (symbol < 0)
+			return "码长解码失败";
+		bits.Consume(codeLength);
+
+		if (symbol < 16)
+		{
+			lengths[i++] = (uint8_t)symbol;
+			continue;
+		}
+		uint8_t value = 0;
+		uint32_t repeat = 0;
+		if (symbol == 16)
+		{
+			if (i == 0)
+				return "第一个码长不能是重复";
+			value = lengths[i - 1];
+			repeat = 3 + bits.Bits(2);
+		}
+		else if (symbol == 17)
+		{
+			repeat = 3 + bits.Bits(3);
+		}
+		else
+		{
+			repeat = 11 + bits.Bits(7);
+		}
+		if (i + repeat > total)
+			return "码长超出哈夫曼表";
+		memset(lengths + i, value, repeat);
+		i += repeat;
+	}
+	if (lengths[256] == 0)
+		return "缺少块结束的码";
+
+	if (!literals.Build(lengths, literalCount) || !distances.Build(lengths + literalCount, distanceCount))
+		return "哈夫曼表无效";
+	return nullptr;
+}
+
+/*
+把zlib流解压到out，解压后的大小必须正好是outSize；每解压出ProgressBytes字节调用一次progress(已解压的字节数)
+整个输出缓冲都在，回溯引用直接从输出里复制，不需要单独的窗口
+*/
+template<typename Progress>
+const char* Inflate(const uint8_t* data, size_t size, uint8_t* out, size_t outSize, Progress&& progress, uint32_t& adler)
+{
+	if (size < 6)
+		return "zlib数据太短";
+	const uint32_t cmf = data[0], flags = data[1];
+	if ((cmf & 15) != 8 || (cmf >> 4) > 7 || (cmf * 256 + flags) % 31 != 0)
+		return "zlib头无效";
+	if (flags & 32)
+		return "不支持预设字典";
+
+	BitStream bits(data + 2, size - 2);
+	HuffmanTable literals, distances;
+	size_t outPos = 0, reported = 0;
+	bool finalBlock = false;
+	while (!finalBlock)
+	{
+		bits.Refill();
+		finalBlock = bits.Bits(1) != 0;
+		const uint32_t type = bits.Bits(2);
+
+		if (type == 0)
+		{
+			const size_t position = bits.AlignToByte();
+			if (position + 4 > size - 2)
+				return "存储块的头超出数据";
+			const uint8_t* header = data + 2 + position;
+			const uint32_t length = header[0] | (header[1] << 8);
+			const uint32_t inverse = header[2] | (header[3] << 8);
+			if ((length ^ 0xFFFF) != inverse)
+				return "存储块的长度校验错误";
+			if (position + 4 + length > size - 2)
+				return "存储块超出数据";
+			if (length > outSize - outPos)
+				return "解压后的数据比图像大";
+			memcpy(out + outPos, header + 4, length);
+			outPos += length;
+			bits.Skip(position + 4 + length);
+		}
+		else if (type == 1 || type == 2)
+		{
+			if (type == 1)
+			{
+				uint8_t lengths[288 + 30];
+				memset(lengths, 8, 144);
+				memset(lengths + 144, 9, 112);
+				memset(lengths + 256, 7, 24);
+				memset(lengths + 280, 8, 8);
+				memset(lengths + 288, 5, 30);
+				literals.Build(lengths, 288);
+				distances.Build(lengths + 288, 30);
+			}
+			else if (const char* error = ReadDynamicTables(bits, literals, distances))
+			{
+				return error;
+			}
+
+			for (;;)
+			{
+				bits.Refill();
+				uint32_t codeLength = 0;
+				int symbol = literals.Decode(bits.Peek(), codeLength);
+				if (symbol < 0)
+					return "字面量/长度解码失败";
+				bits.Consume(codeLength);
+
+				if (symbol < 256)
+				{
+					if (outPos >= outSize)
+						return "解压后的数据比图像大";
+					out[outPos++] = (uint8_t)symbol;
+					continue;
+				}
+				if (symbol == 256)
+					break;
+
+				symbol -= 257;
+				if (symbol >= 29)
+					return "长度码无效";
+				const uint32_t length = LengthBase[symbol] + bits.Bits(LengthExtra[symbol]);
+				const int distanceSymbol = distances.Decode(bits.Peek(), codeLength);
+				if (distanceSymbol < 0 || distanceSymbol >= 30)
+					return "距离码无效";
+				bits.Consume(codeLength);
+				const uint32_t distance = DistanceBase[distanceSymbol] + bits.Bits(DistanceExtra[distanceSymbol]);
+				if (distance > outPos)
+					return "回溯距离超出已解压的数据";
+				if (length > outSize - outPos)
+					return "解压后的数据比图像大";
+
+				uint8_t* dst = out + outPos;
+				const uint8_t* src = dst - distance;
+				if (distance >= 8 && outPos + length + 8 <= outSize)
+				{
+					//每次复制8字节，不超过距离所以不会读到这次还没写的字节，末尾多写的部分之后会被覆盖
+					for (uint32_t i = 0; i < length; i += 8)
+						memcpy(dst + i, src + i, 8);
+				}
+				else
+				{
+					for (uint32_t i = 0; i < length; ++i)
+						dst[i] = src[i];
+				}
+				outPos += length;
+
+				if (outPos - reported >= ProgressBytes)
+				{
+					progress(outPos);
+					reported = outPos;
+				}
+			}
+		}
+		else
+		{
+			return "deflate块类型无效";
+		}
+
+		if (bits.Overrun())
+			return "deflate数据被截断";
+		if (outPos - reported >= ProgressBytes)
+		{
+			progress(outPos);
+			reported = outPos;
+		}
+	}
+
+	if (outPos != outSize)
+		return "解压后的数据比图像小";
+	progress(outPos);
+
+	const size_t position = bits.AlignToByte();
+	if (position + 4 > size - 2)
+		return "缺少Adler32校验";
+	const uint8_t* checksum = data + 2 + position;
+	adler = ((uint32_t)checksum[0] << 24) | ((uint32_t)checksum[1] << 16) | ((uint32_t)checksum[2] << 8) | checksum[3];
+	return nullptr;
+}
+
+//---------------------------------------- 反滤波 ----------------------------------------
+
+uint8_t PaethPredictor(int a, int b, int c)
+{
+	const int pa = std::abs(b - c), pb = std::abs(a - c), pc = std::abs(a + b - 2 * c);
+	if (pa <= pb && pa <= pc)
+		return (uint8_t)a;
+	return (uint8_t)(pb <= pc ? b : c);
+}
+
+void UnfilterRowScalar(uint8_t filter, const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes, uint32_t bpp)
+{
+	switch (filter)
+	{
+	case 0:
+		memcpy(dst, src, rowBytes);
+		break;
+	case 1:
+		for (size_t i = 0; i < rowBytes; ++i)
+			dst[i] = (uint8_t)(src[i] + (i >= bpp ? dst[i - bpp] : 0));
+		break;
+	case 2:
+		for (size_t i = 0; i < rowBytes; ++i)
+			dst[i] = (uint8_t)(src[i] + prev[i]);
+		break;
+	case 3:
+		for (size_t i = 0; i < rowBytes; ++i)
+			dst[i] = (uint8_t)(src[i] + (((i >= bpp ? dst[i - bpp] : 0) + prev[i]) >> 1));
+		break;
+	case 4:
+		for (size_t i = 0; i < rowBytes; ++i)
+			dst[i] = (uint8_t)(src[i] + (i >= bpp ? PaethPredictor(dst[i - bpp], prev[i], prev[i - bpp]) : prev[i]));
+		break;
+	}
+}
+
+#if SOCO_PNG_SSE2
+/*
+Sub/Avg/Paeth依赖左边的像素，没法跨像素并行，一次处理一个像素的所有字节(libpng的做法)
+Paeth在16位里算，三个距离用max(x, -x)求绝对值，按a、b、c的优先级选出预测值，没有分支
+*/
+template<uint32_t Bpp>
+__m128i LoadPixel(const uint8_t* p)
+{
+	uint64_t value = 0;
+	memcpy(&value, p, Bpp);
+	return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&value));
+}
+
+template<uint32_t Bpp>
+void StorePixel(uint8_t* p, __m128i pixel)
+{
+	uint64_t value;
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(&value), pixel);
+	memcpy(p, &value, Bpp);
+}
+
+void UnfilterUpSse(const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes)
+{
+	size_t i = 0;
+	for (; i + 16 <= rowBytes; i += 16)
+	{
+		const __m128i sum = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), sum);
+	}
+	for (; i < rowBytes; ++i)
+		dst[i] = (uint8_t)(src[i] + prev[i]);
+}
+
+template<uint32_t Bpp>
+void UnfilterRowSse(uint8_t filter, const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes)
+{
+	const __m128i zero = _mm_setzero_si128();
+	switch (filter)
+	{
+	case 0:
+		memcpy(dst, src, rowBytes);
+		break;
+	case 1:
+	{
+		__m128i a = zero;
+		for (size_t i = 0; i < rowBytes; i += Bpp)
+		{
+			a = _mm_add_epi8(LoadPixel<Bpp>(src + i), a);
+			StorePixel<Bpp>(dst + i, a);
+		}
+		break;
+	}
+	case 2:
+		UnfilterUpSse(src, prev, dst, rowBytes);
+		break;
+	case 3:
+	{
+		//_mm_avg_epu8是向上取整，(a ^ b) & 1的地方减1变成向下取整
+		const __m128i one = _mm_set1_epi8(1);
+		__m128i a = zero;
+		for (size_t i = 0; i < rowBytes; i += Bpp)
+		{
+			const __m128i b = LoadPixel<Bpp>(prev + i);
+			const __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+			a = _mm_add_epi8(LoadPixel<Bpp>(src + i), average);
+			StorePixel<Bpp>(dst + i, a);
+		}
+		break;
+	}
+	case 4:
+	{
+		__m128i a = zero, c = zero;
+		for (size_t i = 0; i < rowBytes; i += Bpp)
+		{
+			const __m128i b = _mm_unpacklo_epi8(LoadPixel<Bpp>(prev + i), zero);
+			__m128i pa = _mm_sub_epi16(b, c);
+			__m128i pb = _mm_sub_epi16(a, c);
+			__m128i pc = _mm_add_epi16(pa, pb);
+			pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+			pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+			pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+			const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+			const __m128i useB = _mm_cmpeq_epi16(pb, smallest);
+			const __m128i bOrC = _mm_or_si128(_mm_and_si128(useB, b), _mm_andnot_si128(useB, c));
+			const __m128i useA = _mm_cmpeq_epi16(pa, smallest);
+			const __m128i predictor = _mm_or_si128(_mm_and_si128(useA, a), _mm_andnot_si128(useA, bOrC));
+
+			const __m128i pixel = _mm_add_epi8(LoadPixel<Bpp>(src + i), _mm_packus_epi16(predictor, predictor));
+			StorePixel<Bpp>(dst + i, pixel);
+			a = _mm_unpacklo_epi8(pixel, zero);
+			c = b;
+		}
+		break;
+	}
+	}
+}
+#endif
+
+void UnfilterRow(uint8_t filter, const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes, uint32_t bpp, bool useSimd)
+{
+#if SOCO_PNG_SSE2
+	if (useSimd)
+	{
+		switch (bpp)
+		{
+		case 2: UnfilterRowSse<2>(filter, src, prev, dst, rowBytes); return;
+		case 3: UnfilterRowSse<3>(filter, src, prev, dst, rowBytes); return;
+		case 4: UnfilterRowSse<4>(filter, src, prev, dst, rowBytes); return;
+		case 6: UnfilterRowSse<6>(filter, src, prev, dst, rowBytes); return;
+		case 8: UnfilterRowSse<8>(filter, src, prev, dst, rowBytes); return;
+		default:
+			//每像素1字节时逐像素没有好处，只有Up能并行
+			if (filter == 2)
+			{
+				UnfilterUpSse(src, prev, dst, rowBytes);
+				return;
+			}
+			break;
+		}
+	}
+#endif
+	UnfilterRowScalar(filter, src, prev, dst, rowBytes, bpp);
+}
+
+//---------------------------------------- 格式转换 ----------------------------------------
+
+// PNG里16位的样本是大端
+template<int Bytes>
+uint32_t ReadSample(const uint8_t* p, int channel)
+{
+	if constexpr (Bytes == 1)
+		return p[channel];
+	else
+		return ((uint32_t)p[channel * 2] << 8) | p[channel * 2 + 1];
+}
+
+template<int SrcBytes, int OutBytes>
+void WriteSample(uint8_t* p, int channel, uint32_t value)
+{
+	if constexpr (OutBytes == 1)
+	{
+		p[channel] = (uint8_t)(SrcBytes == 1 ? value : value >> 8);
+	}
+	else
+	{
+		const uint16_t sample = (uint16_t)(SrcBytes == 2 ? value : value * 257);
+		memcpy(p + channel * 2, &sample, 2);
+	}
+}
+
+// 源是1灰度、2灰度+alpha、3RGB、4RGBA
+template<int SrcChannels, int SrcBytes, int OutChannels, int OutBytes>
+void ConvertRow(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; ++x, src += SrcChannels * SrcBytes, dst += OutChannels * OutBytes)
+	{
+		uint32_t rgba[4];
+		rgba[0] = ReadSample<SrcBytes>(src, 0);
+		if constexpr (OutChannels == 4)
+		{
+			if constexpr (SrcChannels <= 2)
+			{
+				rgba[1] = rgba[2] = rgba[0];
+			}
+			else
+			{
+				rgba[1] = ReadSample<SrcBytes>(src, 1);
+				rgba[2] = ReadSample<SrcBytes>(src, 2);
+			}
+			if constexpr (SrcChannels == 2 || SrcChannels == 4)
+				rgba[3] = ReadSample<SrcBytes>(src, SrcChannels - 1);
+			else
+				rgba[3] = SrcBytes == 1 ? 255 : 65535;
+		}
+		for (int c = 0; c < OutChannels; ++c)
+			WriteSample<SrcBytes, OutBytes>(dst, c, rgba[c]);
+	}
+}
+
+using ConvertRowFunc = void(*)(const uint8_t*, uint8_t*, uint32_t);
+
+template<int SrcChannels, int SrcBytes>
+ConvertRowFunc SelectOutput(uint32_t channels, uint32_t bitDepth)
+{
+	if (channels == 1)
+		return bitDepth == 8 ? ConvertRow<SrcChannels, SrcBytes, 1, 1> : ConvertRow<SrcChannels, SrcBytes, 1, 2>;
+	return bitDepth == 8 ? ConvertRow<SrcChannels, SrcBytes, 4, 1> : ConvertRow<SrcChannels, SrcBytes, 4, 2>;
+}
+
+ConvertRowFunc SelectConverter(uint32_t srcChannels, uint32_t srcBytes, uint32_t channels, uint32_t bitDepth)
+{
+	switch (srcChannels * 2 + srcBytes - 1)
+	{
+	case 2: return SelectOutput<1, 1>(channels, bitDepth);
+	case 3: return SelectOutput<1, 2>(channels, bitDepth);
+	case 4: return SelectOutput<2, 1>(channels, bitDepth);
+	case 5: return SelectOutput<2, 2>(channels, bitDepth);
+	case 6: return SelectOutput<3, 1>(channels, bitDepth);
+	case 7: return SelectOutput<3, 2>(channels, bitDepth);
+	case 8: return SelectOutput<4, 1>(channels, bitDepth);
+	default: return SelectOutput<4, 2>(channels, bitDepth);
+	}
+}
+
+//---------------------------------------- 文件结构 ----------------------------------------
+
+struct PngHeader
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t BitDepth = 0;
+	uint32_t ColorType = 0;
+	uint32_t Interlace = 0;
+	// 调色板、低于8位、隔行或者有tRNS，交给lodepng
+	bool NeedsFallback = false;
+	std::vector<uint8_t> Idat;
+
+	uint32_t SourceChannels() const
+	{
+		switch (ColorType)
+		{
+		case 0: return 1;
+		case 2: return 3;
+		case 4: return 2;
+		case 6: return 4;
+		default: return 1;
+		}
+	}
+};
+
+uint32_t ReadBigEndian32(const uint8_t* p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+const char* ParseChunks(const uint8_t* data, size_t size, PngHeader& header)
+{
+	static const uint8_t Signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	if (size < 8 || memcmp(data, Signature, 8) != 0)
+		return "不是PNG文件";
+
+	bool hasHeader = false;
+	size_t pos = 8;
+	while (pos + 12 <= size)
+	{
+		const uint32_t length = ReadBigEndian32(data + pos);
+		const uint8_t* type = data + pos + 4;
+		if (length > size - pos - 12)
+			return "块超出文件";
+		if (lodepng_crc32(type, length + 4) != ReadBigEndian32(data + pos + 8 + length))
+			return "块的CRC错误";
+		const uint8_t* chunk = data + pos + 8;
+
+		if (memcmp(type, "IHDR", 4) == 0)
+		{
+			if (length != 13)
+				return "IHDR大小无效";
+			header.Width = ReadBigEndian32(chunk);
+			header.Height = ReadBigEndian32(chunk + 4);
+			header.BitDepth = chunk[8];
+			header.ColorType = chunk[9];
+			header.Interlace = chunk[12];
+			if (chunk[10] != 0 || chunk[11] != 0 || header.Interlace > 1)
+				return "压缩、滤波或隔行方式无效";
+			hasHeader = true;
+		}
+		else if (!hasHeader)
+		{
+			return "第一个块不是IHDR";
+		}
+		else if (memcmp(type, "IDAT", 4) == 0)
+		{
+			header.Idat.insert(header.Idat.end(), chunk, chunk + length);
+		}
+		else if (memcmp(type, "tRNS", 4) == 0)
+		{
+			header.NeedsFallback = true;
+		}
+		else if (memcmp(type, "IEND", 4) == 0)
+		{
+			break;
+		}
+		pos += 12 + (size_t)length;
+	}
+
+	if (!hasHeader)
+		return "缺少IHDR";
+	if (header.Idat.empty())
+		return "缺少IDAT";
+	if (header.Width == 0 || header.Height == 0)
+		return "图像大小为0";
+
+	const uint32_t depth = header.BitDepth;
+	bool validDepth = false;
+	switch (header.ColorType)
+	{
+	case 0: validDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16; break;
+	case 3: validDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8; break;
+	case 2: case 4: case 6: validDepth = depth == 8 || depth == 16; break;
+	}
+	if (!validDepth)
+		return "颜色类型和位深的组合无效";
+
+	header.NeedsFallback |= header.ColorType == 3 || depth < 8 || header.Interlace != 0;
+	return nullptr;
+}
+
+//---------------------------------------- 按行处理 ----------------------------------------
+
+/*
+按顺序处理已经解压出来的行：累计Adler32、反滤波、转换到输出格式
+同一时刻只有一个线程调用ProcessRows，交接由调用者保证
+*/
+class RowDecoder
+{
+public:
+	RowDecoder(const PngHeader& header, const PngDecodeOptions& options, const uint8_t* filtered, PngImage& image)
+		: mFiltered(filtered), mImage(image), mUseSimd(options.UseSimd)
+	{
+		const uint32_t sourceBytes = header.BitDepth / 8;
+		mWidth = header.Width;
+		mHeight = header.Height;
+		mBpp = header.SourceChannels() * sourceBytes;
+		mRowBytes = (size_t)mWidth * mBpp;
+		mStride = mRowBytes + 1;
+		mOutRowBytes = (size_t)mWidth * options.Channels * (options.BitDepth / 8);
+
+		//源和输出格式相同时直接反滤波到输出里，否则先到临时行再转换
+		mIdentity = header.BitDepth == 8 && options.BitDepth == 8 && header.SourceChannels() == options.Channels;
+		mConvert = SelectConverter(header.SourceChannels(), sourceBytes, options.Channels, options.BitDepth);
+		mZeroRow.assign(mRowBytes, 0);
+		if (!mIdentity)
+		{
+			mScratch[0].resize(mRowBytes);
+			mScratch[1].resize(mRowBytes);
+		}
+	}
+
+	void ProcessRows(size_t availableBytes)
+	{
+		const size_t availableRows = std::min<size_t>(availableBytes / mStride, mHeight);
+		for (; mRow < availableRows && !mFailed; ++mRow)
+		{
+			const uint8_t* line = mFiltered + mRow * mStride;
+			UpdateAdler(line, mStride);
+			if (line[0] > 4)
+			{
+				mFailed = true;
+				break;
+			}
+
+			uint8_t* out = mImage.Pixels.data() + mRow * mOutRowBytes;
+			uint8_t* dst = mIdentity ? out : mScratch[mRow & 1].data();
+			const uint8_t* prev = mRow == 0 ? mZeroRow.data() : mPrev;
+			UnfilterRow(line[0], line + 1, prev, dst, mRowBytes, mBpp, mUseSimd);
+			if (!mIdentity)
+				mConvert(dst, out, mWidth);
+			mPrev = dst;
+		}
+	}
+
+	bool HasPendingRows(size_t availableBytes) const { return !mFailed && std::min<size_t>(availableBytes / mStride, mHeight) > mRow; }
+	bool Failed() const { return mFailed; }
+	bool Finished() const { return !mFailed && mRow == mHeight; }
+	uint32_t Adler() const { return (mAdlerB << 16) | mAdlerA; }
+
+private:
+	void UpdateAdler(const uint8_t* data, size_t size)
+	{
+		//5552是保证32位累加不溢出的最大段长
+		while (size > 0)
+		{
+			size_t count = std::min<size_t>(size, 5552);
+			size -= count;
+			while (count-- > 0)
+			{
+				mAdlerA += *data++;
+				mAdlerB += mAdlerA;
+			}
+			mAdlerA %= 65521;
+			mAdlerB %= 65521;
+		}
+	}
+
+	const uint8_t* mFiltered;
+	PngImage& mImage;
+	bool mUseSimd;
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	uint32_t mBpp = 0;
+	size_t mRowBytes = 0;
+	size_t mStride = 0;
+	size_t mOutRowBytes = 0;
+	bool mIdentity = false;
+	ConvertRowFunc mConvert = nullptr;
+
+	std::vector<uint8_t> mZeroRow;
+	std::vector<uint8_t> mScratch[2];
+	const uint8_t* mPrev = nullptr;
+	size_t mRow = 0;
+	bool mFailed = false;
+	uint32_t mAdlerA = 1;
+	uint32_t mAdlerB = 0;
+};
+
+bool DecodeWithLodepng(const uint8_t* data, size_t size, const PngDecodeOptions& options, PngImage& image)
+{
+	unsigned char* rgba = nullptr;
+	unsigned width = 0, height = 0;
+	const unsigned error = lodepng_decode_memory(&rgba, &width, &height, data, size, LCT_RGBA, 16);
+	if (error)
+	{
+		std::cout << "PNG解码：" << lodepng_error_text(error) << std::endl;
+		free(rgba);
+		return false;
+	}
+
+	const ConvertRowFunc convert = SelectConverter(4, 2, options.Channels, options.BitDepth);
+	const size_t outRowBytes = (size_t)width * options.Channels * (options.BitDepth / 8);
+	for (unsigned y = 0; y < height; ++y)
+		convert(rgba + (size_t)y * width * 8, image.Pixels.data() + y * outRowBytes, width);
+	free(rgba);
+	return true;
+}
+
+}
+
+bool DecodePng(const uint8_t* data, size_t size, const PngDecodeOptions& options, PngImage& image)
+{
+	SOCO_PROFILE_SCOPE("DecodePng");
+	if ((options.Channels != 1 && options.Channels != 4) || (options.BitDepth != 8 && options.BitDepth != 16))
+	{
+		std::cout << "PNG解码：只支持输出1或4通道、8或16位" << std::endl;
+		return false;
+	}
+
+	PngHeader header;
+	if (const char* error = ParseChunks(data, size, header))
+	{
+		std::cout << "PNG解码：" << error << std::endl;
+		return false;
+	}
+
+	const uint64_t outputBytes = (uint64_t)header.Width * header.Height * options.Channels * (options.BitDepth / 8);
+	const uint64_t filteredBytes = ((uint64_t)header.Width * header.SourceChannels() * std::max(header.BitDepth / 8, 1u) + 1) * header.Height;
+	if (outputBytes > (1ull << 32) || filteredBytes > (1ull << 32))
+	{
+		std::cout << "PNG解码：图像太大(" << header.Width << "x" << header.Height << ")" << std::endl;
+		return false;
+	}
+	image.Width = header.Width;
+	image.Height = header.Height;
+	image.Channels = options.Channels;
+	image.BitDepth = options.BitDepth;
+	image.Pixels.resize((size_t)outputBytes);
+
+	if (header.NeedsFallback)
+		return DecodeWithLodepng(data, size, options, image);
+
+	std::vector<uint8_t> filtered((size_t)filteredBytes);
+	RowDecoder rows(header, options, filtered.data(), image);
+
+	/*
+	deflate只能顺序解压，能并行的是解压之后的工作：每解压出一段，已经完整的行交给另一个job反滤波
+	running保证同一时刻只有一个job在处理行，job处理完后再检查一次，避免和刚发布的进度错过
+	*/
+	JobSystem* jobs = JobSystem::GetInstance();
+	JobCounter counter;
+	std::atomic<size_t> available = 0;
+	std::atomic<bool> running = false;
+	auto consume = [&]() {
+		for (;;)
+		{
+			rows.ProcessRows(available.load());
+			running.store(false);
+			if (!rows.HasPendingRows(available.load()) || running.exchange(true))
+				return;
+		}
+	};
+	auto progress = [&](size_t bytes) {
+		available.store(bytes);
+		if (options.Pipelined && !running.exchange(true))
+			jobs->Run(consume, &counter);
+	};
+
+	uint32_t adler = 0;
+	const char* error = Inflate(header.Idat.data(), header.Idat.size(), filtered.data(), filtered.size(), progress, adler);
+	jobs->Wait(counter);
+	if (error != nullptr)
+	{
+		std::cout << "PNG解码：" << error << std::endl;
+		return false;
+	}
+
+	rows.ProcessRows(filtered.size());
+	if (!rows.Finished())
+	{
+		std::cout << "PNG解码：无效的滤波类型" << std::endl;
+		return false;
+	}
+	if (rows.Adler() != adler)
+	{
+		std::cout << "PNG解码：Adler32校验错误" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool DecodePngFile(const std::string& path, const PngDecodeOptions& options, PngImage& image)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		std::cout << "无法打开文件：" << path << std::endl;
+		return false;
+	}
+	std::vector<uint8_t> data((size_t)file.tellg());
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char*>(data.data()), data.size()))
+	{
+		std::cout << "读取文件失败：" << path << std::endl;
+		return false;
+	}
+	return DecodePng(data.data(), data.size(), options, image);
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Soco
+{
+
+struct PngDecodeOptions
+{
+	// 输出通道数，1只取R(灰度图是灰度值)，4是RGBA；灰度图的GB等于灰度，没有alpha的图A是最大值
+	uint32_t Channels = 4;
+	// 输出位深8或16，16位源转8位取高字节，8位源转16位乘257；16位输出按本机字节序
+	uint32_t BitDepth = 8;
+	// 反滤波用SSE2(每像素2字节以上时一次处理一个像素)，关闭时用逐字节的标量实现
+	bool UseSimd = true;
+	// 解压和反滤波流水线：解压出一段行就交给JobSystem的另一个线程反滤波、转换格式
+	bool Pipelined = true;
+};
+
+struct PngImage
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t Channels = 0;
+	uint32_t BitDepth = 0;
+	// 行之间没有间隙
+	std::vector<uint8_t> Pixels;
+};
+
+/*
+针对高度图的PNG解码：自己实现的inflate直接解压到按行的缓冲，反滤波和格式转换合在一起，直接输出要求的通道和位深
+支持8/16位的灰度、灰度+alpha、RGB、RGBA，非隔行、没有tRNS；其他情况(调色板、低于8位、隔行、tRNS)转给lodepng，结果相同只是慢
+和lodepng一样检查块的CRC和zlib的Adler32，失败时打印原因并返回false
+*/
+bool DecodePng(const uint8_t* data, size_t size, const PngDecodeOptions& options, PngImage& image);
+bool DecodePngFile(const std::string& path, const PngDecodeOptions& options, PngImage& image);
+
+}
@@ -0,0 +1,178 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+
+namespace Soco
+{
+
+namespace
+{
+	void WriteJsonString(std::ofstream& out, const char* text)
+	{
+		out << '"';
+		for (const char* c = text; *c != '\0'; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+				out << '\\';
+			out << *c;
+		}
+		out << '"';
+	}
+}
+
+Profiler::Profiler()
+{
+	mOriginTicks = Ticks();
+	mOriginTime = Now();
+	mFrameBeginTicks = mOriginTicks;
+}
+
+Profiler::ThreadBuffer* Profiler::RegisterThread()
+{
+	std::lock_guard<std::mutex> lock(mThreadsMutex);
+	mThreads.push_back(std::make_unique<ThreadBuffer>());
+	mThreads.back()->ThreadId = (uint32_t)mThreads.size() - 1;
+	tThreadBuffer = mThreads.back().get();
+	return tThreadBuffer;
+}
+
+void Profiler::EndFrame()
+{
+	const uint64_t endTicks = Ticks();
+	const uint64_t endTime = Now();
+
+	//构造到现在的整段作为基线，基线越长换算比例越准；一帧内的时间都用同一条直线换算，先后顺序不变
+	const double nsPerTick = endTicks > mOriginTicks ? (double)(endTime - mOriginTime) / (double)(endTicks - mOriginTicks) : 1.0;
+	auto toTime = [this, nsPerTick](uint64_t ticks) {
+		return mOriginTime + (uint64_t)std::llround((double)(int64_t)(ticks - mOriginTicks) * nsPerTick);
+	};
+
+	ProfileFrame frame;
+	frame.FrameIndex = mFrameIndex++;
+	frame.Begin = toTime(mFrameBeginTicks);
+	frame.End = toTime(endTicks);
+	mFrameBeginTicks = endTicks;
+
+	{
+		std::lock_guard<std::mutex> lock(mThreadsMutex);
+		for (std::unique_ptr<ThreadBuffer>& thread : mThreads)
+		{
+			thread->Ring.Drain([&frame, &toTime](const ProfileEvent& e) {
+				frame.Events.push_back(e);
+				frame.Events.back().Begin = toTime(e.Begin);
+				frame.Events.back().End = toTime(e.End);
+			});
+		}
+	}
+	frame.DroppedEvents = mDroppedEvents.exchange(0, std::memory_order_relaxed);
+	frame.Zones = AggregateZones(frame.Events);
+
+	mHistory.push_back(std::move(frame));
+	while (mHistory.size() > mHistorySize)
+		mHistory.pop_front();
+}
+
+void Profiler::AddGpuEvents(uint64_t frameIndex, std::vector<ProfileEvent> events)
+{
+	if (mHistory.empty() || frameIndex < mHistory.front().FrameIndex || frameIndex > mHistory.back().FrameIndex)
+		return;
+
+	ProfileFrame& frame = mHistory[frameIndex - mHistory.front().FrameIndex];
+	frame.GpuEvents = std::move(events);
+	frame.GpuZones = AggregateZones(frame.GpuEvents);
+}
+
+const char* Profiler::InternName(const std::string& name)
+{
+	//unordered_set的节点地址不会因为rehash改变
+	return mInternedNames.insert(name).first->c_str();
+}
+
+std::vector<ProfileZoneStats> Profiler::AggregateZones(const std::vector<ProfileEvent>& events)
+{
+	std::vector<ProfileZoneStats> zones;
+
+	//同一个名字在不同编译单元里可能是不同的指针，按内容汇总
+	std::unordered_map<std::string_view, size_t> zoneIndex;
+	for (const ProfileEvent& e : events)
+	{
+		auto ite = zoneIndex.find(e.Name);
+		if (ite == zoneIndex.end())
+		{
+			ite = zoneIndex.emplace(e.Name, zones.size()).first;
+			zones.emplace_back();
+			zones.back().Name = e.Name;
+		}
+
+		ProfileZoneStats& zone = zones[ite->second];
+		const uint64_t time = e.End - e.Begin;
+		zone.Count++;
+		zone.TotalTime += time;
+		zone.MaxTime = std::max<uint64_t>(zone.MaxTime, time);
+	}
+	std::sort(zones.begin(), zones.end(),
+		[](const ProfileZoneStats& a, const ProfileZoneStats& b) { return a.TotalTime > b.TotalTime; });
+
+	return zones;
+}
+
+bool Profiler::ExportChromeTrace(const std::string& path, size_t frameCount) const
+{
+	std::ofstream out(path, std::ios::out | std::ios::trunc);
+	if (!out)
+		return false;
+
+	const size_t count = std::min<size_t>(frameCount, mHistory.size());
+	const size_t first = mHistory.size() - count;
+	const uint64_t origin = count > 0 ? mHistory[first].Begin : 0;
+
+	//Chrome trace的时间单位是微秒
+	auto microseconds = [origin](uint64_t ns) { return (double)(ns - std::min<uint64_t>(ns, origin)) / 1000.0; };
+
+	out.setf(std::ios::fixed);
+	out.precision(3);
+	out << "{\"traceEvents\":[\n";
+	bool firstEvent = true;
+	auto separator = [&out, &firstEvent]() {
+		if (!firstEvent)
+			out << ",\n";
+		firstEvent = false;
+	};
+
+	for (size_t i = first; i < mHistory.size(); ++i)
+	{
+		const ProfileFrame& frame = mHistory[i];
+
+		//每帧一个总区间，放在单独的一行
+		separator();
+		out << "{\"name\":\"Frame " << frame.FrameIndex << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":\"Frames\",\"ts\":"
+			<< microseconds(frame.Begin) << ",\"dur\":" << (double)(frame.End - frame.Begin) / 1000.0 << "}";
+
+		for (const ProfileEvent& e : frame.Events)
+		{
+			separator();
+			out << "{\"name\":";
+			WriteJsonString(out, e.Name);
+			out << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.ThreadId
+				<< ",\"ts\":" << microseconds(e.Begin) << ",\"dur\":" << (double)(e.End - e.Begin) / 1000.0 << "}";
+		}
+
+		for (const ProfileEvent& e : frame.GpuEvents)
+		{
+			separator();
+			out << "{\"name\":";
+			WriteJsonString(out, e.Name);
+			out << ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":\"GPU\""
+				<< ",\"ts\":" << microseconds(e.Begin) << ",\"dur\":" << (double)(e.End - e.Begin) / 1000.0 << "}";
+		}
+	}
+
+	out << "\n]}\n";
+	return (bool)out;
+}
+
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SOCO_PROFILE_RDTSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#define SOCO_PROFILE_RDTSC 0
+#endif
+
+//定义为0时SOCO_PROFILE_SCOPE展开为空，没有任何开销
+#ifndef SOCO_PROFILE_ENABLED
+#define SOCO_PROFILE_ENABLED 1
+#endif
+
+namespace Soco
+{
+
+// 一个结束了的zone，时间单位是纳秒；还在环形缓冲里时Begin/End是Profiler::Ticks，EndFrame收集时换算
+struct ProfileEvent
+{
+	// 必须是字符串常量，只保存指针
+	const char* Name = nullptr;
+	uint64_t Begin = 0;
+	uint64_t End = 0;
+	// 嵌套深度，最外层为0
+	uint32_t Depth = 0;
+	uint32_t ThreadId = 0;
+};
+
+// 同名zone在一帧内的汇总
+struct ProfileZoneStats
+{
+	const char* Name = nullptr;
+	uint32_t Count = 0;
+	uint64_t TotalTime = 0;
+	uint64_t MaxTime = 0;
+};
+
+struct ProfileFrame
+{
+	uint64_t FrameIndex = 0;
+	uint64_t Begin = 0;
+	uint64_t End = 0;
+	std::vector<ProfileEvent> Events;
+	// 按TotalTime从大到小
+	std::vector<ProfileZoneStats> Zones;
+	// GPU时间戳几帧后才读回，到时补到对应的帧上；时间已换算到CPU时间域
+	std::vector<ProfileEvent> GpuEvents;
+	std::vector<ProfileZoneStats> GpuZones;
+	// 环形缓冲满了被丢弃的事件数
+	uint64_t DroppedEvents = 0;
+};
+
+// 单生产者单消费者的无锁环形缓冲：生产者是所属线程，消费者是调用EndFrame的线程
+class ProfileRingBuffer
+{
+public:
+	static constexpr uint64_t Capacity = 1 << 14;
+
+	ProfileRingBuffer() : mEvents(new ProfileEvent[Capacity]) {}
+
+	bool Push(const ProfileEvent& e)
+	{
+		const uint64_t write = mWrite.load(std::memory_order_relaxed);
+		//只有看起来满了才去读消费者的位置，平时不碰消费者写的缓存行
+		if (write - mReadCache >= Capacity)
+		{
+			mReadCache = mRead.load(std::memory_order_acquire);
+			if (write - mReadCache >= Capacity)
+				return false;
+		}
+
+		mEvents[write & (Capacity - 1)] = e;
+		mWrite.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	template<typename Func>
+	void Drain(Func&& func)
+	{
+		const uint64_t read = mRead.load(std::memory_order_relaxed);
+		const uint64_t write = mWrite.load(std::memory_order_acquire);
+		for (uint64_t i = read; i < write; ++i)
+			func(mEvents[i & (Capacity - 1)]);
+		mRead.store(write, std::memory_order_release);
+	}
+
+private:
+	std::unique_ptr<ProfileEvent[]> mEvents;
+	//生产者和消费者各写一个，分开放避免伪共享
+	alignas(64) std::atomic<uint64_t> mWrite{ 0 };
+	// 生产者看到的mRead，只由生产者读写
+	uint64_t mReadCache = 0;
+	alignas(64) std::atomic<uint64_t> mRead{ 0 };
+};
+
+/*
+层级CPU profiler：SOCO_PROFILE_SCOPE在作用域结束时把zone写进当前线程自己的环形缓冲，不加锁
+zone只记录Ticks，每帧调用一次EndFrame，收集所有线程本帧结束的zone，换算成纳秒后按名字汇总，并保留最近若干帧用于导出Chrome trace
+*/
+class Profiler
+{
+public:
+	struct ThreadBuffer
+	{
+		uint32_t ThreadId = 0;
+		// 当前打开的zone数，只由所属线程读写
+		uint32_t ZoneDepth = 0;
+		ProfileRingBuffer Ring;
+	};
+
+	static Profiler* GetInstance()
+	{
+		static Profiler* instance = new Profiler();
+		return instance;
+	}
+
+	static uint64_t Now()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// zone用的时间戳，单位不固定，EndFrame时按和Now的对应关系换算成纳秒
+	// x86上是rdtsc(invariant TSC，各核同步，QueryPerformanceCounter也基于它)，省掉每次读时钟的换算；其他平台用steady_clock的原始计数
+	static uint64_t Ticks()
+	{
+#if SOCO_PROFILE_RDTSC
+		return __rdtsc();
+#else
+		return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+
+	void SetEnabled(bool enabled) { mEnabled.store(enabled, std::memory_order_relaxed); }
+	bool IsEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+
+	// zone开始，返回当前线程的缓冲，depth是zone的嵌套深度
+	ThreadBuffer* BeginZone(uint32_t& depth)
+	{
+		ThreadBuffer* buffer = tThreadBuffer != nullptr ? tThreadBuffer : RegisterThread();
+		depth = buffer->ZoneDepth++;
+		return buffer;
+	}
+
+	// zone结束，写入BeginZone返回的缓冲，begin是BeginZone之后的Ticks
+	void EndZone(ThreadBuffer* buffer, const char* name, uint64_t begin, uint32_t depth)
+	{
+		ProfileEvent e;
+		e.Name = name;
+		e.Begin = begin;
+		e.End = Ticks();
+		e.Depth = depth;
+		e.ThreadId = buffer->ThreadId;
+
+		--buffer->ZoneDepth;
+		if (!buffer->Ring.Push(e))
+			mDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void EndFrame();
+	// 正在记录的帧的编号
+	uint64_t GetFrameIndex() const { return mFrameIndex; }
+
+	// 把GPU zone补到frameIndex帧上，这一帧已经不在历史中时丢弃
+	void AddGpuEvents(uint64_t frameIndex, std::vector<ProfileEvent> events);
+	// 返回和name内容相同、一直有效的字符串指针，用于不是字符串常量的zone名字
+	const char* InternName(const std::string& name);
+
+	// 最近一帧，还没有完整的帧时为nullptr
+	const ProfileFrame* GetLastFrame() const { return mHistory.empty() ? nullptr : &mHistory.back(); }
+	const std::deque<ProfileFrame>& GetHistory() const { return mHistory; }
+	void SetHistorySize(size_t frameCount) { mHistorySize = frameCount; }
+
+	// 导出最近frameCount帧，可以用chrome://tracing或Perfetto打开
+	bool ExportChromeTrace(const std::string& path, size_t frameCount = SIZE_MAX) const;
+
+private:
+	Profiler();
+	// 每个线程第一次记录时注册一次，之后只读tThreadBuffer
+	ThreadBuffer* RegisterThread();
+	static std::vector<ProfileZoneStats> AggregateZones(const std::vector<ProfileEvent>& events);
+
+	std::atomic<bool> mEnabled{ true };
+	std::mutex mThreadsMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> mThreads;
+	std::atomic<uint64_t> mDroppedEvents{ 0 };
+	static inline thread_local ThreadBuffer* tThreadBuffer = nullptr;
+
+	// 构造时同时读的Ticks和Now，EndFrame时和当时的一对连成直线换算
+	uint64_t mOriginTicks = 0;
+	uint64_t mOriginTime = 0;
+
+	std::unordered_set<std::string> mInternedNames;
+
+	std::deque<ProfileFrame> mHistory;
+	size_t mHistorySize = 120;
+	uint64_t mFrameIndex = 0;
+	uint64_t mFrameBeginTicks = 0;
+};
+
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name)
+	{
+		Profiler* profiler = Profiler::GetInstance();
+		if (profiler->IsEnabled())
+		{
+			mProfiler = profiler;
+			mName = name;
+			mBuffer = profiler->BeginZone(mDepth);
+			mBegin = Profiler::Ticks();
+		}
+	}
+
+	~ProfileScope()
+	{
+		if (mProfiler != nullptr)
+			mProfiler->EndZone(mBuffer, mName, mBegin, mDepth);
+	}
+
+	ProfileScope(const ProfileScope& other) = delete;
+	ProfileScope& operator= (const ProfileScope& other) = delete;
+
+private:
+	Profiler* mProfiler = nullptr;
+	Profiler::ThreadBuffer* mBuffer = nullptr;
+	const char* mName = nullptr;
+	uint64_t mBegin = 0;
+	uint32_t mDepth = 0;
+};
+
+}
+
+#define SOCO_PROFILE_CONCAT_INNER(a, b) a##b
+#define SOCO_PROFILE_CONCAT(a, b) SOCO_PROFILE_CONCAT_INNER(a, b)
+
+#if SOCO_PROFILE_ENABLED
+#define SOCO_PROFILE_SCOPE(name) ::Soco::ProfileScope SOCO_PROFILE_CONCAT(socoProfileScope, __LINE__)(name)
+#else
+#define SOCO_PROFILE_SCOPE(name)
+#endif
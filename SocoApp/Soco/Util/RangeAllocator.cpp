@@ -0,0 +1,240 @@
+#include "RangeAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+#include "TransientHeapPacker.h"
+
+namespace Soco
+{
+
+void RangeAllocator::Reset(uint64_t capacity)
+{
+	mCapacity = capacity;
+	mUsedSize = 0;
+	mAllocations.clear();
+	mFreeHandles.clear();
+	mFreeByOffset.clear();
+	mFreeBySize.clear();
+	if (capacity > 0)
+		InsertFree(0, capacity);
+}
+
+void RangeAllocator::InsertFree(uint64_t offset, uint64_t size)
+{
+	mFreeByOffset.emplace(offset, size);
+	mFreeBySize.emplace(size, offset);
+}
+
+void RangeAllocator::EraseFree(std::map<uint64_t, uint64_t>::iterator it)
+{
+	mFreeBySize.erase({ it->second, it->first });
+	mFreeByOffset.erase(it);
+}
+
+void RangeAllocator::AddFreeRange(uint64_t offset, uint64_t size)
+{
+	if (size == 0)
+		return;
+
+	auto next = mFreeByOffset.lower_bound(offset);
+	if (next != mFreeByOffset.end() && offset + size == next->first)
+	{
+		size += next->second;
+		EraseFree(next);
+	}
+
+	auto prev = mFreeByOffset.lower_bound(offset);
+	if (prev != mFreeByOffset.begin())
+	{
+		--prev;
+		if (prev->first + prev->second == offset)
+		{
+			offset = prev->first;
+			size += prev->second;
+			EraseFree(prev);
+		}
+	}
+
+	InsertFree(offset, size);
+}
+
+RangeAllocator::Handle RangeAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0)
+		return InvalidHandle;
+	alignment = std::max<uint64_t>(alignment, 1);
+
+	//对齐空隙小于alignment，大小不小于size + alignment - 1的空闲区间一定放得下，通常往后看一两个就能找到
+	auto candidate = mFreeBySize.lower_bound({ size, 0 });
+	for (; candidate != mFreeBySize.end(); ++candidate)
+	{
+		const uint64_t alignedOffset = AlignUp(candidate->second, alignment);
+		if (alignedOffset + size <= candidate->second + candidate->first)
+			break;
+	}
+	if (candidate == mFreeBySize.end())
+		return InvalidHandle;
+
+	const uint64_t freeOffset = candidate->second;
+	const uint64_t freeSize = candidate->first;
+	const uint64_t offset = AlignUp(freeOffset, alignment);
+	EraseFree(mFreeByOffset.find(freeOffset));
+
+	//前面的对齐空隙和后面剩下的部分还回去，两侧都不会和已有空闲区间相邻
+	if (offset > freeOffset)
+		InsertFree(freeOffset, offset - freeOffset);
+	if (offset + size < freeOffset + freeSize)
+		InsertFree(offset + size, freeOffset + freeSize - offset - size);
+
+	Handle handle;
+	if (!mFreeHandles.empty())
+	{
+		handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+	}
+	else
+	{
+		handle = (Handle)mAllocations.size();
+		mAllocations.emplace_back();
+	}
+
+	Allocation& allocation = mAllocations[handle];
+	allocation.Offset = offset;
+	allocation.Size = size;
+	allocation.Alignment = alignment;
+	allocation.Live = true;
+	mUsedSize += size;
+	return handle;
+}
+
+void RangeAllocator::Free(Handle handle)
+{
+	assert(IsAllocated(handle));
+	Allocation& allocation = mAllocations[handle];
+	allocation.Live = false;
+	mUsedSize -= allocation.Size;
+	mFreeHandles.push_back(handle);
+	AddFreeRange(allocation.Offset, allocation.Size);
+}
+
+void RangeAllocator::Grow(uint64_t newCapacity)
+{
+	if (newCapacity <= mCapacity)
+		return;
+	const uint64_t oldCapacity = mCapacity;
+	mCapacity = newCapacity;
+	AddFreeRange(oldCapacity, newCapacity - oldCapacity);
+}
+
+std::vector<RangeAllocator::Move> RangeAllocator::Compact()
+{
+	std::vector<Handle> live;
+	live.reserve(GetAllocationCount());
+	for (Handle i = 0; i < mAllocations.size(); ++i)
+	{
+		if (mAllocations[i].Live)
+			live.push_back(i);
+	}
+	std::sort(live.begin(), live.end(), [this](Handle a, Handle b) { return mAllocations[a].Offset < mAllocations[b].Offset; });
+
+	std::vector<Move> moves;
+	mFreeByOffset.clear();
+	mFreeBySize.clear();
+
+	//前面的分配都已经挤紧，游标不超过当前分配的原偏移，对齐后也不会超过，所以只会往前挪
+	uint64_t cursor = 0;
+	for (Handle handle : live)
+	{
+		Allocation& allocation = mAllocations[handle];
+		const uint64_t offset = AlignUp(cursor, allocation.Alignment);
+		assert(offset <= allocation.Offset);
+		if (offset > cursor)
+			InsertFree(cursor, offset - cursor);
+		if (offset != allocation.Offset)
+		{
+			moves.push_back({ handle, allocation.Offset, offset, allocation.Size });
+			allocation.Offset = offset;
+		}
+		cursor = offset + allocation.Size;
+	}
+	if (cursor < mCapacity)
+		InsertFree(cursor, mCapacity - cursor);
+
+	return moves;
+}
+
+float RangeAllocator::GetFragmentation() const
+{
+	const uint64_t freeSize = GetFreeSize();
+	if (freeSize == 0)
+		return 0.0f;
+	return 1.0f - (float)((double)GetLargestFreeRange() / (double)freeSize);
+}
+
+bool RangeAllocator::Validate() const
+{
+	if (mFreeByOffset.size() != mFreeBySize.size())
+	{
+		std::cout << "RangeAllocator：两张空闲表大小不一致" << std::endl;
+		return false;
+	}
+
+	std::vector<std::pair<uint64_t, uint64_t>> ranges;
+	uint64_t used = 0;
+	for (const Allocation& allocation : mAllocations)
+	{
+		if (!allocation.Live)
+			continue;
+		if (allocation.Offset % allocation.Alignment != 0)
+		{
+			std::cout << "RangeAllocator：分配" << allocation.Offset << "没有按" << allocation.Alignment << "对齐" << std::endl;
+			return false;
+		}
+		ranges.push_back({ allocation.Offset, allocation.Size });
+		used += allocation.Size;
+	}
+	if (used != mUsedSize)
+	{
+		std::cout << "RangeAllocator：已用大小" << mUsedSize << "与分配之和" << used << "不一致" << std::endl;
+		return false;
+	}
+
+	uint64_t previousFreeEnd = ~0ull;
+	for (const auto& range : mFreeByOffset)
+	{
+		if (range.second == 0 || mFreeBySize.count({ range.second, range.first }) == 0)
+		{
+			std::cout << "RangeAllocator：空闲区间" << range.first << "无效" << std::endl;
+			return false;
+		}
+		if (range.first == previousFreeEnd)
+		{
+			std::cout << "RangeAllocator：空闲区间" << range.first << "没有与前一段合并" << std::endl;
+			return false;
+		}
+		previousFreeEnd = range.first + range.second;
+		ranges.push_back(range);
+	}
+
+	std::sort(ranges.begin(), ranges.end());
+	uint64_t cursor = 0;
+	for (const auto& range : ranges)
+	{
+		if (range.first != cursor)
+		{
+			std::cout << "RangeAllocator：偏移" << cursor << "处有" << (range.first > cursor ? "遗漏" : "重叠") << std::endl;
+			return false;
+		}
+		cursor = range.first + range.second;
+	}
+	if (cursor != mCapacity)
+	{
+		std::cout << "RangeAllocator：区间覆盖到" << cursor << "，容量是" << mCapacity << std::endl;
+		return false;
+	}
+	return true;
+}
+
+}
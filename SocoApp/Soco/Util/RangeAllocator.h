@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace Soco
+{
+
+/*
+在[0, capacity)上分配区间，只管偏移不管内存，GPU缓冲的子分配和整理都建立在它上面
+空闲区间按偏移和按大小各存一份：分配取放得下的最小空闲区间(best fit)，释放时和前后相邻的空闲区间合并
+对齐可以不是2的幂(比如20字节的顶点)，对齐产生的前部空隙还回空闲表
+*/
+class RangeAllocator
+{
+public:
+	using Handle = uint32_t;
+	static constexpr Handle InvalidHandle = ~0u;
+
+	// 整理时一段分配从OldOffset挪到NewOffset，NewOffset总是小于OldOffset
+	struct Move
+	{
+		Handle Allocation;
+		uint64_t OldOffset;
+		uint64_t NewOffset;
+		uint64_t Size;
+	};
+
+	explicit RangeAllocator(uint64_t capacity = 0) { Reset(capacity); }
+
+	// 丢弃所有分配
+	void Reset(uint64_t capacity);
+
+	// 放不下时返回InvalidHandle，size为0时也返回InvalidHandle
+	Handle Allocate(uint64_t size, uint64_t alignment = 1);
+	void Free(Handle allocation);
+
+	// 容量只能变大，新增部分接在末尾的空闲区间上，已有分配的偏移不变
+	void Grow(uint64_t newCapacity);
+
+	/*
+	把所有分配按偏移顺序向前挤紧，保持各自的对齐，返回需要搬动的分配(按NewOffset升序)
+	目标区间只会覆盖空闲区间、已经搬走的旧数据或者自己的原区间，在同一块内存里整理时按顺序用memmove语义拷贝即可
+	*/
+	std::vector<Move> Compact();
+
+	uint64_t GetOffset(Handle allocation) const { return mAllocations[allocation].Offset; }
+	uint64_t GetSize(Handle allocation) const { return mAllocations[allocation].Size; }
+	bool IsAllocated(Handle allocation) const { return allocation < mAllocations.size() && mAllocations[allocation].Live; }
+
+	uint64_t GetCapacity() const { return mCapacity; }
+	uint64_t GetUsedSize() const { return mUsedSize; }
+	uint64_t GetFreeSize() const { return mCapacity - mUsedSize; }
+	uint64_t GetLargestFreeRange() const { return mFreeBySize.empty() ? 0 : mFreeBySize.rbegin()->first; }
+	size_t GetFreeRangeCount() const { return mFreeByOffset.size(); }
+	size_t GetAllocationCount() const { return mAllocations.size() - mFreeHandles.size(); }
+
+	// 0表示空闲空间是连续的一整段，越接近1空闲空间越零碎：1 - 最大空闲区间 / 空闲总量
+	float GetFragmentation() const;
+
+	// 检查空闲表与分配表互不重叠、恰好覆盖整个容量、相邻空闲区间已合并，测试用
+	bool Validate() const;
+
+private:
+	struct Allocation
+	{
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+		uint64_t Alignment = 1;
+		bool Live = false;
+	};
+
+	void InsertFree(uint64_t offset, uint64_t size);
+	void EraseFree(std::map<uint64_t, uint64_t>::iterator it);
+	// 在[offset, offset + size)上插入空闲区间并与前后合并
+	void AddFreeRange(uint64_t offset, uint64_t size);
+
+	uint64_t mCapacity = 0;
+	uint64_t mUsedSize = 0;
+
+	std::vector<Allocation> mAllocations;
+	std::vector<Handle> mFreeHandles;
+
+	// 偏移 -> 大小
+	std::map<uint64_t, uint64_t> mFreeByOffset;
+	// (大小, 偏移)
+	std::set<std::pair<uint64_t, uint64_t>> mFreeBySize;
+};
+
+}
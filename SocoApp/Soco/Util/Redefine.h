@@ -1,7 +1,7 @@
 #pragma once
 
-//D3D12кܶenumENUM1 = ENUM2ĶΪmagic_enum
-//ｫҪöٽض
+//D3D12中有很多enum，有类似ENUM1 = ENUM2的定义行为，不利于magic_enum反射
+//这里将对需要的枚举进行重定义
 
 #include <string>
 #include "../../Common/magic_enum.hpp"
@@ -0,0 +1,301 @@
+#include "ResidencyPolicy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <queue>
+
+namespace Soco
+{
+
+uint32_t ResidencyPolicy::Register(const uint64_t* mipBytes, uint32_t mipCount, uint32_t maxMostDetailedMip, uint32_t mostDetailedMip, uint64_t frame)
+{
+	assert(mipCount > 0 && maxMostDetailedMip < mipCount && mostDetailedMip <= maxMostDetailedMip);
+
+	uint32_t id;
+	if (!mFreeIds.empty())
+	{
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+	}
+	else
+	{
+		id = (uint32_t)mEntries.size();
+		mEntries.emplace_back();
+	}
+
+	Entry& entry = mEntries[id];
+	entry.MipBytes.assign(mipBytes, mipBytes + mipCount);
+	entry.SuffixBytes.assign(mipCount + 1, 0);
+	for (uint32_t i = mipCount; i-- > 0;)
+		entry.SuffixBytes[i] = entry.SuffixBytes[i + 1] + mipBytes[i];
+	entry.MaxMostDetailedMip = maxMostDetailedMip;
+	entry.MostDetailedMip = mostDetailedMip;
+	entry.WantedMip = 0;
+	entry.LastNeeded = frame;
+	entry.Evicted = false;
+	entry.Busy = false;
+	entry.Live = true;
+	entry.LastUsed.store(frame, std::memory_order_relaxed);
+
+	mResidentBytes += ResidentBytes(entry);
+	return id;
+}
+
+void ResidencyPolicy::Unregister(uint32_t id)
+{
+	Entry& entry = mEntries[id];
+	assert(entry.Live);
+	mResidentBytes -= ResidentBytes(entry);
+	entry.Live = false;
+	entry.MipBytes.clear();
+	entry.SuffixBytes.clear();
+	mFreeIds.push_back(id);
+}
+
+void ResidencyPolicy::SetWantedMip(uint32_t id, uint32_t mip, uint64_t frame)
+{
+	Entry& entry = mEntries[id];
+	entry.WantedMip = std::min(mip, entry.MaxMostDetailedMip);
+	if (entry.WantedMip <= entry.MostDetailedMip)
+		entry.LastNeeded = frame;
+}
+
+std::vector<ResidencyChange> ResidencyPolicy::Update(uint64_t frame)
+{
+	const uint64_t budget = mConfig.BudgetBytes;
+	auto recentlyUsed = [this, frame](const Entry& entry) {
+		return entry.LastUsed.load(std::memory_order_relaxed) + mConfig.ProtectFrames > frame;
+	};
+	auto stale = [this, frame](const Entry& entry) {
+		return entry.LastUsed.load(std::memory_order_relaxed) + mConfig.EvictAfterFrames <= frame;
+	};
+
+	//一张纹理在一次Update里可能被处理多次，第一次碰到时记下原来的状态，最后合并成一个变化
+	std::vector<ResidencyChange> changes;
+	std::vector<int32_t> changeIndex(mEntries.size(), -1);
+	auto touch = [&](uint32_t id) {
+		if (changeIndex[id] < 0)
+		{
+			const Entry& entry = mEntries[id];
+			changeIndex[id] = (int32_t)changes.size();
+			changes.push_back({ id, entry.MostDetailedMip, entry.MostDetailedMip, entry.Evicted, entry.Evicted });
+		}
+	};
+
+	//比需要的更精细、并且很久没用上的mip直接丢掉，不管预算
+	for (uint32_t id = 0; id < mEntries.size(); ++id)
+	{
+		Entry& entry = mEntries[id];
+		if (!entry.Live || entry.Busy || entry.Evicted || entry.MostDetailedMip >= entry.WantedMip
+			|| entry.LastNeeded + mConfig.TrimAfterFrames > frame)
+			continue;
+		touch(id);
+		mResidentBytes -= entry.SuffixBytes[entry.MostDetailedMip] - entry.SuffixBytes[entry.WantedMip];
+		entry.MostDetailedMip = entry.WantedMip;
+	}
+
+	//最近没用过的纹理，最久未使用的在前；同样久的先降占用大的，释放得快
+	std::vector<uint32_t> idle;
+	std::vector<uint32_t> inUse;
+	for (uint32_t id = 0; id < mEntries.size(); ++id)
+	{
+		const Entry& entry = mEntries[id];
+		if (!entry.Live || entry.Busy)
+			continue;
+		if (recentlyUsed(entry))
+			inUse.push_back(id);
+		else if (entry.MostDetailedMip < entry.MaxMostDetailedMip || (!entry.Evicted && stale(entry)))
+			idle.push_back(id);
+	}
+	std::sort(idle.begin(), idle.end(), [this](uint32_t a, uint32_t b) {
+		const uint64_t lastA = GetLastUsed(a), lastB = GetLastUsed(b);
+		if (lastA != lastB)
+			return lastA < lastB;
+		const uint64_t bytesA = ResidentBytes(mEntries[a]), bytesB = ResidentBytes(mEntries[b]);
+		if (bytesA != bytesB)
+			return bytesA > bytesB;
+		return a < b;
+	});
+
+	//从最久未使用的纹理开始降级，一张降到最低一级(闲置太久的再换出)后才处理下一张，直到常驻大小不超过target
+	size_t idleCursor = 0;
+	auto reclaimIdle = [&](uint64_t target) {
+		for (; idleCursor < idle.size() && mResidentBytes > target; ++idleCursor)
+		{
+			const uint32_t id = idle[idleCursor];
+			Entry& entry = mEntries[id];
+			touch(id);
+			while (mResidentBytes > target && entry.MostDetailedMip < entry.MaxMostDetailedMip && !entry.Evicted)
+			{
+				mResidentBytes -= entry.MipBytes[entry.MostDetailedMip];
+				++entry.MostDetailedMip;
+			}
+			if (mResidentBytes > target && !entry.Evicted && stale(entry))
+			{
+				mResidentBytes -= entry.SuffixBytes[entry.MostDetailedMip];
+				entry.Evicted = true;
+			}
+			//这张还没降到底就够了，下次从它继续
+			if (mResidentBytes <= target)
+				break;
+		}
+		return mResidentBytes <= target;
+	};
+
+	if (mResidentBytes > budget)
+	{
+		//闲置的纹理都降到底还不够时，正在使用的纹理也要降：每次降当前占用最大的一张的一级，画质损失分摊开
+		//降级是换成更小的资源，在飞的帧还在用旧资源，不会出错；换出才需要保护期
+		if (!reclaimIdle(budget))
+		{
+			std::priority_queue<std::pair<uint64_t, uint32_t>> largest;
+			for (uint32_t id : inUse)
+			{
+				const Entry& entry = mEntries[id];
+				if (!entry.Evicted && entry.MostDetailedMip < entry.MaxMostDetailedMip)
+					largest.push({ ResidentBytes(entry), id });
+			}
+			while (mResidentBytes > budget && !largest.empty())
+			{
+				const uint32_t id = largest.top().second;
+				largest.pop();
+				Entry& entry = mEntries[id];
+				touch(id);
+				mResidentBytes -= entry.MipBytes[entry.MostDetailedMip];
+				++entry.MostDetailedMip;
+				if (entry.MostDetailedMip < entry.MaxMostDetailedMip)
+					largest.push({ ResidentBytes(entry), id });
+			}
+		}
+	}
+	else
+	{
+		//恢复正在使用的纹理，最近使用的优先，需要时从闲置的纹理里腾出空间
+		//升级后要低于预算留出余量，刚因为超预算降下来的纹理不会马上升回去
+		const uint64_t limit = budget == UINT64_MAX ? budget : (uint64_t)((double)budget * (1.0 - mConfig.PromoteHeadroom));
+		std::sort(inUse.begin(), inUse.end(), [this](uint32_t a, uint32_t b) {
+			const uint64_t lastA = GetLastUsed(a), lastB = GetLastUsed(b);
+			return lastA != lastB ? lastA > lastB : a < b;
+		});
+		//新增的mip要上传，每帧总量有上限，超过时剩下的留到后面的帧
+		uint64_t promotedBytes = 0;
+		bool uploadLimited = false;
+		for (size_t i = 0; i < inUse.size() && !uploadLimited; ++i)
+		{
+			const uint32_t id = inUse[i];
+			Entry& entry = mEntries[id];
+			while (!entry.Evicted && entry.MostDetailedMip > entry.WantedMip)
+			{
+				const uint64_t cost = entry.MipBytes[entry.MostDetailedMip - 1];
+				if (promotedBytes > 0 && promotedBytes + cost > mConfig.MaxPromoteBytesPerFrame)
+				{
+					uploadLimited = true;
+					break;
+				}
+				if (cost > limit || !reclaimIdle(limit - cost))
+					break;
+				touch(id);
+				--entry.MostDetailedMip;
+				entry.LastNeeded = frame;
+				mResidentBytes += cost;
+				promotedBytes += cost;
+			}
+		}
+	}
+	mOverBudget = mResidentBytes > budget;
+
+	size_t count = 0;
+	for (ResidencyChange& change : changes)
+	{
+		const Entry& entry = mEntries[change.Texture];
+		change.NewMostDetailedMip = entry.MostDetailedMip;
+		change.NewEvicted = entry.Evicted;
+		if (change.NewMostDetailedMip > change.OldMostDetailedMip)
+			++mDemotions;
+		else if (change.NewMostDetailedMip < change.OldMostDetailedMip)
+			++mPromotions;
+		if (change.NewEvicted && !change.OldEvicted)
+			++mEvictions;
+		if (change.NewMostDetailedMip != change.OldMostDetailedMip || change.NewEvicted != change.OldEvicted)
+			changes[count++] = change;
+	}
+	changes.resize(count);
+	return changes;
+}
+
+std::vector<uint32_t> ResidencyPolicy::RestoreUsedEvicted(uint64_t frame)
+{
+	std::vector<uint32_t> restored;
+	for (uint32_t id = 0; id < mEntries.size(); ++id)
+	{
+		Entry& entry = mEntries[id];
+		if (entry.Live && entry.Evicted && entry.LastUsed.load(std::memory_order_relaxed) >= frame)
+		{
+			entry.Evicted = false;
+			mResidentBytes += ResidentBytes(entry);
+			++mRestores;
+			restored.push_back(id);
+		}
+	}
+	return restored;
+}
+
+uint64_t ResidencyPolicy::GetResidentBytes(uint32_t id) const
+{
+	return ResidentBytes(mEntries[id]);
+}
+
+uint64_t ResidencyPolicy::GetTotalResidentBytes() const
+{
+	return mResidentBytes;
+}
+
+ResidencyStats ResidencyPolicy::GetStats() const
+{
+	ResidencyStats stats;
+	stats.ResidentBytes = mResidentBytes;
+	stats.BudgetBytes = mConfig.BudgetBytes;
+	for (const Entry& entry : mEntries)
+	{
+		if (!entry.Live)
+			continue;
+		if (entry.Evicted)
+			++stats.Evicted;
+		else if (entry.MostDetailedMip > 0)
+			++stats.Demoted;
+		else
+			++stats.FullyResident;
+	}
+	stats.Demotions = mDemotions;
+	stats.Promotions = mPromotions;
+	stats.Evictions = mEvictions;
+	stats.Restores = mRestores;
+	stats.OverBudget = mOverBudget;
+	return stats;
+}
+
+bool ResidencyPolicy::Validate() const
+{
+	uint64_t resident = 0;
+	for (uint32_t id = 0; id < mEntries.size(); ++id)
+	{
+		const Entry& entry = mEntries[id];
+		if (!entry.Live)
+			continue;
+		if (entry.MostDetailedMip > entry.MaxMostDetailedMip || entry.MaxMostDetailedMip >= entry.MipBytes.size())
+		{
+			std::cout << "ResidencyPolicy：纹理" << id << "的mip范围无效" << std::endl;
+			return false;
+		}
+		resident += ResidentBytes(entry);
+	}
+	if (resident != mResidentBytes)
+	{
+		std::cout << "ResidencyPolicy：常驻大小" << mResidentBytes << "与各纹理之和" << resident << "不一致" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+}
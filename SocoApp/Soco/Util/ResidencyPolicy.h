@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace Soco
+{
+
+struct ResidencyPolicyConfig
+{
+	// 所有纹理常驻大小之和的上限
+	uint64_t BudgetBytes = UINT64_MAX;
+	// 最近这么多帧用过的纹理不降级：在飞的帧可能还在读它，而且很快还会用到；至少要等于FrameResource数
+	uint32_t ProtectFrames = 3;
+	// 超过这么多帧没用过的纹理降到最低一级后可以整个换出显存
+	uint32_t EvictAfterFrames = 600;
+	// 升级后要在预算之下留出这个比例的余量，避免在预算边缘反复升降
+	float PromoteHeadroom = 0.1f;
+	// 比需要的更精细的mip连续这么多帧用不上时丢掉，相机来回移动时不会反复加载
+	uint32_t TrimAfterFrames = 120;
+	// 每帧升级新增的mip大小之和的上限(新增的mip要从文件上传)；一帧至少升一级，单个mip超过上限时也能加载
+	uint64_t MaxPromoteBytesPerFrame = UINT64_MAX;
+};
+
+// 一次Update里一张纹理的变化，mip范围是[MostDetailedMip, MipCount)
+struct ResidencyChange
+{
+	uint32_t Texture;
+	uint32_t OldMostDetailedMip;
+	uint32_t NewMostDetailedMip;
+	bool OldEvicted;
+	bool NewEvicted;
+};
+
+struct ResidencyStats
+{
+	uint64_t ResidentBytes = 0;
+	uint64_t BudgetBytes = 0;
+	uint32_t FullyResident = 0;
+	uint32_t Demoted = 0;
+	uint32_t Evicted = 0;
+	// 累计次数，一次Update里同一张纹理降了几级也只算一次
+	uint64_t Demotions = 0;
+	uint64_t Promotions = 0;
+	uint64_t Evictions = 0;
+	uint64_t Restores = 0;
+	// 最近一次Update后仍然超出预算(剩下的纹理都在保护期内或已经降到最低)
+	bool OverBudget = false;
+};
+
+/*
+纹理常驻策略，只做决策不碰GPU，可以用模拟的使用序列单独测试
+每张纹理记录最后一次使用的帧号，mip从最精细的一级开始丢：
+超出预算时按最久未使用的顺序，把一张纹理降到最低一级后再处理下一张，长期不用的再整个换出
+预算有余量时按最近使用的顺序恢复正在使用的纹理的mip，最多恢复到SetWantedMip给出的一级
+*/
+class ResidencyPolicy
+{
+public:
+	static constexpr uint32_t InvalidId = ~0u;
+
+	void SetConfig(const ResidencyPolicyConfig& config) { mConfig = config; }
+	const ResidencyPolicyConfig& GetConfig() const { return mConfig; }
+
+	/*
+	mipBytes[i]是第i级mip(包括所有数组层)的大小，maxMostDetailedMip是允许降到的最粗一级
+	(比如BC格式最精细一级的宽高要是4的倍数)，mostDetailedMip是注册时已经常驻的最精细一级
+	*/
+	uint32_t Register(const uint64_t* mipBytes, uint32_t mipCount, uint32_t maxMostDetailedMip, uint32_t mostDetailedMip, uint64_t frame);
+	void Unregister(uint32_t id);
+
+	// 可以在多个录制线程里调用
+	void MarkUsed(uint32_t id, uint64_t frame) { mEntries[id].LastUsed.store(frame, std::memory_order_relaxed); }
+	uint64_t GetLastUsed(uint32_t id) const { return mEntries[id].LastUsed.load(std::memory_order_relaxed); }
+
+	// 上一次变化还没有生效(比如旧资源还在被GPU使用)的纹理，Update不会再改变它
+	void SetBusy(uint32_t id, bool busy) { mEntries[id].Busy = busy; }
+
+	// 根据屏幕上的纹素密度需要的最精细一级，默认是0；每帧Update之前设置，没有设置的纹理保持上次的值
+	void SetWantedMip(uint32_t id, uint32_t mip, uint64_t frame);
+	uint32_t GetWantedMip(uint32_t id) const { return mEntries[id].WantedMip; }
+
+	// 每帧录制之前调用一次，返回要执行的变化，内部状态已经按变化更新
+	std::vector<ResidencyChange> Update(uint64_t frame);
+
+	// 录制之后、提交之前调用：返回本帧用到的已换出纹理，它们按换出前的mip范围重新计入常驻
+	std::vector<uint32_t> RestoreUsedEvicted(uint64_t frame);
+
+	uint32_t GetMostDetailedMip(uint32_t id) const { return mEntries[id].MostDetailedMip; }
+	bool IsEvicted(uint32_t id) const { return mEntries[id].Evicted; }
+	uint64_t GetResidentBytes(uint32_t id) const;
+	uint64_t GetTotalResidentBytes() const;
+	ResidencyStats GetStats() const;
+
+	// 检查内部一致性：常驻大小之和、mip范围，测试用
+	bool Validate() const;
+
+private:
+	struct Entry
+	{
+		std::vector<uint64_t> MipBytes;
+		// 从第i级开始的所有mip的大小之和，最后多一个0
+		std::vector<uint64_t> SuffixBytes;
+		uint32_t MaxMostDetailedMip = 0;
+		uint32_t MostDetailedMip = 0;
+		uint32_t WantedMip = 0;
+		// 最后一次需要当前最精细一级的帧
+		uint64_t LastNeeded = 0;
+		bool Evicted = false;
+		bool Busy = false;
+		bool Live = false;
+		std::atomic<uint64_t> LastUsed{ 0 };
+	};
+
+	uint64_t ResidentBytes(const Entry& entry) const { return entry.Evicted ? 0 : entry.SuffixBytes[entry.MostDetailedMip]; }
+
+	ResidencyPolicyConfig mConfig;
+	// deque扩容时不移动已有元素，录制线程拿着的下标一直有效
+	std::deque<Entry> mEntries;
+	std::vector<uint32_t> mFreeIds;
+	uint64_t mResidentBytes = 0;
+
+	uint64_t mDemotions = 0;
+	uint64_t mPromotions = 0;
+	uint64_t mEvictions = 0;
+	uint64_t mRestores = 0;
+	bool mOverBudget = false;
+};
+
+}
@@ -5,11 +5,11 @@
 #include <Windows.h>
 #include "../../Common/d3dx12.h"
 
-//ļչDX12һЩṹĹ
+//此文件用来拓展DX12一些结构体的功能
 
 namespace Soco {
 
-//ΪȽôΪstd::mapKeyֵ
+//作为比较器，能让此作为std::map的Key值
 struct BlobPtr_Compare {
 	bool operator()(const Microsoft::WRL::ComPtr<ID3DBlob>& lhs, const Microsoft::WRL::ComPtr<ID3DBlob>& rhs) const
 	{
@@ -29,8 +29,8 @@ struct BlobPtr_Compare {
 using RootSignatureMap = std::map<Microsoft::WRL::ComPtr<ID3DBlob>, Microsoft::WRL::ComPtr<ID3D12RootSignature>, BlobPtr_Compare>;
 
 
-//PSO Desc Ƚ
-//ʱδȽϣStreamOutput\NodeMask\CachedPSO
+//PSO Desc 比较器
+//暂时未比较：StreamOutput\NodeMask\CachedPSO
 
 #define COMPARE_LHS_RHS(LHS, RHS) \
 	if(LHS < RHS) return true; \
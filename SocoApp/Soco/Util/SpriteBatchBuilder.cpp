@@ -0,0 +1,112 @@
+#include "SpriteBatchBuilder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace Soco
+{
+
+namespace
+{
+// 键的低3个字节是提交序号，只排高5个字节
+constexpr int FirstSortedByte = 3;
+constexpr int SortedBytes = 5;
+constexpr uint64_t SequenceMask = (1ull << 24) - 1;
+}
+
+void SpriteBatchBuilder::Add(const SpriteInstance& sprite, uint32_t layer)
+{
+	assert(layer < MaxLayers && sprite.TextureIndex <= MaxTextureIndex);
+	if (mSprites.size() >= MaxSprites)
+		return;
+
+	const uint64_t key = (uint64_t)layer << 48 | (uint64_t)(sprite.TextureIndex & MaxTextureIndex) << 24 | mSprites.size();
+	mKeys.push_back(key);
+	mSprites.push_back(sprite);
+	mKeyAnd &= key;
+	mKeyOr |= key;
+}
+
+void SpriteBatchBuilder::Clear()
+{
+	mSprites.clear();
+	mKeys.clear();
+	mKeyAnd = ~0ull;
+	mKeyOr = 0;
+}
+
+uint32_t SpriteBatchBuilder::Build(SpriteInstance* out)
+{
+	const size_t count = mKeys.size();
+	if (count == 0)
+		return 0;
+
+	//所有键都相同的字节不改变顺序，不用排；通常只有纹理下标的低一两个字节需要排
+	int shifts[SortedBytes];
+	int passes = 0;
+	const uint64_t varying = mKeyAnd ^ mKeyOr;
+	for (int b = 0; b < SortedBytes; ++b)
+	{
+		const int shift = (FirstSortedByte + b) * 8;
+		if ((varying >> shift) & 0xFF)
+			shifts[passes++] = shift;
+	}
+
+	//一趟统计所有要排的字节的直方图
+	uint32_t histograms[SortedBytes][256] = {};
+	if (passes == 1)
+	{
+		for (uint64_t key : mKeys)
+			++histograms[0][(key >> shifts[0]) & 0xFF];
+	}
+	else if (passes > 1)
+	{
+		for (uint64_t key : mKeys)
+		{
+			for (int p = 0; p < passes; ++p)
+				++histograms[p][(key >> shifts[p]) & 0xFF];
+		}
+	}
+
+	mScratch.resize(count);
+	uint64_t* src = mKeys.data();
+	uint64_t* dst = mScratch.data();
+	for (int p = 0; p < passes; ++p)
+	{
+		uint32_t* histogram = histograms[p];
+		const int shift = shifts[p];
+		uint32_t offset = 0;
+		for (int digit = 0; digit < 256; ++digit)
+		{
+			const uint32_t digitCount = histogram[digit];
+			histogram[digit] = offset;
+			offset += digitCount;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint64_t key = src[i];
+			dst[histogram[(key >> shift) & 0xFF]++] = key;
+		}
+		std::swap(src, dst);
+	}
+	//排好的键留在mKeys里，再Add之后重新Build时相同的键仍然按提交顺序
+	if (src != mKeys.data())
+		mKeys.swap(mScratch);
+
+	uint32_t runs = 0;
+	uint64_t lastGroup = ~0ull;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint64_t key = mKeys[i];
+		out[i] = mSprites[key & SequenceMask];
+		if ((key >> 24) != lastGroup)
+		{
+			++runs;
+			lastGroup = key >> 24;
+		}
+	}
+	return runs;
+}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Soco
+{
+
+// 一个精灵在实例缓冲里的布局，和Sprite.hlsl的SpriteInstance一致
+struct SpriteInstance
+{
+	// 大小和左下角的位置，以整个屏幕为1
+	float Size[2];
+	float Offset[2];
+	// 纹理上的区域，xy是起点，zw是大小
+	float UvRect[4];
+	// 在无绑定纹理表里的下标
+	uint32_t TextureIndex;
+};
+
+/*
+收集一帧的精灵，按(层, 纹理下标)稳定排序后写进实例缓冲，不碰GPU，可以单独测试
+层小的先画；同一层里相同纹理的精灵排在一起，保持提交的顺序
+排序键是64位：层16位、纹理下标24位、提交序号24位，基数排序只排层和纹理下标里不是所有键都相同的字节
+*/
+class SpriteBatchBuilder
+{
+public:
+	static constexpr uint32_t MaxLayers = 1u << 16;
+	static constexpr uint32_t MaxTextureIndex = (1u << 24) - 1;
+	static constexpr uint32_t MaxSprites = 1u << 24;
+
+	// layer小于MaxLayers；超过MaxSprites的精灵被丢掉
+	void Add(const SpriteInstance& sprite, uint32_t layer = 0);
+	void Clear();
+	uint32_t GetCount() const { return (uint32_t)mSprites.size(); }
+
+	// 排好序写到out(至少GetCount()个)，返回(层, 纹理)相同的连续段数，也就是纹理切换次数加1
+	uint32_t Build(SpriteInstance* out);
+
+private:
+	std::vector<SpriteInstance> mSprites;
+	std::vector<uint64_t> mKeys;
+	std::vector<uint64_t> mScratch;
+	// 所有键按位与、按位或，两者不同的字节才需要排
+	uint64_t mKeyAnd = ~0ull;
+	uint64_t mKeyOr = 0;
+};
+
+}
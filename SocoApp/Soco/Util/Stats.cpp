@@ -0,0 +1,180 @@
+#include "Stats.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Soco
+{
+
+StatCounter* StatsRegistry::GetCounter(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	StatEntry& entry = mStats[name];
+	assert(entry.Gauge == nullptr && "同名统计已经注册为Gauge");
+	if (entry.Counter == nullptr)
+		entry.Counter = std::make_unique<StatCounter>();
+	return entry.Counter.get();
+}
+
+StatGauge* StatsRegistry::GetGauge(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	StatEntry& entry = mStats[name];
+	assert(entry.Counter == nullptr && "同名统计已经注册为Counter");
+	if (entry.Gauge == nullptr)
+		entry.Gauge = std::make_unique<StatGauge>();
+	return entry.Gauge.get();
+}
+
+void StatsRegistry::EndFrame()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto& [name, entry] : mStats)
+		{
+			int64_t value = entry.Counter != nullptr ? entry.Counter->Exchange() : entry.Gauge->Get();
+
+			if (entry.Samples.size() != mWindowSize)
+			{
+				entry.Samples.assign(mWindowSize, 0);
+				entry.SampleCount = 0;
+				entry.NextSample = 0;
+			}
+			entry.Samples[entry.NextSample] = value;
+			entry.NextSample = (entry.NextSample + 1) % mWindowSize;
+			entry.SampleCount = std::min<size_t>(entry.SampleCount + 1, mWindowSize);
+			entry.Total += value;
+		}
+	}
+
+	++mFrameIndex;
+	if (mDumpInterval != 0 && mFrameIndex % mDumpInterval == 0)
+	{
+		std::ofstream out(mDumpPath, std::ios::out | std::ios::app);
+		if (out)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			WriteRows(out, IsJsonPath(mDumpPath));
+		}
+	}
+}
+
+StatSummary StatsRegistry::GetSummary(const std::string& name) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto ite = mStats.find(name);
+	return ite != mStats.end() ? Summarize(ite->second) : StatSummary();
+}
+
+std::vector<std::string> StatsRegistry::GetNames() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::vector<std::string> names;
+	for (auto& [name, entry] : mStats)
+		names.push_back(name);
+	return names;
+}
+
+void StatsRegistry::SetWindowSize(size_t frameCount)
+{
+	assert(frameCount > 0);
+	std::lock_guard<std::mutex> lock(mMutex);
+	mWindowSize = frameCount;
+}
+
+void StatsRegistry::ResetTotals()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (auto& [name, entry] : mStats)
+		entry.Total = 0;
+}
+
+void StatsRegistry::EnablePeriodicDump(const std::string& path, uint32_t intervalFrames)
+{
+	mDumpPath = path;
+	mDumpInterval = intervalFrames;
+
+	//重新开始一个文件，CSV先写表头
+	std::ofstream out(path, std::ios::out | std::ios::trunc);
+	if (out && !IsJsonPath(path))
+		out << "frame,name,last,min,avg,max,p99\n";
+}
+
+bool StatsRegistry::Dump(const std::string& path) const
+{
+	std::ofstream out(path, std::ios::out | std::ios::trunc);
+	if (!out)
+		return false;
+
+	const bool json = IsJsonPath(path);
+	if (!json)
+		out << "frame,name,last,min,avg,max,p99\n";
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	WriteRows(out, json);
+	return (bool)out;
+}
+
+StatSummary StatsRegistry::Summarize(const StatEntry& entry)
+{
+	StatSummary summary;
+	summary.Samples = entry.SampleCount;
+	summary.Total = entry.Total;
+	if (entry.SampleCount == 0)
+		return summary;
+
+	const size_t window = entry.Samples.size();
+	std::vector<int64_t> samples;
+	samples.reserve(entry.SampleCount);
+	for (size_t i = 0; i < entry.SampleCount; ++i)
+		samples.push_back(entry.Samples[(entry.NextSample + window - entry.SampleCount + i) % window]);
+
+	summary.Last = samples.back();
+	double sum = 0.0;
+	summary.Min = summary.Max = samples[0];
+	for (int64_t sample : samples)
+	{
+		summary.Min = std::min<int64_t>(summary.Min, sample);
+		summary.Max = std::max<int64_t>(summary.Max, sample);
+		sum += (double)sample;
+	}
+	summary.Avg = sum / (double)samples.size();
+
+	//p99：不小于99%样本的最小值
+	size_t rank = (samples.size() * 99 + 99) / 100 - 1;
+	std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+	summary.P99 = samples[rank];
+	return summary;
+}
+
+bool StatsRegistry::IsJsonPath(const std::string& path)
+{
+	return path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+}
+
+void StatsRegistry::WriteRows(std::ostream& out, bool json) const
+{
+	if (json)
+	{
+		out << "{\"frame\":" << mFrameIndex << ",\"stats\":{";
+		bool first = true;
+		for (auto& [name, entry] : mStats)
+		{
+			StatSummary s = Summarize(entry);
+			out << (first ? "" : ",") << "\"" << name << "\":{\"last\":" << s.Last << ",\"min\":" << s.Min
+				<< ",\"avg\":" << s.Avg << ",\"max\":" << s.Max << ",\"p99\":" << s.P99 << "}";
+			first = false;
+		}
+		out << "}}\n";
+	}
+	else
+	{
+		for (auto& [name, entry] : mStats)
+		{
+			StatSummary s = Summarize(entry);
+			out << mFrameIndex << "," << name << "," << s.Last << "," << s.Min << "," << s.Avg << "," << s.Max << "," << s.P99 << "\n";
+		}
+	}
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Soco
+{
+
+// 每帧清零的计数，比如draw call数、上传字节数
+class StatCounter
+{
+public:
+	void Add(int64_t value) { mValue.fetch_add(value, std::memory_order_relaxed); }
+	int64_t Get() const { return mValue.load(std::memory_order_relaxed); }
+
+private:
+	friend class StatsRegistry;
+	int64_t Exchange() { return mValue.exchange(0, std::memory_order_relaxed); }
+
+	std::atomic<int64_t> mValue{ 0 };
+};
+
+// 跨帧保持的值，比如已分配的描述符数量
+class StatGauge
+{
+public:
+	void Set(int64_t value) { mValue.store(value, std::memory_order_relaxed); }
+	void Add(int64_t value) { mValue.fetch_add(value, std::memory_order_relaxed); }
+	int64_t Get() const { return mValue.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<int64_t> mValue{ 0 };
+};
+
+// 最近若干帧的统计
+struct StatSummary
+{
+	int64_t Last = 0;
+	int64_t Min = 0;
+	int64_t Max = 0;
+	double Avg = 0.0;
+	int64_t P99 = 0;
+	size_t Samples = 0;
+	// 上次ResetTotals以来所有帧的和，不受窗口大小限制
+	int64_t Total = 0;
+};
+
+/*
+统计注册表：计数和仪表按名字注册一次，之后只做原子操作
+每帧调用EndFrame采样一次(计数同时清零)，保留最近mWindowSize帧用于min/avg/max/p99
+可以周期性地追加写入CSV或JSON Lines文件，用来对比每次优化前后的数据
+*/
+class StatsRegistry
+{
+public:
+	static StatsRegistry* GetInstance()
+	{
+		static StatsRegistry* instance = new StatsRegistry();
+		return instance;
+	}
+
+	// 返回的指针一直有效，调用者可以缓存
+	StatCounter* GetCounter(const std::string& name);
+	StatGauge* GetGauge(const std::string& name);
+
+	void EndFrame();
+
+	StatSummary GetSummary(const std::string& name) const;
+	std::vector<std::string> GetNames() const;
+	void SetWindowSize(size_t frameCount);
+	// 清零所有统计的Total，比如benchmark预热结束时
+	void ResetTotals();
+
+	// 每intervalFrames帧追加一次所有统计，扩展名为.json时写JSON Lines，否则写CSV
+	void EnablePeriodicDump(const std::string& path, uint32_t intervalFrames);
+	// 把当前统计写成一个完整文件
+	bool Dump(const std::string& path) const;
+
+private:
+	struct StatEntry
+	{
+		std::unique_ptr<StatCounter> Counter;
+		std::unique_ptr<StatGauge> Gauge;
+		// 环形窗口
+		std::vector<int64_t> Samples;
+		size_t SampleCount = 0;
+		size_t NextSample = 0;
+		int64_t Total = 0;
+	};
+
+	StatsRegistry() {}
+	//SocoTests里的检查用独立的注册表，不影响全局统计
+	friend bool RunStatsRegistryHarness(const std::string& path);
+	static StatSummary Summarize(const StatEntry& entry);
+	static bool IsJsonPath(const std::string& path);
+	void WriteRows(std::ostream& out, bool json) const;
+
+	mutable std::mutex mMutex;
+	std::map<std::string, StatEntry> mStats;
+	size_t mWindowSize = 240;
+	uint64_t mFrameIndex = 0;
+
+	std::string mDumpPath;
+	uint32_t mDumpInterval = 0;
+};
+
+}
+
+// name必须在每个调用点保持不变，查找只在第一次执行时做一次
+#define SOCO_STAT_ADD(name, value) \
+	do { static ::Soco::StatCounter* socoStatCounter = ::Soco::StatsRegistry::GetInstance()->GetCounter(name); socoStatCounter->Add(value); } while (0)
+
+#define SOCO_STAT_GAUGE_SET(name, value) \
+	do { static ::Soco::StatGauge* socoStatGauge = ::Soco::StatsRegistry::GetInstance()->GetGauge(name); socoStatGauge->Set(value); } while (0)
@@ -0,0 +1,72 @@
+#include "TransientHeapPacker.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace Soco
+{
+
+TransientPackResult PackTransientLifetimes(const std::vector<TransientAllocationRequest>& requests)
+{
+	TransientPackResult result;
+	result.Offsets.assign(requests.size(), 0);
+
+	std::vector<size_t> order(requests.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+
+	//大的先放，碎片更少；一样大时先开始的先放，结果稳定
+	std::stable_sort(order.begin(), order.end(), [&requests](size_t a, size_t b) {
+		if (requests[a].Size != requests[b].Size)
+			return requests[a].Size > requests[b].Size;
+		return requests[a].FirstUse < requests[b].FirstUse;
+	});
+
+	std::vector<size_t> placed;
+	std::vector<std::pair<uint64_t, uint64_t>> occupied;
+	for (size_t index : order)
+	{
+		const TransientAllocationRequest& request = requests[index];
+		assert(request.FirstUse <= request.LastUse);
+
+		//和当前请求同时存活的已放置请求占用的内存区间
+		occupied.clear();
+		for (size_t other : placed)
+		{
+			const TransientAllocationRequest& o = requests[other];
+			if (o.FirstUse <= request.LastUse && request.FirstUse <= o.LastUse)
+				occupied.push_back({ result.Offsets[other], result.Offsets[other] + o.Size });
+		}
+		std::sort(occupied.begin(), occupied.end());
+
+		uint64_t offset = 0;
+		for (const std::pair<uint64_t, uint64_t>& range : occupied)
+		{
+			if (offset + request.Size <= range.first)
+				break;
+			offset = std::max(offset, AlignUp(range.second, request.Alignment));
+		}
+
+		result.Offsets[index] = offset;
+		result.HeapSize = std::max(result.HeapSize, offset + request.Size);
+		result.TotalSize += request.Size;
+		placed.push_back(index);
+	}
+
+	//同时存活的大小只会在某个请求开始时增加，只需检查这些时刻
+	for (const TransientAllocationRequest& request : requests)
+	{
+		uint64_t live = 0;
+		for (const TransientAllocationRequest& other : requests)
+		{
+			if (other.FirstUse <= request.FirstUse && request.FirstUse <= other.LastUse)
+				live += other.Size;
+		}
+		result.MaxLiveSize = std::max(result.MaxLiveSize, live);
+	}
+
+	return result;
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Soco
+{
+
+// 一段需要在[FirstUse, LastUse]期间(按pass执行顺序，闭区间)独占的堆内存
+struct TransientAllocationRequest
+{
+	uint64_t Size = 0;
+	uint64_t Alignment = 1;
+	uint32_t FirstUse = 0;
+	uint32_t LastUse = 0;
+};
+
+struct TransientPackResult
+{
+	std::vector<uint64_t> Offsets;
+	// 堆需要的大小
+	uint64_t HeapSize = 0;
+	// 不做别名时所有请求的总大小
+	uint64_t TotalSize = 0;
+	// 任一时刻同时存活的请求大小之和的最大值，HeapSize的下界
+	uint64_t MaxLiveSize = 0;
+};
+
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return alignment <= 1 ? value : (value + alignment - 1) / alignment * alignment;
+}
+
+// 生命周期区间装箱：生命周期重叠的请求内存不重叠，不重叠的可以共用同一段内存
+// 按大小从大到小放置，每个请求放在与它同时存活的已放置请求之间第一个放得下的对齐位置
+TransientPackResult PackTransientLifetimes(const std::vector<TransientAllocationRequest>& requests);
+
+}
@@ -0,0 +1,199 @@
+#include "VertexCompression.h"
+
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace Soco
+{
+
+namespace
+{
+
+float SignNotZero(float v)
+{
+	return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+XMFLOAT3 Normalize(const XMFLOAT3& v)
+{
+	float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+	if (length == 0.0f)
+		return v;
+	return { v.x / length, v.y / length, v.z / length };
+}
+
+// 两个方向的夹角，原方向是零向量时不计
+float AngleBetween(const XMFLOAT3& source, const XMFLOAT3& decoded)
+{
+	XMFLOAT3 a = Normalize(source);
+	if (a.x == 0.0f && a.y == 0.0f && a.z == 0.0f)
+		return 0.0f;
+	XMFLOAT3 b = Normalize(decoded);
+
+	//小角度下acos(dot)精度不够，用叉积长度和点积算
+	XMFLOAT3 cross = { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	float sinAngle = std::sqrt(cross.x * cross.x + cross.y * cross.y + cross.z * cross.z);
+	float cosAngle = a.x * b.x + a.y * b.y + a.z * b.z;
+	return std::atan2(sinAngle, cosAngle);
+}
+
+}
+
+uint16_t FloatToUnorm16(float v)
+{
+	return (uint16_t)std::lround(std::clamp(v, 0.0f, 1.0f) * 65535.0f);
+}
+
+float Unorm16ToFloat(uint16_t v)
+{
+	return v / 65535.0f;
+}
+
+int16_t FloatToSnorm16(float v)
+{
+	return (int16_t)std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f);
+}
+
+float Snorm16ToFloat(int16_t v)
+{
+	//-32768和-32767都解码成-1，与DXGI的SNORM规则一致
+	return std::max<float>(v / 32767.0f, -1.0f);
+}
+
+void EncodeOctahedral(const XMFLOAT3& n, int16_t out[2])
+{
+	float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	if (l1 == 0.0f)
+	{
+		out[0] = out[1] = 0;
+		return;
+	}
+
+	float u = n.x / l1;
+	float v = n.y / l1;
+	if (n.z < 0.0f)
+	{
+		float foldedU = (1.0f - std::abs(v)) * SignNotZero(u);
+		float foldedV = (1.0f - std::abs(u)) * SignNotZero(v);
+		u = foldedU;
+		v = foldedV;
+	}
+
+	out[0] = FloatToSnorm16(u);
+	out[1] = FloatToSnorm16(v);
+}
+
+XMFLOAT3 DecodeOctahedral(const int16_t in[2])
+{
+	//与PackedVertex.hlsli的DecodeOctahedral相同
+	XMFLOAT3 n;
+	n.x = Snorm16ToFloat(in[0]);
+	n.y = Snorm16ToFloat(in[1]);
+	n.z = 1.0f - std::abs(n.x) - std::abs(n.y);
+
+	float t = std::max<float>(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return Normalize(n);
+}
+
+PackedVertex PackVertex(const GeometryGenerator::Vertex& vertex)
+{
+	PackedVertex packed;
+	packed.Position[0] = XMConvertFloatToHalf(vertex.Position.x);
+	packed.Position[1] = XMConvertFloatToHalf(vertex.Position.y);
+	packed.Position[2] = XMConvertFloatToHalf(vertex.Position.z);
+	packed.Position[3] = XMConvertFloatToHalf(1.0f);
+	EncodeOctahedral(vertex.Normal, packed.Normal);
+	EncodeOctahedral(vertex.TangentU, packed.Tangent);
+	packed.TexC[0] = FloatToUnorm16(vertex.TexC.x);
+	packed.TexC[1] = FloatToUnorm16(vertex.TexC.y);
+	return packed;
+}
+
+std::vector<PackedVertex> PackVertices(const std::vector<GeometryGenerator::Vertex>& vertices)
+{
+	std::vector<PackedVertex> packed(vertices.size());
+	std::transform(vertices.begin(), vertices.end(), packed.begin(), PackVertex);
+	return packed;
+}
+
+GeometryGenerator::Vertex UnpackVertex(const PackedVertex& packed)
+{
+	GeometryGenerator::Vertex vertex;
+	vertex.Position.x = XMConvertHalfToFloat(packed.Position[0]);
+	vertex.Position.y = XMConvertHalfToFloat(packed.Position[1]);
+	vertex.Position.z = XMConvertHalfToFloat(packed.Position[2]);
+	vertex.Normal = DecodeOctahedral(packed.Normal);
+	vertex.TangentU = DecodeOctahedral(packed.Tangent);
+	vertex.TexC.x = Unorm16ToFloat(packed.TexC[0]);
+	vertex.TexC.y = Unorm16ToFloat(packed.TexC[1]);
+	return vertex;
+}
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> GetPackedVertexInputLayout()
+{
+	return
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_UNORM, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+}
+
+QuantizationError MeasureQuantizationError(const std::vector<GeometryGenerator::Vertex>& source, const std::vector<PackedVertex>& packed)
+{
+	QuantizationError error;
+	if (source.size() != packed.size())
+	{
+		error.Position = error.NormalAngle = error.TangentAngle = error.TexC = INFINITY;
+		return error;
+	}
+
+	float maxCoordinate = 0.0f;
+	for (const GeometryGenerator::Vertex& v : source)
+		maxCoordinate = std::max<float>({ maxCoordinate, std::abs(v.Position.x), std::abs(v.Position.y), std::abs(v.Position.z) });
+
+	float maxPositionError = 0.0f;
+	for (size_t i = 0; i < source.size(); ++i)
+	{
+		const GeometryGenerator::Vertex& s = source[i];
+		GeometryGenerator::Vertex d = UnpackVertex(packed[i]);
+
+		maxPositionError = std::max<float>({ maxPositionError, std::abs(d.Position.x - s.Position.x),
+			std::abs(d.Position.y - s.Position.y), std::abs(d.Position.z - s.Position.z) });
+		error.NormalAngle = std::max<float>(error.NormalAngle, AngleBetween(s.Normal, d.Normal));
+		error.TangentAngle = std::max<float>(error.TangentAngle, AngleBetween(s.TangentU, d.TangentU));
+		error.TexC = std::max<float>({ error.TexC, std::abs(d.TexC.x - s.TexC.x), std::abs(d.TexC.y - s.TexC.y) });
+	}
+
+	error.Position = maxCoordinate > 0.0f ? maxPositionError / maxCoordinate : maxPositionError;
+	return error;
+}
+
+bool CheckQuantizationError(const std::vector<GeometryGenerator::Vertex>& source, const std::vector<PackedVertex>& packed)
+{
+	QuantizationError error = MeasureQuantizationError(source, packed);
+
+	bool passed = true;
+	auto check = [&passed](const char* name, float value, float bound) {
+		if (!(value <= bound))
+		{
+			std::cout << "顶点压缩误差超出上限：" << name << " " << value << " > " << bound << std::endl;
+			passed = false;
+		}
+	};
+	check("Position", error.Position, MaxPositionError);
+	check("Normal", error.NormalAngle, MaxDirectionAngleError);
+	check("Tangent", error.TangentAngle, MaxDirectionAngleError);
+	check("TexC", error.TexC, MaxTexCError);
+	return passed;
+}
+
+}
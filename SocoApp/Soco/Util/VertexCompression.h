@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <d3d12.h>
+
+#include "../../Common/GeometryGenerator.h"
+
+namespace Soco
+{
+
+// 单个分量的量化，超出范围的值先截断
+uint16_t FloatToUnorm16(float v);
+float Unorm16ToFloat(uint16_t v);
+int16_t FloatToSnorm16(float v);
+float Snorm16ToFloat(int16_t v);
+
+// 八面体编码：单位向量投影到|x|+|y|+|z|=1的八面体上，下半球折叠到外侧的四个三角形，展开成[-1,1]^2后存snorm16x2
+// 零向量编码成(0,0)，解码后是(0,0,1)
+void EncodeOctahedral(const DirectX::XMFLOAT3& n, int16_t out[2]);
+DirectX::XMFLOAT3 DecodeOctahedral(const int16_t in[2]);
+
+/*
+压缩顶点，20字节(GeometryGenerator::Vertex是44字节)：
+Position: half4，w固定为1，相对误差不超过2^-11，不需要额外的解码常量
+Normal/Tangent: 八面体编码，snorm16x2
+TexC: unorm16x2，UV必须在[0,1]内，重复平铺的UV不能用这个格式
+解码见Shaders/PackedVertex.hlsli，格式转换由输入装配完成，shader里只需要展开八面体
+*/
+struct PackedVertex
+{
+	uint16_t Position[4];
+	int16_t Normal[2];
+	int16_t Tangent[2];
+	uint16_t TexC[2];
+};
+
+PackedVertex PackVertex(const GeometryGenerator::Vertex& vertex);
+std::vector<PackedVertex> PackVertices(const std::vector<GeometryGenerator::Vertex>& vertices);
+GeometryGenerator::Vertex UnpackVertex(const PackedVertex& packed);
+
+// 与PackedVertex对应的输入布局，shader用PACKED_VERTEX宏切换输入结构
+std::vector<D3D12_INPUT_ELEMENT_DESC> GetPackedVertexInputLayout();
+
+// 逐顶点解码后与原数据比较的最大误差
+struct QuantizationError
+{
+	// 位置最大分量误差除以网格包围盒的最大绝对坐标
+	float Position = 0;
+	// 法线、切线解码后与原方向的夹角，弧度
+	float NormalAngle = 0;
+	float TangentAngle = 0;
+	float TexC = 0;
+};
+
+// 误差上限，CheckQuantizationError用
+constexpr float MaxPositionError = 1.0f / 2048.0f;
+constexpr float MaxDirectionAngleError = 1e-4f;
+constexpr float MaxTexCError = 0.5f / 65535.0f + 1e-7f;
+
+QuantizationError MeasureQuantizationError(const std::vector<GeometryGenerator::Vertex>& source, const std::vector<PackedVertex>& packed);
+// 超出上限时打印是哪一项并返回false
+bool CheckQuantizationError(const std::vector<GeometryGenerator::Vertex>& source, const std::vector<PackedVertex>& packed);
+
+}
@@ -7,6 +7,7 @@
 #include "Common/UploadBuffer.h"
 #include "Common/GeometryGenerator.h"
 #include "Common/Camera.h"
+#include "Common/BCEncoder.h"
 #include "FrameResource.h"
 
 #include "Soco/Shader.h"
@@ -15,15 +16,41 @@
 
 #include "Soco/MeshRenderer.h"
 #include "Soco/SkyboxRenderer.h"
-#include "Soco/TextureRenderer.h"
+#include "Soco/SpriteBatch.h"
 #include "Soco/TerrainRenderer.h"
+#include "Soco/FrameGraph.h"
 
 #include "Soco/Util/PrintHelper.h"
 #include "Soco/Terrain.h"
 
 #include "Soco/Transform.h"
-
+#include "Soco/Scene.h"
+#include "Soco/Util/JobSystem.h"
+#include "Soco/Util/Profiler.h"
+#include "Soco/GpuProfiler.h"
+#include "Soco/GeometryArena.h"
+#include "Soco/TextureResidency.h"
+#include "Soco/Util/Stats.h"
+#include "Soco/Util/Benchmark.h"
+#include "Soco/Util/VertexCompression.h"
+#include "Soco/Util/MeshOptimizer.h"
+#include "Soco/Util/Meshlet.h"
+#include "Soco/Util/MeshAsset.h"
+#include "Soco/Util/MeshSimplifier.h"
+#include "Soco/Util/ResidencyPolicy.h"
+#include "Soco/Util/MipStreaming.h"
+#include "Soco/Util/MipChain.h"
+#include "Soco/Util/PngDecoder.h"
+#include "Soco/Util/TransientHeapPacker.h"
+#include "Soco/Util/BindlessIndexAllocator.h"
+#include "Soco/BindlessTextureTable.h"
+#include "Soco/MipGenerator.h"
+
+#include <array>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <sstream>
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -81,11 +108,6 @@ struct ObjectConstants
 	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
 };
 
-struct SolarObjectConstants
-{
-	DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
-};
-
 
 struct Vertex
 {
@@ -93,6 +115,7 @@ struct Vertex
 	DirectX::XMFLOAT3 Normal;
 	DirectX::XMFLOAT2 TexC;
 };
+static_assert(sizeof(Vertex) == Soco::FloatVertexStride, "Vertex要与MeshVertexFormat::Float一致");
 
 
 enum class RenderLayer : int
@@ -105,6 +128,21 @@ enum class RenderLayer : int
 	Count
 };
 
+const char* RenderLayerNames[(int)RenderLayer::Count] = { "Opaque", "Skybox", "AlphaTested", "Transparent", "UI" };
+
+// 一个录制分块：按层顺序连续的若干段renderer，由一个线程录制进一个command list
+struct DrawChunk
+{
+	struct Segment
+	{
+		const std::vector<Soco::Renderer*>* Objects = nullptr;
+		size_t Begin = 0;
+		size_t End = 0;
+	};
+
+	std::vector<Segment> Segments;
+};
+
 class SocoApp : public D3DApp
 {
 public:
@@ -115,6 +153,13 @@ public:
 
     virtual bool Initialize()override;
 
+	// 星球和地形使用压缩顶点，要在Initialize之前设置
+	void SetPackedVertices(bool packed) { mPackedVertices = packed; }
+	// 用.smesh文件替换生成的星球球体，要在Initialize之前设置
+	void SetSolarMeshPath(const std::string& path) { mSolarMeshPath = path; }
+	// 纹理显存预算，0表示按显卡的显存预算决定，要在Initialize之前设置
+	void SetTextureBudget(UINT64 bytes) { mTextureBudgetBytes = bytes; }
+
 private:
     virtual void OnResize()override;
     virtual void Update(const GameTimer& gt)override;
@@ -126,11 +171,15 @@ private:
 
     void OnKeyboardInput(const GameTimer& gt);
 	void OnMouseInput(const GameTimer& gt);
+	void TogglePostFinalPass();
+	void UpdateFrameGraphChurn();
 
 	//void UpdateCamera(const GameTimer& gt);
 	void UpdateObjectCBs(const GameTimer& gt);
 	void UpdateMaterialCBs(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
+	void UpdateBenchmarkCamera(const GameTimer& gt);
+	void SubmitSprites();
 
 	void LoadTextures();
     void BuildShadersAndInputLayout();
@@ -140,8 +189,13 @@ private:
 	void BuildSolarGeometry();
     void BuildFrameResources();
 	void BuildRenderObjects();
-	void BuildTransforms();
-    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<Soco::Renderer*>& objects);
+	void BuildSolarEntities();
+    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<Soco::Renderer*>& objects,
+		Soco::InputAssemblerState& iaState, size_t begin = 0, size_t end = SIZE_MAX);
+
+	void BuildDrawChunks();
+	void RecordDrawChunk(UINT chunkIndex);
+	void RecordPostProcess(ID3D12GraphicsCommandList* cmdList);
 
 	void GetCommonPSODesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* input);
 
@@ -163,22 +217,73 @@ private:
 	//Textures
 	std::unordered_map<std::string, std::unique_ptr<Soco::Texture2D>> mTextures;
 	std::unique_ptr<Soco::TextureCube> mCubeMap;
-	std::unique_ptr<Soco::RenderTexture> mRenderTexture;
+
+	// 场景先画到SceneColor，后处理读它，最后一个效果直接写back buffer
+	std::unique_ptr<Soco::RenderTexture> mSceneColor;
+
+	// 后处理链，每帧重新声明
+	Soco::FrameGraph mFrameGraph;
+	// 依次执行的compute效果(mShaders的名字)，相邻效果通过transient纹理ping-pong
+	std::vector<std::string> mPostComputeChain;
+	// 链的最后一步，全屏pixel pass写back buffer(mMaterials的名字)
+	std::string mPostFinalPass = "ShadeRed";
+	// H键切换，关闭时EyePosW停在关闭时的位置
+	bool mUpdateEyePos = true;
+
+	// -benchmark churn=1：每帧开始时记录上一帧结束后的描述符用量
+	struct FrameGraphChurnSample
+	{
+		UINT Frame = 0;
+		int Width = 0;
+		int Height = 0;
+		std::string FinalPass;
+		// CbvSrvUav、Rtv、Dsv
+		std::array<int64_t, 3> InUse = {};
+		int64_t Allocated = 0;
+		bool Passed = true;
+	};
+	int mChurnBaseWidth = 0;
+	int mChurnBaseHeight = 0;
+	std::vector<FrameGraphChurnSample> mChurnSamples;
 
 	//Shader & Material
 	std::unordered_map<std::string, std::unique_ptr<Soco::Shader>> mShaders;
 	std::unordered_map<std::string, std::unique_ptr<Soco::Material>> mMaterials;
 
 
-	// renderer洢
-	std::map<std::string, std::unique_ptr<Soco::MeshRenderer>> mMeshRenderers;
+	// 按照renderer的种类存储
+	std::vector<std::unique_ptr<Soco::MeshRenderer>> mMeshRenderers;
 	std::unique_ptr<Soco::SkyboxRenderer> mSkyboxRenderer;
-	std::unique_ptr<Soco::TextureRenderer> mTextureRenderer;
+	std::unique_ptr<Soco::SpriteBatch> mSpriteBatch;
 	std::unique_ptr<Soco::TerrainRenderer> mTerrainRenderer;
 
-	// render queue洢
+	// 按照render queue存储
 	std::vector<Soco::Renderer*> mRenderObjectLayer[(int)RenderLayer::Count];
 
+	// 多线程录制
+	// 每个分块至少这么多renderer才值得多开一个command list
+	static const size_t MinRenderersPerChunk = 128;
+	std::vector<DrawChunk> mDrawChunks;
+
+	// 每个job至少处理这么多个renderer/material，避免调度开销超过工作本身
+	static const size_t UpdateGrainSize = 64;
+	// 场景系统每个实体的工作很少，分段要大得多
+	static const size_t SceneGrainSize = 4096;
+
+	// LOD误差投影到屏幕上不超过这么多像素
+	static constexpr float MaxLodScreenError = 1.0f;
+
+	// 共享几何缓冲的初始大小，放不下时自动翻倍
+	static const UINT64 GeometryArenaVertexBytes = 4 * 1024 * 1024;
+	static const UINT64 GeometryArenaIndexBytes = 1024 * 1024;
+
+	// 2D纹理启动时只加载宽高不超过这个大小的尾部mip，更精细的按屏幕上的需要流式加载
+	static const size_t TextureStreamingTailSize = 128;
+	// 每帧开始流式加载的新增mip大小之和的上限
+	static const UINT64 TextureStreamingBytesPerFrame = 4 * 1024 * 1024;
+	// 无绑定纹理表的大小，也是shader里gBindlessTextures的大小
+	static const UINT BindlessTextureCapacity = 1024;
+
 	Camera mCamera;
 
     PassConstants mMainPassCB;
@@ -193,25 +298,16 @@ private:
 
     //POINT mLastMousePos;
 
-	//solar
-	const float mEarthRotationRadius = 26;
-	Soco::Transform mEarthTransform;
-	float mEarthSunTheta = 0;
-
-	const float mMoonEarthRotationRadius = 2.5f;
-	Soco::Transform mMoonTransform;
-
-	const float mMercurySunRotationRadius = 8.f;
-	Soco::Transform mMercuryTransform;
-	float mMercurySunTheta = 0;
-
-	const float mVenusSunRotationRadius = 16.f;
-	Soco::Transform mVenusTransform;
-	float mVenusSunTheta = 0;
+	//solar，行星、卫星和它们的renderer都是场景实体
+	Soco::EntityWorld mScene;
 
 	//terrain
 	std::unique_ptr<Soco::Terrain> mTerrain;
 
+	bool mPackedVertices = true;
+	std::string mSolarMeshPath;
+	UINT64 mTextureBudgetBytes = 0;
+
 };
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
@@ -226,7 +322,57 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
 
     try
     {
+
+		//-convertmesh in.obj out.smesh：OBJ转换成二进制网格后退出，同时给了-floatvertex时写未压缩顶点
+		if (const char* convert = strstr(cmdLine, "-convertmesh"))
+		{
+			std::istringstream args(convert + strlen("-convertmesh"));
+			std::string objPath, outPath;
+			args >> objPath >> outPath;
+			Soco::MeshVertexFormat format = strstr(cmdLine, "-floatvertex") != nullptr ? Soco::MeshVertexFormat::Float : Soco::MeshVertexFormat::Packed;
+			return Soco::ConvertObjToMeshAsset(objPath, outPath, format) ? 0 : 1;
+		}
+		//-compresstexture in.png out.dds bc1|bc4|bc5|bc7 [srgb]：生成mip链并块压缩成DDS后退出
+		if (const char* compress = strstr(cmdLine, "-compresstexture"))
+		{
+			std::istringstream args(compress + strlen("-compresstexture"));
+			std::string pngPath, ddsPath, formatName, srgb;
+			args >> pngPath >> ddsPath >> formatName >> srgb;
+			const std::pair<const char*, BCFormat> formats[] = {
+				{ "bc1", BCFormat::BC1 }, { "bc4", BCFormat::BC4 }, { "bc5", BCFormat::BC5 }, { "bc7", BCFormat::BC7 } };
+			auto format = std::find_if(std::begin(formats), std::end(formats), [&](const auto& f) { return formatName == f.first; });
+			if (format == std::end(formats))
+			{
+				std::cout << "未知的压缩格式" << formatName << "，可选bc1、bc4、bc5、bc7" << std::endl;
+				return 1;
+			}
+			Soco::MipChainOptions mipOptions;
+			mipOptions.Srgb = srgb == "srgb";
+			return Soco::MipGenerator::CompressTextureToDDS(pngPath.c_str(), std::wstring(ddsPath.begin(), ddsPath.end()), format->second, mipOptions) ? 0 : 1;
+		}
+
         SocoApp theApp(hInstance);
+		//-floatvertex：星球和地形使用未压缩的float顶点，用于对比
+		if (strstr(cmdLine, "-floatvertex") != nullptr)
+			theApp.SetPackedVertices(false);
+		//-solarmesh path.smesh：星球使用网格文件里最大的子网格
+		if (const char* solarMesh = strstr(cmdLine, "-solarmesh"))
+		{
+			std::istringstream args(solarMesh + strlen("-solarmesh"));
+			std::string path;
+			args >> path;
+			theApp.SetSolarMeshPath(path);
+		}
+		//-cpumips：从像素创建的纹理都在CPU上生成mip链，用于和compute shader生成的结果对比
+		if (strstr(cmdLine, "-cpumips") != nullptr)
+			Soco::MipGenerator::GetInstance()->SetUseGpu(false);
+		//-texturebudget=MB：纹理显存预算，默认是显卡本地显存预算的一半
+		if (const char* textureBudget = strstr(cmdLine, "-texturebudget="))
+			theApp.SetTextureBudget((UINT64)strtoull(textureBudget + strlen("-texturebudget="), nullptr, 10) * 1024 * 1024);
+		//-benchmark frames=N planets=M terrain=K report=path ...：确定性回放，结束时写出报告
+		Soco::BenchmarkConfig benchmarkConfig;
+		if (Soco::ParseBenchmarkArgs(cmdLine, benchmarkConfig))
+			theApp.SetBenchmark(benchmarkConfig);
         if(!theApp.Initialize())
             return 0;
 		
@@ -248,6 +394,11 @@ SocoApp::~SocoApp()
 {
     if(md3dDevice != nullptr)
         FlushCommandQueue();
+
+	//网格自己还持有共享缓冲的引用，随成员一起释放
+	Soco::GeometryArena::GetInstance()->Shutdown();
+	Soco::TextureResidencyManager::GetInstance()->Shutdown();
+	Soco::JobSystem::GetInstance()->Shutdown();
 }
 
 
@@ -267,6 +418,19 @@ bool SocoApp::Initialize()
 	mCamera.SetPosition(0.0f, 0.0f, 0.0f);
 	mCamera.LookAt(mCamera.GetPosition3f(), { 0, 0, 1 }, { 0, 1, 0 });
 
+	//每120帧把draw call、状态切换、上传字节等统计追加到FrameStats.csv
+	Soco::StatsRegistry::GetInstance()->EnablePeriodicDump("FrameStats.csv", 120);
+
+	//地形之外的网格都从共享几何缓冲里分配
+	Soco::GeometryArena::GetInstance()->Initialize(md3dDevice.Get(), GeometryArenaVertexBytes, GeometryArenaIndexBytes);
+
+	//从文件加载的纹理按显存预算降级或换出，按屏幕上的需要流式加载mip
+	Soco::TextureResidencyManager::GetInstance()->Initialize(md3dDevice.Get(), mAdapter.Get(), mTextureBudgetBytes, gNumFrameResources);
+	Soco::TextureResidencyManager::GetInstance()->SetStreamingUploadBudget(TextureStreamingBytesPerFrame);
+
+	//材质纹理通过下标访问，要在编译shader之前确定表的大小
+	Soco::BindlessTextureTable::GetInstance()->Initialize(md3dDevice.Get(), BindlessTextureCapacity, gNumFrameResources);
+
 	LoadTextures();
     BuildShadersAndInputLayout();
 	BuildMaterials();
@@ -274,9 +438,10 @@ bool SocoApp::Initialize()
 	BuildBoxGeometry();
 	BuildSolarGeometry();
     BuildRenderObjects();
-	BuildTransforms();
+	BuildSolarEntities();
     BuildFrameResources();
 
+	Soco::GpuProfiler::GetInstance()->Initialize(mCommandQueue.Get(), gNumFrameResources);
 
     // Execute the initialization commands.
     ThrowIfFailed(mCommandList->Close());
@@ -284,7 +449,10 @@ bool SocoApp::Initialize()
     mCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
 
     // Wait until initialization is complete.
+	//加载时共享缓冲扩容换下来的旧缓冲，等初始化的拷贝完成后释放
+	Soco::GeometryArena::GetInstance()->SetRetireFence(mCurrentFence + 1);
     FlushCommandQueue();
+	Soco::GeometryArena::GetInstance()->ReleaseRetired(mFence->GetCompletedValue());
 
     return true;
 }
@@ -298,16 +466,26 @@ void SocoApp::OnResize()
     //XMStoreFloat4x4(&mProj, P);
 	mCamera.SetLens(0.25f*MathHelper::Pi, AspectRatio(), 1.0f, 2000.0f);
 
-	if (mRenderTexture != nullptr)
+	if (mSceneColor == nullptr)
 	{
-		D3D12_RESOURCE_DESC backbufferDesc = mSwapChainBuffer[0]->GetDesc();
-		mRenderTexture->Resize(backbufferDesc.Width, backbufferDesc.Height);
+		Soco::RenderTextureFormat sceneFormat;
+		sceneFormat.ResourceFormat = mBackBufferFormat;
+		sceneFormat.SrvFormat = mBackBufferFormat;
+		sceneFormat.UavFormat = mBackBufferFormat;
+		sceneFormat.RtvFormat = mBackBufferFormat;
+		mSceneColor = std::make_unique<Soco::RenderTexture>(mClientWidth, mClientHeight, sceneFormat);
+	}
+	else
+	{
+		mSceneColor->Resize(mClientWidth, mClientHeight);
 	}
-	
 }
 
 void SocoApp::Update(const GameTimer& gt)
 {
+	SOCO_PROFILE_SCOPE("Update");
+	if (mBenchmark && mBenchmark->GetConfig().FrameGraphChurn)
+		UpdateFrameGraphChurn();
     OnKeyboardInput(gt);
 	OnMouseInput(gt);
 	//UpdateCamera(gt);
@@ -327,49 +505,64 @@ void SocoApp::Update(const GameTimer& gt)
         CloseHandle(eventHandle);
     }
 
-	//Earth
-	Soco::MeshRenderer* earthMeshRenderer = mMeshRenderers["Earth"].get();
-	SolarObjectConstants soc;
-	mEarthSunTheta += gt.DeltaTime() * 0.5f;//ת
-	float x = mEarthRotationRadius * cos(mEarthSunTheta);
-	float z = mEarthRotationRadius * sin(mEarthSunTheta);
+	Soco::GeometryArena::GetInstance()->ReleaseRetired(mFence->GetCompletedValue());
+	Soco::TextureResidencyManager::GetInstance()->ReleaseRetired(mFence->GetCompletedValue());
+	//这个FrameResource的副本GPU已经用完，补上之后录制的draw通过它访问纹理
+	Soco::BindlessTextureTable::GetInstance()->BeginFrame(mCurrFrameResourceIndex);
 
-	mEarthTransform.SetGlobalPosition({ x, 0, z });
-	mEarthTransform.Rotate({ 0, gt.DeltaTime() * 2 , 0 });
-	XMStoreFloat4x4(&soc.World, XMMatrixTranspose(mEarthTransform.GetGlobalMatrixM()));
-	earthMeshRenderer->SetObjectData(&soc);
+	//这个FrameResource的查询GPU已经用完，先读回已完成帧的GPU计时，再开始记录本帧
+	Soco::GpuProfiler::GetInstance()->BeginFrame(mCurrFrameResourceIndex, mCurrFrameResource->TimestampQueryHeap.Get(),
+		mCurrFrameResource->TimestampReadback.Get(), mFence->GetCompletedValue());
 
-	//Moon
-	Soco::MeshRenderer* moonMeshRenderer = mMeshRenderers["Moon"].get();
-	XMStoreFloat4x4(&soc.World, XMMatrixTranspose(mMoonTransform.GetGlobalMatrixM()));
-	moonMeshRenderer->SetObjectData(&soc);
-
-	//Mercury
-	Soco::MeshRenderer* mercuryMeshRenderer = mMeshRenderers["Mercury"].get();
-	mMercurySunTheta += gt.DeltaTime() * 0.3f;
-	x = mMercurySunRotationRadius * cos(mMercurySunTheta);
-	z = mMercurySunRotationRadius * sin(mMercurySunTheta);
-	mMercuryTransform.SetGlobalPosition({ x, 0, z });
-	XMStoreFloat4x4(&soc.World, XMMatrixTranspose(mMercuryTransform.GetGlobalMatrixM()));
-	mercuryMeshRenderer->SetObjectData(&soc);
+	//每帧的CPU工作按依赖关系组成job图，没有依赖的部分在工作线程上并行
+	const float dt = gt.DeltaTime();
 
-	//Venus
-	Soco::MeshRenderer* venusMeshRenderer = mMeshRenderers["Venus"].get();
-	mVenusSunTheta += gt.DeltaTime() * 0.4f;
-	x = mVenusSunRotationRadius * cos(mVenusSunTheta);
-	z = mVenusSunRotationRadius * sin(mVenusSunTheta);
-	mVenusTransform.SetGlobalPosition({ x, 0, z });
-	XMStoreFloat4x4(&soc.World, XMMatrixTranspose(mVenusTransform.GetGlobalMatrixM()));
-	venusMeshRenderer->SetObjectData(&soc);
-
-
-	UpdateObjectCBs(gt);
-	UpdateMaterialCBs(gt);
-	UpdateMainPassCB(gt);
+	if (mBenchmark)
+		UpdateBenchmarkCamera(gt);
+	//精灵要在ObjectCBs里写进实例缓冲，在job图开始之前提交
+	SubmitSprites();
+
+	Soco::JobGraph updateGraph;
+
+	//场景实体：轨道 -> 世界矩阵 -> 直接写本帧的object常量，每一步都是对连续数组的线性遍历
+	auto sceneJob = updateGraph.AddJob("Scene", [this, dt]() {
+		Soco::UpdateOrbits(mScene, dt, SceneGrainSize);
+		Soco::UpdateWorldMatrices(mScene, SceneGrainSize);
+		Soco::UpdateMeshRendererObjects(mScene, mCurrFrameResourceIndex, SceneGrainSize);
+	});
+
+	//场景renderer的常量已经直接写好并清掉了脏标记，其余renderer的上传放在后面，避免旧的CPU副本覆盖
+	auto objectCBJob = updateGraph.AddJob("ObjectCBs", [this, &gt]() { UpdateObjectCBs(gt); });
+	updateGraph.AddDependency(sceneJob, objectCBJob);
+
+	//LOD选择和meshlet剔除要用本帧的世界矩阵，先选LOD，完整网格才剔除
+	auto meshletJob = updateGraph.AddJob("MeshLodCull", [this]() {
+		Soco::SelectMeshLods(mScene, mCamera.GetPosition3f(), mCamera.GetFovY(), (float)mClientHeight, MaxLodScreenError,
+			mCurrFrameResourceIndex, UpdateGrainSize);
+
+		XMFLOAT4X4 viewProj;
+		XMStoreFloat4x4(&viewProj, XMMatrixMultiply(mCamera.GetView(), mCamera.GetProj()));
+		Soco::CullMeshletRenderers(mScene, mCamera.GetPosition3f(), viewProj, mCurrFrameResourceIndex, UpdateGrainSize);
+	});
+	updateGraph.AddDependency(sceneJob, meshletJob);
+
+	//屏幕上的纹素密度决定每张纹理需要的mip，Draw里的TextureResidencyManager::BeginFrame统一处理请求
+	auto textureDensityJob = updateGraph.AddJob("TextureDensity", [this]() {
+		XMFLOAT4X4 viewProj;
+		XMStoreFloat4x4(&viewProj, XMMatrixMultiply(mCamera.GetView(), mCamera.GetProj()));
+		Soco::RequestTextureDensities(mScene, viewProj, mCamera.GetFovY(), (float)mClientHeight, UpdateGrainSize);
+	});
+	updateGraph.AddDependency(sceneJob, textureDensityJob);
+
+	updateGraph.AddJob("MaterialCBs", [this, &gt]() { UpdateMaterialCBs(gt); });
+	updateGraph.AddJob("MainPassCB", [this, &gt]() { UpdateMainPassCB(gt); });
+
+	updateGraph.Execute();
 }
 
 void SocoApp::Draw(const GameTimer& gt)
 {
+	SOCO_PROFILE_SCOPE("Draw");
 
     auto cmdListAlloc = mCurrFrameResource->CmdListAlloc;
 
@@ -382,71 +575,61 @@ void SocoApp::Draw(const GameTimer& gt)
     //ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), mPSOs["opaque"].Get()));
     ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), nullptr));
 
-    mCommandList->RSSetViewports(1, &mScreenViewport);
-    mCommandList->RSSetScissorRects(1, &mScissorRect);
+	//整帧的GPU时间，开始写在第一个command list，结束写在最后一个
+	Soco::GpuProfiler* gpuProfiler = Soco::GpuProfiler::GetInstance();
+	uint32_t gpuFrameZone = gpuProfiler->BeginZone(mCommandList.Get(), "GpuFrame");
 
     // Indicate a state transition on the resource usage.
-	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-		D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+	//back buffer的屏障由后处理的frame graph负责
+	mSceneColor->TransitionTo(mCommandList.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
 
-    // Clear the back buffer and depth buffer.
-    mCommandList->ClearRenderTargetView(CurrentBackBufferRTV(), (float*)&mMainPassCB.FogColor, 0, nullptr);
+    // Clear the scene color and depth buffer.
+	//同时在主线程创建好RTV，录制线程只读
+    mCommandList->ClearRenderTargetView(mSceneColor->RTV(), (float*)&mMainPassCB.FogColor, 0, nullptr);
     mCommandList->ClearDepthStencilView(DepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 
-    // Specify the buffers we are going to render to.
-    mCommandList->OMSetRenderTargets(1, &CurrentBackBufferRTV(), true, &DepthStencilView());
-
-	ID3D12DescriptorHeap* srvDescriptorHeap = mCbvSrvUavHeap->GetDescriptorHeap();
-	ID3D12DescriptorHeap* descriptorHeaps[] = { srvDescriptorHeap };
-	mCommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
-
- //   DrawRenderItems(mCommandList.Get(), mRenderObjectLayer[(int)RenderLayer::Opaque]);
+	//整理会改写网格的缓冲和偏移，要在录制draw之前；拷贝在这个command list里，先于各分块执行
+	Soco::GeometryArena::GetInstance()->MaybeDefragment(mCommandList.Get());
+	//纹理降级、升级同样会替换资源和SRV
+	Soco::TextureResidencyManager::GetInstance()->BeginFrame(mCommandList.Get());
 
-	//DrawRenderItems(mCommandList.Get(), mRenderObjectLayer[(int)RenderLayer::AlphaTested]);
-	//
-	//DrawRenderItems(mCommandList.Get(), mRenderObjectLayer[(int)RenderLayer::Skybox]);
+	ThrowIfFailed(mCommandList->Close());
 
-	//DrawRenderItems(mCommandList.Get(), mRenderObjectLayer[(int)RenderLayer::Transparent]);
+	//各分块由工作线程录制，0号分块和后处理由主线程录制
+	BuildDrawChunks();
+	mCurrFrameResource->EnsureChunkCommandLists(md3dDevice.Get(), (UINT)mDrawChunks.size());
 
-	//DrawRenderItems(mCommandList.Get(), mRenderObjectLayer[(int)RenderLayer::UI]);
-
-	for (std::vector<Soco::Renderer*>& RenderQueue : mRenderObjectLayer)
+	Soco::JobSystem* jobSystem = Soco::JobSystem::GetInstance();
+	Soco::JobCounter recordCounter;
+	for (UINT i = 1; i < mDrawChunks.size(); ++i)
 	{
-		DrawRenderItems(mCommandList.Get(), RenderQueue);
+		jobSystem->Run([this, i]() { RecordDrawChunk(i); }, &recordCounter);
 	}
 
-	//Compute Shader
-	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_GENERIC_READ));
-
-	mRenderTexture->TransitionTo(mCommandList.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	if (!mDrawChunks.empty())
+		RecordDrawChunk(0);
 
-	mShaders["ShadeRed"]->SetComputePipelineState(mCommandList.Get());
-	mShaders["ShadeRed"]->SetComputeRootSignature(mCommandList.Get());
-	mShaders["ShadeRed"]->SetTexture(mCommandList.Get(), "gInput", CurrentBackBufferSRV());
-	mShaders["ShadeRed"]->SetTexture(mCommandList.Get(), "gOutput", mRenderTexture->UAV());
+	ThrowIfFailed(mCurrFrameResource->PostCmdListAlloc->Reset());
+	ThrowIfFailed(mCurrFrameResource->PostCmdList->Reset(mCurrFrameResource->PostCmdListAlloc.Get(), nullptr));
+	RecordPostProcess(mCurrFrameResource->PostCmdList.Get());
 
-	mCommandList->Dispatch(ceil(mClientWidth / 32.0f), ceil(mClientHeight / 32.0f), 1);
+	//resolve前所有分块的zone都要已经结束
+	jobSystem->Wait(recordCounter);
 
-	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-		D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST));
-	mRenderTexture->TransitionTo(mCommandList.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+	gpuProfiler->EndZone(mCurrFrameResource->PostCmdList.Get(), gpuFrameZone);
+	gpuProfiler->ResolveFrame(mCurrFrameResource->PostCmdList.Get());
+	ThrowIfFailed(mCurrFrameResource->PostCmdList->Close());
 
-	mCommandList->CopyResource(CurrentBackBuffer(), mRenderTexture->GetResource());
-	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-		D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_RENDER_TARGET));
-
-
-    // Indicate a state transition on the resource usage.
-	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
-
-    // Done recording commands.
-    ThrowIfFailed(mCommandList->Close());
-
-    // Add the command list to the queue for execution.
-    ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
-    mCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+    // Add the command lists to the queue for execution, in layer order.
+	std::vector<ID3D12CommandList*> cmdsLists;
+	cmdsLists.push_back(mCommandList.Get());
+	for (size_t i = 0; i < mDrawChunks.size(); ++i)
+		cmdsLists.push_back(mCurrFrameResource->ChunkCmdLists[i].Get());
+	cmdsLists.push_back(mCurrFrameResource->PostCmdList.Get());
+	//录制时用到了已换出的纹理，提交前要让它们重新常驻
+	Soco::TextureResidencyManager::GetInstance()->MakeUsedResident();
+    mCommandQueue->ExecuteCommandLists((UINT)cmdsLists.size(), cmdsLists.data());
+	Soco::BindlessTextureTable::GetInstance()->EndFrame();
 
     // Swap the back and front buffers
     ThrowIfFailed(mSwapChain->Present(0, 0));
@@ -454,6 +637,9 @@ void SocoApp::Draw(const GameTimer& gt)
 
     // Advance the fence value to mark commands up to this fence point.
     mCurrFrameResource->Fence = ++mCurrentFence;
+	gpuProfiler->EndFrame(mCurrentFence);
+	Soco::GeometryArena::GetInstance()->SetRetireFence(mCurrentFence);
+	Soco::TextureResidencyManager::GetInstance()->SetRetireFence(mCurrentFence);
 
 
     // Add an instruction to the command queue to set a new fence point. 
@@ -462,6 +648,151 @@ void SocoApp::Draw(const GameTimer& gt)
     mCommandQueue->Signal(mFence.Get(), mCurrentFence);
 }
 
+void SocoApp::BuildDrawChunks()
+{
+	mDrawChunks.clear();
+
+	size_t total = 0;
+	for (const std::vector<Soco::Renderer*>& renderQueue : mRenderObjectLayer)
+		total += renderQueue.size();
+
+	if (total == 0)
+		return;
+
+	//renderer少时只开一个分块，多时按线程数均分，分块可以跨层但保持层的先后顺序
+	size_t chunkCount = (total + MinRenderersPerChunk - 1) / MinRenderersPerChunk;
+	chunkCount = std::clamp<size_t>(chunkCount, 1, Soco::JobSystem::GetInstance()->GetThreadCount());
+	const size_t perChunk = (total + chunkCount - 1) / chunkCount;
+
+	mDrawChunks.resize(chunkCount);
+	size_t chunkIndex = 0;
+	size_t chunkFill = 0;
+	for (const std::vector<Soco::Renderer*>& renderQueue : mRenderObjectLayer)
+	{
+		size_t begin = 0;
+		while (begin < renderQueue.size())
+		{
+			size_t count = std::min<size_t>(perChunk - chunkFill, renderQueue.size() - begin);
+			mDrawChunks[chunkIndex].Segments.push_back({ &renderQueue, begin, begin + count });
+			begin += count;
+			chunkFill += count;
+
+			if (chunkFill == perChunk && chunkIndex + 1 < chunkCount)
+			{
+				++chunkIndex;
+				chunkFill = 0;
+			}
+		}
+	}
+
+	//均分向上取整，末尾可能留下空分块
+	while (!mDrawChunks.empty() && mDrawChunks.back().Segments.empty())
+		mDrawChunks.pop_back();
+}
+
+void SocoApp::RecordDrawChunk(UINT chunkIndex)
+{
+	SOCO_PROFILE_SCOPE("RecordDrawChunk");
+	ID3D12CommandAllocator* alloc = mCurrFrameResource->ChunkCmdListAllocs[chunkIndex].Get();
+	ID3D12GraphicsCommandList* cmdList = mCurrFrameResource->ChunkCmdLists[chunkIndex].Get();
+
+	ThrowIfFailed(alloc->Reset());
+	ThrowIfFailed(cmdList->Reset(alloc, nullptr));
+
+	//command list之间不继承状态，每个分块都要重新设置
+	cmdList->RSSetViewports(1, &mScreenViewport);
+	cmdList->RSSetScissorRects(1, &mScissorRect);
+
+    // Specify the buffers we are going to render to.
+	cmdList->OMSetRenderTargets(1, &mSceneColor->RTV(), true, &DepthStencilView());
+
+	ID3D12DescriptorHeap* descriptorHeaps[] = { mCbvSrvUavHeap->GetDescriptorHeap() };
+	cmdList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+
+	//各层之间也可能共用顶点/索引缓冲，整个分块共用一份绑定状态
+	Soco::InputAssemblerState iaState;
+	for (const DrawChunk::Segment& segment : mDrawChunks[chunkIndex].Segments)
+	{
+		//一层可能分在多个分块里，GPU统计按名字把各段加起来
+		Soco::GpuProfileScope gpuZone(cmdList, RenderLayerNames[segment.Objects - mRenderObjectLayer]);
+		DrawRenderItems(cmdList, *segment.Objects, iaState, segment.Begin, segment.End);
+	}
+
+	ThrowIfFailed(cmdList->Close());
+}
+
+void SocoApp::RecordPostProcess(ID3D12GraphicsCommandList* cmdList)
+{
+	SOCO_PROFILE_SCOPE("RecordPostProcess");
+	ID3D12DescriptorHeap* descriptorHeaps[] = { mCbvSrvUavHeap->GetDescriptorHeap() };
+	cmdList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+
+	//后处理用frame graph声明，屏障由各pass的读写推导，每个pass前合并成一次提交
+	Soco::FrameGraphResource backBuffer = mFrameGraph.ImportResource("BackBuffer", CurrentBackBuffer(),
+		D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_PRESENT);
+	Soco::FrameGraphResource sceneColor = mFrameGraph.ImportTexture("SceneColor", mSceneColor.get());
+
+	//compute效果的输出是transient资源，由frame graph放在共享堆上，生命周期不重叠的输出共用内存，即ping-pong
+	Soco::FrameGraphTextureDesc outputDesc;
+	outputDesc.Width = mClientWidth;
+	outputDesc.Height = mClientHeight;
+	outputDesc.Formats.ResourceFormat = mBackBufferFormat;
+	outputDesc.Formats.SrvFormat = mBackBufferFormat;
+	outputDesc.Formats.UavFormat = mBackBufferFormat;
+
+	Soco::FrameGraphResource current = sceneColor;
+	for (const std::string& effect : mPostComputeChain)
+	{
+		Soco::FrameGraphResource input = current;
+		Soco::FrameGraphResource output = mFrameGraph.CreateTexture(effect + "Output", outputDesc);
+
+		mFrameGraph.AddPass(effect,
+			[&](Soco::FrameGraphPassBuilder& builder) {
+				builder.Read(input, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				builder.Write(output, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			},
+			[this, effect, input, output](ID3D12GraphicsCommandList* cmdList, const Soco::FrameGraphResources& resources) {
+				Soco::Shader* shader = mShaders[effect].get();
+				shader->SetComputePipelineState(cmdList);
+				shader->SetComputeRootSignature(cmdList);
+				shader->SetTexture(cmdList, "gInput", resources.GetTexture(input)->SRV());
+				shader->SetTexture(cmdList, "gOutput", resources.GetTexture(output)->UAV());
+
+				//线程组大小来自shader的numthreads
+				shader->Dispatch(cmdList, mClientWidth, mClientHeight);
+			});
+
+		current = output;
+	}
+
+	//最后一步是全屏pixel pass，直接写back buffer，不需要再拷贝
+	mFrameGraph.AddPass(mPostFinalPass,
+		[&](Soco::FrameGraphPassBuilder& builder) {
+			builder.Read(current, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			builder.Write(backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		},
+		[this, current](ID3D12GraphicsCommandList* cmdList, const Soco::FrameGraphResources& resources) {
+			Soco::Material* material = mMaterials[mPostFinalPass].get();
+			material->SetTexture("gInput", resources.GetTexture(current));
+
+			cmdList->RSSetViewports(1, &mScreenViewport);
+			cmdList->RSSetScissorRects(1, &mScissorRect);
+			cmdList->OMSetRenderTargets(1, &CurrentBackBufferRTV(), true, nullptr);
+
+			material->SetPipelineState(cmdList);
+			material->SetGraphicsRootSignature(cmdList);
+			material->Setup(cmdList, mCurrFrameResourceIndex);
+			material->SetIASetPrimitiveTopology(cmdList);
+			cmdList->IASetVertexBuffers(0, 0, nullptr);
+			cmdList->IASetIndexBuffer(nullptr);
+			SOCO_STAT_ADD("DrawCalls", 1);
+			cmdList->DrawInstanced(3, 1, 0, 0);
+		});
+
+	mFrameGraph.Compile();
+	mFrameGraph.Execute(cmdList);
+}
+
 void SocoApp::OnKeyboardInput(const GameTimer& gt)
 {
 	//auto kb = mKeyboard->GetState();
@@ -485,7 +816,36 @@ void SocoApp::OnKeyboardInput(const GameTimer& gt)
 
 	}
 
-	if (GetKeyDown(Key::C))
+	//UpdateMainPassCB在工作线程上执行，按键在主线程上读好
+	if (GetKey(Key::H))
+		mUpdateEyePos = !mUpdateEyePos;
+
+	//切换ShadeRed的执行方式：融合进最后的全屏pixel pass，或作为compute效果写UAV后再由Blit写back buffer
+	if (GetKeyDown(Key::D2))
+		TogglePostFinalPass();
+
+	//导出最近的CPU profile，用chrome://tracing或Perfetto打开
+	if (GetKeyDown(Key::P))
+	{
+		if (Soco::Profiler::GetInstance()->ExportChromeTrace("ProfileTrace.json"))
+			std::cout << "已导出ProfileTrace.json" << std::endl;
+		else
+			std::cout << "导出ProfileTrace.json失败" << std::endl;
+	}
+
+	//打印最近一段时间的帧统计
+	if (GetKeyDown(Key::O))
+	{
+		auto stats = Soco::StatsRegistry::GetInstance();
+		for (const std::string& name : stats->GetNames())
+		{
+			Soco::StatSummary summary = stats->GetSummary(name);
+			std::cout << name << " last:" << summary.Last << " min:" << summary.Min << " avg:" << summary.Avg
+				<< " max:" << summary.Max << " p99:" << summary.P99 << std::endl;
+		}
+	}
+
+	if (GetKeyDown(Key::C) && rdoc_api != nullptr)
 	{
 		rdoc_api->TriggerCapture();
 		if(!rdoc_api->IsTargetControlConnected())
@@ -507,6 +867,97 @@ void SocoApp::OnKeyboardInput(const GameTimer& gt)
 
 }
  
+void SocoApp::TogglePostFinalPass()
+{
+	if (mPostFinalPass == "ShadeRed")
+	{
+		mPostComputeChain.push_back("ShadeRed");
+		mPostFinalPass = "Blit";
+	}
+	else
+	{
+		mPostComputeChain.erase(std::remove(mPostComputeChain.begin(), mPostComputeChain.end(), "ShadeRed"), mPostComputeChain.end());
+		mPostFinalPass = "ShadeRed";
+	}
+}
+
+void SocoApp::UpdateFrameGraphChurn()
+{
+	//每个状态保持的帧数要超过FrameGraph释放过期纹理和旧堆的延迟(gNumFrameResources帧)
+	const UINT period = 8;
+	//ShadeRed两种执行方式 x 三种大小，一轮6个状态
+	const UINT cycleFrames = period * 6;
+	//前两轮FrameGraph的纹理池和堆还在增长，不检查
+	const UINT warmupFrames = cycleFrames * 2;
+
+	//从benchmark的第0帧(包括预热帧)开始切换，帧号只由benchmark决定
+	const UINT frame = mBenchmark->GetFrameIndex();
+	const UINT lastFrame = mBenchmark->GetConfig().WarmupFrames + mBenchmark->GetConfig().FrameCount - 1;
+	if (frame == 0)
+	{
+		mChurnBaseWidth = mClientWidth;
+		mChurnBaseHeight = mClientHeight;
+		mChurnSamples.clear();
+	}
+	else
+	{
+		auto stats = Soco::StatsRegistry::GetInstance();
+		FrameGraphChurnSample sample;
+		sample.Frame = frame - 1;
+		sample.Width = mClientWidth;
+		sample.Height = mClientHeight;
+		sample.FinalPass = mPostFinalPass;
+		sample.InUse = { stats->GetGauge("DescriptorsInUse.CbvSrvUav")->Get(), stats->GetGauge("DescriptorsInUse.Rtv")->Get(),
+			stats->GetGauge("DescriptorsInUse.Dsv")->Get() };
+		//只统计新占用的堆位置，复用释放的描述符不算
+		sample.Allocated = stats->GetSummary("DescriptorsAllocated").Last;
+		//预热之后不应该再占用新的位置，用量和上一轮同一时刻一样
+		if (sample.Frame >= warmupFrames)
+			sample.Passed = sample.Allocated == 0 && sample.InUse == mChurnSamples[sample.Frame - cycleFrames].InUse;
+		mChurnSamples.push_back(sample);
+	}
+
+	//benchmark的最后一帧：上一帧的用量已经记下，写出逐帧用量，失败的帧数写进报告
+	if (frame == lastFrame)
+	{
+		const std::string path = "FrameGraphChurn.csv";
+		uint64_t failedFrames = 0;
+		std::ofstream file(path);
+		file << "Frame,Width,Height,FinalPass,CbvSrvUavInUse,RtvInUse,DsvInUse,DescriptorsAllocated,Passed\n";
+		for (const FrameGraphChurnSample& sample : mChurnSamples)
+		{
+			file << sample.Frame << "," << sample.Width << "," << sample.Height << "," << sample.FinalPass << ","
+				<< sample.InUse[0] << "," << sample.InUse[1] << "," << sample.InUse[2] << "," << sample.Allocated << ","
+				<< (sample.Passed ? 1 : 0) << "\n";
+			if (!sample.Passed)
+				++failedFrames;
+		}
+		file.close();
+		if (file)
+			std::cout << "已导出" << path << std::endl;
+		else
+			std::cout << "写入" << path << "失败" << std::endl;
+
+		mBenchmark->SetExtraTotal("FrameGraphChurn.FailedFrames", failedFrames);
+		if (lastFrame <= warmupFrames)
+			mBenchmark->AddFailure("FrameGraph描述符检查的帧数(warmup+frames)需要超过" + std::to_string(warmupFrames + 1));
+		else if (failedFrames != 0)
+			mBenchmark->AddFailure("FrameGraph描述符用量随切换次数增长，" + std::to_string(failedFrames) + "帧检查失败");
+		return;
+	}
+
+	if (frame != 0 && frame % period == 0)
+	{
+		const UINT state = frame / period;
+		TogglePostFinalPass();
+		//原大小、3/4、1/2轮流
+		const int scale = 4 - (int)(state % 3);
+		mClientWidth = mChurnBaseWidth * scale / 4;
+		mClientHeight = mChurnBaseHeight * scale / 4;
+		OnResize();
+	}
+}
+
 void SocoApp::OnMouseInput(const GameTimer& gt)
 {
 	POINT moveDelta = GetMouseMove();
@@ -517,27 +968,80 @@ void SocoApp::OnMouseInput(const GameTimer& gt)
 	}
 }
 
+void SocoApp::UpdateBenchmarkCamera(const GameTimer& gt)
+{
+	//相机路径只取决于时间：绕太阳一圈并上下起伏，依次扫过行星、地形和天空盒
+	const float t = gt.TotalTime();
+	XMFLOAT3 eye = { 60.0f * cos(0.2f * t), 25.0f + 15.0f * sin(0.13f * t), 60.0f * sin(0.2f * t) };
+	mCamera.LookAt(eye, { 0, 0, 0 }, { 0, 1, 0 });
+	mCamera.UpdateViewMatrix();
+}
+
 void SocoApp::UpdateObjectCBs(const GameTimer& gt)
 {
+	SOCO_PROFILE_SCOPE("UpdateObjectCBs");
+	//每个renderer只写自己的UploadBuffer，可以直接按区间并行
 	for (std::vector<Soco::Renderer*>& renderLayer : mRenderObjectLayer)
 	{
-		for (Soco::Renderer* renderer : renderLayer)
-		{
-			renderer->Update(mCurrFrameResourceIndex);
-		}
+		Soco::JobSystem::GetInstance()->ParallelFor(0, renderLayer.size(), UpdateGrainSize,
+			[this, &renderLayer](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				renderLayer[i]->Update(mCurrFrameResourceIndex);
+			}
+		});
+	}
+}
+
+void SocoApp::SubmitSprites()
+{
+	SOCO_PROFILE_SCOPE("SubmitSprites");
+	//左下角的高度图预览画在最上层
+	mSpriteBatch->Draw(mTerrain->GetTexture(), { 0.2f, 0.2f }, { 0.0f, 0.0f }, { 0, 0, 1, 1 }, 1);
+
+	const uint32_t spriteCount = mBenchmark ? mBenchmark->GetConfig().SpriteCount : 0;
+	if (spriteCount == 0)
+		return;
+
+	//压力测试：铺满屏幕的网格，纹理轮流使用，位置只由帧号决定
+	static const char* textureNames[] = { "EarthDay", "EarthNight", "EarthCloud", "Sun", "Moon", "Mercury", "Venus", "fenceTex" };
+	Soco::Texture* textures[_countof(textureNames)];
+	for (size_t i = 0; i < _countof(textureNames); ++i)
+		textures[i] = mTextures[textureNames[i]].get();
+
+	const uint32_t columns = (uint32_t)ceilf(sqrtf((float)spriteCount));
+	const float cell = 1.0f / columns;
+	const float phase = mBenchmark->GetFrameIndex() * 0.01f;
+	for (uint32_t i = 0; i < spriteCount; ++i)
+	{
+		const float x = (i % columns) * cell + 0.25f * cell * sinf(phase + i);
+		const float y = (i / columns) * cell;
+		mSpriteBatch->Draw(textures[i % _countof(textures)], { cell, cell }, { x, y });
 	}
 }
 
 void SocoApp::UpdateMaterialCBs(const GameTimer& gt)
 {
+	SOCO_PROFILE_SCOPE("UpdateMaterialCBs");
+	std::vector<Soco::Material*> materials;
+	materials.reserve(mMaterials.size());
 	for (auto& [name, material] : mMaterials)
 	{
-		material->Update(mCurrFrameResourceIndex);
+		materials.push_back(material.get());
 	}
+
+	Soco::JobSystem::GetInstance()->ParallelFor(0, materials.size(), UpdateGrainSize,
+		[this, &materials](size_t first, size_t last) {
+		for (size_t i = first; i < last; ++i)
+		{
+			materials[i]->Update(mCurrFrameResourceIndex);
+		}
+	});
 }
 
 void SocoApp::UpdateMainPassCB(const GameTimer& gt)
 {
+	SOCO_PROFILE_SCOPE("UpdateMainPassCB");
 	//XMMATRIX view = XMLoadFloat4x4(&mView);
 	//XMMATRIX proj = XMLoadFloat4x4(&mProj);
 	XMMATRIX view = mCamera.GetView();
@@ -555,12 +1059,7 @@ void SocoApp::UpdateMainPassCB(const GameTimer& gt)
 	XMStoreFloat4x4(&mMainPassCB.ViewProj, XMMatrixTranspose(viewProj));
 	XMStoreFloat4x4(&mMainPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
 
-	static bool updateEyePos = true;
-
-	if (GetKey(Key::H))
-		updateEyePos = !updateEyePos;
-
-	if(updateEyePos)
+	if(mUpdateEyePos)
 		mMainPassCB.EyePosW = mCamera.GetPosition3f();
 
 	mMainPassCB.RenderTargetSize = XMFLOAT2((float)mClientWidth, (float)mClientHeight);
@@ -587,30 +1086,30 @@ void SocoApp::UpdateMainPassCB(const GameTimer& gt)
 
 void SocoApp::LoadTextures()
 {
-	mTextures["fenceTex"] = std::make_unique<Soco::Texture2D>("fenceTex", L"../Textures/WireFence.dds");
-
-	mTextures["EarthDay"] = std::make_unique<Soco::Texture2D>("EarthDay", L"../Textures/Resources/1/EarthDay.dds");
-	mTextures["EarthNight"] = std::make_unique<Soco::Texture2D>("EarthNight", L"../Textures/Resources/1/EarthNight.dds");
-	mTextures["EarthCloud"] = std::make_unique<Soco::Texture2D>("EarthCloud", L"../Textures/Resources/1/EarthClouds.dds");
-	mTextures["Sun"] = std::make_unique<Soco::Texture2D>("Sun", L"../Textures/Resources/1/NL5.dds");
-	mTextures["Moon"] = std::make_unique<Soco::Texture2D>("Moon", L"../Textures/Resources/1/moon.dds");
-	mTextures["Mercury"] = std::make_unique<Soco::Texture2D>("Mercury", L"../Textures/Resources/1/Mercury.dds");
-	mTextures["Venus"] = std::make_unique<Soco::Texture2D>("Venus", L"../Textures/Resources/1/Venus.dds");
+	SOCO_PROFILE_SCOPE("LoadTextures");
+	//只加载尾部mip，注册后由TextureResidencyManager按屏幕上的纹素密度补上需要的mip
+	mTextures["fenceTex"] = std::make_unique<Soco::Texture2D>("fenceTex", L"../Textures/WireFence.dds", TextureStreamingTailSize);
+
+	mTextures["EarthDay"] = std::make_unique<Soco::Texture2D>("EarthDay", L"../Textures/Resources/1/EarthDay.dds", TextureStreamingTailSize);
+	mTextures["EarthNight"] = std::make_unique<Soco::Texture2D>("EarthNight", L"../Textures/Resources/1/EarthNight.dds", TextureStreamingTailSize);
+	mTextures["EarthCloud"] = std::make_unique<Soco::Texture2D>("EarthCloud", L"../Textures/Resources/1/EarthClouds.dds", TextureStreamingTailSize);
+	mTextures["Sun"] = std::make_unique<Soco::Texture2D>("Sun", L"../Textures/Resources/1/NL5.dds", TextureStreamingTailSize);
+	mTextures["Moon"] = std::make_unique<Soco::Texture2D>("Moon", L"../Textures/Resources/1/moon.dds", TextureStreamingTailSize);
+	mTextures["Mercury"] = std::make_unique<Soco::Texture2D>("Mercury", L"../Textures/Resources/1/Mercury.dds", TextureStreamingTailSize);
+	mTextures["Venus"] = std::make_unique<Soco::Texture2D>("Venus", L"../Textures/Resources/1/Venus.dds", TextureStreamingTailSize);
 
 	mCubeMap = std::make_unique<Soco::TextureCube>("GrassCubeMap", L"../Textures/grasscube1024.dds");
 
-	Soco::RenderTextureFormat rtFormat;
-	rtFormat.ResourceFormat = mBackBufferFormat;
-	rtFormat.SrvFormat = mBackBufferFormat;
-	rtFormat.UavFormat = mBackBufferFormat;
-
-	D3D12_RESOURCE_DESC backbufferDesc = mSwapChainBuffer[0]->GetDesc();
-	mRenderTexture = std::make_unique<Soco::RenderTexture>(backbufferDesc.Width, backbufferDesc.Height, rtFormat);
+	Soco::TextureResidencyManager* residency = Soco::TextureResidencyManager::GetInstance();
+	for (auto& texture : mTextures)
+		residency->Register(texture.second.get());
+	residency->Register(mCubeMap.get());
 }
 
 
 void SocoApp::BuildShadersAndInputLayout()
 {
+	SOCO_PROFILE_SCOPE("BuildShaders");
 
 	const D3D_SHADER_MACRO defines[] =
 	{
@@ -625,6 +1124,16 @@ void SocoApp::BuildShadersAndInputLayout()
 		NULL, NULL
 	};
 
+	//压缩顶点：格式由输入布局指定，shader用PACKED_VERTEX切换输入结构
+	const D3D_SHADER_MACRO packedVertexDefines[] =
+	{
+		"PACKED_VERTEX", "1",
+		NULL, NULL
+	};
+	const D3D_SHADER_MACRO* vertexDefines = mPackedVertices ? packedVertexDefines : nullptr;
+	std::vector<D3D12_INPUT_ELEMENT_DESC> packedInputLayout = Soco::GetPackedVertexInputLayout();
+	std::vector<D3D12_INPUT_ELEMENT_DESC>* solarInputLayout = mPackedVertices ? &packedInputLayout : nullptr;
+
 	Soco::ShaderStage ss;
 	ss.vs = "VS";
 	ss.ps = "PS";
@@ -638,10 +1147,10 @@ void SocoApp::BuildShadersAndInputLayout()
 
 	mShaders["opaque"] = std::make_unique<Soco::Shader>(L"Shaders\\Default.hlsl", defines, ss);
 	mShaders["alphaTested"] = std::make_unique<Soco::Shader>(L"Shaders\\Default.hlsl", alphaTestDefines, ss);
-	mShaders["Earth"] = std::make_unique<Soco::Shader>(L"Shaders\\Earth.hlsl", nullptr, ss);
-	mShaders["Sun"] = std::make_unique<Soco::Shader>(L"Shaders\\Sun.hlsl", nullptr, ss);
-	//ǡˮǡ һshader
-	mShaders["Moon"] = std::make_unique<Soco::Shader>(L"Shaders\\Moon.hlsl", nullptr, ss);
+	mShaders["Earth"] = std::make_unique<Soco::Shader>(L"Shaders\\Earth.hlsl", vertexDefines, ss, solarInputLayout);
+	mShaders["Sun"] = std::make_unique<Soco::Shader>(L"Shaders\\Sun.hlsl", vertexDefines, ss, solarInputLayout);
+	//金星、水星、月亮 共用一个shader
+	mShaders["Moon"] = std::make_unique<Soco::Shader>(L"Shaders\\Moon.hlsl", vertexDefines, ss, solarInputLayout);
 
 	//Skybox
 	mShaders["Skybox"] = std::make_unique<Soco::Shader>(L"Shaders\\Skybox.hlsl", nullptr, ss);
@@ -652,6 +1161,11 @@ void SocoApp::BuildShadersAndInputLayout()
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 	};
+	//压缩地形顶点只有高度，x/z和uv由SV_VertexID算出
+	std::vector<D3D12_INPUT_ELEMENT_DESC> packedTerrainInputLayout =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
 
 	Soco::ShaderStage TessShaderStage;
 	TessShaderStage.vs = "VS";
@@ -660,12 +1174,16 @@ void SocoApp::BuildShadersAndInputLayout()
 	TessShaderStage.ds = "DS";
 
 	//mShaders["Terrain"] = std::make_unique<Soco::Shader>(L"Shaders\\Terrain.hlsl", nullptr, ss, &terrainInputLayout);
-	mShaders["TerrainTess"] = std::make_unique<Soco::Shader>(L"Shaders\\TerrainTess.hlsl", nullptr, TessShaderStage, &terrainInputLayout);
+	mShaders["TerrainTess"] = std::make_unique<Soco::Shader>(L"Shaders\\TerrainTess.hlsl", vertexDefines, TessShaderStage,
+		mPackedVertices ? &packedTerrainInputLayout : &terrainInputLayout);
 
+	//后处理：ShadeRed既可以作为compute效果，也可以作为链尾的全屏pixel pass
 	Soco::ShaderStage ComputeStage;
-	ComputeStage.cs = "ShadeRed";
+	ComputeStage.cs = "ShadeRedCS";
 
 	mShaders["ShadeRed"] = std::make_unique<Soco::Shader>(L"Shaders\\ShadeRed.hlsl", nullptr, ComputeStage);
+	mShaders["ShadeRedPS"] = std::make_unique<Soco::Shader>(L"Shaders\\ShadeRed.hlsl", nullptr, ss);
+	mShaders["Blit"] = std::make_unique<Soco::Shader>(L"Shaders\\Blit.hlsl", nullptr, ss);
 }
 
 void SocoApp::BuildMaterials()
@@ -744,7 +1262,7 @@ void SocoApp::BuildMaterials()
 	//sunMS.rasterizeState.CullMode = D3D12_CULL_MODE_NONE;
 	sunMS.depthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
 
-	mMaterials["Sun"] = std::make_unique<Soco::Material>(mShaders["Sun"].get(), &sunMS);
+	mMaterials["Sun"] = std::make_unique<Soco::Material>(mShaders["Sun"].get(), &sunMS, nullptr, "cbMaterial");
 	mMaterials["Sun"]->SetTexture("SunNoiseMap", mTextures["Sun"].get());
 
 	//Moon
@@ -753,13 +1271,14 @@ void SocoApp::BuildMaterials()
 	moonMS.rasterizeState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
 	moonMS.depthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
 
-	mMaterials["Moon"] = std::make_unique<Soco::Material>(mShaders["Moon"].get());
+	//纹理下标放在材质常量缓冲里，同一个shader的材质共用根签名和PSO
+	mMaterials["Moon"] = std::make_unique<Soco::Material>(mShaders["Moon"].get(), nullptr, nullptr, "cbMaterial");
 	mMaterials["Moon"]->SetTexture("MoonMap", mTextures["Moon"].get());
 
-	mMaterials["Mercury"] = std::make_unique<Soco::Material>(mShaders["Moon"].get());
+	mMaterials["Mercury"] = std::make_unique<Soco::Material>(mShaders["Moon"].get(), nullptr, nullptr, "cbMaterial");
 	mMaterials["Mercury"]->SetTexture("MoonMap", mTextures["Mercury"].get());
 
-	mMaterials["Venus"] = std::make_unique<Soco::Material>(mShaders["Moon"].get());
+	mMaterials["Venus"] = std::make_unique<Soco::Material>(mShaders["Moon"].get(), nullptr, nullptr, "cbMaterial");
 	mMaterials["Venus"]->SetTexture("MoonMap", mTextures["Venus"].get());
 
 	//skybox
@@ -773,6 +1292,18 @@ void SocoApp::BuildMaterials()
 	mMaterials["Skybox"] = std::make_unique<Soco::Material>(mShaders["Skybox"].get(), &skyboxMS, nullptr, "");
 	mMaterials["Skybox"]->SetTexture("gCubeMap", mCubeMap.get());
 
+	//后处理全屏pass，不做深度测试
+	Soco::MaterialState postMS;
+	postMS.blendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+	postMS.rasterizeState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+	postMS.rasterizeState.CullMode = D3D12_CULL_MODE_NONE;
+	postMS.depthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	postMS.depthStencilState.DepthEnable = false;
+	postMS.depthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+
+	mMaterials["ShadeRed"] = std::make_unique<Soco::Material>(mShaders["ShadeRedPS"].get(), &postMS, nullptr, "");
+	mMaterials["Blit"] = std::make_unique<Soco::Material>(mShaders["Blit"].get(), &postMS, nullptr, "");
+
 	//terrain
 	Soco::MaterialState terrainMS;
 	terrainMS.blendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
@@ -788,6 +1319,7 @@ void SocoApp::BuildBoxGeometry()
 {
 	GeometryGenerator geoGen;
 	GeometryGenerator::MeshData box = geoGen.CreateBox(8.0f, 8.0f, 8.0f, 3);
+	Soco::OptimizeMesh(box);
 
 	std::vector<Vertex> vertices(box.Vertices.size());
 	for (size_t i = 0; i < box.Vertices.size(); ++i)
@@ -812,25 +1344,17 @@ void SocoApp::BuildBoxGeometry()
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
 	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-	geo->VertexBufferGPU->SetName(L"Vertex Buffer");
-	geo->VertexBufferUploader->SetName(L"Vertex Buffer Uploader");
-
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
-	geo->IndexBufferGPU->SetName(L"Index Buffer");
-	geo->IndexBufferUploader->SetName(L"Index Buffer Uploader");
-
 	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
 	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
+	Soco::GeometryArena::GetInstance()->Upload(mCommandList.Get(), geo.get(), vertices.data(), vbByteSize, indices.data(), ibByteSize);
 
 	SubmeshGeometry submesh;
 	submesh.IndexCount = (UINT)indices.size();
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
+	BoundingBox::CreateFromPoints(submesh.Bounds, box.Vertices.size(), &box.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+	submesh.UvDensity = Soco::ComputeUvDensity(&box.Vertices[0].Position.x, sizeof(GeometryGenerator::Vertex),
+		&box.Vertices[0].TexC.x, sizeof(GeometryGenerator::Vertex), box.Indices32.data(), box.Indices32.size());
 
 	geo->DrawArgs["box"] = submesh;
 
@@ -839,50 +1363,102 @@ void SocoApp::BuildBoxGeometry()
 
 void SocoApp::BuildSolarGeometry()
 {
+	if (!mSolarMeshPath.empty())
+	{
+		Soco::MeshVertexFormat format = mPackedVertices ? Soco::MeshVertexFormat::Packed : Soco::MeshVertexFormat::Float;
+		std::unique_ptr<MeshGeometry> geo = Soco::LoadMeshGeometry(mSolarMeshPath, "solarGeo", format, mCommandList.Get());
+		if (geo != nullptr)
+		{
+			//星球实体按"sphere"取子网格，文件里有多个子网格时用三角形最多的那个
+			auto largest = std::max_element(geo->DrawArgs.begin(), geo->DrawArgs.end(),
+				[](const auto& a, const auto& b) { return a.second.IndexCount < b.second.IndexCount; });
+			SubmeshGeometry submesh = largest->second;
+			geo->DrawArgs["sphere"] = submesh;
+			mGeometries["solar"] = std::move(geo);
+			return;
+		}
+		std::cout << "星球网格加载失败，使用生成的球体" << std::endl;
+	}
+
 	GeometryGenerator geoGen;
 	GeometryGenerator::MeshData sphere = geoGen.CreateSphere(1, 20, 20);
+	//生成顺序对顶点缓存很不友好，压缩之前先优化
+	Soco::OptimizeMesh(sphere);
 
-	std::vector<Vertex> vertices(sphere.Vertices.size());
-	for (size_t i = 0; i < sphere.Vertices.size(); ++i)
+	std::vector<Soco::PackedVertex> packedVertices;
+	std::vector<Vertex> vertices;
+	if (mPackedVertices)
 	{
-		vertices[i].Pos = sphere.Vertices[i].Position;
-		vertices[i].Normal = sphere.Vertices[i].Normal;
-		vertices[i].TexC = sphere.Vertices[i].TexC;
+		packedVertices = Soco::PackVertices(sphere.Vertices);
+		//量化误差超出VertexCompression.h里的上限说明编码或者网格数据有问题(比如UV超出[0,1])
+		bool withinBounds = Soco::CheckQuantizationError(sphere.Vertices, packedVertices);
+		assert(withinBounds && "星球网格压缩误差超出上限");
+		(void)withinBounds;
+	}
+	else
+	{
+		vertices.resize(sphere.Vertices.size());
+		for (size_t i = 0; i < sphere.Vertices.size(); ++i)
+		{
+			vertices[i].Pos = sphere.Vertices[i].Position;
+			vertices[i].Normal = sphere.Vertices[i].Normal;
+			vertices[i].TexC = sphere.Vertices[i].TexC;
+		}
 	}
 
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
+	const UINT vertexStride = mPackedVertices ? sizeof(Soco::PackedVertex) : sizeof(Vertex);
+	const void* vertexData = mPackedVertices ? (const void*)packedVertices.data() : (const void*)vertices.data();
+	const UINT vbByteSize = (UINT)sphere.Vertices.size() * vertexStride;
 	
+	//LOD链与完整网格共用顶点，索引依次接在后面；误差超过半径一半的LOD在屏幕上已经不成形了
+	const float* positions = &sphere.Vertices[0].Position.x;
+	std::vector<Soco::MeshLodLevel> lods = Soco::BuildLodChain(sphere.Indices32.data(), sphere.Indices32.size(),
+		positions, sphere.Vertices.size(), sizeof(GeometryGenerator::Vertex), 4, 0.5f, 0.5f);
+
 	std::vector<std::uint16_t> indices = sphere.GetIndices16();
+	std::vector<SubmeshLod> submeshLods;
+	for (const Soco::MeshLodLevel& lod : lods)
+	{
+		bool withinBounds = Soco::CheckSimplificationError(sphere.Indices32.data(), sphere.Indices32.size(), lod,
+			positions, sphere.Vertices.size(), sizeof(GeometryGenerator::Vertex));
+		assert(withinBounds && "星球LOD简化误差超出上限");
+		(void)withinBounds;
+
+		SubmeshLod submeshLod;
+		submeshLod.IndexCount = (UINT)lod.Indices.size();
+		submeshLod.StartIndexLocation = (UINT)indices.size();
+		submeshLod.Error = lod.Error;
+		submeshLods.push_back(submeshLod);
+		for (uint32_t index : lod.Indices)
+			indices.push_back((std::uint16_t)index);
+	}
 	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->Name = "solarGeo";
 
 	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertexData, vbByteSize);
 
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
 	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-	geo->VertexBufferGPU->SetName(L"Vertex Buffer");
-	geo->VertexBufferUploader->SetName(L"Vertex Buffer Uploader");
-
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
-	geo->IndexBufferGPU->SetName(L"Index Buffer");
-	geo->IndexBufferUploader->SetName(L"Index Buffer Uploader");
-
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
+	geo->VertexByteStride = vertexStride;
 	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
+	Soco::GeometryArena::GetInstance()->Upload(mCommandList.Get(), geo.get(), vertexData, vbByteSize, indices.data(), ibByteSize);
 
 	SubmeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
+	submesh.IndexCount = (UINT)sphere.Indices32.size();
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
+	submesh.Lods = std::move(submeshLods);
+	BoundingBox::CreateFromPoints(submesh.Bounds, sphere.Vertices.size(), &sphere.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+	submesh.UvDensity = Soco::ComputeUvDensity(&sphere.Vertices[0].Position.x, sizeof(GeometryGenerator::Vertex),
+		&sphere.Vertices[0].TexC.x, sizeof(GeometryGenerator::Vertex), sphere.Indices32.data(), sphere.Indices32.size());
+
+	//星球按meshlet在CPU上剔除背面和视锥外的部分，顶点序号与优化后的顶点缓冲一致
+	submesh.Meshlets = std::make_shared<Soco::MeshletSet>(Soco::BuildMeshlets(sphere.Indices32.data(), sphere.Indices32.size(),
+		&sphere.Vertices[0].Position.x, sphere.Vertices.size(), sizeof(GeometryGenerator::Vertex)));
 
 	geo->DrawArgs["sphere"] = submesh;
 
@@ -925,70 +1501,87 @@ void SocoApp::BuildRenderObjects()
 	//mRenderObjectLayer[(int)RenderLayer::AlphaTested].push_back(boxRitem.get());
 	//mAllObject.push_back(std::move(boxRitem));
 
-	//Earth
+	//Skybox
+	auto SkyboxRitem = std::make_unique<Soco::SkyboxRenderer>(mMaterials["Skybox"].get());
+	mRenderObjectLayer[(int)RenderLayer::Skybox].push_back(SkyboxRitem.get());
+	mSkyboxRenderer = std::move(SkyboxRitem);
+
+	//2D精灵，每帧在SubmitSprites里提交
+	mSpriteBatch = std::make_unique<Soco::SpriteBatch>();
+	mRenderObjectLayer[(int)RenderLayer::UI].push_back(mSpriteBatch.get());
+}
+
+void SocoApp::BuildSolarEntities()
+{
+	const char* OBJECT_CB_NAME = "cbPerObject";
 	MeshGeometry* solarMesh = mGeometries["solar"].get();
-	auto earthRitem = std::make_unique<Soco::MeshRenderer>(mMaterials["Earth"].get(), solarMesh, solarMesh->DrawArgs["sphere"], OBJECT_CB_NAME);
 
-	SolarObjectConstants* solarOC = earthRitem->GetObjectData<SolarObjectConstants*>();
-	XMStoreFloat4x4(&solarOC->World, XMMatrixTranspose(XMMatrixScaling(1, 1, 1)*XMMatrixTranslation(20, 0, 20)));
-	mRenderObjectLayer[(int)RenderLayer::Opaque].push_back(earthRitem.get());
-	mMeshRenderers["Earth"] = std::move(earthRitem);
+	auto addRenderer = [&](const char* materialName) {
+		auto renderer = std::make_unique<Soco::MeshRenderer>(mMaterials[materialName].get(), solarMesh, solarMesh->DrawArgs["sphere"], OBJECT_CB_NAME);
+		mRenderObjectLayer[(int)RenderLayer::Opaque].push_back(renderer.get());
+		mMeshRenderers.push_back(std::move(renderer));
+		return Soco::MeshRendererComponent{ mMeshRenderers.back().get() };
+	};
+
+	auto orbit = [](float radius, float speed, float spinSpeed = 0) {
+		Soco::OrbitComponent component;
+		component.Radius = radius;
+		component.Speed = speed;
+		component.SpinSpeed = spinSpeed;
+		return component;
+	};
 
 	//Sun
-	auto sunRitem = std::make_unique<Soco::MeshRenderer>(mMaterials["Sun"].get(), solarMesh, solarMesh->DrawArgs["sphere"], OBJECT_CB_NAME);
-	solarOC = sunRitem->GetObjectData<SolarObjectConstants*>();
-	XMStoreFloat4x4(&solarOC->World, XMMatrixTranspose(XMMatrixScaling(6, 6, 6)));
-	mRenderObjectLayer[(int)RenderLayer::Opaque].push_back(sunRitem.get());
-	mMeshRenderers["Sun"] = std::move(sunRitem);
+	mScene.Create(Soco::Transform({ 0, 0, 0 }, { 0, 0, 0 }, { 6, 6, 6 }), Soco::WorldMatrixComponent(), addRenderer("Sun"));
 
-	//Moon
-	auto moonRitem = std::make_unique<Soco::MeshRenderer>(mMaterials["Moon"].get(), solarMesh, solarMesh->DrawArgs["sphere"], OBJECT_CB_NAME);
-	mRenderObjectLayer[(int)RenderLayer::Opaque].push_back(moonRitem.get());
-	mMeshRenderers["Moon"] = std::move(moonRitem);
+	//Earth，Moon的父节点是地球，随地球公转和自转
+	Soco::Entity earth = mScene.Create(orbit(26, 0.5f, 2), Soco::Transform({ 26, 0, 0 }, { 0, 0, 0 }, { 2, 2, 2 }),
+		Soco::WorldMatrixComponent(), addRenderer("Earth"));
+	mScene.Create(Soco::Transform({ 2.5f, 0, 0 }, { 0, 0, 0 }, { 0.5f, 0.5f, 0.5f }), Soco::ParentComponent{ earth },
+		Soco::WorldMatrixComponent(), addRenderer("Moon"));
 
 	//Mercury
-	auto MercuryRitem = std::make_unique<Soco::MeshRenderer>(mMaterials["Mercury"].get(), solarMesh, solarMesh->DrawArgs["sphere"], OBJECT_CB_NAME);
-	mRenderObjectLayer[(int)RenderLayer::Opaque].push_back(MercuryRitem.get());
-	mMeshRenderers["Mercury"] = std::move(MercuryRitem);
+	mScene.Create(orbit(8, 0.3f), Soco::Transform({ 8, 0, 0 }, { 0, 0, 0 }, { 1.5f, 1.5f, 1.5f }),
+		Soco::WorldMatrixComponent(), addRenderer("Mercury"));
 
 	//Venus
-	auto VenusRitem = std::make_unique<Soco::MeshRenderer>(mMaterials["Venus"].get(), solarMesh, solarMesh->DrawArgs["sphere"], OBJECT_CB_NAME);
-	mRenderObjectLayer[(int)RenderLayer::Opaque].push_back(VenusRitem.get());
-	mMeshRenderers["Venus"] = std::move(VenusRitem);
-
-	//Skybox
-	auto SkyboxRitem = std::make_unique<Soco::SkyboxRenderer>(mMaterials["Skybox"].get());
-	mRenderObjectLayer[(int)RenderLayer::Skybox].push_back(SkyboxRitem.get());
-	mSkyboxRenderer = std::move(SkyboxRitem);
-
-	//Texture2D
-	auto TextureRitem = std::make_unique<Soco::TextureRenderer>(mTerrain->GetTexture());
-	Soco::TextureRenderer::TexPositionCB& texCB = TextureRitem->GetTexPosCB();
-	texCB.size = { 0.2f, 0.2f };
-	mRenderObjectLayer[(int)RenderLayer::UI].push_back(TextureRitem.get());
-	mTextureRenderer = std::move(TextureRitem);
-}
-
-void SocoApp::BuildTransforms()
-{
-	mEarthTransform = Soco::Transform({ mEarthRotationRadius, 0, 0 }, { 0, 0, 0 }, { 2, 2, 2 });
-	mMoonTransform = Soco::Transform({ mMoonEarthRotationRadius, 0, 0 }, { 0,0,0 }, { 0.5f, 0.5f, 0.5f }, &mEarthTransform);
-	mMercuryTransform = Soco::Transform({ mMercurySunRotationRadius, 0, 0 }, { 0, 0, 0 }, { 1.5f, 1.5f, 1.5f });
-	mVenusTransform = Soco::Transform({ mVenusSunRotationRadius, 0, 0 }, { 0, 0, 0 }, { 1.7f, 1.7f, 1.7f });
+	mScene.Create(orbit(16, 0.4f), Soco::Transform({ 16, 0, 0 }, { 0, 0, 0 }, { 1.7f, 1.7f, 1.7f }),
+		Soco::WorldMatrixComponent(), addRenderer("Venus"));
+
+	//benchmark的额外行星：轨道由固定种子生成，每次运行都相同，材质轮流使用以产生状态切换
+	const uint32_t extraPlanetCount = mBenchmark ? mBenchmark->GetConfig().PlanetCount : 0;
+	const char* extraPlanetMaterials[] = { "Moon", "Mercury", "Venus" };
+	std::mt19937 rng(20201);
+	auto random01 = [&rng]() { return (float)(rng() / 4294967296.0); };
+	for (uint32_t i = 0; i < extraPlanetCount; ++i)
+	{
+		Soco::OrbitComponent planetOrbit = orbit(35.0f + 80.0f * random01(), 0);
+		planetOrbit.Height = 20.0f * (random01() - 0.5f);
+		planetOrbit.Speed = 0.05f + 0.5f * random01();
+		planetOrbit.Theta = XM_2PI * random01();
+		float scale = 0.3f + 0.7f * random01();
+
+		mScene.Create(planetOrbit, Soco::Transform({ planetOrbit.Radius, planetOrbit.Height, 0 }, { 0, 0, 0 }, { scale, scale, scale }),
+			Soco::WorldMatrixComponent(), addRenderer(extraPlanetMaterials[i % _countof(extraPlanetMaterials)]));
+	}
 }
 
-void SocoApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<Soco::Renderer*>& objects)
+void SocoApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<Soco::Renderer*>& objects,
+	Soco::InputAssemblerState& iaState, size_t begin, size_t end)
 {
+	SOCO_PROFILE_SCOPE("DrawRenderItems");
 
 	auto passCB = mCurrFrameResource->PassCB->Resource();
+	end = std::min<size_t>(end, objects.size());
 
     // For each render item...
-    for(size_t i = 0; i < objects.size(); ++i)
+    for(size_t i = begin; i < end; ++i)
     {
         auto object = objects[i];
 		object->SetPipelineState(cmdList);
 		object->SetGraphicsRootSignature(cmdList);
 
+		object->SetInputAssembler(cmdList, mCurrFrameResourceIndex, iaState);
 		object->Setup(cmdList, mCurrFrameResourceIndex);
 
 		object->SetCBV(cmdList, "cbPass", passCB->GetGPUVirtualAddress());
@@ -1001,7 +1594,8 @@ void SocoApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vec
 void SocoApp::BuildTerrain()
 {
 	const char* OBJECT_CB_NAME = "cbPerObject";
-	mTerrain = std::make_unique<Soco::Terrain>("../Textures/HeightMaps/heightmap2.png");
+	const UINT terrainDownScale = mBenchmark ? mBenchmark->GetConfig().TerrainDownScale : 16;
+	mTerrain = std::make_unique<Soco::Terrain>("../Textures/HeightMaps/heightmap2.png", terrainDownScale, mPackedVertices);
 
 	auto TerrainRitem = std::make_unique<Soco::TerrainRenderer>(mTerrain.get(), mMaterials["Terrain"].get(), OBJECT_CB_NAME);
 	mRenderObjectLayer[(int)RenderLayer::Opaque].push_back(TerrainRitem.get());
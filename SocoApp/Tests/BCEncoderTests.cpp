@@ -0,0 +1,350 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Common/BCEncoder.h"
+#include "Common/lodepng.h"
+#include "Soco/Util/JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace Soco
+{
+
+namespace
+{
+
+uint8_t RoundToByte(float v)
+{
+	return (uint8_t)std::min(std::max((int)(v + 0.5f), 0), 255);
+}
+
+// 565按规范展开成8位
+void Expand565(uint16_t color, int* rgb)
+{
+	const int r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+// 只比较格式保存的通道：BC4是R，BC5是RG，BC1是RGB(不透明时)，BC7是RGBA
+double ComputePsnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, BCFormat format)
+{
+	const int channels = format == BCFormat::BC4 ? 1 : (format == BCFormat::BC5 ? 2 : (format == BCFormat::BC1 ? 3 : 4));
+	double sum = 0.0;
+	size_t count = 0;
+	for (size_t i = 0; i < a.size(); i += 4)
+	{
+		for (int c = 0; c < channels; ++c)
+		{
+			const double d = (double)a[i + c] - b[i + c];
+			sum += d * d;
+		}
+		count += channels;
+	}
+	if (sum == 0.0)
+		return 99.0;
+	return 10.0 * std::log10(255.0 * 255.0 / (sum / count));
+}
+
+// 平滑渐变、正弦花纹、硬边的几何形状和少量噪声
+std::vector<uint8_t> MakeColorImage(uint32_t width, uint32_t height)
+{
+	std::mt19937 rng(11);
+	std::uniform_int_distribution<int> noise(-6, 6);
+	std::vector<uint8_t> pixels((size_t)width * height * 4);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const float u = (x + 0.5f) / width, v = (y + 0.5f) / height;
+			float color[4] = {
+				255.0f * u,
+				128.0f + 100.0f * std::sin(u * 19.0f + v * 7.0f),
+				255.0f * v * (1.0f - u),
+				255.0f,
+			};
+			const float dx = u - 0.5f, dy = v - 0.5f;
+			if (dx * dx + dy * dy < 0.04f)
+			{
+				color[0] = 230.0f;
+				color[1] = 40.0f;
+				color[2] = 60.0f;
+			}
+			if (((x / 32) + (y / 32)) % 7 == 0)
+				color[2] = 250.0f;
+			uint8_t* texel = &pixels[((size_t)y * width + x) * 4];
+			for (int c = 0; c < 4; ++c)
+				texel[c] = (uint8_t)std::min(std::max((int)color[c] + (c < 3 ? noise(rng) : 0), 0), 255);
+		}
+	}
+	return pixels;
+}
+
+float SyntheticHeight(float u, float v)
+{
+	return 0.5f + 0.25f * std::sin(u * 9.0f) * std::cos(v * 7.0f) + 0.15f * std::sin((u + v) * 23.0f) + 0.08f * std::cos(u * 41.0f - v * 13.0f);
+}
+
+std::vector<uint8_t> MakeHeightImage(uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t> pixels((size_t)width * height * 4);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const uint8_t h = RoundToByte(255.0f * SyntheticHeight((x + 0.5f) / width, (y + 0.5f) / height));
+			uint8_t* texel = &pixels[((size_t)y * width + x) * 4];
+			texel[0] = texel[1] = texel[2] = h;
+			texel[3] = 255;
+		}
+	}
+	return pixels;
+}
+
+// 由合成高度图求的切线空间法线，xy映射到[0, 255]
+std::vector<uint8_t> MakeNormalImage(uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t> pixels((size_t)width * height * 4);
+	const float step = 1.0f / width;
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const float u = (x + 0.5f) / width, v = (y + 0.5f) / height;
+			const float dx = (SyntheticHeight(u + step, v) - SyntheticHeight(u - step, v)) / (2.0f * step) * 0.05f;
+			const float dy = (SyntheticHeight(u, v + step) - SyntheticHeight(u, v - step)) / (2.0f * step) * 0.05f;
+			const float length = std::sqrt(dx * dx + dy * dy + 1.0f);
+			uint8_t* texel = &pixels[((size_t)y * width + x) * 4];
+			texel[0] = RoundToByte((-dx / length * 0.5f + 0.5f) * 255.0f);
+			texel[1] = RoundToByte((-dy / length * 0.5f + 0.5f) * 255.0f);
+			texel[2] = RoundToByte((1.0f / length * 0.5f + 0.5f) * 255.0f);
+			texel[3] = 255;
+		}
+	}
+	return pixels;
+}
+
+// 解码一个块，stride是expected相邻两项在解码结果里隔的字节数
+void CheckBlock(TestReport& report, const char* name, const uint8_t* block, BCFormat format, const uint8_t* expected, int count, int stride)
+{
+	TestCase test(report, name);
+	const std::vector<uint8_t> texels = DecodeBC(block, 4, 4, format);
+	for (int i = 0; i < count; ++i)
+	{
+		const int actual = texels[i * stride];
+		if (!test.Expect(actual == expected[i], "第" + std::to_string(i) + "项应为" + std::to_string(expected[i]) + "，实际是" + std::to_string(actual)))
+			break;
+	}
+	report.Add(test, "", GetBCFormatName(format), 4, 4, "", "", "", "", "");
+}
+
+// 按规范手写的块，检查解码器(编码器的误差也是用同样的调色板算的)
+void CheckKnownBlocks(TestReport& report)
+{
+	//BC1：c0 = 纯红(0xF800) > c1 = 纯蓝(0x001F)，所有索引为2，即(2 * 红 + 蓝) / 3
+	{
+		const uint8_t block[8] = { 0x00, 0xF8, 0x1F, 0x00, 0xAA, 0xAA, 0xAA, 0xAA };
+		const uint8_t expected[4] = { 170, 0, 85, 255 };
+		CheckBlock(report, "Known.BC1.FourColor", block, BCFormat::BC1, expected, 4, 1);
+	}
+	//BC1：c0 = 蓝 <= c1 = 红时是3色模式，索引2是平均值，索引3是透明黑
+	{
+		const uint8_t block[8] = { 0x1F, 0x00, 0x00, 0xF8, 0x0E, 0x00, 0x00, 0x00 };
+		const uint8_t expected[8] = { 128, 0, 128, 255, 0, 0, 0, 0 };
+		CheckBlock(report, "Known.BC1.ThreeColor", block, BCFormat::BC1, expected, 8, 1);
+	}
+	//BC4：a0 = 255 > a1 = 0，第一个像素索引2是(6 * 255 + 0) / 7，第二个像素索引7是(255 + 6 * 0) / 7
+	{
+		const uint8_t block[8] = { 255, 0, 0x3A, 0, 0, 0, 0, 0 };
+		const uint8_t expected[2] = { 219, 36 };
+		CheckBlock(report, "Known.BC4.EightValues", block, BCFormat::BC4, expected, 2, 4);
+	}
+	//BC4：a0 = 10 <= a1 = 20，索引6和7是0和255，索引3是(3 * 10 + 2 * 20) / 5
+	{
+		const uint8_t block[8] = { 10, 20, 0xFE, 0, 0, 0, 0, 0 };
+		const uint8_t expected[3] = { 0, 255, 14 };
+		CheckBlock(report, "Known.BC4.SixValues", block, BCFormat::BC4, expected, 3, 4);
+	}
+	//BC7 mode 6：所有端点7位全1、p位为1，即所有通道255
+	{
+		const uint8_t block[16] = { 0xC0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 };
+		uint8_t expected[64];
+		memset(expected, 255, sizeof(expected));
+		CheckBlock(report, "Known.BC7.Mode6", block, BCFormat::BC7, expected, 64, 1);
+	}
+}
+
+// 随机纯色块和几个含0、255的纯色块：BC4/BC5任意颜色无损，BC7除了同时含0和255的颜色(误差1)都无损，BC1在565能表示的颜色上无损
+void CheckSolidBlocks(TestReport& report)
+{
+	std::mt19937 rng(5);
+	std::uniform_int_distribution<int> byte(0, 255);
+	const uint8_t extremes[][4] = { { 0, 0, 0, 0 }, { 255, 255, 255, 255 }, { 255, 0, 0, 255 }, { 0, 128, 255, 1 } };
+
+	TestCase solid(report, "SolidBlocks");
+	TestCase solid565(report, "SolidBlocks.BC1");
+	for (int trial = 0; trial < 260; ++trial)
+	{
+		uint8_t color[4] = { (uint8_t)byte(rng), (uint8_t)byte(rng), (uint8_t)byte(rng), (uint8_t)byte(rng) };
+		if (trial >= 256)
+			memcpy(color, extremes[trial - 256], 4);
+		uint8_t texels[64];
+		for (int i = 0; i < 16; ++i)
+			memcpy(texels + i * 4, color, 4);
+
+		bool hasZero = false, hasMax = false;
+		for (int c = 0; c < 4; ++c)
+		{
+			hasZero |= color[c] == 0;
+			hasMax |= color[c] == 255;
+		}
+
+		const std::string colorName = "(" + std::to_string(color[0]) + ", " + std::to_string(color[1]) + ", "
+			+ std::to_string(color[2]) + ", " + std::to_string(color[3]) + ")";
+		const BCFormat formats[] = { BCFormat::BC4, BCFormat::BC5, BCFormat::BC7 };
+		for (BCFormat format : formats)
+		{
+			const std::vector<uint8_t> encoded = EncodeBC(texels, 4, 4, format, BCEncodeOptions());
+			const std::vector<uint8_t> decoded = DecodeBC(encoded.data(), 4, 4, format);
+			const int channels = format == BCFormat::BC4 ? 1 : (format == BCFormat::BC5 ? 2 : 4);
+			const int tolerance = format == BCFormat::BC7 && hasZero && hasMax ? 1 : 0;
+			int maxError = 0;
+			for (int i = 0; i < 16; ++i)
+				for (int c = 0; c < channels; ++c)
+					maxError = std::max(maxError, std::abs((int)decoded[i * 4 + c] - (int)texels[i * 4 + c]));
+			solid.Expect(maxError <= tolerance, std::string(GetBCFormatName(format)) + "纯色块" + colorName + "的误差是" + std::to_string(maxError));
+		}
+
+		//BC1用随机的565颜色
+		int expanded[3];
+		Expand565((uint16_t)(color[0] << 8 | color[1]), expanded);
+		for (int i = 0; i < 16; ++i)
+		{
+			texels[i * 4] = (uint8_t)expanded[0];
+			texels[i * 4 + 1] = (uint8_t)expanded[1];
+			texels[i * 4 + 2] = (uint8_t)expanded[2];
+			texels[i * 4 + 3] = 255;
+		}
+		uint8_t block[8];
+		EncodeBC1Block(texels, block);
+		const std::vector<uint8_t> decoded = DecodeBC(block, 4, 4, BCFormat::BC1);
+		solid565.Expect(memcmp(texels, decoded.data(), 64) == 0,
+			"纯色块(" + std::to_string(expanded[0]) + ", " + std::to_string(expanded[1]) + ", " + std::to_string(expanded[2]) + ")有损");
+	}
+	report.Add(solid, "", "BC4/BC5/BC7", 4, 4, "", "", "", "", "");
+	report.Add(solid565, "", "BC1", 4, 4, "", "", "", "", "");
+
+	//BC1透明像素要解码成alpha为0
+	TestCase transparent(report, "BC1.Transparency");
+	uint8_t texels[64];
+	for (int i = 0; i < 16; ++i)
+	{
+		texels[i * 4] = (uint8_t)(i * 16);
+		texels[i * 4 + 1] = 100;
+		texels[i * 4 + 2] = 50;
+		texels[i * 4 + 3] = i % 3 == 0 ? 0 : 255;
+	}
+	uint8_t block[8];
+	EncodeBC1Block(texels, block);
+	const std::vector<uint8_t> decoded = DecodeBC(block, 4, 4, BCFormat::BC1);
+	for (int i = 0; i < 16; ++i)
+	{
+		if (!transparent.Expect((decoded[i * 4 + 3] == 0) == (texels[i * 4 + 3] == 0), "第" + std::to_string(i) + "个像素的透明度不对"))
+			break;
+	}
+	report.Add(transparent, "", "BC1", 4, 4, "", "", "", "", "");
+}
+
+}
+
+bool RunBCEncoderBenchmark(const std::string& path)
+{
+	TestReport report("BCEncoder", path, "Image,Format,Width,Height,Refine,Psnr,Threads,SingleMs,ParallelMs");
+
+	CheckKnownBlocks(report);
+	CheckSolidBlocks(report);
+
+	struct TestImage
+	{
+		std::string Name;
+		uint32_t Width;
+		uint32_t Height;
+		std::vector<uint8_t> Pixels;
+		BCFormat Formats[2];
+		int FormatCount;
+		// 每种格式细化2轮时的PSNR下限(dB)，比实测值低0.5dB左右，编码质量退化时能发现
+		double MinPsnr[2];
+	};
+	std::vector<TestImage> images;
+	images.push_back({ "Color", 512, 512, MakeColorImage(512, 512), { BCFormat::BC1, BCFormat::BC7 }, 2, { 37.5, 40.5 } });
+	images.push_back({ "Height", 512, 512, MakeHeightImage(512, 512), { BCFormat::BC4, BCFormat::BC1 }, 2, { 56.0, 45.0 } });
+	images.push_back({ "Normal", 512, 512, MakeNormalImage(512, 512), { BCFormat::BC5, BCFormat::BC1 }, 2, { 69.0, 43.5 } });
+
+	//仓库里的高度图，按运行时的相对路径找，找不到时跳过
+	{
+		unsigned char* data = nullptr;
+		unsigned width = 0, height = 0;
+		if (lodepng_decode32_file(&data, &width, &height, "../Textures/HeightMaps/heightmap2.png") == 0)
+		{
+			images.push_back({ "heightmap2.png", width, height, std::vector<uint8_t>(data, data + (size_t)width * height * 4),
+				{ BCFormat::BC4, BCFormat::BC1 }, 2, { 67.0, 44.5 } });
+		}
+		else
+		{
+			std::cout << "BCEncoder：没有找到../Textures/HeightMaps/heightmap2.png，跳过" << std::endl;
+		}
+		free(data);
+	}
+
+	const uint32_t threadCount = JobSystem::GetInstance()->GetThreadCount();
+	for (const TestImage& image : images)
+	{
+		for (int f = 0; f < image.FormatCount; ++f)
+		{
+			const BCFormat format = image.Formats[f];
+			for (uint32_t refine = 0; refine <= 2; refine += 2)
+			{
+				TestCase test(report, image.Name + "." + GetBCFormatName(format) + ".Refine" + std::to_string(refine));
+				BCEncodeOptions options;
+				options.RefineIterations = refine;
+
+				//单线程和并行各测几次取最快的一次，两者结果必须一致
+				double bestMs[2] = { DBL_MAX, DBL_MAX };
+				std::vector<uint8_t> encoded[2];
+				for (int parallel = 0; parallel < 2; ++parallel)
+				{
+					options.Parallel = parallel != 0;
+					for (int repeat = 0; repeat < 3; ++repeat)
+					{
+						const auto start = std::chrono::high_resolution_clock::now();
+						encoded[parallel] = EncodeBC(image.Pixels.data(), image.Width, image.Height, format, options);
+						const auto end = std::chrono::high_resolution_clock::now();
+						bestMs[parallel] = std::min(bestMs[parallel], std::chrono::duration<double, std::milli>(end - start).count());
+					}
+				}
+				test.Expect(encoded[0] == encoded[1], "并行编码的结果和单线程不同");
+				test.Expect(encoded[0].size() == GetBCSize(format, image.Width, image.Height), "编码结果的大小和GetBCSize不一致");
+
+				const std::vector<uint8_t> decoded = DecodeBC(encoded[0].data(), image.Width, image.Height, format);
+				const double psnr = ComputePsnr(image.Pixels, decoded, format);
+				if (refine == 2)
+					test.Expect(psnr >= image.MinPsnr[f], "PSNR " + std::to_string(psnr) + "dB低于" + std::to_string(image.MinPsnr[f]) + "dB");
+
+				report.Add(test, image.Name, GetBCFormatName(format), image.Width, image.Height, refine, psnr, threadCount, bestMs[0], bestMs[1]);
+				const double megaPixels = (double)image.Width * image.Height / 1e6;
+				std::cout << "BCEncoder：" << image.Name << " " << GetBCFormatName(format) << "，细化" << refine << "轮，PSNR " << psnr
+					<< "dB，单线程" << megaPixels / (bestMs[0] / 1000.0) << "MPix/s，" << threadCount << "线程" << megaPixels / (bestMs[1] / 1000.0) << "MPix/s" << std::endl;
+			}
+		}
+	}
+
+	return report.Finish();
+}
+
+}
@@ -0,0 +1,308 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/BindlessIndexAllocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+
+namespace Soco
+{
+
+namespace
+{
+
+struct BindlessTraceResult
+{
+	uint64_t Allocations = 0;
+	uint64_t Frees = 0;
+	uint64_t Updates = 0;
+	uint64_t CopiedDescriptors = 0;
+	uint32_t PeakLive = 0;
+	uint32_t HighWater = 0;
+	// 下标释放到再分配之间最少隔了几帧，没有再分配过时为0
+	uint64_t MinReuseFrames = 0;
+	double NsPerOperation = 0.0;
+};
+
+/*
+参考模型：每个下标的描述符有一个版本号，写描述符时加1并且直接写当前帧的副本(如果有)，BeginFrame返回的下标按最新版本更新那份副本
+每帧开始和结束时检查当前副本里所有已分配下标的版本都是最新的
+*/
+class BindlessTraceContext
+{
+public:
+	BindlessTraceContext(TestCase& test, uint32_t capacity, uint32_t frameCopies)
+		: mTest(test), mAllocator(capacity, frameCopies), mVersion(capacity, 0),
+		mCopyVersion(frameCopies, std::vector<uint64_t>(capacity, 0)), mLive(capacity, false), mFreedFrame(capacity, UINT64_MAX)
+	{}
+
+	// 只统计分配器自己的耗时
+	template<typename F>
+	auto Timed(F&& func)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		auto value = func();
+		mAllocatorNs += std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+		++mOperations;
+		return value;
+	}
+
+	void BeginFrame(uint32_t copy)
+	{
+		const std::vector<uint32_t>& dirty = *Timed([&]() { return &mAllocator.BeginFrame(copy); });
+		mFrameCopy = copy;
+		for (size_t i = 0; i < dirty.size(); ++i)
+		{
+			if (dirty[i] >= mAllocator.GetCapacity() || (i > 0 && dirty[i] <= dirty[i - 1]))
+			{
+				Fail("BeginFrame返回的下标越界、重复或没有排序");
+				break;
+			}
+			mCopyVersion[copy][dirty[i]] = mVersion[dirty[i]];
+		}
+		mResult.CopiedDescriptors += dirty.size();
+		CheckCurrentCopy();
+	}
+
+	void EndFrame()
+	{
+		CheckCurrentCopy();
+		if (mAllocator.GetLiveCount() != mLiveList.size())
+			Fail("已分配的下标数量不对");
+		mAllocator.EndFrame();
+		mFrameCopy = BindlessIndexAllocator::InvalidIndex;
+	}
+
+	uint32_t Allocate()
+	{
+		const uint32_t index = Timed([&]() { return mAllocator.Allocate(); });
+		if (index == BindlessIndexAllocator::InvalidIndex)
+		{
+			if (mLiveList.size() < mAllocator.GetCapacity() && mAllocator.GetRetiredCount() == 0)
+				Fail("还有空闲下标时分配失败");
+			return index;
+		}
+		if (index >= mAllocator.GetCapacity() || mLive[index])
+		{
+			Fail("分配了无效或已分配的下标" + std::to_string(index));
+			return BindlessIndexAllocator::InvalidIndex;
+		}
+		if (mFreedFrame[index] != UINT64_MAX)
+		{
+			const uint64_t delay = mAllocator.GetFrame() - mFreedFrame[index];
+			if (delay < mAllocator.GetFrameCopies())
+				Fail("下标" + std::to_string(index) + "释放后" + std::to_string(delay) + "帧就再分配了");
+			mResult.MinReuseFrames = mResult.MinReuseFrames == 0 ? delay : std::min(mResult.MinReuseFrames, delay);
+		}
+		mLive[index] = true;
+		mLiveList.push_back(index);
+		++mResult.Allocations;
+		mResult.PeakLive = std::max(mResult.PeakLive, (uint32_t)mLiveList.size());
+
+		//和BindlessTextureTable一样，分配后马上写描述符
+		WriteDescriptor(index);
+		return index;
+	}
+
+	void Release(uint32_t index)
+	{
+		if (!Timed([&]() { return mAllocator.Free(index); }))
+			Fail("释放已分配的下标" + std::to_string(index) + "失败");
+		if (Timed([&]() { return mAllocator.Free(index); }))
+			Fail("重复释放下标" + std::to_string(index) + "没有报错");
+		if (Timed([&]() { return mAllocator.MarkDirty(index); }))
+			Fail("已释放的下标" + std::to_string(index) + "还能MarkDirty");
+		mLive[index] = false;
+		mFreedFrame[index] = mAllocator.GetFrame();
+		mLiveList.erase(std::find(mLiveList.begin(), mLiveList.end(), index));
+		++mResult.Frees;
+	}
+
+	void Update(uint32_t index)
+	{
+		WriteDescriptor(index);
+		++mResult.Updates;
+	}
+
+	void Fail(const std::string& message)
+	{
+		mTest.Fail("第" + std::to_string(mAllocator.GetFrame()) + "帧，" + message);
+	}
+
+	const std::vector<uint32_t>& Live() const { return mLiveList; }
+	bool Passed() const { return mTest.Passed(); }
+
+	BindlessTraceResult Finish()
+	{
+		mResult.HighWater = mAllocator.GetHighWater();
+		mResult.NsPerOperation = mOperations > 0 ? mAllocatorNs / mOperations : 0.0;
+		return mResult;
+	}
+
+private:
+	void WriteDescriptor(uint32_t index)
+	{
+		++mVersion[index];
+		if (!Timed([&]() { return mAllocator.MarkDirty(index); }))
+			Fail("已分配的下标" + std::to_string(index) + "不能MarkDirty");
+		//两帧之间写当前副本会改到GPU还在用的描述符
+		if (mAllocator.GetCurrentCopy() != mFrameCopy)
+			Fail("当前副本应该是" + std::to_string((int)mFrameCopy));
+		if (mFrameCopy != BindlessIndexAllocator::InvalidIndex)
+			mCopyVersion[mFrameCopy][index] = mVersion[index];
+	}
+
+	void CheckCurrentCopy()
+	{
+		const uint32_t copy = mAllocator.GetCurrentCopy();
+		if (copy == BindlessIndexAllocator::InvalidIndex)
+		{
+			Fail("BeginFrame之后没有当前副本");
+			return;
+		}
+		for (uint32_t index : mLiveList)
+		{
+			if (mCopyVersion[copy][index] != mVersion[index])
+			{
+				Fail("副本" + std::to_string(copy) + "里下标" + std::to_string(index) + "的描述符过期");
+				return;
+			}
+		}
+	}
+
+	TestCase& mTest;
+	BindlessIndexAllocator mAllocator;
+	std::vector<uint64_t> mVersion;
+	std::vector<std::vector<uint64_t>> mCopyVersion;
+	uint32_t mFrameCopy = BindlessIndexAllocator::InvalidIndex;
+	std::vector<bool> mLive;
+	std::vector<uint64_t> mFreedFrame;
+	std::vector<uint32_t> mLiveList;
+	BindlessTraceResult mResult;
+	uint64_t mOperations = 0;
+	double mAllocatorNs = 0.0;
+};
+
+struct BindlessTrace
+{
+	const char* Name;
+	uint32_t Capacity;
+	uint32_t FrameCopies;
+	uint32_t Frames;
+	// 每帧BeginFrame之后调用
+	std::function<void(BindlessTraceContext& context, uint64_t frame, std::mt19937& rng)> Step;
+};
+
+BindlessTraceResult RunTrace(TestCase& test, const BindlessTrace& trace)
+{
+	BindlessTraceContext context(test, trace.Capacity, trace.FrameCopies);
+	std::mt19937 rng(4901);
+
+	//第一次BeginFrame之前注册的纹理，和启动时加载的一样
+	for (uint32_t i = 0; i < trace.Capacity / 8; ++i)
+		context.Allocate();
+
+	for (uint64_t frame = 0; frame < trace.Frames && context.Passed(); ++frame)
+	{
+		context.BeginFrame((uint32_t)(frame % trace.FrameCopies));
+		trace.Step(context, frame, rng);
+		context.EndFrame();
+
+		//两帧之间(比如改变窗口大小时)也会写描述符，这时所有副本都在下次轮到自己时更新
+		if (frame % 7 == 0 && !context.Live().empty())
+			context.Update(context.Live()[rng() % context.Live().size()]);
+		if (frame % 13 == 0)
+			context.Allocate();
+	}
+	return context.Finish();
+}
+
+void ReleaseRandom(BindlessTraceContext& context, std::mt19937& rng)
+{
+	if (!context.Live().empty())
+		context.Release(context.Live()[rng() % context.Live().size()]);
+}
+
+}
+
+bool RunBindlessAllocatorBenchmark(const std::string& path)
+{
+	TestReport report("Bindless", path, "Capacity,FrameCopies,Frames,Allocations,Frees,Updates,CopiedDescriptors,PeakLive,HighWater,MinReuseFrames,NsPerOperation");
+
+	std::vector<BindlessTrace> traces;
+	//第1帧分配到满，第2帧全部释放：之后两帧在飞的帧还可能用着这些下标，分配都要失败，第5帧全部能再分配
+	traces.push_back({ "FillAndDrain", 256, 3, 12, [](BindlessTraceContext& context, uint64_t frame, std::mt19937& rng) {
+		if (frame == 1 || frame == 5)
+		{
+			while (context.Allocate() != BindlessIndexAllocator::InvalidIndex) {}
+			if (context.Live().size() != 256)
+				context.Fail("填满后已分配的下标数量不对");
+		}
+		else if (frame == 2)
+		{
+			//按随机顺序释放，再分配的顺序和释放顺序无关
+			while (!context.Live().empty())
+				ReleaseRandom(context, rng);
+		}
+		else if (frame == 3 || frame == 4)
+		{
+			if (context.Allocate() != BindlessIndexAllocator::InvalidIndex)
+				context.Fail("刚释放的下标在在飞的帧执行完之前被再分配了");
+		}
+	} });
+	//随机分配、释放、换描述符，每500帧一次释放一大批
+	auto random = [](BindlessTraceContext& context, uint64_t frame, std::mt19937& rng) {
+		const uint32_t operations = rng() % 16;
+		for (uint32_t i = 0; i < operations; ++i)
+		{
+			const uint32_t op = rng() % 3;
+			if (op == 0 || context.Live().size() < 64)
+				context.Allocate();
+			else if (op == 1)
+				ReleaseRandom(context, rng);
+			else
+				context.Update(context.Live()[rng() % context.Live().size()]);
+		}
+		if (frame % 500 == 499)
+		{
+			for (uint32_t i = 0; i < 200; ++i)
+				ReleaseRandom(context, rng);
+		}
+	};
+	traces.push_back({ "Random", 1024, 3, 4000, random });
+	traces.push_back({ "RandomTwoCopies", 1024, 2, 4000, random });
+	//常驻管理换mip：已注册的纹理每帧有几张换描述符，每300帧换一批关卡纹理
+	traces.push_back({ "Streaming", 1024, 3, 3000, [](BindlessTraceContext& context, uint64_t frame, std::mt19937& rng) {
+		if (frame == 0)
+		{
+			while (context.Live().size() < 600)
+				context.Allocate();
+		}
+		for (uint32_t i = 0; i < 8; ++i)
+			context.Update(context.Live()[rng() % context.Live().size()]);
+		if (frame % 300 == 299)
+		{
+			for (uint32_t i = 0; i < 150; ++i)
+				ReleaseRandom(context, rng);
+			for (uint32_t i = 0; i < 150; ++i)
+				context.Allocate();
+		}
+	} });
+
+	for (const BindlessTrace& trace : traces)
+	{
+		TestCase test(report, trace.Name);
+		const BindlessTraceResult result = RunTrace(test, trace);
+		report.Add(test, trace.Capacity, trace.FrameCopies, trace.Frames, result.Allocations, result.Frees, result.Updates,
+			result.CopiedDescriptors, result.PeakLive, result.HighWater, result.MinReuseFrames, result.NsPerOperation);
+		std::cout << trace.Name << "：分配" << result.Allocations << "次，释放" << result.Frees << "次，更新副本"
+			<< result.CopiedDescriptors << "个描述符，峰值" << result.PeakLive << "，最短重用间隔" << result.MinReuseFrames << "帧" << std::endl;
+	}
+
+	return report.Finish();
+}
+
+}
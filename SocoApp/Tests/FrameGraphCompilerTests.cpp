@@ -0,0 +1,480 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/FrameGraphCompiler.h"
+
+#include <iterator>
+#include <random>
+#include <sstream>
+
+namespace Soco
+{
+
+namespace
+{
+
+uint32_t AddTestResource(FrameGraphCompiler& compiler, const char* name, uint64_t aliasKey = 0, uint64_t size = 0)
+{
+	FGResourceInfo info;
+	info.Name = name;
+	info.AliasKey = aliasKey;
+	info.Size = size;
+	info.Alignment = size != 0 ? 65536 : 1;
+	return compiler.AddResource(info);
+}
+
+uint32_t AddTestImported(FrameGraphCompiler& compiler, const char* name, uint32_t initialState, uint32_t finalState)
+{
+	FGResourceInfo info;
+	info.Name = name;
+	info.Imported = true;
+	info.InitialState = initialState;
+	info.FinalState = finalState;
+	return compiler.AddResource(info);
+}
+
+uint32_t AddTestPass(FrameGraphCompiler& compiler, const char* name, std::vector<FGAccess> accesses, bool sideEffect = false)
+{
+	FGPassInfo info;
+	info.Name = name;
+	info.Accesses = std::move(accesses);
+	info.HasSideEffect = sideEffect;
+	return compiler.AddPass(info);
+}
+
+FGBarrier Transition(uint32_t resource, uint32_t before, uint32_t after)
+{
+	return { FGBarrier::BarrierType::Transition, resource, before, after };
+}
+
+FGBarrier UavBarrier(uint32_t resource)
+{
+	return { FGBarrier::BarrierType::UAV, resource, FGState::UnorderedAccess, FGState::UnorderedAccess };
+}
+
+FGBarrier AliasingBarrier(uint32_t resource, uint32_t before)
+{
+	FGBarrier barrier;
+	barrier.Type = FGBarrier::BarrierType::Aliasing;
+	barrier.Resource = resource;
+	barrier.ResourceBefore = before;
+	return barrier;
+}
+
+bool SameBarrier(const FGBarrier& a, const FGBarrier& b)
+{
+	if (a.Type != b.Type || a.Resource != b.Resource)
+		return false;
+	if (a.Type == FGBarrier::BarrierType::Aliasing)
+		return a.ResourceBefore == b.ResourceBefore;
+	return a.StateBefore == b.StateBefore && a.StateAfter == b.StateAfter;
+}
+
+void ExpectBarriers(TestCase& test, const std::string& where, const std::vector<FGBarrier>& actual, const std::vector<FGBarrier>& expected)
+{
+	bool same = actual.size() == expected.size();
+	for (size_t i = 0; same && i < actual.size(); ++i)
+		same = SameBarrier(actual[i], expected[i]);
+	if (same)
+		return;
+
+	std::ostringstream message;
+	message << where << "的屏障不对，得到";
+	for (const FGBarrier& barrier : actual)
+		message << " (" << (int)barrier.Type << "," << barrier.Resource << "," << barrier.StateBefore << "->" << barrier.StateAfter << ")";
+	test.Fail(message.str());
+}
+
+// 存活的pass按顺序是expected，每个pass的屏障依次是barriers
+void ExpectPasses(TestCase& test, const FGCompileResult& result, const std::vector<uint32_t>& expected,
+	const std::vector<std::vector<FGBarrier>>& barriers)
+{
+	if (result.Passes.size() != expected.size())
+	{
+		test.Fail("存活的pass数量是" + std::to_string(result.Passes.size()) + "，应该是" + std::to_string(expected.size()));
+		return;
+	}
+	for (size_t i = 0; i < expected.size(); ++i)
+	{
+		test.Expect(result.Passes[i].Pass == expected[i], "第" + std::to_string(i) + "个执行的pass不对");
+		ExpectBarriers(test, "第" + std::to_string(i) + "个pass", result.Passes[i].Barriers, barriers[i]);
+	}
+}
+
+size_t CountBarriers(const FGCompileResult& result)
+{
+	size_t count = result.FinalBarriers.size();
+	for (const FGCompiledPass& pass : result.Passes)
+		count += pass.Barriers.size();
+	return count;
+}
+
+/*
+随机图的不变量：
+同一资源上有冲突的访问(至少一个是写)按声明顺序执行；存活的pass读到的内容的写者都存活；有副作用或写外部资源的pass都存活
+同一个slot上的资源AliasKey相同、生命周期不重叠；同一个堆里生命周期重叠的slot内存不重叠
+按屏障重放状态，每次访问时资源处在需要的状态
+*/
+void CheckInvariants(TestCase& test, const FrameGraphCompiler& compiler, const FGCompileResult& result)
+{
+	const uint32_t passCount = (uint32_t)compiler.PassCount();
+	const uint32_t resourceCount = (uint32_t)compiler.ResourceCount();
+
+	std::vector<uint32_t> position(passCount, FGInvalidIndex);
+	for (uint32_t i = 0; i < result.Passes.size(); ++i)
+		position[result.Passes[i].Pass] = i;
+
+	std::vector<uint32_t> lastWriter(resourceCount, FGInvalidIndex);
+	std::vector<uint32_t> lastAccess(resourceCount, FGInvalidIndex);
+	std::vector<uint32_t> firstUse(resourceCount, FGInvalidIndex);
+	std::vector<uint32_t> lastUse(resourceCount, FGInvalidIndex);
+	for (uint32_t pass = 0; pass < passCount; ++pass)
+	{
+		const FGPassInfo& info = compiler.GetPass(pass);
+		const bool live = position[pass] != FGInvalidIndex;
+		test.Expect(live != result.PassCulled[pass], "PassCulled和执行顺序不一致");
+
+		bool root = info.HasSideEffect;
+		for (const FGAccess& access : info.Accesses)
+		{
+			const uint32_t r = access.Resource;
+			const bool write = !FGState::IsReadOnly(access.State);
+			root = root || (write && compiler.GetResource(r).Imported);
+			if (live && lastWriter[r] != FGInvalidIndex)
+				test.Expect(position[lastWriter[r]] != FGInvalidIndex, info.Name + "读到的内容的写者被剔除了");
+			if (live && write && lastAccess[r] != FGInvalidIndex && position[lastAccess[r]] != FGInvalidIndex)
+				test.Expect(position[lastAccess[r]] < position[pass], info.Name + "在之前访问同一资源的pass之前执行");
+			if (live)
+			{
+				if (firstUse[r] == FGInvalidIndex)
+					firstUse[r] = position[pass];
+				lastUse[r] = position[pass];
+				lastAccess[r] = pass;
+			}
+			if (write)
+				lastWriter[r] = pass;
+		}
+		test.Expect(!root || live, info.Name + "有副作用却被剔除了");
+	}
+
+	for (uint32_t a = 0; a < resourceCount; ++a)
+	{
+		const uint32_t slotA = result.PhysicalSlot[a];
+		test.Expect(result.ResourceCulled[a] == (firstUse[a] == FGInvalidIndex), "ResourceCulled不对");
+		test.Expect((slotA == FGInvalidIndex) == (compiler.GetResource(a).Imported || result.ResourceCulled[a]), "存活的transient资源没有slot");
+		if (slotA == FGInvalidIndex)
+			continue;
+		test.Expect(result.SlotAliasKey[slotA] == compiler.GetResource(a).AliasKey, "slot的AliasKey不对");
+
+		for (uint32_t b = a + 1; b < resourceCount; ++b)
+		{
+			const uint32_t slotB = result.PhysicalSlot[b];
+			if (slotB == FGInvalidIndex)
+				continue;
+			const bool overlap = firstUse[a] <= lastUse[b] && firstUse[b] <= lastUse[a];
+			test.Expect(!(overlap && slotA == slotB), "生命周期重叠的资源用了同一个slot");
+
+			const uint32_t group = result.SlotHeapGroup[slotA];
+			if (!overlap || slotA == slotB || group == FGInvalidIndex || group != result.SlotHeapGroup[slotB])
+				continue;
+			const uint64_t beginA = result.SlotHeapOffset[slotA], endA = beginA + compiler.GetResource(a).Size;
+			const uint64_t beginB = result.SlotHeapOffset[slotB], endB = beginB + compiler.GetResource(b).Size;
+			test.Expect(endA <= beginB || endB <= beginA, "同时存活的资源在堆里重叠");
+			test.Expect(endA <= result.HeapSize[group] && endB <= result.HeapSize[group], "资源超出了堆的大小");
+		}
+	}
+
+	//Aliasing屏障的ResourceBefore是这段内存上最后一个已经结束的资源
+	for (uint32_t i = 0; i < result.Passes.size(); ++i)
+	{
+		for (const FGBarrier& barrier : result.Passes[i].Barriers)
+		{
+			if (barrier.Type != FGBarrier::BarrierType::Aliasing)
+				continue;
+			const uint32_t slot = result.PhysicalSlot[barrier.Resource];
+			const uint64_t begin = result.SlotHeapOffset[slot], end = begin + compiler.GetResource(barrier.Resource).Size;
+			uint32_t latest = FGInvalidIndex;
+			for (uint32_t r = 0; r < resourceCount; ++r)
+			{
+				const uint32_t other = result.PhysicalSlot[r];
+				if (other == FGInvalidIndex || result.SlotHeapGroup[other] != result.SlotHeapGroup[slot] || lastUse[r] >= i)
+					continue;
+				const uint64_t otherBegin = result.SlotHeapOffset[other], otherEnd = otherBegin + compiler.GetResource(r).Size;
+				if (otherBegin < end && begin < otherEnd && (latest == FGInvalidIndex || lastUse[r] > latest))
+					latest = lastUse[r];
+			}
+			test.Expect(barrier.ResourceBefore == FGInvalidIndex ? latest == FGInvalidIndex :
+				latest != FGInvalidIndex && lastUse[barrier.ResourceBefore] == latest, "Aliasing屏障的ResourceBefore不是最后一个占用者");
+		}
+	}
+
+	//重放：Imported按资源、transient按slot跟踪状态，transient都从Common开始
+	std::vector<uint32_t> importedState(resourceCount);
+	for (uint32_t r = 0; r < resourceCount; ++r)
+		importedState[r] = compiler.GetResource(r).InitialState;
+	std::vector<uint32_t> slotState(result.SlotAliasKey.size(), FGState::Common);
+	auto state = [&](uint32_t r) -> uint32_t& {
+		return compiler.GetResource(r).Imported ? importedState[r] : slotState[result.PhysicalSlot[r]];
+	};
+	auto replay = [&](const std::vector<FGBarrier>& barriers) {
+		for (const FGBarrier& barrier : barriers)
+		{
+			if (barrier.Type != FGBarrier::BarrierType::Transition)
+				continue;
+			test.Expect(state(barrier.Resource) == barrier.StateBefore, "屏障的StateBefore和实际状态不同");
+			state(barrier.Resource) = barrier.StateAfter;
+		}
+	};
+	for (const FGCompiledPass& compiled : result.Passes)
+	{
+		replay(compiled.Barriers);
+		for (const FGAccess& access : compiler.GetPass(compiled.Pass).Accesses)
+		{
+			const uint32_t current = state(access.Resource);
+			if (FGState::IsReadOnly(access.State))
+				test.Expect(FGState::IsReadOnly(current) && (current & access.State) == access.State, "读的时候资源不在读状态");
+			else
+				test.Expect(current == access.State, "写的时候资源不在写状态");
+		}
+	}
+	replay(result.FinalBarriers);
+	for (uint32_t r = 0; r < resourceCount; ++r)
+	{
+		const FGResourceInfo& info = compiler.GetResource(r);
+		if (info.Imported && info.FinalState != FGState::Keep)
+			test.Expect(importedState[r] == info.FinalState, "Imported资源帧末不在FinalState");
+	}
+}
+
+// 随机的图：每个pass随机读几个已经写过的资源、写一两个资源，偶尔写外部资源或者有副作用
+void BuildRandomGraph(FrameGraphCompiler& compiler, std::mt19937& rng)
+{
+	const uint32_t writeStates[] = { FGState::RenderTarget, FGState::UnorderedAccess, FGState::DepthWrite, FGState::CopyDest };
+	const uint32_t readStates[] = { FGState::PixelShaderResource, FGState::NonPixelShaderResource, FGState::CopySource };
+
+	const uint32_t importedCount = 1 + rng() % 3;
+	for (uint32_t i = 0; i < importedCount; ++i)
+	{
+		const uint32_t finalState = rng() % 2 ? FGState::Present : FGState::Keep;
+		AddTestImported(compiler, "Imported", FGState::Common, finalState);
+	}
+	const uint32_t transientCount = 4 + rng() % 12;
+	for (uint32_t i = 0; i < transientCount; ++i)
+	{
+		//AliasKey相同的描述相同：key 0~2放在共享堆里，大小随key变，key 3~4不放进堆；key只有几种，容易复用slot
+		const uint64_t aliasKey = rng() % 5;
+		AddTestResource(compiler, "Transient", aliasKey, aliasKey < 3 ? (aliasKey + 1) * 65536 : 0);
+	}
+
+	std::vector<bool> written(compiler.ResourceCount(), false);
+	for (uint32_t r = 0; r < importedCount; ++r)
+		written[r] = true;
+
+	const uint32_t passCount = 3 + rng() % 14;
+	for (uint32_t pass = 0; pass < passCount; ++pass)
+	{
+		std::vector<FGAccess> accesses;
+		std::vector<bool> touched(compiler.ResourceCount(), false);
+		const uint32_t reads = rng() % 3;
+		for (uint32_t i = 0; i < reads; ++i)
+		{
+			const uint32_t r = rng() % compiler.ResourceCount();
+			if (written[r] && !touched[r])
+			{
+				accesses.push_back({ r, readStates[rng() % std::size(readStates)] });
+				touched[r] = true;
+			}
+		}
+		const uint32_t writes = 1 + rng() % 2;
+		for (uint32_t i = 0; i < writes; ++i)
+		{
+			const uint32_t r = rng() % 4 == 0 ? rng() % importedCount : importedCount + rng() % transientCount;
+			if (!touched[r])
+			{
+				accesses.push_back({ r, writeStates[rng() % std::size(writeStates)] });
+				touched[r] = true;
+				written[r] = true;
+			}
+		}
+		AddTestPass(compiler, "Random", accesses, rng() % 8 == 0);
+	}
+}
+
+// 每个用例一行：pass数、存活pass数、资源数、slot数、屏障数、堆大小、不做别名的大小
+void AddResult(TestReport& report, const TestCase& test, const FrameGraphCompiler& compiler, const FGCompileResult& result)
+{
+	uint64_t heapBytes = 0;
+	for (uint64_t size : result.HeapSize)
+		heapBytes += size;
+	report.Add(test, compiler.PassCount(), result.Passes.size(), compiler.ResourceCount(), result.SlotAliasKey.size(),
+		CountBarriers(result), heapBytes, result.TransientTotalSize);
+}
+
+}
+
+bool RunFrameGraphCompilerTests(const std::string& path)
+{
+	using namespace FGState;
+	TestReport report("FrameGraphCompiler", path, "Passes,LivePasses,Resources,Slots,Barriers,HeapBytes,TransientBytes");
+
+	//写后读：读之前转换到读状态，外部资源帧末回到Present
+	{
+		TestCase test(report, "ReadAfterWrite");
+		FrameGraphCompiler compiler;
+		uint32_t backBuffer = AddTestImported(compiler, "BackBuffer", Present, Present);
+		uint32_t color = AddTestResource(compiler, "Color");
+		uint32_t draw = AddTestPass(compiler, "Draw", { { color, RenderTarget } });
+		uint32_t blit = AddTestPass(compiler, "Blit", { { color, PixelShaderResource }, { backBuffer, RenderTarget } });
+		FGCompileResult result = compiler.Compile();
+		ExpectPasses(test, result, { draw, blit }, {
+			{ Transition(color, Common, RenderTarget) },
+			{ Transition(color, RenderTarget, PixelShaderResource), Transition(backBuffer, Present, RenderTarget) } });
+		ExpectBarriers(test, "帧末", result.FinalBarriers, { Transition(backBuffer, RenderTarget, Present) });
+		CheckInvariants(test, compiler, result);
+		AddResult(report, test, compiler, result);
+	}
+
+	//写后写：第一个写者也是数据依赖，不能剔除；状态相同的连续写没有屏障
+	{
+		TestCase test(report, "WriteAfterWrite");
+		FrameGraphCompiler compiler;
+		uint32_t output = AddTestImported(compiler, "Output", Common, Keep);
+		uint32_t color = AddTestResource(compiler, "Color");
+		uint32_t clear = AddTestPass(compiler, "Clear", { { color, RenderTarget } });
+		uint32_t draw = AddTestPass(compiler, "Draw", { { color, RenderTarget } });
+		uint32_t resolve = AddTestPass(compiler, "Resolve", { { color, PixelShaderResource }, { output, RenderTarget } });
+		FGCompileResult result = compiler.Compile();
+		ExpectPasses(test, result, { clear, draw, resolve }, {
+			{ Transition(color, Common, RenderTarget) },
+			{},
+			{ Transition(color, RenderTarget, PixelShaderResource), Transition(output, Common, RenderTarget) } });
+		test.Expect(result.FinalBarriers.empty(), "FinalState为Keep的资源不应该有帧末屏障");
+		CheckInvariants(test, compiler, result);
+		AddResult(report, test, compiler, result);
+	}
+
+	//读后写：第二次写在读之后，只约束顺序，不让没人读的第二次写存活
+	{
+		TestCase test(report, "WriteAfterRead");
+		FrameGraphCompiler compiler;
+		uint32_t first = AddTestImported(compiler, "First", Common, Keep);
+		uint32_t second = AddTestImported(compiler, "Second", Common, Keep);
+		uint32_t color = AddTestResource(compiler, "Color");
+		uint32_t drawA = AddTestPass(compiler, "DrawA", { { color, RenderTarget } });
+		uint32_t copyA = AddTestPass(compiler, "CopyA", { { color, PixelShaderResource }, { first, RenderTarget } });
+		uint32_t inspect = AddTestPass(compiler, "Inspect", { { color, NonPixelShaderResource } });
+		uint32_t drawB = AddTestPass(compiler, "DrawB", { { color, RenderTarget } });
+		uint32_t copyB = AddTestPass(compiler, "CopyB", { { color, PixelShaderResource }, { second, RenderTarget } });
+		uint32_t drawC = AddTestPass(compiler, "DrawC", { { color, RenderTarget } });
+		FGCompileResult result = compiler.Compile();
+		ExpectPasses(test, result, { drawA, copyA, drawB, copyB }, {
+			{ Transition(color, Common, RenderTarget) },
+			{ Transition(color, RenderTarget, PixelShaderResource), Transition(first, Common, RenderTarget) },
+			{ Transition(color, PixelShaderResource, RenderTarget) },
+			{ Transition(color, RenderTarget, PixelShaderResource), Transition(second, Common, RenderTarget) } });
+		test.Expect(result.PassCulled[drawC], "最后一次没人读的写应该被剔除");
+		test.Expect(result.PassCulled[inspect], "只在DrawB之前读、没有输出的pass应该被剔除");
+		CheckInvariants(test, compiler, result);
+		AddResult(report, test, compiler, result);
+	}
+
+	//剔除：没人读的pass、只被剔除的pass读的pass都剔除；有副作用的pass和它的输入保留
+	{
+		TestCase test(report, "Culling");
+		FrameGraphCompiler compiler;
+		uint32_t unused = AddTestResource(compiler, "Unused");
+		uint32_t chainA = AddTestResource(compiler, "ChainA");
+		uint32_t chainB = AddTestResource(compiler, "ChainB");
+		uint32_t readback = AddTestResource(compiler, "Readback");
+		uint32_t dead = AddTestPass(compiler, "Dead", { { unused, RenderTarget } });
+		uint32_t deadA = AddTestPass(compiler, "DeadA", { { chainA, UnorderedAccess } });
+		uint32_t deadB = AddTestPass(compiler, "DeadB", { { chainA, NonPixelShaderResource }, { chainB, UnorderedAccess } });
+		uint32_t produce = AddTestPass(compiler, "Produce", { { readback, UnorderedAccess } });
+		uint32_t copy = AddTestPass(compiler, "Copy", { { readback, CopySource } }, true);
+		FGCompileResult result = compiler.Compile();
+		ExpectPasses(test, result, { produce, copy }, {
+			{ Transition(readback, Common, UnorderedAccess) },
+			{ Transition(readback, UnorderedAccess, CopySource) } });
+		test.Expect(result.PassCulled[dead] && result.PassCulled[deadA] && result.PassCulled[deadB], "没有副作用的pass没被剔除");
+		test.Expect(result.ResourceCulled[unused] && result.ResourceCulled[chainA] && result.ResourceCulled[chainB] &&
+			!result.ResourceCulled[readback], "ResourceCulled不对");
+		test.Expect(result.PhysicalSlot[unused] == FGInvalidIndex, "被剔除的资源不应该有slot");
+		CheckInvariants(test, compiler, result);
+		AddResult(report, test, compiler, result);
+	}
+
+	//别名：A[0,1] B[1,2] C[2,3]同一个AliasKey，A和C共用slot 0；E的key不同，生命周期[3,3]放在B的内存上
+	{
+		TestCase test(report, "AliasSlots");
+		FrameGraphCompiler compiler;
+		const uint64_t size = 65536;
+		uint32_t output = AddTestImported(compiler, "Output", Common, Keep);
+		uint32_t a = AddTestResource(compiler, "A", 1, size);
+		uint32_t b = AddTestResource(compiler, "B", 1, size);
+		uint32_t c = AddTestResource(compiler, "C", 1, size);
+		uint32_t e = AddTestResource(compiler, "E", 2, size);
+		uint32_t p0 = AddTestPass(compiler, "P0", { { a, RenderTarget } });
+		uint32_t p1 = AddTestPass(compiler, "P1", { { a, PixelShaderResource }, { b, RenderTarget } });
+		uint32_t p2 = AddTestPass(compiler, "P2", { { b, PixelShaderResource }, { c, RenderTarget } });
+		uint32_t p3 = AddTestPass(compiler, "P3", { { c, PixelShaderResource }, { e, UnorderedAccess }, { output, RenderTarget } });
+		FGCompileResult result = compiler.Compile();
+
+		test.Expect(result.PhysicalSlot[a] == 0 && result.PhysicalSlot[b] == 1 && result.PhysicalSlot[c] == 0 && result.PhysicalSlot[e] == 2,
+			"slot分配不对");
+		test.Expect(result.SlotOrdinal == std::vector<uint32_t>({ 0, 1, 0 }), "SlotOrdinal不对");
+		test.Expect(result.HeapSize.size() == 1 && result.HeapSize[0] == 2 * size, "堆大小应该是两个资源");
+		test.Expect(result.TransientTotalSize == 3 * size, "不做别名时的大小应该是三个slot");
+		test.Expect(result.SlotHeapOffset[2] == result.SlotHeapOffset[1], "E应该放在B的内存上");
+
+		//C复用A的slot，状态接着A的PixelShaderResource
+		ExpectPasses(test, result, { p0, p1, p2, p3 }, {
+			{ AliasingBarrier(a, FGInvalidIndex), Transition(a, Common, RenderTarget) },
+			{ AliasingBarrier(b, FGInvalidIndex), Transition(a, RenderTarget, PixelShaderResource), Transition(b, Common, RenderTarget) },
+			{ Transition(b, RenderTarget, PixelShaderResource), Transition(c, PixelShaderResource, RenderTarget) },
+			{ AliasingBarrier(e, b), Transition(c, RenderTarget, PixelShaderResource), Transition(e, Common, UnorderedAccess),
+				Transition(output, Common, RenderTarget) } });
+		CheckInvariants(test, compiler, result);
+		AddResult(report, test, compiler, result);
+	}
+
+	//UAV：连续写同一个UAV之间是UAV屏障；之后的几次读合并成一个组合读状态
+	{
+		TestCase test(report, "UavAndReadCombine");
+		FrameGraphCompiler compiler;
+		uint32_t first = AddTestImported(compiler, "First", Common, PixelShaderResource);
+		uint32_t second = AddTestImported(compiler, "Second", Common, Keep);
+		uint32_t buffer = AddTestResource(compiler, "Buffer");
+		uint32_t passA = AddTestPass(compiler, "WriteA", { { buffer, UnorderedAccess } });
+		uint32_t passB = AddTestPass(compiler, "WriteB", { { buffer, UnorderedAccess } });
+		uint32_t readPixel = AddTestPass(compiler, "ReadPixel", { { buffer, PixelShaderResource }, { first, UnorderedAccess } });
+		uint32_t readCompute = AddTestPass(compiler, "ReadCompute", { { buffer, NonPixelShaderResource }, { second, RenderTarget } });
+		FGCompileResult result = compiler.Compile();
+		ExpectPasses(test, result, { passA, passB, readPixel, readCompute }, {
+			{ Transition(buffer, Common, UnorderedAccess) },
+			{ UavBarrier(buffer) },
+			{ Transition(buffer, UnorderedAccess, PixelShaderResource | NonPixelShaderResource), Transition(first, Common, UnorderedAccess) },
+			{ Transition(second, Common, RenderTarget) } });
+		ExpectBarriers(test, "帧末", result.FinalBarriers, { Transition(first, UnorderedAccess, PixelShaderResource) });
+		CheckInvariants(test, compiler, result);
+		AddResult(report, test, compiler, result);
+	}
+
+	//随机图只检查不变量
+	{
+		TestCase test(report, "RandomGraphs");
+		std::mt19937 rng(2801);
+		FrameGraphCompiler compiler;
+		FGCompileResult result;
+		for (uint32_t i = 0; i < 2000 && test.Passed(); ++i)
+		{
+			compiler.Clear();
+			BuildRandomGraph(compiler, rng);
+			result = compiler.Compile();
+			CheckInvariants(test, compiler, result);
+		}
+		AddResult(report, test, compiler, result);
+	}
+
+	return report.Finish();
+}
+
+}
@@ -0,0 +1,248 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/GpuTimestampRing.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <random>
+
+namespace Soco
+{
+
+namespace
+{
+
+// 假的GPU：帧执行完时把时间戳写进这帧的slot，读回时直接拷贝，和readback buffer一样会被后来的帧覆盖
+class FakeTimestampSource : public TimestampSource
+{
+public:
+	std::vector<std::vector<uint64_t>> Slots;
+
+	void ReadTimestamps(uint32_t frameSlot, uint32_t count, uint64_t* timestamps) override
+	{
+		std::copy(Slots[frameSlot].begin(), Slots[frameSlot].begin() + count, timestamps);
+	}
+};
+
+struct TimestampRingCase
+{
+	const char* Name;
+	uint32_t Frames;
+	uint32_t FrameSlots;
+	uint32_t MaxZones;
+	// 每帧[MinZones, MinZones + ZoneSpread]个zone，超过MaxZones的被丢掉
+	uint32_t MinZones;
+	uint32_t ZoneSpread;
+	// GPU落后CPU最多几帧(不超过FrameSlots，CPU复用slot前会等)
+	uint32_t MaxLatency;
+	// 每几帧Collect一次，大于1时slot会在读回之前被复用
+	uint32_t CollectInterval;
+	uint64_t Frequency;
+	uint64_t GpuTimestamp;
+	uint64_t CpuTime;
+	// 每帧开始时间相对校准点的偏移(ns)，可以是负的(GPU时钟在校准点之前)
+	int64_t StartNs;
+	// 每隔几帧让一个zone的结束早于开始，0表示不测
+	uint32_t ReversedZoneInterval;
+};
+
+struct ExpectedFrame
+{
+	uint32_t Slot = 0;
+	std::vector<GpuZoneTiming> Zones;
+	std::vector<uint64_t> Timestamps;
+};
+
+uint64_t GreatestCommonDivisor(uint64_t a, uint64_t b)
+{
+	while (b != 0)
+	{
+		uint64_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+}
+
+bool RunGpuTimestampRingHarness(const std::string& path)
+{
+	const TimestampRingCase cases[] = {
+		{ "Steady", 600, 3, 16, 1, 7, 2, 1, 10000000, 5000000, 1000000000ull, 0, 0 },
+		{ "EmptyFrames", 600, 3, 16, 0, 2, 2, 1, 10000000, 5000000, 1000000000ull, 0, 0 },
+		{ "LateReadback", 600, 3, 16, 1, 7, 2, 5, 10000000, 5000000, 1000000000ull, 0, 0 },
+		{ "SlotWraparound", 5000, 2, 8, 1, 7, 2, 3, 1000000000, 0, 0, 0, 0 },
+		{ "ZoneOverflow", 300, 3, 8, 6, 20, 1, 1, 10000000, 5000000, 1000000000ull, 0, 0 },
+		//2^62附近的时钟，24MHz，每帧离校准点约一小时：tick * 1e9会溢出64位
+		{ "LargeTimestamps", 300, 3, 16, 1, 7, 2, 1, 24000000, 1ull << 62, 1ull << 60, 3600000000000ll, 0 },
+		//GPU时钟在校准点之前，以及结束早于开始的zone
+		{ "BeforeCalibration", 300, 3, 16, 1, 7, 2, 1, 19200000, 1ull << 40, 1ull << 50, -3600000000000ll, 7 },
+	};
+
+	TestReport report("GpuTimestampRing", path, "Frames,FrameSlots,MaxZones,Collected,DroppedFrames,DroppedZones");
+
+	for (const TimestampRingCase& ringCase : cases)
+	{
+		TestCase test(report, ringCase.Name);
+
+		GpuTimestampRing ring;
+		ring.Initialize(ringCase.FrameSlots, ringCase.MaxZones);
+		FakeTimestampSource source;
+		source.Slots.assign(ringCase.FrameSlots, std::vector<uint64_t>(ring.GetQueriesPerFrame(), 0));
+		GpuClockCalibration clock;
+		clock.Frequency = ringCase.Frequency;
+		clock.GpuTimestamp = ringCase.GpuTimestamp;
+		clock.CpuTime = ringCase.CpuTime;
+
+		//GPU时间只取能整除换算的单位：unitTicks个tick正好是unitNs纳秒，期望值不经过被测的换算
+		const uint64_t divisor = GreatestCommonDivisor(ringCase.Frequency, 1000000000ull);
+		const int64_t unitTicks = (int64_t)(ringCase.Frequency / divisor);
+		const int64_t unitNs = (int64_t)(1000000000ull / divisor);
+
+		std::mt19937 rng(3201);
+		std::map<uint64_t, ExpectedFrame> expected;
+		// 已经提交、还没读回的帧，按slot
+		std::vector<uint64_t> pendingInSlot(ringCase.FrameSlots, UINT64_MAX);
+		uint64_t completedFence = 0;
+		uint64_t lastCollected = UINT64_MAX;
+		uint64_t collectedFrames = 0, expectedDroppedFrames = 0, expectedDroppedZones = 0;
+
+		auto completeUpTo = [&](uint64_t fence) {
+			//fence = frame + 1，GPU按顺序执行完把时间戳写进slot
+			for (; completedFence < fence; ++completedFence)
+			{
+				auto ite = expected.find(completedFence);
+				if (ite != expected.end())
+					std::copy(ite->second.Timestamps.begin(), ite->second.Timestamps.end(), source.Slots[ite->second.Slot].begin());
+			}
+		};
+		auto collect = [&]() {
+			for (GpuFrameTimings& frame : ring.Collect(completedFence, source, clock))
+			{
+				auto ite = expected.find(frame.FrameIndex);
+				if (ite == expected.end())
+				{
+					test.Fail("读回了没有zone或者已经丢弃的帧" + std::to_string(frame.FrameIndex));
+					continue;
+				}
+				if (lastCollected != UINT64_MAX && frame.FrameIndex <= lastCollected)
+					test.Fail("读回的帧没有按顺序");
+				if (frame.FrameIndex >= completedFence)
+					test.Fail("读回了GPU还没执行完的帧");
+				lastCollected = frame.FrameIndex;
+
+				const std::vector<GpuZoneTiming>& zones = ite->second.Zones;
+				if (frame.Zones.size() != zones.size())
+					test.Fail("第" + std::to_string(frame.FrameIndex) + "帧的zone数量不对");
+				for (size_t z = 0; z < std::min(zones.size(), frame.Zones.size()); ++z)
+				{
+					if (frame.Zones[z].Name != zones[z].Name)
+						test.Fail("zone名称不对：" + frame.Zones[z].Name);
+					if (frame.Zones[z].Begin != zones[z].Begin || frame.Zones[z].End != zones[z].End)
+						test.Fail("zone " + zones[z].Name + "换算到CPU时间不对：" + std::to_string(frame.Zones[z].Begin) + "~" +
+							std::to_string(frame.Zones[z].End) + "，应该是" + std::to_string(zones[z].Begin) + "~" + std::to_string(zones[z].End));
+				}
+				pendingInSlot[ite->second.Slot] = UINT64_MAX;
+				expected.erase(ite);
+				++collectedFrames;
+			}
+		};
+
+		for (uint64_t frame = 0; frame < ringCase.Frames; ++frame)
+		{
+			const uint32_t slot = (uint32_t)(frame % ringCase.FrameSlots);
+			//复用slot之前CPU等GPU执行完这个slot上一次的帧
+			if (frame >= ringCase.FrameSlots)
+				completeUpTo(frame - ringCase.FrameSlots + 1);
+			if (frame % ringCase.CollectInterval == 0)
+				collect();
+
+			//这个slot上还没读回的帧会被覆盖
+			if (pendingInSlot[slot] != UINT64_MAX)
+			{
+				expected.erase(pendingInSlot[slot]);
+				pendingInSlot[slot] = UINT64_MAX;
+				++expectedDroppedFrames;
+			}
+
+			ring.BeginFrame(frame, slot);
+			const uint32_t zoneCount = ringCase.MinZones + rng() % (ringCase.ZoneSpread + 1);
+			ExpectedFrame frameExpected;
+			frameExpected.Slot = slot;
+			frameExpected.Timestamps.assign(ring.GetQueriesPerFrame(), 0);
+			//每帧在GPU时间上相隔约16ms，zone依次排开
+			int64_t units = (ringCase.StartNs + (int64_t)frame * 16000000) / unitNs;
+			for (uint32_t z = 0; z < zoneCount; ++z)
+			{
+				const std::string name = "Pass" + std::to_string(z);
+				const uint32_t zone = ring.BeginZone(name);
+				if (z >= ringCase.MaxZones)
+				{
+					if (zone != GpuTimestampRing::InvalidZone)
+						test.Fail("超过上限的zone没有返回InvalidZone");
+					++expectedDroppedZones;
+					continue;
+				}
+				if (zone != z)
+				{
+					test.Fail("zone编号不对");
+					continue;
+				}
+
+				const int64_t beginUnits = units + 1 + rng() % 10;
+				int64_t endUnits = beginUnits + rng() % 1000;
+				const bool reversed = ringCase.ReversedZoneInterval != 0 && z == 0 && frame % ringCase.ReversedZoneInterval == 0;
+				if (reversed)
+					endUnits = beginUnits - 5;
+				units = std::max(beginUnits, endUnits);
+
+				frameExpected.Timestamps[GpuTimestampRing::BeginQueryIndex(zone)] = ringCase.GpuTimestamp + beginUnits * unitTicks;
+				frameExpected.Timestamps[GpuTimestampRing::EndQueryIndex(zone)] = ringCase.GpuTimestamp + endUnits * unitTicks;
+
+				GpuZoneTiming timing;
+				timing.Name = name;
+				timing.Begin = ringCase.CpuTime + beginUnits * unitNs;
+				timing.End = reversed ? timing.Begin : ringCase.CpuTime + endUnits * unitNs;
+				frameExpected.Zones.push_back(timing);
+			}
+
+			const uint32_t usedZones = std::min(zoneCount, ringCase.MaxZones);
+			if (ring.GetUsedQueryCount() != usedZones * 2)
+				test.Fail("GetUsedQueryCount不对");
+			ring.EndFrame(frame + 1);
+			if (usedZones > 0)
+			{
+				expected[frame] = std::move(frameExpected);
+				pendingInSlot[slot] = frame;
+			}
+
+			//GPU随机落后0~MaxLatency帧
+			const uint64_t latency = rng() % (ringCase.MaxLatency + 1);
+			if (frame + 1 >= latency)
+				completeUpTo(frame + 1 - latency);
+		}
+
+		//GPU空闲后剩下的帧都能读回
+		completeUpTo(ringCase.Frames);
+		collect();
+		if (!expected.empty())
+			test.Fail(std::to_string(expected.size()) + "帧既没有读回也没有丢弃");
+		if (ring.GetPendingFrameCount() != 0)
+			test.Fail("GPU空闲后还有未读回的帧");
+		if (ring.GetDroppedFrameCount() != expectedDroppedFrames)
+			test.Fail("丢弃的帧数是" + std::to_string(ring.GetDroppedFrameCount()) + "，应该是" + std::to_string(expectedDroppedFrames));
+		if (ring.GetDroppedZoneCount() != expectedDroppedZones)
+			test.Fail("丢弃的zone数量不对");
+
+		report.Add(test, ringCase.Frames, ringCase.FrameSlots, ringCase.MaxZones, collectedFrames, ring.GetDroppedFrameCount(),
+			ring.GetDroppedZoneCount());
+		std::cout << ringCase.Name << "：" << ringCase.Frames << "帧，读回" << collectedFrames << "帧，丢弃" << ring.GetDroppedFrameCount()
+			<< "帧、" << ring.GetDroppedZoneCount() << "个zone，" << (test.Passed() ? "通过" : "失败") << std::endl;
+	}
+
+	return report.Finish();
+}
+
+}
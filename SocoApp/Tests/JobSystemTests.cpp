@@ -0,0 +1,130 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace Soco
+{
+
+namespace
+{
+
+using BenchClock = std::chrono::high_resolution_clock;
+
+double ElapsedMicroseconds(BenchClock::time_point start)
+{
+	return std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+}
+
+//每个元素迭代若干次，结果只取决于下标，并行和串行的结果逐位相同
+float ParallelForWork(size_t i)
+{
+	float x = (float)(i % 1024) * (1.0f / 1024.0f);
+	for (int k = 0; k < 64; ++k)
+		x = x * x * 0.5f + 0.25f;
+	return x;
+}
+
+}
+
+bool RunJobSystemBenchmark(const std::string& path)
+{
+	JobSystem* jobSystem = JobSystem::GetInstance();
+	const uint32_t originalThreads = jobSystem->GetThreadCount();
+	const uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	const uint32_t latencyIterations = 20000;
+	const uint32_t batchJobs = 100000;
+	const size_t elementCount = 1 << 20;
+	const size_t grainSize = 4096;
+	const int repeats = 5;
+
+	std::vector<float> reference(elementCount);
+	for (size_t i = 0; i < elementCount; ++i)
+		reference[i] = ParallelForWork(i);
+	std::vector<float> results(elementCount);
+
+	TestReport report("JobSystem", path, "Threads,RunWaitUs,BatchJobNs,WakeLatencyUs,ParallelForMs,Speedup,Efficiency");
+
+	double singleThreadMs = 0.0;
+	for (uint32_t threads = 1; threads <= maxThreads; ++threads)
+	{
+		jobSystem->Initialize(threads);
+		TestCase test(report, "Threads" + std::to_string(threads));
+		test.Expect(jobSystem->GetThreadCount() == threads, "线程数不对");
+		std::atomic<uint32_t> executed = 0;
+
+		//Run后马上Wait，job通常由主线程自己执行，测量的是调度本身的开销
+		auto start = BenchClock::now();
+		for (uint32_t i = 0; i < latencyIterations; ++i)
+		{
+			JobCounter counter;
+			jobSystem->Run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+			jobSystem->Wait(counter);
+		}
+		const double runWaitUs = ElapsedMicroseconds(start) / latencyIterations;
+
+		//一次提交一批，工作线程一起偷
+		start = BenchClock::now();
+		{
+			JobCounter counter;
+			for (uint32_t i = 0; i < batchJobs; ++i)
+				jobSystem->Run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+			jobSystem->Wait(counter);
+		}
+		const double batchJobNs = ElapsedMicroseconds(start) * 1000.0 / batchJobs;
+
+		//主线程只等不执行，job一定由工作线程取走，包括唤醒睡眠线程的时间；单线程时没有意义
+		double wakeLatencyUs = 0.0;
+		if (threads > 1)
+		{
+			const uint32_t wakeIterations = latencyIterations / 10;
+			start = BenchClock::now();
+			for (uint32_t i = 0; i < wakeIterations; ++i)
+			{
+				JobCounter counter;
+				jobSystem->Run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+				while (!counter.IsDone())
+					std::this_thread::yield();
+			}
+			wakeLatencyUs = ElapsedMicroseconds(start) / wakeIterations;
+			test.Expect(executed.load() == latencyIterations + batchJobs + wakeIterations, "执行的job数量不对");
+		}
+		else
+		{
+			test.Expect(executed.load() == latencyIterations + batchJobs, "执行的job数量不对");
+		}
+
+		//取几次中最快的一次
+		double parallelForMs = 0.0;
+		for (int r = 0; r < repeats; ++r)
+		{
+			std::fill(results.begin(), results.end(), 0.0f);
+			start = BenchClock::now();
+			jobSystem->ParallelFor(0, elementCount, grainSize, [&results](size_t first, size_t last) {
+				for (size_t i = first; i < last; ++i)
+					results[i] = ParallelForWork(i);
+			});
+			const double ms = ElapsedMicroseconds(start) / 1000.0;
+			parallelForMs = r == 0 ? ms : std::min(parallelForMs, ms);
+			test.Expect(results == reference, "ParallelFor的结果和串行计算不同");
+		}
+		if (threads == 1)
+			singleThreadMs = parallelForMs;
+		const double speedup = parallelForMs > 0.0 ? singleThreadMs / parallelForMs : 0.0;
+
+		report.Add(test, threads, runWaitUs, batchJobNs, wakeLatencyUs, parallelForMs, speedup, speedup / threads);
+		std::cout << threads << "个线程：Run+Wait " << runWaitUs << "us，批量每个job " << batchJobNs << "ns，唤醒延迟"
+			<< wakeLatencyUs << "us，ParallelFor " << parallelForMs << "ms(" << speedup << "倍)，"
+			<< (test.Passed() ? "通过" : "失败") << std::endl;
+	}
+
+	jobSystem->Initialize(originalThreads);
+	return report.Finish();
+}
+
+}
@@ -0,0 +1,60 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/MeshOptimizer.h"
+
+#include <iomanip>
+#include <iostream>
+
+using MeshData = GeometryGenerator::MeshData;
+
+namespace Soco
+{
+
+bool RunMeshOptimizationReport(const std::string& path)
+{
+	GeometryGenerator geoGen;
+	std::pair<const char*, MeshData> meshes[] =
+	{
+		{ "Box3", geoGen.CreateBox(8.0f, 8.0f, 8.0f, 3) },
+		{ "Sphere20", geoGen.CreateSphere(1.0f, 20, 20) },
+		{ "Sphere64", geoGen.CreateSphere(1.0f, 64, 64) },
+		{ "Geosphere3", geoGen.CreateGeosphere(1.0f, 3) },
+		{ "Geosphere5", geoGen.CreateGeosphere(1.0f, 5) },
+		{ "Cylinder", geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20) },
+		{ "Grid64", geoGen.CreateGrid(10.0f, 10.0f, 64, 64) },
+	};
+
+	TestReport report("MeshOptimization", path, "Triangles,Vertices,OptimizedVertices,Acmr,OptimizedAcmr,Atvr,OptimizedAtvr");
+
+	std::cout << std::fixed << std::setprecision(3);
+	for (auto& [name, mesh] : meshes)
+	{
+		TestCase test(report, name);
+		const size_t vertexCount = mesh.Vertices.size();
+		const size_t triangleCount = mesh.Indices32.size() / 3;
+		VertexCacheStats before = AnalyzeVertexCache(mesh.Indices32, vertexCount);
+
+		OptimizeMesh(mesh);
+		VertexCacheStats after = AnalyzeVertexCache(mesh.Indices32, mesh.Vertices.size());
+
+		//三角形不能丢，合并和重排后顶点只会变少，索引都在范围内
+		test.Expect(mesh.Indices32.size() / 3 == triangleCount, "三角形数量变了");
+		test.Expect(mesh.Vertices.size() <= vertexCount, "顶点变多了");
+		for (uint32_t index : mesh.Indices32)
+		{
+			if (!test.Expect(index < mesh.Vertices.size(), "索引超出顶点范围"))
+				break;
+		}
+		//overdraw排序允许ACMR比缓存优化的结果差5%，但不应该比原来的顺序差
+		test.Expect(after.Acmr <= before.Acmr, "ACMR变差了");
+
+		report.Add(test, triangleCount, vertexCount, mesh.Vertices.size(), before.Acmr, after.Acmr, before.Atvr, after.Atvr);
+		std::cout << name << "：顶点 " << vertexCount << " -> " << mesh.Vertices.size()
+			<< "，ACMR " << before.Acmr << " -> " << after.Acmr
+			<< "，ATVR " << before.Atvr << " -> " << after.Atvr << std::endl;
+	}
+	std::cout << std::defaultfloat;
+	return report.Finish();
+}
+
+}
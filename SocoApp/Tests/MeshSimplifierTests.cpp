@@ -0,0 +1,72 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/MeshSimplifier.h"
+#include "Soco/Util/MeshOptimizer.h"
+#include "Soco/Util/Profiler.h"
+
+#include <cmath>
+#include <iostream>
+
+namespace Soco
+{
+
+bool RunSimplifierBenchmark(const std::string& path)
+{
+	TestReport report("Simplifier", path, "Triangles,SimplifyMs,Error,MeasuredError");
+
+	GeometryGenerator geoGen;
+	std::vector<std::pair<std::string, GeometryGenerator::MeshData>> meshes;
+	meshes.emplace_back("Sphere20", geoGen.CreateSphere(1.0f, 20, 20));
+	meshes.emplace_back("Sphere40", geoGen.CreateSphere(1.0f, 40, 40));
+	meshes.emplace_back("Sphere100", geoGen.CreateSphere(1.0f, 100, 100));
+	meshes.emplace_back("Geosphere5", geoGen.CreateGeosphere(1.0f, 5));
+	meshes.emplace_back("Box3", geoGen.CreateBox(1.0f, 1.0f, 1.0f, 3));
+	//起伏的地形网格，有开放边界
+	GeometryGenerator::MeshData grid = geoGen.CreateGrid(2.0f, 2.0f, 128, 128);
+	for (GeometryGenerator::Vertex& v : grid.Vertices)
+		v.Position.y = 0.1f * std::sin(v.Position.x * 5.0f) * std::cos(v.Position.z * 4.0f);
+	meshes.emplace_back("Grid128", std::move(grid));
+
+	for (auto& [name, mesh] : meshes)
+	{
+		OptimizeMesh(mesh);
+		const float* positions = &mesh.Vertices[0].Position.x;
+		const size_t stride = sizeof(GeometryGenerator::Vertex);
+		const size_t vertexCount = mesh.Vertices.size();
+
+		report.Add(TestCase(report, name + ".LOD0"), mesh.Indices32.size() / 3, 0, 0, 0);
+
+		uint64_t begin = Profiler::Now();
+		std::vector<MeshLodLevel> levels = BuildLodChain(mesh.Indices32.data(), mesh.Indices32.size(), positions, vertexCount, stride, 6);
+		const double chainMs = (Profiler::Now() - begin) * 1e-6;
+
+		size_t previousTriangles = mesh.Indices32.size() / 3;
+		for (size_t i = 0; i < levels.size(); ++i)
+		{
+			TestCase test(report, name + ".LOD" + std::to_string(i + 1));
+
+			//单独计时每一级：每一级都从原网格简化
+			begin = Profiler::Now();
+			SimplifyMesh(mesh.Indices32.data(), mesh.Indices32.size(), positions, vertexCount, stride, levels[i].Indices.size(), 1e30f);
+			const double simplifyMs = (Profiler::Now() - begin) * 1e-6;
+
+			float measured = MeasureSimplificationError(mesh.Indices32.data(), mesh.Indices32.size(),
+				levels[i].Indices.data(), levels[i].Indices.size(), positions, vertexCount, stride);
+			test.Expect(CheckSimplificationError(mesh.Indices32.data(), mesh.Indices32.size(), levels[i], positions, vertexCount, stride),
+				"实测误差超出上限");
+			//每一级都要比上一级少
+			const size_t triangles = levels[i].Indices.size() / 3;
+			test.Expect(triangles < previousTriangles, "三角形没有比上一级少");
+			previousTriangles = triangles;
+
+			report.Add(test, triangles, simplifyMs, levels[i].Error, measured);
+			std::cout << name << " LOD" << i + 1 << "：" << triangles << "个三角形，简化" << simplifyMs << "ms，误差"
+				<< levels[i].Error << "，实测" << measured << std::endl;
+		}
+		std::cout << name << "：" << mesh.Indices32.size() / 3 << "个三角形，" << levels.size() << "级LOD，共" << chainMs << "ms" << std::endl;
+	}
+
+	return report.Finish();
+}
+
+}
@@ -0,0 +1,209 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/Meshlet.h"
+#include "Soco/Util/MeshOptimizer.h"
+#include "Soco/Util/Profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+
+namespace Soco
+{
+
+namespace
+{
+
+struct Vec3
+{
+	float x = 0, y = 0, z = 0;
+
+	Vec3() = default;
+	Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+	explicit Vec3(const float* p) : x(p[0]), y(p[1]), z(p[2]) {}
+
+	Vec3 operator- (const Vec3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+	Vec3 operator* (float s) const { return { x * s, y * s, z * s }; }
+	float Dot(const Vec3& o) const { return x * o.x + y * o.y + z * o.z; }
+	Vec3 Cross(const Vec3& o) const { return { y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x }; }
+	float Length() const { return std::sqrt(Dot(*this)); }
+	Vec3 Normalized() const { float l = Length(); return l > 0 ? *this * (1.0f / l) : *this; }
+};
+
+// 行向量约定的LH观察和投影矩阵
+void LookAtPerspective(const Vec3& eye, const Vec3& at, float fovY, float aspect, float nearZ, float farZ, float viewProj[16])
+{
+	Vec3 z = (at - eye).Normalized();
+	Vec3 up = std::abs(z.y) > 0.99f ? Vec3(0, 0, 1) : Vec3(0, 1, 0);
+	Vec3 x = up.Cross(z).Normalized();
+	Vec3 y = z.Cross(x);
+
+	const float view[16] =
+	{
+		x.x, y.x, z.x, 0,
+		x.y, y.y, z.y, 0,
+		x.z, y.z, z.z, 0,
+		-x.Dot(eye), -y.Dot(eye), -z.Dot(eye), 1,
+	};
+
+	const float h = 1.0f / std::tan(fovY * 0.5f);
+	const float w = h / aspect;
+	const float range = farZ / (farZ - nearZ);
+	const float proj[16] =
+	{
+		w, 0, 0, 0,
+		0, h, 0, 0,
+		0, 0, range, 1,
+		0, 0, -nearZ * range, 0,
+	};
+
+	for (int r = 0; r < 4; ++r)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			float sum = 0;
+			for (int k = 0; k < 4; ++k)
+				sum += view[r * 4 + k] * proj[k * 4 + c];
+			viewProj[r * 4 + c] = sum;
+		}
+	}
+}
+
+// 网格的三角形排序后和meshlet里的三角形比较，检查每个三角形恰好出现一次且绕序不变
+const char* CheckMeshletTriangles(const MeshletSet& set, const std::vector<uint32_t>& indices)
+{
+	//把三角形旋转到最小的顶点在前，绕序不变
+	auto canonical = [](uint32_t a, uint32_t b, uint32_t c) -> std::array<uint32_t, 3> {
+		if (a <= b && a <= c)
+			return { a, b, c };
+		if (b <= a && b <= c)
+			return { b, c, a };
+		return { c, a, b };
+	};
+
+	std::vector<std::array<uint32_t, 3>> expected, actual;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		expected.push_back(canonical(indices[i], indices[i + 1], indices[i + 2]));
+
+	for (const Meshlet& meshlet : set.Meshlets)
+	{
+		if (meshlet.VertexCount > MaxMeshletVertices || meshlet.TriangleCount > MaxMeshletTriangles)
+			return "meshlet超过顶点或三角形上限";
+		for (uint32_t t = 0; t < meshlet.TriangleCount; ++t)
+		{
+			uint32_t corners[3];
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				uint8_t local = set.Triangles[(meshlet.TriangleOffset + t) * 3 + corner];
+				if (local >= meshlet.VertexCount)
+					return "局部顶点序号超出meshlet的顶点数";
+				corners[corner] = set.Vertices[meshlet.VertexOffset + local];
+			}
+			actual.push_back(canonical(corners[0], corners[1], corners[2]));
+		}
+	}
+
+	std::sort(expected.begin(), expected.end());
+	std::sort(actual.begin(), actual.end());
+	return expected == actual ? nullptr : "meshlet里的三角形和网格不一致";
+}
+
+// 被剔除的meshlet里每个三角形都必须是背面，或者三个顶点都在同一个视锥平面外侧
+bool IsCullingConservative(const MeshletSet& set, const MeshletCullParams& camera, const GeometryGenerator::MeshData& mesh)
+{
+	const Vec3 eye(camera.CameraPosition);
+	for (size_t m = 0; m < set.Meshlets.size(); ++m)
+	{
+		if (!IsMeshletCulled(set.Bounds[m], camera))
+			continue;
+
+		const Meshlet& meshlet = set.Meshlets[m];
+		for (uint32_t t = 0; t < meshlet.TriangleCount; ++t)
+		{
+			Vec3 p[3];
+			for (int corner = 0; corner < 3; ++corner)
+				p[corner] = Vec3(&mesh.Vertices[set.Vertices[meshlet.VertexOffset + set.Triangles[(meshlet.TriangleOffset + t) * 3 + corner]]].Position.x);
+
+			const Vec3 normal = (p[1] - p[0]).Cross(p[2] - p[0]).Normalized();
+			if (normal.Dot((p[0] - eye).Normalized()) >= -1e-4f)
+				continue;
+
+			bool outside = false;
+			for (int i = 0; i < 6 && !outside; ++i)
+			{
+				const float* plane = camera.FrustumPlanes[i];
+				outside = true;
+				for (int corner = 0; corner < 3; ++corner)
+					outside = outside && p[corner].Dot(Vec3(plane)) + plane[3] < 0;
+			}
+			if (!outside)
+				return false;
+		}
+	}
+	return true;
+}
+
+}
+
+bool RunMeshletBenchmark(const std::string& path)
+{
+	TestReport report("Meshlets", path, "Triangles,Meshlets,AvgVertices,AvgTriangles,BuildMs,CullUs,VisibleTriangleRatio");
+
+	//相机绕球一圈，远近交替：远处主要是锥剔除，近处视锥也能剔掉一部分
+	const int cameraCount = 64;
+	std::vector<MeshletCullParams> cameras(cameraCount);
+	for (int i = 0; i < cameraCount; ++i)
+	{
+		const float angle = i * 6.2831853f / cameraCount;
+		const float distance = i % 2 == 0 ? 4.0f : 1.5f;
+		Vec3 eye(distance * std::cos(angle), 0.5f * std::sin(angle * 3), distance * std::sin(angle));
+
+		float viewProj[16];
+		LookAtPerspective(eye, Vec3(), 0.25f * 3.1415926f, 16.0f / 9.0f, 0.1f, 100.0f, viewProj);
+		ExtractFrustumPlanes(viewProj, cameras[i].FrustumPlanes);
+		cameras[i].CameraPosition[0] = eye.x;
+		cameras[i].CameraPosition[1] = eye.y;
+		cameras[i].CameraPosition[2] = eye.z;
+	}
+
+	GeometryGenerator geoGen;
+	//GeometryGenerator最多细分6次
+	for (uint32_t subdivisions = 2; subdivisions <= 6; ++subdivisions)
+	{
+		GeometryGenerator::MeshData mesh = geoGen.CreateGeosphere(1.0f, subdivisions);
+		OptimizeMesh(mesh);
+
+		const int buildRuns = 5;
+		MeshletSet set;
+		uint64_t begin = Profiler::Now();
+		for (int i = 0; i < buildRuns; ++i)
+			set = BuildMeshlets(mesh.Indices32.data(), mesh.Indices32.size(), &mesh.Vertices[0].Position.x,
+				mesh.Vertices.size(), sizeof(GeometryGenerator::Vertex));
+		const double buildMs = (Profiler::Now() - begin) * 1e-6 / buildRuns;
+
+		std::vector<uint32_t> culled(set.TriangleCount * 3);
+		uint64_t visibleIndices = 0;
+		begin = Profiler::Now();
+		for (const MeshletCullParams& camera : cameras)
+			visibleIndices += CullMeshlets(set, camera, culled.data());
+		const double cullUs = (Profiler::Now() - begin) * 1e-3 / cameraCount;
+
+		const double avgVertices = (double)set.Vertices.size() / set.Meshlets.size();
+		const double avgTriangles = (double)set.TriangleCount / set.Meshlets.size();
+		const double visibleRatio = (double)visibleIndices / cameraCount / (set.TriangleCount * 3);
+
+		TestCase test(report, "Geosphere" + std::to_string(subdivisions));
+		if (const char* error = CheckMeshletTriangles(set, mesh.Indices32))
+			test.Fail(error);
+		for (int i = 0; i < cameraCount && test.Passed(); ++i)
+			test.Expect(IsCullingConservative(set, cameras[i], mesh), "相机" + std::to_string(i) + "剔除了可见的三角形");
+		report.Add(test, set.TriangleCount, set.Meshlets.size(), avgVertices, avgTriangles, buildMs, cullUs, visibleRatio);
+		std::cout << "Geosphere" << subdivisions << "：" << set.TriangleCount << "个三角形，" << set.Meshlets.size() << "个meshlet(平均"
+			<< avgVertices << "顶点/" << avgTriangles << "三角形)，构建" << buildMs << "ms，剔除" << cullUs << "us/次，剩余"
+			<< visibleRatio * 100 << "%三角形" << std::endl;
+	}
+	return report.Finish();
+}
+
+}
@@ -0,0 +1,319 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/MipChain.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace Soco
+{
+
+namespace
+{
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+const bool HasSse2 = true;
+#else
+const bool HasSse2 = false;
+#endif
+
+// 参考实现按定义计算，和MipChain.cpp里的常数相同
+const double Pi = 3.14159265358979323846;
+const double KaiserRadius = 3.0;
+const double KaiserAlpha = 4.0;
+
+double BesselI0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for (int k = 1; k < 64 && term > 1e-14 * sum; ++k)
+	{
+		const double half = x / (2.0 * k);
+		term *= half * half;
+		sum += term;
+	}
+	return sum;
+}
+
+// x以目标像素为单位
+double KaiserSinc(double x)
+{
+	if (std::abs(x) >= KaiserRadius)
+		return 0.0;
+	const double sinc = x == 0.0 ? 1.0 : std::sin(Pi * x) / (Pi * x);
+	const double r = x / KaiserRadius;
+	return sinc * BesselI0(KaiserAlpha * std::sqrt(1.0 - r * r)) / BesselI0(KaiserAlpha);
+}
+
+double SrgbToLinear(double c)
+{
+	return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+}
+
+double LinearToSrgb(double l)
+{
+	return l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+}
+
+/*
+参考实现：双精度，sRGB按公式转换，每个目标像素直接在二维足迹上求和
+Box/Min/Max的足迹是目标像素在源图像上覆盖的矩形，按重叠面积加权；Kaiser按定义逐个源像素求权重再整体归一化
+*/
+void DownsampleReference(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst, const MipChainOptions& options)
+{
+	const uint32_t dstWidth = std::max(1u, width / 2);
+	const uint32_t dstHeight = std::max(1u, height / 2);
+	const double scaleX = (double)width / dstWidth;
+	const double scaleY = (double)height / dstHeight;
+
+	auto decode = [&](uint32_t x, uint32_t y, int c) {
+		const double v = src[((size_t)y * width + x) * 4 + c] / 255.0;
+		return options.Srgb && c < 3 ? SrgbToLinear(v) : v;
+	};
+	auto address = [&](int64_t j, uint32_t n) {
+		return (uint32_t)(options.Wrap ? ((j % n) + n) % n : std::min<int64_t>(std::max<int64_t>(j, 0), n - 1));
+	};
+
+	for (uint32_t y = 0; y < dstHeight; ++y)
+	{
+		for (uint32_t x = 0; x < dstWidth; ++x)
+		{
+			double result[4] = { 0, 0, 0, 0 };
+			if (options.Filter == MipFilter::Kaiser)
+			{
+				const double centerX = (x + 0.5) * scaleX;
+				const double centerY = (y + 0.5) * scaleY;
+				const int64_t x0 = (int64_t)std::floor(centerX - KaiserRadius * scaleX) - 1;
+				const int64_t x1 = (int64_t)std::ceil(centerX + KaiserRadius * scaleX) + 1;
+				const int64_t y0 = (int64_t)std::floor(centerY - KaiserRadius * scaleY) - 1;
+				const int64_t y1 = (int64_t)std::ceil(centerY + KaiserRadius * scaleY) + 1;
+				double sum = 0;
+				for (int64_t sy = y0; sy <= y1; ++sy)
+				{
+					const double wy = KaiserSinc((sy + 0.5 - centerY) / scaleY);
+					for (int64_t sx = x0; sx <= x1; ++sx)
+					{
+						const double w = wy * KaiserSinc((sx + 0.5 - centerX) / scaleX);
+						if (w == 0)
+							continue;
+						sum += w;
+						for (int c = 0; c < 4; ++c)
+							result[c] += w * decode(address(sx, width), address(sy, height), c);
+					}
+				}
+				for (int c = 0; c < 4; ++c)
+					result[c] /= sum;
+			}
+			else
+			{
+				const double fx0 = x * scaleX, fx1 = (x + 1) * scaleX;
+				const double fy0 = y * scaleY, fy1 = (y + 1) * scaleY;
+				if (options.Filter == MipFilter::Min)
+					std::fill(result, result + 4, DBL_MAX);
+				else if (options.Filter == MipFilter::Max)
+					std::fill(result, result + 4, -DBL_MAX);
+				for (uint32_t sy = (uint32_t)fy0; sy < height && sy < fy1; ++sy)
+				{
+					const double overlapY = std::min<double>(sy + 1, fy1) - std::max<double>(sy, fy0);
+					for (uint32_t sx = (uint32_t)fx0; sx < width && sx < fx1; ++sx)
+					{
+						const double overlapX = std::min<double>(sx + 1, fx1) - std::max<double>(sx, fx0);
+						if (overlapX <= 0 || overlapY <= 0)
+							continue;
+						for (int c = 0; c < 4; ++c)
+						{
+							const double v = decode(sx, sy, c);
+							if (options.Filter == MipFilter::Min)
+								result[c] = std::min(result[c], v);
+							else if (options.Filter == MipFilter::Max)
+								result[c] = std::max(result[c], v);
+							else
+								result[c] += v * overlapX * overlapY / (scaleX * scaleY);
+						}
+					}
+				}
+			}
+
+			uint8_t* texel = dst + ((size_t)y * dstWidth + x) * 4;
+			for (int c = 0; c < 4; ++c)
+			{
+				double v = std::min(std::max(result[c], 0.0), 1.0);
+				if (options.Srgb && c < 3)
+					v = LinearToSrgb(v);
+				texel[c] = (uint8_t)std::floor(v * 255.0 + 0.5);
+			}
+		}
+	}
+}
+
+const char* FilterName(MipFilter filter)
+{
+	switch (filter)
+	{
+	case MipFilter::Box: return "Box";
+	case MipFilter::Kaiser: return "Kaiser";
+	case MipFilter::Min: return "Min";
+	case MipFilter::Max: return "Max";
+	}
+	return "Unknown";
+}
+
+// 噪声叠加渐变，同时覆盖高频和平滑区域
+std::vector<uint8_t> MakeTestImage(uint32_t width, uint32_t height, uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> noise(-48, 48);
+	std::vector<uint8_t> pixels((size_t)width * height * 4);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				const int base = (int)(255.0 * (c % 2 == 0 ? (x + 0.5) / width : (y + 0.5) / height));
+				pixels[((size_t)y * width + x) * 4 + c] = (uint8_t)std::min(std::max(base + noise(rng), 0), 255);
+			}
+		}
+	}
+	return pixels;
+}
+
+int MaxDifference(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+{
+	int maxDiff = 0;
+	for (size_t i = 0; i < a.size(); ++i)
+		maxDiff = std::max(maxDiff, std::abs((int)a[i] - (int)b[i]));
+	return maxDiff;
+}
+
+std::string CaseName(const MipChainOptions& options, uint32_t width, uint32_t height)
+{
+	return std::string(FilterName(options.Filter)) + (options.Srgb ? ".Srgb" : "") + (options.Wrap ? ".Wrap" : "")
+		+ "." + std::to_string(width) + "x" + std::to_string(height);
+}
+
+// 从第0级一直缩小到1x1的毫秒数
+double MeasureMipChain(const std::vector<uint8_t>& image, uint32_t width, uint32_t height, const MipChainOptions& options)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	std::vector<uint8_t> level = image;
+	while (width > 1 || height > 1)
+	{
+		std::vector<uint8_t> next((size_t)std::max(1u, width / 2) * std::max(1u, height / 2) * 4);
+		DownsampleRgba8(level.data(), width, height, next.data(), options);
+		level.swap(next);
+		width = std::max(1u, width / 2);
+		height = std::max(1u, height / 2);
+	}
+	const auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+}
+
+bool RunMipChainBenchmark(const std::string& path)
+{
+	TestReport report("MipChain", path, "Filter,Srgb,Wrap,Width,Height,MaxError,SimdMs,ScalarMs");
+
+	const MipFilter filters[] = { MipFilter::Box, MipFilter::Kaiser, MipFilter::Min, MipFilter::Max };
+
+	//和参考实现对比：奇偶宽高、只有一行或一列、比Kaiser足迹还小的图像
+	const uint32_t checkSizes[][2] = { { 64, 64 }, { 67, 33 }, { 31, 62 }, { 9, 1 }, { 1, 9 }, { 5, 5 }, { 2, 3 }, { 1, 1 } };
+	uint32_t checkCount = 0;
+	for (const auto& size : checkSizes)
+	{
+		const std::vector<uint8_t> image = MakeTestImage(size[0], size[1], size[0] * 131 + size[1]);
+		const size_t dstBytes = (size_t)std::max(1u, size[0] / 2) * std::max(1u, size[1] / 2) * 4;
+		for (MipFilter filter : filters)
+		{
+			for (int srgb = 0; srgb < 2; ++srgb)
+			{
+				for (int wrap = 0; wrap < (filter == MipFilter::Kaiser ? 2 : 1); ++wrap)
+				{
+					MipChainOptions options;
+					options.Filter = filter;
+					options.Srgb = srgb != 0;
+					options.Wrap = wrap != 0;
+
+					std::vector<uint8_t> reference(dstBytes), simd(dstBytes), scalar(dstBytes);
+					DownsampleReference(image.data(), size[0], size[1], reference.data(), options);
+					DownsampleRgba8(image.data(), size[0], size[1], simd.data(), options);
+					options.UseSimd = false;
+					DownsampleRgba8(image.data(), size[0], size[1], scalar.data(), options);
+
+					TestCase test(report, CaseName(options, size[0], size[1]));
+					const int maxError = std::max(MaxDifference(reference, simd), MaxDifference(reference, scalar));
+					test.Expect(maxError <= 1, "与参考实现最大相差" + std::to_string(maxError));
+					++checkCount;
+					report.Add(test, FilterName(filter), srgb, wrap, size[0], size[1], maxError, "", "");
+				}
+			}
+		}
+	}
+
+	//黑白棋盘格在sRGB空间平均应该是中灰(188)，直接平均编码值会得到128，偏暗
+	{
+		const uint8_t checker[16] = { 0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 255 };
+		MipChainOptions options;
+		options.Srgb = true;
+		uint8_t srgbResult[4];
+		DownsampleRgba8(checker, 2, 2, srgbResult, options);
+		options.Srgb = false;
+		uint8_t linearResult[4];
+		DownsampleRgba8(checker, 2, 2, linearResult, options);
+		TestCase test(report, "SrgbChecker");
+		test.Expect(srgbResult[0] == 188 && srgbResult[3] == 255 && linearResult[0] == 128,
+			"棋盘格平均结果sRGB " + std::to_string(srgbResult[0]) + "，线性 " + std::to_string(linearResult[0]));
+		report.Add(test, FilterName(MipFilter::Box), 1, 0, 2, 2, "", "", "");
+	}
+
+	//整条mip链的耗时：SIMD和标量成对交替运行，报告各自最快的一次
+	//有SSE2时每对的耗时比(SIMD/标量)取中位数，大于1就是SIMD比标量慢；成对比较抵消频率的缓慢变化，中位数不受偶发的抢占影响
+	const uint32_t benchSizes[][2] = { { 256, 256 }, { 1024, 1024 }, { 1023, 1023 }, { 2048, 1024 } };
+	const int repeats = 9;
+	for (const auto& size : benchSizes)
+	{
+		const std::vector<uint8_t> image = MakeTestImage(size[0], size[1], 7);
+		for (MipFilter filter : filters)
+		{
+			for (int srgb = 0; srgb < (filter == MipFilter::Box || filter == MipFilter::Kaiser ? 2 : 1); ++srgb)
+			{
+				MipChainOptions options;
+				options.Filter = filter;
+				options.Srgb = srgb != 0;
+
+				double bestMs[2] = { DBL_MAX, DBL_MAX };
+				std::vector<double> ratios;
+				for (int r = 0; r < repeats; ++r)
+				{
+					double ms[2];
+					for (int simd = 0; simd < 2; ++simd)
+					{
+						options.UseSimd = simd != 0;
+						ms[simd] = MeasureMipChain(image, size[0], size[1], options);
+						bestMs[simd] = std::min(bestMs[simd], ms[simd]);
+					}
+					ratios.push_back(ms[1] / ms[0]);
+				}
+				std::nth_element(ratios.begin(), ratios.begin() + repeats / 2, ratios.end());
+				const double medianRatio = ratios[repeats / 2];
+
+				TestCase test(report, CaseName(options, size[0], size[1]) + ".Speed");
+				if (HasSse2)
+					test.Expect(medianRatio <= 1.0, "SIMD比标量慢，耗时比中位数 " + std::to_string(medianRatio));
+				report.Add(test, FilterName(filter), srgb, 0, size[0], size[1], "", bestMs[1], bestMs[0]);
+				std::cout << "MipChain：" << size[0] << "x" << size[1] << " " << FilterName(filter) << (srgb ? " sRGB" : "")
+					<< "，SIMD " << bestMs[1] << "ms，标量 " << bestMs[0] << "ms" << std::endl;
+			}
+		}
+	}
+
+	std::cout << "MipChain：" << checkCount << "种情况与参考实现对比" << (HasSse2 ? "" : "，没有SSE2，SIMD列也是标量实现") << std::endl;
+	return report.Finish();
+}
+
+}
@@ -0,0 +1,179 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/MipStreaming.h"
+#include "Common/GeometryGenerator.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+namespace Soco
+{
+
+namespace
+{
+
+struct Ray
+{
+	double x, y, z;
+};
+
+double Dot(const Ray& a, const Ray& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// 相机在原点看+z；边长side的正方形中心在center，绕x轴倾斜tilt弧度
+struct QuadCase
+{
+	Ray Center;
+	double Side;
+	double Tilt;
+};
+
+/*
+对正方形覆盖的每个像素，求像素中心和右、下相邻像素中心的光线与平面的交点的UV，
+和GPU一样取两个方向UV导数长度的较大值，返回所有像素里最小的一个，即最精细的需求；没有像素覆盖时返回0
+*/
+double MinUvFootprint(const QuadCase& quad, int viewportWidth, int viewportHeight, double projScale)
+{
+	const Ray axisU = { 1, 0, 0 };
+	const Ray axisV = { 0, std::cos(quad.Tilt), std::sin(quad.Tilt) };
+	const Ray normal = { 0, -std::sin(quad.Tilt), std::cos(quad.Tilt) };
+	const double planeD = Dot(quad.Center, normal);
+
+	auto uvAt = [&](const Ray& dir, double& u, double& v) {
+		const double denom = Dot(dir, normal);
+		if (std::abs(denom) < 1e-12)
+			return false;
+		const double t = planeD / denom;
+		const Ray p = { dir.x * t - quad.Center.x, dir.y * t - quad.Center.y, dir.z * t - quad.Center.z };
+		u = Dot(p, axisU) / quad.Side + 0.5;
+		v = Dot(p, axisV) / quad.Side + 0.5;
+		return t > 0;
+	};
+
+	//四个角投影到屏幕上的包围矩形
+	double minX = viewportWidth, maxX = 0, minY = viewportHeight, maxY = 0;
+	for (int corner = 0; corner < 4; ++corner)
+	{
+		const double su = (corner & 1) ? 0.5 : -0.5;
+		const double sv = (corner & 2) ? 0.5 : -0.5;
+		const Ray p = { quad.Center.x + quad.Side * (su * axisU.x + sv * axisV.x), quad.Center.y + quad.Side * (su * axisU.y + sv * axisV.y),
+			quad.Center.z + quad.Side * (su * axisU.z + sv * axisV.z) };
+		const double x = viewportWidth * 0.5 + p.x / p.z * projScale;
+		const double y = viewportHeight * 0.5 - p.y / p.z * projScale;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+	}
+	const int x0 = std::max(0, (int)std::floor(minX));
+	const int x1 = std::min(viewportWidth - 1, (int)std::ceil(maxX));
+	const int y0 = std::max(0, (int)std::floor(minY));
+	const int y1 = std::min(viewportHeight - 1, (int)std::ceil(maxY));
+
+	double minFootprint = DBL_MAX;
+	for (int py = y0; py <= y1; ++py)
+	{
+		for (int px = x0; px <= x1; ++px)
+		{
+			const Ray dir = { (px + 0.5 - viewportWidth * 0.5) / projScale, -(py + 0.5 - viewportHeight * 0.5) / projScale, 1.0 };
+			double u, v;
+			if (!uvAt(dir, u, v) || u < 0 || u > 1 || v < 0 || v > 1)
+				continue;
+
+			double ux, vx, uy, vy;
+			if (!uvAt({ dir.x + 1.0 / projScale, dir.y, dir.z }, ux, vx) || !uvAt({ dir.x, dir.y - 1.0 / projScale, dir.z }, uy, vy))
+				continue;
+			const double dx = std::sqrt((ux - u) * (ux - u) + (vx - v) * (vx - v));
+			const double dy = std::sqrt((uy - u) * (uy - u) + (vy - v) * (vy - v));
+			minFootprint = std::min(minFootprint, std::max(dx, dy));
+		}
+	}
+	return minFootprint == DBL_MAX ? 0.0 : minFootprint;
+}
+
+// UV密度写在Estimate和Reference两列
+void CheckDensity(TestReport& report, const char* name, const GeometryGenerator::MeshData& mesh, double expected, double tolerance)
+{
+	TestCase test(report, name);
+	const float density = ComputeUvDensity(&mesh.Vertices[0].Position.x, sizeof(GeometryGenerator::Vertex),
+		&mesh.Vertices[0].TexC.x, sizeof(GeometryGenerator::Vertex), mesh.Indices32.data(), mesh.Indices32.size());
+	test.Expect(std::abs(density - expected) <= tolerance * expected, "UV密度和解析值不符");
+	report.Add(test, "", "", "", "", "", density, expected);
+}
+
+}
+
+bool RunMipEstimatorHarness(const std::string& path)
+{
+	TestReport report("MipEstimator", path, "Texture,Distance,Tilt,OffsetX,OffsetY,Estimate,Reference");
+
+	//UV密度：球的UV面积是1，表面积是4 * pi * r^2；CreateGrid的UV铺满[0, 1]
+	GeometryGenerator geoGen;
+	const float sphereRadius = 3.0f;
+	CheckDensity(report, "SphereUvDensity", geoGen.CreateSphere(sphereRadius, 40, 40),
+		std::sqrt(1.0 / (4.0 * 3.14159265358979 * sphereRadius * sphereRadius)), 0.02);
+	const float quadSide = 2.0f;
+	GeometryGenerator::MeshData grid = geoGen.CreateGrid(quadSide, quadSide, 8, 8);
+	CheckDensity(report, "GridUvDensity", grid, 1.0 / quadSide, 1e-4);
+	const float quadDensity = ComputeUvDensity(&grid.Vertices[0].Position.x, sizeof(GeometryGenerator::Vertex),
+		&grid.Vertices[0].TexC.x, sizeof(GeometryGenerator::Vertex), grid.Indices32.data(), grid.Indices32.size());
+
+	const int viewportWidth = 1280;
+	const int viewportHeight = 720;
+	const double fovY = 0.25 * 3.14159265358979;
+	const double projScale = viewportHeight / (2.0 * std::tan(fovY * 0.5));
+	const double radius = quadSide * std::sqrt(0.5);
+
+	const double distances[] = { 1.5, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256 };
+	const double tilts[] = { 0, 30, 60, 75 };
+	const double offsets[][2] = { { 0, 0 }, { 0.6, 0 }, { 0, 0.3 } };
+	const uint32_t textureSizes[] = { 256, 768, 1024, 1536, 4096 };
+
+	uint32_t caseCount = 0;
+	uint32_t exactCount = 0;
+	for (double distanceInRadii : distances)
+	{
+		for (double tiltDegrees : tilts)
+		{
+			for (const auto& offset : offsets)
+			{
+				const double depth = distanceInRadii * radius;
+				const QuadCase quad = { { offset[0] * depth, offset[1] * depth, depth }, quadSide, tiltDegrees * 3.14159265358979 / 180.0 };
+				const double footprint = MinUvFootprint(quad, viewportWidth, viewportHeight, projScale);
+				if (footprint <= 0)
+					continue;
+
+				//相机空间就是视空间，包围球最近处的深度是中心深度减半径
+				const float pixelsPerUv = ComputeScreenUvDensity(quadDensity, 1.0f, (float)(depth - radius), (float)projScale);
+				for (uint32_t size : textureSizes)
+				{
+					uint32_t mipCount = 1;
+					while ((size >> mipCount) != 0)
+						++mipCount;
+
+					const uint32_t estimate = EstimateMipLevel(size, size, mipCount, pixelsPerUv);
+					const double lod = std::log2(footprint * size);
+					const uint32_t reference = lod <= 0 ? 0 : (uint32_t)std::min<double>(std::floor(lod), mipCount - 1);
+
+					std::ostringstream name;
+					name << "Texture" << size << ".Distance" << distanceInRadii << ".Tilt" << tiltDegrees << ".Offset" << offset[0] << "_" << offset[1];
+					TestCase test(report, name.str());
+					if (test.Expect(estimate <= reference, "估计第" + std::to_string(estimate) + "级，比参考第" + std::to_string(reference) + "级粗")
+						&& tiltDegrees == 0 && distanceInRadii >= 4)
+						test.Expect(reference - estimate <= 1, "估计第" + std::to_string(estimate) + "级，比参考第" + std::to_string(reference) + "级精细超过一级");
+					++caseCount;
+					exactCount += estimate == reference;
+
+					report.Add(test, size, distanceInRadii, tiltDegrees, offset[0], offset[1], estimate, reference);
+				}
+			}
+		}
+	}
+
+	std::cout << "MipEstimator：" << caseCount << "种情况，" << exactCount << "种与参考相同" << std::endl;
+	return report.Finish();
+}
+
+}
@@ -0,0 +1,356 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/PngDecoder.h"
+#include "Soco/Util/JobSystem.h"
+#include "Common/lodepng.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace Soco
+{
+
+namespace
+{
+
+struct SyntheticCase
+{
+	const char* Name;
+	uint32_t ColorType;
+	uint32_t BitDepth;
+	uint32_t Width;
+	uint32_t Height;
+	bool Interlaced;
+	bool ColorKey;
+};
+
+uint32_t ChannelCount(uint32_t colorType)
+{
+	switch (colorType)
+	{
+	case 0: return 1;
+	case 2: return 3;
+	case 4: return 2;
+	case 6: return 4;
+	default: return 1;
+	}
+}
+
+/*
+用lodepng编码合成图，每行的滤波类型按0~4轮换(隔行时由lodepng自己选)
+像素是平滑的渐变加一点扰动，各种滤波都有非零的预测；低于8位的灰度用8位的原始数据给出，值都能精确表示
+*/
+std::vector<uint8_t> EncodeSynthetic(const SyntheticCase& test)
+{
+	const bool palette = test.ColorType == 3;
+	const uint32_t rawBits = palette || test.BitDepth < 8 ? 8 : test.BitDepth;
+	const uint32_t channels = ChannelCount(test.ColorType);
+	const uint32_t sampleBytes = rawBits / 8;
+	std::vector<uint8_t> raw((size_t)test.Width * test.Height * channels * sampleBytes);
+	for (uint32_t y = 0; y < test.Height; ++y)
+	{
+		for (uint32_t x = 0; x < test.Width; ++x)
+		{
+			for (uint32_t c = 0; c < channels; ++c)
+			{
+				const uint32_t hash = (x * 73856093u) ^ (y * 19349663u) ^ (c * 83492791u);
+				uint32_t value = (x * 523u + y * 311u + c * 9001u + (hash % 97u) * 7u) & 0xFFFF;
+				if (palette)
+					value &= 0xFF;
+				else if (test.BitDepth < 8)
+					value = ((value >> 8) & ((1u << test.BitDepth) - 1)) * (255u / ((1u << test.BitDepth) - 1));
+				else if (test.BitDepth == 8)
+					value >>= 8;
+				uint8_t* sample = &raw[(((size_t)y * test.Width + x) * channels + c) * sampleBytes];
+				if (sampleBytes == 2)
+				{
+					sample[0] = (uint8_t)(value >> 8);
+					sample[1] = (uint8_t)value;
+				}
+				else
+				{
+					sample[0] = (uint8_t)value;
+				}
+			}
+		}
+	}
+
+	LodePNGState state;
+	lodepng_state_init(&state);
+	state.info_raw.colortype = palette ? LCT_PALETTE : (LodePNGColorType)test.ColorType;
+	state.info_raw.bitdepth = rawBits;
+	state.info_png.color.colortype = (LodePNGColorType)test.ColorType;
+	state.info_png.color.bitdepth = test.BitDepth;
+	if (palette)
+	{
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			lodepng_palette_add(&state.info_raw, (uint8_t)i, (uint8_t)(255 - i), (uint8_t)(i * 7), (uint8_t)(i | 128));
+			lodepng_palette_add(&state.info_png.color, (uint8_t)i, (uint8_t)(255 - i), (uint8_t)(i * 7), (uint8_t)(i | 128));
+		}
+	}
+	if (test.ColorKey)
+	{
+		//第一个像素的颜色作为透明色
+		for (LodePNGColorMode* mode : { &state.info_raw, &state.info_png.color })
+		{
+			mode->key_defined = 1;
+			mode->key_r = raw[0];
+			mode->key_g = raw[1];
+			mode->key_b = raw[2];
+		}
+	}
+	state.info_png.interlace_method = test.Interlaced ? 1 : 0;
+	state.encoder.auto_convert = 0;
+	state.encoder.filter_palette_zero = 0;
+
+	std::vector<uint8_t> filters(test.Height);
+	for (uint32_t y = 0; y < test.Height; ++y)
+		filters[y] = (uint8_t)(y % 5);
+	state.encoder.filter_strategy = test.Interlaced ? LFS_MINSUM : LFS_PREDEFINED;
+	state.encoder.predefined_filters = filters.data();
+
+	unsigned char* png = nullptr;
+	size_t pngSize = 0;
+	const unsigned error = lodepng_encode(&png, &pngSize, raw.data(), test.Width, test.Height, &state);
+	lodepng_state_cleanup(&state);
+	std::vector<uint8_t> result;
+	if (!error)
+		result.assign(png, png + pngSize);
+	free(png);
+	return result;
+}
+
+// 和lodepng解码成RGBA16的结果比较，期望值只由RGBA16取通道和高字节得到
+bool MatchesReference(const PngImage& image, const uint8_t* rgba16)
+{
+	const size_t pixelCount = (size_t)image.Width * image.Height;
+	for (size_t i = 0; i < pixelCount; ++i)
+	{
+		for (uint32_t c = 0; c < image.Channels; ++c)
+		{
+			const uint32_t reference = ((uint32_t)rgba16[(i * 4 + c) * 2] << 8) | rgba16[(i * 4 + c) * 2 + 1];
+			uint32_t actual;
+			if (image.BitDepth == 8)
+			{
+				actual = image.Pixels[i * image.Channels + c];
+				if (actual != reference >> 8)
+					return false;
+			}
+			else
+			{
+				uint16_t sample;
+				memcpy(&sample, &image.Pixels[(i * image.Channels + c) * 2], 2);
+				if (sample != reference)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+uint32_t ReadBigEndian32(const uint8_t* p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+std::string VariantName(const PngDecodeOptions& options)
+{
+	return std::string(options.UseSimd ? "Simd" : "Scalar") + (options.Pipelined ? "Pipelined" : "") + ".R"
+		+ (options.Channels == 1 ? "" : "GBA") + std::to_string(options.BitDepth);
+}
+
+void CheckSyntheticImages(TestReport& report)
+{
+	const SyntheticCase cases[] = {
+		{ "Grey8", 0, 8, 67, 29, false, false },
+		{ "Grey16", 0, 16, 131, 301, false, false },
+		{ "RGB8", 2, 8, 67, 29, false, false },
+		{ "RGB16", 2, 16, 67, 29, false, false },
+		{ "GreyAlpha8", 4, 8, 67, 29, false, false },
+		{ "GreyAlpha16", 4, 16, 67, 29, false, false },
+		{ "RGBA8", 6, 8, 257, 301, false, false },
+		{ "RGBA16", 6, 16, 67, 29, false, false },
+		//以下交给lodepng
+		{ "Palette8", 3, 8, 67, 29, false, false },
+		{ "Grey4", 0, 4, 67, 29, false, false },
+		{ "RGBA8Interlaced", 6, 8, 67, 29, true, false },
+		{ "RGB8ColorKey", 2, 8, 67, 29, false, true },
+	};
+
+	for (const SyntheticCase& synthetic : cases)
+	{
+		const std::vector<uint8_t> png = EncodeSynthetic(synthetic);
+		unsigned char* reference = nullptr;
+		unsigned width = 0, height = 0;
+		const bool referenceDecoded = !png.empty() && lodepng_decode_memory(&reference, &width, &height, png.data(), png.size(), LCT_RGBA, 16) == 0;
+
+		for (uint32_t channels : { 1u, 4u })
+		{
+			for (uint32_t bitDepth : { 8u, 16u })
+			{
+				for (int variant = 0; variant < 3; ++variant)
+				{
+					PngDecodeOptions options;
+					options.Channels = channels;
+					options.BitDepth = bitDepth;
+					options.UseSimd = variant != 0;
+					options.Pipelined = variant == 2;
+
+					TestCase test(report, std::string("Synthetic.") + synthetic.Name + "." + VariantName(options));
+					PngImage image;
+					if (test.Expect(referenceDecoded, "lodepng编码或解码合成图失败")
+						&& test.Expect(DecodePng(png.data(), png.size(), options, image), "解码失败")
+						&& test.Expect(image.Width == width && image.Height == height, "宽高和lodepng不一致"))
+					{
+						test.Expect(MatchesReference(image, reference), "和lodepng不一致");
+					}
+					report.Add(test, synthetic.ColorType, synthetic.BitDepth, width, height, "", "", "", "");
+				}
+			}
+		}
+		free(reference);
+	}
+}
+
+// 截断的文件和IDAT里改了一个字节(重新算过CRC)的文件都要解码失败
+void CheckCorruptedImages(TestReport& report)
+{
+	const SyntheticCase synthetic = { "RGBA8", 6, 8, 257, 301, false, false };
+	const std::vector<uint8_t> png = EncodeSynthetic(synthetic);
+
+	PngImage image;
+	std::cout << "PNG解码：下面两条错误是检查损坏文件时预期的输出" << std::endl;
+	report.Check("Corrupted.Truncated", !png.empty() && !DecodePng(png.data(), png.size() / 2, PngDecodeOptions(), image));
+
+	std::vector<uint8_t> corrupted = png;
+	bool modified = false;
+	for (size_t pos = 8; pos + 12 <= corrupted.size();)
+	{
+		const uint32_t length = ReadBigEndian32(&corrupted[pos]);
+		if (memcmp(&corrupted[pos + 4], "IDAT", 4) == 0 && length > 16)
+		{
+			corrupted[pos + 8 + length / 2] ^= 0x10;
+			const uint32_t crc = lodepng_crc32(&corrupted[pos + 4], length + 4);
+			for (int i = 0; i < 4; ++i)
+				corrupted[pos + 8 + length + i] = (uint8_t)(crc >> (24 - 8 * i));
+			modified = true;
+			break;
+		}
+		pos += 12 + (size_t)length;
+	}
+	report.Check("Corrupted.Deflate", modified && !DecodePng(corrupted.data(), corrupted.size(), PngDecodeOptions(), image));
+}
+
+template<typename F>
+double BestOfThree(F&& func)
+{
+	double best = DBL_MAX;
+	for (int repeat = 0; repeat < 3; ++repeat)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		func();
+		const auto end = std::chrono::high_resolution_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+}
+
+bool RunPngDecodeBenchmark(const std::string& path)
+{
+	TestReport report("PngDecode", path, "ColorType,BitDepth,Width,Height,Ms,LodepngMs,FileMBps,MPixPerSecond");
+
+	CheckSyntheticImages(report);
+	CheckCorruptedImages(report);
+
+	//仓库里的高度图，按运行时的相对路径找，找不到时只做合成图的检查
+	const std::string directory = "../Textures/HeightMaps/";
+	std::vector<std::filesystem::path> files;
+	std::error_code errorCode;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, errorCode))
+		if (entry.path().extension() == ".png")
+			files.push_back(entry.path());
+	std::sort(files.begin(), files.end());
+	if (files.empty())
+		std::cout << "PNG解码：" << directory << "下没有PNG，只做了合成图的检查" << std::endl;
+
+	for (const auto& file : files)
+	{
+		const std::string filename = file.string();
+		const std::string name = file.filename().string();
+		std::vector<uint8_t> data;
+		{
+			std::ifstream stream(filename, std::ios::binary);
+			data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+		}
+		const double fileMegabytes = (double)data.size() / (1024.0 * 1024.0);
+
+		//计时用lodepng最常用的RGBA8输出，比较用RGBA16，16位的输出也能逐位比较
+		unsigned char* rgba8 = nullptr;
+		unsigned width = 0, height = 0;
+		const double lodepngMs = BestOfThree([&]() {
+			free(rgba8);
+			rgba8 = nullptr;
+			lodepng_decode32_file(&rgba8, &width, &height, filename.c_str());
+		});
+		free(rgba8);
+
+		unsigned char* reference = nullptr;
+		LodePNGState state;
+		lodepng_state_init(&state);
+		const bool referenceDecoded = lodepng_decode_memory(&reference, &width, &height, data.data(), data.size(), LCT_RGBA, 16) == 0
+			&& lodepng_inspect(&width, &height, &state, data.data(), data.size()) == 0;
+		const uint32_t colorType = state.info_png.color.colortype;
+		const uint32_t bitDepth = state.info_png.color.bitdepth;
+		lodepng_state_cleanup(&state);
+
+		const double megaPixels = (double)width * height / 1e6;
+		std::cout << "PNG解码：" << name << " " << width << "x" << height << "，lodepng " << lodepngMs << "ms";
+
+		struct Variant
+		{
+			bool UseSimd;
+			bool Pipelined;
+			uint32_t Channels;
+		};
+		const Variant variants[] = {
+			{ false, false, 4 },
+			{ true, false, 4 },
+			{ true, true, 4 },
+			{ true, true, 1 },
+		};
+		for (const Variant& variant : variants)
+		{
+			PngDecodeOptions options;
+			options.UseSimd = variant.UseSimd;
+			options.Pipelined = variant.Pipelined;
+			options.Channels = variant.Channels;
+			//单通道输出保留源的位深，高度图要16位精度时不丢失
+			options.BitDepth = variant.Channels == 1 && bitDepth == 16 ? 16 : 8;
+
+			TestCase test(report, name + "." + VariantName(options));
+			PngImage image;
+			bool decoded = true;
+			const double ms = BestOfThree([&]() { decoded &= DecodePng(data.data(), data.size(), options, image); });
+			if (test.Expect(referenceDecoded, "lodepng解码失败") && test.Expect(decoded, "解码失败"))
+				test.Expect(image.Width == width && image.Height == height && MatchesReference(image, reference), "和lodepng不一致");
+
+			report.Add(test, colorType, bitDepth, width, height, ms, lodepngMs, fileMegabytes / (ms / 1000.0), megaPixels / (ms / 1000.0));
+			std::cout << "，" << VariantName(options) << " " << ms << "ms(" << lodepngMs / ms << "倍)";
+		}
+		std::cout << std::endl;
+		free(reference);
+	}
+
+	std::cout << "PNG解码：" << JobSystem::GetInstance()->GetThreadCount() << "线程" << std::endl;
+	return report.Finish();
+}
+
+}
@@ -0,0 +1,100 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/Profiler.h"
+
+#include <iostream>
+
+namespace Soco
+{
+
+namespace
+{
+
+struct ProfilerOverheadCase
+{
+	const char* Name;
+	uint32_t Depth;
+	bool Enabled;
+};
+
+//depth层嵌套，最内层每次循环一个zone，外层zone把内层包住
+void RecordNestedZones(uint32_t depth, uint32_t count)
+{
+	if (depth <= 1)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			SOCO_PROFILE_SCOPE("ProfilerBench");
+		}
+		return;
+	}
+
+	SOCO_PROFILE_SCOPE("ProfilerBenchOuter");
+	RecordNestedZones(depth - 1, count);
+}
+
+}
+
+bool RunProfilerOverheadBenchmark(const std::string& path)
+{
+	const ProfilerOverheadCase cases[] = {
+		{ "Flat", 1, true },
+		{ "Nested4", 4, true },
+		{ "Disabled", 1, false },
+	};
+	//每帧的zone数量远小于环形缓冲容量，不会丢弃
+	const uint32_t zonesPerFrame = (uint32_t)ProfileRingBuffer::Capacity / 4;
+	const uint32_t frames = 64;
+
+	Profiler* profiler = Profiler::GetInstance();
+	const bool wasEnabled = profiler->IsEnabled();
+	profiler->EndFrame();
+
+	TestReport report("Profiler", path, "Zones,RecordNsPerZone,EndFrameNsPerZone");
+
+	for (const ProfilerOverheadCase& overheadCase : cases)
+	{
+		TestCase test(report, overheadCase.Name);
+		profiler->SetEnabled(overheadCase.Enabled);
+		const uint64_t expected = overheadCase.Enabled ? (uint64_t)zonesPerFrame + overheadCase.Depth - 1 : 0;
+		uint64_t recordNs = 0;
+		uint64_t endFrameNs = 0;
+		bool casePassed = true;
+
+		for (uint32_t f = 0; f < frames; ++f)
+		{
+			uint64_t begin = Profiler::Now();
+			RecordNestedZones(overheadCase.Depth, zonesPerFrame);
+			recordNs += Profiler::Now() - begin;
+
+			begin = Profiler::Now();
+			profiler->EndFrame();
+			endFrameNs += Profiler::Now() - begin;
+
+			const ProfileFrame& frame = *profiler->GetLastFrame();
+			casePassed = casePassed && frame.Events.size() == expected && frame.DroppedEvents == 0;
+			for (size_t i = 0; i < frame.Events.size() && casePassed; ++i)
+			{
+				//最内层先结束，外层按从里到外的顺序排在最后
+				const ProfileEvent& e = frame.Events[i];
+				const uint32_t depth = i < zonesPerFrame ? overheadCase.Depth - 1 : overheadCase.Depth - 2 - (uint32_t)(i - zonesPerFrame);
+				casePassed = e.Depth == depth && e.Begin <= e.End && frame.Begin <= e.Begin && e.End <= frame.End;
+				if (casePassed && i > 0 && i < zonesPerFrame)
+					casePassed = frame.Events[i - 1].End <= e.Begin;
+				if (casePassed && i >= zonesPerFrame)
+					casePassed = e.Begin <= frame.Events[0].Begin && frame.Events[i - 1].End <= e.End;
+			}
+		}
+		test.Expect(casePassed, "收集到的zone数量、深度或时间不对");
+
+		const double zones = (double)frames * zonesPerFrame;
+		report.Add(test, (uint64_t)zones, recordNs / zones, endFrameNs / zones);
+		std::cout << overheadCase.Name << "：每个zone记录" << recordNs / zones << "ns，EndFrame收集" << endFrameNs / zones << "ns，"
+			<< (casePassed ? "通过" : "失败") << std::endl;
+	}
+
+	profiler->SetEnabled(wasEnabled);
+	return report.Finish();
+}
+
+}
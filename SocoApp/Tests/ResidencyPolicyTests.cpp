@@ -0,0 +1,306 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/ResidencyPolicy.h"
+#include "Soco/Util/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+
+namespace Soco
+{
+
+namespace
+{
+
+struct ResidencyTrace
+{
+	std::string Name;
+	uint32_t Frames;
+	// 返回这一帧用到的纹理
+	std::function<void(uint64_t frame, std::vector<uint32_t>& used)> Usage;
+	// 可以在中途修改预算，返回0表示不变
+	std::function<uint64_t(uint64_t frame)> Budget;
+	// 可选：这一帧用到的纹理需要的最精细一级
+	std::function<uint32_t(uint64_t frame, uint32_t texture)> Wanted;
+	// 每帧升级上传的上限
+	uint64_t MaxPromoteBytesPerFrame = UINT64_MAX;
+};
+
+struct ResidencyTraceResult
+{
+	uint64_t PeakResident = 0;
+	double AvgResident = 0;
+	uint32_t OverBudgetFrames = 0;
+	double AvgUpdateUs = 0;
+	ResidencyStats Stats;
+};
+
+// 相机在[0, textureCount * 10]之间来回移动，800帧一个来回
+float StreamingCamera(uint64_t frame, uint32_t textureCount)
+{
+	const float t = (float)(frame % 800) / 400.0f;
+	return (t < 1.0f ? t : 2.0f - t) * textureCount * 10.0f;
+}
+
+// 按格式大小生成一条完整mip链：RGBA8，宽高从size开始每级减半
+std::vector<uint64_t> MakeMipChain(uint32_t size)
+{
+	std::vector<uint64_t> mips;
+	for (uint32_t s = size; ; s /= 2)
+	{
+		mips.push_back((uint64_t)s * s * 4);
+		if (s == 1)
+			break;
+	}
+	return mips;
+}
+
+ResidencyTraceResult RunTrace(TestCase& test, const ResidencyTrace& trace, const std::vector<std::vector<uint64_t>>& textures, uint64_t budget)
+{
+	//变化生效需要的帧数，模拟旧资源等fence
+	const uint32_t BusyFrames = 2;
+
+	ResidencyPolicy policy;
+	ResidencyPolicyConfig config;
+	config.BudgetBytes = budget;
+	config.ProtectFrames = 3;
+	config.EvictAfterFrames = 200;
+	config.TrimAfterFrames = 60;
+	config.MaxPromoteBytesPerFrame = trace.MaxPromoteBytesPerFrame;
+	policy.SetConfig(config);
+
+	std::vector<uint32_t> ids;
+	for (const std::vector<uint64_t>& mips : textures)
+	{
+		//最后两级(2x2和1x1)模拟BC格式不能作为最精细的一级
+		const uint32_t mipCount = (uint32_t)mips.size();
+		ids.push_back(policy.Register(mips.data(), mipCount, mipCount > 2 ? mipCount - 3 : 0, 0, 0));
+	}
+	std::vector<uint64_t> busyUntil(ids.size(), 0);
+	//模拟策略里的LastNeeded：需要的一级不比当前更精细的最后一帧
+	std::vector<uint64_t> lastNeeded(ids.size(), 0);
+	std::vector<uint32_t> used;
+
+	ResidencyTraceResult result;
+	double residentSum = 0;
+	uint64_t updateNs = 0;
+	auto fail = [&](uint64_t frame, const std::string& message) {
+		test.Fail("第" + std::to_string(frame) + "帧：" + message);
+	};
+
+	for (uint64_t frame = 1; frame <= trace.Frames; ++frame)
+	{
+		if (uint64_t newBudget = trace.Budget ? trace.Budget(frame) : 0)
+		{
+			config.BudgetBytes = newBudget;
+			policy.SetConfig(config);
+		}
+		for (uint32_t i = 0; i < ids.size(); ++i)
+		{
+			if (busyUntil[i] != 0 && busyUntil[i] <= frame)
+			{
+				policy.SetBusy(ids[i], false);
+				busyUntil[i] = 0;
+			}
+		}
+
+		//和程序里一样，需要的mip在Update之前按上一帧用到的纹理估计
+		if (trace.Wanted)
+		{
+			for (uint32_t i : used)
+			{
+				policy.SetWantedMip(ids[i], trace.Wanted(frame, i), frame);
+				if (policy.GetWantedMip(ids[i]) <= policy.GetMostDetailedMip(ids[i]))
+					lastNeeded[i] = frame;
+			}
+		}
+
+		//Update之前记下每张纹理的状态，用来检查这一帧的决策
+		std::vector<uint64_t> lastUsed(ids.size());
+		std::vector<bool> busy(ids.size());
+		for (uint32_t i = 0; i < ids.size(); ++i)
+		{
+			lastUsed[i] = policy.GetLastUsed(ids[i]);
+			busy[i] = busyUntil[i] != 0;
+		}
+
+		uint64_t begin = Profiler::Now();
+		std::vector<ResidencyChange> changes = policy.Update(frame);
+		updateNs += Profiler::Now() - begin;
+
+		//最低一级(最后两级模拟BC格式不能作为最精细的一级)或已换出的纹理不能再降
+		auto atFloor = [&](uint32_t i) {
+			return policy.IsEvicted(ids[i]) || policy.GetMostDetailedMip(ids[i]) >= textures[i].size() - 3;
+		};
+		auto isProtected = [&](uint32_t i) { return lastUsed[i] + config.ProtectFrames > frame; };
+
+		uint64_t newestDemoted = 0;
+		bool protectedDemoted = false;
+		uint64_t promotedBytes = 0;
+		uint32_t promotedSteps = 0;
+		std::vector<bool> changed(ids.size(), false);
+		for (const ResidencyChange& change : changes)
+		{
+			const uint32_t i = change.Texture;
+			changed[i] = true;
+			if (change.NewMostDetailedMip < change.OldMostDetailedMip)
+			{
+				if (change.NewMostDetailedMip < policy.GetWantedMip(ids[i]))
+					fail(frame, "升级超过了需要的一级");
+				for (uint32_t mip = change.NewMostDetailedMip; mip < change.OldMostDetailedMip; ++mip)
+					promotedBytes += textures[i][mip];
+				promotedSteps += change.OldMostDetailedMip - change.NewMostDetailedMip;
+				lastNeeded[i] = frame;
+			}
+			if (busy[i])
+				fail(frame, "改变了上一次变化还没生效的纹理");
+			if (change.NewEvicted && !change.OldEvicted && isProtected(i))
+				fail(frame, "换出了保护期内的纹理");
+			//丢掉用不上的mip不受LRU和保护期限制
+			const bool trimmed = change.NewMostDetailedMip <= policy.GetWantedMip(ids[i]);
+			if (change.NewMostDetailedMip > change.OldMostDetailedMip && !trimmed)
+			{
+				if (isProtected(i))
+					protectedDemoted = true;
+				else
+					newestDemoted = std::max(newestDemoted, lastUsed[i]);
+			}
+			else if (change.NewMostDetailedMip < change.OldMostDetailedMip && !isProtected(i))
+			{
+				fail(frame, "升级了最近没有使用的纹理");
+			}
+			policy.SetBusy(ids[i], true);
+			busyUntil[i] = frame + BusyFrames;
+		}
+
+		if (promotedBytes > config.MaxPromoteBytesPerFrame && promotedSteps > 1)
+			fail(frame, "升级上传超过了每帧的上限");
+
+		for (uint32_t i = 0; i < ids.size(); ++i)
+		{
+			if (!busy[i] && !policy.IsEvicted(ids[i]) && policy.GetMostDetailedMip(ids[i]) < policy.GetWantedMip(ids[i])
+				&& lastNeeded[i] + config.TrimAfterFrames <= frame)
+				fail(frame, "没有丢掉很久用不上的mip");
+		}
+
+		for (uint32_t i = 0; i < ids.size(); ++i)
+		{
+			if (busy[i] || isProtected(i) || atFloor(i))
+				continue;
+			//保护期内的纹理只能在其它纹理都降到底之后再降
+			if (protectedDemoted)
+				fail(frame, "还有闲置的纹理可以降级时降级了保护期内的纹理");
+			//LRU：比被降级的纹理更久没用、还能降的纹理这一帧必须也被处理过
+			if (newestDemoted != 0 && !changed[i] && lastUsed[i] < newestDemoted)
+				fail(frame, "没有按最久未使用的顺序降级");
+		}
+
+		if (policy.GetTotalResidentBytes() > config.BudgetBytes)
+		{
+			++result.OverBudgetFrames;
+			for (uint32_t i = 0; i < ids.size(); ++i)
+			{
+				if (!busy[i] && !atFloor(i))
+					fail(frame, "超出预算时还有可以降级的纹理");
+			}
+		}
+
+		used.clear();
+		trace.Usage(frame, used);
+		for (uint32_t i : used)
+			policy.MarkUsed(ids[i], frame);
+		policy.RestoreUsedEvicted(frame);
+
+		if (!policy.Validate())
+			fail(frame, "内部状态不一致");
+
+		result.PeakResident = std::max(result.PeakResident, policy.GetTotalResidentBytes());
+		residentSum += (double)policy.GetTotalResidentBytes();
+	}
+
+	result.AvgResident = residentSum / trace.Frames;
+	result.AvgUpdateUs = updateNs / 1e3 / trace.Frames;
+	result.Stats = policy.GetStats();
+	return result;
+}
+
+}
+
+bool RunResidencyTraceBenchmark(const std::string& path)
+{
+	TestReport report("Residency", path, "Frames,Textures,BudgetMB,PeakResidentMB,AvgResidentMB,OverBudgetFrames,Demotions,Promotions,Evictions,Restores,AvgUpdateUs");
+
+	//64张纹理，大小从256到2048，固定种子
+	std::mt19937 rng(4401);
+	std::vector<std::vector<uint64_t>> textures;
+	uint64_t totalBytes = 0;
+	for (int i = 0; i < 64; ++i)
+	{
+		textures.push_back(MakeMipChain(256u << (rng() % 4)));
+		for (uint64_t bytes : textures.back())
+			totalBytes += bytes;
+	}
+	const uint32_t textureCount = (uint32_t)textures.size();
+	const uint64_t budget = totalBytes / 4;
+
+	std::vector<ResidencyTrace> traces;
+	//工作集是连续的12张纹理，每30帧向后挪4张
+	traces.push_back({ "SlidingWindow", 1200, [textureCount](uint64_t frame, std::vector<uint32_t>& used) {
+		const uint32_t start = (uint32_t)(frame / 30 * 4);
+		for (uint32_t i = 0; i < 12; ++i)
+			used.push_back((start + i) % textureCount);
+	}, nullptr, nullptr });
+	//每帧轮流用8张，所有纹理的使用间隔相同，LRU最差的情况
+	traces.push_back({ "RoundRobin", 1200, [textureCount](uint64_t frame, std::vector<uint32_t>& used) {
+		for (uint32_t i = 0; i < 8; ++i)
+			used.push_back((uint32_t)((frame * 8 + i) % textureCount));
+	}, nullptr, nullptr });
+	//前100帧用全部，之后只用前一半直到第700帧，然后又用全部：闲置的一半被换出后再恢复
+	traces.push_back({ "IdleThenReturn", 1000, [textureCount](uint64_t frame, std::vector<uint32_t>& used) {
+		const uint32_t count = frame < 100 || frame >= 700 ? textureCount : textureCount / 2;
+		for (uint32_t i = 0; i < count; ++i)
+			used.push_back(i);
+	}, nullptr, nullptr });
+	//随机使用，预算中途减半再恢复
+	traces.push_back({ "BudgetChange", 1200, [textureCount](uint64_t frame, std::vector<uint32_t>& used) {
+		std::mt19937 frameRng((uint32_t)frame / 10);
+		for (uint32_t i = 0; i < 10; ++i)
+			used.push_back(frameRng() % textureCount);
+	}, [budget](uint64_t frame) -> uint64_t {
+		return frame == 400 ? budget / 2 : frame == 800 ? budget : 0;
+	}, nullptr });
+	//纹理排在一条线上，相机来回移动，能看到附近的纹理，需要的mip随距离变粗；每帧最多上传2MB
+	ResidencyTrace streaming = { "Streaming", 1600, [textureCount](uint64_t frame, std::vector<uint32_t>& used) {
+		const float camera = StreamingCamera(frame, textureCount);
+		for (uint32_t i = 0; i < textureCount; ++i)
+		{
+			if (std::abs(i * 10.0f - camera) <= 120.0f)
+				used.push_back(i);
+		}
+	}, nullptr, [textureCount](uint64_t frame, uint32_t texture) {
+		const float distance = std::abs(texture * 10.0f - StreamingCamera(frame, textureCount));
+		return (uint32_t)std::log2(std::max(distance / 10.0f, 1.0f));
+	} };
+	streaming.MaxPromoteBytesPerFrame = 2 * 1024 * 1024;
+	traces.push_back(streaming);
+
+	for (const ResidencyTrace& trace : traces)
+	{
+		TestCase test(report, trace.Name);
+		ResidencyTraceResult result = RunTrace(test, trace, textures, budget);
+
+		const double MB = 1024.0 * 1024.0;
+		report.Add(test, trace.Frames, textureCount, budget / MB, result.PeakResident / MB, result.AvgResident / MB, result.OverBudgetFrames,
+			result.Stats.Demotions, result.Stats.Promotions, result.Stats.Evictions, result.Stats.Restores, result.AvgUpdateUs);
+		std::cout << trace.Name << "：峰值" << result.PeakResident / MB << "MB，降级" << result.Stats.Demotions
+			<< "次，升级" << result.Stats.Promotions << "次，换出" << result.Stats.Evictions << "次，"
+			<< (test.Passed() ? "通过" : "失败") << std::endl;
+	}
+
+	return report.Finish();
+}
+
+}
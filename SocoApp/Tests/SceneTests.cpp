@@ -0,0 +1,154 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Scene.h"
+#include "Soco/Util/Profiler.h"
+
+#include <cmath>
+#include <iostream>
+#include <map>
+
+using namespace DirectX;
+
+namespace Soco
+{
+
+namespace
+{
+
+// 原来的写法：变换和轨道角度按名字存在map里，每帧按名字查找
+struct NamedScene
+{
+	std::vector<std::string> Names;
+	std::map<std::string, Transform> Transforms;
+	std::map<std::string, float> Thetas;
+	std::map<std::string, XMFLOAT4X4> Worlds;
+	std::vector<std::pair<std::string, std::string>> Children;
+
+	void Update(float dt)
+	{
+		for (const std::string& name : Names)
+		{
+			float& theta = Thetas[name];
+			theta += dt * 0.3f;
+			Transforms[name].SetGlobalPosition({ 40 * cos(theta), 0, 40 * sin(theta) });
+			Transforms[name].Rotate({ 0, dt, 0 });
+			XMStoreFloat4x4(&Worlds[name], Transforms[name].GetGlobalMatrixM());
+		}
+		for (auto& [child, parent] : Children)
+			XMStoreFloat4x4(&Worlds[child], Transforms[child].GetGlobalMatrixM());
+	}
+};
+
+// 逐个实体的标量写法：每个实体单独算sin/cos，经过Transform::Rotate和GetLocalMatrixM
+void UpdateOrbitsScalar(EntityWorld& world, float dt)
+{
+	world.ForEach<OrbitComponent, Transform, WorldMatrixComponent>([dt](OrbitComponent& orbit, Transform& transform, WorldMatrixComponent& worldMatrix) {
+		orbit.Theta += dt * orbit.Speed;
+		transform.SetLocalPosition({ orbit.Radius * cos(orbit.Theta), orbit.Height, orbit.Radius * sin(orbit.Theta) });
+		transform.Rotate({ 0, dt * orbit.SpinSpeed, 0 });
+		XMStoreFloat4x4(&worldMatrix.World, transform.GetLocalMatrixM());
+	});
+}
+
+template<typename F>
+double MeasureFrames(F&& updateFrame)
+{
+	const int warmupFrames = 5;
+	const int frames = 60;
+	for (int i = 0; i < warmupFrames; ++i)
+		updateFrame();
+
+	uint64_t begin = Profiler::Now();
+	for (int i = 0; i < frames; ++i)
+		updateFrame();
+	return (Profiler::Now() - begin) * 1e-6 / frames;
+}
+
+}
+
+bool RunSceneScalingBenchmark(const std::string& path)
+{
+	TestReport report("SceneScaling", path, "Method,Count,MsPerFrame,NsPerObject");
+
+	auto measure = [&report](const char* method, uint32_t count, double ms) {
+		double nsPerObject = ms * 1e6 / count;
+		TestCase test(report, std::string(method) + std::to_string(count));
+		report.Add(test, method, count, ms, nsPerObject);
+		std::cout << method << " " << count << "个物体: " << ms << "ms/帧, " << nsPerObject << "ns/物体" << std::endl;
+	};
+
+	const uint32_t maxCount = 1000000;
+	const float dt = 1.0f / 60.0f;
+	for (uint32_t count = 10; count <= maxCount; count *= 10)
+	{
+		//按名字查找的写法在百万级时建表就要很久，只测到10万
+		if (count <= 100000)
+		{
+			//每10个物体带一个子节点，和地球-月亮一样
+			NamedScene named;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				std::string name = "Planet" + std::to_string(i);
+				named.Names.push_back(name);
+				named.Transforms[name] = Transform({ 40, 0, 0 });
+				named.Thetas[name] = i * 0.001f;
+			}
+			for (uint32_t i = 0; i < count; i += 10)
+			{
+				std::string name = "Moon" + std::to_string(i);
+				named.Transforms[name] = Transform({ 2.5f, 0, 0 }, { 0, 0, 0 }, { 0.5f, 0.5f, 0.5f }, &named.Transforms[named.Names[i]]);
+				named.Children.push_back({ name, named.Names[i] });
+			}
+			measure("NamedLookup", count, MeasureFrames([&named, dt]() { named.Update(dt); }));
+		}
+
+		EntityWorld world;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			OrbitComponent orbit;
+			orbit.Radius = 40;
+			orbit.Speed = 0.3f;
+			orbit.Theta = i * 0.001f;
+			orbit.SpinSpeed = 1;
+			Entity planet = world.Create(orbit, Transform({ 40, 0, 0 }), WorldMatrixComponent());
+			if (i % 10 == 0)
+				world.Create(Transform({ 2.5f, 0, 0 }, { 0, 0, 0 }, { 0.5f, 0.5f, 0.5f }), ParentComponent{ planet }, WorldMatrixComponent());
+		}
+
+		measure("EcsScalar", count, MeasureFrames([&world, dt]() {
+			UpdateOrbitsScalar(world, dt);
+			UpdateWorldMatrices(world, SIZE_MAX);
+		}));
+		measure("EcsSimd", count, MeasureFrames([&world, dt]() {
+			UpdateOrbits(world, dt, SIZE_MAX);
+			UpdateWorldMatrices(world, SIZE_MAX);
+		}));
+		measure("EcsSimdParallel", count, MeasureFrames([&world, dt]() {
+			UpdateOrbits(world, dt, 4096);
+			UpdateWorldMatrices(world, 4096);
+		}));
+
+		//关键帧曲线：8个关键帧的闭合路径
+		AnimationCurve curve;
+		curve.KeyInterval = 0.5f;
+		for (int k = 0; k < 8; ++k)
+			curve.Keys.push_back({ 40 * cos(k * XM_PI / 4), 5.0f * (k % 2), 40 * sin(k * XM_PI / 4) });
+
+		EntityWorld curveWorld;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			CurveAnimationComponent animation;
+			animation.Curve = &curve;
+			animation.Time = i * 0.001f;
+			curveWorld.Create(animation, Transform(), WorldMatrixComponent());
+		}
+		measure("CurveAnimation", count, MeasureFrames([&curveWorld, dt]() {
+			UpdateCurveAnimations(curveWorld, dt, SIZE_MAX);
+			UpdateWorldMatrices(curveWorld, SIZE_MAX);
+		}));
+	}
+
+	return report.Finish();
+}
+
+}
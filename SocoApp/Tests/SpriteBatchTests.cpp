@@ -0,0 +1,145 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/SpriteBatchBuilder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace Soco
+{
+
+namespace
+{
+
+struct SpriteBatchCase
+{
+	const char* Name;
+	uint32_t Sprites;
+	uint32_t Textures;
+	uint32_t Layers;
+};
+
+struct GeneratedSprite
+{
+	SpriteInstance Sprite;
+	uint32_t Layer;
+};
+
+std::vector<GeneratedSprite> GenerateSprites(const SpriteBatchCase& test, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<GeneratedSprite> sprites(test.Sprites);
+	for (GeneratedSprite& generated : sprites)
+	{
+		SpriteInstance& sprite = generated.Sprite;
+		sprite.Size[0] = sprite.Size[1] = 0.01f + 0.05f * unit(rng);
+		sprite.Offset[0] = unit(rng);
+		sprite.Offset[1] = unit(rng);
+		sprite.UvRect[0] = sprite.UvRect[1] = 0.0f;
+		sprite.UvRect[2] = sprite.UvRect[3] = 1.0f;
+		//0号是空纹理
+		sprite.TextureIndex = 1 + rng() % test.Textures;
+		generated.Layer = rng() % test.Layers;
+	}
+	return sprites;
+}
+
+// 参考实现：按(层, 纹理)稳定排序下标后拷贝
+uint32_t BuildReference(const std::vector<GeneratedSprite>& sprites, std::vector<uint32_t>& order, SpriteInstance* out)
+{
+	order.resize(sprites.size());
+	for (uint32_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		if (sprites[a].Layer != sprites[b].Layer)
+			return sprites[a].Layer < sprites[b].Layer;
+		return sprites[a].Sprite.TextureIndex < sprites[b].Sprite.TextureIndex;
+	});
+
+	uint32_t runs = 0;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		const GeneratedSprite& sprite = sprites[order[i]];
+		out[i] = sprite.Sprite;
+		if (i == 0 || sprite.Layer != sprites[order[i - 1]].Layer || sprite.Sprite.TextureIndex != sprites[order[i - 1]].Sprite.TextureIndex)
+			++runs;
+	}
+	return runs;
+}
+
+template<typename F>
+double MeasureMicroseconds(uint32_t iterations, F&& func)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < iterations; ++i)
+		func();
+	return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+}
+
+}
+
+bool RunSpriteBatchBenchmark(const std::string& path)
+{
+	const SpriteBatchCase cases[] = {
+		{ "OneTexture", 10000, 1, 1 },
+		{ "EightTextures", 10000, 8, 1 },
+		{ "ManyTextures", 10000, 1000, 1 },
+		{ "Layered", 10000, 64, 4 },
+		{ "Large", 100000, 64, 4 },
+	};
+	//每个精灵一个TextureRenderer时，每帧一次DrawInstanced和一个按256字节对齐的常量缓冲
+	const uint32_t unbatchedConstantBytes = 256;
+
+	TestReport report("SpriteBatch", path, "Sprites,Textures,Layers,TextureRuns,BatchedDrawCalls,UnbatchedDrawCalls,InstanceBytes,UnbatchedConstantBytes,"
+		"BuildUs,StableSortUs");
+
+	std::mt19937 rng(20240611);
+	for (const SpriteBatchCase& spriteCase : cases)
+	{
+		TestCase test(report, spriteCase.Name);
+		const std::vector<GeneratedSprite> sprites = GenerateSprites(spriteCase, rng);
+		std::vector<SpriteInstance> built(sprites.size()), rebuilt(sprites.size()), reference(sprites.size());
+		std::vector<uint32_t> order;
+
+		SpriteBatchBuilder builder;
+		for (const GeneratedSprite& sprite : sprites)
+			builder.Add(sprite.Sprite, sprite.Layer);
+		const uint32_t runs = builder.Build(built.data());
+		//再Build一次结果不变
+		const uint32_t rerun = builder.Build(rebuilt.data());
+		const uint32_t referenceRuns = BuildReference(sprites, order, reference.data());
+
+		const size_t bytes = sprites.size() * sizeof(SpriteInstance);
+		test.Expect(builder.GetCount() == sprites.size(), "精灵数量不对");
+		test.Expect(runs == referenceRuns, "纹理段数是" + std::to_string(runs) + "，stable_sort是" + std::to_string(referenceRuns));
+		test.Expect(memcmp(built.data(), reference.data(), bytes) == 0, "排序结果和stable_sort不同");
+		test.Expect(rerun == runs && memcmp(rebuilt.data(), reference.data(), bytes) == 0, "再Build一次结果变了");
+
+		//每帧的工作：提交所有精灵再排序写出
+		const uint32_t iterations = std::max<uint32_t>(1, 2000000 / spriteCase.Sprites);
+		const double buildUs = MeasureMicroseconds(iterations, [&]() {
+			builder.Clear();
+			for (const GeneratedSprite& sprite : sprites)
+				builder.Add(sprite.Sprite, sprite.Layer);
+			builder.Build(built.data());
+		});
+		const double stableSortUs = MeasureMicroseconds(iterations, [&]() {
+			BuildReference(sprites, order, reference.data());
+		});
+		test.Expect(memcmp(built.data(), reference.data(), bytes) == 0, "Clear后重新提交的排序结果和stable_sort不同");
+		test.Expect(buildUs <= stableSortUs, "提交和排序比stable_sort慢");
+
+		report.Add(test, spriteCase.Sprites, spriteCase.Textures, spriteCase.Layers, runs, 1, spriteCase.Sprites, bytes,
+			(uint64_t)spriteCase.Sprites * unbatchedConstantBytes, buildUs, stableSortUs);
+		std::cout << spriteCase.Name << "：" << spriteCase.Sprites << "个精灵，" << runs << "段纹理，每帧提交和排序" << buildUs
+			<< "us，stable_sort " << stableSortUs << "us" << std::endl;
+	}
+
+	return report.Finish();
+}
+
+
+}
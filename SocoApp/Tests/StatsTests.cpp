@@ -0,0 +1,118 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/Stats.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+namespace Soco
+{
+
+bool RunStatsRegistryHarness(const std::string& path)
+{
+	TestReport report("StatsRegistry", path);
+
+	//计数每帧清零，仪表跨帧保持
+	{
+		StatsRegistry registry;
+		StatCounter* draws = registry.GetCounter("Draws");
+		StatGauge* allocated = registry.GetGauge("Allocated");
+		draws->Add(3);
+		draws->Add(2);
+		allocated->Set(7);
+		registry.EndFrame();
+		const bool afterFirst = draws->Get() == 0 && allocated->Get() == 7 && registry.GetSummary("Draws").Last == 5;
+		registry.EndFrame();
+		StatSummary drawSummary = registry.GetSummary("Draws");
+		StatSummary gaugeSummary = registry.GetSummary("Allocated");
+		report.Check("CounterResetEachFrame", afterFirst && drawSummary.Last == 0 && drawSummary.Max == 5 && drawSummary.Total == 5);
+		report.Check("GaugeKeepsValue", gaugeSummary.Last == 7 && gaugeSummary.Min == 7 && gaugeSummary.Samples == 2 && gaugeSummary.Total == 14);
+		report.Check("SameNameSamePointer", registry.GetCounter("Draws") == draws && registry.GetSummary("Missing").Samples == 0);
+	}
+
+	//窗口4帧，写入1..10后只剩7..10，Total是全部的和
+	{
+		StatsRegistry registry;
+		registry.SetWindowSize(4);
+		StatCounter* counter = registry.GetCounter("Value");
+		for (int64_t value = 1; value <= 10; ++value)
+		{
+			counter->Add(value);
+			registry.EndFrame();
+		}
+		StatSummary summary = registry.GetSummary("Value");
+		report.Check("WindowRollover", summary.Samples == 4 && summary.Min == 7 && summary.Max == 10 && summary.Last == 10 &&
+			summary.Avg == 8.5 && summary.P99 == 10 && summary.Total == 55);
+
+		//改变窗口大小后从下一帧重新开始
+		registry.SetWindowSize(3);
+		counter->Add(100);
+		registry.EndFrame();
+		summary = registry.GetSummary("Value");
+		report.Check("WindowResize", summary.Samples == 1 && summary.Min == 100 && summary.Max == 100 && summary.Total == 155);
+
+		registry.ResetTotals();
+		summary = registry.GetSummary("Value");
+		report.Check("ResetTotals", summary.Total == 0 && summary.Samples == 1 && summary.Last == 100);
+	}
+
+	//p99：随机窗口大小和样本，和排序后第ceil(0.99n)个比较；窗口写满绕回后也一样
+	{
+		std::mt19937 rng(3301);
+		bool ok = true;
+		for (uint32_t trial = 0; trial < 300 && ok; ++trial)
+		{
+			const size_t window = 1 + rng() % 300;
+			const size_t frames = 1 + rng() % (window * 2);
+			StatsRegistry registry;
+			registry.SetWindowSize(window);
+			StatCounter* counter = registry.GetCounter("Value");
+			std::vector<int64_t> values;
+			for (size_t frame = 0; frame < frames; ++frame)
+			{
+				const int64_t value = (int64_t)(rng() % 1000) - 100;
+				values.push_back(value);
+				counter->Add(value);
+				registry.EndFrame();
+			}
+
+			std::vector<int64_t> recent(values.end() - std::min(window, frames), values.end());
+			std::sort(recent.begin(), recent.end());
+			const size_t needed = (recent.size() * 99 + 99) / 100;
+			StatSummary summary = registry.GetSummary("Value");
+			ok = summary.Samples == recent.size() && summary.P99 == recent[needed - 1] &&
+				summary.Min == recent.front() && summary.Max == recent.back() && summary.Last == values.back();
+		}
+		report.Check("P99Rank", ok);
+	}
+
+	//4个线程同时Add，主线程同时EndFrame，所有帧的和等于Add的总数
+	{
+		StatsRegistry registry;
+		StatCounter* counter = registry.GetCounter("Concurrent");
+		std::atomic<bool> done{ false };
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([counter]() {
+				for (int i = 0; i < 200000; ++i)
+					counter->Add(1);
+			});
+		}
+		std::thread frames([&registry, &done]() {
+			while (!done.load())
+				registry.EndFrame();
+		});
+		for (std::thread& thread : threads)
+			thread.join();
+		done.store(true);
+		frames.join();
+		registry.EndFrame();
+		report.Check("ConcurrentAddAndEndFrame", registry.GetSummary("Concurrent").Total == 800000 && counter->Get() == 0);
+	}
+
+	return report.Finish();
+}
+
+}
@@ -0,0 +1,78 @@
+#include "Tests.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// 引擎代码里是extern声明，和SocoApp.cpp里的定义保持一致
+const int gNumFrameResources = 3;
+
+namespace
+{
+
+struct TestSuite
+{
+	const char* Name;
+	bool (*Run)(const std::string& path);
+};
+
+// 每个检查把结果导出到<Name>.csv
+const TestSuite Suites[] = {
+	{ "FrameGraphCompiler", Soco::RunFrameGraphCompilerTests },
+	{ "TransientPacker", Soco::RunTransientPackerHarness },
+	{ "GpuTimestampRing", Soco::RunGpuTimestampRingHarness },
+	{ "Stats", Soco::RunStatsRegistryHarness },
+	{ "ProfilerOverhead", Soco::RunProfilerOverheadBenchmark },
+	{ "JobSystem", Soco::RunJobSystemBenchmark },
+	{ "SceneScaling", Soco::RunSceneScalingBenchmark },
+	{ "MeshOptimization", Soco::RunMeshOptimizationReport },
+	{ "Meshlets", Soco::RunMeshletBenchmark },
+	{ "Simplifier", Soco::RunSimplifierBenchmark },
+	{ "Residency", Soco::RunResidencyTraceBenchmark },
+	{ "MipEstimator", Soco::RunMipEstimatorHarness },
+	{ "MipChain", Soco::RunMipChainBenchmark },
+	{ "BCEncoder", Soco::RunBCEncoderBenchmark },
+	{ "PngDecode", Soco::RunPngDecodeBenchmark },
+	{ "Bindless", Soco::RunBindlessAllocatorBenchmark },
+	{ "SpriteBatch", Soco::RunSpriteBatchBenchmark },
+};
+
+}
+
+// SocoTests [名字...]：不带参数时运行全部检查，有检查失败时返回1
+int main(int argc, char* argv[])
+{
+	std::vector<const TestSuite*> selected;
+	for (int i = 1; i < argc; ++i)
+	{
+		const TestSuite* found = nullptr;
+		for (const TestSuite& suite : Suites)
+		{
+			if (strcmp(suite.Name, argv[i]) == 0)
+				found = &suite;
+		}
+		if (found == nullptr)
+		{
+			std::cout << "没有名为" << argv[i] << "的检查，可用的有：";
+			for (const TestSuite& suite : Suites)
+				std::cout << " " << suite.Name;
+			std::cout << std::endl;
+			return 1;
+		}
+		selected.push_back(found);
+	}
+	if (selected.empty())
+	{
+		for (const TestSuite& suite : Suites)
+			selected.push_back(&suite);
+	}
+
+	int failed = 0;
+	for (const TestSuite* suite : selected)
+	{
+		if (!suite->Run(std::string(suite->Name) + ".csv"))
+			++failed;
+	}
+	std::cout << selected.size() - failed << "/" << selected.size() << "项检查通过" << std::endl;
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+#include "TestReport.h"
+
+#include <iostream>
+
+namespace Soco
+{
+
+TestCase::TestCase(TestReport& report, std::string name)
+	: mReport(report), mName(std::move(name))
+{
+}
+
+void TestCase::Fail(const std::string& message)
+{
+	if (mPassed)
+		std::cout << mReport.GetSuite() << "检查失败：" << mName << "：" << message << std::endl;
+	mPassed = false;
+}
+
+bool TestCase::Expect(bool condition, const std::string& message)
+{
+	if (!condition)
+		Fail(message);
+	return condition;
+}
+
+TestReport::TestReport(std::string suite, std::string path, const std::string& columns)
+	: mSuite(std::move(suite)), mPath(std::move(path)), mOut(mPath)
+{
+	mOut << "Case," << (columns.empty() ? "" : columns + ",") << "Passed" << std::endl;
+}
+
+bool TestReport::Check(const std::string& name, bool passed)
+{
+	mOut << name << "," << (passed ? 1 : 0) << std::endl;
+	if (!passed)
+		std::cout << mSuite << "检查失败：" << name << std::endl;
+	mPassed = mPassed && passed;
+	return passed;
+}
+
+bool TestReport::Finish()
+{
+	mOut.flush();
+	const bool written = (bool)mOut;
+	if (!written)
+		std::cout << "无法写入" << mPath << std::endl;
+	std::cout << mSuite << "检查" << (mPassed && written ? "通过" : "失败") << "，已导出" << mPath << std::endl;
+	return mPassed && written;
+}
+
+}
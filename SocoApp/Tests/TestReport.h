@@ -0,0 +1,65 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+namespace Soco
+{
+
+class TestReport;
+
+// 一个用例：记录是否通过，只打印第一条失败的原因
+class TestCase
+{
+public:
+	TestCase(TestReport& report, std::string name);
+
+	const std::string& GetName() const { return mName; }
+	bool Passed() const { return mPassed; }
+
+	void Fail(const std::string& message);
+	// condition为false时失败，返回condition
+	bool Expect(bool condition, const std::string& message);
+
+private:
+	TestReport& mReport;
+	std::string mName;
+	bool mPassed = true;
+};
+
+/*
+测试写出的CSV：第一列是用例名，最后一列是Passed，中间是各测试自己的统计
+有一个用例失败整个报告就是失败
+*/
+class TestReport
+{
+public:
+	// columns是中间的列名，用逗号隔开，可以为空
+	TestReport(std::string suite, std::string path, const std::string& columns = "");
+
+	const std::string& GetSuite() const { return mSuite; }
+
+	// 写一行：用例名、values、是否通过
+	template <typename... Values>
+	void Add(const TestCase& test, const Values&... values)
+	{
+		mOut << test.GetName();
+		((mOut << "," << values), ...);
+		mOut << "," << (test.Passed() ? 1 : 0) << std::endl;
+		mPassed = mPassed && test.Passed();
+	}
+
+	// 没有统计的用例直接写一行，失败时打印用例名，返回passed
+	bool Check(const std::string& name, bool passed);
+
+	// 打印结果并返回整个报告是否通过，CSV写不出来也算失败
+	bool Finish();
+
+private:
+	std::string mSuite;
+	std::string mPath;
+	std::ofstream mOut;
+	bool mPassed = true;
+};
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+
+// 各模块的检查，每个写一份CSV(最后一列是Passed)，有检查失败时返回false
+namespace Soco
+{
+
+/*
+手工构造的几张图(写后读、写后写、读后写、剔除、别名slot、UAV屏障和组合读)逐个检查执行顺序、剔除结果和每个pass的屏障，
+再用随机图检查不变量：有冲突的访问按声明顺序、读到的内容的写者存活、同时存活的资源不共用slot和堆内存、屏障重放后状态正确
+*/
+bool RunFrameGraphCompilerTests(const std::string& path);
+
+/*
+按随机的生命周期和大小(frame graph里常见的纹理大小和对齐，或者任意大小和对齐)装箱，
+检查偏移对齐、不超出堆、生命周期重叠的请求不共用堆内存、同样的输入结果相同，
+统计堆大小和同时存活最大值、不做别名总大小的比值
+*/
+bool RunTransientPackerHarness(const std::string& path);
+
+/*
+用假的TimestampSource模拟GPU落后CPU几帧执行、slot复用、读回不及时(slot在读回前被覆盖)、zone超过上限、
+很大的时间戳(换算时乘1e9会溢出)、GPU时钟在校准点之前、结束早于开始的zone，
+检查读回的帧按顺序、只读回执行完的帧、zone名称和换算到CPU时间域的开始结束时间、丢弃的帧和zone数量
+*/
+bool RunGpuTimestampRingHarness(const std::string& path);
+
+/*
+用独立的注册表检查：计数在EndFrame时清零、仪表跨帧保持，窗口写满后只保留最近的帧(min/avg/max/last)，
+改变窗口大小后重新开始，p99取不小于99%样本的最小值(和排序后的结果比较)，ResetTotals只清Total，
+多个线程同时Add、主线程同时EndFrame时计数不丢失
+*/
+bool RunStatsRegistryHarness(const std::string& path);
+
+/*
+测量SOCO_PROFILE_SCOPE的开销：单层zone、4层嵌套zone、profiler关闭时，每个zone在记录线程上的纳秒数和EndFrame收集时的纳秒数
+同时检查收集到的zone数量、嵌套深度、时间落在帧内且子zone在父zone内
+会往全局Profiler里写帧
+*/
+bool RunProfilerOverheadBenchmark(const std::string& path);
+
+/*
+对1到CPU核数的每个线程数调用JobSystem::Initialize，测量：
+主线程Run+Wait一个空job的耗时，一次提交一批空job的每个job耗时，
+主线程只等不执行时空job被工作线程取走执行完的延迟(包括唤醒)，
+以及ParallelFor一个计算密集的循环的耗时和相对单线程的加速比，结果和串行计算比较
+结束后恢复原来的线程数
+*/
+bool RunJobSystemBenchmark(const std::string& path);
+
+/*
+比较按名字查找、逐个标量计算和SIMD批量计算在不同物体数量(10到100万)下每帧的CPU耗时，
+每个写法和物体数量一行，只统计不检查
+*/
+bool RunSceneScalingBenchmark(const std::string& path);
+
+/*
+对GeometryGenerator生成的几种网格比较优化前后的顶点数、ACMR和ATVR，
+检查三角形数量不变、顶点不会变多、索引不越界、ACMR不比原来的顺序差
+*/
+bool RunMeshOptimizationReport(const std::string& path);
+
+/*
+对不同细分级别的geosphere测量meshlet构建时间、meshlet大小、剔除耗时和剩余三角形比例，
+检查meshlet不超过上限、三角形不多不少且绕序不变，绕球一圈的64个相机下被剔除的三角形都是背面或在视锥外
+*/
+bool RunMeshletBenchmark(const std::string& path);
+
+/*
+对几种生成网格(包括有开放边界的起伏地形)建6级LOD链，测量各级的简化耗时、三角形数、报告误差和实测误差，
+检查实测误差不超过上限、每一级的三角形都比上一级少
+*/
+bool RunSimplifierBenchmark(const std::string& path);
+
+/*
+用几种模拟的使用序列(工作集在预算内外来回变化、循环扫描、长时间闲置后重新使用、按距离请求mip)驱动ResidencyPolicy
+每帧检查：不超预算(除非剩下的都降到了最低)、保护期内的纹理没有被换出、降级按最久未使用的顺序、
+升级不超过需要的一级和每帧的上传上限、用不上的mip按时丢掉
+统计每种序列的常驻大小、升降级次数
+*/
+bool RunResidencyTraceBenchmark(const std::string& path);
+
+/*
+用逐像素光线求交算出的UV导数(与GPU选mip的方式相同)做参考，检查不同距离、倾斜、偏离视线中心和纹理大小下：
+估计的mip不比参考粗；正对相机、距离不小于4倍半径时最多精细一级；生成的球和平面的UV密度符合解析值
+*/
+bool RunMipEstimatorHarness(const std::string& path);
+
+/*
+用双精度、按二维足迹直接求和的参考实现检查DownsampleRgba8的每种滤波(含sRGB、奇数宽高、1像素宽的图像)，SSE2和标量实现的误差都不能超过1；
+再测两种实现在几种图像大小下生成整条mip链的耗时，有SSE2时SIMD比标量慢就算失败
+*/
+bool RunMipChainBenchmark(const std::string& path);
+
+/*
+检查手写的BC1/BC4/BC7块按规范解码、纯色块无损(BC1是565能表示的颜色)、BC1透明像素解码后alpha为0，
+用合成的颜色图、高度图、法线图和仓库里的高度图检查各格式的PSNR不低于下限、并行和单线程的编码结果一致，并记录两者的耗时
+*/
+bool RunBCEncoderBenchmark(const std::string& path);
+
+/*
+用lodepng编码的各种颜色类型、位深、按行指定滤波的合成图检查每种输出设置的解码结果和lodepng逐位一致，截断和改坏的文件要解码失败；
+再对仓库里的高度图检查同样的一致性，并记录几种解码设置和lodepng的耗时
+*/
+bool RunPngDecodeBenchmark(const std::string& path);
+
+/*
+用几种模拟的序列(填满后全部释放、随机分配释放和更新、纹理每几帧换一次描述符)驱动BindlessIndexAllocator，和参考模型比较：
+已分配的下标不重复，释放后frameCopies帧之内不会再分配，每帧使用的副本里所有已分配下标的描述符都是最新的，重复释放能检查出来
+记录每种序列的分配次数、峰值、更新的描述符数和每次操作的耗时
+*/
+bool RunBindlessAllocatorBenchmark(const std::string& path);
+
+/*
+用1万个左右的随机精灵(不同的纹理数和层数)检查SpriteBatchBuilder的结果和std::stable_sort逐字节相同、重复Build和Clear后重新提交的结果不变，
+提交和排序比stable_sort慢也算失败；记录两者的耗时，和每个精灵一个TextureRenderer时的draw call数、常量缓冲上传量
+*/
+bool RunSpriteBatchBenchmark(const std::string& path);
+
+}
@@ -0,0 +1,143 @@
+#include "Tests.h"
+#include "TestReport.h"
+#include "Soco/Util/TransientHeapPacker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+namespace Soco
+{
+
+namespace
+{
+
+struct PackerCase
+{
+	const char* Name;
+	uint32_t Trials;
+	uint32_t Requests;
+	// 生命周期在[0, Passes)里
+	uint32_t Passes;
+	// 生命周期长度的上限
+	uint32_t MaxLifetime;
+	// 按frame graph里常见的纹理大小和64KB/4MB对齐生成，否则是任意大小和2的幂对齐
+	bool TextureSizes;
+};
+
+std::vector<TransientAllocationRequest> GenerateRequests(const PackerCase& test, std::mt19937& rng)
+{
+	//1080p的RGBA8、RGBA16F、D32、半分辨率RGBA16F、4xMSAA RGBA8(4MB对齐)
+	const uint64_t textureSizes[] = { 8355840, 16646144, 8355840, 4194304, 33423360 };
+	const uint64_t textureAlignments[] = { 65536, 65536, 65536, 65536, 4194304 };
+
+	std::vector<TransientAllocationRequest> requests(test.Requests);
+	for (TransientAllocationRequest& request : requests)
+	{
+		if (test.TextureSizes)
+		{
+			const uint32_t kind = rng() % 5;
+			request.Size = textureSizes[kind];
+			request.Alignment = textureAlignments[kind];
+		}
+		else
+		{
+			request.Size = 1 + rng() % 100000;
+			request.Alignment = 1ull << (rng() % 17);
+		}
+		request.FirstUse = rng() % test.Passes;
+		request.LastUse = std::min(test.Passes - 1, request.FirstUse + (uint32_t)(rng() % test.MaxLifetime));
+	}
+	return requests;
+}
+
+// 检查对齐、堆大小和同时存活的请求不共用内存，失败时返回原因
+const char* CheckPacking(const std::vector<TransientAllocationRequest>& requests, const TransientPackResult& result)
+{
+	if (result.Offsets.size() != requests.size())
+		return "偏移数量和请求数量不同";
+
+	uint64_t total = 0;
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		const TransientAllocationRequest& a = requests[i];
+		total += a.Size;
+		if (result.Offsets[i] % a.Alignment != 0)
+			return "偏移没有对齐";
+		if (result.Offsets[i] + a.Size > result.HeapSize)
+			return "请求超出了堆的大小";
+
+		for (size_t j = i + 1; j < requests.size(); ++j)
+		{
+			const TransientAllocationRequest& b = requests[j];
+			const bool lifetimeOverlap = a.FirstUse <= b.LastUse && b.FirstUse <= a.LastUse;
+			const bool memoryOverlap = result.Offsets[i] < result.Offsets[j] + b.Size && result.Offsets[j] < result.Offsets[i] + a.Size;
+			if (lifetimeOverlap && memoryOverlap)
+				return "生命周期重叠的请求共用了堆内存";
+		}
+	}
+	if (total != result.TotalSize)
+		return "TotalSize不等于请求大小之和";
+	//对齐最多在每个请求前浪费Alignment - 1字节
+	uint64_t maxPadding = 0;
+	for (const TransientAllocationRequest& request : requests)
+		maxPadding += request.Alignment - 1;
+	if (result.HeapSize < result.MaxLiveSize || result.HeapSize > result.TotalSize + maxPadding)
+		return "堆大小不在[同时存活的最大值, 总大小加对齐]之间";
+	return nullptr;
+}
+
+}
+
+bool RunTransientPackerHarness(const std::string& path)
+{
+	const PackerCase cases[] = {
+		{ "Small", 2000, 8, 8, 4, true },
+		{ "FrameGraph", 2000, 24, 20, 6, true },
+		{ "LongLived", 1000, 24, 20, 20, true },
+		{ "ShortLived", 1000, 64, 64, 2, true },
+		{ "ArbitrarySizes", 1000, 48, 32, 8, false },
+		{ "Large", 50, 512, 256, 16, false },
+	};
+
+	TestReport report("TransientHeapPacker", path, "Trials,Requests,AvgHeapOverMaxLive,WorstHeapOverMaxLive,AvgHeapOverTotal,UsPerPack");
+
+	std::mt19937 rng(2901);
+	for (const PackerCase& packerCase : cases)
+	{
+		TestCase test(report, packerCase.Name);
+		double sumOverLive = 0, worstOverLive = 0, sumOverTotal = 0, packUs = 0;
+		const char* failure = nullptr;
+		for (uint32_t trial = 0; trial < packerCase.Trials && failure == nullptr; ++trial)
+		{
+			const std::vector<TransientAllocationRequest> requests = GenerateRequests(packerCase, rng);
+			const auto start = std::chrono::high_resolution_clock::now();
+			const TransientPackResult result = PackTransientLifetimes(requests);
+			packUs += std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+
+			failure = CheckPacking(requests, result);
+			//同样的输入结果相同，frame graph每帧重新编译时堆布局不变
+			if (failure == nullptr && PackTransientLifetimes(requests).Offsets != result.Offsets)
+				failure = "同样的输入得到了不同的布局";
+
+			const double overLive = (double)result.HeapSize / result.MaxLiveSize;
+			sumOverLive += overLive;
+			worstOverLive = std::max(worstOverLive, overLive);
+			sumOverTotal += (double)result.HeapSize / result.TotalSize;
+		}
+
+		if (failure != nullptr)
+			test.Fail(failure);
+
+		report.Add(test, packerCase.Trials, packerCase.Requests, sumOverLive / packerCase.Trials, worstOverLive,
+			sumOverTotal / packerCase.Trials, packUs / packerCase.Trials);
+		std::cout << packerCase.Name << "：" << packerCase.Requests << "个请求，堆大小平均是同时存活最大值的" << sumOverLive / packerCase.Trials
+			<< "倍，最差" << worstOverLive << "倍，是不做别名的" << sumOverTotal / packerCase.Trials * 100 << "%，"
+			<< (test.Passed() ? "通过" : "失败") << std::endl;
+	}
+
+	return report.Finish();
+}
+
+}
@@ -0,0 +1,135 @@
+# -*- coding: utf-8 -*-
+"""
+比较两个构建的benchmark结果
+
+用同样的参数交替运行两个exe，再比较报告：
+    python Tools/CompareBenchmark.py Base/SocoApp.exe New/SocoApp.exe --runs 3 -- -headless -benchmark frames=1000 planets=2000
+
+也可以直接比较已有的报告：
+    python Tools/CompareBenchmark.py --reports base.json new.json
+
+帧时间p50或p99变慢超过--threshold(默认5%)，或者计数总量不同(确定性回放下同一场景的计数应该完全相同)时返回1
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+
+def percentile(samples, p):
+    samples = sorted(samples)
+    return samples[max(0, (len(samples) * p + 99) // 100 - 1)]
+
+
+def merge_reports(reports):
+    """多次运行的帧时间合并成一个分布，计数取第一次的"""
+    frame_times = []
+    for report in reports:
+        frame_times += report["frameTimesMs"]
+    zones = {}
+    for report in reports:
+        for name, zone in report["zonesMs"].items():
+            zones.setdefault(name, []).append(zone["p50"])
+    return {
+        "label": reports[0]["label"],
+        "config": reports[0]["config"],
+        "frameTimes": frame_times,
+        "zoneP50": {name: sorted(values)[len(values) // 2] for name, values in zones.items()},
+        "totals": reports[0]["totals"],
+    }
+
+
+def run(exe, args, report_path, label, cwd):
+    # report和label紧跟在-benchmark后面，-benchmark的参数到下一个-开头的选项为止
+    index = args.index("-benchmark") + 1
+    command = [exe] + args[:index] + ["report=" + report_path, "label=" + label] + args[index:]
+    print("运行:", " ".join(command))
+    subprocess.run(command, cwd=cwd, check=True)
+    with open(os.path.join(cwd, report_path), encoding="utf-8") as f:
+        return json.load(f)
+
+
+def change(base, new):
+    return (new - base) / base * 100.0 if base != 0 else 0.0
+
+
+def compare(base, new, threshold):
+    regressed = False
+
+    print("\n帧时间(ms)          %10s %10s %8s" % ("base", "new", "变化"))
+    for p in (50, 90, 99):
+        b = percentile(base["frameTimes"], p)
+        n = percentile(new["frameTimes"], p)
+        mark = ""
+        if p in (50, 99) and change(b, n) > threshold:
+            mark = "  <- 变慢"
+            regressed = True
+        print("  p%-17d %10.3f %10.3f %+7.1f%%%s" % (p, b, n, change(b, n), mark))
+    b = sum(base["frameTimes"]) / len(base["frameTimes"])
+    n = sum(new["frameTimes"]) / len(new["frameTimes"])
+    print("  %-18s %10.3f %10.3f %+7.1f%%" % ("avg", b, n, change(b, n)))
+
+    print("\nzone p50(ms)")
+    for name in sorted(set(base["zoneP50"]) | set(new["zoneP50"])):
+        b = base["zoneP50"].get(name)
+        n = new["zoneP50"].get(name)
+        if b is None or n is None:
+            print("  %-30s %10s %10s" % (name, b if b is not None else "-", n if n is not None else "-"))
+        else:
+            print("  %-30s %10.3f %10.3f %+7.1f%%" % (name, b, n, change(b, n)))
+
+    print("\n计数总量")
+    for name in sorted(set(base["totals"]) | set(new["totals"])):
+        b = base["totals"].get(name, 0)
+        n = new["totals"].get(name, 0)
+        if b != n:
+            print("  %-30s %12d %12d  <- 不同" % (name, b, n))
+            regressed = True
+        else:
+            print("  %-30s %12d" % (name, b))
+
+    return regressed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="比较两个构建的benchmark报告")
+    parser.add_argument("base", nargs="?", help="基准构建的exe")
+    parser.add_argument("new", nargs="?", help="新构建的exe")
+    parser.add_argument("--reports", nargs=2, metavar=("BASE_JSON", "NEW_JSON"), help="直接比较两个已有的报告")
+    parser.add_argument("--runs", type=int, default=1, help="每个构建交替运行的次数")
+    parser.add_argument("--threshold", type=float, default=5.0, help="判定为变慢的百分比")
+    parser.add_argument("--cwd", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "SocoApp"),
+                        help="运行目录，Shader和贴图按相对路径加载")
+    # -- 之后的参数原样传给程序
+    argv = sys.argv[1:]
+    app_args = argv[argv.index("--") + 1:] if "--" in argv else []
+    options = parser.parse_args(argv[:argv.index("--")] if "--" in argv else argv)
+
+    if options.reports:
+        with open(options.reports[0], encoding="utf-8") as f:
+            base = merge_reports([json.load(f)])
+        with open(options.reports[1], encoding="utf-8") as f:
+            new = merge_reports([json.load(f)])
+    else:
+        if not options.base or not options.new:
+            parser.error("需要两个exe，或者--reports")
+        args = list(app_args)
+        if "-benchmark" not in args:
+            args.append("-benchmark")
+        base_reports, new_reports = [], []
+        for i in range(options.runs):
+            base_reports.append(run(os.path.abspath(options.base), args, "BenchmarkBase%d.json" % i, "base", options.cwd))
+            new_reports.append(run(os.path.abspath(options.new), args, "BenchmarkNew%d.json" % i, "new", options.cwd))
+        base = merge_reports(base_reports)
+        new = merge_reports(new_reports)
+
+    if base["config"] != new["config"]:
+        print("警告：两份报告的benchmark参数不同", base["config"], new["config"])
+
+    sys.exit(1 if compare(base, new, options.threshold) else 0)
+
+
+if __name__ == "__main__":
+    main()